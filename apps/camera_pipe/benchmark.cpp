@@ -0,0 +1,182 @@
+// A structured latency benchmark for the camera pipe: per-frame
+// wall-time percentiles over many frames with input rotation, plus
+// the profiler's per-stage time and memory breakdown, written out as
+// JSON. Build with `make benchmark`; the pipeline is compiled with
+// the profile feature so stage costs are attributed by the sampling
+// profiler.
+
+#include "camera_pipe_profile.h"
+
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+#include "halide_image_io.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace Halide::Runtime;
+using namespace Halide::Tools;
+
+namespace {
+
+double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 7) {
+        printf("Usage: ./benchmark raw.png color_temp gamma contrast frames out.json [budget_ms]\n"
+               "e.g. ./benchmark raw.png 3700 2.0 50 1000 results.json 25.0\n"
+               "If budget_ms is given, exits non-zero when the p99 frame time exceeds it.\n");
+        return 0;
+    }
+
+    fprintf(stderr, "input: %s\n", argv[1]);
+    Buffer<uint16_t> input = load_and_convert_image(argv[1]);
+    fprintf(stderr, "       %d %d\n", input.width(), input.height());
+    Buffer<uint8_t> output(((input.width() - 32) / 32) * 32, ((input.height() - 24) / 32) * 32, 3);
+
+    // These color matrices are for the sensor in the Nokia N900 and are
+    // taken from the FCam source.
+    float _matrix_3200[][4] = {{ 1.6697f, -0.2693f, -0.4004f, -42.4346f},
+                               {-0.3576f,  1.0615f,  1.5949f, -37.1158f},
+                               {-0.2175f, -1.8751f,  6.9640f, -26.6970f}};
+
+    float _matrix_7000[][4] = {{ 2.2997f, -0.4478f,  0.1706f, -39.0923f},
+                               {-0.3826f,  1.5906f, -0.2080f, -25.4311f},
+                               {-0.0888f, -0.7344f,  2.2832f, -20.0826f}};
+    Buffer<float> matrix_3200(4, 3), matrix_7000(4, 3);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            matrix_3200(j, i) = _matrix_3200[i][j];
+            matrix_7000(j, i) = _matrix_7000[i][j];
+        }
+    }
+
+    float color_temp = (float)atof(argv[2]);
+    float gamma = (float)atof(argv[3]);
+    float contrast = (float)atof(argv[4]);
+    int frames = atoi(argv[5]);
+    const char *json_path = argv[6];
+    double budget_ms = (argc > 7) ? atof(argv[7]) : 0;
+    int blackLevel = 25;
+    int whiteLevel = 1023;
+
+    // Rotate between several distinct input frames, so consecutive
+    // runs don't process the exact bytes already sitting in the
+    // cache. Each copy gets a small brightness offset, which is
+    // enough to make the data distinct without changing the work done.
+    const int num_inputs = 4;
+    std::vector<Buffer<uint16_t>> inputs;
+    for (int k = 0; k < num_inputs; k++) {
+        Buffer<uint16_t> copy(input.width(), input.height());
+        copy.for_each_element([&](int x, int y) {
+            int v = input(x, y) + k * 4;
+            copy(x, y) = (uint16_t)(v > whiteLevel ? whiteLevel : v);
+        });
+        inputs.push_back(std::move(copy));
+    }
+
+    // Warm up: fill caches, page in the code, let the thread pool spin up.
+    for (int i = 0; i < 3; i++) {
+        camera_pipe_profile(inputs[i % num_inputs], matrix_3200, matrix_7000,
+                            color_temp, gamma, contrast, blackLevel, whiteLevel,
+                            output);
+    }
+    halide_profiler_reset();
+
+    std::vector<double> frame_ms(frames);
+    for (int i = 0; i < frames; i++) {
+        auto t0 = std::chrono::steady_clock::now();
+        camera_pipe_profile(inputs[i % num_inputs], matrix_3200, matrix_7000,
+                            color_temp, gamma, contrast, blackLevel, whiteLevel,
+                            output);
+        auto t1 = std::chrono::steady_clock::now();
+        frame_ms[i] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    }
+
+    std::vector<double> sorted = frame_ms;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (double t : frame_ms) {
+        total += t;
+    }
+    double mean = total / frames;
+    double p50 = percentile(sorted, 0.50);
+    double p90 = percentile(sorted, 0.90);
+    double p99 = percentile(sorted, 0.99);
+
+    fprintf(stderr, "%d frames: p50 %.3fms p90 %.3fms p99 %.3fms (min %.3f max %.3f)\n",
+            frames, p50, p90, p99, sorted.front(), sorted.back());
+
+    const halide_profiler_pipeline_stats *stats =
+        halide_profiler_get_pipeline_state("camera_pipe_profile");
+
+    FILE *json = fopen(json_path, "w");
+    if (!json) {
+        fprintf(stderr, "Could not open %s\n", json_path);
+        return 1;
+    }
+    fprintf(json, "{\n");
+    fprintf(json, "  \"pipeline\": \"camera_pipe_profile\",\n");
+    fprintf(json, "  \"frames\": %d,\n", frames);
+    fprintf(json, "  \"width\": %d,\n", output.width());
+    fprintf(json, "  \"height\": %d,\n", output.height());
+    fprintf(json, "  \"wall_time_ms\": {\n");
+    fprintf(json, "    \"min\": %.6f,\n", sorted.front());
+    fprintf(json, "    \"p50\": %.6f,\n", p50);
+    fprintf(json, "    \"p90\": %.6f,\n", p90);
+    fprintf(json, "    \"p99\": %.6f,\n", p99);
+    fprintf(json, "    \"max\": %.6f,\n", sorted.back());
+    fprintf(json, "    \"mean\": %.6f\n", mean);
+    fprintf(json, "  },\n");
+    if (budget_ms > 0) {
+        fprintf(json, "  \"sla\": {\"budget_ms\": %.6f, \"met\": %s},\n",
+                budget_ms, p99 <= budget_ms ? "true" : "false");
+    }
+    if (stats) {
+        fprintf(json, "  \"memory\": {\n");
+        fprintf(json, "    \"peak_bytes\": %llu,\n", (unsigned long long)stats->memory_peak);
+        fprintf(json, "    \"total_bytes\": %llu,\n", (unsigned long long)stats->memory_total);
+        fprintf(json, "    \"num_allocs\": %d\n", stats->num_allocs);
+        fprintf(json, "  },\n");
+        uint64_t total_stage_time = 0;
+        for (int i = 0; i < stats->num_funcs; i++) {
+            total_stage_time += stats->funcs[i].time;
+        }
+        fprintf(json, "  \"stages\": [\n");
+        for (int i = 0; i < stats->num_funcs; i++) {
+            const halide_profiler_func_stats &f = stats->funcs[i];
+            double stage_ms = f.time / 1e6;
+            double pct = total_stage_time ? 100.0 * f.time / total_stage_time : 0;
+            fprintf(json, "    {\"name\": \"%s\", \"time_ms\": %.6f, "
+                          "\"time_ms_per_frame\": %.6f, \"time_pct\": %.3f, "
+                          "\"memory_peak\": %llu}%s\n",
+                    f.name, stage_ms, stage_ms / frames, pct,
+                    (unsigned long long)f.memory_peak,
+                    i + 1 < stats->num_funcs ? "," : "");
+        }
+        fprintf(json, "  ]\n");
+    } else {
+        fprintf(json, "  \"stages\": []\n");
+    }
+    fprintf(json, "}\n");
+    fclose(json);
+    fprintf(stderr, "wrote %s\n", json_path);
+
+    if (budget_ms > 0 && p99 > budget_ms) {
+        fprintf(stderr, "SLA MISSED: p99 %.3fms > budget %.3fms\n", p99, budget_ms);
+        return 1;
+    }
+    return 0;
+}
@@ -428,11 +428,13 @@ std::pair<FuncType, FuncType> tiled_transpose(FuncType f, int max_tile_size,
                                               const Target& target,
                                               const string& prefix,
                                               bool always_tile = false) {
-    // ARM can do loads of up to stride 4. We can use these loads to write a more
-    // efficient transpose. The strategy is to break the transpose into 4x4 tiles,
-    // transpose the tiles themselves (dense vector load/stores), then transpose
-    // the data within each tile (stride 4 loads).
-    if (target.arch != Target::ARM && !always_tile) {
+    // ARM can do loads of up to stride 4, and on x86 the strided
+    // loads within a tile lower to a network of even/odd shuffles
+    // (see Deinterleave.cpp), so both get a more efficient transpose
+    // this way. The strategy is to break the transpose into tiles,
+    // transpose the tiles themselves (dense vector load/stores), then
+    // transpose the data within each tile (strided loads).
+    if (target.arch != Target::ARM && target.arch != Target::X86 && !always_tile) {
         return { transpose(f), FuncType() };
     }
 
@@ -0,0 +1,87 @@
+#include "fft_plan.h"
+
+#include <cstddef>
+
+// The codelet headers are generated into $(BIN) by the fft generator
+// from the batch file the Makefile writes; the size list here must
+// match FFT_PLAN_SIZES there.
+#include "fft_forward_c2c_16x16.h"
+#include "fft_inverse_c2c_16x16.h"
+#include "fft_forward_r2c_16x16.h"
+#include "fft_inverse_c2r_16x16.h"
+#include "fft_forward_c2c_32x32.h"
+#include "fft_inverse_c2c_32x32.h"
+#include "fft_forward_r2c_32x32.h"
+#include "fft_inverse_c2r_32x32.h"
+#include "fft_forward_c2c_64x64.h"
+#include "fft_inverse_c2c_64x64.h"
+#include "fft_forward_r2c_64x64.h"
+#include "fft_inverse_c2r_64x64.h"
+#include "fft_forward_c2c_128x128.h"
+#include "fft_inverse_c2c_128x128.h"
+#include "fft_forward_r2c_128x128.h"
+#include "fft_inverse_c2r_128x128.h"
+#include "fft_forward_c2c_256x256.h"
+#include "fft_inverse_c2c_256x256.h"
+#include "fft_forward_r2c_256x256.h"
+#include "fft_inverse_c2r_256x256.h"
+
+extern "C" {
+
+struct fft_plan {
+    int size0, size1;
+    fft_direction_t direction;
+    fft_number_type_t input_type, output_type;
+    int (*codelet)(halide_buffer_t *, halide_buffer_t *);
+};
+
+}  // extern "C"
+
+namespace {
+
+// The four variants compiled for each size, mirroring the AOT test.
+#define FFT_PLAN_ENTRIES(N)                                            \
+    { N, N, fft_samples_to_frequency, fft_number_complex,              \
+      fft_number_complex, fft_forward_c2c_##N##x##N },                 \
+    { N, N, fft_frequency_to_samples, fft_number_complex,              \
+      fft_number_complex, fft_inverse_c2c_##N##x##N },                 \
+    { N, N, fft_samples_to_frequency, fft_number_real,                 \
+      fft_number_complex, fft_forward_r2c_##N##x##N },                 \
+    { N, N, fft_frequency_to_samples, fft_number_complex,              \
+      fft_number_real, fft_inverse_c2r_##N##x##N },
+
+const fft_plan registry[] = {
+    FFT_PLAN_ENTRIES(16)
+    FFT_PLAN_ENTRIES(32)
+    FFT_PLAN_ENTRIES(64)
+    FFT_PLAN_ENTRIES(128)
+    FFT_PLAN_ENTRIES(256)
+};
+
+#undef FFT_PLAN_ENTRIES
+
+}  // namespace
+
+extern "C" const fft_plan *fft_plan_create(int size0, int size1,
+                                           fft_direction_t direction,
+                                           fft_number_type_t input_type,
+                                           fft_number_type_t output_type) {
+    for (const fft_plan &p : registry) {
+        if (p.size0 == size0 && p.size1 == size1 &&
+            p.direction == direction &&
+            p.input_type == input_type &&
+            p.output_type == output_type) {
+            return &p;
+        }
+    }
+    return NULL;
+}
+
+extern "C" int fft_execute(const fft_plan *plan,
+                           halide_buffer_t *input, halide_buffer_t *output) {
+    return plan->codelet(input, output);
+}
+
+extern "C" void fft_plan_destroy(const fft_plan *) {
+    // Plans are static; nothing to release.
+}
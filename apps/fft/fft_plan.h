@@ -0,0 +1,66 @@
+#ifndef FFT_PLAN_H
+#define FFT_PLAN_H
+
+// A runtime plan interface over a set of AOT-compiled FFT pipelines,
+// in the style of FFTW: create a plan once, execute it many times.
+// Halide specializes each FFT at compile time, so the "planning" here
+// is a lookup into a registry of precompiled codelets rather than a
+// runtime composition of radix stages; the set of supported shapes is
+// fixed when the library is built (see FFT_PLAN_SIZES in the Makefile).
+//
+// All transforms are unnormalized (gain = 1), following the FFTW
+// convention: a forward transform followed by an inverse transform
+// scales the signal by size0 * size1.
+//
+// Buffers follow the conventions of the fft generator: 3D Float(32)
+// buffers where dimension 2 holds the components of each element
+// (extent 1 for real data, extent 2 for real-then-imaginary complex
+// data), and dimension 0 has a stride equal to the component count.
+// For real-to-complex transforms the output's extent in dimension 1 is
+// size1 / 2 + 1; for complex-to-real transforms the same holds for the
+// input.
+
+#include "HalideRuntime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    fft_samples_to_frequency = 0,  // The forward transform.
+    fft_frequency_to_samples = 1,  // The inverse transform.
+} fft_direction_t;
+
+typedef enum {
+    fft_number_real = 0,
+    fft_number_complex = 1,
+} fft_number_type_t;
+
+// An opaque handle to a precompiled transform.
+typedef struct fft_plan fft_plan;
+
+// Returns a plan for the requested transform, or NULL if no codelet
+// for that shape was compiled into the library. Plans are backed by a
+// static registry: creation never allocates, the same arguments always
+// return the same plan, and a plan remains valid for the lifetime of
+// the process.
+const fft_plan *fft_plan_create(int size0, int size1,
+                                fft_direction_t direction,
+                                fft_number_type_t input_type,
+                                fft_number_type_t output_type);
+
+// Runs the planned transform. Returns the result of the underlying
+// Halide pipeline: zero on success. Safe to call concurrently from
+// multiple threads with distinct buffers.
+int fft_execute(const fft_plan *plan,
+                halide_buffer_t *input, halide_buffer_t *output);
+
+// Accepted for symmetry with other planning APIs. Plans live in the
+// static registry, so this is a no-op.
+void fft_plan_destroy(const fft_plan *plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
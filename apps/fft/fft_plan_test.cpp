@@ -0,0 +1,155 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "HalideBuffer.h"
+
+#include "fft_plan.h"
+
+using Halide::Runtime::Buffer;
+
+namespace {
+
+Buffer<float, 3> real_buffer(int x_size, int y_size) {
+    return Buffer<float, 3>::make_interleaved(x_size, y_size, 1);
+}
+
+Buffer<float, 3> complex_buffer(int x_size, int y_size) {
+    return Buffer<float, 3>::make_interleaved(x_size, y_size, 2);
+}
+
+void fill_signal(Buffer<float, 3> &b, int comps) {
+    for (int j = 0; j < b.height(); j++) {
+        for (int i = 0; i < b.width(); i++) {
+            for (int c = 0; c < comps; c++) {
+                b(i, j, c) = (float)rand() / (float)RAND_MAX - 0.5f;
+            }
+        }
+    }
+}
+
+int check_execute(const fft_plan *plan, const char *what,
+                  Buffer<float, 3> &in, Buffer<float, 3> &out) {
+    if (!plan) {
+        std::cerr << what << ": no plan\n";
+        return 1;
+    }
+    int result = fft_execute(plan, in, out);
+    if (result != 0) {
+        std::cerr << what << " failed returning " << result << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    // A complex-to-complex round trip. The transforms are
+    // unnormalized, so the round trip gains a factor of size0 * size1.
+    {
+        const int kSize = 32;
+        const fft_plan *forward =
+            fft_plan_create(kSize, kSize, fft_samples_to_frequency,
+                            fft_number_complex, fft_number_complex);
+        const fft_plan *inverse =
+            fft_plan_create(kSize, kSize, fft_frequency_to_samples,
+                            fft_number_complex, fft_number_complex);
+
+        auto in = complex_buffer(kSize, kSize);
+        auto freq = complex_buffer(kSize, kSize);
+        auto back = complex_buffer(kSize, kSize);
+        fill_signal(in, 2);
+
+        if (check_execute(forward, "forward c2c", in, freq) ||
+            check_execute(inverse, "inverse c2c", freq, back)) {
+            return 1;
+        }
+
+        const float gain = kSize * kSize;
+        for (int j = 0; j < kSize; j++) {
+            for (int i = 0; i < kSize; i++) {
+                for (int c = 0; c < 2; c++) {
+                    float error = fabs(back(i, j, c) / gain - in(i, j, c));
+                    if (error > 1e-5f) {
+                        std::cerr << "c2c round trip off by " << error
+                                  << " at (" << i << ", " << j << ", " << c << ")\n";
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+
+    // A real-to-complex round trip at a different size, to check that
+    // planning picks the right codelet per shape.
+    {
+        const int kSize = 64;
+        const fft_plan *forward =
+            fft_plan_create(kSize, kSize, fft_samples_to_frequency,
+                            fft_number_real, fft_number_complex);
+        const fft_plan *inverse =
+            fft_plan_create(kSize, kSize, fft_frequency_to_samples,
+                            fft_number_complex, fft_number_real);
+
+        auto in = real_buffer(kSize, kSize);
+        auto freq = complex_buffer(kSize, kSize / 2 + 1);
+        auto full = complex_buffer(kSize, kSize);
+        auto back = real_buffer(kSize, kSize);
+        fill_signal(in, 1);
+
+        if (check_execute(forward, "forward r2c", in, freq)) {
+            return 1;
+        }
+
+        // The forward transform folds the spectrum of a real signal;
+        // the inverse codelet wants the full spectrum, so unfold it
+        // using conjugate symmetry first.
+        for (int j = 0; j < kSize; j++) {
+            for (int i = 0; i < kSize; i++) {
+                if (j <= kSize / 2) {
+                    full(i, j, 0) = freq(i, j, 0);
+                    full(i, j, 1) = freq(i, j, 1);
+                } else {
+                    full(i, j, 0) = freq((kSize - i) % kSize, kSize - j, 0);
+                    full(i, j, 1) = -freq((kSize - i) % kSize, kSize - j, 1);
+                }
+            }
+        }
+
+        if (check_execute(inverse, "inverse c2r", full, back)) {
+            return 1;
+        }
+
+        const float gain = kSize * kSize;
+        for (int j = 0; j < kSize; j++) {
+            for (int i = 0; i < kSize; i++) {
+                float error = fabs(back(i, j, 0) / gain - in(i, j, 0));
+                if (error > 1e-5f) {
+                    std::cerr << "r2c round trip off by " << error
+                              << " at (" << i << ", " << j << ")\n";
+                    return 1;
+                }
+            }
+        }
+    }
+
+    // Asking for a shape that wasn't compiled in must fail cleanly.
+    if (fft_plan_create(48, 48, fft_samples_to_frequency,
+                        fft_number_complex, fft_number_complex) != NULL) {
+        std::cerr << "got a plan for an uncompiled size\n";
+        return 1;
+    }
+
+    // Plans are cached: repeated creation returns the same handle.
+    if (fft_plan_create(32, 32, fft_samples_to_frequency,
+                        fft_number_complex, fft_number_complex) !=
+        fft_plan_create(32, 32, fft_samples_to_frequency,
+                        fft_number_complex, fft_number_complex)) {
+        std::cerr << "plan creation is not cached\n";
+        return 1;
+    }
+
+    std::cout << "Success!\n";
+    return 0;
+}
@@ -66,11 +66,20 @@ class GEMMGenerator :
 
         A(i, j) = As(i % s, j, i / s);
 
+        // Pack B the same way: panels of four columns (the j extent
+        // of the inner kernel), with the four entries for each step
+        // of the reduction stored adjacently. The kernel then streams
+        // through both packed operands contiguously, which is what
+        // BLAS implementations do to stay fast at large sizes. The
+        // boundary condition zero-fills the final panel; those
+        // columns are never read back.
+        Func Bs("Bs");
         Btmp(i, j) = (*B_in)(i, j);
         if (transpose_B) {
             B(i, j) = Btmp(j, i);
         } else {
-            B(i, j) = Btmp(i, j);
+            Bs(j, i, jo) = BoundaryConditions::constant_exterior(*B_in, cast<T>(0))(i, jo*4 + j);
+            B(i, j) = Bs(j % 4, i, j / 4);
         }
 
         Var k("k");
@@ -136,6 +145,11 @@ class GEMMGenerator :
                 .compute_at(B, i)
                 .vectorize(i)
                 .unroll(j);
+        } else {
+            Bs.compute_root()
+                .split(i, io, ii, s).reorder(j, ii, io, jo)
+                .unroll(j).vectorize(ii)
+                .specialize(B_.width() >= 256 && B_.height() >= 256).parallel(jo, 4);
         }
 
 
@@ -226,3 +226,169 @@ public:
 };
 
 HALIDE_REGISTER_GENERATOR(Resize, resize);
+
+// The Resize generator above re-evaluates and re-normalizes the
+// filter weights on every realization. The pair of generators below
+// split the pipeline the way production resizers do: ResizeWeights
+// builds the per-coordinate weight table (including the normalizing
+// division) once for a given scale, and ResizeApply resamples through
+// the table with nothing but multiply-adds per tap. A table for one
+// dimension is a few kilobytes, so a caller resizing more than a
+// frame or two at a given scale should build the tables once and
+// reuse them; the weight pipeline also memoizes its table, so even
+// repeated realizations at the same scale only compute it once.
+class ResizeWeights : public Halide::Generator<ResizeWeights> {
+public:
+    GeneratorParam<InterpolationType> interpolation_type
+        {"interpolation_type", Cubic,
+         {{"box", Box},
+          {"linear", Linear},
+          {"cubic", Cubic},
+          {"lanczos", Lanczos}}};
+
+    GeneratorParam<bool> upsample{"upsample", false};
+
+    Input<float> scale_factor{"scale_factor"};
+
+    // weights(x, k) is the normalized weight of the k'th filter tap
+    // for output coordinate x. The source coordinate the tap applies
+    // to is begin_index(x, ...) + k, which ResizeApply recomputes;
+    // it's two flops, and keeping it out of the table keeps the apply
+    // stage's footprints affine.
+    Output<Buffer<float>> weights{"weights", 2};
+
+    Var x, k;
+
+    Func unnormalized_kernel, kernel_sum, normalized;
+
+    void generate() {
+        const KernelInfo &info = kernel_info[interpolation_type];
+
+        Expr kernel_scaling = upsample ? Expr(1.0f) : scale_factor;
+        Expr kernel_radius = 0.5f * info.taps / kernel_scaling;
+        Expr kernel_taps = cast<int>(ceil(info.taps / kernel_scaling));
+
+        Expr sourcex = (x + 0.5f) / scale_factor - 0.5f;
+        Expr beginx = cast<int>(ceil(sourcex - kernel_radius));
+
+        RDom r(0, kernel_taps);
+
+        unnormalized_kernel(x, k) = info.kernel((k + beginx - sourcex) * kernel_scaling);
+        kernel_sum(x) = sum(unnormalized_kernel(x, r));
+        normalized(x, k) = unnormalized_kernel(x, k) / kernel_sum(x);
+
+        weights(x, k) = normalized(x, k);
+    }
+
+    void schedule() {
+        unnormalized_kernel
+            .compute_at(normalized, x)
+            .vectorize(x);
+        kernel_sum
+            .compute_at(normalized, x)
+            .vectorize(x);
+        // The table depends only on the scale factor, so repeated
+        // realizations at the same scale are served from the
+        // memoization cache instead of being recomputed.
+        normalized
+            .compute_root()
+            .memoize()
+            .reorder(k, x)
+            .vectorize(x, 8);
+        weights
+            .reorder(k, x)
+            .vectorize(x, 8);
+    }
+};
+
+HALIDE_REGISTER_GENERATOR(ResizeWeights, resize_weights);
+
+class ResizeApply : public Halide::Generator<ResizeApply> {
+public:
+    // The tap count comes from the extent of the weight tables, so
+    // unlike ResizeWeights this is not parameterized by the
+    // interpolation kernel: one apply pipeline per direction serves
+    // every kernel.
+    GeneratorParam<bool> upsample{"upsample", false};
+
+    Input<Buffer<>> input{"input", 3};
+    Input<Buffer<float>> weights_x{"weights_x", 2};
+    Input<Buffer<float>> weights_y{"weights_y", 2};
+    Input<float> scale_factor{"scale_factor"};
+    // 0.5f * taps / kernel_scaling, for the same kernel and scaling
+    // the tables were built with. Must match ResizeWeights so the
+    // first-tap indices agree.
+    Input<float> kernel_radius{"kernel_radius"};
+    Output<Buffer<>> output{"output", 3};
+
+    Var x, y, c;
+
+    Func as_float, clamped, resized_x, resized_y;
+
+    void generate() {
+        clamped = BoundaryConditions::repeat_edge(input,
+                 {{input.dim(0).min(), input.dim(0).extent()},
+                  {input.dim(1).min(), input.dim(1).extent()}});
+
+        as_float(x, y, c) = cast<float>(clamped(x, y, c));
+
+        // The first source coordinate each output coordinate's filter
+        // touches. Same expressions as in Resize and ResizeWeights.
+        Expr sourcex = (x + 0.5f) / scale_factor - 0.5f;
+        Expr sourcey = (y + 0.5f) / scale_factor - 0.5f;
+        Expr beginx = cast<int>(ceil(sourcex - kernel_radius));
+        Expr beginy = cast<int>(ceil(sourcey - kernel_radius));
+
+        RDom rx(0, weights_x.dim(1).extent());
+        RDom ry(0, weights_y.dim(1).extent());
+
+        // Perform separable resizing through the tables, in the same
+        // order as the Resize generator: x first when upsampling,
+        // second when downsampling.
+        Func resized;
+        if (upsample) {
+            resized_x(x, y, c) = sum(weights_x(x, rx) * as_float(rx + beginx, y, c));
+            resized_y(x, y, c) = sum(weights_y(y, ry) * resized_x(x, ry + beginy, c));
+            resized = resized_y;
+        } else {
+            resized_y(x, y, c) = sum(weights_y(y, ry) * as_float(x, ry + beginy, c));
+            resized_x(x, y, c) = sum(weights_x(x, rx) * resized_y(rx + beginx, y, c));
+            resized = resized_x;
+        }
+
+        if (input.type().is_float()) {
+            output(x, y, c) = clamp(resized(x, y, c), 0.0f, 1.0f);
+        } else {
+            output(x, y, c) = saturating_cast(input.type(), resized(x, y, c));
+        }
+    }
+
+    void schedule() {
+        Var xi, yi;
+        if (upsample) {
+            output
+                .tile(x, y, xi, yi, 16, 64)
+                .parallel(y)
+                .vectorize(xi);
+            resized_x
+                .compute_at(output, x)
+                .vectorize(x, 8);
+            as_float
+                .compute_at(output, y)
+                .vectorize(x, 8);
+        } else {
+            output
+                .tile(x, y, xi, yi, 32, 8)
+                .parallel(y)
+                .vectorize(xi);
+            resized_y
+                .compute_at(output, y)
+                .vectorize(x, 8);
+            resized_x
+                .compute_at(output, xi);
+        }
+    }
+};
+
+HALIDE_REGISTER_GENERATOR(ResizeApply, resize_apply);
+
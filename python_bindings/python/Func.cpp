@@ -14,6 +14,7 @@
 #include "Func_Stage.h"
 #include "Func_VarOrRVar.h"
 #include "Func_gpu.h"
+#include "GILRelease.h"
 
 #include <string>
 #include <vector>
@@ -47,19 +48,30 @@ h::Realization python_object_to_realization(p::object obj) {
     return h::Realization(buffers);
 }
 
+// The actual pipeline invocations below run without the GIL, so that
+// multi-threaded Python callers can overlap pipeline calls instead of
+// serializing on the interpreter lock. Converting the arguments and
+// results to and from Python objects still happens with the GIL held.
 template <typename... Args>
 p::object func_realize(h::Func &f, Args... args) {
-    return realization_to_python_object(f.realize(args...));
+    h::Realization r = [&]() {
+        GILRelease no_gil;
+        return f.realize(args...);
+    }();
+    return realization_to_python_object(r);
 }
 
 template <typename... Args>
 void func_realize_into(h::Func &f, Args... args) {
+    GILRelease no_gil;
     f.realize(args...);
 }
 
 template <typename... Args>
 void func_realize_tuple(h::Func &f, p::tuple obj, Args... args) {
-    f.realize(python_object_to_realization(obj), args...);
+    h::Realization r = python_object_to_realization(obj);
+    GILRelease no_gil;
+    f.realize(r, args...);
 }
 
 void func_compile_jit0(h::Func &that) {
@@ -0,0 +1,25 @@
+#ifndef GILRELEASE_H
+#define GILRELEASE_H
+
+// to avoid compiler confusion, python.hpp must be include before Halide headers
+#include <boost/python.hpp>
+
+/// Releases the Python GIL for the lifetime of the object, so that
+/// long-running Halide calls (realize, copy_to_host) can overlap with
+/// other Python threads instead of serializing on the interpreter lock.
+/// The destructor reacquires the GIL, including when unwinding after a
+/// Halide error. Only construct this while holding the GIL, and do not
+/// touch any Python state while it is alive.
+class GILRelease {
+public:
+    GILRelease() : state(PyEval_SaveThread()) {}
+    ~GILRelease() { PyEval_RestoreThread(state); }
+
+private:
+    PyThreadState *state;
+
+    GILRelease(const GILRelease &) = delete;
+    GILRelease &operator=(const GILRelease &) = delete;
+};
+
+#endif  // GILRELEASE_H
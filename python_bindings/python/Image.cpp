@@ -20,6 +20,7 @@
 #include <boost/mpl/list.hpp>
 
 #include "Func.h"
+#include "GILRelease.h"
 #include "Type.h"
 
 #include <functional>
@@ -174,9 +175,45 @@ boost::python::object get_type_function_wrapper() {
 
 template <typename T>
 void buffer_copy_to_host(h::Buffer<T> &im) {
+    // The copy can be large and does not touch Python state; let other
+    // Python threads run while it happens.
+    GILRelease no_gil;
     im.copy_to_host();
 }
 
+// Implements the numpy __array_interface__ protocol, so that
+// numpy.asarray(buffer) (and anything else that speaks the protocol)
+// wraps the buffer's host data zero-copy instead of going through
+// buffer_to_ndarray.
+template <typename T>
+p::dict buffer_array_interface(h::Buffer<T> &im) {
+    if (im.data() == nullptr) {
+        throw std::invalid_argument("Can't describe a Buffer with a null host pointer as an array");
+    }
+    // Ensure the host data is current before numpy looks at it.
+    buffer_copy_to_host(im);
+
+    const h::Type t = halide_type_of<T>();
+    const char code = t.is_float() ? 'f' : (t.is_uint() ? 'u' : 'i');
+    // Halide buffers are always in host byte order; we only target
+    // little-endian hosts.
+    const std::string typestr = "<" + std::string(1, code) + std::to_string(t.bytes());
+
+    p::list shape, strides;
+    for (int i = 0; i < im.dimensions(); i++) {
+        shape.append(im.dim(i).extent());
+        strides.append(im.dim(i).stride() * t.bytes());
+    }
+
+    p::dict interface;
+    interface["version"] = 3;
+    interface["typestr"] = typestr;
+    interface["shape"] = p::tuple(shape);
+    interface["strides"] = p::tuple(strides);
+    interface["data"] = p::make_tuple((intptr_t) im.data(), false);
+    return interface;
+}
+
 template <typename T>
 void buffer_set_host_dirty(h::Buffer<T> &im, bool value) {
     im.set_host_dirty(value);
@@ -292,6 +329,11 @@ void defineBuffer_impl(const std::string suffix, const h::Type type) {
 
         .def("copy_to_host", buffer_copy_to_host<T>, p::arg("self"),
              "Manually copy-back data to the host, if it's on a device. ")
+        .add_property("__array_interface__", &buffer_array_interface<T>,
+                      "A dict describing the host data in the numpy array interface "
+                      "protocol, so numpy.asarray(buffer) wraps it without copying. "
+                      "The returned array aliases the buffer's storage; keep the "
+                      "buffer alive while the array is in use.")
         .def("set_host_dirty", buffer_set_host_dirty<T>,
              (p::arg("self"), p::arg("dirty") = true),
              "Mark the buffer as dirty-on-host. ")
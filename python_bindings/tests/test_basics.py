@@ -270,6 +270,29 @@ def test_image_to_ndarray():
 
     return
 
+def test_buffer_array_interface():
+
+    try:
+        import numpy
+    except ImportError:
+        print("Skipping test_buffer_array_interface")
+        return
+
+    i0 = Buffer(Int(16), 50, 40)
+    i0[24, 24] = 42
+
+    a0 = numpy.asarray(i0)
+    assert a0.dtype == numpy.int16
+    assert a0.shape == (50, 40)
+    assert a0[24, 24] == 42
+
+    # The array aliases the buffer's storage, so writes are visible both ways.
+    a0[10, 10] = 7
+    assert i0(10, 10) == 7
+
+    return
+
+
 def test_param_bug():
     "see https://github.com/rodrigob/Halide/issues/1"
 
@@ -297,6 +320,7 @@ if __name__ == "__main__":
     test_float_or_int()
     test_ndarray_to_image()
     test_image_to_ndarray()
+    test_buffer_array_interface()
     test_types()
     test_operator_order()
     test_basics()
@@ -90,6 +90,34 @@ public:
     }
 };
 
+namespace {
+
+// Fold a list of asserts into a single AssertStmt which tests the
+// conjunction of all of their conditions. Codegen gives assert branches
+// very-likely branch weights, so the hot path pays for one branch-free
+// evaluation of the combined condition instead of one branch per check,
+// and the buffer metadata the conditions share is only loaded once. The
+// error expression walks the original checks in order, so the check that
+// fails still reports its own error.
+Stmt fold_asserts(const vector<Stmt> &asserts) {
+    internal_assert(!asserts.empty());
+    Expr condition;
+    for (const Stmt &st : asserts) {
+        const AssertStmt *a = st.as<AssertStmt>();
+        internal_assert(a);
+        condition = condition.defined() ? (condition && a->condition) : a->condition;
+    }
+    const AssertStmt *last = asserts.back().as<AssertStmt>();
+    Expr error = last->message;
+    for (size_t i = asserts.size() - 1; i > 0; i--) {
+        const AssertStmt *a = asserts[i-1].as<AssertStmt>();
+        error = select(a->condition, error, a->message);
+    }
+    return AssertStmt::make(condition, error);
+}
+
+}  // namespace
+
 Stmt add_image_checks(Stmt s,
                       const vector<Function> &outputs,
                       const Target &t,
@@ -558,22 +586,22 @@ Stmt add_image_checks(Stmt s,
         }
     }
 
-    // Inject the code that checks the host pointers.
+    // Inject the code that checks the host pointers and alignment, and
+    // that no dimension math overflows, folded into a single guard.
     if (!no_asserts) {
-        for (size_t i = asserts_host_non_null.size(); i > 0; i--) {
-            s = Block::make(asserts_host_non_null[i-1], s);
-        }
-        for (size_t i = asserts_host_alignment.size(); i > 0; i--) {
-            s = Block::make(asserts_host_alignment[i-1], s);
-        }
-    }
-    // Inject the code that checks that no dimension math overflows
-    if (!no_asserts) {
-        for (size_t i = dims_no_overflow_asserts.size(); i > 0; i--) {
-            s = Block::make(dims_no_overflow_asserts[i-1], s);
+        vector<Stmt> checks;
+        checks.insert(checks.end(), dims_no_overflow_asserts.begin(),
+                      dims_no_overflow_asserts.end());
+        checks.insert(checks.end(), asserts_host_alignment.begin(),
+                      asserts_host_alignment.end());
+        checks.insert(checks.end(), asserts_host_non_null.begin(),
+                      asserts_host_non_null.end());
+        if (!checks.empty()) {
+            s = Block::make(fold_asserts(checks), s);
         }
 
-        // Inject the code that defines the proposed sizes.
+        // Inject the code that defines the total extents the overflow
+        // checks test.
         for (size_t i = lets_overflow.size(); i > 0; i--) {
             s = LetStmt::make(lets_overflow[i-1].first, lets_overflow[i-1].second, s);
         }
@@ -590,19 +618,15 @@ Stmt add_image_checks(Stmt s,
     // prepending code.
 
     if (!no_asserts) {
-        // Inject the code that checks the constraints are correct.
-        for (size_t i = asserts_constrained.size(); i > 0; i--) {
-            s = Block::make(asserts_constrained[i-1], s);
-        }
-
-        // Inject the code that checks for out-of-bounds access to the buffers.
-        for (size_t i = asserts_required.size(); i > 0; i--) {
-            s = Block::make(asserts_required[i-1], s);
-        }
-
-        // Inject the code that checks that elem_sizes are ok.
-        for (size_t i = asserts_elem_size.size(); i > 0; i--) {
-            s = Block::make(asserts_elem_size[i-1], s);
+        // Inject the code that checks the buffer types, that accesses are
+        // in bounds, and that the constraints are correct, folded into a
+        // single guard.
+        vector<Stmt> checks;
+        checks.insert(checks.end(), asserts_elem_size.begin(), asserts_elem_size.end());
+        checks.insert(checks.end(), asserts_required.begin(), asserts_required.end());
+        checks.insert(checks.end(), asserts_constrained.begin(), asserts_constrained.end());
+        if (!checks.empty()) {
+            s = Block::make(fold_asserts(checks), s);
         }
     }
 
@@ -616,11 +640,9 @@ Stmt add_image_checks(Stmt s,
         }
     }
 
-    if (!no_asserts) {
+    if (!no_asserts && !asserts_proposed.empty()) {
         // Inject the code that checks the proposed sizes still pass the bounds checks
-        for (size_t i = asserts_proposed.size(); i > 0; i--) {
-            s = Block::make(asserts_proposed[i-1], s);
-        }
+        s = Block::make(fold_asserts(asserts_proposed), s);
     }
 
     // Inject the code that defines the proposed sizes.
@@ -21,6 +21,18 @@ namespace Internal {
 /** Insert checks to make sure a statement doesn't read out of bounds
  * on inputs or outputs, and that the inputs and outputs conform to
  * the format required (e.g. stride.0 must be 1).
+ *
+ * The checks for each buffer are folded into a small number of guards,
+ * each testing the conjunction of its checks in one very-likely branch,
+ * so the prologue of a pipeline realized at a high rate over small
+ * regions stays cheap. The failing check is identified again on the
+ * cold path to report the right error.
+ *
+ * With Target::NoAsserts the guards are omitted entirely, but the
+ * bounds-query handling is still injected unless Target::NoBoundsQuery
+ * is also set: a NoAsserts pipeline continues to answer
+ * Pipeline::infer_input_bounds queries, it just doesn't validate the
+ * buffers it is finally run on.
  */
 Stmt add_image_checks(Stmt s,
                       const std::vector<Function> &outputs,
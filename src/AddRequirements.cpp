@@ -0,0 +1,160 @@
+#include "AddRequirements.h"
+#include "Debug.h"
+#include "ExprUsesVar.h"
+#include "IRMutator.h"
+#include "IRVisitor.h"
+#include "Scope.h"
+#include "Simplify.h"
+#include "Solve.h"
+#include "Substitute.h"
+#include "Target.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Collect the distinct variables referenced by an expression, in
+// traversal order.
+class CollectVars : public IRGraphVisitor {
+public:
+    vector<string> vars;
+
+    using IRGraphVisitor::visit;
+
+    void visit(const Variable *op) {
+        if (std::find(vars.begin(), vars.end(), op->name) == vars.end()) {
+            vars.push_back(op->name);
+        }
+    }
+};
+
+// Like Substitute, but leaves AssertStmts alone. The runtime checks
+// injected for the requirements are what make assuming the required
+// facts sound, so substituting the facts into their own conditions
+// (which would fold them to true and remove them) must be avoided;
+// other asserts are left intact too, as removing a check is never
+// necessary for correctness.
+class SubstituteFacts : public IRMutator2 {
+    const map<string, Expr> &replace;
+    Scope<int> hidden;
+
+    using IRMutator2::visit;
+
+    Expr visit(const Variable *op) override {
+        auto iter = replace.find(op->name);
+        if (iter != replace.end() && !hidden.contains(op->name)) {
+            return iter->second;
+        }
+        return op;
+    }
+
+    bool replaces(const string &s) const {
+        return replace.find(s) != replace.end();
+    }
+
+    template<typename LetOrLetStmt, typename StmtOrExpr>
+    StmtOrExpr visit_let(const LetOrLetStmt *op) {
+        Expr new_value = mutate(op->value);
+        bool shadows = replaces(op->name);
+        if (shadows) {
+            hidden.push(op->name, 0);
+        }
+        StmtOrExpr new_body = mutate(op->body);
+        if (shadows) {
+            hidden.pop(op->name);
+        }
+        if (new_value.same_as(op->value) &&
+            new_body.same_as(op->body)) {
+            return op;
+        }
+        return LetOrLetStmt::make(op->name, new_value, new_body);
+    }
+
+    Expr visit(const Let *op) override {
+        return visit_let<Let, Expr>(op);
+    }
+
+    Stmt visit(const LetStmt *op) override {
+        return visit_let<LetStmt, Stmt>(op);
+    }
+
+    Stmt visit(const AssertStmt *op) override {
+        return op;
+    }
+
+public:
+    SubstituteFacts(const map<string, Expr> &m) : replace(m) {}
+};
+
+}  // namespace
+
+Stmt add_requirement_checks(Stmt s, const vector<Expr> &requirements, const Target &t) {
+    if (t.has_feature(Target::NoAsserts)) {
+        return s;
+    }
+
+    // Prepend in reverse so the checks run in the order they were added.
+    for (size_t i = requirements.size(); i > 0; i--) {
+        Expr condition = requirements[i - 1];
+        std::ostringstream cond_str;
+        cond_str << condition;
+        Expr error = Call::make(Int(32), "halide_error_requirement_failed",
+                                {cond_str.str(), Expr(std::string("pipeline requirement"))},
+                                Call::Extern);
+        s = Block::make(AssertStmt::make(condition, error), s);
+    }
+    return s;
+}
+
+Stmt apply_requirements(Stmt s, const vector<Expr> &requirements) {
+    // Substitutions derived from solved equalities, applied together
+    // at the end.
+    map<string, Expr> replacements;
+
+    for (Expr r : requirements) {
+        // Later requirements may mention variables that an earlier
+        // equality eliminates; keep the fact set consistent.
+        r = simplify(substitute(replacements, r));
+        if (is_one(r)) {
+            continue;
+        }
+
+        CollectVars vars;
+        r.accept(&vars);
+
+        for (const string &v : vars.vars) {
+            SolverResult solved = solve_expression(r, v);
+            if (!solved.fully_solved) {
+                continue;
+            }
+            const EQ *eq = solved.result.as<EQ>();
+            if (!eq) {
+                continue;
+            }
+            const Variable *lhs = eq->a.as<Variable>();
+            if (lhs && lhs->name == v && !expr_uses_var(eq->b, v)) {
+                replacements[v] = eq->b;
+                break;
+            }
+        }
+    }
+
+    if (replacements.empty()) {
+        return s;
+    }
+
+    debug(2) << "Substituting " << replacements.size()
+             << " facts from pipeline requirements\n";
+    return SubstituteFacts(replacements).mutate(s);
+}
+
+}  // namespace Internal
+}  // namespace Halide
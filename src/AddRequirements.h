@@ -0,0 +1,38 @@
+#ifndef HALIDE_INTERNAL_ADD_REQUIREMENTS_H
+#define HALIDE_INTERNAL_ADD_REQUIREMENTS_H
+
+/** \file
+ *
+ * Defines the lowering passes that handle the requirements added via
+ * Pipeline::add_requirement: injecting the runtime checks, and
+ * exploiting the required facts at compile time.
+ */
+
+#include <vector>
+
+#include "IR.h"
+
+namespace Halide {
+
+struct Target;
+
+namespace Internal {
+
+/** Prepend a runtime check for each pipeline requirement. Omitted
+ * when the target has the NoAsserts feature. */
+Stmt add_requirement_checks(Stmt s, const std::vector<Expr> &requirements, const Target &t);
+
+/** Exploit the pipeline requirements at compile time. Equalities that
+ * the solver can put into var == expr form (e.g. width == height, or
+ * stride == width) are substituted through the statement, so that
+ * provably-equal address math folds together in the simplification
+ * passes that follow. The conditions of AssertStmts are deliberately
+ * left untouched: the runtime checks injected by
+ * add_requirement_checks are what make assuming these facts sound, so
+ * they must not fold to true. */
+Stmt apply_requirements(Stmt s, const std::vector<Expr> &requirements);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -23,7 +23,19 @@ vector<ApplySplitResult> apply_split(const Split &split, bool is_update, string
 
         dim_extent_alignment[split.inner] = split.factor;
 
-        Expr base = outer * split.factor + old_min;
+        Expr factor = split.factor;
+        if (!is_const(factor)) {
+            // The split factor is only known at runtime (e.g. it's a
+            // Param or derived from the output extents). Guard
+            // against nonpositive values, which would otherwise
+            // produce divides by zero in the loop bounds or a loop
+            // nest that iterates backwards. When the factor matters
+            // for simplification it is a constant, so the max
+            // simplifies away.
+            factor = max(factor, 1);
+        }
+
+        Expr base = outer * factor + old_min;
         string base_name = prefix + split.inner + ".base";
         Expr base_var = Variable::make(Int(32), base_name);
         string old_var_name = prefix + split.old_var;
@@ -47,7 +59,8 @@ vector<ApplySplitResult> apply_split(const Split &split, bool is_update, string
         } else if (is_one(split.factor)) {
             // The split factor trivially divides the old extent,
             // but we know nothing new about the outer dimension.
-        } else if (tail == TailStrategy::GuardWithIf) {
+        } else if (tail == TailStrategy::GuardWithIf ||
+                   tail == TailStrategy::Predicate) {
             // It's an exact split but we failed to prove that the
             // extent divides the factor. Use predication.
 
@@ -56,16 +69,24 @@ vector<ApplySplitResult> apply_split(const Split &split, bool is_update, string
             // that bounds inference has a chance of understanding
             // what it means for it to be limited by the if
             // statement's condition.
-            Expr rebased = outer * split.factor + inner;
+            Expr rebased = outer * factor + inner;
             string rebased_var_name = prefix + split.old_var + ".rebased";
             Expr rebased_var = Variable::make(Int(32), rebased_var_name);
 
             result.push_back(ApplySplitResult(
                 prefix + split.old_var, rebased_var + old_min, ApplySplitResult::Substitution));
 
-            // Tell Halide to optimize for the case in which this
-            // condition is true by partitioning some outer loop.
-            Expr cond = likely(rebased_var < old_extent);
+            Expr cond = rebased_var < old_extent;
+            if (tail == TailStrategy::GuardWithIf) {
+                // Tell Halide to optimize for the case in which this
+                // condition is true by partitioning some outer loop.
+                cond = likely(cond);
+            }
+            // For TailStrategy::Predicate we deliberately don't mark
+            // the condition as likely, so that loop partitioning
+            // leaves it alone and it survives into the vectorized
+            // loop body, where it becomes a predicate on the vector
+            // loads and stores.
             result.push_back(ApplySplitResult(cond));
             result.push_back(ApplySplitResult(rebased_var_name, rebased, ApplySplitResult::LetStmt));
 
@@ -78,7 +99,7 @@ vector<ApplySplitResult> apply_split(const Split &split, bool is_update, string
             // non-trivial loop.
             base = likely_if_innermost(base);
 
-            base = Min::make(base, old_max + (1 - split.factor));
+            base = Min::make(base, old_max + (1 - factor));
         } else {
             internal_assert(tail == TailStrategy::RoundUp);
         }
@@ -138,8 +159,14 @@ vector<std::pair<string, Expr>> compute_loop_bounds_after_split(const Split &spl
     Expr old_var_max = Variable::make(Int(32), prefix + split.old_var + ".loop_max");
     Expr old_var_min = Variable::make(Int(32), prefix + split.old_var + ".loop_min");
     if (split.is_split()) {
-        Expr inner_extent = split.factor;
-        Expr outer_extent = (old_var_max - old_var_min + split.factor)/split.factor;
+        Expr factor = split.factor;
+        if (!is_const(factor)) {
+            // Runtime split factors are guarded against nonpositive
+            // values, as in apply_split above.
+            factor = max(factor, 1);
+        }
+        Expr inner_extent = factor;
+        Expr outer_extent = (old_var_max - old_var_min + factor)/factor;
         let_stmts.push_back({ prefix + split.inner + ".loop_min", 0 });
         let_stmts.push_back({ prefix + split.inner + ".loop_max", inner_extent-1 });
         let_stmts.push_back({ prefix + split.inner + ".loop_extent", inner_extent });
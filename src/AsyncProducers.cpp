@@ -0,0 +1,429 @@
+#include "AsyncProducers.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Debug.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+Stmt no_op() {
+    return Evaluate::make(0);
+}
+
+// Count the produce and consume markers for a Func within a Stmt, and
+// note whether any production happens under a non-serial loop, which
+// would scramble the order of semaphore releases.
+class FindProduction : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) {
+        bool old = in_non_serial;
+        if (op->for_type != ForType::Serial &&
+            op->for_type != ForType::Unrolled) {
+            in_non_serial = true;
+        }
+        IRVisitor::visit(op);
+        in_non_serial = old;
+    }
+
+    void visit(const ProducerConsumer *op) {
+        if (op->name == func) {
+            if (op->is_producer) {
+                produces++;
+                production_non_serial = production_non_serial || in_non_serial;
+            } else {
+                consumes++;
+            }
+        }
+        IRVisitor::visit(op);
+    }
+
+    string func;
+    bool in_non_serial = false;
+
+public:
+    int produces = 0, consumes = 0;
+    bool production_non_serial = false;
+    FindProduction(const string &f) : func(f) {}
+};
+
+// Does a Stmt load from, call, or provide values of a Func? Variables
+// that merely mention the Func's bounds (e.g. f.s0.x.min) don't
+// count; they stay well-defined whether or not the production runs.
+class UsesFunc : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Call *op) {
+        if (op->call_type == Call::Halide && op->name == func) {
+            result = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Variable *op) {
+        // f.buffer, or f.0.buffer and friends for Tuple-valued Funcs.
+        if (starts_with(op->name, func + ".") &&
+            ends_with(op->name, ".buffer")) {
+            result = true;
+        }
+    }
+
+    void visit(const Provide *op) {
+        if (op->name == func) {
+            result = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+    string func;
+
+public:
+    bool result = false;
+    UsesFunc(const string &f) : func(f) {}
+};
+
+bool stmt_uses_func(Stmt s, const string &func) {
+    UsesFunc uses(func);
+    s.accept(&uses);
+    return uses.result;
+}
+
+// Grab the production subtree of a Func (including the produce marker).
+class ExtractProduction : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const ProducerConsumer *op) {
+        if (op->name == func && op->is_producer) {
+            result = op;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    string func;
+
+public:
+    Stmt result;
+    ExtractProduction(const string &f) : func(f) {}
+};
+
+bool contains_production(Stmt s, const string &func) {
+    ExtractProduction p(func);
+    s.accept(&p);
+    return p.result.defined();
+}
+
+// The producer side of the fork: the production of the async Func
+// (followed by a semaphore release), the productions of anything it
+// consumes that is produced within the same realization, and the
+// loops and lets leading to them. Everything else collapses to a
+// no-op.
+class GenerateProducerBody : public IRMutator2 {
+    using IRMutator2::visit;
+
+    Stmt visit(const ProducerConsumer *op) override {
+        if (op->name == func) {
+            if (op->is_producer) {
+                Expr release = Call::make(Int(32), "halide_semaphore_release",
+                                          {sem_var, 1}, Call::Extern);
+                return Block::make(op, Evaluate::make(release));
+            } else {
+                return no_op();
+            }
+        } else if (op->is_producer) {
+            if (contains_production(op->body, func)) {
+                // An enclosing production (e.g. the output's), with
+                // the async production nested somewhere inside. Keep
+                // digging.
+                Stmt body = mutate(op->body);
+                if (is_no_op(body)) {
+                    return body;
+                }
+                return ProducerConsumer::make(op->name, true, body);
+            } else if (needed.count(op->name)) {
+                // Dependencies of the async production come along
+                // verbatim.
+                return op;
+            } else {
+                // Unrelated productions are the consumer's business.
+                return no_op();
+            }
+        } else {
+            Stmt body = mutate(op->body);
+            if (is_no_op(body)) {
+                return body;
+            }
+            return ProducerConsumer::make(op->name, false, body);
+        }
+    }
+
+    Stmt visit(const Provide *op) override {
+        // Any Provide reached by this recursion is outside the
+        // productions kept above, so it's consumer-side work.
+        return no_op();
+    }
+
+    Stmt visit(const For *op) override {
+        Stmt body = mutate(op->body);
+        if (is_no_op(body)) {
+            return body;
+        }
+        return For::make(op->name, op->min, op->extent,
+                         op->for_type, op->device_api, body);
+    }
+
+    Stmt visit(const LetStmt *op) override {
+        Stmt body = mutate(op->body);
+        if (is_no_op(body)) {
+            return body;
+        }
+        return LetStmt::make(op->name, op->value, body);
+    }
+
+    Stmt visit(const IfThenElse *op) override {
+        Stmt then_case = mutate(op->then_case);
+        Stmt else_case;
+        if (op->else_case.defined()) {
+            else_case = mutate(op->else_case);
+        }
+        if (is_no_op(then_case) && is_no_op(else_case)) {
+            return no_op();
+        }
+        return IfThenElse::make(op->condition, then_case, else_case);
+    }
+
+    Stmt visit(const Block *op) override {
+        Stmt first = mutate(op->first);
+        Stmt rest = mutate(op->rest);
+        if (is_no_op(first)) {
+            return rest;
+        }
+        if (is_no_op(rest)) {
+            return first;
+        }
+        return Block::make(first, rest);
+    }
+
+    Stmt visit(const Realize *op) override {
+        Stmt body = mutate(op->body);
+        if (is_no_op(body)) {
+            return body;
+        }
+        return Realize::make(op->name, op->types, op->bounds,
+                             op->condition, body, op->memory_type);
+    }
+
+    Stmt visit(const Allocate *op) override {
+        Stmt body = mutate(op->body);
+        if (is_no_op(body)) {
+            return body;
+        }
+        return Allocate::make(op->name, op->type, op->extents, op->condition,
+                              body, op->new_expr, op->free_function,
+                              op->memory_type);
+    }
+
+    string func;
+    Expr sem_var;
+    const set<string> &needed;
+
+public:
+    GenerateProducerBody(const string &f, Expr sem, const set<string> &n)
+        : func(f), sem_var(sem), needed(n) {}
+};
+
+// The consumer side: everything except the async production, with a
+// semaphore acquire in front of each compute-level iteration of the
+// consumer.
+class GenerateConsumerBody : public IRMutator2 {
+    using IRMutator2::visit;
+
+    Stmt visit(const ProducerConsumer *op) override {
+        if (op->name == func) {
+            if (op->is_producer) {
+                return no_op();
+            } else {
+                Expr acquire = Call::make(Int(32), "halide_semaphore_acquire",
+                                          {sem_var, 1}, Call::Extern);
+                return Block::make(Evaluate::make(acquire), op);
+            }
+        }
+        return IRMutator2::visit(op);
+    }
+
+    string func;
+    Expr sem_var;
+
+public:
+    GenerateConsumerBody(const string &f, Expr sem)
+        : func(f), sem_var(sem) {}
+};
+
+// Strip the production of a Func, leaving its consume markers alone.
+class PruneProduction : public IRMutator2 {
+    using IRMutator2::visit;
+
+    Stmt visit(const ProducerConsumer *op) override {
+        if (op->name == func && op->is_producer) {
+            return no_op();
+        }
+        return IRMutator2::visit(op);
+    }
+
+    string func;
+
+public:
+    PruneProduction(const string &f) : func(f) {}
+};
+
+// Splice out the Realize node for a Func whose production has been
+// pruned away.
+class PruneRealization : public IRMutator2 {
+    using IRMutator2::visit;
+
+    Stmt visit(const Realize *op) override {
+        if (op->name == func) {
+            return mutate(op->body);
+        }
+        return IRMutator2::visit(op);
+    }
+
+    string func;
+
+public:
+    PruneRealization(const string &f) : func(f) {}
+};
+
+class ForkAsyncProducers : public IRMutator2 {
+    using IRMutator2::visit;
+
+    Stmt visit(const Realize *op) override {
+        Stmt body = mutate(op->body);
+
+        auto it = env.find(op->name);
+        bool lift = (it != env.end() &&
+                     it->second.schedule().async() &&
+                     !(it->second.schedule().store_level() ==
+                       it->second.schedule().compute_level()));
+        if (lift) {
+            Stmt forked = fork_producer(op->name, body);
+            if (forked.defined()) {
+                body = forked;
+            } else {
+                debug(2) << "Not forking async producer " << op->name
+                         << "; leaving it serial\n";
+            }
+        }
+
+        if (body.same_as(op->body)) {
+            return op;
+        }
+        return Realize::make(op->name, op->types, op->bounds,
+                             op->condition, body, op->memory_type);
+    }
+
+    // Split the body of a Realize node into producer and consumer
+    // tasks run as a two-way parallel fork, with a semaphore pacing
+    // the consumer. Returns an undefined Stmt if the fork can't be
+    // done safely.
+    Stmt fork_producer(const string &func, Stmt body) {
+        FindProduction production(func);
+        body.accept(&production);
+        if (production.produces != 1 ||
+            production.consumes != 1 ||
+            production.production_non_serial) {
+            return Stmt();
+        }
+
+        // Anything the production consumes that is produced within
+        // this realization must come along to the producer side.
+        ExtractProduction extract(func);
+        body.accept(&extract);
+        internal_assert(extract.result.defined());
+        set<string> needed;
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (const auto &i : env) {
+                const string &g = i.first;
+                if (g == func || needed.count(g)) {
+                    continue;
+                }
+                bool used = stmt_uses_func(extract.result, g);
+                for (const string &n : needed) {
+                    if (used) break;
+                    ExtractProduction dep(n);
+                    body.accept(&dep);
+                    used = dep.result.defined() && stmt_uses_func(dep.result, g);
+                }
+                if (used) {
+                    needed.insert(g);
+                    progress = true;
+                }
+            }
+        }
+
+        string sem_name = func + ".semaphore";
+        Expr sem_var = Variable::make(type_of<halide_semaphore_t *>(), sem_name);
+
+        GenerateProducerBody gen_producer(func, sem_var, needed);
+        Stmt producer = gen_producer.mutate(body);
+
+        GenerateConsumerBody gen_consumer(func, sem_var);
+        Stmt consumer = gen_consumer.mutate(body);
+
+        // Productions that moved to the producer side should drop out
+        // of the consumer side, along with their storage. If one
+        // doesn't (because the consumer also uses it directly), bail
+        // rather than silently compute it twice.
+        for (const string &g : needed) {
+            FindProduction p(g);
+            consumer.accept(&p);
+            if (p.produces == 0) {
+                // Produced outside this realization; shared read-only.
+                continue;
+            }
+            Stmt pruned = PruneProduction(g).mutate(consumer);
+            if (stmt_uses_func(pruned, g)) {
+                return Stmt();
+            }
+            consumer = PruneRealization(g).mutate(pruned);
+        }
+
+        // Express the fork as a parallel loop of extent two, as
+        // ScheduleFunctions does for same-level async producers, so
+        // the existing task-spawning machinery builds the closure.
+        string fork_name = func + ".__fork";
+        Expr fork_var = Variable::make(Int(32), fork_name);
+        Stmt fork_body = IfThenElse::make(fork_var == 0, producer, consumer);
+        Stmt loop = For::make(fork_name, 0, 2, ForType::Parallel, DeviceAPI::None, fork_body);
+
+        Expr init = Call::make(Int(32), "halide_semaphore_init",
+                               {sem_var, 0}, Call::Extern);
+        Stmt block = Block::make(Evaluate::make(init), loop);
+
+        // The semaphore lives on the stack alongside the fork.
+        return Allocate::make(sem_name, UInt(64), {2}, const_true(), block);
+    }
+
+    const map<string, Function> &env;
+
+public:
+    ForkAsyncProducers(const map<string, Function> &e) : env(e) {}
+};
+
+}  // namespace
+
+Stmt fork_async_producers(Stmt s, const map<string, Function> &env) {
+    return ForkAsyncProducers(env).mutate(s);
+}
+
+}
+}
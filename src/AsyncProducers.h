@@ -0,0 +1,30 @@
+#ifndef HALIDE_ASYNC_PRODUCERS_H
+#define HALIDE_ASYNC_PRODUCERS_H
+
+/** \file
+ *
+ * Defines the lowering pass that breaks up async producers whose
+ * store level is outside their compute level into tasks of their own,
+ * so they can run ahead of their consumers.
+ */
+
+#include <map>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** For each Func scheduled as async() whose store level is outside
+ * its compute level, fork the production off into its own task
+ * spanning the consumer's loops. The producer signals a semaphore
+ * after each production; the consumer acquires it before each of its
+ * compute-level iterations, so the producer is free to work
+ * arbitrarily far ahead within the realization. Funcs for which the
+ * fork cannot be done safely are left serial. */
+Stmt fork_async_producers(Stmt s, const std::map<std::string, Function> &env);
+
+}
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <regex>
 
+#include "Associativity.h"
 #include "AutoSchedule.h"
 #include "AutoScheduleUtils.h"
 #include "ExprUsesVar.h"
@@ -742,6 +743,12 @@ struct AutoSchedule {
     // schedule is placed last in the list).
     map<string, map<int, vector<string>>> func_schedules;
 
+    // Complete statements emitted before the schedule chain of a function
+    // stage. rfactor introduces new Funcs which are not part of 'env', so
+    // the declaration of the factored Func and the schedules applied to it
+    // cannot go through 'func_schedules'; they are recorded here verbatim.
+    map<string, map<int, vector<string>>> stage_prologues;
+
     // Store the list of vars/rvars used in the schedule applied to some
     // function stages.
     map<string, map<int, set<string>>> used_vars;
@@ -810,14 +817,41 @@ struct AutoSchedule {
                 }
             }
 
+            // Merge the stage numbers which have schedules with those which
+            // have prologue statements; rfactor can leave a stage with only
+            // a prologue.
+            set<int> stage_nums;
             for (const auto &s : f.second) {
-                internal_assert(!s.second.empty());
+                stage_nums.insert(s.first);
+            }
+            const auto &pro_iter = sched.stage_prologues.find(f.first);
+            if (pro_iter != sched.stage_prologues.end()) {
+                for (const auto &s : pro_iter->second) {
+                    stage_nums.insert(s.first);
+                }
+            }
+
+            for (int stage_num : stage_nums) {
+                if (pro_iter != sched.stage_prologues.end()) {
+                    const auto &stmts = pro_iter->second.find(stage_num);
+                    if (stmts != pro_iter->second.end()) {
+                        for (const string &stmt : stmts->second) {
+                            schedule_ss << "    " << stmt << "\n";
+                        }
+                    }
+                }
+
+                const auto &s = f.second.find(stage_num);
+                if (s == f.second.end()) {
+                    continue;
+                }
+                internal_assert(!s->second.empty());
                 schedule_ss << "    " << fname;
-                if (s.first > 0) {
-                    schedule_ss << ".update(" << std::to_string(s.first - 1) << ")";
+                if (s->first > 0) {
+                    schedule_ss << ".update(" << std::to_string(s->first - 1) << ")";
                 }
-                for (size_t i = 0; i < s.second.size(); ++i) {
-                    schedule_ss << "\n        ." << s.second[i];
+                for (size_t i = 0; i < s->second.size(); ++i) {
+                    schedule_ss << "\n        ." << s->second[i];
                 }
                 schedule_ss << ";\n";
             }
@@ -849,6 +883,13 @@ struct AutoSchedule {
             }
         }
     }
+
+    void push_stage_prologue(const string &stage_name, size_t stage_num,
+                             const string &stmt) {
+        vector<string> v = split_string(stage_name, ".");
+        internal_assert(!v.empty());
+        stage_prologues[v[0]][stage_num].push_back(stmt);
+    }
 };
 
 // Implement the grouping algorithm and the cost model for making the grouping
@@ -1049,10 +1090,21 @@ struct Partitioner {
     RegionCosts &costs;
     // Output functions of the pipeline.
     const vector<Function> &outputs;
+    // True when generating a schedule for a GPU target. Tiles of the group
+    // output then become thread blocks, and the grouping is additionally
+    // constrained so that the intermediate allocations of a group fit in
+    // shared memory.
+    const bool gpu_schedule;
+
+    // Hard device limits assumed when generating GPU schedules. These are
+    // conservative values that hold across current CUDA and OpenCL devices.
+    static const int gpu_shared_mem_limit = 48 * 1024;
+    static const int gpu_max_threads_per_block = 1024;
 
     Partitioner(const map<string, Box> &_pipeline_bounds, const MachineParams &_arch_params,
                 DependenceAnalysis &_dep_analysis, RegionCosts &_costs,
-                const vector<Function> &_outputs, const set<string> &unbounded);
+                const vector<Function> &_outputs, const set<string> &unbounded,
+                bool _gpu_schedule);
 
     void initialize_groups();
 
@@ -1160,9 +1212,9 @@ struct Partitioner {
     // visible to the user. Additionally, functions like sum and maximum are not
     // user visible. More thought needs to go into interaction between the user and
     // auto scheduling.
-    void generate_cpu_schedule(const Target &t, AutoSchedule &sched);
+    void generate_schedule(const Target &t, AutoSchedule &sched);
 
-    // Same as \ref Partitioner::generate_cpu_schedule, but this generates and
+    // Same as \ref Partitioner::generate_schedule, but this generates and
     // applies schedules for a group of function stages.
 
     void generate_group_cpu_schedule(const Group &g, const Target &t,
@@ -1171,6 +1223,37 @@ struct Partitioner {
                                      const set<string> &inlines,
                                      AutoSchedule &sched);
 
+    // Attempt to parallelize a serial associative reduction with rfactor.
+    // The reduction domain is split so that the outer piece matches the
+    // machine parallelism, the outer rvar is lifted into a pure dimension
+    // of an intermediate Func computing partial results, and the partial
+    // results are merged by the (now cheap) original update. Returns true
+    // if the factoring was applied, in which case the stage has been fully
+    // scheduled and the generic path must not touch it.
+    bool try_parallelize_reduction(const Group &g, Stage f_handle, Definition def,
+                                   const map<string, Expr> &stg_estimates,
+                                   const Target &t, AutoSchedule &sched);
+
+    // GPU counterpart of \ref Partitioner::generate_group_cpu_schedule. The
+    // tile structure chosen by the grouping maps onto the GPU grid: the outer
+    // tile dimensions become blocks, the dimensions created by the tile splits
+    // become threads, and group members are computed inside the block so their
+    // allocations land in shared memory.
+    void generate_group_gpu_schedule(const Group &g, const Target &t,
+                                     const map<FStage, DimBounds> &group_loop_bounds,
+                                     const map<string, Box> &group_storage_bounds,
+                                     const set<string> &inlines,
+                                     AutoSchedule &sched);
+
+    // Mark the innermost dimensions of 'f_handle' as GPU threads, walking
+    // outwards while the cumulative thread count provably fits in a block.
+    // Only the first 'num_inner_dims' dimensions are considered; dimensions
+    // beyond that belong to the block-level tile structure. Returns the number
+    // of dimensions marked.
+    int mark_gpu_threads(Stage f_handle, int stage_num, Definition def,
+                         int num_inner_dims, const set<string> &rvars,
+                         const map<string, Expr> &estimates, AutoSchedule &sched);
+
     // Split the dimension of stage 'f_handle' along 'v' into inner and outer
     // dimensions. Modify 'estimates' according to the split and append the split
     // schedule to 'sched'.
@@ -1293,9 +1376,11 @@ Partitioner::Partitioner(const map<string, Box> &_pipeline_bounds,
                          DependenceAnalysis &_dep_analysis,
                          RegionCosts &_costs,
                          const vector<Function> &_outputs,
-                         const set<string> &unbounded)
+                         const set<string> &unbounded,
+                         bool _gpu_schedule)
         : pipeline_bounds(_pipeline_bounds), arch_params(_arch_params),
-          dep_analysis(_dep_analysis), costs(_costs), outputs(_outputs) {
+          dep_analysis(_dep_analysis), costs(_costs), outputs(_outputs),
+          gpu_schedule(_gpu_schedule) {
     // Place each stage of a function in its own group. Each stage is
     // a node in the pipeline graph. If a function is unbounded, then
     // we should inline it.
@@ -1509,7 +1594,11 @@ vector<map<string, Expr>> Partitioner::generate_tile_configs(const FStage &stg)
     // at least size of 64 gives enough values for vectorization and can help
     // with prefetching. This also interacts with the number of parallel tasks
     // that are generated.
-    int min_inner_dim_size = 64;
+    //
+    // On the GPU the inner tile dimensions become threads of a block, so a
+    // warp's worth of the innermost dimension is enough; insisting on 64
+    // would exclude most viable block shapes.
+    int min_inner_dim_size = gpu_schedule ? 32 : 64;
 
     Definition def = get_stage_definition(stg.func, stg.stage_num);
     const vector<Dim> &dims = def.schedule().dims();
@@ -1595,6 +1684,22 @@ vector<map<string, Expr>> Partitioner::generate_tile_configs(const FStage &stg)
         }
     }
 
+    if (gpu_schedule) {
+        // The tile dimensions become the threads of a block, so drop
+        // configurations with more threads than a block can hold.
+        vector<map<string, Expr>> valid_configs;
+        for (const auto &config : tile_configs) {
+            Expr num_threads = make_one(Int(64));
+            for (const auto &dim : config) {
+                num_threads *= dim.second;
+            }
+            if (can_prove(num_threads <= gpu_max_threads_per_block)) {
+                valid_configs.push_back(config);
+            }
+        }
+        tile_configs = valid_configs;
+    }
+
     return tile_configs;
 }
 
@@ -1916,6 +2021,26 @@ Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_
         }
     }
 
+    if (gpu_schedule) {
+        // Group members computed inside a tile will be allocated per thread
+        // block, i.e. in shared memory, so reject tilings whose intermediate
+        // allocations do not fit there.
+        Expr group_footprint = make_zero(Int(64));
+        for (const auto &reg : alloc_regions) {
+            if ((group_members.find(reg.first) != group_members.end()) &&
+                (reg.first != g.output.func.name())) {
+                Expr size = costs.region_size(reg.first, reg.second);
+                if (!size.defined()) {
+                    return GroupAnalysis();
+                }
+                group_footprint += size;
+            }
+        }
+        if (can_prove(simplify(group_footprint) > gpu_shared_mem_limit)) {
+            return GroupAnalysis();
+        }
+    }
+
     Cost group_cost(simplify(tile_cost.arith + out_cost.arith),
                     simplify(tile_cost.memory + out_cost.memory));
 
@@ -2664,6 +2789,134 @@ public :
     }
 };
 
+bool Partitioner::try_parallelize_reduction(const Group &g, Stage f_handle,
+                                            Definition def,
+                                            const map<string, Expr> &stg_estimates,
+                                            const Target &t, AutoSchedule &sched) {
+    Function g_out = g.output.func;
+    int stage_num = g.output.stage_num;
+    internal_assert(stage_num > 0);
+
+    // Factoring the update replaces its loop structure, so members computed
+    // at tiles of the update would be left without a compute level. Only
+    // factor when the group is just the reduction itself.
+    for (const FStage &mem : g.members) {
+        if ((mem.func.name() != g_out.name()) &&
+            (g.inlined.find(mem.func.name()) == g.inlined.end())) {
+            return false;
+        }
+    }
+
+    vector<Dim> &dims = def.schedule().dims();
+
+    // Find the serial rvar with the largest extent, and the parallelism
+    // available from the pure dimensions of the update.
+    Expr pure_par = make_one(Int(64));
+    string rvar_name;
+    Expr rvar_extent;
+    for (int d = 0; d < (int)dims.size() - 1; d++) {
+        string var = get_base_name(dims[d].var);
+        Expr estimate;
+        const auto &iter = stg_estimates.find(var);
+        if ((iter != stg_estimates.end()) && iter->second.defined()) {
+            estimate = iter->second;
+        }
+        if (dims[d].is_rvar()) {
+            if (can_parallelize_rvar(var, g_out.name(), def)) {
+                // The generic parallelization path already handles this rvar.
+                return false;
+            }
+            if (estimate.defined() &&
+                (!rvar_extent.defined() || can_prove(estimate > rvar_extent))) {
+                rvar_name = var;
+                rvar_extent = estimate;
+            }
+        } else if (estimate.defined()) {
+            pure_par = simplify(pure_par * estimate);
+        }
+    }
+
+    if (rvar_name.empty()) {
+        return false;
+    }
+
+    // If the pure dimensions already saturate the machine there is no need
+    // to factor the reduction.
+    if (!can_prove(pure_par < arch_params.parallelism)) {
+        return false;
+    }
+
+    // Each slice of the factored reduction must do enough work to amortize
+    // the cost of initializing and merging the partial results.
+    if (!can_prove(rvar_extent >= 2 * arch_params.parallelism)) {
+        return false;
+    }
+
+    // rfactor only applies to associative updates.
+    AssociativeOp assoc =
+        prove_associativity(g_out.name(), def.args(), def.values());
+    if (!assoc.associative()) {
+        return false;
+    }
+
+    // Split the rvar so that the outer piece matches the machine parallelism.
+    Expr factor =
+        simplify((rvar_extent + arch_params.parallelism - 1) / arch_params.parallelism);
+
+    VarOrRVar r_old(rvar_name, true);
+    VarOrRVar r_outer(rvar_name + "_fo", true);
+    VarOrRVar r_inner(rvar_name + "_fi", true);
+    Var par_var(rvar_name + "_p");
+
+    for (const VarOrRVar &v : {r_old, r_outer, r_inner, VarOrRVar(par_var)}) {
+        const auto &iter = sched.internal_vars.find(v.name());
+        if (iter == sched.internal_vars.end()) {
+            sched.internal_vars.emplace(v.name(), v);
+        } else {
+            internal_assert(iter->second.is_rvar == v.is_rvar);
+        }
+    }
+
+    f_handle.split(r_old, r_outer, r_inner, factor);
+    Func intm = f_handle.rfactor(r_outer.rvar, par_var);
+    intm.compute_root();
+    intm.update(0).parallel(par_var);
+
+    string fname = get_sanitized_name(g_out.name());
+    string intm_name = get_sanitized_name(intm.name());
+    string update_str = fname + ".update(" + std::to_string(stage_num - 1) + ")";
+    std::ostringstream split_ss;
+    split_ss << update_str << ".split(" << rvar_name << ", " << r_outer.name()
+             << ", " << r_inner.name() << ", " << factor << ");";
+    sched.push_stage_prologue(f_handle.name(), stage_num, split_ss.str());
+    sched.push_stage_prologue(f_handle.name(), stage_num,
+                              "Func " + intm_name + " = " + update_str +
+                              ".rfactor(" + r_outer.name() + ", " +
+                              par_var.name() + ");");
+    sched.push_stage_prologue(f_handle.name(), stage_num,
+                              intm_name + ".compute_root();");
+    sched.push_stage_prologue(f_handle.name(), stage_num,
+                              intm_name + ".update(0).parallel(" +
+                              par_var.name() + ");");
+
+    // The original update is now a cheap merge of the partial results over
+    // the outer rvar. Vectorize its pure dimensions if possible.
+    Definition new_def = get_stage_definition(g_out, stage_num);
+    set<string> new_rvars;
+    const vector<Dim> &new_dims = new_def.schedule().dims();
+    for (int d = 0; d < (int)new_dims.size() - 1; d++) {
+        if (new_dims[d].is_rvar()) {
+            new_rvars.insert(get_base_name(new_dims[d].var));
+        }
+    }
+    map<string, Expr> new_estimates = stg_estimates;
+    Stage new_handle = Func(g_out).update(stage_num - 1);
+    vectorize_stage(g, new_handle, stage_num, new_def, g_out, true, t,
+                    new_rvars, new_estimates, sched);
+
+    return true;
+}
+
 void Partitioner::generate_group_cpu_schedule(
         const Group &g, const Target &t,
         const map<FStage, DimBounds> &group_loop_bounds,
@@ -2701,6 +2954,16 @@ void Partitioner::generate_group_cpu_schedule(
         return;
     }
 
+    // If this is an update stage whose reduction loops cannot legally be
+    // parallelized and whose pure loops are too small to saturate the
+    // machine, try to recover parallelism by factoring the reduction. When
+    // the factoring succeeds the stage has been rescheduled from scratch,
+    // so the generic tiling path below must not run on top of it.
+    if ((g.output.stage_num > 0) &&
+        try_parallelize_reduction(g, f_handle, def, stg_estimates, t, sched)) {
+        return;
+    }
+
     // Realize tiling and update the dimension estimates
     vector<VarOrRVar> outer_dims;
     vector<VarOrRVar> inner_dims;
@@ -2921,7 +3184,288 @@ void Partitioner::generate_group_cpu_schedule(
     }
 }
 
-void Partitioner::generate_cpu_schedule(const Target &t, AutoSchedule &sched) {
+int Partitioner::mark_gpu_threads(Stage f_handle, int stage_num, Definition def,
+                                  int num_inner_dims, const set<string> &rvars,
+                                  const map<string, Expr> &estimates, AutoSchedule &sched) {
+    vector<Dim> &dims = def.schedule().dims();
+    int limit = std::min(num_inner_dims, (int)dims.size() - 1);
+
+    Expr num_threads = make_one(Int(64));
+    int num_marked = 0;
+    for (int d = 0; d < limit; d++) {
+        string var = get_base_name(dims[d].var);
+        if (rvars.find(var) != rvars.end()) {
+            // Keep rvars serial; even when can_parallelize_rvar holds, the
+            // partial results would have to be combined across threads. A
+            // serial loop inside the thread loops is legal, so keep walking.
+            continue;
+        }
+
+        const auto &iter = estimates.find(var);
+        if ((iter == estimates.end()) || !iter->second.defined()) {
+            break;
+        }
+        if (!can_prove(num_threads * iter->second <= gpu_max_threads_per_block)) {
+            break;
+        }
+
+        VarOrRVar v(var, false);
+        f_handle.gpu_threads(v);
+        sched.push_schedule(f_handle.name(), stage_num,
+                            "gpu_threads(" + var + ")", {var});
+        num_threads = simplify(num_threads * iter->second);
+        num_marked++;
+        if (num_marked == 3) {
+            // gpu_threads() maps at most three dimensions.
+            break;
+        }
+    }
+    return num_marked;
+}
+
+void Partitioner::generate_group_gpu_schedule(
+        const Group &g, const Target &t,
+        const map<FStage, DimBounds> &group_loop_bounds,
+        const map<string, Box> &group_storage_bounds,
+        const set<string> &inlines,
+        AutoSchedule &sched) {
+    string out_f_name = g.output.func.name();
+    Function g_out = g.output.func;
+
+    debug(3) << "\n================\n";
+    debug(3) << "Scheduling group on the GPU:\n";
+    debug(3) << "================\n";
+    debug(3) << g;
+
+    // Get the definition corresponding to the stage
+    Definition def = get_stage_definition(g_out, g.output.stage_num);
+
+    // Get the estimates for stage bounds
+    DimBounds stg_bounds = get_bounds(g.output);
+    map<string, Expr> stg_estimates = bounds_to_estimates(stg_bounds);
+
+    Stage f_handle = Stage(Func(g_out));
+
+    // Get a function handle for scheduling the stage
+    if (g.output.stage_num > 0) {
+        int stage_num = g.output.stage_num;
+        f_handle = Func(g_out).update(stage_num - 1);
+    } else {
+        Func(g_out).compute_root();
+        sched.push_schedule(f_handle.name(), g.output.stage_num, "compute_root()", {});
+    }
+
+    if (g.output.func.has_extern_definition()) {
+        internal_assert(g.members.size() == 1);
+        return;
+    }
+
+    // Realize tiling and update the dimension estimates. The tiling is the
+    // same as on the CPU; what differs is how the resulting loop structure is
+    // mapped onto the GPU grid below.
+    vector<VarOrRVar> outer_dims;
+    vector<VarOrRVar> inner_dims;
+
+    // 'dims' will get modified since we are going to apply the schedules
+    // (e.g. tiling, reordering, etc.)
+    vector<Dim> &dims = def.schedule().dims();
+
+    // Keep track of the rvars
+    set<string> rvars;
+    for (int d = 0; d < (int)dims.size() - 1; d++) {
+        if (dims[d].is_rvar()) {
+            rvars.insert(get_base_name(dims[d].var));
+        }
+    }
+
+    // Reorder the dimensions for better spatial locality (i.e. smallest stride
+    // is innermost); on the GPU this is what makes global memory accesses of
+    // adjacent threads coalesce. If we only have one dimension (excluding
+    // __outermost), there is nothing to reorder.
+    if (dims.size() > 2) {
+        map<string, Expr> strides =
+            analyze_spatial_locality(g.output, group_storage_bounds, inlines);
+        if (!strides.empty()) {
+            reorder_dims(f_handle, g.output.stage_num, def, strides, sched);
+        }
+    }
+
+    vector<string> dim_vars(dims.size() - 1);
+    for (int d = 0; d < (int)dims.size() - 1; d++) {
+        dim_vars[d] = get_base_name(dims[d].var);
+    }
+
+    // Apply tiling to output of the group
+    for (const auto &var : dim_vars) {
+        bool is_rvar = (rvars.find(var) != rvars.end());
+        VarOrRVar v(var, is_rvar);
+
+        const auto &iter = g.tile_sizes.find(var);
+        if ((iter != g.tile_sizes.end()) &&
+            get_element(stg_estimates, var).defined() &&
+            can_prove(get_element(stg_estimates, var) > iter->second)) {
+            const Expr &tile_size = iter->second;
+            if (can_prove(tile_size == 1)) {
+                outer_dims.push_back(v);
+            } else {
+                pair<VarOrRVar, VarOrRVar> tile_vars =
+                    split_dim(g, f_handle, g.output.stage_num, def, true, v,
+                              tile_size, "_i", "_o", stg_estimates, sched);
+
+                inner_dims.push_back(tile_vars.first);
+                outer_dims.push_back(tile_vars.second);
+
+                if (is_rvar) {
+                    rvars.erase(var);
+                    rvars.insert(tile_vars.first.name());
+                    rvars.insert(tile_vars.second.name());
+                }
+            }
+        } else {
+            inner_dims.push_back(v);
+        }
+    }
+
+    // Reorder the tile dimensions
+    if (!outer_dims.empty()) {
+
+        vector<VarOrRVar> ordering;
+        for (const auto &v : inner_dims) {
+            ordering.push_back(v);
+        }
+        for (const auto &v : outer_dims) {
+            ordering.push_back(v);
+        }
+
+        set<string> var_list;
+        string var_order = ordering[0].name();
+        for (size_t o = 1; o < ordering.size(); o++) {
+            var_order += ", " + ordering[o].name();
+            var_list.insert(ordering[o].name());
+        }
+
+        if (dims != ordering) {
+            f_handle.reorder(ordering);
+            sched.push_schedule(f_handle.name(), g.output.stage_num,
+                                "reorder(" + var_order + ")", var_list);
+        }
+    }
+
+    // Map the tile structure onto the GPU grid: the dimensions created by the
+    // tile splits become the threads of a block, and the outer tile
+    // dimensions become the blocks. generate_tile_configs() has already
+    // restricted the tile sizes so the threads fit in a block, and
+    // analyze_group() has rejected groupings whose intermediate allocations
+    // do not fit in shared memory.
+    int num_inner = (int)dims.size() - (int)outer_dims.size() - 1;
+    if (!outer_dims.empty()) {
+        mark_gpu_threads(f_handle, g.output.stage_num, def, num_inner, rvars,
+                         stg_estimates, sched);
+
+        int num_blocks = 0;
+        for (int d = num_inner; d < (int)dims.size() - 1; d++) {
+            string var = get_base_name(dims[d].var);
+            if (rvars.find(var) != rvars.end()) {
+                // A serial rvar loop inside the block loops is legal; any
+                // block dimensions marked further out will still enclose the
+                // thread loops.
+                continue;
+            }
+            VarOrRVar v(var, false);
+            f_handle.gpu_blocks(v);
+            sched.push_schedule(f_handle.name(), g.output.stage_num,
+                                "gpu_blocks(" + var + ")", {var});
+            num_blocks++;
+            if (num_blocks == 3) {
+                // gpu_blocks() maps at most three dimensions; anything
+                // beyond that remains a serial loop on the host.
+                break;
+            }
+        }
+    } else {
+        user_warning << "Degenerate tiling. No dimensions are tiled" << '\n';
+        user_warning << "Not mapping \"" << f_handle.name() << "\" to the GPU grid" << '\n';
+    }
+
+    // Find the level at which group members will be computed.
+    int tile_inner_index = dims.size() - outer_dims.size() - 1;
+    VarOrRVar tile_inner_var("", false);
+    if (!outer_dims.empty()) {
+        string var_name = get_base_name(dims[tile_inner_index].var);
+        bool is_rvar = (rvars.find(var_name) != rvars.end());
+        tile_inner_var = VarOrRVar(var_name, is_rvar);
+    }
+
+    for (const FStage &mem : g.members) {
+        // Skip member stages that have been inlined or stage that is the
+        // output stage of the group
+        if ((g.inlined.find(mem.func.name()) != g.inlined.end()) ||
+            (mem.func.name() == g_out.name())) {
+            continue;
+        }
+
+        // Get the definition corresponding to the stage
+        Definition mem_def = get_stage_definition(mem.func, mem.stage_num);
+
+        // Get the estimates for the dimensions of the member stage
+        map<string, Expr> mem_estimates =
+            bounds_to_estimates(get_element(group_loop_bounds, mem));
+
+        set<string> mem_rvars;
+        vector<Dim> &mem_dims = mem_def.schedule().dims();
+        for (int d = 0; d < (int)mem_dims.size() - 1; d++) {
+            if (mem_dims[d].is_rvar()) {
+                mem_rvars.insert(get_base_name(mem_dims[d].var));
+            }
+        }
+
+        // Get a function handle for scheduling the stage
+        Stage mem_handle = Stage(Func(mem.func));
+
+        if (mem.stage_num > 0) {
+            mem_handle = Func(mem.func).update(mem.stage_num - 1);
+        } else {
+            if (!outer_dims.empty()) {
+                // Computing the member at the innermost block dimension
+                // places its allocation in shared memory.
+                if (tile_inner_var.is_rvar) {
+                    Func(mem.func).compute_at(Func(g_out), tile_inner_var.rvar);
+                } else {
+                    Func(mem.func).compute_at(Func(g_out), tile_inner_var.var);
+                }
+                string sanitized_g_out = get_sanitized_name(g_out.name());
+                sched.push_schedule(mem_handle.name(), mem.stage_num,
+                                    "compute_at(" + sanitized_g_out + ", " + tile_inner_var.name() + ")",
+                                    {sanitized_g_out, tile_inner_var.name()});
+            } else {
+                user_warning << "Degenerate tiling. No dimensions are tiled" << '\n';
+                user_warning << "Computing \"" <<  mem.func.name() << "\" at root" << '\n';
+                Func(mem.func).compute_root();
+                sched.push_schedule(mem_handle.name(), mem.stage_num, "compute_root()", {});
+            }
+        }
+
+        // Reorder the dimensions for better spatial locality. If we only have
+        // one dimension (excluding __outermost), there is nothing to reorder.
+        if (dims.size() > 2) {
+            map<string, Expr> mem_strides =
+                analyze_spatial_locality(mem, group_storage_bounds, inlines);
+            if (!mem_strides.empty()) {
+                reorder_dims(mem_handle, mem.stage_num, mem_def, mem_strides, sched);
+            }
+        }
+
+        // The member is produced once per tile, cooperatively by the threads
+        // of the block.
+        if (!outer_dims.empty()) {
+            mark_gpu_threads(mem_handle, mem.stage_num, mem_def,
+                             (int)mem_dims.size() - 1, mem_rvars, mem_estimates,
+                             sched);
+        }
+    }
+}
+
+void Partitioner::generate_schedule(const Target &t, AutoSchedule &sched) {
     // Grab the group bounds early as they rely on the dimensions of the group
     // outputs which will be altered by modifying schedules.
     map<FStage, map<FStage, DimBounds>> loop_bounds = group_loop_bounds();
@@ -2945,8 +3489,13 @@ void Partitioner::generate_cpu_schedule(const Target &t, AutoSchedule &sched) {
 
     // Realize schedule for each group in the pipeline.
     for (const auto &g : groups) {
-        generate_group_cpu_schedule(g.second, t, get_element(loop_bounds, g.first),
-                                    get_element(storage_bounds, g.first), inlines, sched);
+        if (gpu_schedule) {
+            generate_group_gpu_schedule(g.second, t, get_element(loop_bounds, g.first),
+                                        get_element(storage_bounds, g.first), inlines, sched);
+        } else {
+            generate_group_cpu_schedule(g.second, t, get_element(loop_bounds, g.first),
+                                        get_element(storage_bounds, g.first), inlines, sched);
+        }
     }
 }
 
@@ -3430,7 +3979,8 @@ string generate_schedules(const vector<Function> &outputs, const Target &target,
     set<string> unbounded = get_unbounded_functions(pipeline_bounds, env);
 
     debug(2) << "Initializing partitioner...\n";
-    Partitioner part(pipeline_bounds, arch_params, dep_analysis, costs, outputs, unbounded);
+    Partitioner part(pipeline_bounds, arch_params, dep_analysis, costs, outputs, unbounded,
+                     target.has_gpu_feature());
 
     // Compute and display reuse
     /* TODO: Use the reuse estimates to reorder loops
@@ -3479,8 +4029,8 @@ string generate_schedules(const vector<Function> &outputs, const Target &target,
 
     debug(2) << "Initializing AutoSchedule...\n";
     AutoSchedule sched(env, full_order);
-    debug(2) << "Generating CPU schedule...\n";
-    part.generate_cpu_schedule(target, sched);
+    debug(2) << "Generating schedule...\n";
+    part.generate_schedule(target, sched);
 
     std::ostringstream oss;
     oss << "// Target: " << target.to_string() << "\n";
@@ -3493,7 +4043,8 @@ string generate_schedules(const vector<Function> &outputs, const Target &target,
              << "*******************************\n" << sched_string << "\n\n";
 
     // TODO: Unify both inlining and grouping for fast mem
-    // TODO: GPU scheduling
+    // TODO: Model occupancy rather than assuming one resident block per SM
+    // when generating GPU schedules
     // TODO: Hierarchical tiling
 
     return sched_string;
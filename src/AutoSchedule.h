@@ -12,7 +12,9 @@
 namespace Halide {
 
 /** A struct representing the machine parameters to generate the auto-scheduled
- * code for. */
+ * code for. The defaults describe a generic desktop CPU;
+ * tools/halide_machine_params.cpp micro-benchmarks the host and prints
+ * measured values in the canonical string form accepted below. */
 struct MachineParams {
     /** Maximum level of parallelism avalaible. */
     Expr parallelism;
@@ -41,7 +43,11 @@ namespace Internal {
  * have specializations or schedules as the current auto-scheduler does not take
  * into account user-defined schedules or specializations. This applies the
  * schedules and returns a string representation of the schedules. The target
- * architecture is specified by 'target'. */
+ * architecture is specified by 'target'. When 'target' has a GPU feature
+ * enabled, the tile structure is mapped onto the GPU grid instead of being
+ * parallelized and vectorized: outer tile dimensions become gpu_blocks(),
+ * inner ones become gpu_threads(), and the grouping is constrained so that
+ * the intermediates of a group fit in shared memory. */
 EXPORT std::string generate_schedules(const std::vector<Function> &outputs,
                                       const Target &target,
                                       const MachineParams &arch_params);
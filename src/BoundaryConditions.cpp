@@ -62,15 +62,19 @@ Func constant_exterior(const Func &source, Tuple value,
         }
     }
 
+    // Tag the in-bounds arm itself, not just the clamped coordinates
+    // within it, so the select as a whole reads as interior-likely to
+    // loop partitioning and to the passes that branch around or prune
+    // boundary handling.
     Func bounded("constant_exterior");
     if (value.as_vector().size() > 1) {
         std::vector<Expr> def;
         for (size_t i = 0; i < value.as_vector().size(); i++) {
-            def.push_back(select(out_of_bounds, value[i], repeat_edge(source, bounds)(args)[i]));
+            def.push_back(select(out_of_bounds, value[i], likely(repeat_edge(source, bounds)(args)[i])));
         }
         bounded(args) = Tuple(def);
     } else {
-        bounded(args) = select(out_of_bounds, value[0], repeat_edge(source, bounds)(args));
+        bounded(args) = select(out_of_bounds, value[0], likely(repeat_edge(source, bounds)(args)));
     }
 
     return bounded;
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <mutex>
 
 #include "Bounds.h"
 #include "IRVisitor.h"
@@ -68,11 +69,53 @@ public:
     bool const_bound;
 
     Bounds(const Scope<Interval> *s, const FuncValueBounds &fb, bool const_bound) :
-        func_bounds(fb), const_bound(const_bound) {
+        func_bounds(fb), const_bound(const_bound),
+        initial_const_bound(const_bound) {
         scope.set_containing_scope(s);
     }
 private:
 
+    // Intervals of subexpressions already visited during this
+    // walk. An IRVisitor recurses into expressions as trees, so a
+    // subexpression reachable along several paths (common when many
+    // definitions share work, e.g. the values of a wide Tuple after
+    // tuple-splitting) would otherwise be visited once per path,
+    // which is exponential in the worst case. Keyed on the Expr
+    // rather than the raw node pointer so that the node stays alive
+    // and the pointer stays unique.
+    struct ExprPtrCompare {
+        bool operator()(const Expr &a, const Expr &b) const {
+            return a.get() < b.get();
+        }
+    };
+    map<Expr, Interval, ExprPtrCompare> memo;
+
+    // Memoized results are only valid in the scope the walk started
+    // in, and for the const_bound mode it started in. Both change
+    // temporarily mid-walk (Let bodies, Ramp lanes, narrowing casts),
+    // during which the memo must be neither consulted nor updated.
+    int inner_bindings{0};
+    const bool initial_const_bound;
+
+    // Compute the bounds of a subexpression into 'interval', reusing
+    // the result if this node has already been visited along another
+    // path.
+    void bounds_of(const Expr &e) {
+        bool can_memoize = (inner_bindings == 0 &&
+                            const_bound == initial_const_bound);
+        if (can_memoize) {
+            auto it = memo.find(e);
+            if (it != memo.end()) {
+                interval = it->second;
+                return;
+            }
+        }
+        e.accept(this);
+        if (can_memoize) {
+            memo.emplace(e, interval);
+        }
+    }
+
     // Compute the intrinsic bounds of a function.
     void bounds_of_func(string name, int value_index, Type t) {
         // if we can't get a good bound from the function, fall back to the bounds of the type.
@@ -116,7 +159,7 @@ private:
     }
 
     void visit(const Cast *op) {
-        op->value.accept(this);
+        bounds_of(op->value);
         Interval a = interval;
 
         if (a.is_single_point(op->value)) {
@@ -229,9 +272,9 @@ private:
     }
 
     void visit(const Add *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Interval a = interval;
-        op->b.accept(this);
+        bounds_of(op->b);
         Interval b = interval;
 
         if (a.is_single_point(op->a) && b.is_single_point(op->b)) {
@@ -249,15 +292,23 @@ private:
 
             // Assume no overflow for float, int32, and int64
             if (!op->type.is_float() && (!op->type.is_int() || op->type.bits() < 32)) {
+                // Check in 64-bit arithmetic, in which none of the
+                // types this applies to except uint64 can wrap.
+                // Checking in int32 would be unsound once uint32
+                // values pass the int32 range.
+                if (!Int(64).can_represent(op->type.element_of())) {
+                    bounds_of_type(op->type);
+                    return;
+                }
                 if (interval.has_upper_bound()) {
-                    Expr no_overflow = (cast<int>(a.max) + cast<int>(b.max) == cast<int>(interval.max));
+                    Expr no_overflow = (cast<int64_t>(a.max) + cast<int64_t>(b.max) == cast<int64_t>(interval.max));
                     if (!can_prove(no_overflow)) {
                         bounds_of_type(op->type);
                         return;
                     }
                 }
                 if (interval.has_lower_bound()) {
-                    Expr no_overflow = (cast<int>(a.min) + cast<int>(b.min) == cast<int>(interval.min));
+                    Expr no_overflow = (cast<int64_t>(a.min) + cast<int64_t>(b.min) == cast<int64_t>(interval.min));
                     if (!can_prove(no_overflow)) {
                         bounds_of_type(op->type);
                         return;
@@ -268,9 +319,9 @@ private:
     }
 
     void visit(const Sub *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Interval a = interval;
-        op->b.accept(this);
+        bounds_of(op->b);
         Interval b = interval;
 
         if (a.is_single_point(op->a) && b.is_single_point(op->b)) {
@@ -288,15 +339,20 @@ private:
 
             // Assume no overflow for float, int32, and int64
             if (!op->type.is_float() && (!op->type.is_int() || op->type.bits() < 32)) {
+                // As in visit(Add), check in 64-bit arithmetic.
+                if (!Int(64).can_represent(op->type.element_of())) {
+                    bounds_of_type(op->type);
+                    return;
+                }
                 if (interval.has_upper_bound()) {
-                    Expr no_overflow = (cast<int>(a.max) - cast<int>(b.min) == cast<int>(interval.max));
+                    Expr no_overflow = (cast<int64_t>(a.max) - cast<int64_t>(b.min) == cast<int64_t>(interval.max));
                     if (!can_prove(no_overflow)) {
                         bounds_of_type(op->type);
                         return;
                     }
                 }
                 if (interval.has_lower_bound()) {
-                    Expr no_overflow = (cast<int>(a.min) - cast<int>(b.max) == cast<int>(interval.min));
+                    Expr no_overflow = (cast<int64_t>(a.min) - cast<int64_t>(b.max) == cast<int64_t>(interval.min));
                     if (!can_prove(no_overflow)) {
                         bounds_of_type(op->type);
                         return;
@@ -314,10 +370,10 @@ private:
     }
 
     void visit(const Mul *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Interval a = interval;
 
-        op->b.accept(this);
+        bounds_of(op->b);
         Interval b = interval;
 
         // Move constants to the right
@@ -363,12 +419,15 @@ private:
 
         // Assume no overflow for float, int32, and int64
         if (!op->type.is_float() && (!op->type.is_int() || op->type.bits() < 32)) {
-            if (a.is_bounded() && b.is_bounded()) {
-                // Try to prove it can't overflow
-                Expr test1 = (cast<int>(a.min) * cast<int>(b.min) == cast<int>(a.min * b.min));
-                Expr test2 = (cast<int>(a.min) * cast<int>(b.max) == cast<int>(a.min * b.max));
-                Expr test3 = (cast<int>(a.max) * cast<int>(b.min) == cast<int>(a.max * b.min));
-                Expr test4 = (cast<int>(a.max) * cast<int>(b.max) == cast<int>(a.max * b.max));
+            if (a.is_bounded() && b.is_bounded() &&
+                Int(64).can_represent(op->type.element_of())) {
+                // Try to prove it can't overflow. As in visit(Add),
+                // check in 64-bit arithmetic, in which products of
+                // these types can't wrap.
+                Expr test1 = (cast<int64_t>(a.min) * cast<int64_t>(b.min) == cast<int64_t>(a.min * b.min));
+                Expr test2 = (cast<int64_t>(a.min) * cast<int64_t>(b.max) == cast<int64_t>(a.min * b.max));
+                Expr test3 = (cast<int64_t>(a.max) * cast<int64_t>(b.min) == cast<int64_t>(a.max * b.min));
+                Expr test4 = (cast<int64_t>(a.max) * cast<int64_t>(b.max) == cast<int64_t>(a.max * b.max));
                 if (!can_prove(test1 && test2 && test3 && test4)) {
                     bounds_of_type(op->type);
                 }
@@ -379,10 +438,10 @@ private:
     }
 
     void visit(const Div *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Interval a = interval;
 
-        op->b.accept(this);
+        bounds_of(op->b);
         Interval b = interval;
 
         if (!b.is_bounded()) {
@@ -432,10 +491,10 @@ private:
     }
 
     void visit(const Mod *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Interval a = interval;
 
-        op->b.accept(this);
+        bounds_of(op->b);
         if (!interval.is_bounded()) {
             // Uses interval produced by op->b which might be half bound.
             return;
@@ -472,10 +531,10 @@ private:
     }
 
     void visit(const Min *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Interval a = interval;
 
-        op->b.accept(this);
+        bounds_of(op->b);
         Interval b = interval;
 
         if (a.is_single_point(op->a) && b.is_single_point(op->b)) {
@@ -488,10 +547,10 @@ private:
 
 
     void visit(const Max *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Interval a = interval;
 
-        op->b.accept(this);
+        bounds_of(op->b);
         Interval b = interval;
 
         if (a.is_single_point(op->a) && b.is_single_point(op->b)) {
@@ -504,14 +563,14 @@ private:
 
     template<typename T1, typename T2>
     void visit_compare(const Expr &a_expr, const Expr &b_expr) {
-        a_expr.accept(this);
+        bounds_of(a_expr);
         if (!interval.is_bounded()) {
             bounds_of_type(Bool());
             return;
         }
         Interval a = interval;
 
-        b_expr.accept(this);
+        bounds_of(b_expr);
         if (!interval.is_bounded()) {
             bounds_of_type(Bool());
             return;
@@ -566,21 +625,21 @@ private:
     }
 
     void visit(const Select *op) {
-        op->true_value.accept(this);
+        bounds_of(op->true_value);
         if (!interval.is_bounded()) {
             // Uses interval produced by op->true_value which might be half bound.
             return;
         }
         Interval a = interval;
 
-        op->false_value.accept(this);
+        bounds_of(op->false_value);
         if (!interval.is_bounded()) {
             // Uses interval produced by op->false_value which might be half bound.
             return;
         }
         Interval b = interval;
 
-        op->condition.accept(this);
+        bounds_of(op->condition);
         Interval cond = interval;
 
         if (cond.is_single_point()) {
@@ -615,7 +674,7 @@ private:
     }
 
     void visit(const Load *op) {
-        op->index.accept(this);
+        bounds_of(op->index);
         if (!const_bound && interval.is_single_point() && is_one(op->predicate)) {
             // If the index is const and it is not a predicated load,
             // we can return the load of that index
@@ -636,11 +695,12 @@ private:
         Expr lane = op->base + var * op->stride;
         ScopedBinding<Interval> p(scope, var_name, Interval(make_const(var.type(), 0),
                                                         make_const(var.type(), op->lanes-1)));
+        ScopedValue<int> b(inner_bindings, inner_bindings + 1);
         lane.accept(this);
     }
 
     void visit(const Broadcast *op) {
-        op->value.accept(this);
+        bounds_of(op->value);
     }
 
     void visit(const Call *op) {
@@ -652,7 +712,7 @@ private:
         std::vector<Expr> new_args(op->args.size());
         bool const_args = true;
         for (size_t i = 0; i < op->args.size() && const_args; i++) {
-            op->args[i].accept(this);
+            bounds_of(op->args[i]);
             if (interval.is_single_point()) {
                 new_args[i] = interval.min;
             } else {
@@ -693,10 +753,10 @@ private:
         } else if (op->is_intrinsic(Call::likely) ||
                    op->is_intrinsic(Call::likely_if_innermost)) {
             assert(op->args.size() == 1);
-            op->args[0].accept(this);
+            bounds_of(op->args[0]);
         } else if (op->is_intrinsic(Call::return_second)) {
             assert(op->args.size() == 2);
-            op->args[1].accept(this);
+            bounds_of(op->args[1]);
         } else if (op->is_intrinsic(Call::if_then_else)) {
             assert(op->args.size() == 3);
             // Probably more conservative than necessary
@@ -704,7 +764,7 @@ private:
             equivalent_select.accept(this);
         } else if (op->is_intrinsic(Call::require)) {
             assert(op->args.size() == 3);
-            op->args[1].accept(this);
+            bounds_of(op->args[1]);
         } else if (op->is_intrinsic(Call::shift_left) ||
                    op->is_intrinsic(Call::shift_right) ||
                    op->is_intrinsic(Call::bitwise_and)) {
@@ -743,7 +803,7 @@ private:
                                 Call::make(Int(32), Call::buffer_get_max, op->args, Call::Extern));
         } else if (op->is_intrinsic(Call::memoize_expr)) {
             internal_assert(op->args.size() >= 1);
-            op->args[0].accept(this);
+            bounds_of(op->args[0]);
         } else if (op->call_type == Call::Halide) {
             bounds_of_func(op->name, op->value_index, op->type);
         } else {
@@ -753,7 +813,7 @@ private:
     }
 
     void visit(const Let *op) {
-        op->value.accept(this);
+        bounds_of(op->value);
         Interval val = interval;
 
         // We'll either substitute the values in directly, or pass
@@ -785,6 +845,7 @@ private:
 
         {
             ScopedBinding<Interval> p(scope, op->name, var);
+            ScopedValue<int> b(inner_bindings, inner_bindings + 1);
             op->body.accept(this);
         }
 
@@ -810,7 +871,7 @@ private:
     void visit(const Shuffle *op) {
         Interval result = Interval::nothing();
         for (Expr i : op->vectors) {
-            i.accept(this);
+            bounds_of(i);
             result.include(interval);
         }
         interval = result;
@@ -853,8 +914,50 @@ private:
     }
 };
 
+namespace {
+
+// Bounds queries issued during lowering are heavily repeated: bounds
+// inference asks for the bounds of the same exprs in the same scopes
+// over and over. Cache results in a small direct-mapped structure,
+// keyed on the expression and the identity of the scope's state (its
+// address plus the scope mutation counter; see Scope.h). The cache is
+// lossy: a colliding entry is simply overwritten.
+struct BoundsCacheEntry {
+    Expr expr;
+    const void *scope;
+    const void *fb;
+    size_t fb_size;
+    uint64_t scope_epoch;
+    bool const_bound;
+    Interval result;
+};
+
+const int bounds_cache_bits = 12;
+BoundsCacheEntry bounds_cache[1 << bounds_cache_bits];
+std::mutex bounds_cache_mutex;
+
+}  // namespace
+
 Interval bounds_of_expr_in_scope(Expr expr, const Scope<Interval> &scope, const FuncValueBounds &fb, bool const_bound) {
     //debug(3) << "computing bounds_of_expr_in_scope " << expr << "\n";
+    uint64_t h = structural_hash(expr);
+    h ^= (uint64_t)(uintptr_t)&scope * 0x9e3779b97f4a7c15ULL;
+    h ^= (uint64_t)(uintptr_t)&fb * 0x100000001b3ULL;
+    h ^= (uint64_t)const_bound;
+    BoundsCacheEntry *entry = &bounds_cache[h & ((1 << bounds_cache_bits) - 1)];
+    {
+        std::lock_guard<std::mutex> lock(bounds_cache_mutex);
+        if (entry->expr.defined() &&
+            entry->scope == &scope &&
+            entry->fb == &fb &&
+            entry->fb_size == fb.size() &&
+            entry->scope_epoch == scope_mutation_counter().load(std::memory_order_relaxed) &&
+            entry->const_bound == const_bound &&
+            (entry->expr.same_as(expr) || equal(entry->expr, expr))) {
+            return entry->result;
+        }
+    }
+
     Bounds b(&scope, fb, const_bound);
     expr.accept(&b);
     //debug(3) << "bounds_of_expr_in_scope " << expr << " = " << simplify(b.interval.min) << ", " << simplify(b.interval.max) << "\n";
@@ -868,6 +971,21 @@ Interval bounds_of_expr_in_scope(Expr expr, const Scope<Interval> &scope, const
             << "Max of " << expr
             << " should have been a scalar: " << b.interval.max << "\n";
     }
+
+    {
+        // Record the scope epoch after computing: any push/pop pairs
+        // done while visiting restored the scope to its query-time
+        // state, so the current counter value still identifies it.
+        std::lock_guard<std::mutex> lock(bounds_cache_mutex);
+        entry->expr = expr;
+        entry->scope = &scope;
+        entry->fb = &fb;
+        entry->fb_size = fb.size();
+        entry->scope_epoch = scope_mutation_counter().load(std::memory_order_relaxed);
+        entry->const_bound = const_bound;
+        entry->result = b.interval;
+    }
+
     return b.interval;
 }
 
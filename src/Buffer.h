@@ -286,6 +286,15 @@ public:
         return contents.defined();
     }
 
+    /** Check if this Buffer holds the only reference to its
+     * contents. Used by RealizationPool to tell whether a buffer
+     * handed out by a previous realization is still held by the
+     * caller. */
+    bool unique() const {
+        return contents.defined() &&
+               Internal::ref_count(contents.get()).is_unique();
+    }
+
     /** Get a pointer to the underlying Runtime::Buffer */
     // @{
     Runtime::Buffer<T> *get() {
@@ -340,6 +349,7 @@ public:
     HALIDE_BUFFER_FORWARD_CONST(data)
     HALIDE_BUFFER_FORWARD_CONST(contains)
     HALIDE_BUFFER_FORWARD(crop)
+    HALIDE_BUFFER_FORWARD_CONST(cropped)
     HALIDE_BUFFER_FORWARD(slice)
     HALIDE_BUFFER_FORWARD_CONST(sliced)
     HALIDE_BUFFER_FORWARD(embed)
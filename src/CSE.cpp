@@ -1,4 +1,5 @@
 #include <map>
+#include <unordered_map>
 
 #include "CSE.h"
 #include "IRMutator.h"
@@ -84,7 +85,20 @@ public:
     };
     vector<Entry> entries;
 
-    typedef map<ExprWithCompareCache, int> CacheType;
+    // The numbering hashes on the cached structural hash of each
+    // node, so candidate entries are found in constant time and the
+    // deep equality check only runs on hash matches.
+    struct ExprStructuralHash {
+        size_t operator()(const Expr &e) const {
+            return (size_t)structural_hash(e);
+        }
+    };
+    struct ExprStructuralEq {
+        bool operator()(const Expr &a, const Expr &b) const {
+            return equal(a, b);
+        }
+    };
+    typedef std::unordered_map<Expr, int, ExprStructuralHash, ExprStructuralEq> CacheType;
     CacheType numbering;
 
     map<Expr, int, ExprCompare> shallow_numbering;
@@ -92,19 +106,13 @@ public:
     Scope<int> let_substitutions;
     int number;
 
-    IRCompareCache cache;
-
-    GVN() : number(0), cache(8) {}
+    GVN() : number(0) {}
 
     Stmt mutate(const Stmt &s) override {
         internal_error << "Can't call GVN on a Stmt: " << s << "\n";
         return Stmt();
     }
 
-    ExprWithCompareCache with_cache(Expr e) {
-        return ExprWithCompareCache(e, &cache);
-    }
-
     Expr mutate(const Expr &e) override {
         // Early out if we've already seen this exact Expr.
         {
@@ -126,7 +134,7 @@ public:
         }
 
         // If e already has an entry, return that.
-        CacheType::iterator iter = numbering.find(with_cache(e));
+        CacheType::iterator iter = numbering.find(e);
         if (iter != numbering.end()) {
             number = iter->second;
             shallow_numbering[e] = number;
@@ -140,7 +148,7 @@ public:
 
         // See if it's there in another form after being rebuilt
         // (e.g. because it was a let variable).
-        iter = numbering.find(with_cache(new_e));
+        iter = numbering.find(new_e);
         if (iter != numbering.end()) {
             number = iter->second;
             shallow_numbering[old_e] = number;
@@ -151,7 +159,7 @@ public:
         // Add it to the numbering.
         Entry entry = {new_e, 0};
         number = (int)entries.size();
-        numbering[with_cache(new_e)] = number;
+        numbering[new_e] = number;
         shallow_numbering[new_e] = number;
         entries.push_back(entry);
         internal_assert(new_e.type() == old_e.type());
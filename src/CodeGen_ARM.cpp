@@ -226,6 +226,10 @@ CodeGen_ARM::CodeGen_ARM(Target target) : CodeGen_Posix(target) {
     negations.push_back(Pattern("vqneg.v16i8", "sqneg.v16i8", 16, -max(wild_i8x_, -127)));
     negations.push_back(Pattern("vqneg.v8i16", "sqneg.v8i16", 8,  -max(wild_i16x_, -32767)));
     negations.push_back(Pattern("vqneg.v4i32", "sqneg.v4i32", 4,  -max(wild_i32x_, -(0x7fffffff))));
+
+    for (size_t i = 0; i < casts.size(); i++) {
+        casts_index.add(casts[i].pattern);
+    }
 }
 
 Value *CodeGen_ARM::call_pattern(const Pattern &p, Type t, const vector<Expr> &args) {
@@ -254,9 +258,9 @@ void CodeGen_ARM::visit(const Cast *op) {
 
     vector<Expr> matches;
 
-    for (size_t i = 0; i < casts.size() ; i++) {
-        const Pattern &pattern = casts[i];
-        //debug(4) << "Trying pattern: " << patterns[i].intrin << " " << patterns[i].pattern << "\n";
+    for (int candidate : casts_index.candidates(op)) {
+        const Pattern &pattern = casts[candidate];
+        //debug(4) << "Trying pattern: " << pattern.intrin32 << " " << pattern.pattern << "\n";
         if (expr_match(pattern.pattern, op, matches)) {
 
             //debug(4) << "Match!\n";
@@ -405,6 +409,24 @@ void CodeGen_ARM::visit(const Mul *op) {
     CodeGen_Posix::visit(op);
 }
 
+bool CodeGen_ARM::supports_resampling_intrinsic(const Call *op) const {
+    if (neon_intrinsics_disabled()) {
+        return false;
+    }
+    Type arg_t = op->args[0].type();
+    if (!arg_t.is_vector() || arg_t.bits() > 32) {
+        return false;
+    }
+    if (op->is_intrinsic(Call::rounding_shift_right)) {
+        // vrshr exists, but there is no table pattern for it and llvm
+        // only sometimes recognizes the widened form.
+        return false;
+    }
+    // widening_add/widening_mul select vaddl/vmull, and
+    // rounding_halving_add matches the vrhadd patterns above.
+    return true;
+}
+
 Expr CodeGen_ARM::sorted_avg(Expr a, Expr b) {
     Type ty = a.type();
     Type wide_ty = ty.with_bits(ty.bits() * 2);
@@ -427,7 +449,100 @@ void CodeGen_ARM::visit(const Div *op) {
     CodeGen_Posix::visit(op);
 }
 
+namespace {
+
+// Collect the multiply terms of a sum whose operands losslessly cast
+// to the given narrow type. Terms that don't match are gathered into
+// rest.
+void find_dot_product_terms(const Expr &e, Type ty, vector<pair<Expr, Expr>> &mpys, Expr &rest) {
+    if (const Add *add = e.as<Add>()) {
+        find_dot_product_terms(add->a, ty, mpys, rest);
+        find_dot_product_terms(add->b, ty, mpys, rest);
+        return;
+    }
+    if (const Mul *mul = e.as<Mul>()) {
+        Expr a = lossless_cast(ty, mul->a);
+        Expr b = lossless_cast(ty, mul->b);
+        if (a.defined() && b.defined()) {
+            mpys.push_back({a, b});
+            return;
+        }
+    }
+    rest = rest.defined() ? Add::make(rest, e) : e;
+}
+
+// Interleave the given vectors into one dense vector, but only if the
+// interleave disappears: either the simplifier collapses it (slices
+// of a common vector), or the operands are loads of adjacent strided
+// ramps that combine into a single dense load. Returns an undefined
+// Expr otherwise.
+Expr collapse_interleave(const vector<Expr> &e) {
+    int terms = (int)e.size();
+    const Load *l0 = e[0].as<Load>();
+    const Ramp *r0 = l0 ? l0->index.as<Ramp>() : nullptr;
+    if (r0 && is_const(r0->stride, terms) && is_one(l0->predicate)) {
+        bool can_collapse = true;
+        for (int i = 1; i < terms && can_collapse; i++) {
+            const Load *li = e[i].as<Load>();
+            const Ramp *ri = li ? li->index.as<Ramp>() : nullptr;
+            can_collapse = ri &&
+                           li->name == l0->name &&
+                           li->type == l0->type &&
+                           is_const(ri->stride, terms) &&
+                           is_one(li->predicate) &&
+                           is_zero(simplify(ri->base - r0->base - i));
+        }
+        if (can_collapse) {
+            int lanes = l0->type.lanes() * terms;
+            return Load::make(l0->type.with_lanes(lanes), l0->name,
+                              Ramp::make(r0->base, 1, lanes),
+                              l0->image, l0->param, const_true(lanes));
+        }
+    }
+    Expr interleaved = simplify(Shuffle::make_interleave(e));
+    if (!interleaved.as<Shuffle>()) {
+        return interleaved;
+    }
+    return Expr();
+}
+
+}  // namespace
+
 void CodeGen_ARM::visit(const Add *op) {
+#if LLVM_VERSION >= 60
+    // Matching a 4-way widening dot-product reduction against the
+    // v8.2 dot product instructions. The structure is the same as the
+    // vrmpy matching in HexagonOptimize.cpp: gather the 8-bit
+    // multiply terms of the sum, and use sdot/udot if the operands
+    // interleave into dense vectors.
+    if (!neon_intrinsics_disabled() &&
+        target.bits == 64 &&
+        target.has_feature(Target::ARMDotProd) &&
+        op->type.is_vector() &&
+        op->type.bits() == 32 &&
+        op->type.lanes() % 4 == 0) {
+        int lanes = op->type.lanes();
+        vector<pair<Expr, Expr>> mpys;
+        Expr rest;
+        const char *intrin = "llvm.aarch64.neon.sdot.v4i32.v16i8";
+        find_dot_product_terms(op, Int(8, lanes), mpys, rest);
+        if (mpys.size() != 4) {
+            mpys.clear();
+            rest = Expr();
+            intrin = "llvm.aarch64.neon.udot.v4i32.v16i8";
+            find_dot_product_terms(op, UInt(8, lanes), mpys, rest);
+        }
+        if (mpys.size() == 4) {
+            Expr a = collapse_interleave({mpys[0].first, mpys[1].first, mpys[2].first, mpys[3].first});
+            Expr b = collapse_interleave({mpys[0].second, mpys[1].second, mpys[2].second, mpys[3].second});
+            if (a.defined() && b.defined()) {
+                Expr acc = rest.defined() ? rest : make_zero(op->type);
+                value = call_intrin(op->type, 4, intrin, {acc, a, b});
+                return;
+            }
+        }
+    }
+#endif
     CodeGen_Posix::visit(op);
 }
 
@@ -981,11 +1096,23 @@ string CodeGen_ARM::mattrs() const {
             return "-neon";
         }
     } else {
+        string attrs;
+        if (target.has_feature(Target::SVE_256)) {
+            attrs = "+sve";
+        }
+        if (target.has_feature(Target::ARMDotProd)) {
+            if (!attrs.empty()) attrs += ",";
+            attrs += "+dotprod";
+        }
+        if (target.has_feature(Target::ARMFp16)) {
+            if (!attrs.empty()) attrs += ",";
+            attrs += "+fullfp16";
+        }
         if (target.os == Target::IOS || target.os == Target::OSX) {
-            return "+reserve-x18";
-        } else {
-            return "";
+            if (!attrs.empty()) attrs += ",";
+            attrs += "+reserve-x18";
         }
+        return attrs;
     }
 }
 
@@ -999,6 +1126,9 @@ bool CodeGen_ARM::use_soft_float_abi() const {
 }
 
 int CodeGen_ARM::native_vector_bits() const {
+    if (target.bits == 64 && target.has_feature(Target::SVE_256)) {
+        return 256;
+    }
     return 128;
 }
 
@@ -6,6 +6,7 @@
  */
 
 #include "CodeGen_Posix.h"
+#include "IRMatch.h"
 
 namespace Halide {
 namespace Internal {
@@ -20,6 +21,8 @@ protected:
 
     Expr sorted_avg(Expr a, Expr b);
 
+    bool supports_resampling_intrinsic(const Call *op) const;
+
     using CodeGen_Posix::visit;
 
     /** Nodes for which we want to emit specific neon intrinsics */
@@ -56,6 +59,12 @@ protected:
     };
     std::vector<Pattern> casts, left_shifts, averagings, negations;
 
+    /** The casts table is large enough that trying every entry on
+     * every Cast node is measurable, so it is indexed by root shape.
+     * The other tables are a handful of entries each and are already
+     * gated by the node type of the visit method that consults them. */
+    PatternIndex casts_index;
+
     // Call an intrinsic as defined by a pattern. Dispatches to the
     // 32- or 64-bit name depending on the target's bit width.
     // @{
@@ -69,7 +78,7 @@ protected:
     int native_vector_bits() const;
 
     // NEON can be disabled for older processors.
-    bool neon_intrinsics_disabled() {
+    bool neon_intrinsics_disabled() const {
         return target.has_feature(Target::NoNEON);
     }
 };
@@ -316,6 +316,15 @@ string type_to_c_type(Type type, bool include_space, bool c_plus_plus = true) {
         if (type.is_vector()) {
             oss << type.lanes();
         }
+    } else if (type.is_bfloat()) {
+        // bfloat values are opaque 16-bit payloads by the time they
+        // reach codegen; all math on them has been lowered to float32
+        // (see EmulateFloat16Math.h).
+        if (type.is_vector()) {
+            oss << "uint" << type.bits() << "x" << type.lanes() << "_t";
+        } else {
+            oss << "uint" << type.bits() << "_t";
+        }
     } else if (type.is_handle()) {
         needs_space = false;
 
@@ -1957,6 +1966,12 @@ void CodeGen_C::visit(const Call *op) {
         Type t = op->type.with_code(op->type.is_int() ? Type::UInt : op->type.code());
         Expr e = cast(t, select(a < b, b - a, a - b));
         rhs << print_expr(e);
+    } else if (op->is_intrinsic(Call::widening_add) ||
+               op->is_intrinsic(Call::widening_mul) ||
+               op->is_intrinsic(Call::rounding_halving_add) ||
+               op->is_intrinsic(Call::rounding_shift_right)) {
+        internal_assert(op->args.size() == 2);
+        rhs << print_expr(lower_resampling_intrinsic(op));
     } else if (op->is_intrinsic(Call::return_second)) {
         internal_assert(op->args.size() == 2);
         string arg0 = print_expr(op->args[0]);
@@ -2448,7 +2463,14 @@ void CodeGen_C::visit(const Allocate *op) {
                            << op->name << " is constant but exceeds 2^31 - 1.\n";
             } else {
                 size_id = print_expr(Expr(static_cast<int32_t>(constant_size)));
-                if (can_allocation_fit_on_stack(stack_bytes)) {
+                if (op->memory_type == MemoryType::Stack) {
+                    user_assert(stack_bytes <= stack_allocation_budget(target))
+                        << "Allocation " << op->name << " is scheduled with store_in(MemoryType::Stack), "
+                        << "but requires " << stack_bytes << " bytes, which exceeds the stack budget of "
+                        << stack_allocation_budget(target) << " bytes for this target.\n";
+                    on_stack = true;
+                } else if (op->memory_type != MemoryType::Heap &&
+                           can_allocation_fit_on_stack(stack_bytes, target)) {
                     on_stack = true;
                 }
             }
@@ -2457,6 +2479,10 @@ void CodeGen_C::visit(const Allocate *op) {
             // it would have constant size).
             internal_assert(op->extents.size() > 0);
 
+            user_assert(op->memory_type != MemoryType::Stack)
+                << "Allocation " << op->name << " is scheduled with store_in(MemoryType::Stack), "
+                << "but its size is not constant at compile time.\n";
+
             size_id = print_assignment(Int(64), print_expr(op->extents[0]));
 
             for (size_t i = 1; i < op->extents.size(); i++) {
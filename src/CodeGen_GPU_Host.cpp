@@ -427,6 +427,15 @@ void CodeGen_GPU_Host<CodeGen_CPU>::visit(const For *loop) {
 
         std::string api_unique_name = gpu_codegen->api_unique_name();
 
+        // A private slot for this launch site in which the runtime
+        // can cache the resolved kernel handle and anything else it
+        // needs to re-issue this kernel cheaply. Starts out null.
+        PointerType *void_ptr_type = llvm::Type::getInt8PtrTy(*context);
+        GlobalVariable *run_state = new GlobalVariable(*module, void_ptr_type,
+                                                       false, GlobalVariable::InternalLinkage,
+                                                       ConstantPointerNull::get(void_ptr_type),
+                                                       kernel_name + "_run_state");
+
         // TODO: only three dimensions can be passed to
         // cuLaunchKernel. How should we handle blkid[3]?
         internal_assert(is_one(bounds.num_threads[3]) && is_one(bounds.num_blocks[3]))
@@ -467,6 +476,7 @@ void CodeGen_GPU_Host<CodeGen_CPU>::visit(const For *loop) {
             gpu_vertex_buffer,
             gpu_num_coords_dim0,
             gpu_num_coords_dim1,
+            run_state,
         };
         std::string run_fn_name = "halide_" + api_unique_name + "_run";
         llvm::Function *dev_run_fn = module->getFunction(run_fn_name);
@@ -1,3 +1,4 @@
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <mutex>
@@ -178,6 +179,36 @@ Stmt sloppy_unpredicate_loads(Stmt s) {
     return SloppyUnpredicateLoads().mutate(s);
 }
 
+// The resampling intrinsics are matched by the patterns in
+// HexagonOptimize, which runs on the Stmt, so expand them to the
+// canonical arithmetic before then rather than at codegen time like
+// the other backends.
+class ExpandResamplingIntrinsics : public IRMutator2 {
+    std::function<bool(const Call *)> supported;
+    const Target &target;
+
+    Expr visit(const Call *op) override {
+        if (op->is_intrinsic(Call::widening_add) ||
+            op->is_intrinsic(Call::widening_mul) ||
+            op->is_intrinsic(Call::rounding_halving_add) ||
+            op->is_intrinsic(Call::rounding_shift_right)) {
+            if (op->type.is_vector() && !supported(op)) {
+                user_warning << "Vectorized " << op->name << " at type "
+                             << op->args[0].type() << " has no native instruction on target "
+                             << target.to_string() << " and will use generic arithmetic.\n";
+            }
+            return mutate(lower_resampling_intrinsic(op));
+        }
+        return IRMutator2::visit(op);
+    }
+
+    using IRMutator2::visit;
+
+public:
+    ExpandResamplingIntrinsics(std::function<bool(const Call *)> supported, const Target &target)
+        : supported(std::move(supported)), target(target) {}
+};
+
 }// namespace
 
 void CodeGen_Hexagon::compile_func(const LoweredFunc &f,
@@ -226,6 +257,10 @@ void CodeGen_Hexagon::compile_func(const LoweredFunc &f,
     body = eliminate_bool_vectors(body);
     debug(2) << "Lowering after eliminating boolean vectors: " << body << "\n\n";
 
+    body = ExpandResamplingIntrinsics(
+        [this](const Call *op) { return supports_resampling_intrinsic(op); },
+        target).mutate(body);
+
     // Optimize the IR for Hexagon.
     debug(1) << "Optimizing Hexagon instructions...\n";
     body = optimize_hexagon_instructions(body, target);
@@ -400,15 +435,20 @@ void CodeGen_Hexagon::init_module() {
         { IPICK(is_128B, Intrinsic::hexagon_V6_vavguh), u16v1, "avg.vuh.vuh", {u16v1, u16v1} },
         { IPICK(is_128B, Intrinsic::hexagon_V6_vavgh),  i16v1, "avg.vh.vh",   {i16v1, i16v1} },
         { IPICK(is_128B, Intrinsic::hexagon_V6_vavgw),  i32v1, "avg.vw.vw",   {i32v1, i32v1} },
+        { IPICK(is_128B, Intrinsic::hexagon_V6_vavgb),  i8v1,  "avg.vb.vb",   {i8v1,  i8v1} },     // v62 or later
+        { IPICK(is_128B, Intrinsic::hexagon_V6_vavguw), u32v1, "avg.vuw.vuw", {u32v1, u32v1} },    // v62 or later
 
         { IPICK(is_128B, Intrinsic::hexagon_V6_vavgubrnd), u8v1,  "avg_rnd.vub.vub", {u8v1,  u8v1} },
         { IPICK(is_128B, Intrinsic::hexagon_V6_vavguhrnd), u16v1, "avg_rnd.vuh.vuh", {u16v1, u16v1} },
         { IPICK(is_128B, Intrinsic::hexagon_V6_vavghrnd),  i16v1, "avg_rnd.vh.vh",   {i16v1, i16v1} },
         { IPICK(is_128B, Intrinsic::hexagon_V6_vavgwrnd),  i32v1, "avg_rnd.vw.vw",   {i32v1, i32v1} },
+        { IPICK(is_128B, Intrinsic::hexagon_V6_vavgbrnd),  i8v1,  "avg_rnd.vb.vb",   {i8v1,  i8v1} },   // v62 or later
+        { IPICK(is_128B, Intrinsic::hexagon_V6_vavguwrnd), u32v1, "avg_rnd.vuw.vuw", {u32v1, u32v1} },  // v62 or later
 
         { IPICK(is_128B, Intrinsic::hexagon_V6_vnavgub), i8v1,  "navg.vub.vub", {u8v1,  u8v1} },
         { IPICK(is_128B, Intrinsic::hexagon_V6_vnavgh),  i16v1, "navg.vh.vh",   {i16v1, i16v1} },
         { IPICK(is_128B, Intrinsic::hexagon_V6_vnavgw),  i32v1, "navg.vw.vw",   {i32v1, i32v1} },
+        { IPICK(is_128B, Intrinsic::hexagon_V6_vnavgb),  i8v1,  "navg.vb.vb",   {i8v1,  i8v1} },    // v62 or later
 
         // Non-widening multiplication:
         { IPICK(is_128B, Intrinsic::hexagon_V6_vmpyih),  i16v1, "mul.vh.vh",   {i16v1, i16v1} },
@@ -1616,6 +1656,25 @@ Expr CodeGen_Hexagon::mulhi_shr(Expr a, Expr b, int shr) {
     }
 }
 
+bool CodeGen_Hexagon::supports_resampling_intrinsic(const Call *op) const {
+    Type arg_t = op->args[0].type();
+    if (!arg_t.is_vector()) {
+        return false;
+    }
+    if (op->is_intrinsic(Call::rounding_halving_add)) {
+        // vavg..rnd covers these; there is no unsigned 32-bit or
+        // signed 8-bit variant before v62.
+        return (arg_t.is_uint() && (arg_t.bits() == 8 || arg_t.bits() == 16)) ||
+               (arg_t.is_int() && (arg_t.bits() == 16 || arg_t.bits() == 32));
+    }
+    if (op->is_intrinsic(Call::widening_add) ||
+        op->is_intrinsic(Call::widening_mul)) {
+        // The widening vadd/vmpy patterns in HexagonOptimize.
+        return arg_t.bits() <= 16;
+    }
+    return false;
+}
+
 Expr CodeGen_Hexagon::sorted_avg(Expr a, Expr b) {
     Type ty = a.type();
     if (ty.is_vector() && ((ty.is_uint() && (ty.bits() == 8 || ty.bits() == 16)) ||
@@ -27,6 +27,8 @@ protected:
     Expr mulhi_shr(Expr a, Expr b, int shr);
     Expr sorted_avg(Expr a, Expr b);
 
+    bool supports_resampling_intrinsic(const Call *op) const;
+
     std::string mcpu() const;
     std::string mattrs() const;
     bool use_soft_float_abi() const;
@@ -157,6 +157,7 @@ bool function_takes_user_context(const std::string &name) {
         "halide_free",
         "halide_malloc",
         "halide_print",
+        "halide_release_allocation_prefix",
         "halide_profiler_memory_allocate",
         "halide_profiler_memory_free",
         "halide_profiler_pipeline_start",
@@ -167,6 +168,8 @@ bool function_takes_user_context(const std::string &name) {
         "halide_start_clock",
         "halide_trace",
         "halide_trace_helper",
+        "halide_readback_slice",
+        "halide_readback_fence",
         "halide_memoization_cache_lookup",
         "halide_memoization_cache_store",
         "halide_memoization_cache_release",
@@ -218,6 +221,19 @@ bool can_allocation_fit_on_stack(int64_t size) {
     return (size <= 1024 * 16);
 }
 
+bool can_allocation_fit_on_stack(int64_t size, const Target &target) {
+    user_assert(size > 0) << "Allocation size should be a positive number\n";
+    return size <= stack_allocation_budget(target);
+}
+
+int64_t stack_allocation_budget(const Target &target) {
+    // Threads on embedded OSes run with much smaller stacks.
+    if (target.os == Target::QuRT || target.os == Target::NoOS) {
+        return 1024 * 8;
+    }
+    return 1024 * 16;
+}
+
 Expr lower_euclidean_div(Expr a, Expr b) {
     internal_assert(a.type() == b.type());
     // IROperator's div_round_to_zero will replace this with a / b for
@@ -54,6 +54,12 @@ bool function_takes_user_context(const std::string &name);
  * on the stack; otherwise, return False. This routine asserts if size is
  * non-positive. */
 bool can_allocation_fit_on_stack(int64_t size);
+bool can_allocation_fit_on_stack(int64_t size, const Target &target);
+
+/** The maximum size in bytes of a single allocation the given target
+ * can reasonably place on the stack. Allocations explicitly scheduled
+ * with store_in(MemoryType::Stack) must fit within this budget. */
+int64_t stack_allocation_budget(const Target &target);
 
 /** Given a Halide Euclidean division/mod operation, define it in terms of
  * div_round_to_zero or mod_round_to_zero. */
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <limits>
+#include <set>
 #include <sstream>
 #include <mutex>
 
@@ -410,11 +411,43 @@ void CodeGen_LLVM::init_module() {
 }
 
 void CodeGen_LLVM::add_external_code(const Module &halide_module) {
+    // Record which functions are already defined, so that we can tell
+    // which definitions arrive with the external code below.
+    std::set<std::string> existing_definitions;
+    for (const llvm::Function &f : *module) {
+        if (!f.isDeclaration()) {
+            existing_definitions.insert(f.getName().str());
+        }
+    }
+
+    bool linked_any = false;
     for (const ExternalCode &code_blob : halide_module.external_code()) {
         if (code_blob.is_for_cpu_target(get_target())) {
             add_bitcode_to_module(context, *module, code_blob.contents(), code_blob.name());
+            linked_any = true;
         }
     }
+
+    if (!linked_any) {
+        return;
+    }
+
+    // The external code is linked in before we generate and optimize
+    // the pipeline, so calls into it are ordinary in-module calls
+    // that the inliner can collapse into the loops. Bitcode built
+    // without optimization arrives marked optnone/noinline, which
+    // blocks that entirely, so clear those attributes and hint that
+    // these helpers are worth inlining. We leave the linkage alone;
+    // the symbols may still be wanted in the final object.
+    for (llvm::Function &f : *module) {
+        if (f.isDeclaration() ||
+            existing_definitions.count(f.getName().str())) {
+            continue;
+        }
+        f.removeFnAttr(llvm::Attribute::OptimizeNone);
+        f.removeFnAttr(llvm::Attribute::NoInline);
+        f.addFnAttr(llvm::Attribute::InlineHint);
+    }
 }
 
 CodeGen_LLVM::~CodeGen_LLVM() {
@@ -437,6 +470,7 @@ struct MangledNames {
     string extern_name;
     string argv_name;
     string metadata_name;
+    string warmup_name;
 };
 
 MangledNames get_mangled_names(const std::string &name,
@@ -450,6 +484,7 @@ MangledNames get_mangled_names(const std::string &name,
     names.extern_name = names.simple_name;
     names.argv_name = names.simple_name + "_argv";
     names.metadata_name = names.simple_name + "_metadata";
+    names.warmup_name = names.simple_name + "_warmup";
 
     if (linkage != LoweredFunc::Internal &&
         ((mangling == NameMangling::Default &&
@@ -470,6 +505,10 @@ MangledNames get_mangled_names(const std::string &name,
         Type void_star_star(Handle(1, &inner_type));
         names.argv_name = cplusplus_function_mangled_name(names.argv_name, namespaces, type_of<int>(), { ExternFuncArgument(make_zero(void_star_star)) }, target);
         names.metadata_name = cplusplus_function_mangled_name(names.metadata_name, namespaces, type_of<const struct halide_filter_metadata_t *>(), {}, target);
+        names.warmup_name = cplusplus_function_mangled_name(names.warmup_name, namespaces, type_of<int>(),
+                                                            { ExternFuncArgument(make_zero(Handle())),
+                                                              ExternFuncArgument(make_zero(Handle())),
+                                                              ExternFuncArgument(make_zero(UInt(64))) }, target);
     }
     return names;
 }
@@ -526,17 +565,47 @@ std::unique_ptr<llvm::Module> CodeGen_LLVM::compile(const Module &input) {
     for (const auto &b : input.buffers()) {
         compile_buffer(b);
     }
+
+    // Run the function-level optimization passes on each function
+    // right after it is emitted rather than leaving everything to
+    // optimize_module(). Freshly-generated IR is full of redundant
+    // address math, and shrinking each function before the next one
+    // is generated keeps peak memory closer to the largest single
+    // function than to the sum of all of them.
+    std::unique_ptr<TargetMachine> streaming_tm = make_target_machine(*module);
+    legacy::FunctionPassManager streaming_function_passes(module.get());
+    {
+        streaming_function_passes.add(createTargetTransformInfoWrapperPass(
+            streaming_tm ? streaming_tm->getTargetIRAnalysis() : TargetIRAnalysis()));
+        PassManagerBuilder b;
+        b.OptLevel = 3;
+        b.LoopVectorize = true;
+        b.SLPVectorize = true;
+#if LLVM_VERSION >= 50
+        if (streaming_tm) {
+            streaming_tm->adjustPassManager(b);
+        }
+#endif
+        b.populateFunctionPassManager(streaming_function_passes);
+    }
+    streaming_function_passes.doInitialization();
+
     for (const auto &f : input.functions()) {
         const auto names = get_mangled_names(f, get_target());
 
         compile_func(f, names.simple_name, names.extern_name);
 
+        // The function member still points at the llvm::Function that
+        // compile_func just finalized.
+        streaming_function_passes.run(*function);
+
         // If the Func is externally visible, also create the argv wrapper and metadata.
         // (useful for calling from JIT and other machine interfaces).
         if (f.linkage == LoweredFunc::ExternalPlusMetadata) {
             llvm::Function *wrapper = add_argv_wrapper(names.argv_name);
             llvm::Function *metadata_getter = embed_metadata_getter(names.metadata_name,
                 names.simple_name, f.args, input.get_metadata_name_map());
+            add_warmup_shim(names.warmup_name);
 
             if (target.has_feature(Target::Matlab)) {
                 define_matlab_wrapper(module.get(), wrapper, metadata_getter);
@@ -544,6 +613,8 @@ std::unique_ptr<llvm::Module> CodeGen_LLVM::compile(const Module &input) {
         }
     }
 
+    streaming_function_passes.doFinalization();
+
     debug(2) << module.get() << "\n";
 
     // Verify the module is ok
@@ -668,6 +739,8 @@ void CodeGen_LLVM::compile_func(const LoweredFunc &f, const std::string &simple_
     // Generate the function declaration and argument unpacking code.
     begin_func(f.linkage, simple_name, extern_name, f.args);
 
+    non_temporal_buffers = f.non_temporal_buffers;
+
     // If building with MSAN, ensure that calls to halide_msan_annotate_buffer_is_initialized()
     // happen for every output buffer if the function succeeds.
     if (f.linkage != LoweredFunc::Internal &&
@@ -693,6 +766,7 @@ void CodeGen_LLVM::compile_func(const LoweredFunc &f, const std::string &simple_
     f.body.accept(this);
 
     // Clean up and return.
+    non_temporal_buffers.clear();
     end_func(f.args);
 }
 
@@ -907,6 +981,38 @@ llvm::Function *CodeGen_LLVM::add_argv_wrapper(const std::string &name) {
     return wrapper;
 }
 
+// Make a companion warmup entry point that hands the filter's entry
+// point and a caller-provided scratch arena to halide_pipeline_warmup,
+// so cold-start costs can be paid before the first real call.
+llvm::Function *CodeGen_LLVM::add_warmup_shim(const std::string &name) {
+    llvm::Type *args_t[] = {i8_t->getPointerTo(), i8_t->getPointerTo(), i64_t};
+    llvm::FunctionType *shim_t = llvm::FunctionType::get(i32_t, args_t, false);
+    llvm::Function *shim = llvm::Function::Create(shim_t, llvm::GlobalValue::ExternalLinkage, name, module.get());
+    llvm::BasicBlock *block = llvm::BasicBlock::Create(module->getContext(), "entry", shim);
+    builder->SetInsertPoint(block);
+
+    llvm::Function *warmup_fn = module->getFunction("halide_pipeline_warmup");
+    if (!warmup_fn) {
+        // The no-runtime initial modules don't contain it; emit a declaration.
+        llvm::Type *warmup_args_t[] = {i8_t->getPointerTo(), i8_t->getPointerTo(), i8_t->getPointerTo(), i64_t};
+        llvm::FunctionType *warmup_t = llvm::FunctionType::get(i32_t, warmup_args_t, false);
+        warmup_fn = llvm::Function::Create(warmup_t, llvm::GlobalValue::ExternalLinkage,
+                                           "halide_pipeline_warmup", module.get());
+    }
+
+    llvm::Function::arg_iterator arg = shim->arg_begin();
+    llvm::Value *user_context = iterator_to_pointer(arg++);
+    llvm::Value *arena = iterator_to_pointer(arg++);
+    llvm::Value *arena_size = iterator_to_pointer(arg);
+    llvm::Value *entry_point = builder->CreatePointerCast(function, i8_t->getPointerTo());
+
+    llvm::Value *warmup_call_args[] = {user_context, entry_point, arena, arena_size};
+    llvm::Value *result = builder->CreateCall(warmup_fn, warmup_call_args);
+    builder->CreateRet(result);
+    internal_assert(!verifyFunction(*shim, &llvm::errs()));
+    return shim;
+}
+
 llvm::Function *CodeGen_LLVM::embed_metadata_getter(const std::string &metadata_name,
         const std::string &function_name, const std::vector<LoweredArgument> &args,
         const std::map<std::string, std::string> &metadata_name_map) {
@@ -1633,6 +1739,26 @@ void CodeGen_LLVM::add_tbaa_metadata(llvm::Instruction *inst, string buffer, Exp
     inst->setMetadata("tbaa", tbaa);
 }
 
+bool CodeGen_LLVM::buffer_is_non_temporal(const std::string &buffer) {
+    if (non_temporal_buffers.empty()) {
+        return false;
+    }
+    if (non_temporal_buffers.count(buffer)) {
+        return true;
+    }
+    // Stores to one element of a Tuple-valued Func use the Func's
+    // name with the value index appended.
+    size_t dot = buffer.rfind('.');
+    return (dot != std::string::npos &&
+            non_temporal_buffers.count(buffer.substr(0, dot)));
+}
+
+void CodeGen_LLVM::add_non_temporal_metadata(llvm::StoreInst *store) {
+    MDNode *md = MDNode::get(*context,
+                             ConstantAsMetadata::get(ConstantInt::get(i32_t, 1)));
+    store->setMetadata(LLVMContext::MD_nontemporal, md);
+}
+
 void CodeGen_LLVM::visit(const Load *op) {
     // If it's a Handle, load it as a uint64_t and then cast
     if (op->type.is_handle()) {
@@ -1709,6 +1835,48 @@ void CodeGen_LLVM::visit(const Load *op) {
             }
 
             value = shuffle_vectors(vec_a, vec_b, indices);
+        } else if (ramp && stride && stride->value > 2 && stride->value <= 4) {
+            // Interleaved access with a small stride (e.g. RGB channels of
+            // an interleaved image). Load a dense vector covering each
+            // slice of the footprint and shuffle out the lanes we want.
+            // LLVM turns the loads-plus-shuffle into ldN on targets that
+            // have it and into shuffle sequences elsewhere, either of
+            // which beats the scalar gather below. Slices that would
+            // start past the last element the ramp touches are shifted
+            // backwards so that we never read beyond it; for wide
+            // vectors only the final slice shifts, but for narrow
+            // vectors (lanes < stride - 1) earlier slices must too.
+            int s = (int)stride->value;
+            int max_offset = (s - 1) * (ramp->lanes - 1);
+            vector<int> offsets(s);
+            vector<Value *> slices;
+            for (int k = 0; k < s; k++) {
+                offsets[k] = std::min(k * ramp->lanes, max_offset);
+                Expr slice_base = simplify(ramp->base + offsets[k]);
+                Expr slice_index = Ramp::make(slice_base,
+                                              make_one(slice_base.type()),
+                                              ramp->lanes);
+                Expr slice = Load::make(op->type, op->name, slice_index,
+                                        op->image, op->param, op->predicate);
+                slices.push_back(codegen(slice));
+            }
+
+            // Pick each result lane out of the concatenated slices. The
+            // slice offsets start at zero, step by at most the lane
+            // count, and the last ends at the footprint's last element,
+            // so every element the ramp touches is covered by some
+            // slice.
+            vector<int> indices(ramp->lanes);
+            for (int j = 0; j < ramp->lanes; j++) {
+                int o = j * s;
+                for (int k = 0; k < s; k++) {
+                    if (offsets[k] <= o && o < offsets[k] + ramp->lanes) {
+                        indices[j] = k * ramp->lanes + (o - offsets[k]);
+                        break;
+                    }
+                }
+            }
+            value = shuffle_vectors(concat_vectors(slices), indices);
         } else if (ramp && stride && stride->value == -1) {
             // Load the vector and then flip it in-place
             Expr flipped_base = ramp->base - ramp->lanes + 1;
@@ -1901,28 +2069,9 @@ void CodeGen_LLVM::codegen_predicated_vector_store(const Store *op) {
         Value *vpred = codegen(op->predicate);
         Halide::Type value_type = op->value.type();
         Value *val = codegen(op->value);
-        bool is_external = (external_buffer.find(op->name) != external_buffer.end());
-        int alignment = value_type.bytes();
-        int native_bits = native_vector_bits();
-        int native_bytes = native_bits / 8;
-
-        // Boost the alignment if possible, up to the native vector width.
-        ModulusRemainder mod_rem = modulus_remainder(ramp->base, alignment_info);
-        while ((mod_rem.remainder & 1) == 0 &&
-               (mod_rem.modulus & 1) == 0 &&
-               alignment < native_bytes) {
-            mod_rem.modulus /= 2;
-            mod_rem.remainder /= 2;
-            alignment *= 2;
-        }
+        int alignment = dense_vector_alignment(value_type, op->name, ramp->base, op->param);
 
-        // If it is an external buffer, then we cannot assume that the host pointer
-        // is aligned to at least the native vector width. However, we may be able to do
-        // better than just assuming that it is unaligned.
-        if (is_external && op->param.defined()) {
-            int host_alignment = op->param.host_alignment();
-            alignment = gcd(alignment, host_alignment);
-        }
+        int native_bits = native_vector_bits();
 
         // For dense vector stores wider than the native vector
         // width, bust them up into native vectors.
@@ -1981,35 +2130,9 @@ Value *CodeGen_LLVM::codegen_dense_vector_load(const Load *load, Value *vpred) {
     const Ramp *ramp = load->index.as<Ramp>();
     internal_assert(ramp && is_one(ramp->stride)) << "Should be dense vector load\n";
 
-    bool is_external = (external_buffer.find(load->name) != external_buffer.end());
-    int alignment = load->type.bytes(); // The size of a single element
+    int alignment = dense_vector_alignment(load->type, load->name, ramp->base, load->param);
 
     int native_bits = native_vector_bits();
-    int native_bytes = native_bits / 8;
-
-    // We assume halide_malloc for the platform returns
-    // buffers aligned to at least the native vector
-    // width. (i.e. 16-byte alignment on arm, and 32-byte
-    // alignment on x86), so this is the maximum alignment we
-    // can infer based on the index alone.
-
-    // Boost the alignment if possible, up to the native vector width.
-    ModulusRemainder mod_rem = modulus_remainder(ramp->base, alignment_info);
-    while ((mod_rem.remainder & 1) == 0 &&
-           (mod_rem.modulus & 1) == 0 &&
-           alignment < native_bytes) {
-        mod_rem.modulus /= 2;
-        mod_rem.remainder /= 2;
-        alignment *= 2;
-    }
-
-    // If it is an external buffer, then we cannot assume that the host pointer
-    // is aligned to at least native vector width. However, we may be able to do
-    // better than just assuming that it is unaligned.
-    if (is_external && load->param.defined()) {
-        int host_alignment = load->param.host_alignment();
-        alignment = gcd(alignment, host_alignment);
-    }
 
     // For dense vector loads wider than the native vector
     // width, bust them up into native vectors
@@ -2217,6 +2340,20 @@ void CodeGen_LLVM::visit(const Call *op) {
                               Let::make(b_name, op->args[1],
                                         Select::make(a_var < b_var, b_var - a_var, a_var - b_var))));
         }
+    } else if (op->is_intrinsic(Call::widening_add) ||
+               op->is_intrinsic(Call::widening_mul) ||
+               op->is_intrinsic(Call::rounding_halving_add) ||
+               op->is_intrinsic(Call::rounding_shift_right)) {
+        internal_assert(op->args.size() == 2);
+        if (op->type.is_vector() && !supports_resampling_intrinsic(op)) {
+            user_warning << "Vectorized " << op->name << " at type "
+                         << op->args[0].type() << " has no native instruction on target "
+                         << target.to_string() << " and will use generic arithmetic.\n";
+        }
+        // Expand to the canonical arithmetic here, at the last
+        // moment, so the backend peephole patterns that match it see
+        // it exactly as constructed.
+        codegen(lower_resampling_intrinsic(op));
     } else if (op->is_intrinsic("div_round_to_zero")) {
         internal_assert(op->args.size() == 2);
         Value *a = codegen(op->args[0]);
@@ -2649,6 +2786,43 @@ void CodeGen_LLVM::visit(const Call *op) {
 
         value = builder->CreateCall(prefetch_fn, args);
 
+    } else if (op->is_intrinsic(Call::atomic_rmw)) {
+        internal_assert(op->args.size() == 3);
+        const StringImm *rmw_op = op->args[0].as<StringImm>();
+        const Load *load = op->args[1].as<Load>();
+        internal_assert(rmw_op && load) << "Malformed atomic_rmw intrinsic\n";
+        internal_assert(op->type.is_scalar() &&
+                        (op->type.is_int() || op->type.is_uint()))
+            << "atomic_rmw of unsupported type " << op->type << "\n";
+
+        // The load argument just carries the address; the atomic
+        // instruction does the read itself.
+        Value *ptr = codegen_buffer_pointer(load->name, op->type, load->index);
+        Value *val = codegen(op->args[2]);
+
+        AtomicRMWInst::BinOp binop = AtomicRMWInst::Add;
+        if (rmw_op->value == "add") {
+            binop = AtomicRMWInst::Add;
+        } else if (rmw_op->value == "sub") {
+            binop = AtomicRMWInst::Sub;
+        } else if (rmw_op->value == "min") {
+            binop = op->type.is_int() ? AtomicRMWInst::Min : AtomicRMWInst::UMin;
+        } else if (rmw_op->value == "max") {
+            binop = op->type.is_int() ? AtomicRMWInst::Max : AtomicRMWInst::UMax;
+        } else if (rmw_op->value == "and") {
+            binop = AtomicRMWInst::And;
+        } else if (rmw_op->value == "or") {
+            binop = AtomicRMWInst::Or;
+        } else if (rmw_op->value == "xor") {
+            binop = AtomicRMWInst::Xor;
+        } else {
+            internal_error << "Unknown atomic_rmw op " << rmw_op->value << "\n";
+        }
+
+        // The update is a reduction, so no ordering is required
+        // beyond the atomicity of the operation itself.
+        value = builder->CreateAtomicRMW(binop, ptr, val,
+                                         llvm::AtomicOrdering::Monotonic);
     } else if (op->is_intrinsic(Call::signed_integer_overflow)) {
         user_error << "Signed integer overflow occurred during constant-folding. Signed"
             " integer overflow for int32 and int64 is undefined behavior in"
@@ -2828,31 +3002,54 @@ void CodeGen_LLVM::visit(const Prefetch *op) {
 }
 
 void CodeGen_LLVM::visit(const Let *op) {
-    sym_push(op->name, codegen(op->value));
-    if (op->value.type() == Int(32)) {
-        alignment_info.push(op->name, modulus_remainder(op->value, alignment_info));
+    // Let chains (e.g. from CSE) can be tens of thousands of nodes
+    // deep in large pipelines. Walk the spine iteratively with flat
+    // scope bookkeeping instead of recursing once per let, which
+    // would otherwise dominate stack depth during codegen.
+    vector<const Let *> lets;
+    Expr body = op;
+    while (const Let *let = body.as<Let>()) {
+        sym_push(let->name, codegen(let->value));
+        if (let->value.type() == Int(32)) {
+            alignment_info.push(let->name, modulus_remainder(let->value, alignment_info));
+        }
+        lets.push_back(let);
+        body = let->body;
     }
-    value = codegen(op->body);
-    if (op->value.type() == Int(32)) {
-        alignment_info.pop(op->name);
+
+    value = codegen(body);
+
+    for (size_t i = lets.size(); i > 0; i--) {
+        const Let *let = lets[i - 1];
+        if (let->value.type() == Int(32)) {
+            alignment_info.pop(let->name);
+        }
+        sym_pop(let->name);
     }
-    sym_pop(op->name);
 }
 
 void CodeGen_LLVM::visit(const LetStmt *op) {
-    sym_push(op->name, codegen(op->value));
-
-    if (op->value.type() == Int(32)) {
-        alignment_info.push(op->name, modulus_remainder(op->value, alignment_info));
+    // As with Let, walk the spine iteratively.
+    vector<const LetStmt *> lets;
+    Stmt body = op;
+    while (const LetStmt *let = body.as<LetStmt>()) {
+        sym_push(let->name, codegen(let->value));
+        if (let->value.type() == Int(32)) {
+            alignment_info.push(let->name, modulus_remainder(let->value, alignment_info));
+        }
+        lets.push_back(let);
+        body = let->body;
     }
 
-    codegen(op->body);
+    codegen(body);
 
-    if (op->value.type() == Int(32)) {
-        alignment_info.pop(op->name);
+    for (size_t i = lets.size(); i > 0; i--) {
+        const LetStmt *let = lets[i - 1];
+        if (let->value.type() == Int(32)) {
+            alignment_info.pop(let->name);
+        }
+        sym_pop(let->name);
     }
-
-    sym_pop(op->name);
 }
 
 void CodeGen_LLVM::visit(const AssertStmt *op) {
@@ -2890,6 +3087,48 @@ Constant *CodeGen_LLVM::create_binary_blob(const vector<char> &data, const strin
     return ptr;
 }
 
+namespace {
+
+// Map a call to one of the halide_error_* functions to the error code
+// it would return, so that under NoErrorStrings we can produce the code
+// directly without materializing any of the message arguments.
+int map_error_call_to_code(const std::string &name) {
+    static const std::map<std::string, int> error_codes = {
+        {"halide_error_explicit_bounds_too_small", halide_error_code_explicit_bounds_too_small},
+        {"halide_error_bad_type", halide_error_code_bad_type},
+        {"halide_error_access_out_of_bounds", halide_error_code_access_out_of_bounds},
+        {"halide_error_buffer_allocation_too_large", halide_error_code_buffer_allocation_too_large},
+        {"halide_error_buffer_extents_negative", halide_error_code_buffer_extents_negative},
+        {"halide_error_buffer_extents_too_large", halide_error_code_buffer_extents_too_large},
+        {"halide_error_constraints_make_required_region_smaller", halide_error_code_constraints_make_required_region_smaller},
+        {"halide_error_constraint_violated", halide_error_code_constraint_violated},
+        {"halide_error_out_of_memory", halide_error_code_out_of_memory},
+        {"halide_error_buffer_argument_is_null", halide_error_code_buffer_argument_is_null},
+        {"halide_error_debug_to_file_failed", halide_error_code_debug_to_file_failed},
+        {"halide_error_unaligned_host_ptr", halide_error_code_unaligned_host_ptr},
+        {"halide_error_host_is_null", halide_error_code_host_is_null},
+        {"halide_error_failed_to_upgrade_buffer_t", halide_error_code_failed_to_upgrade_buffer_t},
+        {"halide_error_failed_to_downgrade_buffer_t", halide_error_code_failed_to_downgrade_buffer_t},
+        {"halide_error_bad_fold", halide_error_code_bad_fold},
+        {"halide_error_bad_extern_fold", halide_error_code_bad_extern_fold},
+        {"halide_error_fold_factor_too_small", halide_error_code_fold_factor_too_small},
+        {"halide_error_requirement_failed", halide_error_code_requirement_failed},
+        {"halide_error_specialize_fail", halide_error_code_specialize_fail}};
+    auto it = error_codes.find(name);
+    if (it != error_codes.end()) {
+        return it->second;
+    }
+    if (starts_with(name, "halide_error_param_too_small")) {
+        return halide_error_code_param_too_small;
+    }
+    if (starts_with(name, "halide_error_param_too_large")) {
+        return halide_error_code_param_too_large;
+    }
+    return halide_error_code_generic_error;
+}
+
+}  // namespace
+
 void CodeGen_LLVM::create_assertion(Value *cond, Expr message, llvm::Value *error_code) {
 
     internal_assert(!message.defined() || message.type() == Int(32))
@@ -2897,6 +3136,24 @@ void CodeGen_LLVM::create_assertion(Value *cond, Expr message, llvm::Value *erro
 
     if (target.has_feature(Target::NoAsserts)) return;
 
+    if (target.has_feature(Target::NoErrorStrings) && message.defined() && !error_code) {
+        // Reduce the message to a constant error code. The error
+        // handler is never called, so the linker can drop the message
+        // strings and the formatting code in errors.cpp entirely.
+        // Anything that isn't a call to an error handler (e.g. an
+        // extern stage's result code) is already string-free.
+        if (const Call *call = message.as<Call>()) {
+            if (call->name == "halide_error_bounds_inference_call_failed" ||
+                call->name == "halide_error_extern_stage_failed") {
+                // These report a failure that already happened in an
+                // extern call; propagate its result code unchanged.
+                message = call->args.back();
+            } else {
+                message = IntImm::make(Int(32), map_error_call_to_code(call->name));
+            }
+        }
+    }
+
     // If the condition is a vector, fold it down to a scalar
     VectorType *vt = dyn_cast<VectorType>(cond->getType());
     if (vt) {
@@ -2921,6 +3178,22 @@ void CodeGen_LLVM::create_assertion(Value *cond, Expr message, llvm::Value *erro
     // Call the error handler
     if (!error_code) error_code = codegen(message);
 
+    // The calls that materialize and deliver the message only run on
+    // the failure path, so mark them cold to keep them out of the way
+    // of the hot code.
+    for (llvm::Function::iterator bb = assert_fails_bb->getIterator(); ; bb++) {
+        for (llvm::Instruction &inst : *bb) {
+            if (CallInst *call = dyn_cast<CallInst>(&inst)) {
+                #if LLVM_VERSION < 50
+                call->addAttribute(AttributeSet::FunctionIndex, Attribute::Cold);
+                #else
+                call->addAttribute(AttributeList::FunctionIndex, Attribute::Cold);
+                #endif
+            }
+        }
+        if (&*bb == builder->GetInsertBlock()) break;
+    }
+
     return_with_error_code(error_code);
 
     // Continue on using the success case
@@ -2950,6 +3223,12 @@ void CodeGen_LLVM::visit(const ProducerConsumer *op) {
     builder->CreateBr(produce);
     builder->SetInsertPoint(produce);
     codegen(op->body);
+
+    // Non-temporal stores are weakly ordered, so fence before anyone
+    // consumes the values.
+    if (op->is_producer && buffer_is_non_temporal(op->name)) {
+        builder->CreateFence(llvm::AtomicOrdering::SequentiallyConsistent);
+    }
 }
 
 void CodeGen_LLVM::visit(const For *op) {
@@ -3117,40 +3396,24 @@ void CodeGen_LLVM::visit(const Store *op) {
 
     Halide::Type value_type = op->value.type();
     Value *val = codegen(op->value);
-    bool is_external = (external_buffer.find(op->name) != external_buffer.end());
     // Scalar
     if (value_type.is_scalar()) {
         Value *ptr = codegen_buffer_pointer(op->name, value_type, op->index);
         StoreInst *store = builder->CreateAlignedStore(val, ptr, value_type.bytes());
         add_tbaa_metadata(store, op->name, op->index);
+        if (buffer_is_non_temporal(op->name)) {
+            add_non_temporal_metadata(store);
+        }
     } else if (const Let *let = op->index.as<Let>()) {
         Stmt s = Store::make(op->name, op->value, let->body, op->param, op->predicate);
         codegen(LetStmt::make(let->name, let->value, s));
     } else {
-        int alignment = value_type.bytes();
         const Ramp *ramp = op->index.as<Ramp>();
         if (ramp && is_one(ramp->stride)) {
 
-            int native_bits = native_vector_bits();
-            int native_bytes = native_bits / 8;
-
-            // Boost the alignment if possible, up to the native vector width.
-            ModulusRemainder mod_rem = modulus_remainder(ramp->base, alignment_info);
-            while ((mod_rem.remainder & 1) == 0 &&
-                   (mod_rem.modulus & 1) == 0 &&
-                   alignment < native_bytes) {
-                mod_rem.modulus /= 2;
-                mod_rem.remainder /= 2;
-                alignment *= 2;
-            }
+            int alignment = dense_vector_alignment(value_type, op->name, ramp->base, op->param);
 
-            // If it is an external buffer, then we cannot assume that the host pointer
-            // is aligned to at least the native vector width. However, we may be able to do
-            // better than just assuming that it is unaligned.
-            if (is_external && op->param.defined()) {
-                int host_alignment = op->param.host_alignment();
-                alignment = gcd(alignment, host_alignment);
-            }
+            int native_bits = native_vector_bits();
 
             // For dense vector stores wider than the native vector
             // width, bust them up into native vectors.
@@ -3167,6 +3430,9 @@ void CodeGen_LLVM::visit(const Store *op) {
                 Value *vec_ptr = builder->CreatePointerCast(elt_ptr, slice_val->getType()->getPointerTo());
                 StoreInst *store = builder->CreateAlignedStore(slice_val, vec_ptr, alignment);
                 add_tbaa_metadata(store, op->name, slice_index);
+                if (buffer_is_non_temporal(op->name)) {
+                    add_non_temporal_metadata(store);
+                }
             }
         } else if (ramp) {
             Type ptr_type = value_type.element_of();
@@ -3518,4 +3784,35 @@ ModulusRemainder CodeGen_LLVM::get_alignment_info(Expr e) {
     return modulus_remainder(e, alignment_info);
 }
 
+int CodeGen_LLVM::dense_vector_alignment(Type t, const std::string &buf_name,
+                                         Expr base, const Parameter &param) {
+    bool is_external = (external_buffer.find(buf_name) != external_buffer.end());
+
+    // What the base pointer itself is aligned to. We assume
+    // halide_malloc for the platform returns buffers aligned to at
+    // least the native vector width (i.e. 16-byte alignment on arm,
+    // and 32-byte alignment on x86). For an external buffer we can
+    // only assume the host alignment the user declared.
+    int base_alignment;
+    if (is_external && param.defined()) {
+        base_alignment = param.host_alignment();
+    } else {
+        base_alignment = native_vector_bits() / 8;
+    }
+
+    // Boost the element-size alignment using what we know about the
+    // index, up to the alignment of the base pointer.
+    int alignment = t.bytes();
+    ModulusRemainder mod_rem = modulus_remainder(base, alignment_info);
+    while ((mod_rem.remainder & 1) == 0 &&
+           (mod_rem.modulus & 1) == 0 &&
+           alignment < base_alignment) {
+        mod_rem.modulus /= 2;
+        mod_rem.remainder /= 2;
+        alignment *= 2;
+    }
+
+    return gcd(alignment, base_alignment);
+}
+
 }}
@@ -284,6 +284,14 @@ protected:
      * different buffers */
     void add_tbaa_metadata(llvm::Instruction *inst, std::string buffer, Expr index);
 
+    /** Returns true if stores to the given buffer were scheduled as
+     * non-temporal with Func::store_non_temporal. */
+    bool buffer_is_non_temporal(const std::string &buffer);
+
+    /** Mark a store with non-temporal metadata so that llvm emits a
+     * streaming store instruction for it where the target has one. */
+    void add_non_temporal_metadata(llvm::StoreInst *store);
+
     /** Get a unique name for the actual block of memory that an
      * allocate node uses. Used so that alias analysis understands
      * when multiple Allocate nodes shared the same memory. */
@@ -299,6 +307,15 @@ protected:
     virtual Expr sorted_avg(Expr a, Expr b);
     // @}
 
+    /** Can this backend select a native instruction for the given
+     * resampling intrinsic (widening_add, widening_mul,
+     * rounding_halving_add, rounding_shift_right) at the type it is
+     * used at? Used only to decide whether to warn that one of the
+     * guaranteed-fast-path ops is falling back to generic code. */
+    virtual bool supports_resampling_intrinsic(const Call *op) const {
+        return false;
+    }
+
 
     using IRVisitor::visit;
 
@@ -381,6 +398,10 @@ protected:
      * guarantee their alignment) */
     std::set<std::string> external_buffer;
 
+    /** Funcs in the function currently being compiled whose stores
+     * should be non-temporal. Copied from the LoweredFunc. */
+    std::set<std::string> non_temporal_buffers;
+
     /** The user_context argument. May be a constant null if the
      * function is being compiled without a user context. */
     llvm::Value *get_user_context() const;
@@ -439,6 +460,16 @@ protected:
     /** Get the result of modulus-remainder analysis for a given expr. */
     ModulusRemainder get_alignment_info(Expr e);
 
+    /** The byte alignment that a dense vector load or store of the
+     * named buffer at the given ramp base is guaranteed to have. It
+     * combines what the index proves with what we know about the
+     * buffer's base pointer: internal allocations are aligned to at
+     * least the native vector width by halide_malloc and the stack
+     * allocator, and external buffers to their declared host
+     * alignment (see ImageParam::set_host_alignment). */
+    int dense_vector_alignment(Type t, const std::string &buf_name,
+                               Expr base, const Parameter &param);
+
 private:
 
     /** All the values in scope at the current code location during
@@ -471,6 +502,8 @@ private:
 
     llvm::Function *add_argv_wrapper(const std::string &name);
 
+    llvm::Function *add_warmup_shim(const std::string &name);
+
     llvm::Value *codegen_dense_vector_load(const Load *load, llvm::Value *vpred = nullptr);
 
     virtual void codegen_predicated_vector_load(const Load *op);
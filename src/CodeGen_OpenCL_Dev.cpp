@@ -500,10 +500,35 @@ void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Shuffle *op) {
 }
 
 void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Max *op) {
+    // Use OpenCL's clamp builtin for clamping patterns; GPUs commonly
+    // implement it in fewer instructions than a min/max pair, which
+    // matters for the address clamping boundary conditions
+    // produce. clamp is undefined when the bounds cross, so only fold
+    // when they provably don't.
+    const Min *min = op->a.as<Min>();
+    Expr lo = op->b;
+    if (!min) {
+        min = op->b.as<Min>();
+        lo = op->a;
+    }
+    if (min && can_prove(lo <= min->b)) {
+        print_expr(Call::make(op->type, "clamp", {min->a, lo, min->b}, Call::Extern));
+        return;
+    }
     print_expr(Call::make(op->type, "max", {op->a, op->b}, Call::Extern));
 }
 
 void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Min *op) {
+    const Max *max = op->a.as<Max>();
+    Expr hi = op->b;
+    if (!max) {
+        max = op->b.as<Max>();
+        hi = op->a;
+    }
+    if (max && can_prove(max->b <= hi)) {
+        print_expr(Call::make(op->type, "clamp", {max->a, max->b, hi}, Call::Extern));
+        return;
+    }
     print_expr(Call::make(op->type, "min", {op->a, op->b}, Call::Extern));
 }
 
@@ -290,7 +290,12 @@ void CodeGen_OpenGLCompute_Dev::CodeGen_OpenGLCompute_C::add_kernel(Stmt s,
     FindSharedAllocations fsa;
     s.accept(&fsa);
     for (const Allocate *op : fsa.allocs) {
-        internal_assert(op->extents.size() == 1 && is_const(op->extents[0]));
+        internal_assert(op->extents.size() == 1);
+        user_assert(is_const(op->extents[0]))
+            << "Only fixed-size allocations can be stored in shared memory "
+            << "in the OpenGL Compute backend. Try storing " << op->name
+            << " in registers or global memory instead, or use "
+            << "Func::bound_extent to give it a constant size.\n";
         stream << "shared "
                << print_type(op->type) << " "
                << print_name(op->name) << "["
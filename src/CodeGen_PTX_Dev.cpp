@@ -224,6 +224,88 @@ void CodeGen_PTX_Dev::visit(const AssertStmt *op) {
     codegen(IfThenElse::make(!op->condition, Evaluate::make(trap)));
 }
 
+llvm::Value *CodeGen_PTX_Dev::warp_shuffle(llvm::Value *val, const std::string &mode,
+                                           llvm::Value *operand) {
+    llvm::Type *t = val->getType();
+    bool is_float = t->isFloatTy();
+    internal_assert(is_float || t == i32_t) << "warp_shuffle of non-32-bit value\n";
+    llvm::Type *shfl_t = is_float ? f32_t : i32_t;
+
+    string name = "llvm.nvvm.shfl.";
+    vector<llvm::Type *> arg_types;
+    vector<llvm::Value *> args;
+    #if LLVM_VERSION >= 60
+    // The sync variants take a mask of the participating lanes. Warp
+    // primitives are only injected where whole warps are active.
+    name += "sync.";
+    arg_types.push_back(i32_t);
+    args.push_back(ConstantInt::get(i32_t, 0xffffffff));
+    #endif
+    name += mode + (is_float ? ".f32" : ".i32");
+    arg_types.push_back(shfl_t);
+    args.push_back(val);
+    arg_types.push_back(i32_t);
+    args.push_back(operand);
+    // The mask-and-clamp operand: segment mask zero, source lanes
+    // clamped to the whole warp.
+    arg_types.push_back(i32_t);
+    args.push_back(ConstantInt::get(i32_t, 31));
+
+    llvm::FunctionType *fn_t = llvm::FunctionType::get(shfl_t, arg_types, false);
+    llvm::Function *fn = llvm::cast<llvm::Function>(module->getOrInsertFunction(name, fn_t));
+    return builder->CreateCall(fn, args);
+}
+
+void CodeGen_PTX_Dev::visit(const Call *op) {
+    if (op->is_intrinsic(Call::gpu_warp_reduce)) {
+        const StringImm *reduce_op = op->args[0].as<StringImm>();
+        internal_assert(reduce_op) << "Malformed gpu_warp_reduce intrinsic\n";
+        Halide::Type t = op->args[1].type();
+        internal_assert(t.is_scalar() && t.bits() == 32)
+            << "gpu_warp_reduce of unsupported type " << t << "\n";
+
+        // A log2(warp_size)-step shuffle-down tree. Every lane ends
+        // up with the reduction of itself and all higher lanes that
+        // are within the warp, so lane zero holds the full result.
+        llvm::Value *val = codegen(op->args[1]);
+        for (int delta = 16; delta > 0; delta /= 2) {
+            llvm::Value *other = warp_shuffle(val, "down", ConstantInt::get(i32_t, delta));
+            const std::string &o = reduce_op->value;
+            if (o == "add") {
+                val = t.is_float() ? builder->CreateFAdd(val, other) : builder->CreateAdd(val, other);
+            } else if (o == "min" || o == "max") {
+                llvm::Value *cmp;
+                if (t.is_float()) {
+                    cmp = builder->CreateFCmpOLT(val, other);
+                } else if (t.is_uint()) {
+                    cmp = builder->CreateICmpULT(val, other);
+                } else {
+                    cmp = builder->CreateICmpSLT(val, other);
+                }
+                if (o == "max") {
+                    cmp = builder->CreateNot(cmp);
+                }
+                val = builder->CreateSelect(cmp, val, other);
+            } else if (o == "and") {
+                val = builder->CreateAnd(val, other);
+            } else if (o == "or") {
+                val = builder->CreateOr(val, other);
+            } else if (o == "xor") {
+                val = builder->CreateXor(val, other);
+            } else {
+                internal_error << "Unknown gpu_warp_reduce op " << o << "\n";
+            }
+        }
+        value = val;
+    } else if (op->is_intrinsic(Call::gpu_warp_broadcast)) {
+        llvm::Value *val = codegen(op->args[0]);
+        llvm::Value *lane = codegen(op->args[1]);
+        value = warp_shuffle(val, "idx", lane);
+    } else {
+        CodeGen_LLVM::visit(op);
+    }
+}
+
 string CodeGen_PTX_Dev::march() const {
     return "nvptx64";
 }
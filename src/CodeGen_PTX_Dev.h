@@ -59,8 +59,15 @@ protected:
     void visit(const Allocate *);
     void visit(const Free *);
     void visit(const AssertStmt *);
+    void visit(const Call *);
     // @}
 
+    /** Emit a warp shuffle of a 32-bit value via the nvvm shfl
+     * intrinsics. The mode is "down" or "idx", and the operand is the
+     * lane delta or source lane respectively. */
+    llvm::Value *warp_shuffle(llvm::Value *val, const std::string &mode,
+                              llvm::Value *operand);
+
     std::string march() const;
     std::string mcpu() const;
     std::string mattrs() const;
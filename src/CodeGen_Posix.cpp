@@ -79,7 +79,7 @@ int CodeGen_Posix::allocation_padding(Type type) const {
     return type.bytes();
 }
 
-CodeGen_Posix::Allocation CodeGen_Posix::create_allocation(const std::string &name, Type type,
+CodeGen_Posix::Allocation CodeGen_Posix::create_allocation(const std::string &name, Type type, MemoryType memory_type,
                                                            const std::vector<Expr> &extents, Expr condition,
                                                            Expr new_expr, std::string free_function) {
     Value *llvm_size = nullptr;
@@ -92,11 +92,28 @@ CodeGen_Posix::Allocation CodeGen_Posix::create_allocation(const std::string &na
         if (stack_bytes > target.maximum_buffer_size()) {
             const string str_max_size = target.has_large_buffers() ? "2^63 - 1" : "2^31 - 1";
             user_error << "Total size for allocation " << name << " is constant but exceeds " << str_max_size << ".";
-        } else if (!can_allocation_fit_on_stack(stack_bytes)) {
+        } else if (memory_type == MemoryType::Stack) {
+            // Explicitly scheduled onto the stack. Don't second-guess
+            // the size heuristic, but stay within the target's stack
+            // budget.
+            user_assert(stack_bytes <= stack_allocation_budget(target))
+                << "Allocation " << name << " is scheduled with store_in(MemoryType::Stack), "
+                << "but requires " << stack_bytes << " bytes, which exceeds the stack budget of "
+                << stack_allocation_budget(target) << " bytes for this target.\n";
+        } else if (memory_type == MemoryType::Heap ||
+                   !can_allocation_fit_on_stack(stack_bytes, target)) {
             stack_bytes = 0;
             llvm_size = codegen(Expr(constant_bytes));
         }
     } else {
+        // While the stack promotion heuristic only fires for constant
+        // sizes, an explicit request for the stack can't be honored
+        // for an unbounded allocation, and silently spilling to the
+        // heap would hide the very cost the directive exists to
+        // remove.
+        user_assert(memory_type != MemoryType::Stack)
+            << "Allocation " << name << " is scheduled with store_in(MemoryType::Stack), "
+            << "but its size is not constant at compile time.\n";
         llvm_size = codegen_allocation_size(name, type, extents);
     }
 
@@ -268,7 +285,7 @@ void CodeGen_Posix::visit(const Allocate *alloc) {
                    << alloc->name << "\n";
     }
 
-    Allocation allocation = create_allocation(alloc->name, alloc->type,
+    Allocation allocation = create_allocation(alloc->name, alloc->type, alloc->memory_type,
                                               alloc->extents, alloc->condition,
                                               alloc->new_expr, alloc->free_function);
     sym_push(alloc->name, allocation.ptr);
@@ -171,6 +171,70 @@ void CodeGen_X86::visit(const NE *op) {
     codegen(!(op->a == op->b));
 }
 
+void CodeGen_X86::visit(const Load *op) {
+    // A vector load with a dynamic index would be scalarized into a
+    // chain of extract/load/insert by the default lowering. On AVX2
+    // we can use a native gather instead, as long as the elements are
+    // 32-bit and the lanes divide into the 4- or 8-wide gathers the
+    // ISA provides. Constant-stride ramps keep the specialized
+    // dense/shuffle lowerings, which beat a gather when they apply.
+    if (target.has_feature(Target::AVX2) &&
+        op->type.is_vector() &&
+        op->type.bits() == 32 &&
+        !op->type.is_handle() &&
+        is_one(op->predicate) &&
+        op->index.type().is_int() &&
+        op->index.type().bits() == 32) {
+        const Ramp *ramp = op->index.as<Ramp>();
+        bool const_stride_ramp = ramp && is_const(ramp->stride);
+        int lanes = op->type.lanes();
+        int intrin_lanes = (lanes % 8 == 0) ? 8 : ((lanes % 4 == 0) ? 4 : 0);
+        if (!const_stride_ramp && intrin_lanes > 0) {
+            string name = op->type.is_float() ? "llvm.x86.avx2.gather.d.ps" : "llvm.x86.avx2.gather.d.d";
+            if (intrin_lanes == 8) {
+                name += ".256";
+            }
+
+            llvm::Type *intrin_type = llvm_type_of(op->type.with_lanes(intrin_lanes));
+            llvm::Type *index_type = VectorType::get(i32_t, intrin_lanes);
+            llvm::Type *base_type = i8_t->getPointerTo();
+
+            Value *base = codegen_buffer_pointer(op->name, op->type.element_of(), make_zero(Int(32)));
+            base = builder->CreatePointerCast(base, base_type);
+            Value *index = codegen(op->index);
+            // The mask has the same type as the result; all lanes on.
+            Value *mask = llvm::Constant::getAllOnesValue(intrin_type);
+            // With a full mask the pass-through operand is never used.
+            Value *pass_through = UndefValue::get(intrin_type);
+            // The index is in elements, the gather scale in bytes.
+            Value *scale = ConstantInt::get(i8_t, op->type.bytes());
+
+            llvm::Function *fn = module->getFunction(name);
+            if (!fn) {
+                llvm::Type *arg_types[] = {intrin_type, base_type, index_type, intrin_type, i8_t};
+                FunctionType *func_t = FunctionType::get(intrin_type, arg_types, false);
+                fn = llvm::Function::Create(func_t, llvm::Function::ExternalLinkage, name, module.get());
+                fn->setCallingConv(CallingConv::C);
+                // Unlike most of the intrinsics we use, a gather
+                // reads memory, so don't mark it readnone.
+                fn->setOnlyReadsMemory();
+                fn->setDoesNotThrow();
+            }
+
+            vector<Value *> results;
+            for (int start = 0; start < lanes; start += intrin_lanes) {
+                Value *index_slice = slice_vector(index, start, intrin_lanes);
+                Value *args[] = {pass_through, base, index_slice, mask, scale};
+                results.push_back(builder->CreateCall(fn, args));
+            }
+            value = concat_vectors(results);
+            return;
+        }
+    }
+
+    CodeGen_Posix::visit(op);
+}
+
 void CodeGen_X86::visit(const Select *op) {
     if (op->condition.type().is_vector()) {
         // LLVM handles selects on vector conditions much better at native width
@@ -323,6 +387,24 @@ void CodeGen_X86::visit(const Cast *op) {
     CodeGen_Posix::visit(op);
 }
 
+bool CodeGen_X86::supports_resampling_intrinsic(const Call *op) const {
+    Type arg_t = op->args[0].type();
+    if (!arg_t.is_vector()) {
+        return false;
+    }
+    if (op->is_intrinsic(Call::rounding_halving_add)) {
+        // pavgb/pavgw; there is no signed or 32-bit equivalent.
+        return arg_t.is_uint() && (arg_t.bits() == 8 || arg_t.bits() == 16);
+    }
+    if (op->is_intrinsic(Call::widening_add) ||
+        op->is_intrinsic(Call::widening_mul)) {
+        // llvm selects pmovzx/pmovsx + padd/pmull pairs for the
+        // widened forms at these widths.
+        return arg_t.bits() <= 16;
+    }
+    return false;
+}
+
 Expr CodeGen_X86::mulhi_shr(Expr a, Expr b, int shr) {
     Type ty = a.type();
     if (ty.is_vector() && ty.bits() == 16) {
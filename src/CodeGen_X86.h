@@ -31,6 +31,8 @@ protected:
 
     Expr mulhi_shr(Expr a, Expr b, int shr);
 
+    bool supports_resampling_intrinsic(const Call *op) const;
+
     using CodeGen_Posix::visit;
 
     /** Nodes for which we want to emit specific sse/avx intrinsics */
@@ -47,6 +49,10 @@ protected:
     void visit(const NE *);
     void visit(const Select *);
     // @}
+
+    /** Loads with dynamic vector indices become native gather
+     * instructions on targets with AVX2. */
+    void visit(const Load *);
 };
 
 }}
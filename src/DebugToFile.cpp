@@ -80,7 +80,7 @@ class DebugToFile : public IRMutator2 {
             body = LetStmt::make(call_result_name, call, body);
             body = Block::make(mutate(op->body), body);
 
-            return Realize::make(op->name, op->types, op->bounds, op->condition, body);
+            return Realize::make(op->name, op->types, op->bounds, op->condition, body, op->memory_type);
 
         } else {
             return IRMutator2::visit(op);
@@ -380,6 +380,12 @@ Expr extract_lane(Expr e, int lane) {
     return simplify(e);
 }
 
+// The largest deinterleaving factor to rewrite into a shuffle
+// network. 16 covers an in-register transpose of a full vector of
+// floats on the widest targets we generate shuffles for; beyond that
+// the number of intermediate vectors stops paying for itself.
+const int max_deinterleave_factor = 16;
+
 class Interleaver : public IRMutator2 {
     Scope<ModulusRemainder> alignment_info;
 
@@ -390,29 +396,41 @@ class Interleaver : public IRMutator2 {
     bool should_deinterleave;
     int num_lanes;
 
+    // Collect the lanes of e congruent to each residue mod n, for
+    // power-of-two n, by recursively splitting into even and odd
+    // lanes. out[k] gets the lanes congruent to k. The result is a
+    // log2(n)-deep network of even/odd shuffles, which maps onto the
+    // zip/unpack instructions of the targets we care about.
+    void split_lanes_mod_n(const Expr &e, int n, std::vector<Expr> *out) {
+        if (n == 1) {
+            out->push_back(e);
+            return;
+        }
+        std::vector<Expr> evens, odds;
+        split_lanes_mod_n(extract_even_lanes(e, vector_lets), n / 2, &evens);
+        split_lanes_mod_n(extract_odd_lanes(e, vector_lets), n / 2, &odds);
+        for (int i = 0; i < n / 2; i++) {
+            out->push_back(evens[i]);
+            out->push_back(odds[i]);
+        }
+    }
+
     Expr deinterleave_expr(Expr e) {
         if (e.type().lanes() <= num_lanes) {
             // Just scalarize
             return e;
-        } else if (num_lanes == 2) {
-            Expr a = extract_even_lanes(e, vector_lets);
-            Expr b = extract_odd_lanes(e, vector_lets);
-            return Shuffle::make_interleave({a, b});
         } else if (num_lanes == 3) {
             Expr a = extract_mod3_lanes(e, 0, vector_lets);
             Expr b = extract_mod3_lanes(e, 1, vector_lets);
             Expr c = extract_mod3_lanes(e, 2, vector_lets);
             return Shuffle::make_interleave({a, b, c});
-        } else if (num_lanes == 4) {
-            Expr a = extract_even_lanes(e, vector_lets);
-            Expr b = extract_odd_lanes(e, vector_lets);
-            Expr aa = extract_even_lanes(a, vector_lets);
-            Expr ab = extract_odd_lanes(a, vector_lets);
-            Expr ba = extract_even_lanes(b, vector_lets);
-            Expr bb = extract_odd_lanes(b, vector_lets);
-            return Shuffle::make_interleave({aa, ba, ab, bb});
+        } else if (num_lanes <= max_deinterleave_factor &&
+                   (num_lanes & (num_lanes - 1)) == 0) {
+            std::vector<Expr> parts;
+            split_lanes_mod_n(e, num_lanes, &parts);
+            return Shuffle::make_interleave(parts);
         } else {
-            // Give up and don't do anything clever for >4
+            // Give up and don't do anything clever for other factors
             return e;
         }
     }
@@ -466,10 +484,19 @@ class Interleaver : public IRMutator2 {
         return visit_let<LetStmt, Stmt>(op);
     }
 
+    // A factor we know how to deinterleave by: 3, or a power of two
+    // up to max_deinterleave_factor.
+    static bool can_deinterleave_factor(int i) {
+        return i == 3 || (i >= 2 &&
+                          i <= max_deinterleave_factor &&
+                          (i & (i - 1)) == 0);
+    }
+
     Expr visit(const Mod *op) override {
         const Ramp *r = op->a.as<Ramp>();
-        for (int i = 2; i <= 4; ++i) {
+        for (int i = 2; i <= max_deinterleave_factor; ++i) {
             if (r &&
+                can_deinterleave_factor(i) &&
                 is_const(op->b, i) &&
                 (r->type.lanes() % i) == 0) {
                 should_deinterleave = true;
@@ -482,8 +509,9 @@ class Interleaver : public IRMutator2 {
 
     Expr visit(const Div *op) override {
         const Ramp *r = op->a.as<Ramp>();
-        for (int i = 2; i <= 4; ++i) {
+        for (int i = 2; i <= max_deinterleave_factor; ++i) {
             if (r &&
+                can_deinterleave_factor(i) &&
                 is_const(op->b, i) &&
                 (r->type.lanes() % i) == 0) {
                 should_deinterleave = true;
@@ -1,10 +1,15 @@
 #include <map>
 
+#include "Bounds.h"
 #include "EarlyFree.h"
-#include "IRMutator.h"
-#include "IREquality.h"
 #include "ExprUsesVar.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
 #include "InjectHostDevBufferCopies.h"
+#include "Monotonic.h"
+#include "Simplify.h"
+#include "Substitute.h"
 
 namespace Halide {
 namespace Internal {
@@ -123,9 +128,106 @@ private:
     }
 };
 
+// The loop we'd consider injecting slab releases into: the serial,
+// host-side for loop at the heart of the statement containing the
+// last use, if there is one.
+const For *find_consume_loop(Stmt s) {
+    while (s.defined()) {
+        if (const LetStmt *let = s.as<LetStmt>()) {
+            s = let->body;
+        } else if (const ProducerConsumer *pc = s.as<ProducerConsumer>()) {
+            s = pc->body;
+        } else if (const For *loop = s.as<For>()) {
+            if (loop->for_type == ForType::Serial &&
+                loop->device_api == DeviceAPI::None) {
+                return loop;
+            }
+            return nullptr;
+        } else {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+// If the final consumer of an allocation walks it sequentially, the
+// slabs it has finished with are dead well before the whole
+// allocation is. When we can prove that from the loop structure -
+// every address the loop body touches is at or above a bound that
+// increases monotonically with the loop variable - inject a
+// per-iteration hint that lets the allocator return the consumed
+// prefix to the OS, so the peak footprint of e.g. a pyramid tracks
+// the unconsumed remainder rather than the full intermediate.
+class InjectSlabReleases : public IRMutator2 {
+public:
+    const Allocate *alloc;
+    const For *consume_loop;
+
+private:
+    using IRMutator2::visit;
+
+    Stmt visit(const For *op) override {
+        if (op != consume_loop) {
+            return IRMutator2::visit(op);
+        }
+
+        // The address of the allocation may escape through its base
+        // pointer or a buffer_t wrapping it, in which case the box of
+        // loads and stores below doesn't cover all uses.
+        if (stmt_uses_var(op->body, alloc->name) ||
+            stmt_uses_var(op->body, alloc->name + ".buffer")) {
+            return op;
+        }
+
+        Box b = box_touched(op->body, alloc->name);
+        if (b.size() != 1 || !b[0].has_lower_bound()) {
+            return op;
+        }
+        Expr min = b[0].min;
+        if (is_monotonic(min, op->name) != Monotonic::Increasing) {
+            return op;
+        }
+
+        // Everything below the next iteration's lower bound is dead
+        // once this iteration finishes.
+        Expr loop_var = Variable::make(Int(32), op->name);
+        Expr dead_elems = substitute(op->name, loop_var + 1, min);
+        Expr dead_bytes = cast(UInt(64), max(dead_elems, 0)) *
+                          make_const(UInt(64), alloc->type.bytes());
+        Expr release = Call::make(Int(32), "halide_release_allocation_prefix",
+                                  {Variable::make(Handle(), alloc->name),
+                                   simplify(dead_bytes)},
+                                  Call::Extern);
+        Stmt body = Block::make(op->body, Evaluate::make(release));
+        return For::make(op->name, op->min, op->extent,
+                         op->for_type, op->device_api, body);
+    }
+};
+
 class InjectEarlyFrees : public IRMutator2 {
     using IRMutator2::visit;
 
+    // The allocation is definitely on the heap, with the header the
+    // default allocator's release hint expects.
+    bool allocation_is_on_heap(const Allocate *alloc) {
+        if (alloc->new_expr.defined() ||
+            !alloc->free_function.empty() ||
+            !is_one(alloc->condition) ||
+            alloc->memory_type == MemoryType::Stack) {
+            return false;
+        }
+        // Matches the largest stack_allocation_budget codegen grants
+        // any target (see CodeGen_Internal.cpp).
+        const int64_t max_stack_allocation = 1024 * 16;
+        int32_t const_size = alloc->constant_allocation_size();
+        if (const_size > 0 &&
+            alloc->memory_type != MemoryType::Heap &&
+            (int64_t)const_size * alloc->type.bytes() <= max_stack_allocation) {
+            return false;
+        }
+        return true;
+    }
+
     Stmt visit(const Allocate *alloc) override {
         Stmt stmt = IRMutator2::visit(alloc);
         alloc = stmt.as<Allocate>();
@@ -139,10 +241,18 @@ class InjectEarlyFrees : public IRMutator2 {
             inject_marker.func = alloc->name;
             inject_marker.last_use = last_use.last_use;
             stmt = inject_marker.mutate(stmt);
+
+            const For *consume_loop = find_consume_loop(last_use.last_use);
+            if (consume_loop && allocation_is_on_heap(alloc)) {
+                InjectSlabReleases inject_releases;
+                inject_releases.alloc = alloc;
+                inject_releases.consume_loop = consume_loop;
+                stmt = inject_releases.mutate(stmt);
+            }
         } else {
             stmt = Allocate::make(alloc->name, alloc->type, alloc->extents, alloc->condition,
                                   Block::make(alloc->body, Free::make(alloc->name)),
-                                  alloc->new_expr, alloc->free_function);
+                                  alloc->new_expr, alloc->free_function, alloc->memory_type);
         }
         return stmt;
 
@@ -0,0 +1,140 @@
+#include "EmulateFloat16Math.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Util.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+class EmulateFloat16Math : public IRMutator2 {
+    using IRMutator2::visit;
+
+    // Should math producing this type be done in float32 instead?
+    bool needs_widening(Type t) {
+        return t.is_bfloat() || (widen_float16 && t.is_float() && t.bits() == 16);
+    }
+
+    Expr widen(Expr e) {
+        Type wide = Float(32, e.type().lanes());
+        if (e.type() == wide) {
+            return e;
+        }
+        return lower_cast(wide, e);
+    }
+
+    // Build a cast, lowering it if it involves a bfloat type. New
+    // casts made by this mutator go through here so they don't need a
+    // second visit.
+    Expr lower_cast(Type t, Expr e) {
+        if (t.is_bfloat()) {
+            internal_assert(t.bits() == 16) << "Only 16-bit bfloats are supported\n";
+            // Round to nearest even by adding half of the truncated
+            // ulp, plus one more if the bit above it is set. Like the
+            // hardware instructions, this can round a NaN with
+            // payload bits only in the bottom half to infinity; the
+            // alternative is a select per conversion.
+            Expr f = widen(e);
+            Expr bits = reinterpret(UInt(32, t.lanes()), f);
+            Expr one = make_one(bits.type());
+            Expr bias = make_const(bits.type(), 0x7fff) + ((bits >> 16) & one);
+            Expr rounded = Cast::make(UInt(16, t.lanes()), (bits + bias) >> 16);
+            return reinterpret(t, rounded);
+        } else if (e.type().is_bfloat()) {
+            internal_assert(e.type().bits() == 16) << "Only 16-bit bfloats are supported\n";
+            // bfloat16 is the top 16 bits of a float32, so widening
+            // is exact: shift the bits into place.
+            Expr bits = Cast::make(UInt(32, e.type().lanes()),
+                                   reinterpret(UInt(16, e.type().lanes()), e));
+            Expr f = reinterpret(Float(32, e.type().lanes()), bits << 16);
+            return lower_cast(t, f);
+        } else if (t == e.type()) {
+            return e;
+        } else {
+            return Cast::make(t, e);
+        }
+    }
+
+    template<typename Op>
+    Expr visit_binop(const Op *op) {
+        if (needs_widening(op->type)) {
+            Expr e = Op::make(widen(mutate(op->a)), widen(mutate(op->b)));
+            return lower_cast(op->type, e);
+        }
+        return IRMutator2::visit(op);
+    }
+
+    template<typename Op>
+    Expr visit_cmp(const Op *op) {
+        if (needs_widening(op->a.type())) {
+            return Op::make(widen(mutate(op->a)), widen(mutate(op->b)));
+        }
+        return IRMutator2::visit(op);
+    }
+
+    Expr visit(const Add *op) override { return visit_binop(op); }
+    Expr visit(const Sub *op) override { return visit_binop(op); }
+    Expr visit(const Mul *op) override { return visit_binop(op); }
+    Expr visit(const Div *op) override { return visit_binop(op); }
+    Expr visit(const Mod *op) override { return visit_binop(op); }
+    Expr visit(const Min *op) override { return visit_binop(op); }
+    Expr visit(const Max *op) override { return visit_binop(op); }
+
+    Expr visit(const EQ *op) override { return visit_cmp(op); }
+    Expr visit(const NE *op) override { return visit_cmp(op); }
+    Expr visit(const LT *op) override { return visit_cmp(op); }
+    Expr visit(const LE *op) override { return visit_cmp(op); }
+    Expr visit(const GT *op) override { return visit_cmp(op); }
+    Expr visit(const GE *op) override { return visit_cmp(op); }
+
+    Expr visit(const Cast *op) override {
+        if (op->type.is_bfloat() || op->value.type().is_bfloat()) {
+            return lower_cast(op->type, mutate(op->value));
+        }
+        return IRMutator2::visit(op);
+    }
+
+    Expr visit(const Call *op) override {
+        // Math functions on float16 call externs like sqrt_f16, which
+        // the runtime doesn't provide; route them through the float32
+        // versions.
+        if (op->call_type == Call::PureExtern &&
+            needs_widening(op->type) &&
+            ends_with(op->name, "_f16")) {
+            std::vector<Expr> new_args;
+            for (const Expr &arg : op->args) {
+                new_args.push_back(widen(mutate(arg)));
+            }
+            string f32_name = op->name.substr(0, op->name.size() - 4) + "_f32";
+            Expr e = Call::make(Float(32, op->type.lanes()), f32_name,
+                                new_args, Call::PureExtern);
+            return lower_cast(op->type, e);
+        }
+        return IRMutator2::visit(op);
+    }
+
+public:
+    bool widen_float16;
+
+    EmulateFloat16Math(bool widen_float16) : widen_float16(widen_float16) {}
+};
+
+}  // namespace
+
+Stmt emulate_float16_math(const Stmt &s, const Target &t) {
+    // ARMv8.2 with the fp16 arithmetic extension can do float16 math
+    // directly; everything else widens to float32. bfloat16 math is
+    // always widened, as no LLVM version we support has native
+    // bfloat arithmetic.
+    bool native_float16 = (t.arch == Target::ARM &&
+                           t.bits == 64 &&
+                           t.has_feature(Target::ARMFp16));
+    return EmulateFloat16Math(!native_float16).mutate(s);
+}
+
+}
+}
@@ -0,0 +1,31 @@
+#ifndef HALIDE_EMULATE_FLOAT16_MATH_H
+#define HALIDE_EMULATE_FLOAT16_MATH_H
+
+/** \file
+ *
+ * Defines a pass that rewrites math on 16-bit floating point types
+ * into math on 32-bit float, so that narrow float types work as
+ * storage types on every backend.
+ */
+
+#include "IR.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Rewrite arithmetic, comparisons, and casts involving bfloat16 (and
+ * float16, on targets without native half-precision arithmetic) to
+ * widen the operands to float32, compute, and round the result back
+ * down. Conversions to and from bfloat16 become bit manipulation on
+ * uint16/uint32, so after this pass bfloat16 values only flow through
+ * type-agnostic operations (loads, stores, selects, shuffles,
+ * reinterprets) and codegen can treat them as 16-bit integers. The
+ * rewrites vectorize cleanly: a widened vector op stays a single
+ * vector op at twice the bit width. */
+EXPORT Stmt emulate_float16_math(const Stmt &s, const Target &t);
+
+}
+}
+
+#endif
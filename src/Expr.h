@@ -5,6 +5,7 @@
  * Base classes for Halide expressions (\ref Halide::Expr) and statements (\ref Halide::Internal::Stmt)
  */
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -75,9 +76,18 @@ struct IRNode {
      * visitors.
      */
     virtual void accept(IRVisitor *v) const = 0;
-    IRNode(IRNodeType t) : node_type(t) {}
+    IRNode(IRNodeType t) : node_type(t), structural_hash_cache(0) {}
     virtual ~IRNode() {}
 
+    /** IR nodes are created and destroyed in enormous numbers while
+     * lowering, so their storage is recycled through a pool (see
+     * IR.cpp) rather than handed back to the global allocator on
+     * every deletion. */
+    // @{
+    EXPORT static void *operator new(size_t size);
+    EXPORT static void operator delete(void *ptr);
+    // @}
+
     /** These classes are all managed with intrusive reference
      * counting, so we also track a reference count. It's mutable
      * so that we can do reference counting even through const
@@ -96,6 +106,14 @@ struct IRNode {
      * anyway, so this doesn't increase the memory footprint of an IR node.
      */
     IRNodeType node_type;
+
+    /** A lazily-computed hash of the node's value, used by
+     * structural_hash in IREquality to make repeated deep comparisons
+     * cheap. Zero means not yet computed. Nodes are immutable once
+     * constructed, so the cache never goes stale; it is atomic
+     * because nodes (especially the interned immediates) are shared
+     * across threads, and a racing first use must not tear. */
+    mutable std::atomic<uint64_t> structural_hash_cache;
 };
 
 template<>
@@ -193,6 +211,27 @@ struct IntImm : public ExprNode<IntImm> {
         // Then sign-extending to get them back
         value >>= (64 - t.bits());
 
+        // The same few small constants are made over and over during
+        // lowering. Intern them so they are allocated once and
+        // equality on them is pointer equality.
+        if (t.bits() == 32 && value >= -16 && value <= 256) {
+            static struct Cache {
+                const IntImm *c[273];
+                Cache() {
+                    for (int i = 0; i < 273; i++) {
+                        IntImm *node = new IntImm;
+                        node->type = Int(32);
+                        node->value = i - 16;
+                        // These nodes live forever; hold a reference
+                        // so handles to them never free them.
+                        node->ref_count.increment();
+                        c[i] = node;
+                    }
+                }
+            } cache;
+            return cache.c[value + 16];
+        }
+
         IntImm *node = new IntImm;
         node->type = t;
         node->value = value;
@@ -216,6 +255,40 @@ struct UIntImm : public ExprNode<UIntImm> {
         value <<= (64 - t.bits());
         value >>= (64 - t.bits());
 
+        if (t.bits() == 1) {
+            // Interned true and false, used by every condition that
+            // simplifies to a constant.
+            static struct BoolCache {
+                const UIntImm *c[2];
+                BoolCache() {
+                    for (int i = 0; i < 2; i++) {
+                        UIntImm *node = new UIntImm;
+                        node->type = UInt(1);
+                        node->value = i;
+                        node->ref_count.increment();
+                        c[i] = node;
+                    }
+                }
+            } bool_cache;
+            return bool_cache.c[value];
+        }
+
+        if (t.bits() == 32 && value <= 256) {
+            static struct Cache {
+                const UIntImm *c[257];
+                Cache() {
+                    for (int i = 0; i < 257; i++) {
+                        UIntImm *node = new UIntImm;
+                        node->type = UInt(32);
+                        node->value = i;
+                        node->ref_count.increment();
+                        c[i] = node;
+                    }
+                }
+            } cache;
+            return cache.c[value];
+        }
+
         UIntImm *node = new UIntImm;
         node->type = t;
         node->value = value;
@@ -338,6 +411,25 @@ const DeviceAPI all_device_apis[] = {DeviceAPI::None,
                                      DeviceAPI::Metal,
                                      DeviceAPI::Hexagon};
 
+/** An enum describing the memory an allocation should be placed
+ * in. Used by Func::store_in to override the compiler's stack/heap
+ * decision for a Func's realizations. */
+enum class MemoryType {
+    /** Let the compiler decide. Constant-sized allocations within the
+     * target's stack budget go on the stack; everything else goes on
+     * the heap. The default. */
+    Auto,
+
+    /** Always allocate on the heap with halide_malloc, even if the
+     * allocation is small and constant-sized. */
+    Heap,
+
+    /** Always allocate on the stack. The size must be a compile-time
+     * constant that fits within the target's stack budget, or an
+     * error is raised during lowering. */
+    Stack
+};
+
 namespace Internal {
 
 /** An enum describing a type of loop traversal. Used in schedules, and in
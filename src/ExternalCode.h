@@ -40,7 +40,14 @@ public:
      * compare names for equality. To guarantee uniqueness in public
      * code, we suggest using a Java style inverted domain name
      * followed by organization specific naming. E.g.:
-     *     com.initech.y2k.5d2ac80aaf522eec6cb4b40f39fb923f9902bc7e */
+     *     com.initech.y2k.5d2ac80aaf522eec6cb4b40f39fb923f9902bc7e
+     *
+     * The bitcode is linked into the generated code before it is
+     * optimized, so small extern helpers defined in it can be inlined
+     * into the loops that call them. For the best chance of that, do
+     * not compile the bitcode with target features the pipeline's
+     * target lacks; llvm will refuse to inline across such a
+     * mismatch. */
     static ExternalCode bitcode_wrapper(const Target &cpu_type, const std::vector<uint8_t> &code, const std::string &name) {
         return ExternalCode(LLVMBitcode, cpu_type, DeviceAPI::None, code, name);
     }
@@ -4,6 +4,7 @@
 
 #include <limits>
 #include <cmath>
+#include <cstring>
 
 namespace Halide {
 namespace Internal {
@@ -429,4 +430,87 @@ uint16_t float16_t::to_bits() const {
     return data;
 }
 
+namespace {
+
+// bfloat16 is the top 16 bits of a binary32, so conversions are bit
+// manipulation. Rounding is to nearest with ties going to even; NaN
+// payloads that would round to infinity are fixed up afterwards.
+uint16_t float_to_bfloat(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if (std::isnan(value)) {
+        // Keep NaNs NaN: force a mantissa bit that survives truncation.
+        return (uint16_t)((bits >> 16) | 0x0040);
+    }
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return (uint16_t)(bits >> 16);
+}
+
+float bfloat_to_float(uint16_t value) {
+    uint32_t bits = ((uint32_t)value) << 16;
+    float result;
+    memcpy(&result, &bits, sizeof(bits));
+    return result;
+}
+
+}  // namespace
+
+bfloat16_t::bfloat16_t(float value) : data(float_to_bfloat(value)) {}
+
+bfloat16_t::bfloat16_t(double value) : data(float_to_bfloat((float)value)) {}
+
+bfloat16_t::bfloat16_t(int value) : data(float_to_bfloat((float)value)) {}
+
+bfloat16_t::bfloat16_t() : data(0) {}
+
+bfloat16_t::operator float() const {
+    return bfloat_to_float(data);
+}
+
+bfloat16_t::operator double() const {
+    return bfloat_to_float(data);
+}
+
+bfloat16_t bfloat16_t::make_from_bits(uint16_t bits) {
+    bfloat16_t result;
+    result.data = bits;
+    return result;
+}
+
+bfloat16_t bfloat16_t::operator-() const {
+    return make_from_bits(data ^ 0x8000);
+}
+
+bfloat16_t bfloat16_t::operator+(bfloat16_t rhs) const {
+    return bfloat16_t(bfloat_to_float(data) + bfloat_to_float(rhs.data));
+}
+
+bfloat16_t bfloat16_t::operator-(bfloat16_t rhs) const {
+    return bfloat16_t(bfloat_to_float(data) - bfloat_to_float(rhs.data));
+}
+
+bfloat16_t bfloat16_t::operator*(bfloat16_t rhs) const {
+    return bfloat16_t(bfloat_to_float(data) * bfloat_to_float(rhs.data));
+}
+
+bfloat16_t bfloat16_t::operator/(bfloat16_t rhs) const {
+    return bfloat16_t(bfloat_to_float(data) / bfloat_to_float(rhs.data));
+}
+
+bool bfloat16_t::operator==(bfloat16_t rhs) const {
+    return bfloat_to_float(data) == bfloat_to_float(rhs.data);
+}
+
+bool bfloat16_t::operator>(bfloat16_t rhs) const {
+    return bfloat_to_float(data) > bfloat_to_float(rhs.data);
+}
+
+bool bfloat16_t::operator<(bfloat16_t rhs) const {
+    return bfloat_to_float(data) < bfloat_to_float(rhs.data);
+}
+
+uint16_t bfloat16_t::to_bits() const {
+    return data;
+}
+
 }  // namespace halide
@@ -117,6 +117,72 @@ private:
 
 static_assert(sizeof(float16_t) == 2, "float16_t should occupy two bytes");
 
+/** Class that provides a type that implements half precision
+ *  floating point in the bfloat format (the most significant 16 bits
+ *  of an IEEE754 binary32) in software.
+ *
+ *  Like float16_t, this type is enforced to be 16-bits wide and
+ *  maintains no state other than the raw bits, so it can be passed to
+ *  code that checks a type's size and used for buffer_t allocation.
+ * */
+struct bfloat16_t {
+
+    /** Construct from a float, double, or int using
+     * round-to-nearest-ties-to-even. */
+    // @{
+    EXPORT explicit bfloat16_t(float value);
+    EXPORT explicit bfloat16_t(double value);
+    EXPORT explicit bfloat16_t(int value);
+    // @}
+
+    /** Construct a bfloat16_t with the bits initialised to 0. This
+     * represents positive zero.*/
+    EXPORT bfloat16_t();
+
+    // Use explicit to avoid accidently raising the precision
+    /** Cast to float */
+    EXPORT explicit operator float() const;
+    /** Cast to double */
+    EXPORT explicit operator double() const;
+
+    EXPORT bfloat16_t(const bfloat16_t&) = default;
+    EXPORT bfloat16_t& operator=(const bfloat16_t&) = default;
+
+    /** Get a new bfloat16_t with the given raw bits */
+    EXPORT static bfloat16_t make_from_bits(uint16_t bits);
+
+    /** Return a new bfloat16_t with a negated sign bit*/
+    EXPORT bfloat16_t operator-() const;
+
+    /** Arithmetic operators. Compute in single precision and round
+     * the result. */
+    // @{
+    EXPORT bfloat16_t operator+(bfloat16_t rhs) const;
+    EXPORT bfloat16_t operator-(bfloat16_t rhs) const;
+    EXPORT bfloat16_t operator*(bfloat16_t rhs) const;
+    EXPORT bfloat16_t operator/(bfloat16_t rhs) const;
+    // @}
+
+    /** Comparison operators */
+    // @{
+    EXPORT bool operator==(bfloat16_t rhs) const;
+    EXPORT bool operator!=(bfloat16_t rhs) const { return !(*this == rhs); }
+    EXPORT bool operator>(bfloat16_t rhs) const;
+    EXPORT bool operator<(bfloat16_t rhs) const;
+    EXPORT bool operator>=(bfloat16_t rhs) const { return (*this > rhs) || (*this == rhs); }
+    EXPORT bool operator<=(bfloat16_t rhs) const { return (*this < rhs) || (*this == rhs); }
+    // @}
+
+    /** Returns the bits that represent this bfloat16_t. */
+    EXPORT uint16_t to_bits() const;
+
+private:
+    // The raw bits.
+    uint16_t data;
+};
+
+static_assert(sizeof(bfloat16_t) == 2, "bfloat16_t should occupy two bytes");
+
 }  // namespace Halide
 
 template<>
@@ -124,4 +190,9 @@ HALIDE_ALWAYS_INLINE halide_type_t halide_type_of<Halide::float16_t>() {
     return halide_type_t(halide_type_float, 16);
 }
 
+template<>
+HALIDE_ALWAYS_INLINE halide_type_t halide_type_of<Halide::bfloat16_t>() {
+    return halide_type_t(halide_type_bfloat, 16);
+}
+
 #endif
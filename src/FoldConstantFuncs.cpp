@@ -0,0 +1,213 @@
+#include <algorithm>
+
+#include "FoldConstantFuncs.h"
+#include "Buffer.h"
+#include "Debug.h"
+#include "Function.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+#include "Scope.h"
+#include "Simplify.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// The largest number of elements we're prepared to evaluate at
+// compile time. Beyond this the table starts to bloat the object file
+// and the time spent folding becomes noticeable.
+const int64_t max_fold_size = 64 * 1024;
+
+// Check whether an expression stands a chance of being evaluated at
+// compile time: it may only reference the function's pure arguments,
+// let-bound names, and calls that the simplifier might fold. Calls to
+// other functions, images, and parameters all depend on state not
+// available until runtime.
+class CouldFoldAtCompileTime : public IRVisitor {
+    using IRVisitor::visit;
+
+    const vector<string> &args;
+    Scope<int> lets;
+
+    void visit(const Variable *op) override {
+        if (op->param.defined() || op->image.defined()) {
+            result = false;
+            return;
+        }
+        if (lets.contains(op->name)) {
+            return;
+        }
+        if (std::find(args.begin(), args.end(), op->name) == args.end()) {
+            result = false;
+        }
+    }
+
+    void visit(const Call *op) override {
+        if (op->call_type == Call::Halide ||
+            op->call_type == Call::Image ||
+            op->param.defined() ||
+            op->image.defined() ||
+            !op->is_pure()) {
+            result = false;
+            return;
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Let *op) override {
+        op->value.accept(this);
+        ScopedBinding<int> bind(lets, op->name, 0);
+        op->body.accept(this);
+    }
+
+public:
+    bool result = true;
+
+    CouldFoldAtCompileTime(const vector<string> &args) : args(args) {}
+};
+
+// Write a constant scalar into a buffer at the given zero-based
+// coordinates. Returns false if the expression isn't a constant of
+// the buffer's type.
+bool write_constant(Buffer<> &buf, const vector<int> &coords, Expr value) {
+    Type t = buf.type();
+    internal_assert(value.type() == t);
+
+    ptrdiff_t offset = 0;
+    for (size_t i = 0; i < coords.size(); i++) {
+        offset += (ptrdiff_t)coords[i] * buf.raw_buffer()->dim[i].stride;
+    }
+    uint8_t *addr = (uint8_t *)buf.data() + offset * t.bytes();
+
+    if (const IntImm *imm = value.as<IntImm>()) {
+        switch (t.bits()) {
+        case 8:  *(int8_t  *)addr = (int8_t)imm->value;  return true;
+        case 16: *(int16_t *)addr = (int16_t)imm->value; return true;
+        case 32: *(int32_t *)addr = (int32_t)imm->value; return true;
+        case 64: *(int64_t *)addr = imm->value;          return true;
+        }
+    } else if (const UIntImm *imm = value.as<UIntImm>()) {
+        switch (t.bits()) {
+        case 8:  *(uint8_t  *)addr = (uint8_t)imm->value;  return true;
+        case 16: *(uint16_t *)addr = (uint16_t)imm->value; return true;
+        case 32: *(uint32_t *)addr = (uint32_t)imm->value; return true;
+        case 64: *(uint64_t *)addr = imm->value;           return true;
+        }
+    } else if (const FloatImm *imm = value.as<FloatImm>()) {
+        switch (t.bits()) {
+        case 32: *(float  *)addr = (float)imm->value; return true;
+        case 64: *(double *)addr = imm->value;        return true;
+        }
+    }
+    return false;
+}
+
+bool fold_function(Function f) {
+    if (f.has_update_definition() ||
+        f.has_extern_definition() ||
+        f.outputs() != 1 ||
+        !f.definition().specializations().empty() ||
+        f.is_tracing_loads() ||
+        f.is_tracing_stores() ||
+        f.is_tracing_realizations()) {
+        return false;
+    }
+
+    Type t = f.output_types()[0];
+    if (t.lanes() != 1 ||
+        t.is_handle() ||
+        t.bits() < 8 ||
+        (t.is_float() && t.bits() < 32)) {
+        return false;
+    }
+
+    // Every dimension must be bounded to a constant region via
+    // Func::bound; otherwise we don't know how big to make the table.
+    const vector<string> &args = f.args();
+    vector<int> mins(args.size()), extents(args.size());
+    int64_t size = 1;
+    for (size_t i = 0; i < args.size(); i++) {
+        bool found = false;
+        for (const Bound &b : f.schedule().bounds()) {
+            const int64_t *min = b.min.defined() ? as_const_int(b.min) : nullptr;
+            const int64_t *extent = b.extent.defined() ? as_const_int(b.extent) : nullptr;
+            if (b.var == args[i] && min && extent) {
+                mins[i] = (int)*min;
+                extents[i] = (int)*extent;
+                found = true;
+                break;
+            }
+        }
+        if (!found || extents[i] <= 0) {
+            return false;
+        }
+        size *= extents[i];
+        if (size > max_fold_size) {
+            return false;
+        }
+    }
+
+    Expr value = f.definition().values()[0];
+    CouldFoldAtCompileTime check(args);
+    value.accept(&check);
+    if (!check.result) {
+        return false;
+    }
+
+    // Evaluate every element. If any fails to simplify down to a
+    // constant (e.g. it calls a math function the simplifier doesn't
+    // fold), give up on the whole function.
+    Buffer<> table(t, extents, f.name() + ".constant_table");
+    vector<int> coords(args.size(), 0);
+    for (int64_t idx = 0; idx < size; idx++) {
+        map<string, Expr> bindings;
+        for (size_t i = 0; i < args.size(); i++) {
+            bindings[args[i]] = mins[i] + coords[i];
+        }
+        Expr e = simplify(substitute(bindings, value));
+        if (!write_constant(table, coords, e)) {
+            return false;
+        }
+        for (size_t i = 0; i < args.size(); i++) {
+            coords[i]++;
+            if (coords[i] < extents[i]) {
+                break;
+            }
+            coords[i] = 0;
+        }
+    }
+    for (size_t i = 0; i < args.size(); i++) {
+        table.translate((int)i, mins[i]);
+    }
+
+    // Redefine the function as a load from the table. The table is a
+    // raw Buffer, so lowering will embed it in the generated code as
+    // read-only data.
+    vector<Expr> call_args;
+    for (const string &arg : args) {
+        call_args.push_back(Variable::make(Int(32), arg));
+    }
+    f.definition().values()[0] = Call::make(table, call_args);
+    return true;
+}
+
+}  // namespace
+
+void fold_constant_funcs(map<string, Function> &env) {
+    for (auto &iter : env) {
+        Function f(iter.second);
+        if (fold_function(f)) {
+            debug(1) << "Folded constant function " << f.name()
+                     << " into a compile-time table\n";
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,30 @@
+#ifndef HALIDE_FOLD_CONSTANT_FUNCS_H
+#define HALIDE_FOLD_CONSTANT_FUNCS_H
+
+/** \file
+ *
+ * Defines a pass that evaluates functions whose values are entirely
+ * known at compile time and replaces their definitions with loads
+ * from constant tables embedded in the generated code.
+ */
+
+#include <map>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Replace the definitions of functions that are pure, bounded to a
+ * constant region in every dimension via Func::bound, and defined
+ * entirely in terms of constants, with loads from a table of their
+ * values computed at compile time. The table is embedded in the
+ * generated object as read-only data, so lookup tables of this form
+ * cost no compute at runtime. Functions for which the values cannot
+ * be folded are left untouched. */
+EXPORT void fold_constant_funcs(std::map<std::string, Function> &env);
+
+}
+}
+
+#endif
@@ -170,6 +170,30 @@ void Func::define_extern(const std::string &function_name,
                        mangling, device_api, uses_old_buffer_t);
 }
 
+Func &Func::extern_preserves_buffer_state(bool preserves) {
+    user_assert(func.has_extern_definition())
+        << "Can't declare extern_preserves_buffer_state on Func \"" << name()
+        << "\" because it has no extern definition.\n";
+    func.extern_definition_preserves_buffer_state() = preserves;
+    return *this;
+}
+
+Func &Func::extern_requires_resident_inputs(bool resident) {
+    user_assert(func.has_extern_definition())
+        << "Can't declare extern_requires_resident_inputs on Func \"" << name()
+        << "\" because it has no extern definition.\n";
+    func.extern_definition_requires_resident_inputs() = resident;
+    return *this;
+}
+
+Func &Func::extern_requires_dense_buffers(bool dense) {
+    user_assert(func.has_extern_definition())
+        << "Can't declare extern_requires_dense_buffers on Func \"" << name()
+        << "\" because it has no extern definition.\n";
+    func.extern_definition_requires_dense_buffers() = dense;
+    return *this;
+}
+
 /** Get the types of the buffers returned by an extern definition. */
 const std::vector<Type> &Func::output_types() const {
     return func.output_types();
@@ -283,23 +307,45 @@ void Stage::set_dim_type(VarOrRVar var, ForType t) {
             found = true;
             dims[i].for_type = t;
 
+            // Atomic updates are lowered to scalar atomic
+            // read-modify-write instructions, so their loops can be
+            // parallelized but not vectorized. The same goes for
+            // scatter-buffered updates, which flush with atomics.
+            user_assert(!((definition.schedule().atomic() ||
+                           definition.schedule().scatter_buffer_slots() > 0) &&
+                          t == ForType::Vectorized))
+                << "In schedule for " << stage_name
+                << ", cannot vectorize var " << var.name()
+                << " because the definition is marked atomic() or"
+                << " scatter_buffered()."
+                << " Such updates may be parallelized but not vectorized.\n";
+
             // If it's an rvar and the for type is parallel, we need to
             // validate that this doesn't introduce a race condition.
             if (!dims[i].is_pure() && var.is_rvar &&
                 (t == ForType::Vectorized || t == ForType::Parallel ||
                  t == ForType::GPUBlock || t == ForType::GPUThread)) {
-                user_assert(definition.schedule().allow_race_conditions())
-                    << "In schedule for " << stage_name
-                    << ", marking var " << var.name()
-                    << " as parallel or vectorized may introduce a race"
-                    << " condition resulting in incorrect output."
-                    << " It is possible to override this error using"
-                    << " the allow_race_conditions() method. Use this"
-                    << " with great caution, and only when you are willing"
-                    << " to accept non-deterministic output, or you can prove"
-                    << " that any race conditions in this code do not change"
-                    << " the output, or you can prove that there are actually"
-                    << " no race conditions, and that Halide is being too cautious.\n";
+                if (definition.schedule().atomic() ||
+                    definition.schedule().scatter_buffer_slots() > 0) {
+                    // Atomic read-modify-writes make the races
+                    // benign, whether issued per point or when a
+                    // write-combining buffer slot is flushed.
+                } else {
+                    user_assert(definition.schedule().allow_race_conditions())
+                        << "In schedule for " << stage_name
+                        << ", marking var " << var.name()
+                        << " as parallel or vectorized may introduce a race"
+                        << " condition resulting in incorrect output."
+                        << " It is possible to override this error using"
+                        << " the allow_race_conditions() method. Use this"
+                        << " with great caution, and only when you are willing"
+                        << " to accept non-deterministic output, or you can prove"
+                        << " that any race conditions in this code do not change"
+                        << " the output, or you can prove that there are actually"
+                        << " no race conditions, and that Halide is being too cautious.\n"
+                        << " If the update is a simple scatter reduction (e.g."
+                        << " a histogram), consider the atomic() method instead.\n";
+                }
             }
 
         } else if (t == ForType::Vectorized) {
@@ -895,6 +941,20 @@ void Stage::split(const string &old, const string &outer, const string &inner, E
              << outer << " and " << inner << " with factor of " << factor << "\n";
     vector<Dim> &dims = definition.schedule().dims();
 
+    // The factor may be a runtime expression (e.g. a Param, or
+    // derived from the output extents), but it must be a pure int.
+    user_assert(factor.defined())
+        << "In schedule for " << stage_name
+        << ", split factor for " << old << " is undefined\n";
+    user_assert(factor.type().is_int())
+        << "In schedule for " << stage_name
+        << ", split factor for " << old
+        << " must be an integer, but has type " << factor.type() << "\n";
+    user_assert(is_pure(factor))
+        << "In schedule for " << stage_name
+        << ", split factor for " << old
+        << " must be a pure expression: " << factor << "\n";
+
     // Check that the new names aren't already in the dims list.
     for (size_t i = 0; i < dims.size(); i++) {
         string new_names[2] = {inner, outer};
@@ -990,9 +1050,10 @@ void Stage::split(const string &old, const string &outer, const string &inner, E
     }
 
     if (exact) {
-        user_assert(tail == TailStrategy::GuardWithIf)
+        user_assert(tail == TailStrategy::GuardWithIf ||
+                    tail == TailStrategy::Predicate)
             << "When splitting Var " << old_name
-            << " the tail strategy must be GuardWithIf or Auto. "
+            << " the tail strategy must be GuardWithIf, Predicate, or Auto. "
             << "Anything else may change the meaning of the algorithm\n";
     }
 
@@ -1367,6 +1428,32 @@ Stage &Stage::allow_race_conditions() {
     return *this;
 }
 
+Stage &Stage::skip_where(Expr condition) {
+    user_assert(condition.defined())
+        << "In schedule for " << name()
+        << ", the condition passed to skip_where is undefined.\n";
+    user_assert(condition.type().is_bool())
+        << "In schedule for " << name()
+        << ", the condition passed to skip_where must be of type bool, "
+        << "but has type " << condition.type() << "\n";
+    definition.predicate() = definition.predicate() && condition;
+    return *this;
+}
+
+Stage &Stage::atomic() {
+    definition.schedule().atomic() = true;
+    return *this;
+}
+
+Stage &Stage::scatter_buffered(int buffer_slots) {
+    user_assert(buffer_slots >= 2 && ((buffer_slots & (buffer_slots - 1)) == 0))
+        << "In schedule for " << name()
+        << ", the number of scatter_buffered slots must be a power of"
+        << " two of at least two, but is " << buffer_slots << "\n";
+    definition.schedule().scatter_buffer_slots() = buffer_slots;
+    return *this;
+}
+
 Stage &Stage::serial(VarOrRVar var) {
     set_dim_type(var, ForType::Serial);
     return *this;
@@ -1449,7 +1536,8 @@ Stage &Stage::tile(VarOrRVar x, VarOrRVar y,
 
 namespace {
 // An helper function for reordering vars in a schedule.
-void reorder_vars(vector<Dim> &dims_old, const VarOrRVar *vars, size_t size, const Stage &stage) {
+void reorder_vars(vector<Dim> &dims_old, const VarOrRVar *vars, size_t size, const Stage &stage,
+                  const Definition &definition) {
     vector<Dim> dims = dims_old;
 
     // Tag all the vars with their locations in the dims list.
@@ -1469,18 +1557,40 @@ void reorder_vars(vector<Dim> &dims_old, const VarOrRVar *vars, size_t size, con
             << stage.dump_argument_list();
     }
 
-    // Look for illegal reorderings
+    // Look for illegal reorderings. Reordering the reduction
+    // variables of an update definition relative to one another
+    // changes the order in which the reduction is applied, which is
+    // only legal if the update is provably associative and
+    // commutative (the same condition rfactor requires). Only run the
+    // prover if such a reordering is actually requested.
+    bool associativity_checked = false, associativity_proven = false;
     for (size_t i = 0; i < idx.size(); i++) {
         if (dims[idx[i]].is_pure()) continue;
         for (size_t j = i+1; j < idx.size(); j++) {
             if (dims[idx[j]].is_pure()) continue;
 
             if (idx[i] > idx[j]) {
-                user_error
-                    << "In schedule for " << stage.name()
-                    << ", can't reorder RVars " << vars[i].name()
-                    << " and " << vars[j].name()
-                    << " because it may change the meaning of the algorithm.\n";
+                if (!associativity_checked) {
+                    associativity_checked = true;
+                    if (!definition.is_init()) {
+                        vector<std::string> tmp = split_string(stage.name(), ".update(");
+                        internal_assert(!tmp.empty() && !tmp[0].empty());
+                        const auto &prover_result =
+                            prove_associativity(tmp[0], definition.args(), definition.values());
+                        associativity_proven =
+                            prover_result.associative() && prover_result.commutative();
+                    }
+                }
+                if (!associativity_proven) {
+                    user_error
+                        << "In schedule for " << stage.name()
+                        << ", can't reorder RVars " << vars[i].name()
+                        << " and " << vars[j].name()
+                        << " because it may change the meaning of the algorithm. "
+                        << "Reordering RVars relative to one another is only "
+                        << "allowed when the update definition is provably "
+                        << "associative and commutative.\n";
+                }
             }
         }
     }
@@ -1498,7 +1608,7 @@ void reorder_vars(vector<Dim> &dims_old, const VarOrRVar *vars, size_t size, con
 }
 
 Stage &Stage::reorder(const std::vector<VarOrRVar>& vars) {
-    reorder_vars(definition.schedule().dims(), &vars[0], vars.size(), *this);
+    reorder_vars(definition.schedule().dims(), &vars[0], vars.size(), *this, definition);
     return *this;
 }
 
@@ -1720,14 +1830,16 @@ Stage &Stage::hexagon(VarOrRVar x) {
     return *this;
 }
 
-Stage &Stage::prefetch(const Func &f, VarOrRVar var, Expr offset, PrefetchBoundStrategy strategy) {
-    PrefetchDirective prefetch = {f.name(), var.name(), offset, strategy, Parameter()};
+Stage &Stage::prefetch(const Func &f, VarOrRVar var, Expr offset, PrefetchBoundStrategy strategy,
+                       Expr bytes_per_fetch) {
+    PrefetchDirective prefetch = {f.name(), var.name(), offset, strategy, bytes_per_fetch, Parameter()};
     definition.schedule().prefetches().push_back(prefetch);
     return *this;
 }
 
-Stage &Stage::prefetch(const Internal::Parameter &param, VarOrRVar var, Expr offset, PrefetchBoundStrategy strategy) {
-    PrefetchDirective prefetch = {param.name(), var.name(), offset, strategy, param};
+Stage &Stage::prefetch(const Internal::Parameter &param, VarOrRVar var, Expr offset, PrefetchBoundStrategy strategy,
+                       Expr bytes_per_fetch) {
+    PrefetchDirective prefetch = {param.name(), var.name(), offset, strategy, bytes_per_fetch, param};
     definition.schedule().prefetches().push_back(prefetch);
     return *this;
 }
@@ -1926,12 +2038,108 @@ Func &Func::allow_race_conditions() {
     return *this;
 }
 
+Func &Func::atomic() {
+    invalidate_cache();
+    user_assert(num_update_definitions() > 0)
+        << "Func " << name() << " has no update definitions to mark as"
+        << " atomic. Call atomic() after defining the updates.\n";
+    // Atomicity is a property of the scatter updates, so mark every
+    // update definition.
+    for (int i = 0; i < num_update_definitions(); i++) {
+        func.update(i).schedule().atomic() = true;
+    }
+    return *this;
+}
+
+Func &Func::scatter_buffered(int buffer_slots) {
+    invalidate_cache();
+    user_assert(num_update_definitions() > 0)
+        << "Func " << name() << " has no update definitions to mark as"
+        << " scatter_buffered. Call scatter_buffered() after defining"
+        << " the updates.\n";
+    user_assert(buffer_slots >= 2 && ((buffer_slots & (buffer_slots - 1)) == 0))
+        << "In schedule for " << name()
+        << ", the number of scatter_buffered slots must be a power of"
+        << " two of at least two, but is " << buffer_slots << "\n";
+    for (int i = 0; i < num_update_definitions(); i++) {
+        func.update(i).schedule().scatter_buffer_slots() = buffer_slots;
+    }
+    return *this;
+}
+
+Func &Func::skip_where(Expr condition) {
+    invalidate_cache();
+    Stage(func.definition(), name(), args(), func.schedule()).skip_where(condition);
+    return *this;
+}
+
 Func &Func::memoize() {
     invalidate_cache();
+    user_assert(!func.schedule().store_interleaved())
+        << "Can't call memoize on Func \"" << name()
+        << "\" because it is scheduled with store_interleaved, and the "
+        << "cache stores one buffer per Tuple element.\n";
     func.schedule().memoized() = true;
     return *this;
 }
 
+Func &Func::async() {
+    invalidate_cache();
+    func.schedule().async() = true;
+    return *this;
+}
+
+Func &Func::store_forwarding() {
+    invalidate_cache();
+    func.schedule().store_forwarding() = true;
+    return *this;
+}
+
+Func &Func::store_non_temporal() {
+    invalidate_cache();
+    func.schedule().store_non_temporal() = true;
+    return *this;
+}
+
+Func &Func::software_pipeline(int stage_count) {
+    user_assert(stage_count == 2)
+        << "Only two-stage software pipelining (loads one iteration "
+        << "ahead) is currently implemented.\n";
+    invalidate_cache();
+    func.schedule().software_pipeline() = true;
+    return *this;
+}
+
+Func &Func::skip_strips(VarOrRVar var, Expr skip) {
+    user_assert(skip.defined())
+        << "skip_strips() called with an undefined predicate\n";
+    user_assert(skip.type().is_bool() && skip.type().is_scalar())
+        << "The predicate passed to skip_strips() must be a scalar boolean\n";
+    user_assert(func.schedule().skip_strips_var().empty() ||
+                func.schedule().skip_strips_var() == var.name())
+        << "Func " << name() << " already has a skip_strips() predicate on "
+        << func.schedule().skip_strips_var() << "; only one loop may be guarded\n";
+    invalidate_cache();
+    func.schedule().skip_strips_var() = var.name();
+    func.schedule().skip_strips_predicate() = std::move(skip);
+    return *this;
+}
+
+Func &Func::store_in(MemoryType t) {
+    invalidate_cache();
+    func.schedule().memory_type() = t;
+    return *this;
+}
+
+Func &Func::stream_readback(int slices) {
+    user_assert(slices >= 1)
+        << "In schedule for " << name()
+        << ", stream_readback requires at least one slice.\n";
+    invalidate_cache();
+    func.schedule().stream_readback_slices() = slices;
+    return *this;
+}
+
 Stage Func::specialize(Expr c) {
     invalidate_cache();
     return Stage(func.definition(), name(), args(), func.schedule()).specialize(c);
@@ -2270,15 +2478,23 @@ Func &Func::hexagon(VarOrRVar x) {
     return *this;
 }
 
-Func &Func::prefetch(const Func &f, VarOrRVar var, Expr offset, PrefetchBoundStrategy strategy) {
+Func &Func::prefetch(const Func &f, VarOrRVar var, Expr offset, PrefetchBoundStrategy strategy,
+                     Expr bytes_per_fetch) {
     invalidate_cache();
-    Stage(func.definition(), name(), args(), func.schedule()).prefetch(f, var, offset, strategy);
+    Stage(func.definition(), name(), args(), func.schedule()).prefetch(f, var, offset, strategy, bytes_per_fetch);
     return *this;
 }
 
-Func &Func::prefetch(const Internal::Parameter &param, VarOrRVar var, Expr offset, PrefetchBoundStrategy strategy) {
+Func &Func::prefetch(const Internal::Parameter &param, VarOrRVar var, Expr offset, PrefetchBoundStrategy strategy,
+                     Expr bytes_per_fetch) {
     invalidate_cache();
-    Stage(func.definition(), name(), args(), func.schedule()).prefetch(param, var, offset, strategy);
+    Stage(func.definition(), name(), args(), func.schedule()).prefetch(param, var, offset, strategy, bytes_per_fetch);
+    return *this;
+}
+
+Func &Func::auto_prefetch() {
+    invalidate_cache();
+    func.schedule().auto_prefetch() = true;
     return *this;
 }
 
@@ -2336,6 +2552,56 @@ Func &Func::align_storage(Var dim, Expr alignment) {
     return *this;
 }
 
+Func &Func::store_tiled(Var x, Var y, Expr x_tile, Expr y_tile) {
+    invalidate_cache();
+
+    user_assert(x.name() != y.name())
+        << "store_tiled must be given two distinct dimensions.\n";
+
+    vector<StorageDim> &dims = func.schedule().storage_dims();
+    bool found_x = false, found_y = false;
+    for (size_t i = 0; i < dims.size(); i++) {
+        if (var_name_match(dims[i].var, x.name())) {
+            dims[i].tile_extent = x_tile;
+            found_x = true;
+        } else if (var_name_match(dims[i].var, y.name())) {
+            dims[i].tile_extent = y_tile;
+            found_y = true;
+        }
+    }
+    user_assert(found_x) << "Could not find variable " << x.name()
+                         << " to tile the storage of.\n";
+    user_assert(found_y) << "Could not find variable " << y.name()
+                         << " to tile the storage of.\n";
+    return *this;
+}
+
+Func &Func::store_interleaved() {
+    invalidate_cache();
+
+    user_assert(defined())
+        << "Can't call store_interleaved on Func \"" << name()
+        << "\" because it does not have a definition.\n";
+    user_assert(func.outputs() > 1)
+        << "Can't call store_interleaved on Func \"" << name()
+        << "\" because it is not Tuple-valued.\n";
+    user_assert(!func.schedule().memoized())
+        << "Can't call store_interleaved on Func \"" << name()
+        << "\" because it is memoized, and the cache stores one buffer "
+        << "per Tuple element.\n";
+    const vector<Type> &types = func.output_types();
+    for (size_t i = 1; i < types.size(); i++) {
+        user_assert(types[i] == types[0])
+            << "Can't call store_interleaved on Func \"" << name()
+            << "\" because its Tuple elements have different types ("
+            << types[0] << " vs " << types[i] << "); interleaved "
+            << "storage is a single allocation with a single element type.\n";
+    }
+
+    func.schedule().store_interleaved() = true;
+    return *this;
+}
+
 Func &Func::fold_storage(Var dim, Expr factor, bool fold_forward) {
     invalidate_cache();
 
@@ -2352,6 +2618,37 @@ Func &Func::fold_storage(Var dim, Expr factor, bool fold_forward) {
     return *this;
 }
 
+Func &Func::slide_over(Var var) {
+    invalidate_cache();
+    func.schedule().slide_over_loop() = var.name();
+    return *this;
+}
+
+Func &Func::compute_with(Func f, Var var) {
+    invalidate_cache();
+    user_assert(f.defined())
+        << "Func " << name() << " cannot be computed with undefined Func "
+        << f.name() << "\n";
+    user_assert(name() != f.name())
+        << "Func " << name() << " cannot be computed with itself\n";
+    bool found = false;
+    for (const Var &v : f.args()) {
+        found = found || (v.name() == var.name());
+    }
+    user_assert(found)
+        << "In schedule for " << name() << ", could not find var " << var.name()
+        << " among the pure variables of " << f.name() << "\n";
+    user_assert(f.function().schedule().compute_with_func().empty())
+        << "Func " << name() << " cannot be computed with " << f.name()
+        << ", which is itself computed with "
+        << f.function().schedule().compute_with_func()
+        << ". Chains of compute_with are not supported; compute both "
+        << "with the same sibling instead.\n";
+    func.schedule().compute_with_func() = f.name();
+    func.schedule().compute_with_var() = var.name();
+    return *this;
+}
+
 Func &Func::compute_at(LoopLevel loop_level) {
     invalidate_cache();
     func.schedule().compute_level() = loop_level;
@@ -2999,6 +3296,14 @@ void Func::realize(Realization dst, const Target &target) {
     pipeline().realize(dst, target);
 }
 
+Region Func::infer_stale_regions(const std::string &input, const Region &changed) {
+    return pipeline().infer_stale_regions(input, changed)[0];
+}
+
+void Func::realize_region(Realization dst, const Region &region, const Target &target) {
+    pipeline().realize_region(dst, region, target);
+}
+
 void Func::infer_input_bounds(Realization dst) {
     pipeline().infer_input_bounds(dst);
 }
@@ -286,16 +286,29 @@ public:
                            DeviceAPI device_api = DeviceAPI::Default_GPU);
 
     EXPORT Stage &allow_race_conditions();
+    EXPORT Stage &atomic();
+    EXPORT Stage &scatter_buffered(int buffer_slots = 256);
+
+    /** Guard this definition with a runtime condition, skipping the
+     * computation at points where it is false. See Func::skip_where.
+     * For update definitions over a reduction domain, RDom::where
+     * usually expresses this more directly; this form is useful for
+     * updates over the pure variables, which have no RDom to hang a
+     * predicate on. */
+    EXPORT Stage &skip_where(Expr condition);
 
     EXPORT Stage &hexagon(VarOrRVar x = Var::outermost());
     EXPORT Stage &prefetch(const Func &f, VarOrRVar var, Expr offset = 1,
-                           PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf);
+                           PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf,
+                           Expr bytes_per_fetch = Expr());
     EXPORT Stage &prefetch(const Internal::Parameter &param, VarOrRVar var, Expr offset = 1,
-                           PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf);
+                           PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf,
+                           Expr bytes_per_fetch = Expr());
     template<typename T>
     Stage &prefetch(const T &image, VarOrRVar var, Expr offset = 1,
-                    PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf) {
-        return prefetch(image.parameter(), var, offset, strategy);
+                    PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf,
+                    Expr bytes_per_fetch = Expr()) {
+        return prefetch(image.parameter(), var, offset, strategy, bytes_per_fetch);
     }
     // @}
 };
@@ -594,9 +607,35 @@ public:
      * function, strange things may happen, as the pipeline isn't
      * necessarily safe to run in-place. If you pass multiple buffers,
      * they must have matching sizes. This form of realize does *not*
-     * automatically copy data back from the GPU. */
+     * automatically copy data back from the GPU.
+     *
+     * The buffers may be crops of larger buffers (see
+     * Buffer::cropped): the function is evaluated over the crop's
+     * coordinate range directly into the parent allocation, with no
+     * staging copy. A crop of a buffer with a device allocation
+     * carries a device-side view of the same region where the device
+     * API supports it. */
     EXPORT void realize(Realization dst, const Target &target = Target());
 
+    /** Given a box of the named input (an ImageParam or input Buffer)
+     * whose values have changed, return a conservative box of this
+     * Func that is now stale and must be recomputed. Each Range of
+     * the changed region must have defined, though not necessarily
+     * constant, bounds. In the result, a Range with undefined bounds
+     * means the whole dimension is stale, and a Range with extent
+     * zero means nothing is. See Pipeline::infer_stale_regions. */
+    EXPORT Internal::Region infer_stale_regions(const std::string &input,
+                                                const Internal::Region &changed);
+
+    /** Evaluate this function over just the given region of the
+     * given output buffer, leaving the rest of the buffer untouched.
+     * The region must have constant integer bounds; trailing
+     * dimensions may be omitted or left undefined to cover the whole
+     * dimension. Together with infer_stale_regions this supports
+     * incrementally updating a realization when an input changes. */
+    EXPORT void realize_region(Realization dst, const Internal::Region &region,
+                               const Target &target = Target());
+
     /** For a given size of output, or a given output buffer,
      * determine the bounds required of all unbound ImageParams
      * referenced. Communicates the result by allocating new buffers
@@ -982,6 +1021,42 @@ public:
                               bool uses_old_buffer_t = false);
     // @}
 
+    /** Declare that the extern function called by this Func's extern
+     * definition only reads from its input buffers, only writes to
+     * its output buffers, and leaves the host/device dirty bits and
+     * any device allocation of every buffer passed to it in a correct
+     * state. By default, lowering must assume an extern stage may
+     * have modified any buffer it was handed, which forces
+     * conservative host/device copies around later uses of those
+     * buffers. With this declared, lowering keeps tracking buffer
+     * state across the call, so device-resident inputs stay
+     * device-resident and redundant copies are elided. An error if
+     * this Func has no extern definition. */
+    EXPORT Func &extern_preserves_buffer_state(bool preserves = true);
+
+    /** Declare that the extern function called by this Func's extern
+     * definition wants its inputs resident for the device API given
+     * to define_extern before it is called (in host memory, for
+     * DeviceAPI::Host). Lowering stages each input with the
+     * equivalent of halide_copy_to_device or halide_copy_to_host as
+     * needed. The copies participate in the usual buffer state
+     * tracking, so an input that is already resident is handed over
+     * as-is and the extern stage does not need to make a defensive
+     * copy of its own. An error if this Func has no extern
+     * definition. */
+    EXPORT Func &extern_requires_resident_inputs(bool resident = true);
+
+    /** Declare that the extern function called by this Func's extern
+     * definition can only consume densely-packed buffers, and so must
+     * never be handed a strided crop of a larger allocation. Lowering
+     * raises an error if a schedule would require passing such a crop
+     * (which happens when an input to the stage, or the stage itself,
+     * is stored at a different loop level than it is computed).
+     * Buffers that come from ImageParams are passed through
+     * unchecked; constrain their strides on the ImageParam itself.
+     * An error if this Func has no extern definition. */
+    EXPORT Func &extern_requires_dense_buffers(bool dense = true);
+
     /** Get the types of the outputs of this Func. */
     EXPORT const std::vector<Type> &output_types() const;
 
@@ -1309,6 +1384,64 @@ public:
      * different values at different times or on different machines. */
     EXPORT Func &allow_race_conditions();
 
+    /** Specify that scatter updates to this Func should be performed
+     * with atomic read-modify-write operations, which makes it safe
+     * to parallelize over RVars that Halide cannot prove race-free.
+     * Unlike allow_race_conditions, the result is deterministic for
+     * commutative updates. The update must be of a form that maps to
+     * a hardware atomic: an integer +=, -=, min, max, or bitwise
+     * and/or/xor of the value already stored, and the rest of the
+     * update expression must not read the Func being updated. It is
+     * an error to lower an atomic update of any other form. Use this
+     * for scatter reductions (e.g. histograms) where the extra buffer
+     * and merge pass of rfactor cost more than atomic contention.
+     * Applies to every update definition of this Func; use
+     * f.update(n).atomic() to mark a single update. */
+    EXPORT Func &atomic();
+
+    /** Like atomic(), but each parallel task accumulates scatter
+     * updates into a small private write-combining buffer instead of
+     * issuing an atomic operation per point. The buffer is a
+     * direct-mapped table of buffer_slots (index, partial value)
+     * pairs; updates to an index that is already resident just
+     * combine in place, and a slot is flushed to the Func with a
+     * single atomic read-modify-write when its index is evicted or
+     * the task finishes. Use this instead of atomic() when many
+     * updates hit the same few destinations from every thread and the
+     * atomics become contended, and instead of rfactor when the
+     * footprint of a full per-thread copy of the Func is too large.
+     * The update must satisfy the same conditions as atomic(), and in
+     * addition must be associative (so -= is accumulated as a sum and
+     * subtracted once on flush). buffer_slots must be a power of two.
+     * Applies to every update definition of this Func; use
+     * f.update(n).scatter_buffered() to mark a single update. */
+    EXPORT Func &scatter_buffered(int buffer_slots = 256);
+
+    /** Guard this Func's pure definition with a runtime condition:
+     * points where the condition is false are skipped entirely
+     * instead of computed. Unlike wrapping the definition in a
+     * select(), which evaluates both sides everywhere, the guarded
+     * body does no work where the condition fails, so the cost of a
+     * sparse stage drops in proportion to its sparsity - a
+     * mostly-transparent layer in a compositing pipeline costs one
+     * mask load and branch per skipped point:
+     \code
+     f(x, y) = blend(bg(x, y), layer(x, y));
+     f.skip_where(alpha(x, y) != 0);
+     \endcode
+     *
+     * Values at skipped points are undefined unless some other
+     * definition stores to them, so sparse stages usually pair this
+     * with an init or a later update covering the whole domain.
+     *
+     * The condition may use this Func's pure variables, params, and
+     * calls to other Funcs. The check is inserted at the innermost
+     * loop that all of its variables belong to, so a condition that
+     * only mentions an outer variable skips whole rows at a time.
+     * Conditions the compiler can solve statically also tighten the
+     * loop bounds, so provably-inactive iteration ranges aren't
+     * visited at all. */
+    EXPORT Func &skip_where(Expr condition);
 
     /** Specialize a Func. This creates a special-case version of the
      * Func where the given condition is true. The most effective
@@ -1473,6 +1606,20 @@ public:
      \endcode
      * When cond is true, this is equivalent to g.compute_at(f,y).
      * When it is false, this is equivalent to g.compute_at(f,x).
+     *
+     * When compiling with the Profile target feature, the profiler
+     * counts how many times each specialization branch is taken. The
+     * counts appear in the profiler report and are available
+     * programmatically via
+     * halide_profiler_get_pipeline_state()->specializations, which
+     * makes it easy to reorder a chain of specializations
+     * hottest-first based on a representative workload.
+     *
+     * A chain of specializations whose conditions are equality tests
+     * on a single integer expression with distinct constants, ended
+     * by specialize_fail(), is mutually exclusive, so it compiles to
+     * a binary search over the constants instead of testing each
+     * condition in turn.
      */
     EXPORT Stage specialize(Expr condition);
 
@@ -1636,9 +1783,16 @@ public:
     /** Prefetch data written to or read from a Func or an ImageParam by a
      * subsequent loop iteration, at an optionally specified iteration offset.
      * 'var' specifies at which loop level the prefetch calls should be inserted.
-     * The final argument specifies how prefetch of region outside bounds
+     * 'strategy' specifies how prefetch of region outside bounds
      * should be handled.
      *
+     * On targets with a block prefetch engine (Hexagon's l2fetch),
+     * 'bytes_per_fetch' bounds how many bytes each issued prefetch
+     * stages, so fetching a large region is pipelined with the
+     * compute consuming it instead of being staged in one blocking
+     * descriptor. Left undefined, the whole region is fetched at
+     * once. It is ignored on targets that prefetch by cache line.
+     *
      * For example, consider this pipeline:
      \code
      Func f, g;
@@ -1665,16 +1819,33 @@ public:
      */
     // @{
     EXPORT Func &prefetch(const Func &f, VarOrRVar var, Expr offset = 1,
-                          PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf);
+                          PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf,
+                          Expr bytes_per_fetch = Expr());
     EXPORT Func &prefetch(const Internal::Parameter &param, VarOrRVar var, Expr offset = 1,
-                          PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf);
+                          PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf,
+                          Expr bytes_per_fetch = Expr());
     template<typename T>
     Func &prefetch(const T &image, VarOrRVar var, Expr offset = 1,
-                   PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf) {
-        return prefetch(image.parameter(), var, offset, strategy);
+                   PrefetchBoundStrategy strategy = PrefetchBoundStrategy::GuardWithIf,
+                   Expr bytes_per_fetch = Expr()) {
+        return prefetch(image.parameter(), var, offset, strategy, bytes_per_fetch);
     }
     // @}
 
+    /** Automatically prefetch the input images read in this Func's
+     * innermost serial loops. Vectorized and unrolled inner loops are
+     * treated as part of the loop body, so a serial row loop over a
+     * vectorized column loop prefetches at row granularity. A prefetch
+     * is emitted for each external buffer whose footprint moves with
+     * the loop, skipping any the schedule already prefetches
+     * explicitly. The prefetch distance
+     * is derived from the per-iteration footprint: small footprints
+     * are fetched several iterations ahead so enough bytes are in
+     * flight to cover the memory latency, large ones just one
+     * iteration ahead. Use the explicit prefetch() overloads instead
+     * when you know a better distance. */
+    EXPORT Func &auto_prefetch();
+
     /** Specify how the storage for the function is laid out. These
      * calls let you specify the nesting order of the dimensions. For
      * example, foo.reorder_storage(y, x) tells Halide to use
@@ -1713,6 +1884,44 @@ public:
      * aligned to multiples of 16, use foo.align_storage(x, 16). */
     EXPORT Func &align_storage(Var dim, Expr alignment);
 
+    /** Store realizations of this function in a tiled layout: the
+     * addresses covered by an x_tile x y_tile block of coordinates
+     * are contiguous, and the blocks themselves are laid out in
+     * storage order. Kernels whose access patterns are column-major
+     * or block-local (transposes, rotations, block matching) touch a
+     * few dense tiles per working set instead of one cache line per
+     * element of a column.
+     *
+     * The tiled dimensions need not be adjacent in storage order; any
+     * dimension stored between them simply becomes part of the
+     * tile. Tile extents that are powers of 2 keep the address math
+     * down to shifts and masks, and extents the tile size doesn't
+     * divide are padded up to whole tiles.
+     *
+     * Only plain realizations in host memory can be stored tiled:
+     * this can't be applied to pipeline outputs, inputs, or functions
+     * accessed through a halide_buffer_t (e.g. by extern stages or on
+     * the GPU), since that describes memory with per-dimension
+     * strides. */
+    EXPORT Func &store_tiled(Var x, Var y, Expr x_tile, Expr y_tile);
+
+    /** Store the elements of this Tuple-valued function interleaved
+     * in a single allocation (array-of-structs), instead of as one
+     * planar allocation per Tuple element. All elements of a given
+     * coordinate become adjacent in memory, so stages that consume
+     * all elements together (e.g. complex arithmetic on a
+     * real/imaginary pair) touch one cache line per point instead of
+     * one per element. Vectorized access becomes strided loads and
+     * stores at the element count's stride.
+     *
+     * The Func must already be defined, with every Tuple element of
+     * the same type: a single allocation has a single element type.
+     *
+     * Like store_tiled, this only applies to plain realizations in
+     * host memory: pipeline outputs and functions accessed through a
+     * halide_buffer_t keep one buffer per Tuple element. */
+    EXPORT Func &store_interleaved();
+
     /** Store realizations of this function in a circular buffer of a
      * given extent. This is more efficient when the extent of the
      * circular buffer is a power of 2. If the fold factor is too
@@ -1745,6 +1954,71 @@ public:
      */
     EXPORT Func &fold_storage(Var dim, Expr extent, bool fold_forward = true);
 
+    /** Require that computations of this function slide over the
+     * given loop variable of its consumer, reusing values computed by
+     * earlier iterations of that loop instead of recomputing them.
+     *
+     * Sliding normally happens automatically whenever this function
+     * is stored at a loop level outside the one it is computed at and
+     * consecutive iterations of an intervening serial loop use
+     * overlapping regions of it. That analysis can silently fail
+     * (e.g. if the region accessed can't be proved to move
+     * monotonically along one dimension), in which case the stencil
+     * overlap is recomputed on every iteration. This directive turns
+     * such a silent failure into an error at compilation time, in the
+     * same spirit as fold_storage.
+     *
+     * This is useful for tiled stencil schedules, where recomputing
+     * the apron of a large stencil on every tile is expensive:
+     \code
+     Func f, g;
+     Var x, y, xo, yo, xi, yi;
+     g(x, y) = x * y;
+     f(x, y) = g(x, y - 12) + g(x, y + 12);
+     f.tile(x, y, xo, yo, xi, yi, 64, 64).parallel(yo);
+     g.store_at(f, yo).compute_at(f, xo).slide_over(xo);
+     \endcode
+     *
+     * Each row of tiles is processed by one thread, and g's storage
+     * lives at the row level, so within a row each tile after the
+     * first computes only the 64 new columns of g, carrying the
+     * overlapping columns over from the previous tile. The named loop
+     * must be a serial (or unrolled) loop of the consumer between
+     * this function's store and compute levels; sliding over a
+     * parallel loop would require iterations to consume each other's
+     * results. */
+    EXPORT Func &slide_over(Var var);
+
+    /** Compute this function inside the loop nest of a sibling
+     * function, sharing that sibling's loops from the outermost down
+     * to (and including) the loop over the given pure variable, with
+     * the two computations sequenced within each iteration of that
+     * loop. Both functions must be compute_root; neither may consume
+     * the other. This merges two passes over memory into one, which
+     * is the right tool when two stages read the same input but
+     * compute_at cannot express the sharing because there is no
+     * producer-consumer edge between them:
+     \code
+     Func f, g, h;
+     Var x, y;
+     f(x, y) = input(x, y) + 1;
+     g(x, y) = input(x, y) * 2;
+     h(x, y) = f(x, y) + g(x, y);
+     f.compute_root();
+     g.compute_root().compute_with(f, y);
+     \endcode
+     *
+     * Each iteration of f's y loop now computes a row of f and then a
+     * row of g, so each row of input is read once while it is hot in
+     * cache instead of once per stage. The sibling's loops outside
+     * the named variable must be plain loops over its pure
+     * dimensions, and this function's nest must be a plain nest over
+     * its pure dimensions (schedule the traversal via the sibling's
+     * inner dimensions instead). Every shared dimension must be a
+     * pure variable of both functions and cover the same region in
+     * both; the regions are checked at runtime. */
+    EXPORT Func &compute_with(Func f, Var var);
+
     /** Compute this function as needed for each unique value of the
      * given var for the given calling function f.
      *
@@ -1868,6 +2142,111 @@ public:
      */
     EXPORT Func &memoize();
 
+    /** Produce this Func asynchronously in a separate task. The
+     * producer is forked off into its own task on the thread pool and
+     * signals a semaphore when the realization is complete; the
+     * consumer acquires the semaphore before its first use. Anything
+     * else scheduled at the same loop level (e.g. other producers, or
+     * copies to and from a device) overlaps with the asynchronous
+     * production. Must be used with a compute_at or compute_root
+     * schedule; it is an error to mark an inlined Func or a Pipeline
+     * output as async.
+     *
+     * If the store level is outside the compute level
+     * (e.g. store_root().compute_at(consumer, y)), the producer
+     * instead becomes a task spanning the consumer's loops, free to
+     * run ahead of the consumer within the realization; the consumer
+     * waits on the semaphore before each of its compute-level
+     * iterations. This pipelines I/O-bound producers (extern stages
+     * in particular) with compute. The loops between the store and
+     * compute levels must be serial for the fork to happen; if they
+     * are not, production falls back to running serially. */
+    EXPORT Func &async();
+
+    /** Forward loaded values across iterations of this Func's serial
+     * loops instead of reloading them from memory. Dense vector loads
+     * of a stencil window that shift by a constant amount per
+     * iteration are kept in registers and reconstructed with shuffles
+     * (shift-and-insert), so a w-wide 1D stencil does one new load
+     * per iteration instead of w. Whether this is a win depends on
+     * the cost of unaligned loads versus shuffles on the target; it
+     * tends to pay off on machines with few load issue slots. */
+    EXPORT Func &store_forwarding();
+
+    /** Hint that values stored to this Func's realization will not be
+     * read again soon, so stores should bypass the cache using
+     * non-temporal (streaming) store instructions where the target
+     * supports them (e.g. movntps/movntdq on x86, stnp on ARM). A
+     * memory fence is emitted at the end of this Func's producer so
+     * that consumers see the stored values. Useful for large output
+     * stages that would otherwise evict the working set of the rest
+     * of the pipeline from cache. Stores that the backend cannot make
+     * non-temporal (e.g. predicated or strided stores) are unaffected. */
+    EXPORT Func &store_non_temporal();
+
+    /** Software-pipeline this Func's innermost serial loops: the
+     * loads that iteration i+1 needs are issued at the bottom of
+     * iteration i into scratch buffers, and the loop is restructured
+     * into a prologue, a kernel, and an epilogue for the final
+     * iteration. This gives in-order cores (Hexagon, in-order ARM) a
+     * full loop body's worth of work in which to cover load latency,
+     * instead of stalling at the top of every iteration waiting for
+     * loads that issued moments earlier. Out-of-order x86 cores get
+     * little from it. Only two-stage pipelining (loads one iteration
+     * ahead) is currently implemented. */
+    EXPORT Func &software_pipeline(int stage_count = 2);
+
+    /** Skip iterations of the given loop variable at runtime when the
+     * given predicate evaluates true. The predicate is evaluated once
+     * per iteration of that loop, and may reference the loop variable
+     * and any pipeline parameters (e.g. a per-block dirty mask passed
+     * in via an ImageParam), so guarding an outer loop produced by
+     * split() skips whole strips of work for the cost of one cheap
+     * test each, with the strip size controlled by the split factor:
+     *
+     \code
+     ImageParam dirty(UInt(8), 1);
+     f(x) = some_expensive_thing(x);
+     f.split(x, xo, xi, 64).skip_strips(xo, dirty(xo) == 0);
+     \endcode
+     *
+     * Skipped iterations leave the corresponding region of the
+     * realization untouched, so this is only sound when that memory
+     * already holds acceptable values - e.g. when realizing over an
+     * output buffer that still contains the previous frame and the
+     * predicate marks the unchanged blocks. Halide does not (and
+     * cannot) verify this. Only one loop per Func may be guarded. */
+    EXPORT Func &skip_strips(VarOrRVar var, Expr skip);
+
+    /** Set the type of memory used to back realizations of this
+     * Func. By default (MemoryType::Auto), small constant-sized
+     * allocations go on the stack and everything else goes on the
+     * heap. MemoryType::Stack forces the allocation onto the stack,
+     * eliminating a call to halide_malloc per realization; it is an
+     * error during lowering if the allocated size is not a
+     * compile-time constant, or exceeds the stack budget for the
+     * target. MemoryType::Heap always allocates with
+     * halide_malloc. */
+    EXPORT Func &store_in(MemoryType memory_type);
+
+    /** Overlap the device -> host read-back of this Func with the
+     * device work that produces the rest of it. Only meaningful for
+     * pipeline outputs computed on a device API. The schedule must
+     * wrap the gpu_blocks loops in a serial host-side loop (e.g. by
+     * splitting the outermost storage dimension and leaving the outer
+     * loop serial); as each iteration of that loop completes, the
+     * slab of the output it produced is copied back to the host on a
+     * separate transfer queue while later kernels run. The read-backs
+     * are throttled to approximately \p slices copies over the whole
+     * output, so a fine-grained outer loop does not drown the
+     * transfer queue in tiny copies. A fence before the output is
+     * consumed guarantees all slabs have landed.
+     *
+     * On backends without support for asynchronous transfer queues
+     * the slabs are copied back eagerly but synchronously, which
+     * still bounds the size of the final blocking copy. The schedule
+     * is a no-op when the Func is not computed on a device. */
+    EXPORT Func &stream_readback(int slices);
 
     /** Allocate storage for this function within f's loop over
      * var. Scheduling storage is optional, and can be used to
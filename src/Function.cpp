@@ -14,6 +14,7 @@
 #include "IROperator.h"
 #include "IRPrinter.h"
 #include "ParallelRVar.h"
+#include "Simplify.h"
 #include "Var.h"
 
 namespace Halide {
@@ -78,6 +79,9 @@ struct FunctionContents {
     NameMangling extern_mangling = NameMangling::Default;
     DeviceAPI extern_function_device_api = DeviceAPI::Host;
     bool extern_uses_old_buffer_t = false;
+    bool extern_preserves_buffer_state = false;
+    bool extern_requires_resident_inputs = false;
+    bool extern_requires_dense_buffers = false;
     Expr extern_proxy_expr;
 
     bool trace_loads = false, trace_stores = false, trace_realizations = false;
@@ -323,6 +327,9 @@ void Function::deep_copy(FunctionPtr copy, DeepCopyMap &copied_map) const {
     copy->extern_mangling = contents->extern_mangling;
     copy->extern_function_device_api = contents->extern_function_device_api;
     copy->extern_uses_old_buffer_t = contents->extern_uses_old_buffer_t;
+    copy->extern_preserves_buffer_state = contents->extern_preserves_buffer_state;
+    copy->extern_requires_resident_inputs = contents->extern_requires_resident_inputs;
+    copy->extern_requires_dense_buffers = contents->extern_requires_dense_buffers;
     copy->extern_proxy_expr = contents->extern_proxy_expr;
     copy->trace_loads = contents->trace_loads;
     copy->trace_stores = contents->trace_stores;
@@ -849,6 +856,30 @@ Expr &Function::extern_definition_proxy_expr() {
     return contents->extern_proxy_expr;
 }
 
+bool Function::extern_definition_preserves_buffer_state() const {
+    return contents->extern_preserves_buffer_state;
+}
+
+bool &Function::extern_definition_preserves_buffer_state() {
+    return contents->extern_preserves_buffer_state;
+}
+
+bool Function::extern_definition_requires_resident_inputs() const {
+    return contents->extern_requires_resident_inputs;
+}
+
+bool &Function::extern_definition_requires_resident_inputs() {
+    return contents->extern_requires_resident_inputs;
+}
+
+bool Function::extern_definition_requires_dense_buffers() const {
+    return contents->extern_requires_dense_buffers;
+}
+
+bool &Function::extern_definition_requires_dense_buffers() {
+    return contents->extern_requires_dense_buffers;
+}
+
 const std::vector<ExternFuncArgument> &Function::extern_arguments() const {
     return contents->extern_arguments;
 }
@@ -988,14 +1019,36 @@ class SubstituteScheduleParamExprs : public IRMutator2 {
         Expr expr = IRMutator2::visit(v);
         if (v->param.defined() && v->param.is_bound_before_lowering()) {
             expr = mutate(v->param.scalar_expr());
+            substituted_any = true;
+        } else if (v->param.defined() && !v->param.is_buffer()) {
+            runtime_params.insert(v->param.name());
         }
         return expr;
     }
 
 public:
+    // Whether any ScheduleParam was substituted, and the scalar
+    // runtime parameters encountered along the way. When both are
+    // present, the runtime parameters are what stop the substituted
+    // expressions from folding all the way down to constants.
+    bool substituted_any = false;
+    std::set<string> runtime_params;
+
     SubstituteScheduleParamExprs() = default;
 };
 
+// Constant-folds every Expr stored in a FunctionContents. Run after
+// ScheduleParam substitution so arithmetic that mixed ScheduleParams
+// with constants doesn't survive as runtime math.
+class FoldScheduleParamExprs : public IRMutator2 {
+public:
+    using IRMutator2::mutate;
+
+    Expr mutate(const Expr &e) override {
+        return e.defined() ? simplify(e) : e;
+    }
+};
+
 
 } // anonymous namespace
 
@@ -1015,9 +1068,17 @@ Function &Function::substitute_calls(const Function &orig, const Function &subst
     return substitute_calls(substitutions);
 }
 
-Function &Function::substitute_schedule_param_exprs() {
+Function &Function::substitute_schedule_param_exprs(std::set<std::string> *blocked_by) {
     SubstituteScheduleParamExprs sub_schedule_params;
     contents->mutate(&sub_schedule_params);
+    if (sub_schedule_params.substituted_any) {
+        FoldScheduleParamExprs fold;
+        contents->mutate(&fold);
+        if (blocked_by) {
+            blocked_by->insert(sub_schedule_params.runtime_params.begin(),
+                               sub_schedule_params.runtime_params.end());
+        }
+    }
     return *this;
 }
 
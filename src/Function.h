@@ -16,6 +16,7 @@
 #include "Util.h"
 
 #include <map>
+#include <set>
 
 namespace Halide {
 
@@ -228,6 +229,31 @@ public:
     EXPORT Expr &extern_definition_proxy_expr();
     // @}
 
+    /** Check if the extern function being called has declared that it
+     * only reads its inputs, only writes its outputs, and leaves the
+     * dirty bits and device allocation of every buffer passed to it
+     * in a correct state. */
+    // @{
+    EXPORT bool extern_definition_preserves_buffer_state() const;
+    EXPORT bool &extern_definition_preserves_buffer_state();
+    // @}
+
+    /** Check if the extern function being called has asked for its
+     * inputs to be made resident for the extern definition's device
+     * API before the call. */
+    // @{
+    EXPORT bool extern_definition_requires_resident_inputs() const;
+    EXPORT bool &extern_definition_requires_resident_inputs();
+    // @}
+
+    /** Check if the extern function being called has declared that it
+     * can only consume densely-packed buffers, and so must never be
+     * passed a strided crop of a larger allocation. */
+    // @{
+    EXPORT bool extern_definition_requires_dense_buffers() const;
+    EXPORT bool &extern_definition_requires_dense_buffers();
+    // @}
+
     /** Add an external definition of this Func. */
     EXPORT void define_extern(const std::string &function_name,
                               const std::vector<ExternFuncArgument> &args,
@@ -317,8 +343,14 @@ public:
     // @}
 
     /** Find all Vars that are placeholders for ScheduleParams and substitute in
-     * the corresponding constant value. */
-    EXPORT Function &substitute_schedule_param_exprs();
+     * the corresponding constant value, then constant-fold the
+     * affected definitions so the dependent arithmetic reaches the
+     * rest of lowering as constants. If blocked_by is non-null, the
+     * names of any runtime parameters appearing in definitions
+     * alongside substituted ScheduleParams are added to it; these are
+     * what kept those expressions from folding to constants
+     * outright. */
+    EXPORT Function &substitute_schedule_param_exprs(std::set<std::string> *blocked_by = nullptr);
 
     /** Return true iff the name matches one of the Function's pure args. */
     EXPORT bool is_pure_arg(const std::string &name) const;
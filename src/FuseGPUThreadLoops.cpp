@@ -28,6 +28,30 @@ string block_names[] = {"__block_id_x", "__block_id_y", "__block_id_z", "__block
 string shared_mem_name = "__shared";
 }
 
+// Does a statement read or write the block's shared memory? Runs
+// after ExtractSharedAllocations, so shared accesses are loads and
+// stores to the __shared buffer.
+class FindSharedMemoryAccesses : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Load *op) {
+        if (starts_with(op->name, shared_mem_name)) {
+            reads = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Store *op) {
+        if (starts_with(op->name, shared_mem_name)) {
+            writes = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    bool reads = false, writes = false;
+};
+
 class InjectThreadBarriers : public IRMutator2 {
     bool in_threads;
 
@@ -44,11 +68,35 @@ class InjectThreadBarriers : public IRMutator2 {
         return IRMutator2::visit(op);
     }
 
+    // A barrier is only needed between two fused stages if they
+    // communicate through shared memory. That's a write followed by
+    // any access, or a read followed by a write (the write may reuse
+    // bytes still being read by another thread, because the shared
+    // allocations are coalesced by liveness).
+    static bool needs_barrier_between(const Stmt &before, const Stmt &after) {
+        FindSharedMemoryAccesses b;
+        before.accept(&b);
+        if (!b.reads && !b.writes) {
+            return false;
+        }
+        FindSharedMemoryAccesses a;
+        after.accept(&a);
+        return ((b.writes && (a.reads || a.writes)) ||
+                (b.reads && a.writes));
+    }
+
     Stmt visit(const Block *op) override {
         if (!in_threads && op->rest.defined()) {
             Stmt first = mutate(op->first);
             Stmt rest = mutate(op->rest);
-            return Block::make(Block::make(first, barrier), rest);
+            if (needs_barrier_between(op->first, op->rest)) {
+                return Block::make(Block::make(first, barrier), rest);
+            } else if (first.same_as(op->first) &&
+                       rest.same_as(op->rest)) {
+                return op;
+            } else {
+                return Block::make(first, rest);
+            }
         } else {
             return IRMutator2::visit(op);
         }
@@ -221,6 +269,76 @@ public:
     ReplaceForWithIf(const ExtractBlockSize &e) : block_size(e) {}
 };
 
+// On CUDA, rewrite atomic updates whose address is the same for every
+// lane of a warp to do a warp-level shuffle reduction first, so that
+// one lane issues a single atomic per warp instead of 32 serialized
+// ones. Runs on the fused kernel body, where the thread indices are
+// the block-wide .__thread_id_* variables.
+class InjectWarpReductions : public IRMutator2 {
+    using IRMutator2::visit;
+
+    static const int warp_size = 32;
+
+    // The x dimension of the block, which warps are laid out along.
+    const string thread_var = "." + thread_names[0];
+
+    // True while every lane of a warp is guaranteed to reach the
+    // current statement: control flow that depends on the thread x
+    // index may leave some lanes of the warp inactive, and a shuffle
+    // with inactive lanes reads garbage.
+    bool warp_uniform = true;
+
+    Stmt visit(const IfThenElse *op) override {
+        if (expr_uses_var(op->condition, thread_var)) {
+            ScopedValue<bool> old(warp_uniform, false);
+            return IRMutator2::visit(op);
+        }
+        return IRMutator2::visit(op);
+    }
+
+    Stmt visit(const For *op) override {
+        if (expr_uses_var(op->min, thread_var) ||
+            expr_uses_var(op->extent, thread_var)) {
+            ScopedValue<bool> old(warp_uniform, false);
+            return IRMutator2::visit(op);
+        }
+        return IRMutator2::visit(op);
+    }
+
+    Stmt visit(const Evaluate *op) override {
+        const Call *rmw = op->value.as<Call>();
+        if (!warp_uniform ||
+            !rmw ||
+            !rmw->is_intrinsic(Call::atomic_rmw) ||
+            rmw->type.bits() != 32) {
+            // The shfl instructions move 32-bit values.
+            return IRMutator2::visit(op);
+        }
+        const StringImm *rmw_op = rmw->args[0].as<StringImm>();
+        const Load *load = rmw->args[1].as<Load>();
+        internal_assert(rmw_op && load) << "Malformed atomic_rmw intrinsic\n";
+        if (expr_uses_var(load->index, thread_var)) {
+            // Different lanes hit different addresses; nothing to
+            // combine within the warp.
+            return IRMutator2::visit(op);
+        }
+
+        // All 32 lanes update the same address. Reduce the operands
+        // across the warp and have lane zero issue one atomic. Every
+        // supported read-modify-write reduces with its own operation,
+        // except sub, whose operands sum.
+        string reduce_op = rmw_op->value == "sub" ? "add" : rmw_op->value;
+        Expr reduced = Call::make(rmw->type, Call::gpu_warp_reduce,
+                                  {StringImm::make(reduce_op), rmw->args[2]},
+                                  Call::Intrinsic);
+        Expr atomic = Call::make(rmw->type, Call::atomic_rmw,
+                                 {rmw->args[0], rmw->args[1], reduced},
+                                 Call::Intrinsic);
+        Expr lane = Variable::make(Int(32), thread_var) % warp_size;
+        return IfThenElse::make(lane == 0, Evaluate::make(atomic));
+    }
+};
+
 class ExtractSharedAllocations : public IRMutator2 {
     using IRMutator2::visit;
 
@@ -522,10 +640,26 @@ public:
 
         if (device_api == DeviceAPI::OpenGLCompute) {
 
-            // Individual shared allocations.
+            // Individual shared allocations. GLSL requires shared
+            // arrays to be statically sized, so if the size isn't
+            // already a constant, round it up to a constant upper
+            // bound.
             for (SharedAllocation alloc : allocations) {
+                Expr size = alloc.size;
+                if (!is_const(size)) {
+                    size = find_constant_bound(size, Direction::Upper);
+                    user_assert(size.defined())
+                        << "Allocation " << alloc.name << " has a size that is "
+                        << "neither constant nor bounded by a constant: "
+                        << alloc.size << "\n"
+                        << "The OpenGL Compute backend requires allocations "
+                        << "stored in shared memory to have a size that can be "
+                        << "determined at compile time. Consider using "
+                        << "Func::bound_extent on the staged Func.\n";
+                    size = simplify(size);
+                }
                 s = Allocate::make(shared_mem_name + "_" + alloc.name,
-                                   alloc.type, {alloc.size}, const_true(), s);
+                                   alloc.type, {size}, const_true(), s);
             }
         } else {
             // One big combined shared allocation.
@@ -608,6 +742,19 @@ class FuseGPUThreadLoopsSingleKernel : public IRMutator2 {
 
             debug(3) << "Replaced for with if:\n" << body << "\n\n";
 
+            // If the block is made of whole warps, combine atomic
+            // updates to warp-invariant addresses with a shuffle
+            // reduction. Only the PTX backend lowers the warp
+            // primitives; the other device APIs keep plain atomics.
+            if (op->device_api == DeviceAPI::CUDA &&
+                block_size.dimensions() >= 1) {
+                const int64_t *tx = as_const_int(block_size.extent(0));
+                if (tx && *tx > 0 && *tx % 32 == 0) {
+                    body = InjectWarpReductions().mutate(body);
+                    debug(3) << "Injected warp reductions:\n" << body << "\n\n";
+                }
+            }
+
             // Rewrap the whole thing in the loop over threads
             for (int i = 0; i < block_size.dimensions(); i++) {
                 body = For::make("." + thread_names[i], 0, block_size.extent(i), ForType::GPUThread, op->device_api, body);
@@ -0,0 +1,500 @@
+#include <algorithm>
+#include <sstream>
+
+#include "FuseOutputLoops.h"
+#include "Function.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRPrinter.h"
+#include "IRVisitor.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::pair;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// A produce body peeled into its scalar lets and loops (in nesting
+// order, outermost first) and the statement under them.
+struct PeeledNest {
+    vector<pair<string, Expr>> lets;
+    vector<const For *> loops;
+    Stmt body;
+};
+
+PeeledNest peel_nest(Stmt s) {
+    PeeledNest p;
+    while (true) {
+        if (const LetStmt *let = s.as<LetStmt>()) {
+            p.lets.push_back({let->name, let->value});
+            s = let->body;
+        } else if (const For *loop = s.as<For>()) {
+            p.loops.push_back(loop);
+            s = loop->body;
+        } else {
+            break;
+        }
+    }
+    p.body = s;
+    return p;
+}
+
+// Insert a statement at the innermost point of a loop nest, after
+// whatever is already there, recording the let and loop names passed
+// on the way down.
+Stmt inject_at_innermost(Stmt s, const Stmt &extra, set<string> *names_seen) {
+    if (const LetStmt *let = s.as<LetStmt>()) {
+        names_seen->insert(let->name);
+        return LetStmt::make(let->name, let->value,
+                             inject_at_innermost(let->body, extra, names_seen));
+    } else if (const For *loop = s.as<For>()) {
+        names_seen->insert(loop->name);
+        return For::make(loop->name, loop->min, loop->extent,
+                         loop->for_type, loop->device_api,
+                         inject_at_innermost(loop->body, extra, names_seen));
+    } else {
+        return Block::make(s, extra);
+    }
+}
+
+// Insert a statement at the bottom of the body of the loop over the
+// named variable, recording the lets and loops passed on the way down
+// (the target loop included). Leaves *found false if the walk hits
+// something other than a let or a loop first.
+Stmt inject_below_loop(Stmt s, const string &loop_name, const Stmt &extra,
+                       vector<pair<string, Expr>> *lets,
+                       vector<const For *> *loops, bool *found) {
+    if (const LetStmt *let = s.as<LetStmt>()) {
+        lets->push_back({let->name, let->value});
+        return LetStmt::make(let->name, let->value,
+                             inject_below_loop(let->body, loop_name, extra, lets, loops, found));
+    } else if (const For *loop = s.as<For>()) {
+        loops->push_back(loop);
+        if (loop->name == loop_name) {
+            *found = true;
+            return For::make(loop->name, loop->min, loop->extent,
+                             loop->for_type, loop->device_api,
+                             Block::make(loop->body, extra));
+        }
+        return For::make(loop->name, loop->min, loop->extent,
+                         loop->for_type, loop->device_api,
+                         inject_below_loop(loop->body, loop_name, extra, lets, loops, found));
+    } else {
+        return s;
+    }
+}
+
+// Find the root-level produce nodes of the group members. The
+// statement encountered last in program order is the most deeply
+// nested in the consume markers of the group's producers, so that's
+// where the fused nest can legally go.
+class FindGroupProductions : public IRVisitor {
+public:
+    const set<string> &group;
+    map<string, Stmt> bodies;
+    string last;
+
+    FindGroupProductions(const set<string> &group) : group(group) {}
+
+private:
+    using IRVisitor::visit;
+
+    int for_depth = 0;
+
+    void visit(const For *op) override {
+        for_depth++;
+        IRVisitor::visit(op);
+        for_depth--;
+    }
+
+    void visit(const ProducerConsumer *op) override {
+        if (op->is_producer && group.count(op->name)) {
+            internal_assert(for_depth == 0)
+                << "Fused function " << op->name << " is not produced at the root level\n";
+            internal_assert(!bodies.count(op->name));
+            bodies[op->name] = op->body;
+            last = op->name;
+            // Don't look for productions inside a group member.
+            return;
+        }
+        IRVisitor::visit(op);
+    }
+};
+
+// Check that no group member is consumed before the point where the
+// fused nest will run (the host's produce node). Unlike fused
+// outputs, siblings fused by compute_with have consumers within the
+// pipeline, and anything that reads a member before the host's
+// position would see uncomputed data.
+class FindEarlyConsumption : public IRVisitor {
+public:
+    const set<string> &group;
+    const string &host;
+    string offender;
+
+    FindEarlyConsumption(const set<string> &group, const string &host)
+        : group(group), host(host) {}
+
+private:
+    using IRVisitor::visit;
+
+    bool past_host = false;
+
+    void visit(const Call *op) override {
+        if (!past_host && op->call_type == Call::Halide &&
+            group.count(op->name) && offender.empty()) {
+            offender = op->name;
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const ProducerConsumer *op) override {
+        IRVisitor::visit(op);
+        if (op->is_producer && op->name == host) {
+            past_host = true;
+        }
+    }
+};
+
+// Replace the group's produce nodes: the one hosting the fused nest
+// gets the merged statement, the others disappear.
+class RewriteGroupProductions : public IRMutator2 {
+public:
+    const set<string> &group;
+    const string &host;
+    const Stmt &fused;
+
+    RewriteGroupProductions(const set<string> &group, const string &host, const Stmt &fused)
+        : group(group), host(host), fused(fused) {}
+
+private:
+    using IRMutator2::visit;
+
+    Stmt visit(const ProducerConsumer *op) override {
+        if (op->is_producer && group.count(op->name)) {
+            if (op->name == host) {
+                return fused;
+            } else {
+                return Evaluate::make(0);
+            }
+        }
+        return IRMutator2::visit(op);
+    }
+};
+
+}  // namespace
+
+Stmt fuse_output_loops(Stmt s, const vector<Function> &outputs) {
+    vector<Function> group;
+    set<string> group_names;
+    for (const Function &f : outputs) {
+        if (f.schedule().fused_output()) {
+            group.push_back(f);
+            group_names.insert(f.name());
+        }
+    }
+    if (group.size() < 2) {
+        return s;
+    }
+
+    FindGroupProductions finder(group_names);
+    s.accept(&finder);
+    internal_assert(finder.bodies.size() == group.size())
+        << "Could not find the productions of all fused outputs\n";
+
+    const Function &master = group[0];
+    const string master_prefix = master.name() + ".s0.";
+
+    // Rewrite each non-master member's stores in terms of the
+    // master's loop variables, and stack them up after the master's
+    // own store at the innermost point of its nest.
+    Stmt extra;
+    for (size_t i = 1; i < group.size(); i++) {
+        const Function &f = group[i];
+        const string prefix = f.name() + ".s0.";
+
+        PeeledNest p = peel_nest(finder.bodies[f.name()]);
+        set<string> loop_names;
+        for (const For *loop : p.loops) {
+            user_assert(loop->for_type == ForType::Serial && loop->device_api == DeviceAPI::None)
+                << "Cannot fuse output " << f.name() << ": its loop nest is scheduled. "
+                << "Schedule the fused traversal via the first output ("
+                << master.name() << ") and leave the others alone.\n";
+            loop_names.insert(loop->name);
+        }
+        bool plain_nest = (p.loops.size() == f.args().size());
+        for (const string &arg : f.args()) {
+            plain_nest = plain_nest && loop_names.count(prefix + arg);
+        }
+        user_assert(plain_nest)
+            << "Cannot fuse output " << f.name() << ": expected a plain loop "
+            << "nest over its pure dimensions. Fused outputs other than the "
+            << "first must not be split, renamed, specialized, or have "
+            << "stages computed inside their loops.\n";
+
+        // The i'th dimension of each output is realized over the same
+        // region (the directive constrained the output buffers to
+        // match), so the master's loop over its i'th dimension can
+        // stand in for ours.
+        map<string, Expr> replacement;
+        for (size_t j = 0; j < f.args().size(); j++) {
+            replacement[prefix + f.args()[j]] =
+                Variable::make(Int(32), master_prefix + master.args()[j]);
+        }
+
+        Stmt body = p.body;
+        for (size_t j = p.lets.size(); j > 0; j--) {
+            body = LetStmt::make(p.lets[j - 1].first, p.lets[j - 1].second, body);
+        }
+        body = substitute(replacement, body);
+
+        extra = extra.defined() ? Block::make(extra, body) : body;
+    }
+
+    set<string> names_seen;
+    Stmt fused = inject_at_innermost(finder.bodies[master.name()], extra, &names_seen);
+    for (const string &arg : master.args()) {
+        user_assert(names_seen.count(master_prefix + arg))
+            << "Cannot fuse outputs: the loop nest of " << master.name()
+            << " no longer defines its pure variable " << arg
+            << ". Don't rename the dimensions of the first fused output.\n";
+    }
+
+    // Keep all the members' produce markers, wrapped around the whole
+    // fused nest.
+    for (size_t i = group.size(); i > 1; i--) {
+        fused = ProducerConsumer::make_produce(group[i - 1].name(), fused);
+    }
+    fused = ProducerConsumer::make_produce(master.name(), fused);
+
+    return RewriteGroupProductions(group_names, finder.last, fused).mutate(s);
+}
+
+Stmt fuse_sibling_loop_nests(Stmt s, const map<string, Function> &env) {
+    // Group the marked functions by the sibling they fuse into.
+    map<string, vector<Function>> groups;
+    for (const auto &iter : env) {
+        const Function &f = iter.second;
+        const string &host_name = f.schedule().compute_with_func();
+        if (host_name.empty()) {
+            continue;
+        }
+        user_assert(env.count(host_name))
+            << "Func " << f.name() << " is scheduled compute_with "
+            << host_name << ", but " << host_name
+            << " is not used by the pipeline.\n";
+        groups[host_name].push_back(f);
+    }
+
+    for (const auto &g : groups) {
+        const Function &master = env.at(g.first);
+        const vector<Function> &followers = g.second;
+        const string master_prefix = master.name() + ".s0.";
+
+        user_assert(master.schedule().compute_level().is_root() &&
+                    !master.has_update_definition())
+            << "Func " << master.name() << " has other functions computed with "
+            << "it, so it must be compute_root and have no update definition.\n";
+        user_assert(master.schedule().compute_with_func().empty())
+            << "Func " << master.name() << " has other functions computed with "
+            << "it, but is itself computed with "
+            << master.schedule().compute_with_func()
+            << ". Chains of compute_with are not supported; compute all "
+            << "the siblings with the same function instead.\n";
+
+        set<string> master_args(master.args().begin(), master.args().end());
+        set<string> member_names;
+        member_names.insert(master.name());
+        for (const Function &f : followers) {
+            user_assert(f.schedule().compute_level().is_root() &&
+                        !f.has_update_definition())
+                << "Func " << f.name() << " is scheduled compute_with "
+                << master.name() << ", so it must be compute_root and have "
+                << "no update definition.\n";
+            user_assert(master_args.count(f.schedule().compute_with_var()))
+                << "In schedule for " << f.name() << ": " << master.name()
+                << " has no pure variable named "
+                << f.schedule().compute_with_var() << "\n";
+            member_names.insert(f.name());
+        }
+
+        FindGroupProductions finder(member_names);
+        s.accept(&finder);
+        internal_assert(finder.bodies.size() == member_names.size())
+            << "Could not find the productions of all compute_with siblings\n";
+
+        FindEarlyConsumption early(member_names, finder.last);
+        s.accept(&early);
+        user_assert(early.offender.empty())
+            << "Cannot fuse the loop nests of " << master.name()
+            << " and the functions computed with it: " << early.offender
+            << " is consumed before the point where the fused nest runs. "
+            << "Functions in a compute_with group must not consume each "
+            << "other, or be consumed by anything computed between their "
+            << "original positions.\n";
+
+        // Fuse the deepest-shared followers first, so that shallower
+        // injections never have to walk through a block a deeper one
+        // has already inserted.
+        vector<Function> order = followers;
+        std::stable_sort(order.begin(), order.end(),
+                         [&](const Function &a, const Function &b) {
+                             const vector<string> &args = master.args();
+                             size_t ia = std::find(args.begin(), args.end(),
+                                                   a.schedule().compute_with_var()) - args.begin();
+                             size_t ib = std::find(args.begin(), args.end(),
+                                                   b.schedule().compute_with_var()) - args.begin();
+                             return ia < ib;
+                         });
+
+        Stmt fused = finder.bodies[master.name()];
+        Stmt checks;
+        for (const Function &f : order) {
+            const string prefix = f.name() + ".s0.";
+            const string &fuse_var = f.schedule().compute_with_var();
+
+            PeeledNest p = peel_nest(finder.bodies[f.name()]);
+            map<string, const For *> follower_loops;
+            for (const For *loop : p.loops) {
+                user_assert(loop->for_type == ForType::Serial && loop->device_api == DeviceAPI::None)
+                    << "Cannot compute " << f.name() << " with " << master.name()
+                    << ": its loop nest is scheduled. Schedule the fused "
+                    << "traversal via " << master.name() << " and leave "
+                    << f.name() << " alone.\n";
+                follower_loops[loop->name] = loop;
+            }
+            bool plain_nest = (p.loops.size() == f.args().size());
+            for (const string &arg : f.args()) {
+                plain_nest = plain_nest && follower_loops.count(prefix + arg);
+            }
+            user_assert(plain_nest)
+                << "Cannot compute " << f.name() << " with " << master.name()
+                << ": expected a plain loop nest over its pure dimensions. "
+                << "A function computed with a sibling must not be split, "
+                << "renamed, specialized, or have stages computed inside "
+                << "its loops.\n";
+
+            // Walk the master's nest down to its loop over the fused
+            // variable, collecting the lets and loops the follower's
+            // computation will sit inside.
+            vector<pair<string, Expr>> master_lets;
+            vector<const For *> shared_loops;
+            bool found = false;
+            Stmt walk = fused;
+            while (!found) {
+                if (const LetStmt *let = walk.as<LetStmt>()) {
+                    master_lets.push_back({let->name, let->value});
+                    walk = let->body;
+                } else if (const For *loop = walk.as<For>()) {
+                    shared_loops.push_back(loop);
+                    found = (loop->name == master_prefix + fuse_var);
+                    walk = loop->body;
+                } else {
+                    break;
+                }
+            }
+            user_assert(found)
+                << "Cannot compute " << f.name() << " with " << master.name()
+                << ": could not find " << master.name() << "'s loop over "
+                << fuse_var << ". The loops of " << master.name()
+                << " outside " << fuse_var << " must be plain loops over "
+                << "its pure dimensions.\n";
+
+            // Each shared master loop stands in for the follower's
+            // loop over the dimension of the same name; the
+            // follower's remaining dimensions keep their own loops,
+            // nested inside the shared ones.
+            set<string> shared_dims;
+            map<string, Expr> replacement;
+            vector<Stmt> region_checks;
+            for (const For *m_loop : shared_loops) {
+                user_assert(starts_with(m_loop->name, master_prefix) &&
+                            master_args.count(m_loop->name.substr(master_prefix.size())))
+                    << "Cannot compute " << f.name() << " with " << master.name()
+                    << ": the loops of " << master.name() << " outside "
+                    << fuse_var << " must be plain loops over its pure "
+                    << "dimensions.\n";
+                string dim = m_loop->name.substr(master_prefix.size());
+                user_assert(follower_loops.count(prefix + dim))
+                    << "Cannot compute " << f.name() << " with " << master.name()
+                    << " at " << fuse_var << ": " << f.name()
+                    << " has no pure variable named " << dim << "\n";
+                user_assert(m_loop->device_api == DeviceAPI::None)
+                    << "Cannot compute " << f.name() << " with " << master.name()
+                    << ": the shared loops run on a device.\n";
+                shared_dims.insert(dim);
+                replacement[prefix + dim] = Variable::make(Int(32), m_loop->name);
+
+                // The shared loops iterate over the master's region,
+                // so they only cover the follower if the two regions
+                // agree. There's no buffer constraint pinning them
+                // together as there is for fused outputs, so check at
+                // runtime.
+                const For *f_loop = follower_loops[prefix + dim];
+                Expr cond = (f_loop->min == m_loop->min &&
+                             f_loop->extent == m_loop->extent);
+                std::ostringstream cond_str;
+                cond_str << cond;
+                Expr error = Call::make(Int(32), "halide_error_requirement_failed",
+                                        {cond_str.str(),
+                                         Expr(f.name() + " is computed with " + master.name() +
+                                              ", but does not cover the same region over dimension " +
+                                              dim)},
+                                        Call::Extern);
+                region_checks.push_back(AssertStmt::make(cond, error));
+            }
+
+            // Rebuild the follower's nest without the shared loops.
+            Stmt body = p.body;
+            for (size_t j = p.loops.size(); j > 0; j--) {
+                const For *loop = p.loops[j - 1];
+                if (shared_dims.count(loop->name.substr(prefix.size()))) {
+                    continue;
+                }
+                body = For::make(loop->name, loop->min, loop->extent,
+                                 loop->for_type, loop->device_api, body);
+            }
+            for (size_t j = p.lets.size(); j > 0; j--) {
+                body = LetStmt::make(p.lets[j - 1].first, p.lets[j - 1].second, body);
+            }
+            body = substitute(replacement, body);
+
+            master_lets.clear();
+            shared_loops.clear();
+            found = false;
+            fused = inject_below_loop(fused, master_prefix + fuse_var,
+                                      body, &master_lets, &shared_loops, &found);
+            internal_assert(found);
+
+            // The checks compare loop bounds of both functions, so
+            // they need both functions' lets in scope.
+            Stmt check = Block::make(region_checks);
+            for (size_t j = p.lets.size(); j > 0; j--) {
+                check = LetStmt::make(p.lets[j - 1].first, p.lets[j - 1].second, check);
+            }
+            for (size_t j = master_lets.size(); j > 0; j--) {
+                check = LetStmt::make(master_lets[j - 1].first, master_lets[j - 1].second, check);
+            }
+            checks = checks.defined() ? Block::make(checks, check) : check;
+        }
+
+        Stmt result = Block::make(checks, fused);
+        for (size_t i = followers.size(); i > 0; i--) {
+            result = ProducerConsumer::make_produce(followers[i - 1].name(), result);
+        }
+        result = ProducerConsumer::make_produce(master.name(), result);
+
+        s = RewriteGroupProductions(member_names, finder.last, result).mutate(s);
+    }
+
+    return s;
+}
+
+}
+}
@@ -0,0 +1,45 @@
+#ifndef HALIDE_FUSE_OUTPUT_LOOPS_H
+#define HALIDE_FUSE_OUTPUT_LOOPS_H
+
+#include "IR.h"
+
+/** \file
+ * Defines passes that interleave sibling loop nests into a single
+ * traversal: one for pipeline outputs marked by Pipeline::fuse_outputs,
+ * and one for compute_root functions marked by Func::compute_with.
+ */
+
+#include <map>
+#include <string>
+
+namespace Halide {
+namespace Internal {
+
+/** Find the root-level productions of the outputs whose schedules
+ * carry the fused_output flag, and rewrite them into one loop nest
+ * that stores all of them, so shared inputs are walked once instead
+ * of once per output. The loop structure is taken from the first
+ * marked output; the others must have plain loop nests over their
+ * pure dimensions. Runs after bounds inference, when each output's
+ * loop bounds have been pinned to its output buffer; the outputs'
+ * buffers are constrained to cover the same region at the time the
+ * directive is applied, so reusing the first output's loops is sound. */
+Stmt fuse_output_loops(Stmt s, const std::vector<Function> &outputs);
+
+/** Fuse the root-level production of each function scheduled with
+ * Func::compute_with into the loop nest of its named sibling: the
+ * sibling's loops from the outermost down to the named pure variable
+ * are shared, and within each iteration of that loop the sibling's
+ * remaining nest runs first and the marked function's after it. The
+ * shared dimensions must cover the same region in both functions;
+ * runtime checks are emitted to enforce this, since unlike fused
+ * outputs there is no output buffer constraint pinning the regions
+ * together. Runs after bounds inference and before variable names
+ * are uniquified, while loop names still follow the
+ * <func>.s0.<var> convention. */
+Stmt fuse_sibling_loop_nests(Stmt s, const std::map<std::string, Function> &env);
+
+}
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include "Generator.h"
 #include "Outputs.h"
 #include "Simplify.h"
+#include "ThreadPool.h"
 
 namespace Halide {
 namespace Internal {
@@ -96,6 +97,9 @@ Outputs compute_outputs(const Target &target,
     if (options.emit_schedule) {
         output_files.schedule_name = base_path + get_extension(".schedule", options);
     }
+    if (options.emit_analysis) {
+        output_files.analysis_name = base_path + get_extension(".analysis.json", options);
+    }
     return output_files;
 }
 
@@ -698,13 +702,28 @@ const std::map<std::string, LoopLevel> &get_halide_looplevel_enum_map() {
     return halide_looplevel_enum_map;
 }
 
-int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
-    const char kUsage[] = "gengen [-g GENERATOR_NAME] [-f FUNCTION_NAME] [-o OUTPUT_DIR] [-r RUNTIME_NAME] [-e EMIT_OPTIONS] [-x EXTENSION_OPTIONS] [-n FILE_BASE_NAME] "
-                          "target=target-string[,target-string...] [generator_arg=value [...]]\n\n"
-                          "  -e  A comma separated list of files to emit. Accepted values are "
-                          "[assembly, bitcode, cpp, h, html, o, static_library, stmt, cpp_stub, schedule]. If omitted, default value is [static_library, h].\n"
-                          "  -x  A comma separated list of file extension pairs to substitute during file naming, "
-                          "in the form [.old=.new[,.old2=.new2]]\n";
+namespace {
+
+const char kGenGenUsage[] = "gengen [-b BATCH_FILE] [-s SWEEP_FILE] [-j JOBS] [-g GENERATOR_NAME] [-f FUNCTION_NAME] [-o OUTPUT_DIR] [-r RUNTIME_NAME] [-e EMIT_OPTIONS] [-x EXTENSION_OPTIONS] [-n FILE_BASE_NAME] "
+                            "target=target-string[,target-string...] [generator_arg=value [...]]\n\n"
+                            "  -b  A file containing one gengen invocation per line, using the same "
+                            "flags as the command line (minus -b and -j). Blank lines and lines starting with '#' "
+                            "are ignored. Any other flags given on the command line are prepended to every line.\n"
+                            "  -s  A sweep manifest: like -b, but each line only lists generator_arg=value "
+                            "assignments for one variant of the generator named with -g. Variants without an "
+                            "explicit -f are emitted as <function_name>_v0, _v1, ... so one sweep produces "
+                            "distinctly-named outputs for an autotuner to link and race.\n"
+                            "  -j  The maximum number of batch or sweep jobs to run in parallel. "
+                            "Defaults to $HL_NUM_THREADS or the number of cores. Only meaningful with -b or -s.\n"
+                            "  -e  A comma separated list of files to emit. Accepted values are "
+                            "[analysis, assembly, bitcode, cpp, h, html, o, static_library, stmt, cpp_stub, schedule]. If omitted, default value is [static_library, h].\n"
+                            "  -x  A comma separated list of file extension pairs to substitute during file naming, "
+                            "in the form [.old=.new[,.old2=.new2]]\n";
+
+// Run a single gengen invocation. args holds everything that was on
+// the command line after argv[0], already split into tokens.
+int generate_filter_one(const std::vector<std::string> &args, std::ostream &cerr) {
+    const char *kUsage = kGenGenUsage;
 
     std::map<std::string, std::string> flags_info = { { "-f", "" },
                                                       { "-g", "" },
@@ -715,9 +734,13 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
                                                       { "-r", "" }};
     std::map<std::string, std::string> generator_args;
 
-    for (int i = 1; i < argc; ++i) {
-        if (argv[i][0] != '-') {
-            std::vector<std::string> v = split_string(argv[i], "=");
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string &arg = args[i];
+        if (arg.empty()) {
+            continue;
+        }
+        if (arg[0] != '-') {
+            std::vector<std::string> v = split_string(arg, "=");
             if (v.size() != 2 || v[0].empty() || v[1].empty()) {
                 cerr << kUsage;
                 return 1;
@@ -725,17 +748,17 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
             generator_args[v[0]] = v[1];
             continue;
         }
-        auto it = flags_info.find(argv[i]);
+        auto it = flags_info.find(arg);
         if (it != flags_info.end()) {
-            if (i + 1 >= argc) {
+            if (i + 1 >= args.size()) {
                 cerr << kUsage;
                 return 1;
             }
-            it->second = argv[i + 1];
+            it->second = args[i + 1];
             ++i;
             continue;
         }
-        cerr << "Unknown flag: " << argv[i] << "\n";
+        cerr << "Unknown flag: " << arg << "\n";
         cerr << kUsage;
         return 1;
     }
@@ -819,9 +842,11 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
                 emit_options.emit_cpp_stub = true;
             } else if (opt == "schedule") {
                 emit_options.emit_schedule = true;
+            } else if (opt == "analysis") {
+                emit_options.emit_analysis = true;
             } else if (!opt.empty()) {
                 cerr << "Unrecognized emit option: " << opt
-                     << " not one of [assembly, bitcode, cpp, h, html, o, static_library, stmt, cpp_stub], ignoring.\n";
+                     << " not one of [analysis, assembly, bitcode, cpp, h, html, o, static_library, stmt, cpp_stub], ignoring.\n";
             }
         }
     }
@@ -893,6 +918,141 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
     return 0;
 }
 
+}  // namespace
+
+int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
+    // Peel off the batch-mode flags; everything else belongs to the
+    // jobs themselves.
+    std::string batch_file, sweep_file;
+    int parallelism = 0;
+    std::vector<std::string> common_args;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-b" && i + 1 < argc) {
+            batch_file = argv[++i];
+        } else if (arg == "-s" && i + 1 < argc) {
+            sweep_file = argv[++i];
+        } else if (arg == "-j" && i + 1 < argc) {
+            parallelism = atoi(argv[++i]);
+        } else {
+            common_args.push_back(arg);
+        }
+    }
+
+    if (!batch_file.empty() && !sweep_file.empty()) {
+        cerr << "-b and -s cannot be combined\n";
+        cerr << kGenGenUsage;
+        return 1;
+    }
+
+    if (batch_file.empty() && sweep_file.empty()) {
+        return generate_filter_one(common_args, cerr);
+    }
+
+    const std::string &jobs_file = batch_file.empty() ? sweep_file : batch_file;
+    std::ifstream f(jobs_file);
+    if (!f) {
+        cerr << "Could not open " << (batch_file.empty() ? "sweep" : "batch")
+             << " file: " << jobs_file << "\n";
+        cerr << kGenGenUsage;
+        return 1;
+    }
+
+    // The base name sweep variants get numbered against: -f if
+    // given, else the generator name.
+    std::string variant_base;
+    for (size_t i = 0; i + 1 < common_args.size(); ++i) {
+        if (common_args[i] == "-g" && variant_base.empty()) {
+            variant_base = common_args[i + 1];
+        } else if (common_args[i] == "-f") {
+            variant_base = common_args[i + 1];
+        }
+    }
+
+    // Each line of the batch file is one gengen invocation, with any
+    // command-line flags prepended. Running them all in one process
+    // amortizes process startup and LLVM initialization over the
+    // whole batch. A sweep manifest is the same thing where each
+    // line is just the generator args that vary, so schedule sweeps
+    // for autotuning don't need a script to spell out the common
+    // flags two hundred times.
+    std::vector<std::vector<std::string>> jobs;
+    std::string line;
+    while (std::getline(f, line)) {
+        std::vector<std::string> job_args = common_args;
+        bool any_tokens = false;
+        bool has_function_name = false;
+        for (const std::string &token : split_string(line, " ")) {
+            if (!token.empty() && token[0] == '#') {
+                break;
+            }
+            if (!token.empty()) {
+                if (token == "-f") {
+                    has_function_name = true;
+                }
+                job_args.push_back(token);
+                any_tokens = true;
+            }
+        }
+        if (!any_tokens) {
+            continue;
+        }
+        if (!sweep_file.empty() && !has_function_name) {
+            // Give each variant a distinct function name so their
+            // outputs don't collide.
+            if (variant_base.empty()) {
+                cerr << "A sweep requires -g (or per-line -f) to name the variants\n";
+                cerr << kGenGenUsage;
+                return 1;
+            }
+            job_args.push_back("-f");
+            job_args.push_back(variant_base + "_v" + std::to_string(jobs.size()));
+        }
+        jobs.push_back(job_args);
+    }
+
+    if (parallelism <= 0) {
+        parallelism = (int) num_compile_time_threads();
+    }
+    parallelism = std::min(parallelism, (int) jobs.size());
+
+    // Give each job a private error stream so that parallel output
+    // doesn't interleave; replay them in order afterwards.
+    std::vector<std::unique_ptr<std::ostringstream>> errors;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        errors.emplace_back(new std::ostringstream);
+    }
+    auto run_job = [&jobs, &errors](size_t i) -> int {
+        try {
+            return generate_filter_one(jobs[i], *errors[i]);
+        } catch (std::exception &e) {
+            *errors[i] << e.what() << "\n";
+            return 1;
+        }
+    };
+
+    int result = 0;
+    if (parallelism <= 1) {
+        for (size_t i = 0; i < jobs.size(); i++) {
+            result |= run_job(i);
+        }
+    } else {
+        ThreadPool<int> pool(parallelism);
+        std::vector<std::future<int>> futures;
+        for (size_t i = 0; i < jobs.size(); i++) {
+            futures.push_back(pool.async(run_job, i));
+        }
+        for (auto &future : futures) {
+            result |= future.get();
+        }
+    }
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        cerr << errors[i]->str();
+    }
+    return result;
+}
+
 GeneratorParamBase::GeneratorParamBase(const std::string &name) : name(name) {
     ObjectInstanceRegistry::register_instance(this, 0, ObjectInstanceRegistry::GeneratorParam,
                                               this, nullptr);
@@ -986,16 +1146,28 @@ GeneratorBase::~GeneratorBase() {
 
 GeneratorBase::ParamInfo::ParamInfo(GeneratorBase *generator, const size_t size) {
     std::set<std::string> names;
-    std::vector<void *> vf = ObjectInstanceRegistry::instances_in_range(
-        generator, size, ObjectInstanceRegistry::FilterParam);
-    for (auto v : vf) {
-        auto param = static_cast<Parameter *>(v);
-        internal_assert(param != nullptr);
-        user_assert(param->is_explicit_name()) << "Params in Generators must have explicit names: " << param->name();
-        user_assert(is_valid_name(param->name())) << "Invalid Param name: " << param->name();
-        user_assert(!names.count(param->name())) << "Duplicate Param name: " << param->name();
-        names.insert(param->name());
-        filter_params.push_back(param);
+
+    // A Generator that enumerates its members via HALIDE_GENERATOR_BIND_MEMBERS
+    // lets us skip the ObjectInstanceRegistry scans below, each of which takes
+    // a global lock and walks a map of every live registered object; that cost
+    // adds up when instantiating the same Generator many times in one process.
+    GeneratorMemberBinder binder;
+    const bool bound = generator->bind_members(binder);
+
+    if (!bound) {
+        // Old-style Param<>/ImageParam members are only discoverable via the
+        // registry scan; bound-member Generators must use Input<> instead.
+        std::vector<void *> vf = ObjectInstanceRegistry::instances_in_range(
+            generator, size, ObjectInstanceRegistry::FilterParam);
+        for (auto v : vf) {
+            auto param = static_cast<Parameter *>(v);
+            internal_assert(param != nullptr);
+            user_assert(param->is_explicit_name()) << "Params in Generators must have explicit names: " << param->name();
+            user_assert(is_valid_name(param->name())) << "Invalid Param name: " << param->name();
+            user_assert(!names.count(param->name())) << "Duplicate Param name: " << param->name();
+            names.insert(param->name());
+            filter_params.push_back(param);
+        }
     }
 
     const auto add_synthetic_params = [this](GIOBase *gio) {
@@ -1016,10 +1188,7 @@ GeneratorBase::ParamInfo::ParamInfo(GeneratorBase *generator, const size_t size)
         }
     };
 
-    std::vector<void *> vi = ObjectInstanceRegistry::instances_in_range(
-        generator, size, ObjectInstanceRegistry::GeneratorInput);
-    for (auto v : vi) {
-        auto input = static_cast<Internal::GeneratorInputBase *>(v);
+    const auto add_input = [&](Internal::GeneratorInputBase *input) {
         internal_assert(input != nullptr);
         user_assert(is_valid_name(input->name())) << "Invalid Input name: (" << input->name() << ")\n";
         user_assert(!names.count(input->name())) << "Duplicate Input name: " << input->name();
@@ -1028,12 +1197,9 @@ GeneratorBase::ParamInfo::ParamInfo(GeneratorBase *generator, const size_t size)
         input->generator = generator;
         filter_inputs.push_back(input);
         add_synthetic_params(input);
-    }
+    };
 
-    std::vector<void *> vo = ObjectInstanceRegistry::instances_in_range(
-        generator, size, ObjectInstanceRegistry::GeneratorOutput);
-    for (auto v : vo) {
-        auto output = static_cast<Internal::GeneratorOutputBase *>(v);
+    const auto add_output = [&](Internal::GeneratorOutputBase *output) {
         internal_assert(output != nullptr);
         user_assert(is_valid_name(output->name())) << "Invalid Output name: (" << output->name() << ")\n";
         user_assert(!names.count(output->name())) << "Duplicate Output name: " << output->name();
@@ -1042,6 +1208,27 @@ GeneratorBase::ParamInfo::ParamInfo(GeneratorBase *generator, const size_t size)
         output->generator = generator;
         filter_outputs.push_back(output);
         add_synthetic_params(output);
+    };
+
+    if (bound) {
+        for (auto *input : binder.inputs()) {
+            add_input(input);
+        }
+        for (auto *output : binder.outputs()) {
+            add_output(output);
+        }
+    } else {
+        std::vector<void *> vi = ObjectInstanceRegistry::instances_in_range(
+            generator, size, ObjectInstanceRegistry::GeneratorInput);
+        for (auto v : vi) {
+            add_input(static_cast<Internal::GeneratorInputBase *>(v));
+        }
+
+        std::vector<void *> vo = ObjectInstanceRegistry::instances_in_range(
+            generator, size, ObjectInstanceRegistry::GeneratorOutput);
+        for (auto v : vo) {
+            add_output(static_cast<Internal::GeneratorOutputBase *>(v));
+        }
     }
 
     if (filter_params.size() > 0 && filter_inputs.size() > 0) {
@@ -1052,10 +1239,7 @@ GeneratorBase::ParamInfo::ParamInfo(GeneratorBase *generator, const size_t size)
         user_error << "Output<> may not be used with Param<> or ImageParam in Generators.\n";
     }
 
-    std::vector<void *> vg = ObjectInstanceRegistry::instances_in_range(
-        generator, size, ObjectInstanceRegistry::GeneratorParam);
-    for (auto v : vg) {
-        auto param = static_cast<GeneratorParamBase *>(v);
+    const auto add_generator_param = [&](GeneratorParamBase *param) {
         internal_assert(param != nullptr);
         user_assert(is_valid_name(param->name)) << "Invalid GeneratorParam name: " << param->name;
         user_assert(!names.count(param->name)) << "Duplicate GeneratorParam name: " << param->name;
@@ -1063,6 +1247,18 @@ GeneratorBase::ParamInfo::ParamInfo(GeneratorBase *generator, const size_t size)
         internal_assert(param->generator == nullptr || param->generator == generator);
         param->generator = generator;
         generator_params.push_back(param);
+    };
+
+    if (bound) {
+        for (auto *param : binder.generator_params()) {
+            add_generator_param(param);
+        }
+    } else {
+        std::vector<void *> vg = ObjectInstanceRegistry::instances_in_range(
+            generator, size, ObjectInstanceRegistry::GeneratorParam);
+        for (auto v : vg) {
+            add_generator_param(static_cast<GeneratorParamBase *>(v));
+        }
     }
 
     // Do in separate loop so that synthetic params are also included
@@ -1074,10 +1270,7 @@ GeneratorBase::ParamInfo::ParamInfo(GeneratorBase *generator, const size_t size)
         g->generator = generator;
     }
 
-    std::vector<void *> vs = ObjectInstanceRegistry::instances_in_range(
-        generator, size, ObjectInstanceRegistry::ScheduleParam);
-    for (auto v : vs) {
-        auto *param = static_cast<ScheduleParamBase*>(v);
+    const auto add_schedule_param = [&](ScheduleParamBase *param) {
         internal_assert(param != nullptr);
         user_assert(!param->name().empty()) << "ScheduleParams must have explicit names when used in Generators.";
         user_assert(is_valid_name(param->name())) << "Invalid ScheduleParam name: " << param->name();
@@ -1085,9 +1278,26 @@ GeneratorBase::ParamInfo::ParamInfo(GeneratorBase *generator, const size_t size)
         names.insert(param->name());
         schedule_params.push_back(param);
         schedule_params_by_name[param->name()] = param;
+    };
+
+    if (bound) {
+        for (auto *param : binder.schedule_params()) {
+            add_schedule_param(param);
+        }
+    } else {
+        std::vector<void *> vs = ObjectInstanceRegistry::instances_in_range(
+            generator, size, ObjectInstanceRegistry::ScheduleParam);
+        for (auto v : vs) {
+            add_schedule_param(static_cast<ScheduleParamBase*>(v));
+        }
     }
 }
 
+bool GeneratorBase::bind_members(GeneratorMemberBinder &binder) {
+    // Default: no explicit enumeration; discover members via the registry scan.
+    return false;
+}
+
 GeneratorBase::ParamInfo &GeneratorBase::param_info() {
     if (!param_info_ptr) {
         param_info_ptr.reset(new ParamInfo(this, size));
@@ -1826,6 +2036,44 @@ void generator_test() {
         tester.call_schedule();
     }
 
+    // Verify that HALIDE_GENERATOR_BIND_MEMBERS produces the same member
+    // enumeration as the registry scan.
+    {
+        class Tester : public Generator<Tester> {
+        public:
+            GeneratorParam<int> gp0{"gp0", 0};
+            ScheduleParam<int> sp0{"sp0", 100};
+            Input<int> input{"input"};
+            Output<Func> output{"output", Int(32), 1};
+
+            HALIDE_GENERATOR_BIND_MEMBERS(gp0, sp0, input, output)
+
+            void generate() {
+                internal_assert(gp0 == 1);
+                Var x;
+                output(x) = input + gp0;
+            }
+            void schedule() {
+                // nothing
+            }
+        };
+
+        Tester tester_instance;
+        tester_instance.init_from_context(context);
+        // Use a base-typed reference to verify by-name lookup still works
+        GeneratorBase &tester = tester_instance;
+
+        tester.set_generator_param("gp0", 1)
+              .set_schedule_param("sp0", 200);
+
+        tester.set_inputs_vector({{StubInput(42)}});
+        tester.call_generate();
+        tester.call_schedule();
+
+        Buffer<int> im = tester_instance.realize(1);
+        internal_assert(im(0) == 43) << "Expected 43 but saw " << im(0);
+    }
+
     // Verify that the Generator's internal phase actually prevents unsupported
     // order of operations (with old-style Generator)
     {
@@ -213,6 +213,48 @@
  *      HALIDE_REGISTER_GENERATOR(ExampleGen, jit_example, SomeNamespace::JitExampleStub)
  * \endcode
  *
+ * In addition to top-level compilation, every registered Generator can be
+ * emitted as a C++ "Stub" header (via the cpp_stub emit option; see the
+ * %.stub.h rule in the Makefile). A Stub allows one Generator to instantiate
+ * another at Halide compilation time and consume its Outputs directly as
+ * Funcs:
+ *
+ * \code
+ *     #include "blur.stub.h"
+ *
+ *     class Sharpen : public Generator<Sharpen> {
+ *     public:
+ *         Input<Func> input{"input", Float(32), 2};
+ *         Output<Func> sharpened{"sharpened", Float(32), 2};
+ *         void generate() {
+ *             blur = Blur(this, { input });
+ *             sharpened(x, y) = 2 * input(x, y) - blur(x, y);
+ *         }
+ *         void schedule() {
+ *             // The inner Generator's Funcs are ordinary Funcs in this
+ *             // pipeline; scheduling directives compose across the
+ *             // Generator boundary. (An inner Generator can also expose
+ *             // loop levels of its own for the enclosing Generator to
+ *             // fill in, via ScheduleParam<LoopLevel>.)
+ *             blur.schedule();
+ *             blur.blurred.compute_at(sharpened, y);
+ *         }
+ *     private:
+ *         Blur blur;
+ *     };
+ * \endcode
+ *
+ * Because the composition happens on the IR (rather than by chaining compiled
+ * pipelines at runtime), the fused result is lowered and optimized as a single
+ * pipeline: compute_at and store_at work across what would otherwise be
+ * object-file boundaries, and intermediate results need not be realized into
+ * full-size buffers. Note that Outputs declared as Output<Buffer> (rather than
+ * Output<Func>) deliberately do not participate in this; they can only be
+ * assigned to an Output<Buffer> of the enclosing Generator, preserving the
+ * buffer constraints they declare. Prefer Output<Func> for outputs that are
+ * meant to be fused into downstream consumers. See
+ * test/generator/stubuser_generator.cpp for a worked example.
+ *
  * Note that a Generator is always executed with a specific Target assigned to it,
  * that you can access via the get_target() method. (You should *not* use the
  * global get_target_from_environment(), etc. methods provided in Target.h)
@@ -324,7 +366,9 @@ EXPORT std::string halide_type_to_c_type(const Type &t);
 
 /** generate_filter_main() is a convenient wrapper for GeneratorRegistry::create() +
  * compile_to_files(); it can be trivially wrapped by a "real" main() to produce a
- * command-line utility for ahead-of-time filter compilation. */
+ * command-line utility for ahead-of-time filter compilation. With -b it runs a
+ * whole batch of invocations (one per line of the batch file, optionally in
+ * parallel) in a single process, amortizing startup costs across the batch. */
 EXPORT int generate_filter_main(int argc, char **argv, std::ostream &cerr);
 
 // select_type<> is to std::conditional as switch is to if:
@@ -2488,6 +2532,36 @@ class SimpleGeneratorFactory;
 // if they cannot return a valid Generator, they must assert-fail.
 using GeneratorFactory = std::function<std::unique_ptr<GeneratorBase>(const GeneratorContext&)>;
 
+/** GeneratorMemberBinder collects the explicit member enumeration from a
+ * Generator that uses HALIDE_GENERATOR_BIND_MEMBERS; it is an implementation
+ * detail of that macro, and user code should never need to use it directly.
+ * Members arrive in the order they are listed, which must match declaration
+ * order. */
+class GeneratorMemberBinder {
+public:
+    void bind(GeneratorParamBase &param) { generator_params_.push_back(&param); }
+    void bind(ScheduleParamBase &param) { schedule_params_.push_back(&param); }
+    void bind(GeneratorInputBase &input) { inputs_.push_back(&input); }
+    void bind(GeneratorOutputBase &output) { outputs_.push_back(&output); }
+
+    template<typename First, typename Second, typename... Rest>
+    void bind(First &first, Second &second, Rest &... rest) {
+        bind(first);
+        bind(second, rest...);
+    }
+
+    const std::vector<GeneratorParamBase *> &generator_params() const { return generator_params_; }
+    const std::vector<ScheduleParamBase *> &schedule_params() const { return schedule_params_; }
+    const std::vector<GeneratorInputBase *> &inputs() const { return inputs_; }
+    const std::vector<GeneratorOutputBase *> &outputs() const { return outputs_; }
+
+private:
+    std::vector<GeneratorParamBase *> generator_params_;
+    std::vector<ScheduleParamBase *> schedule_params_;
+    std::vector<GeneratorInputBase *> inputs_;
+    std::vector<GeneratorOutputBase *> outputs_;
+};
+
 class GeneratorBase : public NamesInterface, public GeneratorContext {
 public:
     struct EmitOptions {
@@ -2501,6 +2575,7 @@ public:
         bool emit_static_library{true};
         bool emit_cpp_stub{false};
         bool emit_schedule{false};
+        bool emit_analysis{false};
         // This is an optional map used to replace the default extensions generated for
         // a file: if an key matches an output extension, emit those files with the
         // corresponding value instead (e.g., ".s" -> ".assembly_text"). This is
@@ -2600,6 +2675,13 @@ protected:
     EXPORT virtual void call_generate() = 0;
     EXPORT virtual void call_schedule() = 0;
 
+    /** Called when lazily building our ParamInfo. A Generator that declares
+     * its members via HALIDE_GENERATOR_BIND_MEMBERS overrides this to
+     * enumerate them directly, which lets us skip the ObjectInstanceRegistry
+     * scan; the default implementation leaves the binder untouched and
+     * returns false, selecting the registry scan. */
+    EXPORT virtual bool bind_members(GeneratorMemberBinder &binder);
+
     EXPORT void track_parameter_values(bool include_outputs);
 
     EXPORT void pre_build();
@@ -3265,4 +3347,38 @@ namespace halide_register_generator {
 #define HALIDE_REGISTER_GENERATOR(...) \
     _HALIDE_REGISTER_GENERATOR_PASTE(_HALIDE_REGISTER_CHOOSER(_HALIDE_REGISTER_ARGCOUNT(__VA_ARGS__)), (__VA_ARGS__))
 
+/** A Generator normally discovers its GeneratorParam, ScheduleParam, Input<>,
+ * and Output<> members on first use, by scanning the global
+ * ObjectInstanceRegistry for objects registered within the Generator's own
+ * address range. That scan takes a process-wide lock and walks a map of every
+ * live registered object, which is measurable overhead when the same Generator
+ * is instantiated many times in one process (e.g. an autotuner sweeping
+ * GeneratorParam values). A Generator may instead enumerate its members
+ * explicitly in its class body:
+ *
+ * \code
+ *     class Example : public Generator<Example> {
+ *     public:
+ *         GeneratorParam<int> tile{"tile", 8};
+ *         Input<Buffer<uint8_t>> input{"input", 2};
+ *         Output<Buffer<uint8_t>> output{"output", 2};
+ *
+ *         HALIDE_GENERATOR_BIND_MEMBERS(tile, input, output)
+ *
+ *         void generate() { ... }
+ *         void schedule() { ... }
+ *     };
+ * \endcode
+ *
+ * The members must be listed in declaration order (the Input<> order defines
+ * the generated function's argument order), and the list must be complete: a
+ * member omitted here is invisible to the Generator machinery. Generators
+ * using this macro must use Input<> rather than Param<> or ImageParam, as
+ * old-style params are only discoverable via the registry scan. */
+#define HALIDE_GENERATOR_BIND_MEMBERS(...) \
+    bool bind_members(::Halide::Internal::GeneratorMemberBinder &binder) override { \
+        binder.bind(__VA_ARGS__); \
+        return true; \
+    }
+
 #endif  // HALIDE_GENERATOR_H_
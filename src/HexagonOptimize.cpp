@@ -528,9 +528,18 @@ private:
             } else {
                 mpy_count = find_mpy_ops(op, Int(8, lanes), Int(8, lanes), 4, mpys, rest);
                 suffix = ".vb.vb";
+                if (mpys.size() != 4) {
+                    // Try the mixed-sign vrmpy (vrmpybusv), which
+                    // multiplies unsigned bytes by signed bytes. This
+                    // is the common shape of 8-bit convolutions:
+                    // unsigned pixels times signed coefficients.
+                    mpys.clear();
+                    rest = Expr();
+                    mpy_count = find_mpy_ops(op, UInt(8, lanes), Int(8, lanes), 4, mpys, rest);
+                    suffix = ".vub.vb";
+                }
             }
 
-            // TODO: suffix = ".vub.vb"
             if (mpy_count > 0 && mpys.size() == 4) {
                 // TODO: It's possible that permuting the order of the
                 // multiply operands can simplify the shuffle away.
@@ -732,14 +741,20 @@ private:
             { "halide.hexagon.avg.vh.vh", i16((wild_i32x + wild_i32x)/2), Pattern::NarrowOps },
             { "halide.hexagon.avg.vw.vw", i32((wild_i64x + wild_i64x)/2), Pattern::NarrowOps },
 
+            { "halide.hexagon.avg.vb.vb", i8((wild_i16x + wild_i16x)/2), Pattern::NarrowOps | Pattern::v62orLater },
+            { "halide.hexagon.avg.vuw.vuw", u32((wild_u64x + wild_u64x)/2), Pattern::NarrowOps | Pattern::v62orLater },
+
             { "halide.hexagon.avg_rnd.vub.vub", u8((wild_u16x + wild_u16x + 1)/2), Pattern::NarrowOps },
             { "halide.hexagon.avg_rnd.vuh.vuh", u16((wild_u32x + wild_u32x + 1)/2), Pattern::NarrowOps },
             { "halide.hexagon.avg_rnd.vh.vh", i16((wild_i32x + wild_i32x + 1)/2), Pattern::NarrowOps },
             { "halide.hexagon.avg_rnd.vw.vw", i32((wild_i64x + wild_i64x + 1)/2), Pattern::NarrowOps },
+            { "halide.hexagon.avg_rnd.vb.vb", i8((wild_i16x + wild_i16x + 1)/2), Pattern::NarrowOps | Pattern::v62orLater },
+            { "halide.hexagon.avg_rnd.vuw.vuw", u32((wild_u64x + wild_u64x + 1)/2), Pattern::NarrowOps | Pattern::v62orLater },
 
             { "halide.hexagon.navg.vub.vub", i8_sat((wild_i16x - wild_i16x)/2), Pattern::NarrowUnsignedOps },
             { "halide.hexagon.navg.vh.vh", i16_sat((wild_i32x - wild_i32x)/2), Pattern::NarrowOps },
             { "halide.hexagon.navg.vw.vw", i32_sat((wild_i64x - wild_i64x)/2), Pattern::NarrowOps },
+            { "halide.hexagon.navg.vb.vb", i8_sat((wild_i16x - wild_i16x)/2), Pattern::NarrowOps | Pattern::v62orLater },
             // vnavg.uw doesn't exist.
 
             // Saturating add/subtract
@@ -1376,7 +1391,7 @@ class EliminateInterleaves : public IRMutator2 {
 
         if (!body.same_as(op->body) || !condition.same_as(op->condition)) {
             return Allocate::make(op->name, op->type, op->extents, condition, body,
-                                  op->new_expr, op->free_function);
+                                  op->new_expr, op->free_function, op->memory_type);
         } else {
             return op;
         }
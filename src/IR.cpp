@@ -1,3 +1,5 @@
+#include <cstdlib>
+
 #include "IR.h"
 #include "IRPrinter.h"
 #include "IRVisitor.h"
@@ -6,6 +8,65 @@
 namespace Halide {
 namespace Internal {
 
+namespace {
+
+// IR nodes are small and are allocated and destroyed in enormous
+// numbers while lowering a big pipeline; the round trips to the
+// global allocator and the recursive teardown at the end of lowering
+// are a measurable fraction of compile time. Recycle freed nodes
+// through per-thread free lists bucketed by size class instead. Each
+// block carries a one-word header recording its size class, in the
+// manner of the runtime's allocation pool in posix_allocator.cpp. The
+// lists are plain PODs so thread teardown order doesn't matter;
+// blocks still pooled at thread exit are deliberately leaked.
+const size_t ir_pool_granularity = 32;
+const size_t ir_pool_num_buckets = 8;  // Blocks of up to 256 bytes
+const size_t ir_pool_bucket_capacity = 2048;
+// The header is 16 bytes so that it doesn't disturb the alignment of
+// the allocation it precedes.
+const size_t ir_pool_header_bytes = 16;
+
+thread_local void *ir_pool_free_list[ir_pool_num_buckets] = {nullptr};
+thread_local size_t ir_pool_free_count[ir_pool_num_buckets] = {0};
+
+}  // namespace
+
+void *IRNode::operator new(size_t size) {
+    size_t bucket = (size + ir_pool_granularity - 1) / ir_pool_granularity;
+    void *block;
+    if (bucket <= ir_pool_num_buckets && ir_pool_free_list[bucket - 1]) {
+        block = ir_pool_free_list[bucket - 1];
+        ir_pool_free_list[bucket - 1] = *(void **)block;
+        ir_pool_free_count[bucket - 1]--;
+    } else if (bucket <= ir_pool_num_buckets) {
+        block = malloc(bucket * ir_pool_granularity + ir_pool_header_bytes);
+        internal_assert(block) << "Out of memory allocating IR node\n";
+    } else {
+        // Too big to pool. A size class of zero tells operator delete
+        // to free the block directly.
+        bucket = 0;
+        block = malloc(size + ir_pool_header_bytes);
+        internal_assert(block) << "Out of memory allocating IR node\n";
+    }
+    *(size_t *)block = bucket;
+    return (char *)block + ir_pool_header_bytes;
+}
+
+void IRNode::operator delete(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    void *block = (char *)ptr - ir_pool_header_bytes;
+    size_t bucket = *(size_t *)block;
+    if (bucket == 0 || ir_pool_free_count[bucket - 1] >= ir_pool_bucket_capacity) {
+        free(block);
+        return;
+    }
+    *(void **)block = ir_pool_free_list[bucket - 1];
+    ir_pool_free_list[bucket - 1] = block;
+    ir_pool_free_count[bucket - 1]++;
+}
+
 Expr Cast::make(Type t, Expr v) {
     internal_assert(v.defined()) << "Cast of undefined\n";
     internal_assert(t.lanes() == v.type().lanes()) << "Cast may not change vector widths\n";
@@ -378,7 +439,8 @@ Stmt Provide::make(const std::string &name, const std::vector<Expr> &values, con
 
 Stmt Allocate::make(const std::string &name, Type type, const std::vector<Expr> &extents,
                     Expr condition, Stmt body,
-                    Expr new_expr, const std::string &free_function) {
+                    Expr new_expr, const std::string &free_function,
+                    MemoryType memory_type) {
     for (size_t i = 0; i < extents.size(); i++) {
         internal_assert(extents[i].defined()) << "Allocate of undefined extent\n";
         internal_assert(extents[i].type().is_scalar() == 1) << "Allocate of vector extent\n";
@@ -390,6 +452,7 @@ Stmt Allocate::make(const std::string &name, Type type, const std::vector<Expr>
     Allocate *node = new Allocate;
     node->name = name;
     node->type = type;
+    node->memory_type = memory_type;
     node->extents = extents;
     node->new_expr = std::move(new_expr);
     node->free_function = free_function;
@@ -439,7 +502,9 @@ Stmt Free::make(const std::string &name) {
     return node;
 }
 
-Stmt Realize::make(const std::string &name, const std::vector<Type> &types, const Region &bounds, Expr condition, Stmt body) {
+Stmt Realize::make(const std::string &name, const std::vector<Type> &types, const Region &bounds,
+                   Expr condition, Stmt body,
+                   MemoryType memory_type) {
     for (size_t i = 0; i < bounds.size(); i++) {
         internal_assert(bounds[i].min.defined()) << "Realize of undefined\n";
         internal_assert(bounds[i].extent.defined()) << "Realize of undefined\n";
@@ -454,6 +519,7 @@ Stmt Realize::make(const std::string &name, const std::vector<Type> &types, cons
     Realize *node = new Realize;
     node->name = name;
     node->types = types;
+    node->memory_type = memory_type;
     node->bounds = bounds;
     node->condition = std::move(condition);
     node->body = std::move(body);
@@ -832,6 +898,10 @@ Call::ConstString Call::shift_left = "shift_left";
 Call::ConstString Call::shift_right = "shift_right";
 Call::ConstString Call::abs = "abs";
 Call::ConstString Call::absd = "absd";
+Call::ConstString Call::widening_add = "widening_add";
+Call::ConstString Call::widening_mul = "widening_mul";
+Call::ConstString Call::rounding_halving_add = "rounding_halving_add";
+Call::ConstString Call::rounding_shift_right = "rounding_shift_right";
 Call::ConstString Call::lerp = "lerp";
 Call::ConstString Call::random = "random";
 Call::ConstString Call::popcount = "popcount";
@@ -864,6 +934,9 @@ Call::ConstString Call::select_mask = "select_mask";
 Call::ConstString Call::extract_mask_element = "extract_mask_element";
 Call::ConstString Call::require = "require";
 Call::ConstString Call::size_of_halide_buffer_t = "size_of_halide_buffer_t";
+Call::ConstString Call::atomic_rmw = "atomic_rmw";
+Call::ConstString Call::gpu_warp_reduce = "gpu_warp_reduce";
+Call::ConstString Call::gpu_warp_broadcast = "gpu_warp_broadcast";
 
 Call::ConstString Call::buffer_get_min = "_halide_buffer_get_min";
 Call::ConstString Call::buffer_get_extent = "_halide_buffer_get_extent";
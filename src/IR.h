@@ -342,6 +342,7 @@ struct Provide : public StmtNode<Provide> {
 struct Allocate : public StmtNode<Allocate> {
     std::string name;
     Type type;
+    MemoryType memory_type;
     std::vector<Expr> extents;
     Expr condition;
 
@@ -358,7 +359,8 @@ struct Allocate : public StmtNode<Allocate> {
 
     EXPORT static Stmt make(const std::string &name, Type type, const std::vector<Expr> &extents,
                             Expr condition, Stmt body,
-                            Expr new_expr = Expr(), const std::string &free_function = std::string());
+                            Expr new_expr = Expr(), const std::string &free_function = std::string(),
+                            MemoryType memory_type = MemoryType::Auto);
 
     /** A routine to check if the extents are all constants, and if so verify
      * the total size is less than 2^31 - 1. If the result is constant, but
@@ -402,11 +404,14 @@ typedef std::vector<Range> Region;
 struct Realize : public StmtNode<Realize> {
     std::string name;
     std::vector<Type> types;
+    MemoryType memory_type;
     Region bounds;
     Expr condition;
     Stmt body;
 
-    EXPORT static Stmt make(const std::string &name, const std::vector<Type> &types, const Region &bounds, Expr condition, Stmt body);
+    EXPORT static Stmt make(const std::string &name, const std::vector<Type> &types, const Region &bounds,
+                            Expr condition, Stmt body,
+                            MemoryType memory_type = MemoryType::Auto);
 
     static const IRNodeType _node_type = IRNodeType::Realize;
 
@@ -480,6 +485,10 @@ struct Call : public ExprNode<Call> {
         shift_right,
         abs,
         absd,
+        widening_add,
+        widening_mul,
+        rounding_halving_add,
+        rounding_shift_right,
         rewrite_buffer,
         random,
         lerp,
@@ -512,7 +521,10 @@ struct Call : public ExprNode<Call> {
         select_mask,
         extract_mask_element,
         require,
-        size_of_halide_buffer_t;
+        size_of_halide_buffer_t,
+        atomic_rmw,
+        gpu_warp_reduce,
+        gpu_warp_broadcast;
 
     // We also declare some symbolic names for some of the runtime
     // functions that we want to construct Call nodes to here to avoid
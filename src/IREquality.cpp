@@ -130,11 +130,13 @@ IRComparer::CmpResult IRComparer::compare_expr(const Expr &a, const Expr &b) {
         return result;
     }
 
-    // If in the future we have hashes for Exprs, this is a good place
-    // to compare the hashes:
-    // if (compare_scalar(a.hash(), b.hash()) != Equal) {
-    //   return result;
-    // }
+    // Differing hashes prove the values differ, and give an
+    // arbitrary but consistent order, so most unequal comparisons
+    // stop here. Matching hashes fall through to the structural walk
+    // below in case of a collision.
+    if (compare_scalar(structural_hash(a), structural_hash(b)) != Equal) {
+        return result;
+    }
 
     if (compare_scalar(a->node_type, b->node_type) != Equal) {
         return result;
@@ -185,6 +187,10 @@ IRComparer::CmpResult IRComparer::compare_stmt(const Stmt &a, const Stmt &b) {
         return result;
     }
 
+    if (compare_scalar(structural_hash(a), structural_hash(b)) != Equal) {
+        return result;
+    }
+
     if (compare_scalar(a->node_type, b->node_type) != Equal) {
         return result;
     }
@@ -465,6 +471,298 @@ void IRComparer::visit(const Prefetch *op) {
 } // namespace
 
 
+
+namespace {
+
+// A reasonable bit-mixing combiner (the one boost::hash_combine uses).
+uint64_t hash_combine(uint64_t h, uint64_t v) {
+    return h ^ (v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+}
+
+uint64_t hash_string(uint64_t h, const string &s) {
+    h = hash_combine(h, s.size());
+    for (char c : s) {
+        h = hash_combine(h, (uint64_t)(uint8_t)c);
+    }
+    return h;
+}
+
+uint64_t hash_type(uint64_t h, Type t) {
+    h = hash_combine(h, (uint64_t)t.code());
+    h = hash_combine(h, (uint64_t)t.bits());
+    h = hash_combine(h, (uint64_t)t.lanes());
+    h = hash_combine(h, (uintptr_t)t.handle_type);
+    return h;
+}
+
+uint64_t hash_node(const IRNode *node);
+
+uint64_t hash_expr(uint64_t h, const Expr &e) {
+    // A distinguished value for undefined, mirroring how
+    // IRComparer::compare_expr orders undefined Exprs.
+    return hash_combine(h, e.defined() ? hash_node(e.get()) : 0x5a17);
+}
+
+uint64_t hash_stmt(uint64_t h, const Stmt &s) {
+    return hash_combine(h, s.defined() ? hash_node(s.get()) : 0x5a17);
+}
+
+uint64_t hash_expr_vector(uint64_t h, const vector<Expr> &v) {
+    h = hash_combine(h, v.size());
+    for (const Expr &e : v) {
+        h = hash_expr(h, e);
+    }
+    return h;
+}
+
+// Hashes exactly the fields IRComparer compares, so that deep-equal
+// nodes are guaranteed to hash alike. Fields the comparer ignores
+// must stay out of the hash.
+uint64_t compute_hash(const IRNode *node) {
+    uint64_t h = hash_combine(0, (uint64_t)node->node_type);
+    switch (node->node_type) {
+    case IRNodeType::IntImm: {
+        const IntImm *op = (const IntImm *)node;
+        h = hash_type(h, op->type);
+        h = hash_combine(h, (uint64_t)op->value);
+        break;
+    }
+    case IRNodeType::UIntImm: {
+        const UIntImm *op = (const UIntImm *)node;
+        h = hash_type(h, op->type);
+        h = hash_combine(h, op->value);
+        break;
+    }
+    case IRNodeType::FloatImm: {
+        const FloatImm *op = (const FloatImm *)node;
+        h = hash_type(h, op->type);
+        uint64_t bits;
+        memcpy(&bits, &op->value, sizeof(bits));
+        h = hash_combine(h, bits);
+        break;
+    }
+    case IRNodeType::StringImm: {
+        const StringImm *op = (const StringImm *)node;
+        h = hash_type(h, op->type);
+        h = hash_string(h, op->value);
+        break;
+    }
+    case IRNodeType::Cast: {
+        const Cast *op = (const Cast *)node;
+        h = hash_type(h, op->type);
+        h = hash_expr(h, op->value);
+        break;
+    }
+    case IRNodeType::Variable: {
+        const Variable *op = (const Variable *)node;
+        h = hash_type(h, op->type);
+        h = hash_string(h, op->name);
+        break;
+    }
+    case IRNodeType::Add: case IRNodeType::Sub: case IRNodeType::Mul:
+    case IRNodeType::Div: case IRNodeType::Mod: case IRNodeType::Min:
+    case IRNodeType::Max: case IRNodeType::EQ: case IRNodeType::NE:
+    case IRNodeType::LT: case IRNodeType::LE: case IRNodeType::GT:
+    case IRNodeType::GE: case IRNodeType::And: case IRNodeType::Or: {
+        // All the binary operators share a layout.
+        const Add *op = (const Add *)node;
+        h = hash_type(h, op->type);
+        h = hash_expr(h, op->a);
+        h = hash_expr(h, op->b);
+        break;
+    }
+    case IRNodeType::Not: {
+        const Not *op = (const Not *)node;
+        h = hash_type(h, op->type);
+        h = hash_expr(h, op->a);
+        break;
+    }
+    case IRNodeType::Select: {
+        const Select *op = (const Select *)node;
+        h = hash_type(h, op->type);
+        h = hash_expr(h, op->condition);
+        h = hash_expr(h, op->true_value);
+        h = hash_expr(h, op->false_value);
+        break;
+    }
+    case IRNodeType::Load: {
+        const Load *op = (const Load *)node;
+        h = hash_type(h, op->type);
+        h = hash_string(h, op->name);
+        h = hash_expr(h, op->predicate);
+        h = hash_expr(h, op->index);
+        break;
+    }
+    case IRNodeType::Ramp: {
+        const Ramp *op = (const Ramp *)node;
+        h = hash_type(h, op->type);
+        h = hash_expr(h, op->base);
+        h = hash_expr(h, op->stride);
+        break;
+    }
+    case IRNodeType::Broadcast: {
+        const Broadcast *op = (const Broadcast *)node;
+        h = hash_type(h, op->type);
+        h = hash_expr(h, op->value);
+        break;
+    }
+    case IRNodeType::Call: {
+        const Call *op = (const Call *)node;
+        h = hash_type(h, op->type);
+        h = hash_string(h, op->name);
+        h = hash_combine(h, (uint64_t)op->call_type);
+        h = hash_combine(h, (uint64_t)op->value_index);
+        h = hash_expr_vector(h, op->args);
+        break;
+    }
+    case IRNodeType::Let: {
+        const Let *op = (const Let *)node;
+        h = hash_type(h, op->type);
+        h = hash_string(h, op->name);
+        h = hash_expr(h, op->value);
+        h = hash_expr(h, op->body);
+        break;
+    }
+    case IRNodeType::Shuffle: {
+        const Shuffle *op = (const Shuffle *)node;
+        h = hash_type(h, op->type);
+        h = hash_expr_vector(h, op->vectors);
+        h = hash_combine(h, op->indices.size());
+        for (int i : op->indices) {
+            h = hash_combine(h, (uint64_t)i);
+        }
+        break;
+    }
+    case IRNodeType::LetStmt: {
+        const LetStmt *op = (const LetStmt *)node;
+        h = hash_string(h, op->name);
+        h = hash_expr(h, op->value);
+        h = hash_stmt(h, op->body);
+        break;
+    }
+    case IRNodeType::AssertStmt: {
+        const AssertStmt *op = (const AssertStmt *)node;
+        h = hash_expr(h, op->condition);
+        h = hash_expr(h, op->message);
+        break;
+    }
+    case IRNodeType::ProducerConsumer: {
+        const ProducerConsumer *op = (const ProducerConsumer *)node;
+        h = hash_string(h, op->name);
+        h = hash_combine(h, (uint64_t)op->is_producer);
+        h = hash_stmt(h, op->body);
+        break;
+    }
+    case IRNodeType::For: {
+        const For *op = (const For *)node;
+        h = hash_string(h, op->name);
+        h = hash_combine(h, (uint64_t)op->for_type);
+        h = hash_expr(h, op->min);
+        h = hash_expr(h, op->extent);
+        h = hash_stmt(h, op->body);
+        break;
+    }
+    case IRNodeType::Store: {
+        const Store *op = (const Store *)node;
+        h = hash_string(h, op->name);
+        h = hash_expr(h, op->predicate);
+        h = hash_expr(h, op->value);
+        h = hash_expr(h, op->index);
+        break;
+    }
+    case IRNodeType::Provide: {
+        const Provide *op = (const Provide *)node;
+        h = hash_string(h, op->name);
+        h = hash_expr_vector(h, op->args);
+        h = hash_expr_vector(h, op->values);
+        break;
+    }
+    case IRNodeType::Allocate: {
+        const Allocate *op = (const Allocate *)node;
+        h = hash_string(h, op->name);
+        h = hash_expr_vector(h, op->extents);
+        h = hash_stmt(h, op->body);
+        h = hash_expr(h, op->condition);
+        h = hash_expr(h, op->new_expr);
+        h = hash_string(h, op->free_function);
+        break;
+    }
+    case IRNodeType::Free: {
+        const Free *op = (const Free *)node;
+        h = hash_string(h, op->name);
+        break;
+    }
+    case IRNodeType::Realize: {
+        const Realize *op = (const Realize *)node;
+        h = hash_string(h, op->name);
+        h = hash_combine(h, op->types.size());
+        h = hash_combine(h, op->bounds.size());
+        for (Type t : op->types) {
+            h = hash_type(h, t);
+        }
+        for (const Range &r : op->bounds) {
+            h = hash_expr(h, r.min);
+            h = hash_expr(h, r.extent);
+        }
+        h = hash_stmt(h, op->body);
+        h = hash_expr(h, op->condition);
+        break;
+    }
+    case IRNodeType::Block: {
+        const Block *op = (const Block *)node;
+        h = hash_stmt(h, op->first);
+        h = hash_stmt(h, op->rest);
+        break;
+    }
+    case IRNodeType::IfThenElse: {
+        const IfThenElse *op = (const IfThenElse *)node;
+        h = hash_expr(h, op->condition);
+        h = hash_stmt(h, op->then_case);
+        h = hash_stmt(h, op->else_case);
+        break;
+    }
+    case IRNodeType::Evaluate: {
+        const Evaluate *op = (const Evaluate *)node;
+        h = hash_expr(h, op->value);
+        break;
+    }
+    case IRNodeType::Prefetch: {
+        const Prefetch *op = (const Prefetch *)node;
+        h = hash_string(h, op->name);
+        h = hash_combine(h, op->bounds.size());
+        for (const Range &r : op->bounds) {
+            h = hash_expr(h, r.min);
+            h = hash_expr(h, r.extent);
+        }
+        break;
+    }
+    }
+    // Zero is reserved to mean not-yet-computed.
+    return h == 0 ? 1 : h;
+}
+
+uint64_t hash_node(const IRNode *node) {
+    // Relaxed ordering suffices: the hash is a pure function of the
+    // immutable node, so threads racing on the first use all store
+    // the same value.
+    uint64_t h = node->structural_hash_cache.load(std::memory_order_relaxed);
+    if (h == 0) {
+        h = compute_hash(node);
+        node->structural_hash_cache.store(h, std::memory_order_relaxed);
+    }
+    return h;
+}
+
+} // namespace
+
+uint64_t structural_hash(const Expr &e) {
+    return e.defined() ? hash_node(e.get()) : 0x5a17;
+}
+
+uint64_t structural_hash(const Stmt &s) {
+    return s.defined() ? hash_node(s.get()) : 0x5a17;
+}
+
 // Now the methods exposed in the header.
 bool equal(const Expr &a, const Expr &b) {
     return IRComparer().compare_expr(a, b) == IRComparer::Equal;
@@ -112,6 +112,18 @@ EXPORT bool graph_equal(const Expr &a, const Expr &b);
 EXPORT bool graph_equal(const Stmt &a, const Stmt &b);
 // @}
 
+/** Compute a hash of an IR node's value. Nodes that compare equal
+ * under the deep comparison above hash identically, so differing
+ * hashes prove inequality, and comparisons can order by hash before
+ * falling back to a structural walk. The hash is cached on the node
+ * and shared subtrees are hashed once, so repeated comparisons of the
+ * same trees are cheap. Hashing an undefined Expr or Stmt is legal
+ * and produces a distinguished value. */
+// @{
+EXPORT uint64_t structural_hash(const Expr &e);
+EXPORT uint64_t structural_hash(const Stmt &s);
+// @}
+
 
 
 EXPORT void ir_equality_test();
@@ -46,6 +46,39 @@ void expr_match_test() {
 
     internal_assert(expr_match(vec_wild * 3, Ramp::make(x, y, 4) * 3, matches));
 
+    // A PatternIndex must keep every pattern expr_match would accept,
+    // and must prune patterns rooted at a different shape.
+    {
+        PatternIndex index;
+        Expr patterns[] = {
+            cast(Int(8, 0), (w + w)/2),       // 0
+            cast(Int(8, 0), (w - w)/2),       // 1
+            cast(UInt(8, 0), (w + w)/2),      // 2
+            cast(Int(16, 0), min(w, w)),      // 3
+            w + w,                            // 4
+            fw                                // 5
+        };
+        for (const Expr &p : patterns) {
+            index.add(p);
+        }
+
+        Expr e = cast(Int(8), (x + y)/2);
+        const vector<int> &c = index.candidates(e);
+        internal_assert(c.size() == 2 && c[0] == 0 && c[1] == 1)
+            << "Wrong candidate set for " << e << "\n";
+        for (int i : c) {
+            // The one surviving match must still be found.
+            if (expr_match(patterns[i], e, matches)) {
+                internal_assert(i == 0);
+            }
+        }
+
+        internal_assert(index.candidates(cast(Int(16), min(x, y))).size() == 1);
+        internal_assert(index.candidates(x + y).size() == 1);
+        internal_assert(index.candidates(fx).size() == 1);
+        internal_assert(index.candidates(cast(Float(64), x)).empty());
+    }
+
     std::cout << "expr_match test passed" << std::endl;
 }
 
@@ -283,4 +316,87 @@ bool expr_match(Expr pattern, Expr expr, map<string, Expr> &matches) {
     }
 }
 
+namespace {
+// The operand that IRMatch recurses into first, for the node kinds
+// that appear at the root of the backends' pattern tables. Nodes not
+// listed here are just bucketed by their root shape alone.
+Expr first_operand(const Expr &e) {
+    switch (e->node_type) {
+    case IRNodeType::Cast: return e.as<Cast>()->value;
+    case IRNodeType::Not: return e.as<Not>()->a;
+    case IRNodeType::Broadcast: return e.as<Broadcast>()->value;
+    case IRNodeType::Add: return e.as<Add>()->a;
+    case IRNodeType::Sub: return e.as<Sub>()->a;
+    case IRNodeType::Mul: return e.as<Mul>()->a;
+    case IRNodeType::Div: return e.as<Div>()->a;
+    case IRNodeType::Mod: return e.as<Mod>()->a;
+    case IRNodeType::Min: return e.as<Min>()->a;
+    case IRNodeType::Max: return e.as<Max>()->a;
+    default: return Expr();
+    }
+}
+}
+
+PatternIndex::Shape PatternIndex::shape_of(const Expr &e) {
+    Shape s;
+    s.node = e->node_type;
+    Type t = e.type();
+    s.code = t.code();
+    s.bits = t.bits();
+    s.lanes = t.lanes();
+    s.any_node = s.any_bits = s.any_lanes = s.any_child = false;
+    Expr child = first_operand(e);
+    if (child.defined()) {
+        s.child = child->node_type;
+    } else {
+        // Both sides of could_match compute the same placeholder, so
+        // childless nodes compare equal on this field.
+        s.child = s.node;
+    }
+    return s;
+}
+
+bool PatternIndex::could_match(const Shape &pattern, const Shape &expr) {
+    // expr_match checks type codes even for wildcards, so the code
+    // field is never a don't-care.
+    return ((pattern.any_node || pattern.node == expr.node) &&
+            pattern.code == expr.code &&
+            (pattern.any_bits || pattern.bits == expr.bits) &&
+            (pattern.any_lanes || pattern.lanes == expr.lanes) &&
+            (pattern.any_child || pattern.child == expr.child));
+}
+
+void PatternIndex::add(const Expr &pattern) {
+    internal_assert(buckets.empty())
+        << "PatternIndex::add called after PatternIndex::candidates\n";
+    Shape s = shape_of(pattern);
+    // Wildcard variables match any node of the right type, and the
+    // types_match rules treat zero bits or lanes as "match anything".
+    s.any_node = (s.node == IRNodeType::Variable);
+    s.any_bits = (s.bits == 0);
+    s.any_lanes = (s.lanes == 0);
+    s.any_child = (s.any_node || s.child == IRNodeType::Variable);
+    shapes.push_back(s);
+}
+
+const std::vector<int> &PatternIndex::candidates(const Expr &expr) const {
+    Shape s = shape_of(expr);
+    uint64_t key = (((uint64_t)s.node << 56) |
+                    ((uint64_t)s.child << 48) |
+                    ((uint64_t)s.code << 40) |
+                    ((uint64_t)s.bits << 32) |
+                    (uint32_t)s.lanes);
+    auto iter = buckets.find(key);
+    if (iter == buckets.end()) {
+        vector<int> &bucket = buckets[key];
+        for (size_t i = 0; i < shapes.size(); i++) {
+            if (could_match(shapes[i], s)) {
+                bucket.push_back((int)i);
+            }
+        }
+        return bucket;
+    }
+    return iter->second;
+}
+
 }}
@@ -43,6 +43,54 @@ EXPORT bool expr_match(Expr pattern, Expr expr, std::vector<Expr> &result);
  */
 EXPORT bool expr_match(Expr pattern, Expr expr, std::map<std::string, Expr> &result);
 
+/** An index over a fixed table of pattern expressions of the form
+ * accepted by expr_match. The backends keep tables of candidate
+ * peephole patterns and run expr_match on every entry for each IR
+ * node visited. Classifying the patterns up-front by the shape of
+ * their root node turns that linear scan into a bucket lookup, so the
+ * per-node matching cost scales with the number of patterns that
+ * could plausibly match instead of the size of the table. A pattern
+ * is only ever filtered out when expr_match was certain to fail on
+ * it, and the surviving patterns come back in the order they were
+ * added, so iterating over candidates() is a drop-in replacement for
+ * iterating over the table. */
+class PatternIndex {
+public:
+    /** Add a pattern to the index. Patterns are numbered in the order
+     * they are added, starting from zero. All patterns must be added
+     * before the first call to candidates. */
+    EXPORT void add(const Expr &pattern);
+
+    /** The numbers of the patterns whose roots could match the given
+     * expression, in the order the patterns were added. Buckets are
+     * built lazily and memoized per root shape, so in steady state
+     * this is a single map lookup. */
+    EXPORT const std::vector<int> &candidates(const Expr &expr) const;
+
+private:
+    /** A conservative description of the root of an expression: the
+     * IR node type, the type code, bits, and lanes, and the IR node
+     * type of the first operand expr_match will recurse into. Any of
+     * these except the type code may instead be flagged as matching
+     * anything when the pattern leaves it unconstrained. */
+    struct Shape {
+        IRNodeType node;
+        halide_type_code_t code;
+        int bits, lanes;
+        IRNodeType child;
+        bool any_node, any_bits, any_lanes, any_child;
+    };
+
+    static Shape shape_of(const Expr &e);
+    static bool could_match(const Shape &pattern, const Shape &expr);
+
+    std::vector<Shape> shapes;
+
+    /** Maps the packed shape of previously-seen expressions to the
+     * numbers of the patterns that could match them. */
+    mutable std::map<uint64_t, std::vector<int>> buckets;
+};
+
 EXPORT void expr_match_test();
 
 }
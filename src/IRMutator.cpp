@@ -171,6 +171,12 @@ void IRMutator::visit(const Call *op) {
 }
 
 void IRMutator::visit(const Let *op) {
+    // Note that this recurses on the body, so the spine of a deep Let
+    // chain costs stack proportional to its depth. Don't walk it
+    // iteratively here: every inner Let must be re-dispatched through
+    // mutate() so that derived visitors see it. Leaf classes that know
+    // their own overrides are spine-safe may flatten the walk
+    // themselves (CodeGen_LLVM does).
     Expr value = mutate(op->value);
     Expr body = mutate(op->body);
     if (value.same_as(op->value) &&
@@ -182,6 +188,7 @@ void IRMutator::visit(const Let *op) {
 }
 
 void IRMutator::visit(const LetStmt *op) {
+    // See the note on visit(Let) above.
     Expr value = mutate(op->value);
     Stmt body = mutate(op->body);
     if (value.same_as(op->value) &&
@@ -284,7 +291,8 @@ void IRMutator::visit(const Allocate *op) {
         stmt = op;
     } else {
         stmt = Allocate::make(op->name, op->type, new_extents, std::move(condition),
-                              std::move(body), std::move(new_expr), op->free_function);
+                              std::move(body), std::move(new_expr), op->free_function,
+                              op->memory_type);
     }
 }
 
@@ -307,7 +315,8 @@ void IRMutator::visit(const Realize *op) {
         stmt = op;
     } else {
         stmt = Realize::make(op->name, op->types, new_bounds,
-                             std::move(condition), std::move(body));
+                             std::move(condition), std::move(body),
+                             op->memory_type);
     }
 }
 
@@ -326,6 +335,7 @@ void IRMutator::visit(const Prefetch *op) {
 }
 
 void IRMutator::visit(const Block *op) {
+    // See the note on visit(Let) above.
     Stmt first = mutate(op->first);
     Stmt rest = mutate(op->rest);
     if (first.same_as(op->first) &&
@@ -363,10 +373,10 @@ void IRMutator::visit(const Shuffle *op) {
     bool changed = false;
 
     for (size_t i = 0; i < op->vectors.size(); i++) {
-        Expr old_vector = op->vectors[i];
+        const Expr &old_vector = op->vectors[i];
         Expr new_vector = mutate(old_vector);
         if (!new_vector.same_as(old_vector)) changed = true;
-        new_vectors[i] = new_vector;
+        new_vectors[i] = std::move(new_vector);
     }
 
     if (!changed) {
@@ -521,6 +531,7 @@ Expr IRMutator2::visit(const Call *op) {
 }
 
 Expr IRMutator2::visit(const Let *op) {
+    // See the note on IRMutator::visit(const Let *) above.
     Expr value = mutate(op->value);
     Expr body = mutate(op->body);
     if (value.same_as(op->value) &&
@@ -531,6 +542,7 @@ Expr IRMutator2::visit(const Let *op) {
 }
 
 Stmt IRMutator2::visit(const LetStmt *op) {
+    // See the note on IRMutator::visit(const Let *) above.
     Expr value = mutate(op->value);
     Stmt body = mutate(op->body);
     if (value.same_as(op->value) &&
@@ -627,7 +639,8 @@ Stmt IRMutator2::visit(const Allocate *op) {
         return op;
     }
     return Allocate::make(op->name, op->type, new_extents, std::move(condition),
-                              std::move(body), std::move(new_expr), op->free_function);
+                              std::move(body), std::move(new_expr), op->free_function,
+                              op->memory_type);
 }
 
 Stmt IRMutator2::visit(const Free *op) {
@@ -649,7 +662,8 @@ Stmt IRMutator2::visit(const Realize *op) {
         return op;
     }
     return Realize::make(op->name, op->types, new_bounds,
-                             std::move(condition), std::move(body));
+                             std::move(condition), std::move(body),
+                             op->memory_type);
 }
 
 Stmt IRMutator2::visit(const Prefetch *op) {
@@ -666,6 +680,7 @@ Stmt IRMutator2::visit(const Prefetch *op) {
 }
 
 Stmt IRMutator2::visit(const Block *op) {
+    // See the note on IRMutator::visit(const Let *) above.
     Stmt first = mutate(op->first);
     Stmt rest = mutate(op->rest);
     if (first.same_as(op->first) &&
@@ -700,10 +715,10 @@ Expr IRMutator2::visit(const Shuffle *op) {
     bool changed = false;
 
     for (size_t i = 0; i < op->vectors.size(); i++) {
-        Expr old_vector = op->vectors[i];
+        const Expr &old_vector = op->vectors[i];
         Expr new_vector = mutate(old_vector);
         if (!new_vector.same_as(old_vector)) changed = true;
-        new_vectors[i] = new_vector;
+        new_vectors[i] = std::move(new_vector);
     }
 
     if (!changed) {
@@ -9,6 +9,7 @@
 #include "Var.h"
 #include "Debug.h"
 #include "CSE.h"
+#include "Float16.h"
 
 namespace Halide {
 
@@ -291,6 +292,12 @@ Expr make_const_helper(Type t, T val) {
         return UIntImm::make(t, (uint64_t)val);
     } else if (t.is_float()) {
         return FloatImm::make(t, (double)val);
+    } else if (t.is_bfloat()) {
+        // There's no bfloat immediate; represent the constant as its
+        // bits. EmulateFloat16Math treats bfloat values as opaque
+        // 16-bit payloads, so this is the canonical constant form.
+        internal_assert(t.bits() == 16) << "Only 16-bit bfloats are supported\n";
+        return reinterpret(t, UIntImm::make(UInt(16), bfloat16_t((double)val).to_bits()));
     } else {
         internal_error << "Can't make a constant of type " << t << "\n";
         return Expr();
@@ -884,6 +891,33 @@ Expr memoize_tag_helper(Expr result, const std::vector<Expr> &cache_key_values)
                                 args, Internal::Call::PureIntrinsic);
 }
 
+Expr lower_resampling_intrinsic(const Call *op) {
+    internal_assert(op->args.size() == 2);
+    Expr a = op->args[0], b = op->args[1];
+    Type t = op->type;
+    if (op->is_intrinsic(Call::widening_add)) {
+        return cast(t, a) + cast(t, b);
+    } else if (op->is_intrinsic(Call::widening_mul)) {
+        return cast(t, a) * cast(t, b);
+    } else if (op->is_intrinsic(Call::rounding_halving_add)) {
+        // The canonical form CodeGen_ARM matches to vrhadd, and
+        // Hexagon to vavg..rnd.
+        Type w = t.with_bits(t.bits() * 2);
+        return cast(t, (cast(w, a) + cast(w, b) + 1) / 2);
+    } else if (op->is_intrinsic(Call::rounding_shift_right)) {
+        // (a + (1 << (b - 1))) >> b, computed at twice the width so
+        // adding the rounding term cannot overflow. Written with a
+        // pre-shift of a so that b == 0 needs no special case:
+        // (2a + 2^b) >> (b + 1) == (a + 2^(b-1)) >> b.
+        Type w = t.with_bits(t.bits() * 2);
+        Expr wb = cast(w, b);
+        return cast(t, ((cast(w, a) << 1) + (make_one(w) << wb)) >> (wb + 1));
+    } else {
+        internal_error << "Not a resampling intrinsic: " << op->name << "\n";
+        return Expr();
+    }
+}
+
 }  // namespace Internal
 
 Expr saturating_cast(Type t, Expr e) {
@@ -198,6 +198,14 @@ struct BufferBuilder {
  * otherwise undefined. */
 Expr strided_ramp_base(Expr e, int stride = 1);
 
+/** Rewrite one of the resampling intrinsics (widening_add,
+ * widening_mul, rounding_halving_add, rounding_shift_right) as
+ * equivalent arithmetic at twice the bit width, in the canonical form
+ * the backend peephole patterns recognize. The backends expand the
+ * intrinsics through this immediately before instruction selection,
+ * so no earlier pass can rewrite the pattern out from under them. */
+EXPORT Expr lower_resampling_intrinsic(const Call *op);
+
 } // namespace Internal
 
 /** Cast an expression to the halide type corresponding to the C++ type T. */
@@ -1909,6 +1917,159 @@ Expr saturating_cast(Expr e) {
  * maximum values of the result type. */
 EXPORT Expr saturating_cast(Type t, Expr e);
 
+/** Compute a + b at twice the bit width of the arguments, so the
+ * addition cannot overflow or wrap. The arguments must have the same
+ * integer type, of 32 bits or narrower. Kept as a named intrinsic
+ * until instruction selection (see rounding_halving_add for why);
+ * lowers to a single widening add (e.g. vaddl) where one exists. */
+inline Expr widening_add(Expr a, Expr b) {
+    user_assert(a.defined() && b.defined()) << "widening_add of undefined Expr\n";
+    Internal::match_types(a, b);
+    Type t = a.type();
+    user_assert((t.is_int() || t.is_uint()) && t.bits() <= 32)
+        << "widening_add requires an integer type of 32 bits or fewer\n";
+    return Internal::Call::make(t.with_bits(t.bits() * 2),
+                                Internal::Call::widening_add, {std::move(a), std::move(b)},
+                                Internal::Call::PureIntrinsic);
+}
+
+/** Compute a * b at twice the bit width of the arguments, so the
+ * multiplication cannot overflow or wrap. The arguments must have the
+ * same integer type, of 32 bits or narrower. Kept as a named
+ * intrinsic until instruction selection (see rounding_halving_add for
+ * why); lowers to a single widening multiply (e.g. vmull, pmull
+ * pairs, Hexagon's vmpy) where one exists. */
+inline Expr widening_mul(Expr a, Expr b) {
+    user_assert(a.defined() && b.defined()) << "widening_mul of undefined Expr\n";
+    Internal::match_types(a, b);
+    Type t = a.type();
+    user_assert((t.is_int() || t.is_uint()) && t.bits() <= 32)
+        << "widening_mul requires an integer type of 32 bits or fewer\n";
+    return Internal::Call::make(t.with_bits(t.bits() * 2),
+                                Internal::Call::widening_mul, {std::move(a), std::move(b)},
+                                Internal::Call::PureIntrinsic);
+}
+
+/** Compute a + b, saturating at the range of the type instead of
+ * overflowing. The arguments must have the same integer type, of 32
+ * bits or narrower. This constructs the canonical widen-clamp-narrow
+ * form that the x86, ARM, and Hexagon backends recognize, so it
+ * lowers to a single saturating add (e.g. paddsb, vqadd) where one
+ * exists. */
+inline Expr saturating_add(Expr a, Expr b) {
+    user_assert(a.defined() && b.defined()) << "saturating_add of undefined Expr\n";
+    Internal::match_types(a, b);
+    Type t = a.type();
+    user_assert((t.is_int() || t.is_uint()) && t.bits() <= 32)
+        << "saturating_add requires an integer type of 32 bits or fewer\n";
+    Type wide = t.with_bits(t.bits() * 2);
+    return saturating_cast(t, cast(wide, std::move(a)) + cast(wide, std::move(b)));
+}
+
+/** Compute a - b, saturating at the range of the type instead of
+ * overflowing. The arguments must have the same integer type, of 32
+ * bits or narrower. The intermediate is always signed, so for
+ * unsigned types this saturates below at zero. Lowers to a single
+ * saturating subtract (e.g. psubsw, vqsub) where one exists. */
+inline Expr saturating_sub(Expr a, Expr b) {
+    user_assert(a.defined() && b.defined()) << "saturating_sub of undefined Expr\n";
+    Internal::match_types(a, b);
+    Type t = a.type();
+    user_assert((t.is_int() || t.is_uint()) && t.bits() <= 32)
+        << "saturating_sub requires an integer type of 32 bits or fewer\n";
+    Type wide = Int(t.bits() * 2, t.lanes());
+    return saturating_cast(t, cast(wide, std::move(a)) - cast(wide, std::move(b)));
+}
+
+/** Compute (a + b) / 2, rounding down, without overflowing in the
+ * intermediate. The arguments must have the same integer type, of 32
+ * bits or narrower. Lowers to a single halving add (e.g. vhadd,
+ * Hexagon's vavg) where one exists. */
+inline Expr halving_add(Expr a, Expr b) {
+    user_assert(a.defined() && b.defined()) << "halving_add of undefined Expr\n";
+    Internal::match_types(a, b);
+    Type t = a.type();
+    user_assert((t.is_int() || t.is_uint()) && t.bits() <= 32)
+        << "halving_add requires an integer type of 32 bits or fewer\n";
+    Type wide = t.with_bits(t.bits() * 2);
+    return cast(t, (cast(wide, std::move(a)) + cast(wide, std::move(b))) / 2);
+}
+
+/** Compute (a + b + 1) / 2, i.e. the average rounded to nearest,
+ * without overflowing in the intermediate. The arguments must have
+ * the same integer type, of 32 bits or narrower. Kept as a named
+ * intrinsic until instruction selection, so that simplification
+ * cannot rewrite it into a form the backend peephole patterns no
+ * longer recognize; lowers to a single rounding halving add
+ * (e.g. pavgb, vrhadd, Hexagon's vavg with rounding) where one
+ * exists, and warns at compile time when a vectorized use has no
+ * native instruction on the target. */
+inline Expr rounding_halving_add(Expr a, Expr b) {
+    user_assert(a.defined() && b.defined()) << "rounding_halving_add of undefined Expr\n";
+    Internal::match_types(a, b);
+    Type t = a.type();
+    user_assert((t.is_int() || t.is_uint()) && t.bits() <= 32)
+        << "rounding_halving_add requires an integer type of 32 bits or fewer\n";
+    return Internal::Call::make(t, Internal::Call::rounding_halving_add,
+                                {std::move(a), std::move(b)},
+                                Internal::Call::PureIntrinsic);
+}
+
+/** Compute (a - b) / 2, rounding down, without overflowing in the
+ * intermediate. The arguments must have the same integer type, of 32
+ * bits or narrower. Lowers to a single halving subtract (e.g. vhsub)
+ * where one exists. */
+inline Expr halving_sub(Expr a, Expr b) {
+    user_assert(a.defined() && b.defined()) << "halving_sub of undefined Expr\n";
+    Internal::match_types(a, b);
+    Type t = a.type();
+    user_assert((t.is_int() || t.is_uint()) && t.bits() <= 32)
+        << "halving_sub requires an integer type of 32 bits or fewer\n";
+    Type wide = t.with_bits(t.bits() * 2);
+    return cast(t, (cast(wide, std::move(a)) - cast(wide, std::move(b))) / 2);
+}
+
+/** Compute (a + (1 << (b - 1))) >> b, i.e. a shift right that rounds
+ * the discarded fraction to nearest instead of towards negative
+ * infinity, without overflowing in the intermediate. A shift of zero
+ * returns a unchanged. The arguments must have the same integer type,
+ * of 32 bits or narrower, and b must be in [0, bits). Kept as a named
+ * intrinsic until instruction selection (see rounding_halving_add for
+ * why); lowers to a single rounding shift (e.g. vrshl, Hexagon's asr
+ * with rounding) where one exists. */
+inline Expr rounding_shift_right(Expr a, Expr b) {
+    user_assert(a.defined() && b.defined()) << "rounding_shift_right of undefined Expr\n";
+    Internal::match_types(a, b);
+    Type t = a.type();
+    user_assert((t.is_int() || t.is_uint()) && t.bits() <= 32)
+        << "rounding_shift_right requires an integer type of 32 bits or fewer\n";
+    return Internal::Call::make(t, Internal::Call::rounding_shift_right,
+                                {std::move(a), std::move(b)},
+                                Internal::Call::PureIntrinsic);
+}
+
+/** Compute a * b / 2^q, rounding the quotient to nearest and
+ * saturating at the range of the type. The arguments must have the
+ * same signed integer type, of 32 bits or narrower. This is the
+ * fixed-point multiply: with q equal to the number of fractional
+ * bits, it multiplies two Q-format values. When q is one less than
+ * the bit width (e.g. q == 15 for Q15 int16 math), this lowers to a
+ * single saturating rounding doubling multiply (e.g. sqrdmulh) where
+ * one exists. */
+inline Expr rounding_mul_shift_right(Expr a, Expr b, int q) {
+    user_assert(a.defined() && b.defined()) << "rounding_mul_shift_right of undefined Expr\n";
+    Internal::match_types(a, b);
+    Type t = a.type();
+    user_assert(t.is_int() && t.bits() <= 32)
+        << "rounding_mul_shift_right requires a signed integer type of 32 bits or fewer\n";
+    user_assert(q > 0 && q < t.bits() * 2 - 1)
+        << "rounding_mul_shift_right with bad shift amount: " << q << "\n";
+    Type wide = t.with_bits(t.bits() * 2);
+    Expr prod = cast(wide, std::move(a)) * cast(wide, std::move(b)) +
+                Internal::make_const(wide, (int64_t)1 << (q - 1));
+    return saturating_cast(t, std::move(prod) / Internal::make_const(wide, (int64_t)1 << q));
+}
+
 }
 
 #endif
@@ -25,6 +25,9 @@ ostream &operator<<(ostream &out, const Type &type) {
     case Type::Float:
         out << "float";
         break;
+    case Type::BFloat:
+        out << "bfloat";
+        break;
     case Type::Handle:
         if (type.handle_type) {
             out << "(" << type.handle_type->inner_name.name << " *)";
@@ -621,6 +624,9 @@ void IRPrinter::visit(const Allocate *op) {
         print(op->extents[i]);
     }
     stream << "]";
+    if (op->memory_type != MemoryType::Auto) {
+        stream << " in " << (op->memory_type == MemoryType::Stack ? "Stack" : "Heap");
+    }
     if (!is_one(op->condition)) {
         stream << " if ";
         print(op->condition);
@@ -0,0 +1,186 @@
+#include "InferStaleRegions.h"
+
+#include "FindCalls.h"
+#include "IREquality.h"
+#include "IROperator.h"
+#include "RealizationOrder.h"
+#include "Simplify.h"
+#include "Solve.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Merge the boxes required by an additional expression into 'reads'.
+void merge_reads(map<string, Box> &reads, const Expr &e,
+                 const Scope<Interval> &scope, const FuncValueBounds &fvb) {
+    if (!e.defined()) {
+        return;
+    }
+    for (const auto &p : boxes_required(e, scope, fvb)) {
+        merge_boxes(reads[p.first], p.second);
+    }
+}
+
+bool intervals_equal(const Interval &a, const Interval &b) {
+    return equal(simplify(a.min), simplify(b.min)) &&
+           equal(simplify(a.max), simplify(b.max));
+}
+
+bool boxes_equal(const Box &a, const Box &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!intervals_equal(a[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Box everything_box(size_t dims) {
+    Box b(dims);
+    for (size_t i = 0; i < dims; i++) {
+        b[i] = Interval::everything();
+    }
+    return b;
+}
+
+// The box of 'f' whose values may change, given the stale boxes of
+// the things its definitions read. Returns an empty box if f cannot
+// be affected. Sets reads_self if any definition of f reads f itself.
+Box stale_box(Function f, const map<string, Box> &stale,
+              const FuncValueBounds &fvb, bool *reads_self) {
+    vector<Definition> defs;
+    defs.push_back(f.definition());
+    defs.insert(defs.end(), f.updates().begin(), f.updates().end());
+
+    Box result;
+    for (const Definition &def : defs) {
+        Scope<Interval> scope;
+        for (const ReductionVariable &rv : def.schedule().rvars()) {
+            scope.push(rv.var, Interval(rv.min, rv.min + rv.extent - 1));
+        }
+
+        map<string, Box> reads;
+        for (const Expr &v : def.values()) {
+            merge_reads(reads, v, scope, fvb);
+        }
+        for (const Expr &a : def.args()) {
+            merge_reads(reads, a, scope, fvb);
+        }
+        merge_reads(reads, def.predicate(), scope, fvb);
+
+        if (reads.count(f.name())) {
+            *reads_self = true;
+        }
+
+        // The condition, on the pure vars of f, under which this
+        // definition reads something stale.
+        Expr cond;
+        for (const auto &p : reads) {
+            auto iter = stale.find(p.first);
+            if (iter == stale.end()) {
+                continue;
+            }
+            const Box &read = p.second;
+            const Box &dirty = iter->second;
+            if (read.size() != dirty.size()) {
+                // A dimensionality mismatch shouldn't happen, but if
+                // it does, give up on precision rather than crash.
+                return everything_box(f.args().size());
+            }
+            Expr c = const_true();
+            for (size_t d = 0; d < read.size(); d++) {
+                // The read overlaps the dirty box in dimension d
+                // unless it is provably entirely on one side of it.
+                if (read[d].has_lower_bound() && dirty[d].has_upper_bound()) {
+                    c = c && (read[d].min <= dirty[d].max);
+                }
+                if (read[d].has_upper_bound() && dirty[d].has_lower_bound()) {
+                    c = c && (read[d].max >= dirty[d].min);
+                }
+            }
+            cond = cond.defined() ? (cond || c) : c;
+        }
+        if (!cond.defined()) {
+            // Reads nothing stale.
+            continue;
+        }
+        cond = simplify(cond);
+        if (is_zero(cond)) {
+            continue;
+        }
+
+        // Invert: solve the condition for each pure var to get the
+        // box of f this definition dirties. A dimension whose store
+        // location is not the pure var itself (e.g. an rvar scatter)
+        // cannot be tracked through the inversion.
+        Box def_box(f.args().size());
+        for (size_t i = 0; i < f.args().size(); i++) {
+            const Variable *v = def.args()[i].as<Variable>();
+            if (v && v->name == f.args()[i]) {
+                def_box[i] = solve_for_outer_interval(cond, v->name);
+            } else {
+                def_box[i] = Interval::everything();
+            }
+        }
+        merge_boxes(result, def_box);
+    }
+    return result;
+}
+
+}  // namespace
+
+map<string, Box> infer_stale_regions(const vector<Function> &outputs,
+                                     const string &input,
+                                     const Box &changed) {
+    map<string, Function> env;
+    for (const Function &f : outputs) {
+        populate_environment(f, env);
+    }
+    vector<string> order = realization_order(outputs, env);
+    FuncValueBounds fvb = compute_function_value_bounds(order, env);
+
+    map<string, Box> stale;
+    stale[input] = changed;
+
+    for (const string &fname : order) {
+        Function f = env.find(fname)->second;
+        bool reads_self = false;
+        Box b = stale_box(f, stale, fvb, &reads_self);
+        if (b.empty()) {
+            continue;
+        }
+        stale[fname] = b;
+        if (!reads_self) {
+            continue;
+        }
+        // A self-referential update spreads staleness within f
+        // itself; iterate to a fixed point, giving up on precision
+        // after a few rounds.
+        for (int i = 0; ; i++) {
+            Box grown = stale_box(f, stale, fvb, &reads_self);
+            merge_boxes(grown, stale[fname]);
+            if (boxes_equal(grown, stale[fname])) {
+                break;
+            }
+            if (i >= 8) {
+                stale[fname] = everything_box(f.args().size());
+                break;
+            }
+            stale[fname] = grown;
+        }
+    }
+
+    return stale;
+}
+
+}
+}
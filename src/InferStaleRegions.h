@@ -0,0 +1,35 @@
+#ifndef HALIDE_INFER_STALE_REGIONS_H
+#define HALIDE_INFER_STALE_REGIONS_H
+
+/** \file
+ *
+ * Defines the inverse-bounds query used for incremental
+ * re-realization: given a region of an input that has changed, which
+ * regions of the funcs that read it (transitively) are stale?
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Bounds.h"
+#include "Function.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Compute, for every Function reachable from 'outputs', a
+ * conservative box covering the points whose values may change when
+ * the given box of the buffer named 'input' (an ImageParam, input
+ * Buffer, or Function) changes. Functions that cannot be affected are
+ * absent from the result. The boxes may use Interval::pos_inf /
+ * Interval::neg_inf when a dimension cannot be bounded, in which case
+ * the whole dimension must be considered stale. */
+std::map<std::string, Box> infer_stale_regions(const std::vector<Function> &outputs,
+                                               const std::string &input,
+                                               const Box &changed);
+
+}
+}
+
+#endif
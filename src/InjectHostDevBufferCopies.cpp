@@ -88,13 +88,22 @@ class FindBufferUsage : public IRVisitor {
             for (size_t i = 0; i < op->args.size(); i++) {
                 if (is_buffer_var(op->args[i])) {
                     DeviceAPI extern_device_api = f.extern_function_device_api();
-                    touched_by_extern = true;
+                    used_by_extern = true;
+                    if (!f.extern_definition_preserves_buffer_state()) {
+                        touched_by_extern = true;
+                    }
                     if (i >= f.extern_arguments().size()) {
                         // An output. The extern stage is responsible
                         // for dealing with any device transitions for
                         // inputs.
                         devices_touched.insert(extern_device_api);
                         devices_writing.insert(extern_device_api);
+                    } else if (f.extern_definition_requires_resident_inputs()) {
+                        // The extern stage wants this input resident
+                        // for its device API before the call, so
+                        // treat the call as a read on that device and
+                        // let the usual machinery stage it.
+                        devices_touched.insert(extern_device_api);
                     }
                 } else {
                     op->args[i].accept(this);
@@ -121,8 +130,12 @@ class FindBufferUsage : public IRVisitor {
 public:
     std::set<DeviceAPI> devices_writing, devices_touched;
     // Any buffer passed to an extern stage may have had its dirty
-    // bits and device allocation messed with.
+    // bits and device allocation messed with, unless the stage has
+    // declared that it preserves buffer state.
     bool touched_by_extern = false;
+    // Was the buffer passed to an extern stage at all? Needed to
+    // place frees correctly even for well-behaved stages.
+    bool used_by_extern = false;
 
     FindBufferUsage(const std::string &buf, DeviceAPI d) : buffer(buf), current_device_api(d) {}
 };
@@ -318,7 +331,7 @@ class InjectBufferCopiesForSingleBuffer : public IRMutator2 {
         }
 
         if (!finder.devices_touched.empty() ||
-            finder.touched_by_extern) {
+            finder.used_by_extern) {
             last_use = s;
         }
 
@@ -344,7 +357,7 @@ class InjectBufferCopiesForSingleBuffer : public IRMutator2 {
         FindBufferUsage finder(buffer, DeviceAPI::Host);
         op->value.accept(&finder);
         if (finder.devices_touched.empty() &&
-            !finder.touched_by_extern) {
+            !finder.used_by_extern) {
             return IRMutator2::visit(op);
         } else {
             return do_copies(op);
@@ -576,7 +589,8 @@ class InjectBufferCopies : public IRMutator2 {
                 body = substitute(op->name, reinterpret(Handle(), make_zero(UInt(64))), body);
             }
 
-            return Allocate::make(op->name, op->type, op->extents, condition, body, op->new_expr, op->free_function);
+            return Allocate::make(op->name, op->type, op->extents, condition, body,
+                                  op->new_expr, op->free_function, op->memory_type);
         }
     }
 
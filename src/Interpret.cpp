@@ -0,0 +1,1230 @@
+#include "Interpret.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <map>
+#include <sstream>
+
+#include "Debug.h"
+#include "Error.h"
+#include "Float16.h"
+#include "IROperator.h"
+#include "IRPrinter.h"
+#include "IRVisitor.h"
+#include "Lerp.h"
+#include "Scope.h"
+#include "Simplify.h"
+#include "Util.h"
+#include "runtime/HalideRuntime.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// One lane of a runtime value. Which member is live is determined by
+// the Type of the Value that holds it: signed integers (and bools)
+// live in i, sign-extended to 64 bits; unsigned integers in u,
+// zero-extended; floats (of any width) in f; handles in p.
+union Lane {
+    int64_t i;
+    uint64_t u;
+    double f;
+    void *p;
+};
+
+struct Value {
+    Type type;
+    vector<Lane> lanes;
+
+    Value() = default;
+    explicit Value(Type t) : type(t), lanes(t.lanes()) {
+        for (Lane &l : lanes) {
+            l.u = 0;
+        }
+    }
+
+    bool scalar_bool() const {
+        internal_assert(lanes.size() == 1);
+        return lanes[0].u != 0;
+    }
+    int64_t scalar_int() const {
+        internal_assert(lanes.size() == 1);
+        return type.is_uint() ? (int64_t)lanes[0].u : lanes[0].i;
+    }
+    void *scalar_handle() const {
+        internal_assert(lanes.size() == 1 && type.is_handle());
+        return lanes[0].p;
+    }
+};
+
+Value make_bool(bool b, int lanes = 1) {
+    Value v(UInt(1, lanes));
+    for (Lane &l : v.lanes) {
+        l.u = b ? 1 : 0;
+    }
+    return v;
+}
+
+Value make_handle(void *p) {
+    Value v(Handle());
+    v.lanes[0].p = p;
+    return v;
+}
+
+// Wrap a lane back into range after an arithmetic op: sign-extend
+// signed values from the type's width, zero-extend unsigned ones.
+void normalize(Type t, Lane &l) {
+    if (t.is_float() || t.is_handle() || t.bits() == 64) {
+        return;
+    }
+    if (t.is_uint()) {
+        l.u &= (((uint64_t)1 << t.bits()) - 1);
+    } else {
+        int shift = 64 - t.bits();
+        l.i = (l.i << shift) >> shift;
+    }
+}
+
+// The raw bit pattern of a lane at its type's width, for reinterpret
+// and for stores.
+uint64_t lane_to_bits(Type t, Lane l) {
+    if (t.is_float()) {
+        if (t.bits() == 64) {
+            uint64_t b;
+            double d = l.f;
+            memcpy(&b, &d, 8);
+            return b;
+        } else if (t.bits() == 32) {
+            uint32_t b;
+            float f = (float)l.f;
+            memcpy(&b, &f, 4);
+            return b;
+        } else {
+            return float16_t((float)l.f).to_bits();
+        }
+    } else if (t.is_handle()) {
+        return (uint64_t)(uintptr_t)l.p;
+    } else {
+        uint64_t b = l.u;
+        if (t.bits() < 64) {
+            b &= (((uint64_t)1 << t.bits()) - 1);
+        }
+        return b;
+    }
+}
+
+Lane lane_from_bits(Type t, uint64_t bits) {
+    Lane l;
+    l.u = 0;
+    if (t.is_float()) {
+        if (t.bits() == 64) {
+            double d;
+            memcpy(&d, &bits, 8);
+            l.f = d;
+        } else if (t.bits() == 32) {
+            float f;
+            uint32_t b = (uint32_t)bits;
+            memcpy(&f, &b, 4);
+            l.f = f;
+        } else {
+            l.f = (double)(float)float16_t::make_from_bits((uint16_t)bits);
+        }
+    } else if (t.is_handle()) {
+        l.p = (void *)(uintptr_t)bits;
+    } else {
+        l.u = bits;
+        normalize(t, l);
+    }
+    return l;
+}
+
+Lane load_element(Type t, const uint8_t *addr) {
+    if (t.is_handle()) {
+        void *p;
+        memcpy(&p, addr, sizeof(void *));
+        Lane l;
+        l.p = p;
+        return l;
+    }
+    uint64_t bits = 0;
+    memcpy(&bits, addr, t.bytes());
+    return lane_from_bits(t, bits);
+}
+
+void store_element(Type t, Lane l, uint8_t *addr) {
+    if (t.is_handle()) {
+        memcpy(addr, &l.p, sizeof(void *));
+        return;
+    }
+    uint64_t bits = lane_to_bits(t, l);
+    memcpy(addr, &bits, t.bytes());
+}
+
+class Interpreter : public IRVisitor {
+public:
+    Interpreter() {
+        scope.push("__user_context", make_handle(nullptr));
+    }
+
+    ~Interpreter() {
+        for (void *p : temp_storage) {
+            free(p);
+        }
+        for (auto &p : allocations) {
+            free(p.second);
+        }
+    }
+
+    void bind(const string &name, Value v) {
+        scope.push(name, std::move(v));
+    }
+
+    void run(const Stmt &s) {
+        s.accept(this);
+    }
+
+private:
+    Scope<Value> scope;
+
+    // Result of the most recently visited Expr.
+    Value result;
+
+    // Heap allocations made by Allocate nodes, by name. Entries are
+    // nulled by an early Free and reclaimed when the Allocate's body
+    // finishes (or in the destructor, if an error propagates out).
+    std::map<string, void *> allocations;
+
+    // Backing store for alloca/make_struct intrinsics and interned
+    // strings, which live until the pipeline finishes.
+    vector<void *> temp_storage;
+    std::list<string> interned_strings;
+
+    Value eval(const Expr &e) {
+        internal_assert(e.defined()) << "Interpreter evaluating undefined Expr\n";
+        e.accept(this);
+        // Handle types are compared loosely: the interpreter doesn't
+        // track what a handle points to.
+        internal_assert(result.type.code() == e.type().code() &&
+                        result.type.bits() == e.type().bits() &&
+                        result.type.lanes() == e.type().lanes())
+            << "Interpreter produced " << result.type << " for " << e << "\n";
+        return std::move(result);
+    }
+
+    NO_INLINE void unsupported(const string &what) {
+        user_error << "The Halide interpreter does not support " << what
+                   << ". Use ordinary JIT compilation for this pipeline.\n";
+    }
+
+    // Apply an elementwise op, dispatching each lane on the type
+    // category. FOp/IOp/UOp take and return double/int64_t/uint64_t.
+    template<typename FOp, typename IOp, typename UOp>
+    Value binary(Type t, const Value &a, const Value &b, FOp fop, IOp iop, UOp uop) {
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            if (t.is_float()) {
+                v.lanes[i].f = fop(a.lanes[i].f, b.lanes[i].f);
+            } else if (t.is_uint()) {
+                v.lanes[i].u = uop(a.lanes[i].u, b.lanes[i].u);
+            } else {
+                v.lanes[i].i = iop(a.lanes[i].i, b.lanes[i].i);
+            }
+            normalize(t, v.lanes[i]);
+        }
+        return v;
+    }
+
+    // Elementwise comparison producing a bool vector.
+    template<typename FOp, typename IOp, typename UOp>
+    Value compare(const Value &a, const Value &b, FOp fop, IOp iop, UOp uop) {
+        Type t = a.type;
+        Value v(UInt(1, t.lanes()));
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            bool r;
+            if (t.is_float()) {
+                r = fop(a.lanes[i].f, b.lanes[i].f);
+            } else if (t.is_int()) {
+                r = iop(a.lanes[i].i, b.lanes[i].i);
+            } else {
+                // Handles compare as unsigned words.
+                r = uop(lane_to_bits(t, a.lanes[i]), lane_to_bits(t, b.lanes[i]));
+            }
+            v.lanes[i].u = r ? 1 : 0;
+        }
+        return v;
+    }
+
+    Value cast_value(Type dst, const Value &src) {
+        if (dst == src.type) {
+            return src;
+        }
+        Type st = src.type;
+        Value v(dst);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            const Lane &s = src.lanes[i];
+            Lane &d = v.lanes[i];
+            if (dst.is_float()) {
+                d.f = st.is_float() ? s.f :
+                      st.is_uint() ? (double)s.u :
+                                     (double)s.i;
+                if (dst.bits() == 32) {
+                    d.f = (float)d.f;
+                } else if (dst.bits() == 16) {
+                    d.f = (double)(float)float16_t((float)d.f);
+                }
+            } else if (dst.is_bool()) {
+                // Casting to bool tests against zero, as in codegen.
+                d.u = (st.is_float() ? (s.f != 0.0) : (s.u != 0)) ? 1 : 0;
+            } else if (dst.is_handle()) {
+                d.p = st.is_handle() ? s.p : (void *)(uintptr_t)s.u;
+            } else {
+                if (st.is_float()) {
+                    d.i = (int64_t)s.f;
+                } else if (st.is_handle()) {
+                    d.u = (uint64_t)(uintptr_t)s.p;
+                } else {
+                    d.i = s.i;
+                }
+                normalize(dst, d);
+            }
+        }
+        return v;
+    }
+
+    // Loads and stores. The base pointer for a Load/Store name is a
+    // handle in scope: buffer hosts arrive via the LetStmts lowering
+    // makes around _halide_buffer_get_host, and Allocate nodes bind
+    // the storage they create.
+    uint8_t *base_pointer(const string &name) {
+        user_assert(scope.contains(name))
+            << "Interpreter: load/store to unknown symbol " << name << "\n";
+        return (uint8_t *)scope.get(name).lanes[0].p;
+    }
+
+    // Expressions
+
+    void visit(const IntImm *op) {
+        Value v(op->type);
+        v.lanes[0].i = op->value;
+        result = std::move(v);
+    }
+
+    void visit(const UIntImm *op) {
+        Value v(op->type);
+        v.lanes[0].u = op->value;
+        result = std::move(v);
+    }
+
+    void visit(const FloatImm *op) {
+        Value v(op->type);
+        v.lanes[0].f = op->value;
+        result = std::move(v);
+    }
+
+    void visit(const StringImm *op) {
+        interned_strings.push_back(op->value);
+        result = make_handle((void *)interned_strings.back().c_str());
+    }
+
+    void visit(const Cast *op) {
+        result = cast_value(op->type, eval(op->value));
+    }
+
+    void visit(const Variable *op) {
+        user_assert(scope.contains(op->name))
+            << "Interpreter: undefined variable " << op->name << "\n";
+        result = scope.get(op->name);
+    }
+
+    void visit(const Add *op) {
+        result = binary(op->type, eval(op->a), eval(op->b),
+                        [](double a, double b) { return a + b; },
+                        [](int64_t a, int64_t b) { return a + b; },
+                        [](uint64_t a, uint64_t b) { return a + b; });
+    }
+
+    void visit(const Sub *op) {
+        result = binary(op->type, eval(op->a), eval(op->b),
+                        [](double a, double b) { return a - b; },
+                        [](int64_t a, int64_t b) { return a - b; },
+                        [](uint64_t a, uint64_t b) { return a - b; });
+    }
+
+    void visit(const Mul *op) {
+        result = binary(op->type, eval(op->a), eval(op->b),
+                        [](double a, double b) { return a * b; },
+                        [](int64_t a, int64_t b) { return a * b; },
+                        [](uint64_t a, uint64_t b) { return a * b; });
+    }
+
+    void visit(const Div *op) {
+        // Halide's Euclidean division. Division by zero produces
+        // zero rather than trapping; its result is unspecified.
+        result = binary(op->type, eval(op->a), eval(op->b),
+                        [](double a, double b) { return a / b; },
+                        [](int64_t a, int64_t b) { return b == 0 ? (int64_t)0 : div_imp(a, b); },
+                        [](uint64_t a, uint64_t b) { return b == 0 ? (uint64_t)0 : a / b; });
+    }
+
+    void visit(const Mod *op) {
+        result = binary(op->type, eval(op->a), eval(op->b),
+                        [](double a, double b) { return mod_imp(a, b); },
+                        [](int64_t a, int64_t b) { return b == 0 ? (int64_t)0 : mod_imp(a, b); },
+                        [](uint64_t a, uint64_t b) { return b == 0 ? (uint64_t)0 : a % b; });
+    }
+
+    void visit(const Min *op) {
+        result = binary(op->type, eval(op->a), eval(op->b),
+                        [](double a, double b) { return std::min(a, b); },
+                        [](int64_t a, int64_t b) { return std::min(a, b); },
+                        [](uint64_t a, uint64_t b) { return std::min(a, b); });
+    }
+
+    void visit(const Max *op) {
+        result = binary(op->type, eval(op->a), eval(op->b),
+                        [](double a, double b) { return std::max(a, b); },
+                        [](int64_t a, int64_t b) { return std::max(a, b); },
+                        [](uint64_t a, uint64_t b) { return std::max(a, b); });
+    }
+
+    void visit(const EQ *op) {
+        result = compare(eval(op->a), eval(op->b),
+                         [](double a, double b) { return a == b; },
+                         [](int64_t a, int64_t b) { return a == b; },
+                         [](uint64_t a, uint64_t b) { return a == b; });
+    }
+
+    void visit(const NE *op) {
+        result = compare(eval(op->a), eval(op->b),
+                         [](double a, double b) { return a != b; },
+                         [](int64_t a, int64_t b) { return a != b; },
+                         [](uint64_t a, uint64_t b) { return a != b; });
+    }
+
+    void visit(const LT *op) {
+        result = compare(eval(op->a), eval(op->b),
+                         [](double a, double b) { return a < b; },
+                         [](int64_t a, int64_t b) { return a < b; },
+                         [](uint64_t a, uint64_t b) { return a < b; });
+    }
+
+    void visit(const LE *op) {
+        result = compare(eval(op->a), eval(op->b),
+                         [](double a, double b) { return a <= b; },
+                         [](int64_t a, int64_t b) { return a <= b; },
+                         [](uint64_t a, uint64_t b) { return a <= b; });
+    }
+
+    void visit(const GT *op) {
+        result = compare(eval(op->a), eval(op->b),
+                         [](double a, double b) { return a > b; },
+                         [](int64_t a, int64_t b) { return a > b; },
+                         [](uint64_t a, uint64_t b) { return a > b; });
+    }
+
+    void visit(const GE *op) {
+        result = compare(eval(op->a), eval(op->b),
+                         [](double a, double b) { return a >= b; },
+                         [](int64_t a, int64_t b) { return a >= b; },
+                         [](uint64_t a, uint64_t b) { return a >= b; });
+    }
+
+    void visit(const And *op) {
+        // Vector bools are eager; scalar && short-circuits as in
+        // codegen, which matters when the right side is guarded by
+        // the left (e.g. a bounds check before a likely load).
+        if (op->type.is_scalar()) {
+            Value a = eval(op->a);
+            result = a.scalar_bool() ? eval(op->b) : std::move(a);
+        } else {
+            result = binary(op->type, eval(op->a), eval(op->b),
+                            [](double, double) { return 0.0; },
+                            [](int64_t a, int64_t b) { return a & b; },
+                            [](uint64_t a, uint64_t b) { return a & b; });
+        }
+    }
+
+    void visit(const Or *op) {
+        if (op->type.is_scalar()) {
+            Value a = eval(op->a);
+            result = a.scalar_bool() ? std::move(a) : eval(op->b);
+        } else {
+            result = binary(op->type, eval(op->a), eval(op->b),
+                            [](double, double) { return 0.0; },
+                            [](int64_t a, int64_t b) { return a | b; },
+                            [](uint64_t a, uint64_t b) { return a | b; });
+        }
+    }
+
+    void visit(const Not *op) {
+        Value a = eval(op->a);
+        for (Lane &l : a.lanes) {
+            l.u = l.u ? 0 : 1;
+        }
+        result = std::move(a);
+    }
+
+    void visit(const Select *op) {
+        Value c = eval(op->condition);
+        if (c.type.is_scalar()) {
+            result = eval(c.scalar_bool() ? op->true_value : op->false_value);
+            return;
+        }
+        Value t = eval(op->true_value);
+        Value f = eval(op->false_value);
+        for (size_t i = 0; i < t.lanes.size(); i++) {
+            if (!c.lanes[i].u) {
+                t.lanes[i] = f.lanes[i];
+            }
+        }
+        result = std::move(t);
+    }
+
+    void visit(const Load *op) {
+        uint8_t *base = base_pointer(op->name);
+        Value idx = eval(op->index);
+        Value pred = eval(op->predicate);
+        Type elem = op->type.element_of();
+        Value v(op->type);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            if (!pred.lanes[i].u) {
+                continue;  // The lane is undefined; leave it zero.
+            }
+            int64_t j = idx.type.is_uint() ? (int64_t)idx.lanes[i].u : idx.lanes[i].i;
+            v.lanes[i] = load_element(elem, base + j * elem.bytes());
+        }
+        result = std::move(v);
+    }
+
+    void visit(const Ramp *op) {
+        Value base = eval(op->base);
+        Value stride = eval(op->stride);
+        Value v(op->type);
+        for (int i = 0; i < op->lanes; i++) {
+            if (op->type.is_float()) {
+                v.lanes[i].f = base.lanes[0].f + i * stride.lanes[0].f;
+            } else if (op->type.is_uint()) {
+                v.lanes[i].u = base.lanes[0].u + (uint64_t)i * stride.lanes[0].u;
+            } else {
+                v.lanes[i].i = base.lanes[0].i + i * stride.lanes[0].i;
+            }
+            normalize(op->type, v.lanes[i]);
+        }
+        result = std::move(v);
+    }
+
+    void visit(const Broadcast *op) {
+        Value s = eval(op->value);
+        Value v(op->type);
+        for (Lane &l : v.lanes) {
+            l = s.lanes[0];
+        }
+        result = std::move(v);
+    }
+
+    void visit(const Shuffle *op) {
+        vector<Value> vecs;
+        vecs.reserve(op->vectors.size());
+        for (const Expr &e : op->vectors) {
+            vecs.push_back(eval(e));
+        }
+        Value v(op->type);
+        for (size_t i = 0; i < op->indices.size(); i++) {
+            int idx = op->indices[i];
+            for (const Value &vec : vecs) {
+                if (idx < (int)vec.lanes.size()) {
+                    v.lanes[i] = vec.lanes[idx];
+                    break;
+                }
+                idx -= (int)vec.lanes.size();
+            }
+        }
+        result = std::move(v);
+    }
+
+    void visit(const Let *op) {
+        scope.push(op->name, eval(op->value));
+        result = eval(op->body);
+        scope.pop(op->name);
+    }
+
+    void visit(const Call *op);
+
+    // Statements
+
+    void visit(const LetStmt *op) {
+        scope.push(op->name, eval(op->value));
+        op->body.accept(this);
+        scope.pop(op->name);
+    }
+
+    void visit(const AssertStmt *op) {
+        if (eval(op->condition).scalar_bool()) {
+            return;
+        }
+        // The message is a call to one of the halide_error_*
+        // functions, which raises the error for us.
+        eval(op->message);
+        halide_runtime_error << "Assertion failed in interpreted pipeline: "
+                             << op->condition << "\n";
+    }
+
+    void visit(const ProducerConsumer *op) {
+        op->body.accept(this);
+    }
+
+    void visit(const For *op) {
+        switch (op->for_type) {
+        case ForType::Serial:
+        case ForType::Unrolled:
+        case ForType::Parallel:
+            // Parallel loops run serially: the interpreter is
+            // single-threaded, and any order is a legal schedule.
+            break;
+        case ForType::Vectorized:
+            // VectorizeLoops rewrites these away before we run.
+            internal_error << "Vectorized loop survived lowering: " << op->name << "\n";
+            break;
+        case ForType::GPUBlock:
+        case ForType::GPUThread:
+            unsupported("GPU loops");
+            break;
+        }
+        int64_t min = eval(op->min).scalar_int();
+        int64_t extent = eval(op->extent).scalar_int();
+        Value var(op->min.type());
+        for (int64_t i = min; i < min + extent; i++) {
+            var.lanes[0].i = i;
+            scope.push(op->name, var);
+            op->body.accept(this);
+            scope.pop(op->name);
+        }
+    }
+
+    void visit(const Store *op) {
+        uint8_t *base = base_pointer(op->name);
+        Value pred = eval(op->predicate);
+        Value idx = eval(op->index);
+        Value val = eval(op->value);
+        Type elem = op->value.type().element_of();
+        for (size_t i = 0; i < val.lanes.size(); i++) {
+            if (!pred.lanes[i].u) {
+                continue;
+            }
+            int64_t j = idx.type.is_uint() ? (int64_t)idx.lanes[i].u : idx.lanes[i].i;
+            store_element(elem, val.lanes[i], base + j * elem.bytes());
+        }
+    }
+
+    void visit(const Provide *op) {
+        internal_error << "Provide node survived lowering: " << op->name << "\n";
+    }
+
+    void visit(const Allocate *op) {
+        if (op->new_expr.defined()) {
+            unsupported("custom allocations (Allocate with new_expr)");
+        }
+        void *storage = nullptr;
+        bool on = !op->condition.defined() || eval(op->condition).scalar_bool();
+        if (on) {
+            int64_t size = op->type.bytes();
+            for (const Expr &e : op->extents) {
+                size *= eval(e).scalar_int();
+            }
+            if (size > 0) {
+                storage = malloc(size);
+                user_assert(storage) << "Interpreter: out of memory allocating "
+                                     << size << " bytes for " << op->name << "\n";
+            }
+        }
+        allocations[op->name] = storage;
+        scope.push(op->name, make_handle(storage));
+        op->body.accept(this);
+        scope.pop(op->name);
+        auto it = allocations.find(op->name);
+        if (it != allocations.end()) {
+            free(it->second);
+            allocations.erase(it);
+        }
+    }
+
+    void visit(const Free *op) {
+        auto it = allocations.find(op->name);
+        internal_assert(it != allocations.end()) << "Free of unknown allocation " << op->name << "\n";
+        free(it->second);
+        allocations.erase(it);
+    }
+
+    void visit(const Realize *op) {
+        internal_error << "Realize node survived lowering: " << op->name << "\n";
+    }
+
+    void visit(const Block *op) {
+        op->first.accept(this);
+        if (op->rest.defined()) {
+            op->rest.accept(this);
+        }
+    }
+
+    void visit(const IfThenElse *op) {
+        if (eval(op->condition).scalar_bool()) {
+            op->then_case.accept(this);
+        } else if (op->else_case.defined()) {
+            op->else_case.accept(this);
+        }
+    }
+
+    void visit(const Evaluate *op) {
+        eval(op->value);
+    }
+
+    void visit(const Prefetch *op) {
+        // Just a hint.
+    }
+
+    // Call handling
+
+    const char *as_c_string(const Value &v) {
+        return (const char *)v.lanes[0].p;
+    }
+
+    halide_buffer_t *as_buffer(const Value &v) {
+        return (halide_buffer_t *)v.lanes[0].p;
+    }
+
+    void *make_temp(size_t size) {
+        void *p = malloc(size);
+        user_assert(p) << "Interpreter: out of memory\n";
+        temp_storage.push_back(p);
+        return p;
+    }
+
+    Value intrinsic(const Call *op);
+    Value extern_call(const Call *op);
+    Value buffer_intrinsic(const Call *op);
+    void raise_error(const Call *op);
+};
+
+void Interpreter::visit(const Call *op) {
+    if (op->is_intrinsic()) {
+        if (starts_with(op->name, "_halide_buffer_")) {
+            result = buffer_intrinsic(op);
+        } else {
+            result = intrinsic(op);
+        }
+    } else if (op->is_extern()) {
+        if (starts_with(op->name, "_halide_buffer_")) {
+            result = buffer_intrinsic(op);
+        } else {
+            result = extern_call(op);
+        }
+    } else {
+        internal_error << "Call to " << op->name
+                       << " of non-lowered call type survived lowering\n";
+    }
+}
+
+Value Interpreter::intrinsic(const Call *op) {
+    Type t = op->type;
+    if (op->is_intrinsic(Call::bitwise_and) ||
+        op->is_intrinsic(Call::bitwise_or) ||
+        op->is_intrinsic(Call::bitwise_xor)) {
+        Value a = eval(op->args[0]);
+        Value b = eval(op->args[1]);
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            uint64_t x = lane_to_bits(t, a.lanes[i]);
+            uint64_t y = lane_to_bits(t, b.lanes[i]);
+            uint64_t r = op->is_intrinsic(Call::bitwise_and) ? (x & y) :
+                         op->is_intrinsic(Call::bitwise_or) ? (x | y) :
+                                                              (x ^ y);
+            v.lanes[i] = lane_from_bits(t, r);
+        }
+        return v;
+    } else if (op->is_intrinsic(Call::bitwise_not)) {
+        Value a = eval(op->args[0]);
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            v.lanes[i] = lane_from_bits(t, ~lane_to_bits(t, a.lanes[i]));
+        }
+        return v;
+    } else if (op->is_intrinsic(Call::shift_left) ||
+               op->is_intrinsic(Call::shift_right)) {
+        Value a = eval(op->args[0]);
+        Value b = eval(op->args[1]);
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            int64_t shift = b.type.is_uint() ? (int64_t)b.lanes[i].u : b.lanes[i].i;
+            if (op->is_intrinsic(Call::shift_left)) {
+                v.lanes[i].u = lane_to_bits(t, a.lanes[i]) << shift;
+            } else if (t.is_int()) {
+                v.lanes[i].i = a.lanes[i].i >> shift;  // Arithmetic shift.
+            } else {
+                v.lanes[i].u = a.lanes[i].u >> shift;
+            }
+            normalize(t, v.lanes[i]);
+        }
+        return v;
+    } else if (op->is_intrinsic(Call::abs)) {
+        Value a = eval(op->args[0]);
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            if (t.is_float()) {
+                v.lanes[i].f = std::abs(a.lanes[i].f);
+            } else {
+                int64_t x = a.lanes[i].i;
+                v.lanes[i].u = (uint64_t)(x < 0 ? -x : x);
+                normalize(t, v.lanes[i]);
+            }
+        }
+        return v;
+    } else if (op->is_intrinsic(Call::absd)) {
+        Value a = eval(op->args[0]);
+        Value b = eval(op->args[1]);
+        Type st = op->args[0].type();
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            if (st.is_float()) {
+                v.lanes[i].f = std::abs(a.lanes[i].f - b.lanes[i].f);
+            } else if (st.is_uint()) {
+                uint64_t x = a.lanes[i].u, y = b.lanes[i].u;
+                v.lanes[i].u = x > y ? x - y : y - x;
+            } else {
+                int64_t x = a.lanes[i].i, y = b.lanes[i].i;
+                v.lanes[i].u = (uint64_t)(x > y ? x - y : y - x);
+            }
+            normalize(t, v.lanes[i]);
+        }
+        return v;
+    } else if (op->is_intrinsic(Call::div_round_to_zero)) {
+        return binary(t, eval(op->args[0]), eval(op->args[1]),
+                      [](double a, double b) { return a / b; },
+                      [](int64_t a, int64_t b) { return b == 0 ? (int64_t)0 : a / b; },
+                      [](uint64_t a, uint64_t b) { return b == 0 ? (uint64_t)0 : a / b; });
+    } else if (op->is_intrinsic(Call::mod_round_to_zero)) {
+        return binary(t, eval(op->args[0]), eval(op->args[1]),
+                      [](double a, double b) { return std::fmod(a, b); },
+                      [](int64_t a, int64_t b) { return b == 0 ? (int64_t)0 : a % b; },
+                      [](uint64_t a, uint64_t b) { return b == 0 ? (uint64_t)0 : a % b; });
+    } else if (op->is_intrinsic(Call::lerp)) {
+        // Codegen lowers lerp late; do the same and evaluate the
+        // lowered expression.
+        return eval(lower_lerp(op->args[0], op->args[1], op->args[2]));
+    } else if (op->is_intrinsic(Call::popcount) ||
+               op->is_intrinsic(Call::count_leading_zeros) ||
+               op->is_intrinsic(Call::count_trailing_zeros)) {
+        Value a = eval(op->args[0]);
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            uint64_t bits = lane_to_bits(t, a.lanes[i]);
+            int r = 0;
+            if (op->is_intrinsic(Call::popcount)) {
+                for (uint64_t b = bits; b; b >>= 1) {
+                    r += (int)(b & 1);
+                }
+            } else if (op->is_intrinsic(Call::count_leading_zeros)) {
+                for (int j = t.bits() - 1; j >= 0 && !((bits >> j) & 1); j--) {
+                    r++;
+                }
+            } else {
+                for (int j = 0; j < t.bits() && !((bits >> j) & 1); j++) {
+                    r++;
+                }
+            }
+            v.lanes[i].i = r;
+            normalize(t, v.lanes[i]);
+        }
+        return v;
+    } else if (op->is_intrinsic(Call::reinterpret)) {
+        Value a = eval(op->args[0]);
+        Type st = op->args[0].type();
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            if (t.is_handle() && st.is_handle()) {
+                v.lanes[i].p = a.lanes[i].p;
+            } else {
+                v.lanes[i] = lane_from_bits(t.element_of(),
+                                            lane_to_bits(st.element_of(), a.lanes[i]));
+            }
+        }
+        return v;
+    } else if (op->is_intrinsic(Call::if_then_else)) {
+        Value c = eval(op->args[0]);
+        if (c.type.is_scalar()) {
+            return eval(c.scalar_bool() ? op->args[1] : op->args[2]);
+        }
+        Value a = eval(op->args[1]);
+        Value b = eval(op->args[2]);
+        for (size_t i = 0; i < a.lanes.size(); i++) {
+            if (!c.lanes[i].u) {
+                a.lanes[i] = b.lanes[i];
+            }
+        }
+        return a;
+    } else if (op->is_intrinsic(Call::require)) {
+        Value c = eval(op->args[0]);
+        if (!c.scalar_bool()) {
+            eval(op->args[2]);  // Raises the error.
+            halide_runtime_error << "Requirement failed in interpreted pipeline\n";
+        }
+        return eval(op->args[1]);
+    } else if (op->is_intrinsic(Call::return_second)) {
+        eval(op->args[0]);
+        return eval(op->args[1]);
+    } else if (op->is_intrinsic(Call::likely) ||
+               op->is_intrinsic(Call::likely_if_innermost)) {
+        return eval(op->args[0]);
+    } else if (op->is_intrinsic(Call::memoize_expr)) {
+        return eval(op->args[0]);
+    } else if (op->is_intrinsic(Call::undef)) {
+        return Value(t);
+    } else if (op->is_intrinsic(Call::bool_to_mask) ||
+               op->is_intrinsic(Call::cast_mask)) {
+        return cast_value(t, eval(op->args[0]));
+    } else if (op->is_intrinsic(Call::select_mask)) {
+        Value c = eval(op->args[0]);
+        Value a = eval(op->args[1]);
+        Value b = eval(op->args[2]);
+        for (size_t i = 0; i < a.lanes.size(); i++) {
+            if (!c.lanes[i].u) {
+                a.lanes[i] = b.lanes[i];
+            }
+        }
+        return a;
+    } else if (op->is_intrinsic(Call::extract_mask_element)) {
+        Value v = eval(op->args[0]);
+        int64_t i = eval(op->args[1]).scalar_int();
+        Value r(t);
+        r.lanes[0] = v.lanes[i];
+        return r;
+    } else if (op->is_intrinsic(Call::stringify)) {
+        std::ostringstream msg;
+        for (const Expr &e : op->args) {
+            Value v = eval(e);
+            Type et = e.type();
+            if (et.is_handle()) {
+                // Either a string constant or an opaque pointer.
+                if (e.as<StringImm>() || e.as<Call>()) {
+                    msg << as_c_string(v);
+                } else {
+                    msg << v.lanes[0].p;
+                }
+            } else if (et.is_float()) {
+                msg << v.lanes[0].f;
+            } else if (et.is_uint()) {
+                msg << v.lanes[0].u;
+            } else {
+                msg << v.lanes[0].i;
+            }
+        }
+        interned_strings.push_back(msg.str());
+        return make_handle((void *)interned_strings.back().c_str());
+    } else if (op->is_intrinsic(Call::make_struct)) {
+        // Pack the arguments with their natural alignment, matching
+        // what codegen produces (used for shapes and argument lists).
+        size_t size = 0, max_align = 1;
+        vector<size_t> offsets(op->args.size());
+        vector<Value> vals(op->args.size());
+        for (size_t i = 0; i < op->args.size(); i++) {
+            vals[i] = eval(op->args[i]);
+            size_t bytes = op->args[i].type().is_handle() ? sizeof(void *) : op->args[i].type().bytes();
+            size = (size + bytes - 1) & ~(bytes - 1);
+            offsets[i] = size;
+            size += bytes;
+            max_align = std::max(max_align, bytes);
+        }
+        size = (size + max_align - 1) & ~(max_align - 1);
+        uint8_t *storage = (uint8_t *)make_temp(std::max(size, (size_t)1));
+        for (size_t i = 0; i < op->args.size(); i++) {
+            store_element(op->args[i].type(), vals[i].lanes[0], storage + offsets[i]);
+        }
+        return make_handle(storage);
+    } else if (op->is_intrinsic(Call::alloca)) {
+        int64_t size = eval(op->args[0]).scalar_int();
+        return make_handle(make_temp(std::max<int64_t>(size, 1)));
+    } else if (op->is_intrinsic(Call::size_of_halide_buffer_t)) {
+        Value v(t);
+        v.lanes[0].i = (int64_t)sizeof(halide_buffer_t);
+        return v;
+    } else if (op->is_intrinsic(Call::signed_integer_overflow)) {
+        halide_runtime_error << "Signed integer overflow evaluated in interpreted pipeline\n";
+    } else if (op->is_intrinsic(Call::indeterminate_expression)) {
+        halide_runtime_error << "Indeterminate expression evaluated in interpreted pipeline\n";
+    } else if (op->is_intrinsic(Call::prefetch)) {
+        return Value(t);
+    } else if (op->is_intrinsic(Call::atomic_rmw)) {
+        // The interpreter is single-threaded, so the read-modify-write
+        // is trivially atomic; evaluate the equivalent load/op/store.
+        unsupported("atomic update stages");
+    } else {
+        unsupported("the intrinsic " + op->name);
+    }
+    return Value(t);  // Unreachable.
+}
+
+Value Interpreter::buffer_intrinsic(const Call *op) {
+    const string &name = op->name;
+    Value v(op->type);
+    if (name == Call::buffer_init) {
+        halide_buffer_t *dst = as_buffer(eval(op->args[0]));
+        halide_dimension_t *dst_shape = (halide_dimension_t *)eval(op->args[1]).scalar_handle();
+        dst->host = (uint8_t *)eval(op->args[2]).scalar_handle();
+        dst->device = eval(op->args[3]).lanes[0].u;
+        dst->device_interface = (const halide_device_interface_t *)eval(op->args[4]).scalar_handle();
+        dst->type.code = (halide_type_code_t)eval(op->args[5]).scalar_int();
+        dst->type.bits = (uint8_t)eval(op->args[6]).scalar_int();
+        dst->type.lanes = 1;
+        dst->dimensions = (int32_t)eval(op->args[7]).scalar_int();
+        dst->dim = dst_shape;
+        halide_dimension_t *shape = (halide_dimension_t *)eval(op->args[8]).scalar_handle();
+        if (shape != dst->dim) {
+            for (int i = 0; i < dst->dimensions; i++) {
+                dst->dim[i] = shape[i];
+            }
+        }
+        dst->flags = eval(op->args[9]).lanes[0].u;
+        return make_handle(dst);
+    } else if (name == Call::buffer_init_from_buffer) {
+        halide_buffer_t *dst = as_buffer(eval(op->args[0]));
+        halide_dimension_t *dst_shape = (halide_dimension_t *)eval(op->args[1]).scalar_handle();
+        const halide_buffer_t *src = as_buffer(eval(op->args[2]));
+        *dst = *src;
+        dst->dim = dst_shape;
+        for (int i = 0; i < dst->dimensions; i++) {
+            dst->dim[i] = src->dim[i];
+        }
+        return make_handle(dst);
+    } else if (name == Call::buffer_crop) {
+        eval(op->args[0]);  // user context
+        halide_buffer_t *dst = as_buffer(eval(op->args[1]));
+        halide_dimension_t *dst_shape = (halide_dimension_t *)eval(op->args[2]).scalar_handle();
+        const halide_buffer_t *src = as_buffer(eval(op->args[3]));
+        const int *min = (const int *)eval(op->args[4]).scalar_handle();
+        const int *extent = (const int *)eval(op->args[5]).scalar_handle();
+        *dst = *src;
+        dst->dim = dst_shape;
+        int64_t offset = 0;
+        for (int i = 0; i < dst->dimensions; i++) {
+            dst->dim[i] = src->dim[i];
+            dst->dim[i].min = min[i];
+            dst->dim[i].extent = extent[i];
+            offset += (min[i] - src->dim[i].min) * (int64_t)src->dim[i].stride;
+        }
+        if (dst->host) {
+            dst->host += offset * src->type.bytes();
+        }
+        user_assert(!src->device_interface) << "Interpreter: cropping a device buffer\n";
+        dst->device_interface = nullptr;
+        dst->device = 0;
+        return make_handle(dst);
+    }
+    // The accessors all take the buffer first.
+    halide_buffer_t *buf = as_buffer(eval(op->args[0]));
+    if (name == Call::buffer_get_min) {
+        v.lanes[0].i = buf->dim[eval(op->args[1]).scalar_int()].min;
+    } else if (name == Call::buffer_get_extent) {
+        v.lanes[0].i = buf->dim[eval(op->args[1]).scalar_int()].extent;
+    } else if (name == Call::buffer_get_stride) {
+        v.lanes[0].i = buf->dim[eval(op->args[1]).scalar_int()].stride;
+    } else if (name == Call::buffer_get_max) {
+        const halide_dimension_t &d = buf->dim[eval(op->args[1]).scalar_int()];
+        v.lanes[0].i = d.min + d.extent - 1;
+    } else if (name == Call::buffer_get_host) {
+        v.lanes[0].p = buf->host;
+    } else if (name == Call::buffer_get_device) {
+        v.lanes[0].u = buf->device;
+    } else if (name == Call::buffer_get_device_interface) {
+        v.lanes[0].p = (void *)buf->device_interface;
+    } else if (name == Call::buffer_get_shape) {
+        v.lanes[0].p = buf->dim;
+    } else if (name == Call::buffer_get_host_dirty) {
+        v.lanes[0].u = buf->host_dirty() ? 1 : 0;
+    } else if (name == Call::buffer_get_device_dirty) {
+        v.lanes[0].u = buf->device_dirty() ? 1 : 0;
+    } else if (name == Call::buffer_get_type_code) {
+        v.lanes[0].u = buf->type.code;
+    } else if (name == Call::buffer_get_type_bits) {
+        v.lanes[0].u = buf->type.bits;
+    } else if (name == Call::buffer_get_type_lanes) {
+        v.lanes[0].u = buf->type.lanes;
+    } else if (name == Call::buffer_set_host_dirty) {
+        buf->set_host_dirty(eval(op->args[1]).scalar_bool());
+        v.lanes[0].i = 0;
+    } else if (name == Call::buffer_set_device_dirty) {
+        buf->set_device_dirty(eval(op->args[1]).scalar_bool());
+        v.lanes[0].i = 0;
+    } else if (name == Call::buffer_is_bounds_query) {
+        v.lanes[0].u = (buf->host == nullptr && buf->device == 0) ? 1 : 0;
+    } else if (name == Call::buffer_set_bounds) {
+        int d = (int)eval(op->args[1]).scalar_int();
+        buf->dim[d].min = (int32_t)eval(op->args[2]).scalar_int();
+        buf->dim[d].extent = (int32_t)eval(op->args[3]).scalar_int();
+        v.lanes[0].p = buf;
+    } else {
+        unsupported("the buffer intrinsic " + name);
+    }
+    return v;
+}
+
+// Raise a halide_error_* call as a Halide runtime error, rendering
+// the arguments the same way the runtime's implementation would be
+// fed them. We don't reproduce each function's exact message; the
+// name plus arguments is enough to identify the failure.
+void Interpreter::raise_error(const Call *op) {
+    std::ostringstream msg;
+    msg << "Interpreted pipeline failed: " << op->name << "(";
+    const char *sep = "";
+    for (size_t i = 1; i < op->args.size(); i++) {  // Skip user context.
+        Value v = eval(op->args[i]);
+        Type t = op->args[i].type();
+        msg << sep;
+        sep = ", ";
+        if (t.is_handle()) {
+            if (op->args[i].as<StringImm>() || op->args[i].as<Call>()) {
+                msg << as_c_string(v);
+            } else {
+                msg << v.lanes[0].p;
+            }
+        } else if (t.is_float()) {
+            msg << v.lanes[0].f;
+        } else if (t.is_uint()) {
+            msg << v.lanes[0].u;
+        } else {
+            msg << v.lanes[0].i;
+        }
+    }
+    msg << ")\n";
+    halide_runtime_error << msg.str();
+}
+
+Value Interpreter::extern_call(const Call *op) {
+    const string &name = op->name;
+    Type t = op->type;
+
+    // Transcendentals and rounding, dispatched elementwise on
+    // doubles. Evaluating float32 math in double precision then
+    // rounding can differ from compiled float32 math in the last
+    // ulp; acceptable for an interpreter meant for correctness
+    // checks.
+    static const std::map<string, double (*)(double)> unary_math = {
+        {"sqrt", [](double x) { return std::sqrt(x); }},
+        {"sin", [](double x) { return std::sin(x); }},
+        {"cos", [](double x) { return std::cos(x); }},
+        {"tan", [](double x) { return std::tan(x); }},
+        {"asin", [](double x) { return std::asin(x); }},
+        {"acos", [](double x) { return std::acos(x); }},
+        {"atan", [](double x) { return std::atan(x); }},
+        {"sinh", [](double x) { return std::sinh(x); }},
+        {"cosh", [](double x) { return std::cosh(x); }},
+        {"tanh", [](double x) { return std::tanh(x); }},
+        {"asinh", [](double x) { return std::asinh(x); }},
+        {"acosh", [](double x) { return std::acosh(x); }},
+        {"atanh", [](double x) { return std::atanh(x); }},
+        {"exp", [](double x) { return std::exp(x); }},
+        {"log", [](double x) { return std::log(x); }},
+        {"floor", [](double x) { return std::floor(x); }},
+        {"ceil", [](double x) { return std::ceil(x); }},
+        {"round", [](double x) { return std::nearbyint(x); }},
+        {"trunc", [](double x) { return std::trunc(x); }},
+    };
+
+    string base = name;
+    bool f32 = ends_with(name, "_f32");
+    if (f32 || ends_with(name, "_f64")) {
+        base = name.substr(0, name.size() - 4);
+    }
+
+    auto unary = unary_math.find(base);
+    if (unary != unary_math.end() && op->args.size() == 1) {
+        Value a = eval(op->args[0]);
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            double r = unary->second(a.lanes[i].f);
+            v.lanes[i].f = f32 ? (double)(float)r : r;
+        }
+        return v;
+    }
+    if ((base == "pow" || base == "atan2") && op->args.size() == 2) {
+        Value a = eval(op->args[0]);
+        Value b = eval(op->args[1]);
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            double r = base == "pow" ? std::pow(a.lanes[i].f, b.lanes[i].f)
+                                     : std::atan2(a.lanes[i].f, b.lanes[i].f);
+            v.lanes[i].f = f32 ? (double)(float)r : r;
+        }
+        return v;
+    }
+    if (base == "is_nan") {
+        Value a = eval(op->args[0]);
+        Value v(t);
+        for (size_t i = 0; i < v.lanes.size(); i++) {
+            v.lanes[i].u = std::isnan(a.lanes[i].f) ? 1 : 0;
+        }
+        return v;
+    }
+    if (base == "nan" || base == "inf" || base == "neg_inf") {
+        Value v(t);
+        double r = base == "nan" ? std::nan("") :
+                   base == "inf" ? std::numeric_limits<double>::infinity() :
+                                   -std::numeric_limits<double>::infinity();
+        for (Lane &l : v.lanes) {
+            l.f = r;
+        }
+        return v;
+    }
+
+    if (name == "halide_print") {
+        eval(op->args[0]);
+        debug(0) << as_c_string(eval(op->args[1]));
+        return Value(t);
+    }
+    if (name == "halide_error") {
+        eval(op->args[0]);
+        halide_runtime_error << as_c_string(eval(op->args[1]));
+    }
+    if (starts_with(name, "halide_error_")) {
+        raise_error(op);
+    }
+
+    unsupported("the external function " + name);
+    return Value(t);  // Unreachable.
+}
+
+}  // namespace
+
+int interpret(const LoweredFunc &fn, const vector<const void *> &args) {
+    internal_assert(args.size() == fn.args.size())
+        << "interpret() of " << fn.name << " expects " << fn.args.size()
+        << " arguments, got " << args.size() << "\n";
+
+    Interpreter interp;
+    for (size_t i = 0; i < fn.args.size(); i++) {
+        const LoweredArgument &arg = fn.args[i];
+        if (arg.is_buffer()) {
+            // As in codegen, the buffer symbol carries a .buffer
+            // suffix; the host pointer symbol is defined by LetStmts
+            // in the body.
+            interp.bind(arg.name + ".buffer", make_handle(const_cast<void *>(args[i])));
+        } else {
+            // Scalars (including __user_context) are passed
+            // argv-style, by pointer to their storage.
+            Value v(arg.type);
+            v.lanes[0] = load_element(arg.type, (const uint8_t *)args[i]);
+            interp.bind(arg.name, std::move(v));
+        }
+    }
+
+    interp.run(fn.body);
+    return 0;
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,32 @@
+#ifndef HALIDE_INTERPRET_H
+#define HALIDE_INTERPRET_H
+
+/** \file
+ *
+ * Defines an interpreter that executes lowered Halide IR directly,
+ * without generating machine code.
+ */
+
+#include "Module.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Execute the body of a lowered function by walking its IR with an
+ * environment, without involving LLVM. Starts in microseconds where
+ * JIT compilation takes seconds, at the cost of running orders of
+ * magnitude slower, which is the right trade for quick correctness
+ * checks on small inputs and for use as an oracle when debugging
+ * codegen. Arguments are passed argv-style, exactly as to the
+ * function's compiled form: one pointer per argument, at a
+ * halide_buffer_t for buffer arguments or at the scalar's storage
+ * otherwise. Parallel loops run serially. Returns 0 on success; a
+ * failing assertion raises the error through the usual
+ * halide_runtime_error path. Used by
+ * Pipeline::realize_interpreted. */
+EXPORT int interpret(const LoweredFunc &fn, const std::vector<const void *> &args);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
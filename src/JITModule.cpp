@@ -1,5 +1,8 @@
 #include <string>
 #include <stdint.h>
+#include <cstdio>
+#include <fstream>
+#include <map>
 #include <mutex>
 #include <set>
 
@@ -15,6 +18,7 @@
 #include "LLVM_Output.h"
 #include "CodeGen_LLVM.h"
 #include "Pipeline.h"
+#include "Util.h"
 
 
 #if defined(_MSC_VER) && !defined(NOMINMAX)
@@ -233,6 +237,77 @@ public:
     }
 };
 
+// An MCJIT object cache that persists compiled objects in the
+// directory named by HL_JIT_OBJECT_CACHE_DIR, keyed on a hash of the
+// module's bitcode. A process that JIT-compiles the same pipelines on
+// every cold start reloads the machine code it compiled last time
+// instead of rerunning instruction selection; only relocation is
+// redone at load time.
+class JITObjectCache : public llvm::ObjectCache {
+public:
+    JITObjectCache(const std::string &dir) : dir(dir) {}
+
+    void notifyObjectCompiled(const llvm::Module *m, llvm::MemoryBufferRef obj) override {
+        std::string path = cache_path(m);
+        // Populate the cache via rename, so that concurrent processes
+        // sharing the directory never observe a partially-written
+        // entry.
+        std::string temp_path = path + ".tmp";
+        std::ofstream out(temp_path, std::ios::binary);
+        out.write(obj.getBufferStart(), obj.getBufferSize());
+        out.flush();
+        if (out.good() && std::rename(temp_path.c_str(), path.c_str()) == 0) {
+            debug(1) << "JIT object cache store " << path << "\n";
+        } else {
+            file_unlink(temp_path);
+        }
+    }
+
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *m) override {
+        std::string path = cache_path(m);
+        auto buffer = llvm::MemoryBuffer::getFile(path);
+        if (!buffer) {
+            return nullptr;
+        }
+        debug(1) << "JIT object cache hit " << path << "\n";
+        return std::move(*buffer);
+    }
+
+private:
+    std::string dir;
+
+    std::string cache_path(const llvm::Module *m) const {
+        llvm::SmallVector<char, 4096> bitcode;
+        llvm::raw_svector_ostream stream(bitcode);
+        llvm::WriteBitcodeToFile(m, stream);
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < bitcode.size(); i++) {
+            h = (h ^ (uint8_t)bitcode[i]) * 0x100000001b3ULL;
+        }
+        char entry_name[32];
+        snprintf(entry_name, sizeof(entry_name), "%016llx", (unsigned long long)h);
+        return dir + "/" + entry_name + ".o";
+    }
+};
+
+// Returns the process-wide JIT object cache, or nullptr if
+// HL_JIT_OBJECT_CACHE_DIR is not set. Never freed: the execution
+// engines that reference it may be torn down by static destructors.
+llvm::ObjectCache *jit_object_cache() {
+    static std::mutex jit_object_cache_mutex;
+    std::lock_guard<std::mutex> lock(jit_object_cache_mutex);
+    static bool initialized = false;
+    static JITObjectCache *cache = nullptr;
+    if (!initialized) {
+        initialized = true;
+        std::string dir = get_env_variable("HL_JIT_OBJECT_CACHE_DIR");
+        if (!dir.empty()) {
+            cache = new JITObjectCache(dir);
+        }
+    }
+    return cache;
+}
+
 }
 
 JITModule::JITModule() {
@@ -297,6 +372,12 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
     if (!ee) std::cerr << error_string << "\n";
     internal_assert(ee) << "Couldn't create execution engine\n";
 
+    // If a JIT object cache directory is configured, compiled objects
+    // are persisted there and reloaded on later runs.
+    if (llvm::ObjectCache *object_cache = jit_object_cache()) {
+        ee->setObjectCache(object_cache);
+    }
+
     // Do any target-specific initialization
     std::vector<llvm::JITEventListener *> listeners;
 
@@ -618,66 +699,79 @@ enum RuntimeKind {
     MaxRuntimeKind
 };
 
-JITModule &shared_runtimes(RuntimeKind k) {
-    // We're already guarded by the shared_runtimes_mutex
-    static JITModule *m = nullptr;
+// The runtimes of each kind are cached per target, so that JIT
+// compilations for different targets within one process each link
+// against a runtime built for their own target, and so that
+// re-realizing for an already-seen target never rebuilds a runtime.
+// We're already guarded by the shared_runtimes_mutex.
+std::map<std::string, JITModule> &shared_runtimes() {
+    static std::map<std::string, JITModule> *m = nullptr;
     if (!m) {
         // Note that this is never freed. On windows this would invoke
         // static destructors that use threading objects, and these
         // don't work (crash or deadlock) after main exits.
-        m = new JITModule[MaxRuntimeKind];
+        m = new std::map<std::string, JITModule>;
     }
-    return m[k];
+    return *m;
 }
 
 JITModule &make_module(llvm::Module *for_module, Target target,
                        RuntimeKind runtime_kind, const std::vector<JITModule> &deps,
                        bool create) {
-    JITModule &runtime = shared_runtimes(runtime_kind);
+    // Ensure that JIT feature is set on target as it must be in
+    // order for the right runtime components to be added.
+    target.set_feature(Target::JIT);
+
+    Target one_gpu(target);
+    one_gpu.set_feature(Target::OpenCL, false);
+    one_gpu.set_feature(Target::Metal, false);
+    one_gpu.set_feature(Target::CUDA, false);
+    one_gpu.set_feature(Target::HVX_64, false);
+    one_gpu.set_feature(Target::HVX_128, false);
+    one_gpu.set_feature(Target::OpenGL, false);
+    one_gpu.set_feature(Target::OpenGLCompute, false);
+    string module_name;
+    switch (runtime_kind) {
+    case OpenCL:
+        one_gpu.set_feature(Target::OpenCL);
+        module_name = "opencl";
+        break;
+    case Metal:
+        one_gpu.set_feature(Target::Metal);
+        module_name = "metal";
+        break;
+    case CUDA:
+        one_gpu.set_feature(Target::CUDA);
+        module_name = "cuda";
+        break;
+    case OpenGL:
+        one_gpu.set_feature(Target::OpenGL);
+        module_name = "opengl";
+        break;
+    case OpenGLCompute:
+        one_gpu.set_feature(Target::OpenGLCompute);
+        module_name = "openglcompute";
+        break;
+    case Hexagon:
+        one_gpu.set_feature(Target::HVX_64);
+        module_name = "hexagon";
+        break;
+    default:
+        module_name = "shared runtime";
+        break;
+    }
+
+    JITModule &runtime = shared_runtimes()[module_name + "/" + one_gpu.to_string()];
     if (!runtime.compiled() && create) {
-        // Ensure that JIT feature is set on target as it must be in
-        // order for the right runtime components to be added.
-        target.set_feature(Target::JIT);
-
-        Target one_gpu(target);
-        one_gpu.set_feature(Target::OpenCL, false);
-        one_gpu.set_feature(Target::Metal, false);
-        one_gpu.set_feature(Target::CUDA, false);
-        one_gpu.set_feature(Target::HVX_64, false);
-        one_gpu.set_feature(Target::HVX_128, false);
-        one_gpu.set_feature(Target::OpenGL, false);
-        one_gpu.set_feature(Target::OpenGLCompute, false);
-        string module_name;
         switch (runtime_kind) {
-        case OpenCL:
-            one_gpu.set_feature(Target::OpenCL);
-            module_name = "opencl";
-            break;
         case Metal:
-            one_gpu.set_feature(Target::Metal);
-            module_name = "metal";
             load_metal();
             break;
-        case CUDA:
-            one_gpu.set_feature(Target::CUDA);
-            module_name = "cuda";
-            break;
         case OpenGL:
-            one_gpu.set_feature(Target::OpenGL);
-            module_name = "opengl";
-            load_opengl();
-            break;
         case OpenGLCompute:
-            one_gpu.set_feature(Target::OpenGLCompute);
-            module_name = "openglcompute";
             load_opengl();
             break;
-        case Hexagon:
-            one_gpu.set_feature(Target::HVX_64);
-            module_name = "hexagon";
-            break;
         default:
-            module_name = "shared runtime";
             break;
         }
 
@@ -726,13 +820,13 @@ JITModule &make_module(llvm::Module *for_module, Target target,
                 hook_function(runtime.exports(), "halide_set_custom_trace", trace_handler);
 
             runtime_internal_handlers.custom_get_symbol =
-                hook_function(shared_runtimes(MainShared).exports(), "halide_set_custom_get_symbol", get_symbol_handler);
+                hook_function(runtime.exports(), "halide_set_custom_get_symbol", get_symbol_handler);
 
             runtime_internal_handlers.custom_load_library =
-                hook_function(shared_runtimes(MainShared).exports(), "halide_set_custom_load_library", load_library_handler);
+                hook_function(runtime.exports(), "halide_set_custom_load_library", load_library_handler);
 
             runtime_internal_handlers.custom_get_library_symbol =
-                hook_function(shared_runtimes(MainShared).exports(), "halide_set_custom_get_library_symbol", get_library_symbol_handler);
+                hook_function(runtime.exports(), "halide_set_custom_get_library_symbol", get_library_symbol_handler);
 
             active_handlers = runtime_internal_handlers;
             merge_handlers(active_handlers, default_handlers);
@@ -836,9 +930,7 @@ void JITSharedRuntime::init_jit_user_context(JITUserContext &jit_user_context,
 void JITSharedRuntime::release_all() {
     std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
 
-    for (int i = MaxRuntimeKind; i > 0; i--) {
-        shared_runtimes((RuntimeKind)(i - 1)) = JITModule();
-    }
+    shared_runtimes().clear();
 }
 
 JITHandlers JITSharedRuntime::set_default_handlers(const JITHandlers &handlers) {
@@ -854,7 +946,13 @@ void JITSharedRuntime::memoization_cache_set_size(int64_t size) {
 
     if (size != default_cache_size) {
         default_cache_size = size;
-        shared_runtimes(MainShared).memoization_cache_set_size(size);
+        // Every main shared runtime gets the new size; GPU runtimes
+        // don't hold a memoization cache.
+        for (auto &iter : shared_runtimes()) {
+            if (iter.first.compare(0, 15, "shared runtime/") == 0) {
+                iter.second.memoization_cache_set_size(size);
+            }
+        }
     }
 }
 
@@ -5,11 +5,55 @@
 #include "IROperator.h"
 #include "Scope.h"
 
+#include <set>
+
 namespace Halide {
 namespace Internal {
 
 using std::string;
 using std::map;
+using std::set;
+
+// Facts about a loop body that determine what can be lifted out of
+// it. Gathered once per loop.
+class LoopBodyFacts : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Store *op) {
+        written.insert(op->name);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Allocate *op) {
+        // The allocation doesn't outlive the loop body, so loads from
+        // it can't be lifted either.
+        written.insert(op->name);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Call *op) {
+        if (!op->is_pure()) {
+            // An impure call could write to anything.
+            has_impure_calls = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const For *op) {
+        if (op->for_type == ForType::GPUBlock ||
+            op->for_type == ForType::GPUThread ||
+            (op->device_api != DeviceAPI::None &&
+             op->device_api != DeviceAPI::Host)) {
+            has_device_loops = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    set<string> written;
+    bool has_impure_calls{false};
+    bool has_device_loops{false};
+};
 
 // Is it safe to lift an Expr out of a loop (and potentially across a device boundary)
 class CanLift : public IRVisitor {
@@ -18,13 +62,27 @@ class CanLift : public IRVisitor {
     void visit(const Call *op) {
         if (!op->is_pure()) {
             result = false;
+        } else if (op->is_intrinsic(Call::if_then_else)) {
+            // The branches are conditionally evaluated, so loads in
+            // them can't be speculated. select is fine; it evaluates
+            // both sides.
+            ScopedValue<bool> old(loads_ok, false);
+            IRVisitor::visit(op);
         } else {
             IRVisitor::visit(op);
         }
     }
 
     void visit(const Load *op) {
-        result = false;
+        // A load can be lifted if nothing in the loop writes to the
+        // same buffer. Buffers have distinct names at this point, so
+        // the names are the alias analysis.
+        if (!loads_ok || facts.written.count(op->name)) {
+            result = false;
+        } else {
+            contains_load = true;
+            IRVisitor::visit(op);
+        }
     }
 
     void visit(const Variable *op) {
@@ -34,11 +92,15 @@ class CanLift : public IRVisitor {
     }
 
     const Scope<int> &varying;
+    const LoopBodyFacts &facts;
 
 public:
     bool result {true};
+    bool contains_load {false};
+    bool loads_ok;
 
-    CanLift(const Scope<int> &v) : varying(v) {}
+    CanLift(const Scope<int> &v, const LoopBodyFacts &facts, bool loads_ok)
+        : varying(v), facts(facts), loads_ok(loads_ok) {}
 };
 
 // Lift pure loop invariants to the top level. Applied independently
@@ -47,15 +109,13 @@ class LiftLoopInvariants : public IRMutator2 {
     using IRMutator2::visit;
 
     Scope<int> varying;
-
-    bool can_lift(const Expr &e) {
-        CanLift check(varying);
-        e.accept(&check);
-        return check.result;
-    }
+    const LoopBodyFacts &facts;
+    bool loads_ok;
 
     bool should_lift(const Expr &e) {
-        if (!can_lift(e)) return false;
+        CanLift check(varying, facts, loads_ok);
+        e.accept(&check);
+        if (!check.result) return false;
         if (e.as<Variable>()) return false;
         if (e.as<Broadcast>()) return false;
         if (is_const(e)) return false;
@@ -63,6 +123,9 @@ class LiftLoopInvariants : public IRMutator2 {
         // (We just skip all vectors on the principle that we don't want them
         // on the stack anyway.)
         if (e.type().is_vector()) return false;
+        if (check.contains_load) {
+            lifted_loads = true;
+        }
         return true;
     }
 
@@ -81,6 +144,41 @@ class LiftLoopInvariants : public IRMutator2 {
         return IRMutator2::visit(op);
     }
 
+    Stmt visit(const IfThenElse *op) override {
+        // The branches only run for some iterations, so don't
+        // speculate loads found in them.
+        Expr condition = mutate(op->condition);
+        ScopedValue<bool> old(loads_ok, false);
+        Stmt then_case = mutate(op->then_case);
+        Stmt else_case;
+        if (op->else_case.defined()) {
+            else_case = mutate(op->else_case);
+        }
+        if (condition.same_as(op->condition) &&
+            then_case.same_as(op->then_case) &&
+            else_case.same_as(op->else_case)) {
+            return op;
+        }
+        return IfThenElse::make(condition, then_case, else_case);
+    }
+
+    Expr visit(const Call *op) override {
+        if (op->is_intrinsic(Call::if_then_else)) {
+            Expr cond = mutate(op->args[0]);
+            ScopedValue<bool> old(loads_ok, false);
+            Expr true_value = mutate(op->args[1]);
+            Expr false_value = mutate(op->args[2]);
+            if (cond.same_as(op->args[0]) &&
+                true_value.same_as(op->args[1]) &&
+                false_value.same_as(op->args[2])) {
+                return op;
+            }
+            return Call::make(op->type, op->name,
+                              {cond, true_value, false_value}, op->call_type);
+        }
+        return IRMutator2::visit(op);
+    }
+
 public:
 
     using IRMutator2::mutate;
@@ -101,6 +199,10 @@ public:
     }
 
     map<Expr, string, IRDeepCompare> lifted;
+    bool lifted_loads {false};
+
+    LiftLoopInvariants(const LoopBodyFacts &facts, bool loads_ok)
+        : facts(facts), loads_ok(loads_ok) {}
 };
 
 class LICM : public IRMutator2 {
@@ -122,9 +224,19 @@ class LICM : public IRMutator2 {
             // Don't lift anything out of OpenGL loops
             return IRMutator2::visit(op);
         } else {
+            LoopBodyFacts facts;
+            op->body.accept(&facts);
+
+            // Loads can only be lifted if nothing in the loop can
+            // write to the buffer loaded from, which we can't tell
+            // for loops that call impure functions or hand work to a
+            // device.
+            bool loads_ok = (!facts.has_impure_calls &&
+                             !facts.has_device_loops &&
+                             !in_gpu_loop);
 
             // Lift invariants
-            LiftLoopInvariants lifter;
+            LiftLoopInvariants lifter(facts, loads_ok);
             Stmt new_stmt = lifter.mutate(op);
 
             // Recurse
@@ -139,6 +251,14 @@ class LICM : public IRMutator2 {
                 new_stmt = LetStmt::make(p.second, p.first, new_stmt);
             }
 
+            if (lifter.lifted_loads) {
+                // The lifted loads were only known to be in-bounds
+                // when the loop body ran at least once. The simplifier
+                // removes this check when the extent is provably
+                // positive.
+                new_stmt = IfThenElse::make(0 < loop->extent, new_stmt);
+            }
+
             return new_stmt;
         }
     }
@@ -83,6 +83,7 @@ DECLARE_CPP_INITMOD(cuda)
 DECLARE_CPP_INITMOD(destructors)
 DECLARE_CPP_INITMOD(device_interface)
 DECLARE_CPP_INITMOD(errors)
+DECLARE_CPP_INITMOD(fake_perf_counters)
 DECLARE_CPP_INITMOD(fake_thread_pool)
 DECLARE_CPP_INITMOD(float16_t)
 DECLARE_CPP_INITMOD(gcd_thread_pool)
@@ -90,8 +91,10 @@ DECLARE_CPP_INITMOD(gpu_device_selection)
 DECLARE_CPP_INITMOD(hexagon_host)
 DECLARE_CPP_INITMOD(ios_io)
 DECLARE_CPP_INITMOD(linux_clock)
+DECLARE_CPP_INITMOD(linux_cpu_topology)
 DECLARE_CPP_INITMOD(linux_host_cpu_count)
 DECLARE_CPP_INITMOD(linux_opengl_context)
+DECLARE_CPP_INITMOD(linux_perf_counters)
 DECLARE_CPP_INITMOD(matlab)
 DECLARE_CPP_INITMOD(metadata)
 DECLARE_CPP_INITMOD(mingw_math)
@@ -122,11 +125,14 @@ DECLARE_CPP_INITMOD(qurt_allocator)
 DECLARE_CPP_INITMOD(qurt_hvx)
 DECLARE_CPP_INITMOD(qurt_init_fini)
 DECLARE_CPP_INITMOD(qurt_thread_pool)
+DECLARE_CPP_INITMOD(region_math)
 DECLARE_CPP_INITMOD(runtime_api)
+DECLARE_CPP_INITMOD(runtime_profiles)
 DECLARE_CPP_INITMOD(ssp)
 DECLARE_CPP_INITMOD(thread_pool)
 DECLARE_CPP_INITMOD(to_string)
 DECLARE_CPP_INITMOD(tracing)
+DECLARE_CPP_INITMOD(warmup)
 DECLARE_CPP_INITMOD(windows_clock)
 DECLARE_CPP_INITMOD(windows_cuda)
 DECLARE_CPP_INITMOD(windows_get_symbol)
@@ -635,6 +641,7 @@ std::unique_ptr<llvm::Module> get_initial_module_for_target(Target t, llvm::LLVM
                 modules.push_back(get_initmod_posix_io(c, bits_64, debug));
                 modules.push_back(get_initmod_posix_tempfile(c, bits_64, debug));
                 modules.push_back(get_initmod_linux_host_cpu_count(c, bits_64, debug));
+                modules.push_back(get_initmod_linux_cpu_topology(c, bits_64, debug));
                 modules.push_back(get_initmod_posix_threads(c, bits_64, debug));
                 modules.push_back(get_initmod_thread_pool(c, bits_64, debug));
                 modules.push_back(get_initmod_posix_get_symbol(c, bits_64, debug));
@@ -659,6 +666,7 @@ std::unique_ptr<llvm::Module> get_initial_module_for_target(Target t, llvm::LLVM
                 modules.push_back(get_initmod_android_io(c, bits_64, debug));
                 modules.push_back(get_initmod_android_tempfile(c, bits_64, debug));
                 modules.push_back(get_initmod_android_host_cpu_count(c, bits_64, debug));
+                modules.push_back(get_initmod_linux_cpu_topology(c, bits_64, debug));
                 modules.push_back(get_initmod_posix_threads(c, bits_64, debug));
                 modules.push_back(get_initmod_thread_pool(c, bits_64, debug));
                 modules.push_back(get_initmod_posix_get_symbol(c, bits_64, debug));
@@ -731,6 +739,14 @@ std::unique_ptr<llvm::Module> get_initial_module_for_target(Target t, llvm::LLVM
                 // TODO: Support this module in the Hexagon backend,
                 // currently generates assert at src/HexagonOffload.cpp:279
                 modules.push_back(get_initmod_cache(c, bits_64, debug));
+
+                // Composes the thread pool, allocation pool, and
+                // cache knobs, so it goes wherever the cache does.
+                modules.push_back(get_initmod_runtime_profiles(c, bits_64, debug));
+
+                // The warmup entry point primes the cache, so it
+                // also goes wherever the cache does.
+                modules.push_back(get_initmod_warmup(c, bits_64, debug));
             }
             modules.push_back(get_initmod_to_string(c, bits_64, debug));
 
@@ -743,6 +759,7 @@ std::unique_ptr<llvm::Module> get_initial_module_for_target(Target t, llvm::LLVM
             }
 
             modules.push_back(get_initmod_device_interface(c, bits_64, debug));
+            modules.push_back(get_initmod_region_math(c, bits_64, debug));
             modules.push_back(get_initmod_metadata(c, bits_64, debug));
             modules.push_back(get_initmod_float16_t(c, bits_64, debug));
             modules.push_back(get_initmod_old_buffer_t(c, bits_64, debug));
@@ -752,6 +769,14 @@ std::unique_ptr<llvm::Module> get_initial_module_for_target(Target t, llvm::LLVM
                 t.os != Target::QuRT) {
                 // MIPS doesn't support the atomics the profiler requires.
                 modules.push_back(get_initmod_profiler(c, bits_64, debug));
+                if (t.os == Target::Linux && t.arch == Target::X86) {
+                    // linux_perf_counters hardcodes the x86 syscall
+                    // numbers for perf_event_open, like linux_clock
+                    // does for clock_gettime.
+                    modules.push_back(get_initmod_linux_perf_counters(c, bits_64, debug));
+                } else {
+                    modules.push_back(get_initmod_fake_perf_counters(c, bits_64, debug));
+                }
             }
 
             if (t.has_feature(Target::MSAN)) {
@@ -799,7 +824,8 @@ std::unique_ptr<llvm::Module> get_initial_module_for_target(Target t, llvm::LLVM
             if (t.has_feature(Target::AVX)) {
                 modules.push_back(get_initmod_x86_avx_ll(c));
             }
-            if (t.has_feature(Target::Profile)) {
+            if (t.has_feature(Target::Profile) ||
+                t.has_feature(Target::ProfileLoops)) {
                 modules.push_back(get_initmod_profiler_inlined(c, bits_64, debug));
             }
         }
@@ -6,6 +6,7 @@
 #include "IREquality.h"
 #include "ExprUsesVar.h"
 #include "CSE.h"
+#include "Util.h"
 
 #include <algorithm>
 
@@ -193,6 +194,10 @@ class LoopCarryOverLoop : public IRMutator {
 
     int max_carried_values;
 
+    // Whether to rotate windows of overlapping vector loads through
+    // registers with shuffles.
+    bool rotate_windows;
+
     using IRMutator::visit;
 
     void visit(const LetStmt *op) {
@@ -243,6 +248,106 @@ class LoopCarryOverLoop : public IRMutator {
         stmt = Block::make(result);
     }
 
+    /** Replace the interior loads of a group of overlapping dense
+     * vector loads with shuffles of the two extreme loads of the
+     * group. A w-wide vectorized stencil does w dense loads per
+     * iteration at bases b, b+1, ..., b+w-1; all but the first and
+     * last read memory that the extremes cover between them, so they
+     * can be reconstructed by shift-and-insert instead. No new loads
+     * are introduced (the window consists of loads already present),
+     * so this can't read out of bounds. */
+    Stmt rotate_shifted_loads(Stmt s, bool *changed) {
+        FindLoads find_loads;
+        s.accept(&find_loads);
+
+        // Group the dense, unpredicated vector loads by buffer and type.
+        vector<vector<const Load *>> groups;
+        for (const Load *load : find_loads.result) {
+            // The same safety condition as for lifting: the buffer
+            // must not be written to within this loop.
+            bool safe = (load->image.defined() ||
+                         load->param.defined() ||
+                         in_consume.contains(load->name));
+            if (!safe) continue;
+            const Ramp *r = load->index.as<Ramp>();
+            if (!r || !is_one(r->stride) || !is_one(load->predicate)) continue;
+            bool represented = false;
+            for (vector<const Load *> &g : groups) {
+                if (g[0]->name == load->name && g[0]->type == load->type) {
+                    g.push_back(load);
+                    represented = true;
+                    break;
+                }
+            }
+            if (!represented) {
+                groups.push_back({load});
+            }
+        }
+
+        for (const vector<const Load *> &g : groups) {
+            // We need at least one load strictly between the extremes
+            // for there to be anything to do.
+            if (g.size() < 3) continue;
+
+            // The loads must all be at constant offsets from each other.
+            Expr base0 = g[0]->index.as<Ramp>()->base;
+            vector<int> offsets(g.size());
+            bool ok = true;
+            for (size_t i = 0; i < g.size(); i++) {
+                // The bases are full graphs, so CSE before
+                // simplifying to avoid exponential blowup.
+                Expr diff = g[i]->index.as<Ramp>()->base - base0;
+                diff = simplify(common_subexpression_elimination(diff));
+                diff = substitute_in_all_lets(diff);
+                const int64_t *d = as_const_int(diff);
+                if (!d) {
+                    ok = false;
+                    break;
+                }
+                offsets[i] = (int)(*d);
+            }
+            if (!ok) continue;
+
+            int min_off = offsets[0], max_off = offsets[0];
+            for (int o : offsets) {
+                min_off = std::min(min_off, o);
+                max_off = std::max(max_off, o);
+            }
+
+            // The two extreme loads must cover the whole window
+            // between them.
+            const int lanes = g[0]->type.lanes();
+            const int span = max_off - min_off;
+            if (span <= 1 || span >= lanes) continue;
+
+            const Load *w0 = nullptr, *w1 = nullptr;
+            for (size_t i = 0; i < g.size(); i++) {
+                if (offsets[i] == min_off) w0 = g[i];
+                if (offsets[i] == max_off) w1 = g[i];
+            }
+
+            for (size_t i = 0; i < g.size(); i++) {
+                int c = offsets[i] - min_off;
+                if (c == 0 || c == span) continue;
+                // Element j of this load is element c + j of the
+                // window. It's in w0 if it's below w0's last lane,
+                // and in w1 otherwise; the overlap of the extremes
+                // guarantees there's no gap.
+                vector<int> indices(lanes);
+                for (int j = 0; j < lanes; j++) {
+                    int pos = c + j;
+                    indices[j] = (pos < lanes) ? pos : (pos - span) + lanes;
+                }
+                Expr rotated = Shuffle::make({Expr(w0), Expr(w1)}, indices);
+                debug(3) << "Rotating load " << Expr(g[i]) << " into " << rotated << "\n";
+                s = graph_substitute(g[i], rotated, s);
+                *changed = true;
+            }
+        }
+
+        return s;
+    }
+
     Stmt lift_carried_values_out_of_stmt(Stmt orig_stmt) {
         debug(4) << "About to lift carried values out of stmt: " << orig_stmt << "\n";
 
@@ -251,6 +356,14 @@ class LoopCarryOverLoop : public IRMutator {
         // exponential runtime.
         Stmt graph_stmt = substitute_in_all_lets(orig_stmt);
 
+        // First rewrite overlapping vector loads as shuffles of the
+        // extremes of their window, so that only the extremes remain
+        // as candidates for carrying.
+        bool rotated = false;
+        if (rotate_windows) {
+            graph_stmt = rotate_shifted_loads(graph_stmt, &rotated);
+        }
+
         // Find all the loads in these stmts.
         FindLoads find_loads;
         graph_stmt.accept(&find_loads);
@@ -308,6 +421,12 @@ class LoopCarryOverLoop : public IRMutator {
         }
 
         if (chains.empty()) {
+            if (rotated) {
+                // No carrying to do, but the rotation alone saves
+                // loads. CSE the graph so each window load is done
+                // once.
+                return common_subexpression_elimination(graph_stmt);
+            }
             return orig_stmt;
         }
 
@@ -480,8 +599,10 @@ class LoopCarryOverLoop : public IRMutator {
     }
 
 public:
-    LoopCarryOverLoop(const string &var, const Scope<int> &s, int max_carried_values)
-        : in_consume(s), max_carried_values(max_carried_values) {
+    LoopCarryOverLoop(const string &var, const Scope<int> &s,
+                      int max_carried_values, bool rotate_windows)
+        : in_consume(s), max_carried_values(max_carried_values),
+          rotate_windows(rotate_windows) {
         linear.push(var, 1);
     }
 
@@ -495,12 +616,211 @@ public:
     vector<ScratchAllocation> allocs;
 };
 
+/** Software-pipeline the loads of innermost serial loops: issue the
+ * loads that iteration i+1 needs at the bottom of iteration i, into
+ * scratch buffers, so that in-order cores have an entire loop body's
+ * worth of work in which to cover the load latency. The loop becomes
+ * a prologue that does the first iteration's loads, a kernel that
+ * runs all iterations but the last, and an epilogue for the last
+ * iteration, which must not load past the end of its inputs. */
+class PipelineLoads : public IRMutator {
+    using IRMutator::visit;
+
+    const set<string> &pipelined_funcs;
+    Scope<int> in_consume;
+
+    // Keeping too many loads in flight just spills the scratch
+    // buffers back to the stack.
+    static const int max_pipelined_loads = 8;
+
+    bool should_pipeline(const string &loop_name) const {
+        for (const string &f : pipelined_funcs) {
+            if (starts_with(loop_name, f + ".")) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    class HasControlFlow : public IRVisitor {
+        using IRVisitor::visit;
+        void visit(const For *op) {
+            result = true;
+        }
+        void visit(const IfThenElse *op) {
+            result = true;
+        }
+    public:
+        bool result = false;
+    };
+
+    void visit(const ProducerConsumer *op) {
+        if (op->is_producer) {
+            IRMutator::visit(op);
+        } else {
+            in_consume.push(op->name, 0);
+            Stmt body = mutate(op->body);
+            in_consume.pop(op->name);
+            stmt = ProducerConsumer::make(op->name, op->is_producer, body);
+        }
+    }
+
+    /** Returns an undefined Stmt if there's nothing worth doing. */
+    Stmt pipeline_loop(const For *op) {
+        // Loads under inner control flow might not run on every
+        // iteration, so only handle innermost straight-line bodies.
+        HasControlFlow control_flow;
+        op->body.accept(&control_flow);
+        if (control_flow.result) {
+            return Stmt();
+        }
+
+        Scope<Expr> linear;
+        linear.push(op->name, 1);
+
+        // The body as a graph (lets substituted in). Only use
+        // graph-aware methods on it.
+        Stmt graph_body = substitute_in_all_lets(op->body);
+        FindLoads find_loads;
+        graph_body.accept(&find_loads);
+
+        // Group equal loads, keeping only the ones that are safe to
+        // issue an iteration early and that actually move with the
+        // loop.
+        vector<vector<const Load *>> loads;
+        vector<Expr> next_indices;
+        for (const Load *load : find_loads.result) {
+            bool safe = (load->image.defined() ||
+                         load->param.defined() ||
+                         in_consume.contains(load->name));
+            if (!safe || !is_one(load->predicate)) continue;
+
+            bool represented = false;
+            for (vector<const Load *> &v : loads) {
+                if (graph_equal(Expr(load), Expr(v[0]))) {
+                    v.push_back(load);
+                    represented = true;
+                }
+            }
+            if (represented || (int)loads.size() >= max_pipelined_loads) {
+                continue;
+            }
+
+            Expr next_index = step_forwards(load->index, linear);
+            if (!next_index.defined()) continue;
+
+            // Loop invariants don't need to be loaded again each
+            // iteration at all; leave them for LICM.
+            Expr cur_index = common_subexpression_elimination(load->index);
+            cur_index = substitute_in_all_lets(simplify(cur_index));
+            if (graph_equal(cur_index, next_index)) continue;
+
+            loads.push_back({load});
+            next_indices.push_back(next_index);
+        }
+
+        if (loads.empty()) {
+            return Stmt();
+        }
+
+        Stmt core = graph_body;
+        vector<Stmt> next_iteration_loads;
+        vector<Stmt> initial_stores;
+        vector<pair<string, Type>> scratch_buffers;
+        for (size_t i = 0; i < loads.size(); i++) {
+            const Load *orig = loads[i][0];
+            string scratch = unique_name('p');
+            Expr idx = scratch_index(0, orig->type);
+            Expr from_scratch = Load::make(orig->type, scratch, idx, Buffer<>(),
+                                           Parameter(), const_true(orig->type.lanes()));
+            for (const Load *l : loads[i]) {
+                core = graph_substitute(l, from_scratch, core);
+            }
+            Expr next_load = Load::make(orig->type, orig->name, next_indices[i],
+                                        orig->image, orig->param,
+                                        const_true(orig->type.lanes()));
+            next_iteration_loads.push_back(
+                Store::make(scratch, next_load, idx, Parameter(),
+                            const_true(orig->type.lanes())));
+            initial_stores.push_back(
+                Store::make(scratch, Expr(orig), idx, Parameter(),
+                            const_true(orig->type.lanes())));
+            scratch_buffers.push_back({scratch, orig->type});
+        }
+
+        core = common_subexpression_elimination(core);
+
+        // The kernel runs every iteration but the last, and issues
+        // the next iteration's loads after the current iteration's
+        // work.
+        Stmt kernel = Block::make(
+            core, common_subexpression_elimination(Block::make(next_iteration_loads)));
+        kernel = For::make(op->name, op->min, op->extent - 1,
+                           op->for_type, op->device_api, kernel);
+
+        // The last iteration must not issue loads past the end of
+        // its inputs, so peel it off as an epilogue. Its loads were
+        // already done by the last kernel iteration (or by the
+        // prologue, if the kernel didn't run).
+        Stmt epilogue = substitute(op->name, op->min + op->extent - 1, core);
+
+        // The prologue fills the scratch buffers for the first
+        // iteration.
+        Stmt prologue = common_subexpression_elimination(Block::make(initial_stores));
+        prologue = substitute(op->name, op->min, prologue);
+
+        Stmt s = Block::make({prologue, kernel, epilogue});
+        for (const auto &scratch : scratch_buffers) {
+            s = Allocate::make(scratch.first, scratch.second.element_of(),
+                               {scratch.second.lanes()}, const_true(), s);
+        }
+        // The prologue and epilogue assume at least one iteration.
+        s = IfThenElse::make(0 < op->extent, s);
+        return s;
+    }
+
+    void visit(const For *op) {
+        if (op->for_type == ForType::Serial &&
+            !is_one(op->extent) &&
+            should_pipeline(op->name)) {
+            Stmt s = pipeline_loop(op);
+            if (s.defined()) {
+                debug(3) << "Software-pipelined loop " << op->name << "\n";
+                stmt = s;
+                return;
+            }
+        }
+        IRMutator::visit(op);
+    }
+
+public:
+    PipelineLoads(const set<string> &pipelined_funcs)
+        : pipelined_funcs(pipelined_funcs) {}
+};
+
 class LoopCarry : public IRMutator {
     using IRMutator::visit;
 
     int max_carried_values;
+    const set<string> &store_forwarding_funcs;
     Scope<int> in_consume;
 
+    // If we were given a specific set of Funcs, only their loops are
+    // fair game, and we additionally rotate windows of overlapping
+    // loads. With no Funcs specified (the Hexagon backend's use of
+    // this pass), every serial loop is considered, without rotation.
+    bool should_carry(const string &loop_name) const {
+        if (store_forwarding_funcs.empty()) {
+            return true;
+        }
+        for (const string &f : store_forwarding_funcs) {
+            if (starts_with(loop_name, f + ".")) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void visit(const ProducerConsumer *op) {
         if (op->is_producer) {
             IRMutator::visit(op);
@@ -513,9 +833,10 @@ class LoopCarry : public IRMutator {
     }
 
     void visit(const For *op) {
-        if (op->for_type == ForType::Serial && !is_one(op->extent)) {
+        if (op->for_type == ForType::Serial && !is_one(op->extent) && should_carry(op->name)) {
             Stmt body = mutate(op->body);
-            LoopCarryOverLoop carry(op->name, in_consume, max_carried_values);
+            LoopCarryOverLoop carry(op->name, in_consume, max_carried_values,
+                                    !store_forwarding_funcs.empty());
             body = carry.mutate(body);
             if (body.same_as(op->body)) {
                 stmt = op;
@@ -538,17 +859,27 @@ class LoopCarry : public IRMutator {
     }
 
 public:
-    LoopCarry(int max_carried_values) : max_carried_values(max_carried_values) {}
+    LoopCarry(int max_carried_values, const set<string> &store_forwarding_funcs)
+        : max_carried_values(max_carried_values),
+          store_forwarding_funcs(store_forwarding_funcs) {}
 };
 
 }
 
 
-Stmt loop_carry(Stmt s, int max_carried_values) {
-    s = LoopCarry(max_carried_values).mutate(s);
+Stmt loop_carry(Stmt s, int max_carried_values,
+                const std::set<std::string> &store_forwarding_funcs) {
+    s = LoopCarry(max_carried_values, store_forwarding_funcs).mutate(s);
     return s;
 }
 
+Stmt pipeline_loads(Stmt s, const std::set<std::string> &pipelined_funcs) {
+    if (pipelined_funcs.empty()) {
+        return s;
+    }
+    return PipelineLoads(pipelined_funcs).mutate(s);
+}
+
 
 }
 }
@@ -1,6 +1,9 @@
 #ifndef HALIDE_LOOP_CARRY_H
 #define HALIDE_LOOP_CARRY_H
 
+#include <set>
+#include <string>
+
 #include "Expr.h"
 
 namespace Halide {
@@ -10,9 +13,23 @@ namespace Internal {
  * induction variables instead of redoing the load. If the loads are
  * predicated, the predicates need to match. Can be an optimization or
  * pessimization depending on how good the L1 cache is on the architecture
- * and how many memory issue slots there are. Currently only intended
- * for Hexagon. */
-Stmt loop_carry(Stmt, int max_carried_values = 8);
+ * and how many memory issue slots there are. With an empty set of
+ * Funcs, considers every serial loop (the Hexagon backend's use of
+ * this pass). With a non-empty set, only loops belonging to those
+ * Funcs are considered, and windows of overlapping dense vector
+ * loads are additionally rotated through registers with shuffles
+ * (see Func::store_forwarding). */
+Stmt loop_carry(Stmt, int max_carried_values = 8,
+                const std::set<std::string> &store_forwarding_funcs = std::set<std::string>());
+
+/** Software-pipeline the innermost serial loops of the given Funcs
+ * into a prologue, kernel, and epilogue. The kernel issues the loads
+ * that iteration i+1 needs at the bottom of iteration i, into scratch
+ * buffers, so in-order cores (Hexagon, in-order ARM) have a full loop
+ * body's worth of work in which to cover the load latency instead of
+ * stalling at the top of every iteration. See
+ * Func::software_pipeline. */
+Stmt pipeline_loads(Stmt s, const std::set<std::string> &pipelined_funcs);
 
 }
 }
@@ -1,4 +1,7 @@
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <algorithm>
@@ -7,7 +10,9 @@
 
 #include "AddImageChecks.h"
 #include "AddParameterChecks.h"
+#include "AddRequirements.h"
 #include "AllocationBoundsInference.h"
+#include "AsyncProducers.h"
 #include "Bounds.h"
 #include "BoundsInference.h"
 #include "CSE.h"
@@ -17,10 +22,13 @@
 #include "DebugToFile.h"
 #include "Deinterleave.h"
 #include "EarlyFree.h"
+#include "EmulateFloat16Math.h"
 #include "FindCalls.h"
+#include "FoldConstantFuncs.h"
 #include "Func.h"
 #include "Function.h"
 #include "FuseGPUThreadLoops.h"
+#include "FuseOutputLoops.h"
 #include "FuzzFloatStores.h"
 #include "HexagonOffload.h"
 #include "InferArguments.h"
@@ -32,12 +40,14 @@
 #include "IRPrinter.h"
 #include "LICM.h"
 #include "LoopCarry.h"
+#include "LowerAtomics.h"
 #include "Memoization.h"
 #include "PartitionLoops.h"
 #include "Prefetch.h"
 #include "Profiling.h"
 #include "Qualify.h"
 #include "RealizationOrder.h"
+#include "RegisterPressure.h"
 #include "RemoveDeadAllocations.h"
 #include "RemoveTrivialForLoops.h"
 #include "RemoveUndef.h"
@@ -50,7 +60,10 @@
 #include "SplitTuples.h"
 #include "StorageFlattening.h"
 #include "StorageFolding.h"
+#include "StreamReadback.h"
+#include "StrengthReduceDivision.h"
 #include "Substitute.h"
+#include "ThreadPool.h"
 #include "Tracing.h"
 #include "TrimNoOps.h"
 #include "UnifyDuplicateLets.h"
@@ -71,14 +84,187 @@ using std::string;
 using std::vector;
 using std::map;
 
+namespace {
+
+// Counts the number of distinct IR nodes reachable from a Stmt. Uses the
+// graph interpretation of the IR so that shared subexpressions are counted
+// once; the count is a proxy for how much memory the IR occupies and how
+// much work subsequent passes have to do.
+class CountIRNodes : public IRGraphVisitor {
+    std::set<const IRNode *> seen;
+
+protected:
+    using IRGraphVisitor::include;
+
+    void include(const Expr &e) override {
+        if (seen.insert(e.get()).second) {
+            count++;
+        }
+        IRGraphVisitor::include(e);
+    }
+
+    void include(const Stmt &s) override {
+        if (seen.insert(s.get()).second) {
+            count++;
+        }
+        IRGraphVisitor::include(s);
+    }
+
+public:
+    int64_t count = 0;
+
+    void count_stmt(const Stmt &s) {
+        include(s);
+    }
+};
+
+// Records per-pass wall time and IR size during lowering, for tracking down
+// compile-time regressions. Enabled by pointing HL_LOWER_TIME_PASSES at a
+// file; one JSON object per lowered pipeline is appended there, so reports
+// from repeated compilations accumulate.
+class LoweringProfiler {
+    using Clock = std::chrono::steady_clock;
+
+    struct PassRecord {
+        string name;
+        double ms;
+        int64_t ir_nodes;
+    };
+
+    string path;
+    string pipeline_name;
+    Clock::time_point start, last;
+    vector<PassRecord> passes;
+
+    static string escape(const string &s) {
+        string result;
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+            }
+            result += c;
+        }
+        return result;
+    }
+
+public:
+    LoweringProfiler(const string &pipeline_name)
+        : path(get_env_variable("HL_LOWER_TIME_PASSES")),
+          pipeline_name(pipeline_name) {
+        if (enabled()) {
+            start = last = Clock::now();
+        }
+    }
+
+    bool enabled() const {
+        return !path.empty();
+    }
+
+    // Record the time since the previous checkpoint against 'pass', along
+    // with the number of distinct IR nodes in 's' after the pass ran. The
+    // node count itself is not included in the pass time.
+    void record(const string &pass, const Stmt &s) {
+        if (!enabled()) {
+            return;
+        }
+        Clock::time_point now = Clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - last).count();
+        CountIRNodes counter;
+        if (s.defined()) {
+            counter.count_stmt(s);
+        }
+        passes.push_back({pass, ms, counter.count});
+        last = Clock::now();
+    }
+
+    // Append the report for this pipeline to the file named by
+    // HL_LOWER_TIME_PASSES.
+    void finish(const Target &t) {
+        if (!enabled()) {
+            return;
+        }
+        double total_ms =
+            std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        std::ofstream file(path, std::ios_base::app);
+        if (!file) {
+            user_warning << "Could not open " << path
+                         << " to write lowering pass times\n";
+            return;
+        }
+        file << "{\"pipeline\": \"" << escape(pipeline_name) << "\", "
+             << "\"target\": \"" << t.to_string() << "\", "
+             << "\"total_ms\": " << total_ms << ", "
+             << "\"passes\": [";
+        for (size_t i = 0; i < passes.size(); i++) {
+            if (i > 0) {
+                file << ", ";
+            }
+            file << "{\"name\": \"" << escape(passes[i].name) << "\", "
+                 << "\"ms\": " << passes[i].ms << ", "
+                 << "\"ir_nodes\": " << passes[i].ir_nodes << "}";
+        }
+        file << "]}\n";
+    }
+};
+
+// Cheap feature bits about the initial loop nest, gathered in a single
+// walk. Used together with the schedules in the environment to skip
+// lowering passes which would provably do nothing, since even a no-op
+// pass is a full IR traversal.
+struct LoweringFeatures {
+    bool has_gpu_loops = false;
+    bool has_hexagon_loops = false;
+    bool has_float_stores = false;
+    bool has_unrolled_loops = false;
+    bool has_vectorized_loops = false;
+};
+
+class FindLoweringFeatures : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) override {
+        if (op->for_type == ForType::GPUBlock ||
+            op->for_type == ForType::GPUThread) {
+            result.has_gpu_loops = true;
+        } else if (op->for_type == ForType::Unrolled) {
+            result.has_unrolled_loops = true;
+        } else if (op->for_type == ForType::Vectorized) {
+            result.has_vectorized_loops = true;
+        }
+        if (op->device_api == DeviceAPI::Hexagon) {
+            result.has_hexagon_loops = true;
+        } else if ((op->device_api != DeviceAPI::None) &&
+                   (op->device_api != DeviceAPI::Host)) {
+            result.has_gpu_loops = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Store *op) override {
+        if (op->value.type().is_float()) {
+            result.has_float_stores = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    LoweringFeatures result;
+};
+
+}  // namespace
+
 Module lower(const vector<Function> &output_funcs, const string &pipeline_name, const Target &t,
              const vector<Argument> &args, const Internal::LoweredFunc::LinkageType linkage_type,
-             const vector<IRMutator2 *> &custom_passes) {
+             const vector<IRMutator2 *> &custom_passes,
+             const vector<Expr> &requirements) {
     std::vector<std::string> namespaces;
     std::string simple_pipeline_name = extract_namespaces(pipeline_name, namespaces);
 
     Module result_module(simple_pipeline_name, t);
 
+    LoweringProfiler profiler(pipeline_name);
+
     // Compute an environment
     map<string, Function> env;
     for (Function f : output_funcs) {
@@ -94,9 +280,34 @@ Module lower(const vector<Function> &output_funcs, const string &pipeline_name,
         Func(f).compute_root().store_root();
     }
 
-    // Ensure that all ScheduleParams become well-defined constant Exprs.
-    for (auto &f : env) {
-        f.second.substitute_schedule_param_exprs();
+    // Ensure that all ScheduleParams become well-defined constant
+    // Exprs, and fold the arithmetic that depended on them. Each
+    // Function is rewritten independently, so spread them across a
+    // thread pool. As in Module.cpp, drop to one thread when debug
+    // output is on so it stays readable.
+    const size_t lowering_threads =
+        (debug::debug_level() > 0) ? 1 : num_compile_time_threads();
+    std::mutex folding_report_mutex;
+    std::set<string> folding_blocked_by;
+    parallel_for_each(env, [&](std::pair<const string, Function> &f) {
+        std::set<string> blocked_by;
+        f.second.substitute_schedule_param_exprs(&blocked_by);
+        if (!blocked_by.empty()) {
+            std::lock_guard<std::mutex> lock(folding_report_mutex);
+            folding_blocked_by.insert(blocked_by.begin(), blocked_by.end());
+        }
+    }, lowering_threads);
+    if (!folding_blocked_by.empty()) {
+        // Worth knowing when hand-tuning: ScheduleParam-dependent
+        // arithmetic folds to constants unless a runtime parameter is
+        // mixed into the same definitions. Turning these into
+        // ScheduleParams (where the value really is fixed per build)
+        // lets the folding finish the job.
+        debug(1) << "ScheduleParam constant-folding is blocked by runtime parameters:";
+        for (const string &p : folding_blocked_by) {
+            debug(1) << " " << p;
+        }
+        debug(1) << "\n";
     }
 
     // Substitute in wrapper Funcs
@@ -109,40 +320,120 @@ Module lower(const vector<Function> &output_funcs, const string &pipeline_name,
     // specializations' conditions
     simplify_specializations(env);
 
+    // Bake functions whose values are entirely known at compile time
+    // into constant tables embedded in the generated code
+    fold_constant_funcs(env);
+
     debug(1) << "Creating initial loop nests...\n";
     bool any_memoized = false;
     Stmt s = schedule_functions(outputs, order, env, t, any_memoized);
+    profiler.record("schedule_functions", s);
     debug(2) << "Lowering after creating initial loop nests:\n" << s << '\n';
 
-    debug(1) << "Canonicalizing GPU var names...\n";
-    s = canonicalize_gpu_vars(s);
-    debug(2) << "Lowering after canonicalizing GPU var names:\n" << s << '\n';
+    FindLoweringFeatures features_finder;
+    s.accept(&features_finder);
+    const LoweringFeatures &features = features_finder.result;
+
+    // Feature bits which are cheaper to read off the schedules than to
+    // rediscover from the IR.
+    bool any_tracing = t.has_feature(Target::TraceLoads) ||
+                       t.has_feature(Target::TraceStores) ||
+                       t.has_feature(Target::TraceRealizations);
+    bool any_prefetches = false;
+    bool any_fused_outputs = false;
+    bool any_fused_siblings = false;
+    bool any_atomics = false;
+    bool any_stream_readback = false;
+    bool any_debug_to_file = false;
+    bool any_skip_strips = false;
+    bool any_sliding = false;
+    bool any_lifted_async = false;
+    bool any_extern_stages = false;
+    for (const auto &iter : env) {
+        const Function &f = iter.second;
+        any_tracing = any_tracing || f.is_tracing_loads() ||
+                      f.is_tracing_stores() || f.is_tracing_realizations();
+        any_debug_to_file = any_debug_to_file || !f.debug_file().empty();
+        any_extern_stages = any_extern_stages || f.has_extern_definition();
+        any_sliding = any_sliding ||
+                      !(f.schedule().store_level() == f.schedule().compute_level());
+        any_lifted_async = any_lifted_async ||
+                           (f.schedule().async() &&
+                            !(f.schedule().store_level() == f.schedule().compute_level()));
+        any_fused_outputs = any_fused_outputs || f.schedule().fused_output();
+        any_fused_siblings = any_fused_siblings ||
+                             !f.schedule().compute_with_func().empty();
+        any_stream_readback = any_stream_readback ||
+                              f.schedule().stream_readback_slices() > 0;
+        any_skip_strips = any_skip_strips ||
+                          !f.schedule().skip_strips_var().empty();
+        any_prefetches = any_prefetches ||
+                         !f.definition().schedule().prefetches().empty();
+        for (const Definition &def : f.updates()) {
+            any_prefetches = any_prefetches || !def.schedule().prefetches().empty();
+            any_atomics = any_atomics || def.schedule().atomic();
+        }
+    }
+
+    if (any_skip_strips) {
+        debug(1) << "Injecting strip-skipping predicates...\n";
+        s = skip_predicated_strips(s, env);
+        profiler.record("skip_predicated_strips", s);
+        debug(2) << "Lowering after injecting strip-skipping predicates:\n" << s << '\n';
+    } else {
+        debug(1) << "Skipping injecting strip-skipping predicates...\n";
+    }
+
+    if (features.has_gpu_loops) {
+        debug(1) << "Canonicalizing GPU var names...\n";
+        s = canonicalize_gpu_vars(s);
+        profiler.record("canonicalize_gpu_vars", s);
+        debug(2) << "Lowering after canonicalizing GPU var names:\n" << s << '\n';
+    } else {
+        debug(1) << "Skipping canonicalizing GPU var names...\n";
+    }
 
     if (any_memoized) {
         debug(1) << "Injecting memoization...\n";
         s = inject_memoization(s, env, pipeline_name, outputs);
+        profiler.record("inject_memoization", s);
         debug(2) << "Lowering after injecting memoization:\n" << s << '\n';
     } else {
         debug(1) << "Skipping injecting memoization...\n";
     }
 
-    debug(1) << "Injecting tracing...\n";
-    s = inject_tracing(s, pipeline_name, env, outputs, t);
-    debug(2) << "Lowering after injecting tracing:\n" << s << '\n';
+    if (any_tracing) {
+        debug(1) << "Injecting tracing...\n";
+        s = inject_tracing(s, pipeline_name, env, outputs, t);
+        profiler.record("inject_tracing", s);
+        debug(2) << "Lowering after injecting tracing:\n" << s << '\n';
+    } else {
+        debug(1) << "Skipping injecting tracing...\n";
+    }
 
     debug(1) << "Adding checks for parameters\n";
     s = add_parameter_checks(s, t);
+    profiler.record("add_parameter_checks", s);
     debug(2) << "Lowering after injecting parameter checks:\n" << s << '\n';
 
+    if (!requirements.empty()) {
+        debug(1) << "Adding pipeline requirement checks\n";
+        s = add_requirement_checks(s, requirements, t);
+        profiler.record("add_requirement_checks", s);
+        debug(2) << "Lowering after injecting requirement checks:\n" << s << '\n';
+    }
+
     // Compute the maximum and minimum possible value of each
     // function. Used in later bounds inference passes.
     debug(1) << "Computing bounds of each function's value\n";
     FuncValueBounds func_bounds = compute_function_value_bounds(order, env);
+    profiler.record("compute_function_value_bounds", s);
 
     // The checks will be in terms of the symbols defined by bounds
     // inference.
     debug(1) << "Adding checks for images\n";
     s = add_image_checks(s, outputs, t, order, env, func_bounds);
+    profiler.record("add_image_checks", s);
     debug(2) << "Lowering after injecting image checks:\n" << s << '\n';
 
     // This pass injects nested definitions of variable names, so we
@@ -150,62 +441,132 @@ Module lower(const vector<Function> &output_funcs, const string &pipeline_name,
     // can still simplify Exprs).
     debug(1) << "Performing computation bounds inference...\n";
     s = bounds_inference(s, outputs, order, env, func_bounds, t);
+    profiler.record("bounds_inference", s);
     debug(2) << "Lowering after computation bounds inference:\n" << s << '\n';
 
-    debug(1) << "Performing sliding window optimization...\n";
-    s = sliding_window(s, env);
-    debug(2) << "Lowering after sliding window:\n" << s << '\n';
+    if (any_sliding) {
+        debug(1) << "Performing sliding window optimization...\n";
+        s = sliding_window(s, env);
+        profiler.record("sliding_window", s);
+        debug(2) << "Lowering after sliding window:\n" << s << '\n';
+    } else {
+        debug(1) << "Skipping sliding window optimization...\n";
+    }
 
     debug(1) << "Performing allocation bounds inference...\n";
     s = allocation_bounds_inference(s, env, func_bounds);
+    profiler.record("allocation_bounds_inference", s);
     debug(2) << "Lowering after allocation bounds inference:\n" << s << '\n';
 
     debug(1) << "Removing code that depends on undef values...\n";
     s = remove_undef(s);
+    profiler.record("remove_undef", s);
     debug(2) << "Lowering after removing code that depends on undef values:\n" << s << "\n\n";
 
+    if (any_fused_outputs) {
+        // Now that bounds inference has pinned each output's loops to
+        // its own buffer, outputs marked by Pipeline::fuse_outputs
+        // can share one traversal.
+        debug(1) << "Fusing output loop nests...\n";
+        s = fuse_output_loops(s, outputs);
+        profiler.record("fuse_output_loops", s);
+        debug(2) << "Lowering after fusing output loop nests:\n" << s << '\n';
+    }
+
+    if (any_fused_siblings) {
+        // Same idea for compute_root functions marked by
+        // Func::compute_with: merge their traversals while loop names
+        // still follow the <func>.s0.<var> convention.
+        debug(1) << "Fusing sibling loop nests...\n";
+        s = fuse_sibling_loop_nests(s, env);
+        profiler.record("fuse_sibling_loop_nests", s);
+        debug(2) << "Lowering after fusing sibling loop nests:\n" << s << '\n';
+    }
+
+    if (any_lifted_async) {
+        // This duplicates the loops between each lifted producer's
+        // store and compute levels, so it must run before variable
+        // names are uniquified.
+        debug(1) << "Forking asynchronous producers...\n";
+        s = fork_async_producers(s, env);
+        profiler.record("fork_async_producers", s);
+        debug(2) << "Lowering after forking asynchronous producers:\n" << s << '\n';
+    }
+
     // This uniquifies the variable names, so we're good to simplify
     // after this point. This lets later passes assume syntactic
     // equivalence means semantic equivalence.
     debug(1) << "Uniquifying variable names...\n";
     s = uniquify_variable_names(s);
+    profiler.record("uniquify_variable_names", s);
     debug(2) << "Lowering after uniquifying variable names:\n" << s << "\n\n";
 
     debug(1) << "Performing storage folding optimization...\n";
     s = storage_folding(s, env);
+    profiler.record("storage_folding", s);
     debug(2) << "Lowering after storage folding:\n" << s << '\n';
 
-    debug(1) << "Injecting debug_to_file calls...\n";
-    s = debug_to_file(s, outputs, env);
-    debug(2) << "Lowering after injecting debug_to_file calls:\n" << s << '\n';
+    if (any_debug_to_file) {
+        debug(1) << "Injecting debug_to_file calls...\n";
+        s = debug_to_file(s, outputs, env);
+        profiler.record("debug_to_file", s);
+        debug(2) << "Lowering after injecting debug_to_file calls:\n" << s << '\n';
+    } else {
+        debug(1) << "Skipping injecting debug_to_file calls...\n";
+    }
 
     debug(1) << "Simplifying...\n"; // without removing dead lets, because storage flattening needs the strides
     s = simplify(s, false);
+    profiler.record("first_simplification", s);
     debug(2) << "Lowering after first simplification:\n" << s << "\n\n";
 
-    debug(1) << "Injecting prefetches...\n";
-    s = inject_prefetch(s, env);
-    debug(2) << "Lowering after injecting prefetches:\n" << s << "\n\n";
+    if (any_prefetches) {
+        debug(1) << "Injecting prefetches...\n";
+        s = inject_prefetch(s, env);
+        profiler.record("inject_prefetch", s);
+        debug(2) << "Lowering after injecting prefetches:\n" << s << "\n\n";
+    } else {
+        debug(1) << "Skipping injecting prefetches...\n";
+    }
 
     debug(1) << "Dynamically skipping stages...\n";
     s = skip_stages(s, order);
+    profiler.record("skip_stages", s);
     debug(2) << "Lowering after dynamically skipping stages:\n" << s << "\n\n";
 
     debug(1) << "Destructuring tuple-valued realizations...\n";
     s = split_tuples(s, env);
+    profiler.record("split_tuples", s);
     debug(2) << "Lowering after destructuring tuple-valued realizations:\n" << s << "\n\n";
 
+    if (any_stream_readback && features.has_gpu_loops) {
+        debug(1) << "Injecting streaming read-backs...\n";
+        s = inject_stream_readback(s, outputs, env);
+        profiler.record("inject_stream_readback", s);
+        debug(2) << "Lowering after injecting streaming read-backs:\n" << s << "\n\n";
+    }
+
     debug(1) << "Performing storage flattening...\n";
     s = storage_flattening(s, outputs, env, t);
+    profiler.record("storage_flattening", s);
     debug(2) << "Lowering after storage flattening:\n" << s << "\n\n";
 
+    if (any_atomics) {
+        debug(1) << "Lowering atomic updates...\n";
+        s = lower_atomics(s, env);
+        profiler.record("lower_atomics", s);
+        debug(2) << "Lowering after lowering atomic updates:\n" << s << "\n\n";
+    }
+
     debug(1) << "Unpacking buffer arguments...\n";
     s = unpack_buffers(s);
+    profiler.record("unpack_buffers", s);
     debug(2) << "Lowering after unpacking buffer arguments...\n" << s << "\n\n";
 
     if (any_memoized) {
         debug(1) << "Rewriting memoized allocations...\n";
         s = rewrite_memoized_allocations(s, env);
+        profiler.record("rewrite_memoized_allocations", s);
         debug(2) << "Lowering after rewriting memoized allocations:\n" << s << "\n\n";
     } else {
         debug(1) << "Skipping rewriting memoized allocations...\n";
@@ -221,6 +582,7 @@ Module lower(const vector<Function> &output_funcs, const string &pipeline_name,
 
         debug(1) << "Injecting host <-> dev buffer copies...\n";
         s = inject_host_dev_buffer_copies(s, t);
+        profiler.record("inject_host_dev_buffer_copies", s);
         debug(2) << "Lowering after injecting host <-> dev buffer copies:\n" << s << "\n\n";
 
         debug(1) << "Selecting a GPU API for extern stages...\n";
@@ -231,6 +593,7 @@ Module lower(const vector<Function> &output_funcs, const string &pipeline_name,
     if (t.has_feature(Target::OpenGL)) {
         debug(1) << "Injecting OpenGL texture intrinsics...\n";
         s = inject_opengl_intrinsics(s);
+        profiler.record("inject_opengl_intrinsics", s);
         debug(2) << "Lowering after OpenGL intrinsics:\n" << s << "\n\n";
     }
 
@@ -238,86 +601,170 @@ Module lower(const vector<Function> &output_funcs, const string &pipeline_name,
         t.has_feature(Target::OpenGLCompute)) {
         debug(1) << "Injecting per-block gpu synchronization...\n";
         s = fuse_gpu_thread_loops(s);
+        profiler.record("fuse_gpu_thread_loops", s);
         debug(2) << "Lowering after injecting per-block gpu synchronization:\n" << s << "\n\n";
     }
 
+    if (!requirements.empty()) {
+        debug(1) << "Applying pipeline requirements...\n";
+        s = apply_requirements(s, requirements);
+        profiler.record("apply_requirements", s);
+        debug(2) << "Lowering after applying pipeline requirements:\n" << s << "\n\n";
+    }
+
     debug(1) << "Simplifying...\n";
     s = simplify(s);
     s = unify_duplicate_lets(s);
     s = remove_trivial_for_loops(s);
+    profiler.record("second_simplification", s);
     debug(2) << "Lowering after second simplifcation:\n" << s << "\n\n";
 
-    debug(1) << "Reduce prefetch dimension...\n";
-    s = reduce_prefetch_dimension(s, t);
-    debug(2) << "Lowering after reduce prefetch dimension:\n" << s << "\n";
-
-    debug(1) << "Unrolling...\n";
-    s = unroll_loops(s);
-    s = simplify(s);
-    debug(2) << "Lowering after unrolling:\n" << s << "\n\n";
+    if (any_prefetches) {
+        debug(1) << "Reduce prefetch dimension...\n";
+        s = reduce_prefetch_dimension(s, t, env);
+        profiler.record("reduce_prefetch_dimension", s);
+        debug(2) << "Lowering after reduce prefetch dimension:\n" << s << "\n";
+    } else {
+        debug(1) << "Skipping reduce prefetch dimension...\n";
+    }
 
-    debug(1) << "Vectorizing...\n";
-    s = vectorize_loops(s, t);
-    s = simplify(s);
-    debug(2) << "Lowering after vectorizing:\n" << s << "\n\n";
+    if (features.has_unrolled_loops) {
+        debug(1) << "Unrolling...\n";
+        s = unroll_loops(s);
+        s = simplify(s);
+        profiler.record("unroll_loops", s);
+        debug(2) << "Lowering after unrolling:\n" << s << "\n\n";
+    } else {
+        debug(1) << "Skipping unrolling...\n";
+    }
 
-    debug(1) << "Detecting vector interleavings...\n";
-    s = rewrite_interleavings(s);
-    s = simplify(s);
-    debug(2) << "Lowering after rewriting vector interleavings:\n" << s << "\n\n";
+    if (features.has_vectorized_loops) {
+        debug(1) << "Vectorizing...\n";
+        s = vectorize_loops(s, t);
+        s = simplify(s);
+        profiler.record("vectorize_loops", s);
+        debug(2) << "Lowering after vectorizing:\n" << s << "\n\n";
+
+        debug(1) << "Detecting vector interleavings...\n";
+        s = rewrite_interleavings(s);
+        s = simplify(s);
+        profiler.record("rewrite_interleavings", s);
+        debug(2) << "Lowering after rewriting vector interleavings:\n" << s << "\n\n";
+    } else {
+        debug(1) << "Skipping vectorizing...\n";
+    }
 
     debug(1) << "Partitioning loops to simplify boundary conditions...\n";
     s = partition_loops(s);
     s = simplify(s);
+    profiler.record("partition_loops", s);
     debug(2) << "Lowering after partitioning loops:\n" << s << "\n\n";
 
     debug(1) << "Trimming loops to the region over which they do something...\n";
     s = trim_no_ops(s);
+    profiler.record("trim_no_ops", s);
     debug(2) << "Lowering after loop trimming:\n" << s << "\n\n";
 
+    std::set<string> store_forwarding_funcs;
+    for (const auto &iter : env) {
+        if (iter.second.schedule().store_forwarding()) {
+            store_forwarding_funcs.insert(iter.first);
+        }
+    }
+    if (!store_forwarding_funcs.empty()) {
+        debug(1) << "Forwarding loaded values across loop iterations...\n";
+        s = loop_carry(s, 8, store_forwarding_funcs);
+        s = simplify(s);
+        profiler.record("loop_carry", s);
+        debug(2) << "Lowering after forwarding loads:\n" << s << "\n\n";
+    }
+
+    std::set<string> software_pipeline_funcs;
+    for (const auto &iter : env) {
+        if (iter.second.schedule().software_pipeline()) {
+            software_pipeline_funcs.insert(iter.first);
+        }
+    }
+    if (!software_pipeline_funcs.empty()) {
+        debug(1) << "Software-pipelining loops...\n";
+        s = pipeline_loads(s, software_pipeline_funcs);
+        s = simplify(s);
+        profiler.record("pipeline_loads", s);
+        debug(2) << "Lowering after software pipelining:\n" << s << "\n\n";
+    }
+
     debug(1) << "Injecting early frees...\n";
     s = inject_early_frees(s);
+    profiler.record("inject_early_frees", s);
     debug(2) << "Lowering after injecting early frees:\n" << s << "\n\n";
 
-    if (t.has_feature(Target::Profile)) {
+    if (t.has_feature(Target::Profile) || t.has_feature(Target::ProfileLoops)) {
         debug(1) << "Injecting profiling...\n";
-        s = inject_profiling(s, pipeline_name);
+        s = inject_profiling(s, pipeline_name, t);
+        profiler.record("inject_profiling", s);
         debug(2) << "Lowering after injecting profiling:\n" << s << "\n\n";
     }
 
-    if (t.has_feature(Target::FuzzFloatStores)) {
+    if (t.has_feature(Target::FuzzFloatStores) && features.has_float_stores) {
         debug(1) << "Fuzzing floating point stores...\n";
         s = fuzz_float_stores(s);
+        profiler.record("fuzz_float_stores", s);
         debug(2) << "Lowering after fuzzing floating point stores:\n" << s << "\n\n";
     }
 
+    debug(1) << "Strength-reducing division by loop-invariant denominators...\n";
+    s = strength_reduce_division(s);
+    profiler.record("strength_reduce_division", s);
+    debug(2) << "Lowering after strength-reducing division:\n" << s << "\n\n";
+
     debug(1) << "Simplifying...\n";
     s = common_subexpression_elimination(s);
     s = loop_invariant_code_motion(s);
+    profiler.record("cse_and_licm", s);
 
     if (t.has_feature(Target::OpenGL)) {
         debug(1) << "Detecting varying attributes...\n";
         s = find_linear_expressions(s);
+        profiler.record("find_linear_expressions", s);
         debug(2) << "Lowering after detecting varying attributes:\n" << s << "\n\n";
 
         debug(1) << "Moving varying attribute expressions out of the shader...\n";
         s = setup_gpu_vertex_buffer(s);
+        profiler.record("setup_gpu_vertex_buffer", s);
         debug(2) << "Lowering after removing varying attributes:\n" << s << "\n\n";
     }
 
     s = remove_dead_allocations(s);
     s = remove_trivial_for_loops(s);
     s = simplify(s);
+    profiler.record("final_simplification", s);
     debug(1) << "Lowering after final simplification:\n" << s << "\n\n";
 
-    debug(1) << "Splitting off Hexagon offload...\n";
-    s = inject_hexagon_rpc(s, t, result_module);
-    debug(2) << "Lowering after splitting off Hexagon offload:\n" << s << '\n';
+    debug(1) << "Estimating vector register pressure...\n";
+    estimate_register_pressure(s, t);
+
+    debug(1) << "Lowering unsupported 16-bit float math...\n";
+    s = emulate_float16_math(s, t);
+    s = simplify(s);
+    profiler.record("emulate_float16_math", s);
+    debug(2) << "Lowering after emulating 16-bit float math:\n" << s << "\n\n";
+
+    if ((t.arch == Target::Hexagon) ||
+        t.features_any_of({Target::HVX_64, Target::HVX_128}) ||
+        features.has_hexagon_loops) {
+        debug(1) << "Splitting off Hexagon offload...\n";
+        s = inject_hexagon_rpc(s, t, result_module);
+        profiler.record("inject_hexagon_rpc", s);
+        debug(2) << "Lowering after splitting off Hexagon offload:\n" << s << '\n';
+    } else {
+        debug(1) << "Skipping Hexagon offload...\n";
+    }
 
     if (!custom_passes.empty()) {
         for (size_t i = 0; i < custom_passes.size(); i++) {
             debug(1) << "Running custom lowering pass " << i << "...\n";
             s = custom_passes[i]->mutate(s);
+            profiler.record("custom_pass_" + std::to_string(i), s);
             debug(1) << "Lowering after custom pass " << i << ":\n" << s << "\n\n";
         }
     }
@@ -398,6 +845,12 @@ Module lower(const vector<Function> &output_funcs, const string &pipeline_name,
 
     LoweredFunc main_func(pipeline_name, public_args, s, linkage_type);
 
+    for (const auto &iter : env) {
+        if (iter.second.schedule().store_non_temporal()) {
+            main_func.non_temporal_buffers.insert(iter.first);
+        }
+    }
+
     // If we're in debug mode, add code that prints the args.
     if (t.has_feature(Target::Debug)) {
         debug_arguments(&main_func);
@@ -405,6 +858,30 @@ Module lower(const vector<Function> &output_funcs, const string &pipeline_name,
 
     result_module.append(main_func);
 
+    // For callers that validate their buffers once and then invoke the
+    // pipeline at a high rate, also emit a copy of the entry point with
+    // every runtime check stripped, under the name
+    // "<pipeline>_unchecked". The caller's side of the contract is
+    // that anything passed to it would have passed the checked entry
+    // point. This doubles the code emitted per pipeline, so it's
+    // opt-in via the unchecked_entry target feature.
+    if (t.has_feature(Target::UncheckedEntry) &&
+        linkage_type != LoweredFunc::Internal &&
+        !t.has_feature(Target::JIT)) {
+        class StripChecks : public IRMutator2 {
+            using IRMutator2::visit;
+            Stmt visit(const AssertStmt *op) override {
+                return Evaluate::make(0);
+            }
+        };
+        // Re-simplify to sweep up the now-dead error message code.
+        Stmt unchecked_body = simplify(StripChecks().mutate(s));
+        LoweredFunc unchecked_func(pipeline_name + "_unchecked", public_args,
+                                   unchecked_body, LoweredFunc::External);
+        unchecked_func.non_temporal_buffers = main_func.non_temporal_buffers;
+        result_module.append(unchecked_func);
+    }
+
     // Append a wrapper for this pipeline that accepts old buffer_ts
     // and upgrades them. It will use the same name, so it will
     // require C++ linkage. We don't need it when jitting.
@@ -413,7 +890,11 @@ Module lower(const vector<Function> &output_funcs, const string &pipeline_name,
     }
 
     // Also append any wrappers for extern stages that expect the old buffer_t
-    wrap_legacy_extern_stages(result_module);
+    if (any_extern_stages) {
+        wrap_legacy_extern_stages(result_module);
+    }
+
+    profiler.finish(t);
 
     return result_module;
 }
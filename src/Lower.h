@@ -25,10 +25,13 @@ class IRMutator2;
  * contain submodules for computation offloaded to another execution
  * engine or API as well as buffers that are used in the passed in
  * Stmt. Multiple LoweredFuncs are added to support legacy buffer_t
- * calling convention. */
+ * calling convention. The requirements are the boolean conditions
+ * added via Pipeline::add_requirement; they are checked at runtime
+ * and exploited at compile time. */
 EXPORT Module lower(const std::vector<Function> &output_funcs, const std::string &pipeline_name, const Target &t,
                     const std::vector<Argument> &args, const Internal::LoweredFunc::LinkageType linkage_type,
-                    const std::vector<IRMutator2 *> &custom_passes = std::vector<IRMutator2 *>());
+                    const std::vector<IRMutator2 *> &custom_passes = std::vector<IRMutator2 *>(),
+                    const std::vector<Expr> &requirements = std::vector<Expr>());
 
 /** Given a halide function with a schedule, create a statement that
  * evaluates it. Automatically pulls in all the functions f depends
@@ -0,0 +1,394 @@
+#include "LowerAtomics.h"
+#include "Function.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Does an expression load from the given buffer anywhere?
+class LoadsFrom : public IRVisitor {
+public:
+    const string &buf;
+    bool result = false;
+
+    LoadsFrom(const string &buf) : buf(buf) {}
+
+private:
+    using IRVisitor::visit;
+
+    void visit(const Load *op) override {
+        if (op->name == buf) {
+            result = true;
+        }
+        IRVisitor::visit(op);
+    }
+};
+
+bool loads_from(const Expr &e, const string &buf) {
+    LoadsFrom l(buf);
+    e.accept(&l);
+    return l.result;
+}
+
+// An update stage whose scatter stores this pass rewrites: either a
+// plain atomic() stage, or a scatter_buffered() stage with a
+// power-of-two number of write-combining slots.
+struct AtomicStage {
+    string prefix;  // Loop name prefix, e.g. "f.s1."
+    string func;    // The function being updated, e.g. "f"
+    int buffer_slots;  // 0 for plain atomics
+};
+
+class LowerAtomics : public IRMutator2 {
+public:
+    LowerAtomics(const vector<AtomicStage> &stages) : stages(stages) {}
+
+private:
+    using IRMutator2::visit;
+
+    const vector<AtomicStage> &stages;
+
+    vector<string> loop_stack;
+
+    // A scatter-buffered store rewritten in the current stage; the
+    // enclosing parallel loop must allocate, initialize, and flush
+    // its combining buffers.
+    struct BufferedStore {
+        string name;      // The buffer stored to ("f", or "f.0" etc.)
+        Type type;
+        string flush_op;  // The rmw op that merges a slot into the buffer
+        Parameter param;
+    };
+
+    // Keyed by stage prefix.
+    map<string, vector<BufferedStore>> pending_buffers;
+
+    const AtomicStage *stage_of_loop(const string &loop_name) const {
+        for (const AtomicStage &s : stages) {
+            if (starts_with(loop_name, s.prefix)) {
+                return &s;
+            }
+        }
+        return nullptr;
+    }
+
+    // The innermost atomic stage whose loops enclose the current
+    // statement, or nullptr.
+    const AtomicStage *enclosing_atomic_stage() const {
+        for (size_t i = loop_stack.size(); i > 0; i--) {
+            if (const AtomicStage *s = stage_of_loop(loop_stack[i - 1])) {
+                return s;
+            }
+        }
+        return nullptr;
+    }
+
+    Stmt visit(const For *op) override {
+        loop_stack.push_back(op->name);
+        Stmt s = IRMutator2::visit(op);
+        loop_stack.pop_back();
+
+        const AtomicStage *stage = stage_of_loop(op->name);
+        if (!stage || stage->buffer_slots == 0) {
+            return s;
+        }
+        auto iter = pending_buffers.find(stage->prefix);
+        if (iter == pending_buffers.end()) {
+            return s;
+        }
+        // The combining buffers live at the innermost parallel loop
+        // of the stage, so each task gets a private copy. If the
+        // stage was left serial, they wrap the outermost stage loop.
+        bool outermost = true;
+        for (const string &l : loop_stack) {
+            if (starts_with(l, stage->prefix)) {
+                outermost = false;
+            }
+        }
+        if (op->for_type != ForType::Parallel && !outermost) {
+            return s;
+        }
+        user_assert(op->for_type == ForType::Serial ||
+                    op->for_type == ForType::Parallel)
+            << "In the scatter_buffered() update definition of "
+            << stage->func << ": scatter buffering requires a CPU"
+            << " loop; use atomic() on the GPU instead.\n";
+        const For *f = s.as<For>();
+        internal_assert(f);
+        Stmt body = wrap_with_buffers(f->body, iter->second, stage->buffer_slots);
+        pending_buffers.erase(iter);
+        return For::make(f->name, f->min, f->extent, f->for_type, f->device_api, body);
+    }
+
+    // Allocate the combining buffers around a loop body, poison the
+    // keys before it, and flush surviving slots after it.
+    Stmt wrap_with_buffers(Stmt body, const vector<BufferedStore> &stores, int slots) {
+        for (const BufferedStore &bs : stores) {
+            string keys = bs.name + ".scatter_keys";
+            string vals = bs.name + ".scatter_vals";
+
+            string init_name = bs.name + ".scatter_init";
+            Expr init_var = Variable::make(Int(32), init_name);
+            Stmt init = Store::make(keys, -1, init_var, Parameter(), const_true());
+            init = For::make(init_name, 0, slots, ForType::Serial, DeviceAPI::None, init);
+
+            string flush_name = bs.name + ".scatter_flush";
+            Expr flush_var = Variable::make(Int(32), flush_name);
+            string key_name = unique_name('t');
+            Expr key = Variable::make(Int(32), key_name);
+            Expr val = Load::make(bs.type, vals, flush_var, Buffer<>(), Parameter(), const_true());
+            // The flush merges each surviving slot into the buffer
+            // with a single atomic read-modify-write, so concurrent
+            // tasks may flush overlapping keys safely.
+            Expr target = Load::make(bs.type, bs.name, key, Buffer<>(), bs.param, const_true());
+            Expr rmw = Call::make(bs.type, Call::atomic_rmw,
+                                  {StringImm::make(bs.flush_op), target, val},
+                                  Call::Intrinsic);
+            Stmt flush = IfThenElse::make(key != -1, Evaluate::make(rmw));
+            flush = LetStmt::make(key_name, Load::make(Int(32), keys, flush_var, Buffer<>(), Parameter(), const_true()), flush);
+            flush = For::make(flush_name, 0, slots, ForType::Serial, DeviceAPI::None, flush);
+
+            body = Block::make({init, body, flush,
+                                Free::make(vals), Free::make(keys)});
+            body = Allocate::make(vals, bs.type, {slots}, const_true(), body);
+            body = Allocate::make(keys, Int(32), {slots}, const_true(), body);
+        }
+        return body;
+    }
+
+    Stmt visit(const Store *op) override {
+        const AtomicStage *stage = enclosing_atomic_stage();
+        if (!stage) {
+            return IRMutator2::visit(op);
+        }
+        // Stores to other buffers from inside an atomic stage (e.g. a
+        // sibling function computed at one of its loops) are not ours
+        // to touch. The store itself is to "f", or "f.0" etc. for
+        // tuple-valued funcs.
+        const string &func = stage->func;
+        if (op->name != func && !starts_with(op->name, func + ".")) {
+            return IRMutator2::visit(op);
+        }
+        const char *directive = stage->buffer_slots ? "scatter_buffered" : "atomic";
+
+        Type t = op->value.type();
+        user_assert(t.is_scalar())
+            << "An " << directive << "() update of " << func << " was vectorized. "
+            << "Such updates may be parallelized but not vectorized.\n";
+        user_assert(t.is_int() || t.is_uint())
+            << "In the " << directive << "() update definition of " << func
+            << ": atomic updates of " << t << " values are not supported. "
+            << "Hardware atomics require integer types; use rfactor or "
+            << "allow_race_conditions instead.\n";
+        user_assert(is_one(op->predicate))
+            << "In the " << directive << "() update definition of " << func
+            << ": cannot make a predicated store atomic.\n";
+
+        // The value stored must be a supported read-modify-write of
+        // the value already at this address.
+        auto is_self_load = [&](const Expr &e) {
+            const Load *l = e.as<Load>();
+            return l && l->name == op->name &&
+                   equal(l->index, op->index) &&
+                   is_one(l->predicate);
+        };
+
+        string rmw_op;
+        Expr old_value, operand;
+        if (const Add *add = op->value.as<Add>()) {
+            rmw_op = "add";
+            if (is_self_load(add->a)) {
+                old_value = add->a;
+                operand = add->b;
+            } else if (is_self_load(add->b)) {
+                old_value = add->b;
+                operand = add->a;
+            }
+        } else if (const Sub *sub = op->value.as<Sub>()) {
+            // Only x - e is a sub; e - x is not an atomic op.
+            if (is_self_load(sub->a)) {
+                rmw_op = "sub";
+                old_value = sub->a;
+                operand = sub->b;
+            }
+        } else if (const Min *min = op->value.as<Min>()) {
+            rmw_op = "min";
+            if (is_self_load(min->a)) {
+                old_value = min->a;
+                operand = min->b;
+            } else if (is_self_load(min->b)) {
+                old_value = min->b;
+                operand = min->a;
+            }
+        } else if (const Max *max = op->value.as<Max>()) {
+            rmw_op = "max";
+            if (is_self_load(max->a)) {
+                old_value = max->a;
+                operand = max->b;
+            } else if (is_self_load(max->b)) {
+                old_value = max->b;
+                operand = max->a;
+            }
+        } else if (const Call *call = op->value.as<Call>()) {
+            if (call->is_intrinsic(Call::bitwise_and) ||
+                call->is_intrinsic(Call::bitwise_or) ||
+                call->is_intrinsic(Call::bitwise_xor)) {
+                if (is_self_load(call->args[0])) {
+                    old_value = call->args[0];
+                    operand = call->args[1];
+                } else if (is_self_load(call->args[1])) {
+                    old_value = call->args[1];
+                    operand = call->args[0];
+                }
+                if (old_value.defined()) {
+                    if (call->is_intrinsic(Call::bitwise_and)) {
+                        rmw_op = "and";
+                    } else if (call->is_intrinsic(Call::bitwise_or)) {
+                        rmw_op = "or";
+                    } else {
+                        rmw_op = "xor";
+                    }
+                }
+            }
+        }
+
+        user_assert(old_value.defined() && !rmw_op.empty())
+            << "In the " << directive << "() update definition of " << func
+            << ": the value stored is not a supported atomic "
+            << "read-modify-write of the value already present. "
+            << "Supported updates are +=, -=, min, max, and bitwise "
+            << "and/or/xor with the stored value.\n";
+        user_assert(!loads_from(operand, op->name))
+            << "In the " << directive << "() update definition of " << func
+            << ": the update reads other sites of " << func
+            << ", so it cannot be performed atomically.\n";
+
+        if (stage->buffer_slots > 0) {
+            return buffered_store(op, stage, rmw_op, operand);
+        }
+
+        // The backends recognize this intrinsic and emit an atomic
+        // read-modify-write. The load argument carries the buffer and
+        // address; it is not actually performed separately.
+        Expr rmw = Call::make(t, Call::atomic_rmw,
+                              {StringImm::make(rmw_op), old_value, operand},
+                              Call::Intrinsic);
+        return Evaluate::make(rmw);
+    }
+
+    // Rewrite a recognized scatter update to accumulate into a
+    // direct-mapped per-task combining buffer: keys[slot] holds the
+    // destination index resident in the slot (-1 if empty), and
+    // vals[slot] the partial value accumulated for it. A collision
+    // flushes the old resident with one atomic rmw before the slot is
+    // reused.
+    Stmt buffered_store(const Store *op, const AtomicStage *stage,
+                        const string &rmw_op, Expr operand) {
+        Type t = op->value.type();
+        string keys = op->name + ".scatter_keys";
+        string vals = op->name + ".scatter_vals";
+        int slots = stage->buffer_slots;
+
+        // -= accumulates a sum in the buffer and subtracts it once on
+        // flush; everything else combines with the op itself.
+        string flush_op = rmw_op;
+        string combine_op = (rmw_op == "sub") ? "add" : rmw_op;
+
+        Expr identity;
+        if (combine_op == "min") {
+            identity = t.max();
+        } else if (combine_op == "max") {
+            identity = t.min();
+        } else if (combine_op == "and") {
+            identity = t.is_int() ? make_const(t, -1) : t.max();
+        } else {
+            identity = make_zero(t);
+        }
+
+        string idx_name = unique_name('t');
+        Expr idx = Variable::make(Int(32), idx_name);
+        string slot_name = unique_name('t');
+        Expr slot = Variable::make(Int(32), slot_name);
+        string key_name = unique_name('t');
+        Expr old_key = Variable::make(Int(32), key_name);
+
+        Expr resident = Load::make(t, vals, slot, Buffer<>(), Parameter(), const_true());
+        Expr combined;
+        if (combine_op == "add") {
+            combined = resident + operand;
+        } else if (combine_op == "min") {
+            combined = min(resident, operand);
+        } else if (combine_op == "max") {
+            combined = max(resident, operand);
+        } else if (combine_op == "and") {
+            combined = resident & operand;
+        } else if (combine_op == "or") {
+            combined = resident | operand;
+        } else {
+            combined = resident ^ operand;
+        }
+        Stmt accumulate = Store::make(vals, combined, slot, Parameter(), const_true());
+
+        // Flush the old resident of a colliding slot...
+        Expr flush_val = Load::make(t, vals, slot, Buffer<>(), Parameter(), const_true());
+        Expr target = Load::make(t, op->name, old_key, Buffer<>(), op->param, const_true());
+        Expr rmw = Call::make(t, Call::atomic_rmw,
+                              {StringImm::make(flush_op), target, flush_val},
+                              Call::Intrinsic);
+        Stmt flush = IfThenElse::make(old_key != -1, Evaluate::make(rmw));
+        // ...and claim it for the new destination.
+        Stmt reset = Block::make(Store::make(keys, idx, slot, Parameter(), const_true()),
+                                 Store::make(vals, identity, slot, Parameter(), const_true()));
+        Stmt evict = Block::make(flush, reset);
+
+        Stmt s = Block::make(IfThenElse::make(old_key != idx, evict), accumulate);
+        s = LetStmt::make(key_name, Load::make(Int(32), keys, slot, Buffer<>(), Parameter(), const_true()), s);
+        s = LetStmt::make(slot_name, idx & (slots - 1), s);
+        s = LetStmt::make(idx_name, op->index, s);
+
+        vector<BufferedStore> &pending = pending_buffers[stage->prefix];
+        bool known = false;
+        for (const BufferedStore &bs : pending) {
+            known |= (bs.name == op->name);
+        }
+        if (!known) {
+            pending.push_back({op->name, t, flush_op, op->param});
+        }
+        return s;
+    }
+};
+
+}  // namespace
+
+Stmt lower_atomics(Stmt s, const map<string, Function> &env) {
+    vector<AtomicStage> stages;
+    for (const auto &iter : env) {
+        const Function &f = iter.second;
+        const vector<Definition> &updates = f.updates();
+        for (size_t i = 0; i < updates.size(); i++) {
+            const StageSchedule &sched = updates[i].schedule();
+            if (sched.atomic() || sched.scatter_buffer_slots() > 0) {
+                stages.push_back({f.name() + ".s" + std::to_string(i + 1) + ".",
+                                  f.name(),
+                                  sched.scatter_buffer_slots()});
+            }
+        }
+    }
+    if (stages.empty()) {
+        return s;
+    }
+    return LowerAtomics(stages).mutate(s);
+}
+
+}
+}
@@ -0,0 +1,28 @@
+#ifndef HALIDE_LOWER_ATOMICS_H
+#define HALIDE_LOWER_ATOMICS_H
+
+#include <map>
+
+#include "IR.h"
+
+/** \file
+ * Defines the lowering pass that turns the scatter stores of update
+ * definitions marked with Stage::atomic into atomic read-modify-write
+ * intrinsics.
+ */
+
+namespace Halide {
+namespace Internal {
+
+/** Rewrite stores belonging to atomic update definitions into
+ * Call::atomic_rmw intrinsics, which the backends emit as hardware
+ * atomic read-modify-write instructions. Must run after storage
+ * flattening, when each store is a flat store paired with a load of
+ * the same address. It is an error for an atomic update not to be of
+ * a supported read-modify-write form. */
+Stmt lower_atomics(Stmt s, const std::map<std::string, Function> &env);
+
+}
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include "Var.h"
 
 #include <map>
+#include <sstream>
 
 namespace Halide {
 namespace Internal {
@@ -166,27 +167,50 @@ class KeyInfo {
         return size_t(1) << i;
     }
 
-// TODO: Using the full names in the key results in a (hopefully incredibly
-// slight) performance difference based on how one names filters and
-// functions. It is arguably a little easier to debug if something
-// goes wrong as one doesn't need to destructure the cache key by hand
-// in the debugger. Also, if a pointer is used, a counter must also be
-// put in the cache key to avoid aliasing on reuse of the address in
-// JIT situations where code is regenerated into the same region of
-// memory.
-//
-// There is a plan to change the hash function used in the cache and
-// after that happens, we'll measure performance again and maybe decide
-// to choose one path or the other (see Git history for the implementation.
-// It was deleted as part of the address_of intrinsic cleanup).
+    // A content hash of the names and the definition of the function
+    // being memoized. Unlike a pointer to an interned name string (the
+    // previous scheme), the hash is stable across processes, so keys
+    // built from it can safely be used by persistent cache backends.
+    // It also doesn't need the per-instance counter the pointer scheme
+    // required to guard against address reuse in JIT situations: two
+    // pipelines that hash alike compute the same values.
+    uint64_t content_hash;
+
+    static uint64_t hash_string(uint64_t h, const std::string &str) {
+        // FNV-1a, 64-bit.
+        for (char c : str) {
+            h ^= (uint8_t)c;
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    uint64_t compute_content_hash(const Function &function) {
+        std::ostringstream definition;
+        definition << std::to_string(top_level_name.size()) << ":" << top_level_name
+                   << std::to_string(function_name.size()) << ":" << function_name;
+        for (const Expr &e : function.values()) {
+            definition << e;
+        }
+        for (const Definition &def : function.updates()) {
+            for (const Expr &a : def.args()) {
+                definition << a;
+            }
+            for (const Expr &v : def.values()) {
+                definition << v;
+            }
+        }
+        return hash_string(0xcbf29ce484222325ULL, definition.str());
+    }
 
 public:
   KeyInfo(const Function &function, const std::string &name)
         : top_level_name(name), function_name(function.name())
     {
+        content_hash = compute_content_hash(function);
         dependencies.visit_function(function);
         size_t size_so_far = 0;
-        size_so_far += Handle().bytes() + 4;
+        size_so_far += sizeof(uint64_t);
 
         size_t needed_alignment = parameters_alignment();
         if (needed_alignment > 1) {
@@ -210,28 +234,14 @@ public:
         std::vector<Stmt> writes;
         Expr index = Expr(0);
 
-        // Store a pointer to a string identifying the filter and
-        // function. Assume this will be unique due to CSE. This can
-        // break with loading and unloading of code, though the name
-        // mechanism can also break in those conditions. For JIT, a
-        // counter is needed as the address may be reused. This isn't
-        // a problem when using full names as the function names
-        // already are uniquefied by a counter.
-        writes.push_back(Store::make(key_name,
-                                     StringImm::make(std::to_string(top_level_name.size()) + ":" + top_level_name +
-                                                     std::to_string(function_name.size()) + ":" + function_name),
-                                     (index / Handle().bytes()), Parameter(), const_true()));
-        size_t alignment = Handle().bytes();
-        index += Handle().bytes();
-
-        // Halide compilation is not threadsafe anyway...
-        static std::atomic<int> memoize_instance {0};
+        // Store the content hash identifying the filter, function,
+        // and definition. The hash is stable across processes, which
+        // persistent cache backends rely on.
         writes.push_back(Store::make(key_name,
-                                     memoize_instance++,
-                                     (index / Int(32).bytes()),
-                                     Parameter(), const_true()));
-        alignment += 4;
-        index += 4;
+                                     make_const(UInt(64), content_hash),
+                                     (index / UInt(64).bytes()), Parameter(), const_true()));
+        size_t alignment = UInt(64).bytes();
+        index += UInt(64).bytes();
 
         size_t needed_alignment = parameters_alignment();
         if (needed_alignment > 1) {
@@ -383,7 +393,7 @@ private:
                 Allocate::make(cache_key_name, UInt(8), {key_info.key_size()},
                                const_true(), generate_key);
 
-            stmt = Realize::make(op->name, op->types, op->bounds, op->condition, cache_key_alloc);
+            stmt = Realize::make(op->name, op->types, op->bounds, op->condition, cache_key_alloc, op->memory_type);
         } else {
             IRMutator::visit(op);
         }
@@ -509,7 +519,7 @@ private:
                 body = Allocate::make(allocation->name, allocation->type, allocation->extents, allocation->condition, body,
                                       Call::make(Handle(), Call::buffer_get_host,
                                                  { Variable::make(type_of<struct halide_buffer_t *>(), allocation->name + ".buffer") }, Call::Extern),
-                                      "halide_memoization_cache_release");
+                                      "halide_memoization_cache_release", allocation->memory_type);
             }
 
             pending_memoized_allocations.erase(innermost_realization_name);
@@ -1,13 +1,19 @@
 #include "Module.h"
 
 #include <array>
+#include <cstdio>
 #include <fstream>
 #include <future>
+#include <iomanip>
+#include <sstream>
 
 #include "CodeGen_C.h"
 #include "CodeGen_Internal.h"
 #include "Debug.h"
 #include "HexagonOffload.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IRVisitor.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Output.h"
 #include "LLVM_Runtime_Linker.h"
@@ -91,9 +97,29 @@ Outputs add_suffixes(const Outputs &in, const std::string &suffix) {
     if (!in.stmt_name.empty()) out.stmt_name = add_suffix(in.stmt_name, suffix);
     if (!in.stmt_html_name.empty()) out.stmt_html_name = add_suffix(in.stmt_html_name, suffix);
     if (!in.schedule_name.empty()) out.schedule_name = add_suffix(in.schedule_name, suffix);
+    if (!in.analysis_name.empty()) out.analysis_name = add_suffix(in.analysis_name, suffix);
+    // The cache directory is shared, not per-target: entries are
+    // already keyed on the target.
+    out.object_cache_dir = in.object_cache_dir;
     return out;
 }
 
+uint64_t fnv1a_hash_64(const void *data, size_t size, uint64_t h = 0xcbf29ce484222325ULL) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+bool copy_file_contents(const std::string &src, const std::string &dst) {
+    std::ifstream in(src, std::ios::binary);
+    std::ofstream out(dst, std::ios::binary);
+    out << in.rdbuf();
+    out.flush();
+    return in.good() && out.good();
+}
+
 uint64_t target_feature_mask(const Target &target) {
     static_assert(sizeof(uint64_t)*8 >= Target::FeatureEnd, "Features will not fit in uint64_t");
     uint64_t feature_mask = 0;
@@ -105,6 +131,205 @@ uint64_t target_feature_mask(const Target &target) {
     return feature_mask;
 }
 
+// Summarize the lowered IR of one function for the static analysis
+// artifact: operation counts and vector widths attributed to the
+// Func whose produce node encloses them, parallel loops with their
+// extents, and allocations with their sizes.
+class AnalyzeLoweredFunc : public IRVisitor {
+    using IRVisitor::visit;
+
+    std::vector<std::string> producer_stack;
+
+public:
+    struct FuncStats {
+        int64_t arith{0}, loads{0}, stores{0}, calls{0}, vector_ops{0};
+        int max_vector_lanes{1};
+    };
+
+    struct LoopInfo {
+        std::string name;
+        std::string extent;
+    };
+
+    struct AllocationInfo {
+        std::string name;
+        Type type;
+        // Zero if the size isn't a compile-time constant.
+        int64_t size_bytes;
+        std::string extents;
+    };
+
+    // Keyed on Func name; code outside any produce node (the
+    // skeleton loops, bounds checks, etc.) lands under "".
+    std::map<std::string, FuncStats> funcs;
+    std::vector<LoopInfo> parallel_loops;
+    std::vector<AllocationInfo> allocations;
+
+private:
+    FuncStats &current() {
+        static std::string top_level = "";
+        return funcs[producer_stack.empty() ? top_level : producer_stack.back()];
+    }
+
+    void count_op(Type t) {
+        FuncStats &f = current();
+        f.arith++;
+        if (t.is_vector()) {
+            f.vector_ops++;
+            f.max_vector_lanes = std::max(f.max_vector_lanes, t.lanes());
+        }
+    }
+
+    template<typename T>
+    void count_and_visit(const T *op) {
+        count_op(op->type);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Add *op) {count_and_visit(op);}
+    void visit(const Sub *op) {count_and_visit(op);}
+    void visit(const Mul *op) {count_and_visit(op);}
+    void visit(const Div *op) {count_and_visit(op);}
+    void visit(const Mod *op) {count_and_visit(op);}
+    void visit(const Min *op) {count_and_visit(op);}
+    void visit(const Max *op) {count_and_visit(op);}
+    void visit(const EQ *op) {count_and_visit(op);}
+    void visit(const NE *op) {count_and_visit(op);}
+    void visit(const LT *op) {count_and_visit(op);}
+    void visit(const LE *op) {count_and_visit(op);}
+    void visit(const GT *op) {count_and_visit(op);}
+    void visit(const GE *op) {count_and_visit(op);}
+    void visit(const And *op) {count_and_visit(op);}
+    void visit(const Or *op) {count_and_visit(op);}
+    void visit(const Not *op) {count_and_visit(op);}
+    void visit(const Select *op) {count_and_visit(op);}
+    void visit(const Cast *op) {count_and_visit(op);}
+
+    void visit(const Load *op) {
+        FuncStats &f = current();
+        f.loads++;
+        if (op->type.is_vector()) {
+            f.vector_ops++;
+            f.max_vector_lanes = std::max(f.max_vector_lanes, op->type.lanes());
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Store *op) {
+        FuncStats &f = current();
+        f.stores++;
+        if (op->value.type().is_vector()) {
+            f.vector_ops++;
+            f.max_vector_lanes = std::max(f.max_vector_lanes, op->value.type().lanes());
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Call *op) {
+        current().calls++;
+        IRVisitor::visit(op);
+    }
+
+    void visit(const ProducerConsumer *op) {
+        if (op->is_producer) {
+            producer_stack.push_back(op->name);
+            op->body.accept(this);
+            producer_stack.pop_back();
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const For *op) {
+        if (op->for_type == ForType::Parallel) {
+            std::ostringstream extent;
+            extent << op->extent;
+            parallel_loops.push_back({op->name, extent.str()});
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Allocate *op) {
+        AllocationInfo info;
+        info.name = op->name;
+        info.type = op->type;
+        info.size_bytes = (int64_t)op->constant_allocation_size() * op->type.bytes();
+        std::ostringstream extents;
+        for (size_t i = 0; i < op->extents.size(); i++) {
+            extents << (i > 0 ? " * " : "") << op->extents[i];
+        }
+        info.extents = extents.str();
+        allocations.push_back(info);
+        IRVisitor::visit(op);
+    }
+};
+
+std::string json_escape(const std::string &s) {
+    std::string result;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result;
+}
+
+// Write the machine-readable analysis artifact for a module. The
+// counts are static (per call of the enclosing loop body, not per
+// pixel), which is what a perf CI needs to diff schedule changes
+// structurally.
+void emit_analysis_artifact(std::ostream &out, const Module &m) {
+    out << "{\n";
+    out << "  \"name\": \"" << json_escape(m.name()) << "\",\n";
+    out << "  \"target\": \"" << m.target().to_string() << "\",\n";
+    out << "  \"functions\": [\n";
+    const auto &fns = m.functions();
+    for (size_t i = 0; i < fns.size(); i++) {
+        AnalyzeLoweredFunc analysis;
+        fns[i].body.accept(&analysis);
+
+        out << "    {\n";
+        out << "      \"name\": \"" << json_escape(fns[i].name) << "\",\n";
+        out << "      \"funcs\": [\n";
+        size_t j = 0;
+        for (const auto &p : analysis.funcs) {
+            const AnalyzeLoweredFunc::FuncStats &f = p.second;
+            out << "        {\"name\": \"" << json_escape(p.first) << "\", "
+                << "\"arith\": " << f.arith << ", "
+                << "\"loads\": " << f.loads << ", "
+                << "\"stores\": " << f.stores << ", "
+                << "\"calls\": " << f.calls << ", "
+                << "\"vector_ops\": " << f.vector_ops << ", "
+                << "\"max_vector_lanes\": " << f.max_vector_lanes << "}"
+                << (++j < analysis.funcs.size() ? "," : "") << "\n";
+        }
+        out << "      ],\n";
+        out << "      \"parallel_loops\": [\n";
+        for (size_t k = 0; k < analysis.parallel_loops.size(); k++) {
+            out << "        {\"name\": \"" << json_escape(analysis.parallel_loops[k].name) << "\", "
+                << "\"extent\": \"" << json_escape(analysis.parallel_loops[k].extent) << "\"}"
+                << (k + 1 < analysis.parallel_loops.size() ? "," : "") << "\n";
+        }
+        out << "      ],\n";
+        out << "      \"allocations\": [\n";
+        for (size_t k = 0; k < analysis.allocations.size(); k++) {
+            const AnalyzeLoweredFunc::AllocationInfo &a = analysis.allocations[k];
+            std::ostringstream type_str;
+            type_str << a.type;
+            out << "        {\"name\": \"" << json_escape(a.name) << "\", "
+                << "\"type\": \"" << type_str.str() << "\", "
+                << "\"size_bytes\": " << a.size_bytes << ", "
+                << "\"extents\": \"" << json_escape(a.extents) << "\"}"
+                << (k + 1 < analysis.allocations.size() ? "," : "") << "\n";
+        }
+        out << "      ]\n";
+        out << "    }" << (i + 1 < fns.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
 }  // namespace
 
 struct ModuleContents {
@@ -219,9 +444,63 @@ void Module::append(const ExternalCode &external_code) {
     contents->external_code.push_back(external_code);
 }
 
+namespace {
+
+// Rewrite extern calls to functions that were renamed or
+// deduplicated while linking modules.
+class RenameExternCalls : public Internal::IRMutator2 {
+    using IRMutator2::visit;
+
+    const std::map<std::string, std::string> &renames;
+
+    Expr visit(const Call *op) override {
+        auto it = renames.find(op->name);
+        if (it != renames.end() &&
+            (op->call_type == Call::Extern ||
+             op->call_type == Call::ExternCPlusPlus)) {
+            std::vector<Expr> new_args;
+            for (const Expr &arg : op->args) {
+                new_args.push_back(mutate(arg));
+            }
+            return Call::make(op->type, it->second, new_args, op->call_type,
+                              op->func, op->value_index, op->image, op->param);
+        }
+        return IRMutator2::visit(op);
+    }
+
+public:
+    RenameExternCalls(const std::map<std::string, std::string> &renames) : renames(renames) {}
+};
+
+// Whether two lowered functions are interchangeable: same argument
+// list, same linkage and mangling, and identical bodies.
+bool functions_are_identical(const Internal::LoweredFunc &a, const Internal::LoweredFunc &b) {
+    if (a.linkage != b.linkage ||
+        a.name_mangling != b.name_mangling ||
+        a.args.size() != b.args.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.args.size(); i++) {
+        if (a.args[i].name != b.args[i].name ||
+            a.args[i].kind != b.args[i].kind ||
+            a.args[i].type != b.args[i].type ||
+            a.args[i].dimensions != b.args[i].dimensions ||
+            a.args[i].alignment.modulus != b.args[i].alignment.modulus ||
+            a.args[i].alignment.remainder != b.args[i].alignment.remainder) {
+            return false;
+        }
+    }
+    return equal(a.body, b.body);
+}
+
+} // namespace
+
 Module link_modules(const std::string &name, const std::vector<Module> &modules) {
     Module output(name, modules.front().target());
 
+    std::map<std::string, size_t> fn_index;
+    std::map<std::string, Buffer<>> buffer_by_name;
+
     for (size_t i = 0; i < modules.size(); i++) {
         const Module &input = modules[i];
 
@@ -232,14 +511,116 @@ Module link_modules(const std::string &name, const std::vector<Module> &modules)
                        << input.name() << ", " << input.target().to_string() << ")\n";
         }
 
-        // TODO(dsharlet): Check for naming collisions, maybe rename
-        // internal linkage declarations in the case of collision.
         for (const auto &b : input.buffers()) {
-            output.append(b);
+            auto it = buffer_by_name.find(b.name());
+            if (it == buffer_by_name.end()) {
+                buffer_by_name.emplace(b.name(), b);
+                output.append(b);
+            } else if (it->second.data() != b.data()) {
+                user_error << "Duplicate buffer name " << b.name()
+                           << " while linking module " << input.name()
+                           << " into " << output.name() << "\n";
+            }
         }
-        for (const auto &f : input.functions()) {
+
+        // Functions from this module whose names change when linked,
+        // either to resolve a collision with an internal helper from
+        // another module, or because they were deduplicated against
+        // an identical function already linked. Kept in discovery
+        // order so that functions appended earlier can be fixed up
+        // with just the renames they haven't already had applied.
+        std::vector<std::pair<std::string, std::string>> renames;
+        // For each function appended from this module, how many of
+        // the renames had been applied to its body when it was
+        // appended.
+        std::vector<size_t> renames_applied;
+        size_t module_start = output.functions().size();
+        for (const auto &input_fn : input.functions()) {
+            Internal::LoweredFunc f = input_fn;
+            if (!renames.empty()) {
+                // Apply the renames discovered so far before comparing
+                // bodies: a function that calls a helper we renamed is
+                // not interchangeable with a function from another
+                // module that calls its own helper of the original
+                // name.
+                std::map<std::string, std::string> so_far(renames.begin(), renames.end());
+                f.body = RenameExternCalls(so_far).mutate(f.body);
+            }
+            auto it = fn_index.find(f.name);
+            if (it != fn_index.end()) {
+                const Internal::LoweredFunc &existing = output.functions()[it->second];
+                if (functions_are_identical(existing, f)) {
+                    // The same helper was linked into several
+                    // pipelines; one copy suffices.
+                    continue;
+                } else if (f.linkage == Internal::LoweredFunc::Internal) {
+                    // A name collision between module-local helpers
+                    // with different bodies. Rename ours.
+                    std::string new_name = f.name;
+                    do {
+                        new_name += "_" + std::to_string(i);
+                    } while (fn_index.count(new_name));
+                    renames.push_back({f.name, new_name});
+                    Internal::LoweredFunc renamed = f;
+                    renamed.name = new_name;
+                    fn_index[new_name] = output.functions().size();
+                    // The body predates its own rename, so a
+                    // recursive self-call still needs the fixup pass
+                    // below.
+                    renames_applied.push_back(renames.size() - 1);
+                    output.append(renamed);
+                    continue;
+                } else {
+                    user_error << "Duplicate definitions of external function " << f.name
+                               << " while linking module " << input.name()
+                               << " into " << output.name() << "\n";
+                }
+            }
+            if (f.linkage == Internal::LoweredFunc::Internal) {
+                // Internal helpers are not part of any interface, so
+                // they can also be deduplicated against an identical
+                // function with a different name, which shrinks the
+                // linked module when the input pipelines share code.
+                bool deduped = false;
+                for (const auto &p : fn_index) {
+                    const Internal::LoweredFunc &existing = output.functions()[p.second];
+                    if (existing.name != f.name &&
+                        existing.linkage == Internal::LoweredFunc::Internal &&
+                        functions_are_identical(existing, f)) {
+                        renames.push_back({f.name, existing.name});
+                        deduped = true;
+                        break;
+                    }
+                }
+                if (deduped) {
+                    continue;
+                }
+            }
+            fn_index[f.name] = output.functions().size();
+            renames_applied.push_back(renames.size());
             output.append(f);
         }
+
+        // Apply the renames each appended function hasn't seen yet
+        // (those discovered after it was appended).
+        for (size_t j = module_start; j < output.functions().size(); j++) {
+            size_t applied = renames_applied[j - module_start];
+            if (applied == renames.size()) {
+                continue;
+            }
+            std::map<std::string, std::string> pending(renames.begin() + applied,
+                                                       renames.end());
+            RenameExternCalls rename_calls(pending);
+            Internal::LoweredFunc &f = output.functions()[j];
+            f.body = rename_calls.mutate(f.body);
+        }
+
+        for (const auto &e : input.external_code()) {
+            output.append(e);
+        }
+        for (const auto &s : input.submodules()) {
+            output.append(s);
+        }
     }
 
     return output;
@@ -339,10 +720,53 @@ void Module::compile(const Outputs &output_files) const {
         llvm::LLVMContext context;
         std::unique_ptr<llvm::Module> llvm_module(compile_module_to_llvm_module(*this, context));
 
+        // If an object cache directory was given, address it with a
+        // hash of the llvm bitcode plus the target string. Unchanged
+        // pipelines then skip instruction selection entirely.
+        std::string cached_object_name;
+        if (!output_files.object_cache_dir.empty() &&
+            (!output_files.object_name.empty() || !output_files.static_library_name.empty())) {
+            llvm::SmallVector<char, 4096> bitcode;
+            llvm::raw_svector_ostream bitcode_stream(bitcode);
+            compile_llvm_module_to_llvm_bitcode(*llvm_module, bitcode_stream);
+            uint64_t hash = fnv1a_hash_64(bitcode.data(), bitcode.size());
+            std::string target_string = target().to_string();
+            hash = fnv1a_hash_64(target_string.c_str(), target_string.size(), hash);
+            const char *ext = (target().os == Target::Windows && !target().has_feature(Target::MinGW)) ? ".obj" : ".o";
+            std::ostringstream cached_name;
+            cached_name << output_files.object_cache_dir << "/"
+                        << std::hex << std::setw(16) << std::setfill('0') << hash << ext;
+            cached_object_name = cached_name.str();
+        }
+
+        auto emit_object = [&](const std::string &object_name) {
+            if (!cached_object_name.empty() && file_exists(cached_object_name)) {
+                debug(1) << "Module.compile(): object cache hit " << cached_object_name << "\n";
+                if (copy_file_contents(cached_object_name, object_name)) {
+                    return;
+                }
+                // If the copy failed, fall through and recompile.
+            }
+            auto out = make_raw_fd_ostream(object_name);
+            compile_llvm_module_to_object(*llvm_module, *out);
+            out->flush();
+            if (!cached_object_name.empty()) {
+                // Populate the cache via rename, so that concurrent
+                // builds sharing the directory never observe a
+                // partially-written entry.
+                std::string temp_name = cached_object_name + ".tmp";
+                if (copy_file_contents(object_name, temp_name) &&
+                    std::rename(temp_name.c_str(), cached_object_name.c_str()) == 0) {
+                    debug(1) << "Module.compile(): object cache store " << cached_object_name << "\n";
+                } else {
+                    file_unlink(temp_name);
+                }
+            }
+        };
+
         if (!output_files.object_name.empty()) {
             debug(1) << "Module.compile(): object_name " << output_files.object_name << "\n";
-            auto out = make_raw_fd_ostream(output_files.object_name);
-            compile_llvm_module_to_object(*llvm_module, *out);
+            emit_object(output_files.object_name);
         }
         if (!output_files.static_library_name.empty()) {
             // To simplify the code, we always create a temporary object output
@@ -354,9 +778,7 @@ void Module::compile(const Outputs &output_files) const {
             {
                 std::string object_name = temp_dir.add_temp_object_file(output_files.static_library_name, "", target());
                 debug(1) << "Module.compile(): temporary object_name " << object_name << "\n";
-                auto out = make_raw_fd_ostream(object_name);
-                compile_llvm_module_to_object(*llvm_module, *out);
-                out->flush();  // create_static_library() is happier if we do this
+                emit_object(object_name);
             }
             debug(1) << "Module.compile(): static_library_name " << output_files.static_library_name << "\n";
             Target base_target(target().os, target().arch, target().bits);
@@ -415,13 +837,19 @@ void Module::compile(const Outputs &output_files) const {
            file << contents->auto_schedule;
         }
     }
+    if (!output_files.analysis_name.empty()) {
+        debug(1) << "Module.compile(): analysis_name " << output_files.analysis_name << "\n";
+        std::ofstream file(output_files.analysis_name);
+        emit_analysis_artifact(file, *this);
+    }
 }
 
 Outputs compile_standalone_runtime(const Outputs &output_files, Target t) {
     Module empty("standalone_runtime", t.without_feature(Target::NoRuntime).without_feature(Target::JIT));
     // For runtime, it only makes sense to output object files or static_library, so ignore
     // everything else.
-    Outputs actual_outputs = Outputs().object(output_files.object_name).static_library(output_files.static_library_name);
+    Outputs actual_outputs = Outputs().object(output_files.object_name).static_library(output_files.static_library_name)
+        .object_cache(output_files.object_cache_dir);
     empty.compile(actual_outputs);
     return actual_outputs;
 }
@@ -438,11 +866,25 @@ void compile_multitarget(const std::string &fn_name,
     user_assert(!fn_name.empty()) << "Function name must be specified.\n";
     user_assert(!targets.empty()) << "Must specify at least one target.\n";
 
-    // You can't ask for .o files when doing this; it's not really useful,
-    // and would complicate output (we might have to do multiple passes
-    // if different values for NoRuntime are specified)... so just forbid
-    // it up front.
-    user_assert(output_files.object_name.empty()) << "Cannot request object_name for compile_multitarget.\n";
+    // Requesting an object file means emitting all of the sub-targets,
+    // the runtime, and the wrapper into a *single* object: each
+    // sub-target's functions are tagged with per-function target-cpu
+    // and target-features attributes, so one TargetMachine can still
+    // select the right instructions for each version, and the shared
+    // code (runtime, wrapper, metadata) exists only once instead of
+    // once per sub-target. The per-target textual outputs don't fit in
+    // that mode, so forbid them.
+    const bool single_object = !output_files.object_name.empty();
+    if (single_object) {
+        user_assert(output_files.assembly_name.empty() &&
+                    output_files.bitcode_name.empty() &&
+                    output_files.llvm_assembly_name.empty() &&
+                    output_files.stmt_name.empty() &&
+                    output_files.stmt_html_name.empty() &&
+                    output_files.analysis_name.empty())
+            << "Only object, static_library, and c_header outputs may be requested "
+            << "when compiling a multitarget pipeline to a single object.\n";
+    }
 
     // The final target in the list is considered "baseline", and is used
     // for (e.g.) the runtime and shared code. It is often just os-arch-bits
@@ -463,7 +905,7 @@ void compile_multitarget(const std::string &fn_name,
     std::vector<std::future<void>> futures;
     // If we are running with HL_DEBUG_CODEGEN=1, use threads=1 to enforce
     // sequential execution, so that debug output won't be utterly incomprehensible
-    const size_t num_threads = (debug::debug_level() > 0) ? 1 : Internal::ThreadPool<void>::num_processors_online();
+    const size_t num_threads = (debug::debug_level() > 0) ? 1 : Internal::num_compile_time_threads();
     Internal::ThreadPool<void> pool(num_threads);
 
     // For safety, the runtime must be built only with features common to all
@@ -477,6 +919,57 @@ void compile_multitarget(const std::string &fn_name,
     // included). So we'll keep track of the common features as we walk thru the targets.
     uint64_t runtime_features_mask = (uint64_t)-1LL;
 
+    // State for the single-object path. Everything that ends up in the
+    // combined module must be codegenned into this one context, so
+    // that path runs serially.
+    llvm::LLVMContext context;
+    std::vector<std::unique_ptr<llvm::Module>> sub_llvm_modules;
+    std::unique_ptr<llvm::Module> runtime_llvm, wrapper_llvm;
+    auto strip_module_flags = [](llvm::Module &m) {
+        if (llvm::NamedMDNode *flags = m.getNamedMetadata("llvm.module.flags")) {
+            m.eraseNamedMetadata(flags);
+        }
+    };
+
+    // Does a function's IR use vector types or target-specific
+    // intrinsics anywhere? If not, it lowers to the same baseline
+    // instructions under every sub-target, so it can keep the
+    // baseline settings and be folded with its twins from the other
+    // sub-targets below.
+    auto needs_target_features = [](const llvm::Function &fn) -> bool {
+        for (const llvm::BasicBlock &bb : fn) {
+            for (const llvm::Instruction &inst : bb) {
+                if (inst.getType()->isVectorTy()) {
+                    return true;
+                }
+                for (const llvm::Use &u : inst.operands()) {
+                    if (u.get()->getType()->isVectorTy()) {
+                        return true;
+                    }
+                }
+                if (const llvm::CallInst *call = llvm::dyn_cast<llvm::CallInst>(&inst)) {
+                    const llvm::Function *callee = call->getCalledFunction();
+                    if (callee && callee->isIntrinsic()) {
+                        llvm::StringRef name = callee->getName();
+                        // These generic intrinsics lower the same way
+                        // everywhere. Conservatively treat anything
+                        // else (math, saturation, target-specific
+                        // ones) as feature-dependent.
+                        if (!name.startswith("llvm.lifetime.") &&
+                            !name.startswith("llvm.dbg.") &&
+                            !name.startswith("llvm.memcpy.") &&
+                            !name.startswith("llvm.memset.") &&
+                            !name.startswith("llvm.memmove.") &&
+                            !name.startswith("llvm.assume")) {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    };
+
     TemporaryObjectFileDir temp_dir;
     std::vector<Expr> wrapper_args;
     std::vector<LoweredArgument> base_target_args;
@@ -525,13 +1018,49 @@ void compile_multitarget(const std::string &fn_name,
         // but base_target is always the last one we encounter.
         base_target_args = sub_module.get_function_by_name(sub_fn_name).args;
 
-        Outputs sub_out = add_suffixes(output_files, suffix);
-        internal_assert(sub_out.object_name.empty());
-        sub_out.object_name = temp_dir.add_temp_object_file(output_files.static_library_name, suffix, target);
-        futures.emplace_back(pool.async([](Module m, Outputs o) {
-            debug(1) << "compile_multitarget: compile_sub_target " << o.object_name << "\n";
-            m.compile(o);
-        }, std::move(sub_module), std::move(sub_out)));
+        if (single_object) {
+            debug(1) << "compile_multitarget: codegen " << sub_fn_name << "\n";
+            std::unique_ptr<llvm::Module> sub_llvm = compile_module_to_llvm_module(sub_module, context);
+            // Record this sub-target's cpu and feature set as
+            // per-function attributes, which take precedence over the
+            // TargetMachine's settings during instruction selection,
+            // then drop the module flags that recorded them: they
+            // would conflict when the modules are linked, and
+            // functions without attributes should get the baseline
+            // settings, which come from the runtime's flags below.
+            llvm::TargetOptions opts;
+            std::string mcpu, mattrs;
+            Internal::get_target_options(*sub_llvm, opts, mcpu, mattrs);
+            for (llvm::Function &fn : *sub_llvm) {
+                if (fn.isDeclaration()) {
+                    continue;
+                }
+                // Purely scalar functions (bounds queries, metadata,
+                // error paths, unvectorized loops) are left on the
+                // baseline settings. They come out identical in every
+                // sub-target, which lets the merge pass below fold
+                // them after linking.
+                if (!needs_target_features(fn)) {
+                    continue;
+                }
+                if (!mcpu.empty()) {
+                    fn.addFnAttr("target-cpu", mcpu);
+                }
+                if (!mattrs.empty()) {
+                    fn.addFnAttr("target-features", mattrs);
+                }
+            }
+            strip_module_flags(*sub_llvm);
+            sub_llvm_modules.push_back(std::move(sub_llvm));
+        } else {
+            Outputs sub_out = add_suffixes(output_files, suffix);
+            internal_assert(sub_out.object_name.empty());
+            sub_out.object_name = temp_dir.add_temp_object_file(output_files.static_library_name, suffix, target);
+            futures.emplace_back(pool.async([](Module m, Outputs o) {
+                debug(1) << "compile_multitarget: compile_sub_target " << o.object_name << "\n";
+                m.compile(o);
+            }, std::move(sub_module), std::move(sub_out)));
+        }
 
         const uint64_t cur_target_mask = target_feature_mask(target);
         Expr can_use = (target == base_target) ?
@@ -560,12 +1089,19 @@ void compile_multitarget(const std::string &fn_name,
                 }
             }
         }
-        Outputs runtime_out = Outputs().object(
-            temp_dir.add_temp_object_file(output_files.static_library_name, "_runtime", runtime_target));
-        futures.emplace_back(pool.async([](Target t, Outputs o) {
-            debug(1) << "compile_multitarget: compile_standalone_runtime " << o.static_library_name << "\n";
-            compile_standalone_runtime(o, t);
-        }, std::move(runtime_target), std::move(runtime_out)));
+        if (single_object) {
+            debug(1) << "compile_multitarget: codegen standalone runtime\n";
+            Module runtime_module("standalone_runtime", runtime_target);
+            runtime_llvm = compile_module_to_llvm_module(runtime_module, context);
+        } else {
+            Outputs runtime_out = Outputs().object(
+                temp_dir.add_temp_object_file(output_files.static_library_name, "_runtime", runtime_target))
+                .object_cache(output_files.object_cache_dir);
+            futures.emplace_back(pool.async([](Target t, Outputs o) {
+                debug(1) << "compile_multitarget: compile_standalone_runtime " << o.static_library_name << "\n";
+                compile_standalone_runtime(o, t);
+            }, std::move(runtime_target), std::move(runtime_out)));
+        }
     }
 
     if (needs_wrapper) {
@@ -601,12 +1137,18 @@ void compile_multitarget(const std::string &fn_name,
         // Add a wrapper to accept old buffer_ts
         add_legacy_wrapper(wrapper_module, wrapper_module.functions().back());
 
-        Outputs wrapper_out = Outputs().object(
-            temp_dir.add_temp_object_file(output_files.static_library_name, "_wrapper", base_target, /* in_front*/ true));
-        futures.emplace_back(pool.async([](Module m, Outputs o) {
-            debug(1) << "compile_multitarget: wrapper " << o.object_name << "\n";
-            m.compile(o);
-        }, std::move(wrapper_module), std::move(wrapper_out)));
+        if (single_object) {
+            debug(1) << "compile_multitarget: codegen wrapper " << fn_name << "\n";
+            wrapper_llvm = compile_module_to_llvm_module(wrapper_module, context);
+        } else {
+            Outputs wrapper_out = Outputs().object(
+                temp_dir.add_temp_object_file(output_files.static_library_name, "_wrapper", base_target, /* in_front*/ true))
+                .object_cache(output_files.object_cache_dir);
+            futures.emplace_back(pool.async([](Module m, Outputs o) {
+                debug(1) << "compile_multitarget: wrapper " << o.object_name << "\n";
+                m.compile(o);
+            }, std::move(wrapper_module), std::move(wrapper_out)));
+        }
     }
 
     if (!output_files.c_header_name.empty()) {
@@ -626,9 +1168,52 @@ void compile_multitarget(const std::string &fn_name,
         f.wait();
     }
 
+    if (single_object) {
+        // Link everything into one module. The combined module keeps
+        // the runtime's module flags (or the wrapper's, if the
+        // runtime was suppressed): those record the
+        // feature-intersection baseline, which is what any function
+        // without per-function attributes must be compiled with.
+        std::unique_ptr<llvm::Module> combined;
+        if (runtime_llvm) {
+            strip_module_flags(*wrapper_llvm);
+            combined = std::move(runtime_llvm);
+        } else {
+            combined = std::move(wrapper_llvm);
+        }
+        for (auto &sub : sub_llvm_modules) {
+            bool failed = llvm::Linker::linkModules(*combined, std::move(sub));
+            internal_assert(!failed) << "Failure linking sub-target modules in compile_multitarget\n";
+        }
+        if (wrapper_llvm) {
+            bool failed = llvm::Linker::linkModules(*combined, std::move(wrapper_llvm));
+            internal_assert(!failed) << "Failure linking wrapper module in compile_multitarget\n";
+        }
+        {
+            // Fold the identical copies of the scalar code that every
+            // sub-target contributed. Each sub-target's symbols stay
+            // visible (the wrapper dispatches on them by name), but
+            // merged bodies are stored once; only functions that
+            // actually use vectors or feature-dependent intrinsics
+            // remain per-target.
+            debug(1) << "compile_multitarget: merging identical functions\n";
+            llvm::legacy::PassManager pm;
+            pm.add(llvm::createMergeFunctionsPass());
+            pm.run(*combined);
+        }
+        debug(1) << "compile_multitarget: single object " << output_files.object_name << "\n";
+        auto out = make_raw_fd_ostream(output_files.object_name);
+        compile_llvm_module_to_object(*combined, *out);
+        out->flush();
+    }
+
     if (!output_files.static_library_name.empty()) {
         debug(1) << "compile_multitarget: static_library_name " << output_files.static_library_name << "\n";
-        create_static_library(temp_dir.files(), base_target, output_files.static_library_name);
+        if (single_object) {
+            create_static_library({output_files.object_name}, base_target, output_files.static_library_name);
+        } else {
+            create_static_library(temp_dir.files(), base_target, output_files.static_library_name);
+        }
     }
 }
 
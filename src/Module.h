@@ -7,6 +7,7 @@
  */
 
 #include <functional>
+#include <set>
 
 #include "Argument.h"
 #include "ExternalCode.h"
@@ -60,6 +61,12 @@ struct LoweredFunc {
      * the Target. */
     NameMangling name_mangling;
 
+    /** Names of Funcs in the body whose stores should use
+     * non-temporal store instructions where the target supports
+     * them. Populated during lowering from
+     * Func::store_non_temporal. */
+    std::set<std::string> non_temporal_buffers;
+
     LoweredFunc(const std::string &name,
                 const std::vector<LoweredArgument> &args,
                 Stmt body,
@@ -158,6 +165,15 @@ EXPORT Outputs compile_standalone_runtime(const Outputs &output_files, Target t)
 
 typedef std::function<Module(const std::string &, const Target &)> ModuleProducer;
 
+/** Compile a pipeline for several targets (which must share
+ * arch-bits-os), plus a wrapper that dispatches at runtime to the most
+ * featureful version the machine can run, via
+ * halide_can_use_target_features. With static_library_name set, each
+ * sub-target becomes its own object inside the library. With
+ * object_name set, everything -- all of the sub-target versions, the
+ * runtime, and the wrapper -- is instead emitted as one object, using
+ * per-function target attributes so that shared code exists only once;
+ * this produces a much smaller binary at the same peak throughput. */
 EXPORT void compile_multitarget(const std::string &fn_name,
                                 const Outputs &output_files,
                                 const std::vector<Target> &targets,
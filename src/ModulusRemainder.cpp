@@ -1,4 +1,7 @@
+#include <mutex>
+
 #include "ModulusRemainder.h"
+#include "IREquality.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
 #include "IR.h"
@@ -63,14 +66,62 @@ public:
     void visit(const Prefetch *);
 };
 
+namespace {
+
+// Modulus-remainder queries repeat heavily during lowering (e.g. from
+// the simplifier and from alignment checks in vectorization), so
+// cache results in a small direct-mapped structure keyed on the
+// expression and the identity of the scope's state (its address plus
+// the scope mutation counter; see Scope.h). The cache is lossy: a
+// colliding entry is simply overwritten.
+struct ModulusRemainderCacheEntry {
+    Expr expr;
+    const void *scope;
+    uint64_t scope_epoch;
+    ModulusRemainder result;
+};
+
+const int modulus_remainder_cache_bits = 12;
+ModulusRemainderCacheEntry modulus_remainder_cache[1 << modulus_remainder_cache_bits];
+std::mutex modulus_remainder_cache_mutex;
+
+ModulusRemainder modulus_remainder_cached(Expr e, const Scope<ModulusRemainder> *scope) {
+    uint64_t h = structural_hash(e);
+    h ^= (uint64_t)(uintptr_t)scope * 0x9e3779b97f4a7c15ULL;
+    ModulusRemainderCacheEntry *entry =
+        &modulus_remainder_cache[h & ((1 << modulus_remainder_cache_bits) - 1)];
+    {
+        std::lock_guard<std::mutex> lock(modulus_remainder_cache_mutex);
+        if (entry->expr.defined() &&
+            entry->scope == scope &&
+            entry->scope_epoch == scope_mutation_counter().load(std::memory_order_relaxed) &&
+            (entry->expr.same_as(e) || equal(entry->expr, e))) {
+            return entry->result;
+        }
+    }
+
+    ComputeModulusRemainder mr(scope);
+    ModulusRemainder result = mr.analyze(e);
+
+    {
+        std::lock_guard<std::mutex> lock(modulus_remainder_cache_mutex);
+        entry->expr = e;
+        entry->scope = scope;
+        entry->scope_epoch = scope_mutation_counter().load(std::memory_order_relaxed);
+        entry->result = result;
+    }
+
+    return result;
+}
+
+}  // namespace
+
 ModulusRemainder modulus_remainder(Expr e) {
-    ComputeModulusRemainder mr(nullptr);
-    return mr.analyze(e);
+    return modulus_remainder_cached(e, nullptr);
 }
 
 ModulusRemainder modulus_remainder(Expr e, const Scope<ModulusRemainder> &scope) {
-    ComputeModulusRemainder mr(&scope);
-    return mr.analyze(e);
+    return modulus_remainder_cached(e, &scope);
 }
 
 
@@ -2,6 +2,8 @@
 #include "Introspection.h"
 #include "Error.h"
 
+#include <algorithm>
+
 namespace Halide {
 namespace Internal {
 
@@ -15,52 +17,89 @@ ObjectInstanceRegistry &ObjectInstanceRegistry::get_registry() {
 void ObjectInstanceRegistry::register_instance(void *this_ptr, size_t size, Kind kind,
                                                void *subject_ptr, const void *introspection_helper) {
     ObjectInstanceRegistry &registry = get_registry();
-    std::lock_guard<std::mutex> lock(registry.mutex);
     uintptr_t key = (uintptr_t)this_ptr;
-    internal_assert(registry.instances.find(key) == registry.instances.end());
+    Shard &shard = registry.shard_for(key);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        internal_assert(shard.instances.find(key) == shard.instances.end());
+        shard.instances[key] = InstanceInfo(size, kind, subject_ptr, introspection_helper != nullptr);
+    }
     if (introspection_helper) {
-        registry.instances[key] = InstanceInfo(size, kind, subject_ptr, true);
+        std::lock_guard<std::mutex> lock(registry.introspection_mutex);
         Introspection::register_heap_object(this_ptr, size, introspection_helper);
-    } else {
-        registry.instances[key] = InstanceInfo(size, kind, subject_ptr, false);
     }
 }
 
 /* static */
 void ObjectInstanceRegistry::unregister_instance(void *this_ptr) {
     ObjectInstanceRegistry &registry = get_registry();
-    std::lock_guard<std::mutex> lock(registry.mutex);
     uintptr_t key = (uintptr_t)this_ptr;
-    std::map<uintptr_t, InstanceInfo>::iterator it = registry.instances.find(key);
-    internal_assert(it != registry.instances.end());
-    if (it->second.registered_for_introspection) {
-        Introspection::deregister_heap_object(this_ptr, it->second.size);
+    Shard &shard = registry.shard_for(key);
+    size_t size;
+    bool registered_for_introspection;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::map<uintptr_t, InstanceInfo>::iterator it = shard.instances.find(key);
+        internal_assert(it != shard.instances.end());
+        size = it->second.size;
+        registered_for_introspection = it->second.registered_for_introspection;
+        shard.instances.erase(it);
+    }
+    if (registered_for_introspection) {
+        std::lock_guard<std::mutex> lock(registry.introspection_mutex);
+        Introspection::deregister_heap_object(this_ptr, size);
     }
-    registry.instances.erase(it);
 }
 
 /* static */
 std::vector<void *> ObjectInstanceRegistry::instances_in_range(void *start, size_t size,
                                                                Kind kind) {
     std::vector<void *> results;
+    if (size == 0) {
+        return results;
+    }
 
     ObjectInstanceRegistry &registry = get_registry();
-    std::lock_guard<std::mutex> lock(registry.mutex);
+    uintptr_t start_ptr = (uintptr_t)start;
+    uintptr_t limit_ptr = start_ptr + size;
 
-    std::map<uintptr_t, InstanceInfo>::const_iterator it =
-        registry.instances.lower_bound((uintptr_t)start);
+    // Gather the entries in the range, in ascending address order, by
+    // walking the pages the range covers. The queried object (a
+    // Generator and its members) spans only a handful of pages, so
+    // this only touches a handful of shards; registrations on
+    // unrelated pages proceed concurrently.
+    std::vector<std::pair<uintptr_t, InstanceInfo>> in_range;
+    uintptr_t first_page = start_ptr >> kPageBits;
+    uintptr_t last_page = (limit_ptr - 1) >> kPageBits;
+    for (uintptr_t page = first_page; page <= last_page; page++) {
+        Shard &shard = registry.shards[page & (kNumShards - 1)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        uintptr_t page_start = std::max(start_ptr, page << kPageBits);
+        uintptr_t page_limit = std::min(limit_ptr, (page + 1) << kPageBits);
+        std::map<uintptr_t, InstanceInfo>::const_iterator it =
+            shard.instances.lower_bound(page_start);
+        while (it != shard.instances.end() && it->first < page_limit) {
+            in_range.push_back(*it);
+            it++;
+        }
+    }
 
-    uintptr_t limit_ptr = ((uintptr_t)start) + size;
-    while (it != registry.instances.end() && it->first < limit_ptr) {
-        if (it->second.kind == kind) {
-            results.push_back(it->second.subject_ptr);
+    size_t i = 0;
+    while (i < in_range.size()) {
+        uintptr_t key = in_range[i].first;
+        const InstanceInfo &info = in_range[i].second;
+        if (info.kind == kind) {
+            results.push_back(info.subject_ptr);
         }
 
-        if (it->first > (uintptr_t)start && it->second.size != 0) {
+        if (key > start_ptr && info.size != 0) {
             // Skip over containers that we enclose
-            it = registry.instances.lower_bound(it->first + it->second.size);
+            uintptr_t container_limit = key + info.size;
+            do {
+                i++;
+            } while (i < in_range.size() && in_range[i].first < container_limit);
         } else {
-            it++;
+            i++;
         }
     }
 
@@ -5,8 +5,10 @@
  *
  * Provides a single global registry of Generators, GeneratorParams,
  * and Params indexed by this pointer. This is used for finding the
- * parameters inside of a Generator. NOTE: this is threadsafe only
- * if you are compiling with C++11 enabled.
+ * parameters inside of a Generator. The registry is sharded by the
+ * page containing the registered pointer, so threads constructing
+ * pipelines concurrently do not contend for a single lock. NOTE:
+ * this is threadsafe only if you are compiling with C++11 enabled.
  */
 
 #include <stddef.h>
@@ -80,8 +82,34 @@ private:
             : subject_ptr(subject_ptr), size(size), kind(kind), registered_for_introspection(registered_for_introspection) {}
     };
 
-    std::mutex mutex;
-    std::map<uintptr_t, InstanceInfo> instances;
+    // The registry is sharded by the page containing the registered
+    // pointer. Threads constructing pipelines concurrently do so on
+    // distinct stacks (or in distinct heap arenas), so their
+    // registrations land on distinct pages and hence in distinct
+    // shards, and proceed without contention. Range queries walk the
+    // pages their range covers in ascending order; as the shards
+    // partition the address space by page, this visits the entries in
+    // ascending address order.
+    enum {
+        kNumShards = 64,  // Must be a power of two
+        kPageBits = 12
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::map<uintptr_t, InstanceInfo> instances;
+    };
+
+    Shard shards[kNumShards];
+
+    // The introspection subsystem is not internally synchronized; its
+    // calls used to be serialized by the single registry lock, so keep
+    // serializing them here.
+    std::mutex introspection_mutex;
+
+    Shard &shard_for(uintptr_t this_ptr) {
+        return shards[(this_ptr >> kPageBits) & (kNumShards - 1)];
+    }
 
     ObjectInstanceRegistry() {}
     ObjectInstanceRegistry(ObjectInstanceRegistry &rhs);  // unimplemented
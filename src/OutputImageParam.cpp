@@ -38,6 +38,20 @@ OutputImageParam &OutputImageParam::set_host_alignment(int bytes) {
     return *this;
 }
 
+OutputImageParam &OutputImageParam::set_shape_from(const halide_buffer_t *buf) {
+    user_assert(buf != nullptr)
+        << "Can't call set_shape_from on a null buffer\n";
+    user_assert(buf->dimensions == dimensions())
+        << "Can't call set_shape_from on " << name()
+        << " with a " << (int)buf->dimensions << "-dimensional buffer: "
+        << name() << " has " << dimensions() << " dimensions\n";
+    for (int i = 0; i < dimensions(); i++) {
+        dim(i).set_bounds(buf->dim[i].min, buf->dim[i].extent);
+        dim(i).set_stride(buf->dim[i].stride);
+    }
+    return *this;
+}
+
 int OutputImageParam::dimensions() const {
     return param.dimensions();
 }
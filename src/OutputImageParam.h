@@ -69,6 +69,24 @@ public:
     /** Set the expected alignment of the host pointer in bytes. */
     EXPORT OutputImageParam &set_host_alignment(int);
 
+    /** Constrain every dimension of this parameter to have exactly
+     * the min, extent, and stride of the given buffer, as
+     * compile-time constants. Useful when the shapes a pipeline will
+     * run on are known when it is compiled (e.g. fixed-resolution
+     * video frames): the compiler sees constant extents and strides
+     * everywhere this parameter's shape is referenced, enabling
+     * constant-bound loop optimizations that variable shapes
+     * defeat. The compiled pipeline will reject buffers of any other
+     * shape at runtime. Equivalent to calling dim(i).set_bounds and
+     * dim(i).set_stride for every dimension i:
+     \code
+     ImageParam frame(UInt(8), 2);
+     Buffer<uint8_t> witness(3840, 2160);
+     frame.set_shape_from(witness.raw_buffer());
+     \endcode
+     */
+    EXPORT OutputImageParam &set_shape_from(const halide_buffer_t *buf);
+
     /** Get the dimensionality of this image parameter */
     EXPORT int dimensions() const;
 
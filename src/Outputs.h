@@ -54,6 +54,21 @@ struct Outputs {
      * output is desired. */
     std::string schedule_name;
 
+    /** The name of the emitted static analysis artifact: a
+     * machine-readable (JSON) summary of per-Func operation counts,
+     * vectorization, parallel loops, and allocation sizes in the
+     * lowered pipeline. Empty if no analysis output is desired. */
+    std::string analysis_name;
+
+    /** A directory to use as a content-addressed cache of compiled
+     * object files, keyed on the LLVM bitcode and target. When set,
+     * emitting an object file (or the objects inside a static
+     * library) first checks the cache, and unchanged pipelines skip
+     * instruction selection entirely. Empty if no caching is
+     * desired. The directory must already exist; it is safe to share
+     * it between concurrent builds. */
+    std::string object_cache_dir;
+
     /** Make a new Outputs struct that emits everything this one does
      * and also an object file with the given name. */
     Outputs object(const std::string &object_name) const {
@@ -133,6 +148,22 @@ struct Outputs {
         updated.schedule_name = schedule_name;
         return updated;
     }
+
+    /** Make a new Outputs struct that emits everything this one does
+     * and also a static analysis artifact with the given name. */
+    Outputs analysis(const std::string &analysis_name) const {
+        Outputs updated = *this;
+        updated.analysis_name = analysis_name;
+        return updated;
+    }
+
+    /** Make a new Outputs struct that emits everything this one does,
+     * caching emitted object files in the given directory. */
+    Outputs object_cache(const std::string &object_cache_dir) const {
+        Outputs updated = *this;
+        updated.object_cache_dir = object_cache_dir;
+        return updated;
+    }
 };
 
 }
@@ -583,10 +583,32 @@ class PartitionLoops : public IRMutator {
 
         bool make_prologue = !equal(prologue, simpler_body);
         bool make_epilogue = !equal(epilogue, simpler_body);
+        bool prologue_equals_epilogue = equal(prologue, epilogue);
 
         // Recurse on the middle section.
         simpler_body = mutate(simpler_body);
 
+        // Recurse on the prologue and epilogue too. They still
+        // contain likely tags for the other loop dimensions, so
+        // partitioning them turns the five regions you'd get from a
+        // 2D boundary condition into the classic nine-region
+        // decomposition: the boundary rows get their own clean
+        // interior in x instead of running the slow path across the
+        // full width.
+        if (make_prologue) {
+            prologue = mutate(prologue);
+        }
+        if (make_epilogue) {
+            // Mutating them separately would give the two copies
+            // distinct variable names, so reuse the prologue if they
+            // started out identical.
+            if (make_prologue && prologue_equals_epilogue) {
+                epilogue = prologue;
+            } else {
+                epilogue = mutate(epilogue);
+            }
+        }
+
         // Construct variables for the bounds of the simplified middle section
         Expr min_steady = op->min, max_steady = op->extent + op->min;
         Expr prologue_val, epilogue_val;
@@ -624,8 +646,14 @@ class PartitionLoops : public IRMutator {
             internal_assert(!expr_uses_var(epilogue_val, op->name));
         }
 
-        // Bust serial for loops up into three.
-        if (op->for_type == ForType::Serial) {
+        // Bust serial for loops up into three. The outermost gpu
+        // block loop gets the same treatment: each piece becomes its
+        // own kernel launch, so the interior blocks run a kernel
+        // variant with no boundary guards (and a register footprint
+        // to match), instead of branching around them inside one
+        // kernel.
+        if (op->for_type == ForType::Serial ||
+            (op->for_type == ForType::GPUBlock && !old_in_gpu_loop)) {
             stmt = For::make(op->name, min_steady, max_steady - min_steady,
                              op->for_type, op->device_api, simpler_body);
 
@@ -645,7 +673,7 @@ class PartitionLoops : public IRMutator {
             // should branch-predict to the steady state pretty well.
             Expr loop_var = Variable::make(Int(32), op->name);
             stmt = simpler_body;
-            if (make_epilogue && make_prologue && equal(prologue, epilogue)) {
+            if (make_epilogue && make_prologue && prologue_equals_epilogue) {
                 stmt = IfThenElse::make(min_steady <= loop_var && loop_var < max_steady, stmt, prologue);
             } else {
                 if (make_epilogue) {
@@ -801,7 +829,8 @@ class RenormalizeGPULoops : public IRMutator {
                 IRMutator::visit(op);
             } else {
                 Stmt inner = LetStmt::make(op->name, op->value, a->body);
-                inner = Allocate::make(a->name, a->type, a->extents, a->condition, inner);
+                inner = Allocate::make(a->name, a->type, a->extents, a->condition, inner,
+                                       Expr(), std::string(), a->memory_type);
                 stmt = mutate(inner);
             }
         } else {
@@ -838,7 +867,8 @@ class RenormalizeGPULoops : public IRMutator {
             allocate_a->name == "__shared" &&
             allocate_b->name == "__shared") {
             Stmt inner = IfThenElse::make(op->condition, allocate_a->body, allocate_b->body);
-            inner = Allocate::make(allocate_a->name, allocate_a->type, allocate_a->extents, allocate_a->condition, inner);
+            inner = Allocate::make(allocate_a->name, allocate_a->type, allocate_a->extents, allocate_a->condition, inner,
+                                   Expr(), std::string(), allocate_a->memory_type);
             stmt = mutate(inner);
         } else if (let_a && let_b && let_a->name == let_b->name) {
             string condition_name = unique_name('t');
@@ -976,6 +1006,66 @@ class LowerLikelyIfInnermost : public IRMutator {
     }
 };
 
+// Does an expression do work worth branching around: a division, a
+// modulus, or a call that isn't just a tag? The boundary-condition
+// helpers that re-index out-of-range coordinates are the motivating
+// case.
+class IsExpensive : public IRVisitor {
+    using IRVisitor::visit;
+    void visit(const Div *op) {
+        result = true;
+    }
+    void visit(const Mod *op) {
+        result = true;
+    }
+    void visit(const Call *op) {
+        if (op->is_intrinsic(Call::likely) ||
+            op->is_intrinsic(Call::likely_if_innermost)) {
+            IRVisitor::visit(op);
+        } else {
+            result = true;
+        }
+    }
+public:
+    bool result = false;
+};
+
+bool is_expensive(Expr e) {
+    IsExpensive v;
+    e.accept(&v);
+    return v.result;
+}
+
+// Any select with a single likely-tagged arm still standing at this
+// point is in a region partitioning failed to specialize: the
+// interior blocks of an inner gpu dimension, or a loop whose
+// simplifications the solver couldn't invert after splits. When the
+// unlikely arm is expensive, rewrite the select into a real branch so
+// such regions at least skip the boundary handling at run time rather
+// than evaluating it for every element. Vectorized selects were
+// already given this treatment by the vectorizer, so only scalar
+// conditions are considered.
+class BranchAroundUnlikelyArms : public IRMutator {
+    using IRMutator::visit;
+
+    void visit(const Select *op) {
+        if (op->condition.type().is_scalar()) {
+            bool likely_t = has_likely_tag(op->true_value);
+            bool likely_f = has_likely_tag(op->false_value);
+            if (likely_t != likely_f &&
+                is_expensive(likely_t ? op->false_value : op->true_value)) {
+                expr = Call::make(op->type, Call::if_then_else,
+                                  {mutate(op->condition),
+                                   mutate(op->true_value),
+                                   mutate(op->false_value)},
+                                  Call::PureIntrinsic);
+                return;
+            }
+        }
+        IRMutator::visit(op);
+    }
+};
+
 }
 
 bool has_likely_tag(Expr e) {
@@ -990,6 +1080,7 @@ Stmt partition_loops(Stmt s) {
     s = ExpandSelects().mutate(s);
     s = PartitionLoops().mutate(s);
     s = RenormalizeGPULoops().mutate(s);
+    s = BranchAroundUnlikelyArms().mutate(s);
     s = RemoveLikelyTags().mutate(s);
     s = CollapseSelects().mutate(s);
     return s;
@@ -17,7 +17,11 @@ bool has_likely_tag(Expr e);
 
 /** Partitions loop bodies into a prologue, a steady state, and an
  * epilogue. Finds the steady state by hunting for use of clamped
- * ramps, or the 'likely' intrinsic. */
+ * ramps, or the 'likely' intrinsic. Applies recursively to the
+ * prologue and epilogue as well as the steady state, so nested loops
+ * with boundary conditions in each dimension decompose into an
+ * interior hyper-rectangle plus edge strips that are each clean in
+ * the remaining dimensions. */
 EXPORT Stmt partition_loops(Stmt s);
 
 }
@@ -1,10 +1,18 @@
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
 
 #include "Pipeline.h"
 #include "Argument.h"
 #include "FindCalls.h"
 #include "Func.h"
 #include "InferArguments.h"
+#include "InferStaleRegions.h"
+#include "Interpret.h"
+#include "IROperator.h"
+#include "IRPrinter.h"
 #include "IRVisitor.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Output.h"
@@ -12,6 +20,9 @@
 #include "Outputs.h"
 #include "PrintLoopNest.h"
 #include "RealizationOrder.h"
+#include "ScheduleFunctions.h"
+#include "ScheduleSerialization.h"
+#include "Simplify.h"
 
 using namespace Halide::Internal;
 
@@ -62,8 +73,15 @@ struct PipelineContents {
         jit_module = JITModule();
         jit_target = Target();
         inferred_args.clear();
+        bounds_query_cache.clear();
     }
 
+    /** Cached results of JIT bounds queries. The key encodes the
+     * output shapes and the values of the scalar parameters, which
+     * are what the inferred bounds can depend on; the value is the
+     * shape of each unbound input buffer at convergence. */
+    std::map<vector<uint64_t>, vector<vector<halide_dimension_t>>> bounds_query_cache;
+
     // The outputs
     vector<Function> outputs;
 
@@ -80,6 +98,10 @@ struct PipelineContents {
     /** A set of custom passes to use when lowering this Func. */
     vector<CustomLoweringPass> custom_lowering_passes;
 
+    /** Requirements added via Pipeline::add_requirement. Checked at
+     * runtime and exploited at compile time during lowering. */
+    vector<Expr> requirements;
+
     /** The inferred arguments. Also the arguments to the main
      * function in the jit_module above. The two must be updated
      * together. */
@@ -150,6 +172,51 @@ vector<Func> Pipeline::outputs() const {
     return funcs;
 }
 
+Pipeline &Pipeline::fuse_outputs() {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    vector<Function> &outs = contents->outputs;
+    user_assert(outs.size() > 1)
+        << "fuse_outputs() requires a Pipeline with more than one output.\n";
+    const Function &first = outs[0];
+    for (size_t i = 0; i < outs.size(); i++) {
+        Function f = outs[i];
+        user_assert(!f.has_extern_definition() && f.updates().empty())
+            << "Cannot fuse output " << f.name()
+            << ": only pure, non-extern outputs can share a traversal.\n";
+        user_assert(!f.schedule().memoized())
+            << "Cannot fuse memoized output " << f.name() << ".\n";
+        user_assert(f.dimensions() == first.dimensions())
+            << "Cannot fuse output " << f.name() << ": it has "
+            << f.dimensions() << " dimensions, but " << first.name()
+            << " has " << first.dimensions() << ".\n";
+        // Fused outputs must not consume each other; interleaving
+        // their stores would then read values not yet written.
+        std::map<string, Function> calls = find_transitive_calls(f);
+        for (const Function &other : outs) {
+            user_assert(other.same_as(f) || !calls.count(other.name()))
+                << "Cannot fuse the outputs of this Pipeline: "
+                << f.name() << " depends on " << other.name() << ".\n";
+        }
+        f.schedule().fused_output() = true;
+        if (i > 0) {
+            // Interleaving the loop nests is only sound if the
+            // outputs are realized over the same region; constrain
+            // the output buffers to match the first output's, which
+            // becomes a runtime check on the buffers passed in.
+            const Parameter &first_buf = first.output_buffers()[0];
+            for (Parameter b : f.output_buffers()) {
+                for (int d = 0; d < f.dimensions(); d++) {
+                    b.set_min_constraint(
+                        d, Variable::make(Int(32), first_buf.name() + ".min." + std::to_string(d), first_buf));
+                    b.set_extent_constraint(
+                        d, Variable::make(Int(32), first_buf.name() + ".extent." + std::to_string(d), first_buf));
+                }
+            }
+        }
+    }
+    return *this;
+}
+
 string Pipeline::auto_schedule(const Target &target, const MachineParams &arch_params) {
     user_assert(target.arch == Target::X86 || target.arch == Target::ARM ||
                 target.arch == Target::POWERPC || target.arch == Target::MIPS)
@@ -157,6 +224,20 @@ string Pipeline::auto_schedule(const Target &target, const MachineParams &arch_p
     return generate_schedules(contents->outputs, target, arch_params);
 }
 
+void Pipeline::save_schedule(const std::string &filename) {
+    std::ofstream file(filename.c_str());
+    user_assert(!file.fail()) << "Cannot open schedule file for writing: " << filename << "\n";
+    serialize_schedules(contents->outputs, file);
+    file.close();
+    user_assert(!file.fail()) << "Error writing schedule file: " << filename << "\n";
+}
+
+void Pipeline::load_schedule(const std::string &filename) {
+    std::ifstream file(filename.c_str());
+    user_assert(!file.fail()) << "Cannot open schedule file for reading: " << filename << "\n";
+    deserialize_schedules(contents->outputs, file);
+}
+
 Func Pipeline::get_func(size_t index) {
     // Compute an environment
     std::map<string, Function> env;
@@ -236,6 +317,11 @@ void Pipeline::print_loop_nest() {
     std::cerr << Halide::Internal::print_loop_nest(contents->outputs);
 }
 
+void Pipeline::validate_schedule(const Target &target) {
+    user_assert(defined()) << "Can't validate the schedule of an undefined Pipeline.\n";
+    validate_schedules(contents->outputs, target);
+}
+
 void Pipeline::compile_to_lowered_stmt(const string &filename,
                                        const vector<Argument> &args,
                                        StmtOutputFormat fmt,
@@ -319,6 +405,208 @@ vector<Argument> Pipeline::infer_arguments() {
     return infer_arguments(Stmt());
 }
 
+namespace {
+
+/** Collects everything about the Parameters referenced by a pipeline
+ * that can change the result of lowering without changing how the
+ * Exprs that mention them print: buffer constraints, host alignment,
+ * and the current values of scalar params that are bound before
+ * lowering (e.g. ScheduleParams). */
+class SerializeReferencedParameters : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Variable *op) {
+        include(op->param);
+    }
+
+    void visit(const Load *op) {
+        include(op->param);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Call *op) {
+        include(op->param);
+        IRVisitor::visit(op);
+    }
+
+    std::set<string> visited;
+
+public:
+    std::ostringstream out;
+
+    void include(const Parameter &p) {
+        if (!p.defined() || !visited.insert(p.name()).second) {
+            return;
+        }
+        out << "|param " << p.name() << " " << p.type();
+        if (p.is_buffer()) {
+            out << " " << p.dimensions() << " " << p.host_alignment();
+            for (int i = 0; i < p.dimensions(); i++) {
+                out << " (" << p.min_constraint(i)
+                    << " " << p.extent_constraint(i)
+                    << " " << p.stride_constraint(i) << ")";
+            }
+        } else if (p.is_bound_before_lowering()) {
+            out << " = " << p.scalar_expr();
+        }
+    }
+};
+
+void serialize_expr(const Expr &e, std::ostream &s, SerializeReferencedParameters &params) {
+    if (e.defined()) {
+        s << e;
+        e.accept(&params);
+    } else {
+        s << "_";
+    }
+}
+
+void serialize_definition(const Definition &def, std::ostream &s,
+                          SerializeReferencedParameters &params) {
+    serialize_expr(def.predicate(), s, params);
+    for (const Expr &e : def.args()) {
+        s << ";";
+        serialize_expr(e, s, params);
+    }
+    s << "=";
+    for (const Expr &e : def.values()) {
+        s << ";";
+        serialize_expr(e, s, params);
+    }
+    const StageSchedule &sched = def.schedule();
+    for (const ReductionVariable &rv : sched.rvars()) {
+        s << "|rvar " << rv.var << " ";
+        serialize_expr(rv.min, s, params);
+        s << " ";
+        serialize_expr(rv.extent, s, params);
+    }
+    for (const Split &split : sched.splits()) {
+        s << "|split " << split.old_var << " " << split.outer << " " << split.inner << " ";
+        serialize_expr(split.factor, s, params);
+        s << " " << split.exact << " " << (int)split.tail << " " << (int)split.split_type;
+    }
+    for (const Dim &dim : sched.dims()) {
+        s << "|dim " << dim.var << " " << (int)dim.for_type
+          << " " << (int)dim.device_api << " " << (int)dim.dim_type;
+    }
+    for (const PrefetchDirective &p : sched.prefetches()) {
+        s << "|prefetch " << p.name << " " << p.var << " ";
+        serialize_expr(p.offset, s, params);
+        s << " " << (int)p.strategy;
+    }
+    s << "|race " << sched.allow_race_conditions();
+    for (const Specialization &spec : def.specializations()) {
+        s << "|specialize ";
+        serialize_expr(spec.condition, s, params);
+        s << " \"" << spec.failure_message << "\" {";
+        serialize_definition(spec.definition, s, params);
+        s << "}";
+    }
+}
+
+void serialize_function(const Function &f, std::ostream &s,
+                        SerializeReferencedParameters &params) {
+    s << "|func " << f.name() << " (";
+    for (const string &arg : f.args()) {
+        s << arg << ";";
+    }
+    s << ") :";
+    for (Type t : f.output_types()) {
+        s << " " << t;
+    }
+    if (f.has_extern_definition()) {
+        s << "|extern " << f.extern_function_name()
+          << " " << f.extern_arguments().size()
+          << " " << (int)f.extern_definition_name_mangling()
+          << " " << (int)f.extern_function_device_api()
+          << " " << f.extern_definition_uses_old_buffer_t() << " ";
+        serialize_expr(f.extern_definition_proxy_expr(), s, params);
+    }
+    if (f.has_pure_definition()) {
+        s << "|pure ";
+        serialize_definition(f.definition(), s, params);
+    }
+    for (const Definition &def : f.updates()) {
+        s << "|update ";
+        serialize_definition(def, s, params);
+    }
+
+    const FuncSchedule &sched = f.schedule();
+    s << "|sched " << sched.memoized() << " " << sched.async()
+      << " " << (int)sched.memory_type()
+      << " " << sched.store_level().to_string()
+      << " " << sched.compute_level().to_string();
+    for (const StorageDim &d : sched.storage_dims()) {
+        s << "|storage " << d.var << " ";
+        serialize_expr(d.alignment, s, params);
+        s << " ";
+        serialize_expr(d.fold_factor, s, params);
+        s << " " << d.fold_forward;
+    }
+    for (const Bound &b : sched.bounds()) {
+        s << "|bound " << b.var << " ";
+        serialize_expr(b.min, s, params);
+        s << " ";
+        serialize_expr(b.extent, s, params);
+        s << " ";
+        serialize_expr(b.modulus, s, params);
+        s << " ";
+        serialize_expr(b.remainder, s, params);
+    }
+    for (const auto &w : sched.wrappers()) {
+        s << "|wrapper " << w.first << " " << Function(w.second).name();
+    }
+    s << "|trace " << f.is_tracing_loads() << f.is_tracing_stores() << f.is_tracing_realizations();
+}
+
+/** Compute a key that uniquely describes the result of lowering a
+ * pipeline: the environment of Functions (definitions and schedules),
+ * the referenced parameters, the target, the function name, and the
+ * arguments. Two compilations with equal keys produce the same
+ * Module, so the lowered Module can be reused. */
+string lowered_module_cache_key(const vector<Function> &outputs,
+                                const string &fn_name,
+                                const Target &target,
+                                const vector<Argument> &args,
+                                Internal::LoweredFunc::LinkageType linkage_type,
+                                const vector<Expr> &requirements) {
+    std::map<string, Function> env;
+    for (const Function &f : outputs) {
+        std::map<string, Function> more_funcs = find_transitive_calls(f);
+        env.insert(more_funcs.begin(), more_funcs.end());
+    }
+
+    std::ostringstream key;
+    key << fn_name << "|" << target.to_string() << "|" << (int)linkage_type;
+    for (const Argument &arg : args) {
+        key << "|arg " << arg.name << " " << (int)arg.kind
+            << " " << (int)arg.dimensions << " " << arg.type;
+    }
+    for (const Function &f : outputs) {
+        key << "|output " << f.name();
+    }
+    for (const Expr &r : requirements) {
+        key << "|require " << r;
+    }
+    SerializeReferencedParameters params;
+    for (const auto &it : env) {
+        serialize_function(it.second, key, params);
+    }
+    key << params.out.str();
+    return key.str();
+}
+
+// A process-wide cache of lowered Modules. Schedule exploration (e.g.
+// an autotuning loop) tends to revisit schedules; when the cache key
+// above matches we can skip lowering entirely. Bounded FIFO so we
+// don't accumulate every Module ever lowered.
+std::mutex lowered_module_cache_mutex;
+std::map<string, Module> lowered_module_cache;
+vector<string> lowered_module_cache_order;
+const size_t lowered_module_cache_size = 64;
+
+}  // namespace
+
 Module Pipeline::compile_to_module(const vector<Argument> &args,
                                    const string &fn_name,
                                    const Target &target,
@@ -383,7 +671,36 @@ Module Pipeline::compile_to_module(const vector<Argument> &args,
             custom_passes.push_back(p.pass);
         }
 
-        contents->module = lower(contents->outputs, new_fn_name, target, lowering_args, linkage_type, custom_passes);
+        // Custom lowering passes are opaque function pointers, so we
+        // can't include their effect in a cache key.
+        const bool use_lowering_cache = custom_passes.empty();
+        string cache_key;
+        if (use_lowering_cache) {
+            cache_key = lowered_module_cache_key(contents->outputs, new_fn_name,
+                                                 target, lowering_args, linkage_type,
+                                                 contents->requirements);
+            std::lock_guard<std::mutex> lock(lowered_module_cache_mutex);
+            auto iter = lowered_module_cache.find(cache_key);
+            if (iter != lowered_module_cache.end()) {
+                debug(2) << "Reusing cached lowered module for " << new_fn_name << "\n";
+                contents->module = iter->second;
+                return contents->module;
+            }
+        }
+
+        contents->module = lower(contents->outputs, new_fn_name, target, lowering_args, linkage_type,
+                                 custom_passes, contents->requirements);
+
+        if (use_lowering_cache) {
+            std::lock_guard<std::mutex> lock(lowered_module_cache_mutex);
+            if (lowered_module_cache.emplace(cache_key, contents->module).second) {
+                lowered_module_cache_order.push_back(cache_key);
+                if (lowered_module_cache_order.size() > lowered_module_cache_size) {
+                    lowered_module_cache.erase(lowered_module_cache_order.front());
+                    lowered_module_cache_order.erase(lowered_module_cache_order.begin());
+                }
+            }
+        }
     }
 
     return contents->module;
@@ -522,6 +839,19 @@ const vector<CustomLoweringPass> &Pipeline::custom_lowering_passes() {
     return contents->custom_lowering_passes;
 }
 
+void Pipeline::add_requirement(Expr condition) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    user_assert(condition.defined()) << "Requirement is undefined\n";
+    user_assert(condition.type().is_bool()) << "Requirement must be a boolean expression\n";
+    contents->invalidate_cache();
+    contents->requirements.push_back(std::move(condition));
+}
+
+const vector<Expr> &Pipeline::requirements() const {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    return contents->requirements;
+}
+
 const JITHandlers &Pipeline::jit_handlers() {
     user_assert(defined()) << "Pipeline is undefined\n";
     return contents->jit_handlers;
@@ -546,6 +876,57 @@ Realization Pipeline::realize(vector<int32_t> sizes,
     return r;
 }
 
+Realization Pipeline::realize(vector<int32_t> sizes, RealizationPool &pool,
+                              const Target &target) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+
+    std::ostringstream key_stream;
+    key_stream << target.to_string();
+    for (int32_t s : sizes) {
+        key_stream << ";" << s;
+    }
+    for (auto &out : contents->outputs) {
+        user_assert(out.has_pure_definition() || out.has_extern_definition()) <<
+            "Can't realize Pipeline with undefined output Func: " << out.name() << ".\n";
+        for (Type t : out.output_types()) {
+            key_stream << ";" << t;
+        }
+    }
+
+    vector<vector<Buffer<>>> &sets = pool.entries[key_stream.str()];
+    vector<Buffer<>> *bufs = nullptr;
+    for (auto &set : sets) {
+        bool all_free = true;
+        for (auto &b : set) {
+            all_free &= b.unique();
+        }
+        if (all_free) {
+            bufs = &set;
+            break;
+        }
+    }
+    if (bufs == nullptr) {
+        // Every cached set is still referenced by the caller, or this
+        // is the first realization with this signature. Allocate a
+        // fresh set and add it to the pool.
+        vector<Buffer<>> fresh;
+        for (auto &out : contents->outputs) {
+            for (Type t : out.output_types()) {
+                fresh.emplace_back(t, sizes);
+            }
+        }
+        sets.push_back(std::move(fresh));
+        bufs = &sets.back();
+    }
+
+    Realization r(*bufs);
+    realize(r, target);
+    for (size_t i = 0; i < r.size(); i++) {
+        r[i].copy_to_host();
+    }
+    return r;
+}
+
 Realization Pipeline::realize(int x_size, int y_size, int z_size, int w_size,
                               const Target &target) {
     return realize({x_size, y_size, z_size, w_size}, target);
@@ -810,6 +1191,71 @@ Pipeline::make_externs_jit_module(const Target &target,
     return result;
 }
 
+vector<Region> Pipeline::infer_stale_regions(const string &input, const Region &changed) {
+    user_assert(defined()) << "Can't query an undefined Pipeline\n";
+
+    Box changed_box;
+    for (const Range &r : changed) {
+        user_assert(r.min.defined() && r.extent.defined())
+            << "The changed input region passed to infer_stale_regions"
+            << " must have defined bounds in every dimension\n";
+        changed_box.push_back(Interval(r.min, r.min + r.extent - 1));
+    }
+
+    std::map<string, Box> stale =
+        Internal::infer_stale_regions(contents->outputs, input, changed_box);
+
+    vector<Region> result;
+    for (const Function &f : contents->outputs) {
+        Region region;
+        auto iter = stale.find(f.name());
+        for (int d = 0; d < f.dimensions(); d++) {
+            if (iter == stale.end()) {
+                // Unaffected: an empty range in every dimension.
+                region.push_back(Range(0, 0));
+            } else if (iter->second[d].is_bounded()) {
+                Expr min = simplify(iter->second[d].min);
+                Expr extent = simplify(iter->second[d].max - iter->second[d].min + 1);
+                region.push_back(Range(min, extent));
+            } else {
+                // Unbounded: the whole dimension may be stale.
+                region.push_back(Range());
+            }
+        }
+        result.push_back(region);
+    }
+    return result;
+}
+
+void Pipeline::realize_region(Realization dst, const Region &region, const Target &target) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+
+    vector<Buffer<>> cropped;
+    for (size_t i = 0; i < dst.size(); i++) {
+        Buffer<> b = dst[i];
+        user_assert((int)region.size() <= b.dimensions())
+            << "The region passed to realize_region has " << region.size()
+            << " dimensions, but output buffer " << i << " has only "
+            << b.dimensions() << "\n";
+        for (size_t d = 0; d < region.size(); d++) {
+            const Range &r = region[d];
+            if (!r.min.defined() && !r.extent.defined()) {
+                // Whole dimension.
+                continue;
+            }
+            const int64_t *min = as_const_int(r.min);
+            const int64_t *extent = as_const_int(r.extent);
+            user_assert(min && extent)
+                << "The region passed to realize_region must have"
+                << " constant integer bounds in every dimension\n";
+            b = Buffer<>(b.cropped((int)d, (int)*min, (int)*extent));
+        }
+        cropped.push_back(b);
+    }
+    Realization cropped_realization(cropped);
+    realize(cropped_realization, target);
+}
+
 void Pipeline::realize(Realization dst, const Target &t) {
     Target target = t;
     user_assert(defined()) << "Can't realize an undefined Pipeline\n";
@@ -901,7 +1347,8 @@ void Pipeline::realize(Realization dst, const Target &t) {
     debug(2) << "Back from jitted function. Exit status was " << exit_status << "\n";
 
     // If we're profiling, report runtimes and reset profiler stats.
-    if (target.has_feature(Target::Profile)) {
+    if (target.has_feature(Target::Profile) ||
+        target.has_feature(Target::ProfileLoops)) {
         JITModule::Symbol report_sym =
             contents->jit_module.find_symbol_by_name("halide_profiler_report");
         JITModule::Symbol reset_sym =
@@ -919,12 +1366,184 @@ void Pipeline::realize(Realization dst, const Target &t) {
     jit_context.finalize(exit_status);
 }
 
-void Pipeline::infer_input_bounds(Realization dst) {
+void Pipeline::realize_streaming(Realization dst, int slab_extent, const Target &t) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+    user_assert(dst.size() > 0) << "Realization is empty\n";
+
+    // All output buffers must agree on the dimension we're going to
+    // slice up.
+    int d = dst[0].dimensions() - 1;
+    user_assert(d >= 0) << "Can't stream a zero-dimensional output\n";
+    int min = dst[0].dim(d).min();
+    int extent = dst[0].dim(d).extent();
+    for (size_t i = 1; i < dst.size(); i++) {
+        user_assert(dst[i].dimensions() == d + 1 &&
+                    dst[i].dim(d).min() == min &&
+                    dst[i].dim(d).extent() == extent)
+            << "All output buffers passed to realize_streaming must share "
+            << "the same bounds in their outermost dimension\n";
+    }
 
-    Target target = get_jit_target_from_environment();
+    if (slab_extent <= 0) {
+        // Pick a slab extent so that a slab of output roughly fits in
+        // the last level cache. The intermediates needed for a slab
+        // are typically within a constant factor of the slab itself,
+        // so this keeps the working set near-resident without
+        // re-paying boundary overlap any more often than needed.
+        int64_t bytes_per_slice = 0;
+        for (size_t i = 0; i < dst.size(); i++) {
+            int64_t b = dst[i].type().bytes();
+            for (int j = 0; j < d; j++) {
+                b *= dst[i].dim(j).extent();
+            }
+            bytes_per_slice += b;
+        }
+        if (bytes_per_slice < 1) {
+            bytes_per_slice = 1;
+        }
+        const int64_t *llc = as_const_int(MachineParams::generic().last_level_cache_size);
+        internal_assert(llc);
+        slab_extent = (int)std::max((int64_t)1, *llc / bytes_per_slice);
+    }
+    if (slab_extent > extent) {
+        slab_extent = extent;
+    }
 
-    vector<const void *> args = prepare_jit_call_arguments(dst, target);
+    debug(2) << "Streaming realization in slabs of " << slab_extent
+             << " over [" << min << ", " << min + extent << ")\n";
+
+    for (int slab_min = min; slab_min < min + extent; slab_min += slab_extent) {
+        int this_extent = std::min(slab_extent, min + extent - slab_min);
+        vector<Buffer<>> slab;
+        for (size_t i = 0; i < dst.size(); i++) {
+            slab.push_back(Buffer<>(dst[i].cropped(d, slab_min, this_extent)));
+        }
+        realize(Realization(slab), t);
+    }
+}
+
+void Pipeline::realize_interpreted(Realization dst) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+
+    for (size_t i = 0; i < dst.size(); i++) {
+        user_assert(dst[i].data() != nullptr)
+            << "Buffer at " << &(dst[i]) << " is unallocated. "
+            << "The Buffers in a Realization passed to realize_interpreted must all be allocated\n";
+    }
+
+    // Lower for the host, but stop there: the whole point is to
+    // avoid LLVM. compile_to_module caches the lowered module, so
+    // repeated calls only pay for lowering once.
+    Target target = get_host_target();
+
+    infer_arguments();
+    vector<Argument> args;
+    for (const InferredArgument &arg : contents->inferred_args) {
+        args.push_back(arg.arg);
+    }
+
+    size_t num_outputs = 0;
+    for (Function f : contents->outputs) {
+        num_outputs += f.output_types().size();
+    }
+    user_assert(dst.size() == num_outputs)
+        << "Realization contains wrong number of Images (" << dst.size()
+        << ") for realizing pipeline with " << num_outputs << " outputs\n";
+
+    string name = generate_function_name();
+    Module module = compile_to_module(args, name, target);
+    Internal::LoweredFunc fn = module.get_function_by_name(name);
+
+    // Bind argument values the same way a JIT call would: inferred
+    // args first, then the outputs.
+    contents->user_context_arg.param.set_scalar((void *)nullptr);
+    vector<const void *> arg_values;
+    for (const InferredArgument &arg : contents->inferred_args) {
+        if (arg.param.defined() && arg.param.is_buffer()) {
+            Buffer<> buf = arg.param.buffer();
+            arg_values.push_back(buf.defined() ? (const void *)buf.raw_buffer() : nullptr);
+        } else if (arg.param.defined()) {
+            arg_values.push_back(arg.param.scalar_address());
+        } else {
+            internal_assert(arg.buffer.defined());
+            arg_values.push_back(arg.buffer.raw_buffer());
+        }
+    }
+    for (size_t i = 0; i < dst.size(); i++) {
+        arg_values.push_back(dst[i].raw_buffer());
+    }
+
+    debug(2) << "Interpreting " << name << "\n";
+    interpret(fn, arg_values);
+}
 
+Realization Pipeline::realize_interpreted(vector<int32_t> sizes) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    vector<Buffer<>> bufs;
+    for (auto &out : contents->outputs) {
+        user_assert(out.has_pure_definition() || out.has_extern_definition()) <<
+            "Can't realize Pipeline with undefined output Func: " << out.name() << ".\n";
+        for (Type t : out.output_types()) {
+            bufs.emplace_back(t, sizes);
+        }
+    }
+    Realization r(bufs);
+    realize_interpreted(r);
+    return r;
+}
+
+namespace {
+
+// Serialize everything the inferred bounds can depend on -- the
+// shapes of the bound buffers (including the outputs) and the values
+// of the scalar parameters -- into a vector usable as a cache
+// key. Returns false if some argument can't be keyed reliably.
+bool build_bounds_query_key(const vector<InferredArgument> &inferred_args,
+                            const vector<const void *> &args,
+                            vector<uint64_t> *key) {
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i] == nullptr) {
+            // An unbound input: one of the things being queried.
+            key->push_back(0);
+            continue;
+        }
+        if (i < inferred_args.size()) {
+            const InferredArgument &ia = inferred_args[i];
+            if (ia.param.defined() && !ia.param.is_buffer()) {
+                if (ia.param.type().is_handle()) {
+                    // Opaque pointers (e.g. the user context) can't
+                    // feed into bounds arithmetic, so their values
+                    // don't belong in the key.
+                    key->push_back(1);
+                    continue;
+                }
+                uint64_t bits = 0;
+                int bytes = ia.param.type().bytes();
+                if (bytes > (int)sizeof(bits)) {
+                    return false;
+                }
+                memcpy(&bits, args[i], bytes);
+                key->push_back(2);
+                key->push_back(bits);
+                continue;
+            }
+        }
+        const halide_buffer_t *buf = (const halide_buffer_t *)args[i];
+        key->push_back(3);
+        key->push_back((uint64_t)buf->dimensions);
+        for (int d = 0; d < buf->dimensions; d++) {
+            key->push_back((uint64_t)(uint32_t)buf->dim[d].min);
+            key->push_back((uint64_t)(uint32_t)buf->dim[d].extent);
+            key->push_back((uint64_t)(uint32_t)buf->dim[d].stride);
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+vector<vector<halide_dimension_t>> Pipeline::run_bounds_query(
+        vector<const void *> &args, const vector<size_t> &query_indices) {
     struct TrackedBuffer {
         // The query buffer, and a backup to check for changes. We
         // want wrappers around actual buffer_ts so that we can copy
@@ -934,24 +1553,14 @@ void Pipeline::infer_input_bounds(Realization dst) {
     };
     vector<TrackedBuffer> tracked_buffers(args.size());
 
-    vector<size_t> query_indices;
-    for (size_t i = 0; i < contents->inferred_args.size(); i++) {
-        if (args[i] == nullptr) {
-            query_indices.push_back(i);
-            InferredArgument ia = contents->inferred_args[i];
-            internal_assert(ia.param.defined() && ia.param.is_buffer());
-            // Make some empty Buffers of the right dimensionality
-            vector<int> initial_shape(ia.param.dimensions(), 0);
-            tracked_buffers[i].query = Runtime::Buffer<>(ia.param.type(), nullptr, initial_shape);
-            tracked_buffers[i].orig = Runtime::Buffer<>(ia.param.type(), nullptr, initial_shape);
-            args[i] = tracked_buffers[i].query.raw_buffer();
-        }
-    }
-
-    // No need to query if all the inputs are bound already.
-    if (query_indices.empty()) {
-        debug(1) << "All inputs are bound. No need for bounds inference\n";
-        return;
+    for (size_t i : query_indices) {
+        InferredArgument ia = contents->inferred_args[i];
+        internal_assert(ia.param.defined() && ia.param.is_buffer());
+        // Make some empty Buffers of the right dimensionality
+        vector<int> initial_shape(ia.param.dimensions(), 0);
+        tracked_buffers[i].query = Runtime::Buffer<>(ia.param.type(), nullptr, initial_shape);
+        tracked_buffers[i].orig = Runtime::Buffer<>(ia.param.type(), nullptr, initial_shape);
+        args[i] = tracked_buffers[i].query.raw_buffer();
     }
 
     JITFuncCallContext jit_context(jit_handlers(), contents->user_context_arg.param);
@@ -995,17 +1604,99 @@ void Pipeline::infer_input_bounds(Realization dst) {
 
     debug(1) << "Bounds inference converged after " << iter << " iterations\n";
 
-    // Now allocate the resulting buffers
+    vector<vector<halide_dimension_t>> shapes;
     for (size_t i : query_indices) {
-        InferredArgument ia = contents->inferred_args[i];
+        Runtime::Buffer<> &q = tracked_buffers[i].query;
+        vector<halide_dimension_t> shape(q.raw_buffer()->dim,
+                                         q.raw_buffer()->dim + q.dimensions());
+        shapes.push_back(std::move(shape));
+    }
+    return shapes;
+}
+
+void Pipeline::infer_input_bounds(Realization dst) {
+
+    Target target = get_jit_target_from_environment();
+
+    vector<const void *> args = prepare_jit_call_arguments(dst, target);
+
+    vector<size_t> query_indices;
+    for (size_t i = 0; i < contents->inferred_args.size(); i++) {
+        if (args[i] == nullptr) {
+            query_indices.push_back(i);
+        }
+    }
+
+    // No need to query if all the inputs are bound already.
+    if (query_indices.empty()) {
+        debug(1) << "All inputs are bound. No need for bounds inference\n";
+        return;
+    }
+
+    // Repeated queries with the same output shapes and scalar
+    // parameter values produce the same bounds, so replay a cached
+    // answer if we have one rather than invoking the pipeline.
+    vector<uint64_t> key;
+    bool cacheable = build_bounds_query_key(contents->inferred_args, args, &key);
+
+    vector<vector<halide_dimension_t>> shapes;
+    auto cached = cacheable ?
+        contents->bounds_query_cache.find(key) :
+        contents->bounds_query_cache.end();
+    if (cacheable && cached != contents->bounds_query_cache.end()) {
+        debug(1) << "Replaying inferred input bounds from the cache\n";
+        shapes = cached->second;
+    } else {
+        shapes = run_bounds_query(args, query_indices);
+        if (cacheable) {
+            contents->bounds_query_cache[key] = shapes;
+        }
+    }
+
+    // Now allocate the resulting buffers
+    for (size_t j = 0; j < query_indices.size(); j++) {
+        InferredArgument ia = contents->inferred_args[query_indices[j]];
         internal_assert(!ia.param.buffer().defined());
 
         // Allocate enough memory with the right type and dimensionality.
-        tracked_buffers[i].query.allocate();
+        Runtime::Buffer<> buf(ia.param.type(), nullptr,
+                              (int)shapes[j].size(), shapes[j].data());
+        buf.allocate();
 
         // Bind this parameter to this buffer, giving away the
         // buffer. The user retrieves it via ImageParam::get.
-        ia.param.set_buffer(Buffer<>(std::move(tracked_buffers[i].query)));
+        ia.param.set_buffer(Buffer<>(std::move(buf)));
+    }
+}
+
+void Pipeline::infer_input_bounds_batch(const std::vector<Realization> &dsts) {
+    user_assert(defined()) << "Can't infer input bounds on an undefined Pipeline.\n";
+
+    Target target = get_jit_target_from_environment();
+
+    for (const Realization &dst : dsts) {
+        vector<const void *> args = prepare_jit_call_arguments(dst, target);
+
+        vector<size_t> query_indices;
+        for (size_t i = 0; i < contents->inferred_args.size(); i++) {
+            if (args[i] == nullptr) {
+                query_indices.push_back(i);
+            }
+        }
+        if (query_indices.empty()) {
+            continue;
+        }
+
+        vector<uint64_t> key;
+        if (!build_bounds_query_key(contents->inferred_args, args, &key)) {
+            // Not cacheable, so there's nothing useful to do ahead
+            // of time.
+            continue;
+        }
+        if (contents->bounds_query_cache.count(key)) {
+            continue;
+        }
+        contents->bounds_query_cache[key] = run_bounds_query(args, query_indices);
     }
 }
 
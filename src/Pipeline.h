@@ -7,6 +7,7 @@
  * pipeline.
  */
 
+#include <map>
 #include <vector>
 
 #include "AutoSchedule.h"
@@ -55,6 +56,8 @@ struct JITExtern;
 
 /** A class representing a Halide pipeline. Constructed from the Func
  * or Funcs that it outputs. */
+class RealizationPool;
+
 class Pipeline {
     Internal::IntrusivePtr<PipelineContents> contents;
 
@@ -85,6 +88,31 @@ public:
                                      const MachineParams &arch_params = MachineParams::generic());
     //@}
 
+    /** Save the schedules of all Funcs in the pipeline to a text file,
+     * and load and apply schedules saved that way, replacing whatever
+     * schedules the Funcs currently carry. This allows schedules (e.g.
+     * found by an autotuner) to be shipped as data and applied to a
+     * Generator at build time without recompiling it. Only schedules
+     * whose split factors and storage directives are integer constants
+     * can be saved. */
+    //@{
+    EXPORT void save_schedule(const std::string &filename);
+    EXPORT void load_schedule(const std::string &filename);
+    //@}
+
+    /** Interleave the loop nests of this pipeline's outputs into a
+     * single traversal, so that outputs which read the same inputs
+     * walk over them once instead of once per output. The outputs
+     * must all be pure (no update definitions), have the same
+     * dimensionality, and be realized over the same region; the
+     * latter is enforced with a runtime check on the output buffers.
+     * The fused loop nest takes its structure from the first output's
+     * schedule (parallelize or vectorize that one); the remaining
+     * outputs must have loop nests that match the first's dimension
+     * for dimension, which in practice means leaving their schedules
+     * alone. */
+    EXPORT Pipeline &fuse_outputs();
+
     /** Return handle to the index-th Func within the pipeline based on the
      * realization order. */
     EXPORT Func get_func(size_t index);
@@ -169,6 +197,21 @@ public:
      * doing. */
     EXPORT void print_loop_nest();
 
+    /** Quickly check the schedules of this Pipeline's Funcs for gross
+     * errors without running lowering. Catches most malformed
+     * schedules - outputs not scheduled compute_root, compute_at or
+     * store_at levels that name loops that do not exist or that can
+     * never enclose the uses of the Func, store levels inside compute
+     * levels, impure Funcs scheduled inline, and device APIs not
+     * enabled in the target - in well under a millisecond, where a
+     * full compile would take seconds to hit the same error. Useful
+     * in autotuning loops to cheaply reject illegal candidate
+     * schedules before compiling them. Throws an error on failure,
+     * just as the equivalent checks during lowering do. A schedule
+     * that passes may still be rejected by the more thorough checks
+     * during lowering. */
+    EXPORT void validate_schedule(const Target &target = get_target_from_environment());
+
     /** Compile to object file and header pair, with the given
      * arguments. */
     EXPORT void compile_to_file(const std::string &filename_prefix,
@@ -351,9 +394,38 @@ public:
     /** Get the custom lowering passes. */
     EXPORT const std::vector<CustomLoweringPass> &custom_lowering_passes();
 
+    /** Declare that the given boolean condition must be true whenever
+     * this Pipeline runs, e.g.
+     *
+     \code
+     p.add_requirement(input.width() == input.height());
+     p.add_requirement(output.dim(1).stride() == output.width());
+     \endcode
+     *
+     * A runtime check is injected at the top of the pipeline (calling
+     * halide_error_requirement_failed and aborting if it fails, like
+     * any other assert), and in exchange the compiler gets to assume
+     * the condition when lowering: equalities that the solver can put
+     * into var == expr form are substituted through the pipeline, so
+     * address math that is equal only because of the requirement folds
+     * together at compile time. The condition must only reference
+     * parameters of the pipeline, not Vars or Funcs. */
+    EXPORT void add_requirement(Expr condition);
+
+    /** Get the requirements added via add_requirement. */
+    EXPORT const std::vector<Expr> &requirements() const;
+
     /** See Func::realize */
     // @{
     EXPORT Realization realize(std::vector<int32_t> sizes, const Target &target = Target());
+
+    /** Evaluate this Pipeline as above, drawing the output buffers
+     * from the given pool. Repeated realizations with the same output
+     * shapes, types, and target recycle their output allocations
+     * (including any device copies) instead of allocating fresh
+     * storage each call. */
+    EXPORT Realization realize(std::vector<int32_t> sizes, RealizationPool &pool,
+                               const Target &target = Target());
     EXPORT Realization realize(int x_size, int y_size, int z_size, int w_size,
                                const Target &target = Target());
     EXPORT Realization realize(int x_size, int y_size, int z_size,
@@ -376,16 +448,81 @@ public:
      * back from the GPU. */
     EXPORT void realize(Realization dst, const Target &target = Target());
 
+    /** The inverse of the usual bounds query: given that a region of
+     * one of the pipeline's inputs (named by its ImageParam or input
+     * Buffer) has changed, compute a conservative region of each
+     * output whose values may have become stale. Returns one Region
+     * per output Func, in output order. A Range with an undefined min
+     * and extent means the whole of that dimension may be stale; a
+     * Range with extent zero means nothing in that output is. Use
+     * with realize_region to recompute just the stale part of a
+     * previously-realized output after an input edit. */
+    EXPORT std::vector<Internal::Region> infer_stale_regions(const std::string &input,
+                                                             const Internal::Region &changed);
+
+    /** Evaluate this Pipeline over just a region of some existing
+     * allocated output buffers, leaving points outside the region
+     * untouched. The region is expressed in output coordinates with
+     * constant integer bounds; a Range with an undefined min and
+     * extent spans the whole of that dimension. Trailing dimensions
+     * may be omitted and span fully. The same region is applied to
+     * every output buffer. */
+    EXPORT void realize_region(Realization dst, const Internal::Region &region,
+                               const Target &target = Target());
+
+    /** Evaluate this Pipeline into existing buffers, iterating over
+     * the outermost dimension of the output in slabs rather than
+     * realizing it in one shot. The peak memory used for intermediates
+     * is what one slab needs, not what the whole output needs, so
+     * pipelines whose intermediates wouldn't fit in RAM (or in cache)
+     * can stream through outputs of any size. Producers whose stencils
+     * straddle a slab boundary are recomputed per slab, so bigger
+     * slabs amortize better but use more memory.
+     *
+     * If slab_extent is zero a slab size is picked so that a slab of
+     * output roughly fits in the last level cache. All output buffers
+     * must share the same bounds in their outermost dimension. Enable
+     * the allocation pool (halide_set_allocation_pool_size) to also
+     * recycle the intermediate allocations between slabs. */
+    EXPORT void realize_streaming(Realization dst, int slab_extent = 0,
+                                  const Target &target = Target());
+
+    /** Evaluate this Pipeline by interpreting its lowered IR
+     * directly, without JIT compilation. Starts in milliseconds
+     * where the JIT takes seconds, but runs orders of magnitude
+     * slower, which is the right trade when iterating on
+     * correctness with small test images, and makes a useful oracle
+     * when debugging codegen: the interpreter and the compiled
+     * pipeline should agree (floating point math may differ in the
+     * last ulp). Parallel loops run serially. Schedules that need a
+     * backend (GPU, Hexagon) or call external code are rejected. The
+     * lowered IR is cached, so only the first call pays for
+     * lowering. */
+    // @{
+    EXPORT void realize_interpreted(Realization dst);
+    EXPORT Realization realize_interpreted(std::vector<int32_t> sizes);
+    // @}
+
     /** For a given size of output, or a given set of output buffers,
      * determine the bounds required of all unbound ImageParams
      * referenced. Communicates the result by allocating new buffers
      * of the appropriate size and binding them to the unbound
-     * ImageParams. */
+     * ImageParams. The results are cached per (output shape, scalar
+     * parameter values), so repeated queries with shapes already seen
+     * replay the stored answer without running the pipeline's bounds
+     * query code. */
     // @{
     EXPORT void infer_input_bounds(int x_size = 0, int y_size = 0, int z_size = 0, int w_size = 0);
     EXPORT void infer_input_bounds(Realization dst);
     // @}
 
+    /** Warm the bounds inference cache for a batch of output shapes
+     * (e.g. every distinct tile shape a tiled harness is going to
+     * ask for) in one call, without binding any input buffers.
+     * Subsequent calls to infer_input_bounds with any of these
+     * shapes are replays from the cache. */
+    EXPORT void infer_input_bounds_batch(const std::vector<Realization> &dsts);
+
     /** Infer the arguments to the Pipeline, sorted into a canonical order:
      * all buffers (sorted alphabetically by name), followed by all non-buffers
      * (sorted alphabetically by name).
@@ -406,6 +543,38 @@ public:
 
 private:
     std::string generate_function_name() const;
+
+    /** Run the bounds-query protocol for a prepared argument list,
+     * returning the converged shape of each unbound input buffer (in
+     * the order given by query_indices). Replaces the null entries
+     * of args with temporary query buffers while running. */
+    std::vector<std::vector<halide_dimension_t>> run_bounds_query(
+        std::vector<const void *> &args,
+        const std::vector<size_t> &query_indices);
+};
+
+/** A pool of output buffers for repeated JIT realizations. Passing
+ * one to Pipeline::realize makes calls with matching output shapes,
+ * types, and target draw their output storage from the pool instead
+ * of allocating it fresh, which matters for interactive tools that
+ * realize the same pipeline every frame. A pooled buffer is only
+ * reused once the caller has dropped all references to the
+ * Realization it was last returned in, so a caller that holds the
+ * previous frame's output while realizing the next one settles into
+ * double-buffering. */
+class RealizationPool {
+    // Cached buffer sets, keyed by target, output types, and
+    // shape. Each key may hold several sets, as callers can keep
+    // multiple realizations live at once.
+    std::map<std::string, std::vector<std::vector<Buffer<>>>> entries;
+
+    friend class Pipeline;
+public:
+    /** Drop the pool's references to all buffers it holds. Buffers
+     * still referenced by a Realization remain valid. */
+    void clear() {
+        entries.clear();
+    }
 };
 
 struct ExternSignature {
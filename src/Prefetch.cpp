@@ -6,6 +6,7 @@
 #include "Bounds.h"
 #include "ExprUsesVar.h"
 #include "IRMutator.h"
+#include "IROperator.h"
 #include "Scope.h"
 #include "Simplify.h"
 #include "Util.h"
@@ -31,10 +32,14 @@ const Definition &get_stage_definition(const Function &f, int stage_num) {
 class CollectExternalBufferBounds : public IRVisitor {
 public:
     map<string, Box> buffers;
+    map<string, Parameter> buffer_params;
 
     using IRVisitor::visit;
 
     void add_buffer_bounds(const string &name, Buffer<> image, Parameter param, int dims) {
+        if (param.defined()) {
+            buffer_params.emplace(name, param);
+        }
         Box b;
         for (int i = 0; i < dims; ++i) {
             string dim_name = std::to_string(i);
@@ -60,14 +65,36 @@ public:
     }
 };
 
+// Detects inner loops that still exist at runtime. Vectorized and
+// unrolled loops compile away into straight-line code, so for the
+// purpose of picking the loop level at which to auto-prefetch they are
+// transparent: a serial row loop over a vectorized column loop is the
+// innermost level whose footprint actually moves iteration to
+// iteration.
+class HasInnerDynamicFor : public IRVisitor {
+    using IRVisitor::visit;
+    void visit(const For *op) override {
+        if (op->for_type != ForType::Vectorized &&
+            op->for_type != ForType::Unrolled) {
+            result = true;
+        }
+        IRVisitor::visit(op);
+    }
+public:
+    bool result = false;
+};
+
 class InjectPrefetch : public IRMutator2 {
 public:
-    InjectPrefetch(const map<string, Function> &e, const map<string, Box> &buffers)
-        : env(e), external_buffers(buffers), current_func(nullptr), stage(-1) { }
+    InjectPrefetch(const map<string, Function> &e, const map<string, Box> &buffers,
+                   const map<string, Parameter> &params)
+        : env(e), external_buffers(buffers), external_params(params),
+          current_func(nullptr), stage(-1) { }
 
 private:
     const map<string, Function> &env;
     const map<string, Box> &external_buffers;
+    const map<string, Parameter> &external_params;
     const Function *current_func;
     int stage;
     Scope<Interval> scope;
@@ -216,6 +243,28 @@ private:
         return Block::make({prefetch, body});
     }
 
+    /** Pick a prefetch distance from the footprint a single loop
+     * iteration reads from a buffer: far enough ahead that a useful
+     * amount of data is in flight, but no further than necessary,
+     * lest the prefetched data be evicted again before use. */
+    Expr auto_prefetch_distance(const Box &box, Type t) {
+        // Aim to have roughly this many bytes in flight.
+        const int64_t bytes_ahead = 512;
+        int64_t footprint = t.bytes();
+        for (size_t i = 0; i < box.size(); i++) {
+            Expr extent = simplify(box[i].max - box[i].min + 1);
+            const int64_t *e = as_const_int(extent);
+            if (!e || *e <= 0) {
+                // Can't size the footprint statically; fetch one
+                // iteration ahead.
+                return 1;
+            }
+            footprint *= *e;
+        }
+        int64_t d = std::max((int64_t)1, bytes_ahead / footprint);
+        return (int)std::min(d, (int64_t)8);
+    }
+
     Stmt visit(const For *op) override {
         const Function *old_func = current_func;
         int old_stage = stage;
@@ -230,17 +279,73 @@ private:
             body = mutate(op->body);
         }
 
-        if (!prefetch_list.empty()) {
-            // If there are multiple prefetches of the same Func or ImageParam,
-            // use the most recent one
-            set<string> seen;
-            for (int i = prefetch_list.size() - 1; i >= 0; --i) {
-                const PrefetchDirective &p = prefetch_list[i];
-                if (!ends_with(op->name, "." + p.var) || (seen.find(p.name) != seen.end())) {
-                    continue;
+        // If there are multiple prefetches of the same Func or ImageParam,
+        // use the most recent one
+        vector<PrefetchDirective> to_inject;
+        set<string> seen;
+        for (int i = prefetch_list.size() - 1; i >= 0; --i) {
+            const PrefetchDirective &p = prefetch_list[i];
+            if (!ends_with(op->name, "." + p.var) || (seen.find(p.name) != seen.end())) {
+                continue;
+            }
+            seen.insert(p.name);
+            to_inject.push_back(p);
+        }
+
+        // In the innermost dynamic serial loops of Funcs scheduled
+        // with auto_prefetch, synthesize a directive for each external
+        // buffer whose footprint moves with the loop and that isn't
+        // already prefetched explicitly. A loop whose only inner loops
+        // are vectorized or unrolled counts as innermost, so a row
+        // loop over a vectorized column loop prefetches the next rows'
+        // footprint while the current row is computed. On Hexagon this
+        // lowers to the asynchronous l2fetch engine, which stages the
+        // next row into L2 concurrently with HVX compute.
+        if (current_func &&
+            current_func->schedule().auto_prefetch() &&
+            op->for_type == ForType::Serial) {
+            HasInnerDynamicFor inner;
+            op->body.accept(&inner);
+            if (!inner.result) {
+                map<string, Box> boxes_read;
+                {
+                    ScopedBinding<Interval> bind(scope, op->name, Interval(loop_var, loop_var));
+                    boxes_read = boxes_required(body, scope);
+                }
+                for (const auto &b : boxes_read) {
+                    if (seen.find(b.first) != seen.end()) {
+                        continue;
+                    }
+                    const auto &param_it = external_params.find(b.first);
+                    if (param_it == external_params.end()) {
+                        continue;
+                    }
+                    bool varies = false;
+                    for (size_t i = 0; i < b.second.size(); i++) {
+                        if (expr_uses_var(b.second[i].min, op->name)) {
+                            varies = true;
+                            break;
+                        }
+                    }
+                    if (!varies) {
+                        continue;
+                    }
+                    PrefetchDirective p;
+                    p.name = b.first;
+                    p.var = op->name.substr(op->name.rfind('.') + 1);
+                    p.offset = auto_prefetch_distance(b.second, param_it->second.type());
+                    p.strategy = PrefetchBoundStrategy::GuardWithIf;
+                    p.param = param_it->second;
+                    debug(3) << "Auto-prefetching " << p.name << " in loop " << op->name
+                             << " at distance " << p.offset << "\n";
+                    to_inject.push_back(p);
+                    seen.insert(b.first);
                 }
-                seen.insert(p.name);
+            }
+        }
 
+        {
+            for (const PrefetchDirective &p : to_inject) {
                 // Add loop variable + prefetch offset to interval scope for box computation
                 Expr fetch_at = loop_var + p.offset;
                 map<string, Box> boxes_rw;
@@ -411,15 +516,85 @@ public:
     SplitPrefetch(Expr bytes) : max_byte_size(bytes) {}
 };
 
+// Limit how many bytes each prefetch of a scheduled buffer stages by
+// splitting the prefetch's outermost dimension into slabs, keeping
+// the dimensionality of the call. Used on targets whose prefetch is a
+// block descriptor rather than a cache-line touch: the slab size
+// bounds how long each issued fetch occupies the engine, so fetching
+// a large region pipelines with the compute consuming it.
+class SlabPrefetch : public IRMutator2 {
+    using IRMutator2::visit;
+
+    const map<string, Expr> &bytes_per_fetch;
+
+    Stmt visit(const Evaluate *op) override {
+        Stmt stmt = IRMutator2::visit(op);
+        op = stmt.as<Evaluate>();
+        internal_assert(op);
+        const Call *call = op->value.as<Call>();
+        if (!call || !call->is_intrinsic(Call::prefetch)) {
+            return stmt;
+        }
+
+        const Variable *base = call->args[0].as<Variable>();
+        internal_assert(base && base->type.is_handle());
+        auto it = bytes_per_fetch.find(base->name);
+        if (it == bytes_per_fetch.end()) {
+            // Tuple-valued Funcs prefetch their component buffers.
+            size_t dot = base->name.rfind('.');
+            if (dot != string::npos) {
+                it = bytes_per_fetch.find(base->name.substr(0, dot));
+            }
+            if (it == bytes_per_fetch.end()) {
+                return stmt;
+            }
+        }
+
+        size_t i = call->args.size() - 2;
+        Expr extent = call->args[i];
+        Expr stride = call->args[i + 1];
+        Expr stride_bytes = stride * call->type.bytes();
+        if (!can_prove(stride_bytes > 0)) {
+            // Leave descending or degenerate prefetches alone.
+            return stmt;
+        }
+
+        Expr rows_per_slab = simplify(max(it->second / stride_bytes, 1));
+        if (can_prove(extent <= rows_per_slab)) {
+            return stmt;
+        }
+
+        string index_name = "prefetch_slab_" + base->name;
+        Expr outer_var = Variable::make(Int(32), index_name);
+        Expr base_row = outer_var * rows_per_slab;
+
+        vector<Expr> args = call->args;
+        args[1] = simplify(call->args[1] + base_row * stride);
+        args[i] = simplify(min(rows_per_slab, extent - base_row));
+        Expr outer_extent = simplify((extent + rows_per_slab - 1) / rows_per_slab);
+
+        stmt = Evaluate::make(Call::make(call->type, Call::prefetch, args, Call::Intrinsic));
+        stmt = For::make(index_name, 0, outer_extent,
+                         ForType::Serial, DeviceAPI::None, stmt);
+        debug(5) << "\nSplit prefetch into slabs of " << it->second << " bytes:\n"
+                 << "Before:\n" << Expr(call) << "\nAfter:\n" << stmt << "\n";
+        return stmt;
+    }
+
+public:
+    SlabPrefetch(const map<string, Expr> &bytes_per_fetch)
+        : bytes_per_fetch(bytes_per_fetch) {}
+};
+
 } // anonymous namespace
 
 Stmt inject_prefetch(Stmt s, const map<string, Function> &env) {
     CollectExternalBufferBounds finder;
     s.accept(&finder);
-    return InjectPrefetch(env, finder.buffers).mutate(s);
+    return InjectPrefetch(env, finder.buffers, finder.buffer_params).mutate(s);
 }
 
-Stmt reduce_prefetch_dimension(Stmt stmt, const Target &t) {
+Stmt reduce_prefetch_dimension(Stmt stmt, const Target &t, const map<string, Function> &env) {
     size_t max_dim = 0;
     Expr max_byte_size;
 
@@ -443,6 +618,29 @@ Stmt reduce_prefetch_dimension(Stmt stmt, const Target &t) {
         // If the max byte size is specified, we may need to tile
         // the prefetch
         stmt = SplitPrefetch(max_byte_size).mutate(stmt);
+    } else {
+        // Only block-prefetch targets honor bytes_per_fetch;
+        // cache-line targets were already split to line granularity
+        // above.
+        map<string, Expr> bytes_per_fetch;
+        for (const auto &iter : env) {
+            const Function &f = iter.second;
+            for (const PrefetchDirective &p : f.definition().schedule().prefetches()) {
+                if (p.bytes_per_fetch.defined()) {
+                    bytes_per_fetch[p.name] = p.bytes_per_fetch;
+                }
+            }
+            for (const Definition &def : f.updates()) {
+                for (const PrefetchDirective &p : def.schedule().prefetches()) {
+                    if (p.bytes_per_fetch.defined()) {
+                        bytes_per_fetch[p.name] = p.bytes_per_fetch;
+                    }
+                }
+            }
+        }
+        if (!bytes_per_fetch.empty()) {
+            stmt = SlabPrefetch(bytes_per_fetch).mutate(stmt);
+        }
     }
     return stmt;
 }
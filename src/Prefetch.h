@@ -20,8 +20,11 @@ Stmt inject_prefetch(Stmt s, const std::map<std::string, Function> &env);
  * (max dimension of the prefetch is specified by target architecture).
  * This keeps the 'max_dim' innermost dimensions and adds loops for the rest
  * of the dimensions. If maximum prefetched-byte-size is specified (depending
- * on the architecture), this also adds an outer loops that tile the prefetches. */
-Stmt reduce_prefetch_dimension(Stmt stmt, const Target &t);
+ * on the architecture), this also adds an outer loops that tile the prefetches.
+ * On targets whose prefetch is a block descriptor (Hexagon's l2fetch), also
+ * splits prefetches whose directive schedules a bytes_per_fetch into slabs of
+ * at most that size, so fetching pipelines with the compute consuming it. */
+Stmt reduce_prefetch_dimension(Stmt stmt, const Target &t, const std::map<std::string, Function> &env);
 
 }
 }
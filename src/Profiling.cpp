@@ -19,6 +19,23 @@ using std::map;
 using std::string;
 using std::vector;
 
+// Specialization branches are counted via an extern call injected
+// when the loop nests are built (see build_provide_loop_nest in
+// ScheduleFunctions.cpp). Those calls can't run inside device code,
+// where the profiler state is unreachable, so strip any that ended up
+// there (e.g. in a Func computed inside a GPU loop).
+class StripSpecializationHits : public IRMutator2 {
+    using IRMutator2::visit;
+
+    Stmt visit(const Evaluate *op) override {
+        const Call *call = op->value.as<Call>();
+        if (call && call->name == "halide_profiler_specialization_hit") {
+            return Evaluate::make(0);
+        }
+        return IRMutator2::visit(op);
+    }
+};
+
 class InjectProfiling : public IRMutator2 {
 public:
     map<string, int> indices;   // maps from func name -> index in buffer.
@@ -27,7 +44,8 @@ public:
 
     string pipeline_name;
 
-    InjectProfiling(const string &pipeline_name) : pipeline_name(pipeline_name) {
+    InjectProfiling(const string &pipeline_name, bool profile_loops)
+        : pipeline_name(pipeline_name), profile_loops(profile_loops) {
         indices["overhead"] = 0;
         stack.push_back(0);
     }
@@ -47,6 +65,10 @@ private:
 
     bool profiling_memory = true;
 
+    // Whether to bill samples to individual loops rather than just
+    // whole Funcs (the ProfileLoops target feature).
+    bool profile_loops;
+
     // Strip down the tuple name, e.g. f.0 into f
     string normalize_name(const string &name) {
         vector<string> v = split_string(name, ".");
@@ -67,6 +89,21 @@ private:
         return idx;
     }
 
+    int get_loop_id(const string &name) {
+        // Like get_func_id, but without normalizing the name: the
+        // full loop name identifies the loop's position in the nest,
+        // which is what the hierarchical report keys off.
+        int idx = -1;
+        map<string, int>::iterator iter = indices.find(name);
+        if (iter == indices.end()) {
+            idx = (int)indices.size();
+            indices[name] = idx;
+        } else {
+            idx = iter->second;
+        }
+        return idx;
+    }
+
     Expr compute_allocation_size(const vector<Expr> &extents,
                                  const Expr &condition,
                                  const Type &type,
@@ -140,7 +177,8 @@ private:
             new_expr.same_as(op->new_expr)) {
             stmt = op;
         } else {
-            stmt = Allocate::make(op->name, op->type, new_extents, condition, body, new_expr, op->free_function);
+            stmt = Allocate::make(op->name, op->type, new_extents, condition, body,
+                                  new_expr, op->free_function, op->memory_type);
         }
 
         if (!is_zero(size) && !on_stack && profiling_memory) {
@@ -214,6 +252,20 @@ private:
     Stmt visit(const For *op) override {
         Stmt body = op->body;
 
+        // When profiling at loop granularity, bill time spent in this
+        // loop's body to the loop itself rather than the enclosing
+        // Func. Vectorized and unrolled loops compile away, so they
+        // are treated as part of whatever loop contains them.
+        int loop_id = -1;
+        if (profile_loops &&
+            (op->device_api == DeviceAPI::None ||
+             op->device_api == DeviceAPI::Host) &&
+            op->for_type != ForType::Vectorized &&
+            op->for_type != ForType::Unrolled) {
+            loop_id = get_loop_id(op->name);
+            stack.push_back(loop_id);
+        }
+
         // The for loop indicates a device transition or a
         // parallel job launch. Decrement the number of active
         // threads outside the loop, and increment it inside the
@@ -241,7 +293,7 @@ private:
             // which means we can't do memory accounting.
             bool old_profiling_memory = profiling_memory;
             profiling_memory = false;
-            body = mutate(body);
+            body = mutate(StripSpecializationHits().mutate(body));
             profiling_memory = old_profiling_memory;
 
             // Get the profiler state pointer from scratch inside the
@@ -254,11 +306,31 @@ private:
                    op->device_api == DeviceAPI::Host) {
             body = mutate(body);
         } else {
-            body = op->body;
+            body = StripSpecializationHits().mutate(op->body);
+        }
+
+        if (loop_id >= 0) {
+            stack.pop_back();
+            Expr profiler_token = Variable::make(Int(32), "profiler_token");
+            // This inlines to a single store, but runs on every
+            // iteration, which is why loop-level profiling is a
+            // separate opt-in feature.
+            Expr set_loop = Call::make(Int(32), "halide_profiler_set_current_func",
+                                       {state, profiler_token, loop_id}, Call::Extern);
+            body = Block::make(Evaluate::make(set_loop), body);
         }
 
         Stmt stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
 
+        if (loop_id >= 0) {
+            // After the loop, fall back to billing the enclosing loop
+            // (or Func).
+            Expr profiler_token = Variable::make(Int(32), "profiler_token");
+            Expr set_enclosing = Call::make(Int(32), "halide_profiler_set_current_func",
+                                            {state, profiler_token, stack.back()}, Call::Extern);
+            stmt = Block::make(stmt, Evaluate::make(set_enclosing));
+        }
+
         if (update_active_threads) {
             stmt = Block::make({decr_active_threads, stmt, incr_active_threads});
         }
@@ -266,8 +338,8 @@ private:
     }
 };
 
-Stmt inject_profiling(Stmt s, string pipeline_name) {
-    InjectProfiling profiling(pipeline_name);
+Stmt inject_profiling(Stmt s, string pipeline_name, const Target &t) {
+    InjectProfiling profiling(pipeline_name, t.has_feature(Target::ProfileLoops));
     s = profiling.mutate(s);
 
     int num_funcs = (int)(profiling.indices.size());
@@ -25,6 +25,7 @@
  */
 
 #include "IR.h"
+#include "Target.h"
 
 namespace Halide {
 namespace Internal {
@@ -35,8 +36,14 @@ namespace Internal {
  * times and counts will be logged at the end. Should be done before
  * storage flattening, but after all bounds inference.
  *
+ * With the ProfileLoops target feature, samples are additionally
+ * attributed to individual loops within each Func (e.g. a vectorized
+ * steady state vs. a scalar tail), and the report shows them indented
+ * under the Funcs they belong to. This adds a store per iteration of
+ * each instrumented loop, so it perturbs fast inner loops more than
+ * per-Func profiling does.
  */
-Stmt inject_profiling(Stmt, std::string);
+Stmt inject_profiling(Stmt, std::string, const Target &t);
 
 }
 }
@@ -10,79 +10,96 @@ using std::string;
 
 namespace {
 
-// Some randomly-generated integers.
-#define C0 576942909
-#define C1 1121052041
-#define C2 1040796640
-
-// Permute a 32-bit unsigned integer using a fixed psuedorandom
-// permutation.
-Expr rng32(Expr x) {
-    internal_assert(x.type() == UInt(32));
-
-    // A polynomial P with coefficients C0 .. CN induces a permutation
-    // modulo 2^d iff:
-    // 1) P(0) != P(1) modulo 2
-    // 2) sum(i * Ci) is odd
-
-    // (See http://en.wikipedia.org/wiki/Permutation_polynomial#Rings_Z.2FpkZ)
-
-    // For a quadratic, this is only satisfied by:
-    // C0 anything
-    // C1 odd
-    // C2 even
-
-    // The coefficients defined above were chosen to satisfy this
-    // property.
-
-    // It's pretty random, but note that the quadratic term disappears
-    // if inputs are the multiples of 2^16, and so you get a linear
-    // sequence.  However, *that* linear sequence probably varies in
-    // the low bits, so if you run in through the permutation again,
-    // you should break it up. All actual use of this runs it through
-    // multiple times in order to combine several inputs, so it should
-    // be ok. The other flaw is it's a permutation, so you get no
-    // collisions. Birthday paradox be damned.
+// This is a counter-based generator: the input expressions (the pure
+// coordinates of the call site, plus a per-call-site tag) are folded
+// into a single 32-bit counter, which is then scrambled by a fixed
+// finalizer. The value at a point is a pure function of the
+// coordinates and the tag, so it is stable no matter how the
+// surrounding loops are scheduled - splitting, reordering,
+// vectorizing, or parallelizing a Func does not change the random
+// stream it sees. There are also no dependencies between the values
+// at adjacent points, so under vectorization each lane just hashes
+// its own counter, using nothing but 32-bit muls, xors and shifts.
+
+// The finalizer constants. These are the "lowbias32" hash of Steele
+// and Vigna's style, found by exhaustive search over this xorshift /
+// multiply construction for near-ideal avalanche behavior, meaning
+// flipping any input bit flips each output bit with probability very
+// close to one half. That gives us:
+// - The correct moments for a uniform distribution
+// - No serial correlations in any of the bits
+// - A flat power spectrum
+// - No visible patterns
+// So, good enough for image processing.
+#define M0 0x7feb352d
+#define M1 0x846ca68b
+
+// The multiplier used to give each coordinate a distinct weight in
+// the counter (the odd part of 2^32 / phi, so successive weights are
+// well spread).
+#define PHI 0x9e3779b9
+
+uint32_t mix32_const(uint32_t x) {
+    x ^= x >> 16;
+    x *= M0;
+    x ^= x >> 15;
+    x *= M1;
+    x ^= x >> 16;
+    return x;
+}
 
-    // However, it's exceedingly cheap to compute, as it only uses
-    // vectorizable int32 muls and adds, and the resulting numbers:
-    // - Have the correct moments for a uniform distribution
-    // - Have no serial correlations in any of the bits
-    // - Have a completely flat power spectrum
-    // - Have no visible patterns
+Expr xor_shift_right(Expr x, int s) {
+    string name = unique_name('R');
+    Expr var = Variable::make(UInt(32), name);
+    return Let::make(name, x, var ^ (var >> s));
+}
 
-    // So I declare this good enough for image processing.
+// Scramble a 32-bit counter with the finalizer above.
+Expr mix32(Expr x) {
+    internal_assert(x.type() == UInt(32));
 
     // If it's just a const (which it often is), save the simplifier some work:
     if (const uint64_t *i = as_const_uint(x)) {
-        return make_const(UInt(32), ((C2 * (*i)) + C1) * (*i) + C0);
+        return make_const(UInt(32), mix32_const((uint32_t)(*i)));
     }
 
-    return (((C2 * x) + C1) * x) + C0;
+    x = xor_shift_right(x, 16);
+    x = x * make_const(UInt(32), M0);
+    x = xor_shift_right(x, 15);
+    x = x * make_const(UInt(32), M1);
+    x = xor_shift_right(x, 16);
+    return x;
 }
 
 }
 
 Expr random_int(const vector<Expr> &e) {
     internal_assert(e.size());
-    internal_assert(e[0].type() == Int(32) || e[0].type() == UInt(32));
-    // Permute the first term
-    Expr result = rng32(cast(UInt(32), e[0]));
-    for (size_t i = 1; i < e.size(); i++) {
+
+    // Fold the terms into the counter with distinct weights. This is
+    // just a linear combination - all the scrambling is done by the
+    // single finalizer at the end, so there is no hash chain to
+    // serialize the terms.
+    Expr counter;
+    const uint64_t *ic = nullptr;
+    for (size_t i = 0; i < e.size(); i++) {
         internal_assert(e[i].type() == Int(32) || e[i].type() == UInt(32));
-        // Add in the next term and permute again
-        string name = unique_name('R');
+        if (i == 0) {
+            counter = cast(UInt(32), e[0]);
+            ic = as_const_uint(counter);
+            continue;
+        }
         // If it's a const, save the simplifier some work
-        const uint64_t *ir = as_const_uint(result);
         const uint64_t *ie = as_const_uint(e[i]);
-        if (ir && ie) {
-            result = rng32(make_const(UInt(32), (*ir) + (*ie)));
+        if (ic && ie) {
+            counter = make_const(UInt(32), (uint32_t)((*ic) * PHI + (*ie)));
+            ic = as_const_uint(counter);
         } else {
-            result = Let::make(name, result + cast<uint32_t>(e[i]),
-                               rng32(Variable::make(UInt(32), name)));
+            counter = counter * make_const(UInt(32), PHI) + cast<uint32_t>(e[i]);
+            ic = nullptr;
         }
     }
-    return result;
+    return mix32(counter);
 }
 
 Expr random_float(const vector<Expr> &e) {
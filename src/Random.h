@@ -17,7 +17,15 @@ Expr random_float(const std::vector<Expr> &);
 
 /** Return a random unsigned integer between zero and 2^32-1 that
  * varies deterministically based on the input expressions (which must
- * be integers or unsigned integers). */
+ * be integers or unsigned integers).
+ *
+ * The implementation is a counter-based generator: the inputs are
+ * folded into a 32-bit counter which is scrambled by a fixed hash.
+ * The result is a pure function of the inputs, so a random Func
+ * produces the same values at the same coordinates however it is
+ * scheduled; only changing the program (which reassigns call-site
+ * tags) changes the streams. Adjacent values have no dependencies on
+ * each other, so generation vectorizes. */
 Expr random_int(const std::vector<Expr> &);
 
 /** Convert calls to random() to IR generated by random_float and
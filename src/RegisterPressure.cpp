@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "RegisterPressure.h"
+#include "Debug.h"
+#include "Error.h"
+#include "IRVisitor.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// The size of the architectural vector register file. Approximate in
+// places (x86 counts the registers an unprivileged compiler can use),
+// but close enough to flag a schedule that wants several times this
+// many live values.
+int num_vector_registers(const Target &t) {
+    switch (t.arch) {
+    case Target::X86:
+        if (t.bits == 32) {
+            return 8;
+        }
+        if (t.features_any_of({Target::AVX512, Target::AVX512_KNL,
+                               Target::AVX512_Skylake, Target::AVX512_Cannonlake})) {
+            return 32;
+        }
+        return 16;
+    case Target::ARM:
+        return (t.bits == 64) ? 32 : 16;
+    case Target::MIPS:
+        return 32;
+    case Target::POWERPC:
+        return 32;
+    case Target::Hexagon:
+        return 32;
+    default:
+        return 16;
+    }
+}
+
+// A vector let's live range, in traversal order, and the number of
+// registers it occupies while live.
+struct LiveInterval {
+    int start, end;
+    int regs;
+};
+
+struct LoopRecord {
+    string name;
+    int start, end;
+    bool innermost;
+};
+
+// One walk over the Stmt collecting the live range of every
+// vector-typed let and the extent of every loop, against a clock that
+// ticks at each definition and use. Lets are the right unit to count
+// post-CSE: every value reused enough to matter has been given a
+// name, and what's left over is expression temporaries with
+// negligible live ranges.
+class CollectVectorLiveRanges : public IRVisitor {
+    using IRVisitor::visit;
+
+    int clock = 0;
+    // Bits in one vector register on this target.
+    int register_bits;
+    // Maps live let names to their interval. Names can repeat across
+    // disjoint scopes; a redefinition just closes the old interval.
+    map<string, size_t> active;
+
+    int regs_needed(Type type) {
+        return std::max(1, (type.bits() * type.lanes() + register_bits - 1) / register_bits);
+    }
+
+    template<typename LetOrLetStmt>
+    void visit_let(const LetOrLetStmt *op) {
+        op->value.accept(this);
+        bool track = op->value.type().is_vector();
+        if (track) {
+            active[op->name] = intervals.size();
+            intervals.push_back({clock, clock, regs_needed(op->value.type())});
+            clock++;
+        }
+        op->body.accept(this);
+        if (track) {
+            active.erase(op->name);
+        }
+    }
+
+    void visit(const Let *op) override {
+        visit_let(op);
+    }
+
+    void visit(const LetStmt *op) override {
+        visit_let(op);
+    }
+
+    void visit(const Variable *op) override {
+        auto it = active.find(op->name);
+        if (it != active.end()) {
+            intervals[it->second].end = clock;
+        }
+        clock++;
+    }
+
+    void visit(const For *op) override {
+        if (op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            // Device code has its own register file; it doesn't
+            // compete with the host loops around it.
+            return;
+        }
+        op->min.accept(this);
+        op->extent.accept(this);
+        size_t idx = loops.size();
+        loops.push_back({op->name, clock++, 0, true});
+        size_t nested_before = loops.size();
+        op->body.accept(this);
+        loops[idx].end = clock++;
+        loops[idx].innermost = (loops.size() == nested_before);
+    }
+
+public:
+    vector<LiveInterval> intervals;
+    vector<LoopRecord> loops;
+
+    CollectVectorLiveRanges(const Target &t)
+        : register_bits(t.natural_vector_size(UInt(8)) * 8) {}
+};
+
+// The peak number of registers occupied at once within [start, end].
+int peak_pressure(const vector<LiveInterval> &intervals, int start, int end) {
+    // Sweep the interval endpoints: +regs at each start, -regs one
+    // past each end.
+    vector<std::pair<int, int>> events;
+    for (const LiveInterval &l : intervals) {
+        if (l.end < start || l.start > end) {
+            continue;
+        }
+        events.push_back({std::max(l.start, start), l.regs});
+        events.push_back({std::min(l.end, end) + 1, -l.regs});
+    }
+    std::sort(events.begin(), events.end());
+    int pressure = 0, peak = 0;
+    for (const auto &e : events) {
+        pressure += e.second;
+        peak = std::max(peak, pressure);
+    }
+    return peak;
+}
+
+}  // namespace
+
+void estimate_register_pressure(const Stmt &s, const Target &t) {
+    CollectVectorLiveRanges live(t);
+    s.accept(&live);
+    if (live.intervals.empty()) {
+        return;
+    }
+
+    const int available = num_vector_registers(t);
+    for (const LoopRecord &loop : live.loops) {
+        if (!loop.innermost) {
+            continue;
+        }
+        int pressure = peak_pressure(live.intervals, loop.start, loop.end);
+        if (pressure == 0) {
+            continue;
+        }
+        debug(1) << "Estimated vector register pressure in loop " << loop.name
+                 << ": " << pressure << " of " << available << "\n";
+        if (pressure > available) {
+            user_warning << "The schedule for loop " << loop.name
+                         << " keeps an estimated " << pressure
+                         << " vector registers live at once, but the target "
+                         << t.to_string() << " only has " << available
+                         << ". Expect heavy spilling; consider unrolling less "
+                         << "or vectorizing by a narrower factor.\n";
+        }
+    }
+}
+
+}
+}
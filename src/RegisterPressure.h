@@ -0,0 +1,30 @@
+#ifndef HALIDE_REGISTER_PRESSURE_H
+#define HALIDE_REGISTER_PRESSURE_H
+
+/** \file
+ * Defines an analysis that estimates vector register pressure in the
+ * inner loops of lowered code.
+ */
+
+#include "IR.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Estimate the number of vector registers live in each innermost
+ * loop of a fully lowered Stmt, and warn about loops whose estimate
+ * exceeds the target's vector register file. Schedules that combine
+ * wide vectorization with aggressive unrolling can need far more
+ * simultaneously live vector values than the target has registers;
+ * the resulting spills are easy to miss until benchmarks run. Run
+ * after CSE, when the values that will occupy registers appear as
+ * lets: the estimate counts each vector let as live from its
+ * definition to its last use. Analysis only; the Stmt is not
+ * changed. Per-loop estimates are reported at debug level 1. */
+void estimate_register_pressure(const Stmt &s, const Target &t);
+
+}
+}
+
+#endif
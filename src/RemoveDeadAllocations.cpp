@@ -53,7 +53,8 @@ class RemoveDeadAllocations : public IRMutator2 {
         } else if (body.same_as(op->body)) {
             return op;
         } else {
-            return Allocate::make(op->name, op->type, op->extents, op->condition, body, op->new_expr, op->free_function);
+            return Allocate::make(op->name, op->type, op->extents, op->condition, body,
+                                  op->new_expr, op->free_function, op->memory_type);
         }
     }
 
@@ -126,10 +126,27 @@ struct FuncScheduleContents {
     std::vector<Bound> estimates;
     std::map<std::string, Internal::FunctionPtr> wrappers;
     bool memoized;
+    bool fused_output;
+    bool async;
+    bool store_forwarding;
+    bool store_non_temporal;
+    bool store_interleaved;
+    bool software_pipeline;
+    bool auto_prefetch;
+    MemoryType memory_type;
+    std::string slide_over_loop;
+    std::string compute_with_func;
+    std::string compute_with_var;
+    int stream_readback_slices;
+    std::string skip_strips_var;
+    Expr skip_strips_predicate;
 
     FuncScheduleContents() :
         store_level(LoopLevel::inlined()), compute_level(LoopLevel::inlined()),
-        memoized(false) {};
+        memoized(false), fused_output(false), async(false), store_forwarding(false),
+        store_non_temporal(false), store_interleaved(false), software_pipeline(false),
+        auto_prefetch(false), memory_type(MemoryType::Auto),
+        stream_readback_slices(0) {};
 
     // Pass an IRMutator2 through to all Exprs referenced in the FuncScheduleContents
     void mutate(IRMutator2 *mutator) {
@@ -161,6 +178,9 @@ struct FuncScheduleContents {
                 b.remainder = mutator->mutate(b.remainder);
             }
         }
+        if (skip_strips_predicate.defined()) {
+            skip_strips_predicate = mutator->mutate(skip_strips_predicate);
+        }
     }
 };
 
@@ -186,8 +206,11 @@ struct StageScheduleContents {
     std::vector<PrefetchDirective> prefetches;
     bool touched;
     bool allow_race_conditions;
+    bool atomic;
+    int scatter_buffer_slots;
 
-    StageScheduleContents() : touched(false), allow_race_conditions(false) {};
+    StageScheduleContents() : touched(false), allow_race_conditions(false), atomic(false),
+                              scatter_buffer_slots(0) {};
 
     // Pass an IRMutator2 through to all Exprs referenced in the StageScheduleContents
     void mutate(IRMutator2 *mutator) {
@@ -208,6 +231,9 @@ struct StageScheduleContents {
             if (p.offset.defined()) {
                 p.offset = mutator->mutate(p.offset);
             }
+            if (p.bytes_per_fetch.defined()) {
+                p.bytes_per_fetch = mutator->mutate(p.bytes_per_fetch);
+            }
         }
     }
 };
@@ -236,6 +262,20 @@ FuncSchedule FuncSchedule::deep_copy(
     copy.contents->bounds = contents->bounds;
     copy.contents->estimates = contents->estimates;
     copy.contents->memoized = contents->memoized;
+    copy.contents->fused_output = contents->fused_output;
+    copy.contents->async = contents->async;
+    copy.contents->store_forwarding = contents->store_forwarding;
+    copy.contents->store_non_temporal = contents->store_non_temporal;
+    copy.contents->store_interleaved = contents->store_interleaved;
+    copy.contents->software_pipeline = contents->software_pipeline;
+    copy.contents->auto_prefetch = contents->auto_prefetch;
+    copy.contents->memory_type = contents->memory_type;
+    copy.contents->slide_over_loop = contents->slide_over_loop;
+    copy.contents->compute_with_func = contents->compute_with_func;
+    copy.contents->compute_with_var = contents->compute_with_var;
+    copy.contents->stream_readback_slices = contents->stream_readback_slices;
+    copy.contents->skip_strips_var = contents->skip_strips_var;
+    copy.contents->skip_strips_predicate = contents->skip_strips_predicate;
 
     // Deep-copy wrapper functions.
     for (const auto &iter : contents->wrappers) {
@@ -255,6 +295,118 @@ bool FuncSchedule::memoized() const {
     return contents->memoized;
 }
 
+bool &FuncSchedule::fused_output() {
+    return contents->fused_output;
+}
+
+bool FuncSchedule::fused_output() const {
+    return contents->fused_output;
+}
+
+bool &FuncSchedule::async() {
+    return contents->async;
+}
+
+bool FuncSchedule::async() const {
+    return contents->async;
+}
+
+bool &FuncSchedule::store_forwarding() {
+    return contents->store_forwarding;
+}
+
+bool FuncSchedule::store_forwarding() const {
+    return contents->store_forwarding;
+}
+
+bool &FuncSchedule::store_non_temporal() {
+    return contents->store_non_temporal;
+}
+
+bool FuncSchedule::store_non_temporal() const {
+    return contents->store_non_temporal;
+}
+
+bool &FuncSchedule::store_interleaved() {
+    return contents->store_interleaved;
+}
+
+bool FuncSchedule::store_interleaved() const {
+    return contents->store_interleaved;
+}
+
+bool &FuncSchedule::software_pipeline() {
+    return contents->software_pipeline;
+}
+
+bool FuncSchedule::software_pipeline() const {
+    return contents->software_pipeline;
+}
+
+bool &FuncSchedule::auto_prefetch() {
+    return contents->auto_prefetch;
+}
+
+bool FuncSchedule::auto_prefetch() const {
+    return contents->auto_prefetch;
+}
+
+std::string &FuncSchedule::slide_over_loop() {
+    return contents->slide_over_loop;
+}
+
+const std::string &FuncSchedule::slide_over_loop() const {
+    return contents->slide_over_loop;
+}
+
+std::string &FuncSchedule::compute_with_func() {
+    return contents->compute_with_func;
+}
+
+const std::string &FuncSchedule::compute_with_func() const {
+    return contents->compute_with_func;
+}
+
+std::string &FuncSchedule::compute_with_var() {
+    return contents->compute_with_var;
+}
+
+const std::string &FuncSchedule::compute_with_var() const {
+    return contents->compute_with_var;
+}
+
+int &FuncSchedule::stream_readback_slices() {
+    return contents->stream_readback_slices;
+}
+
+int FuncSchedule::stream_readback_slices() const {
+    return contents->stream_readback_slices;
+}
+
+std::string &FuncSchedule::skip_strips_var() {
+    return contents->skip_strips_var;
+}
+
+const std::string &FuncSchedule::skip_strips_var() const {
+    return contents->skip_strips_var;
+}
+
+Expr &FuncSchedule::skip_strips_predicate() {
+    return contents->skip_strips_predicate;
+}
+
+Expr FuncSchedule::skip_strips_predicate() const {
+    return contents->skip_strips_predicate;
+}
+
+MemoryType &FuncSchedule::memory_type() {
+    return contents->memory_type;
+}
+
+MemoryType FuncSchedule::memory_type() const {
+    return contents->memory_type;
+}
+
 std::vector<StorageDim> &FuncSchedule::storage_dims() {
     return contents->storage_dims;
 }
@@ -365,6 +517,8 @@ StageSchedule StageSchedule::get_copy() const {
     copy.contents->prefetches = contents->prefetches;
     copy.contents->touched = contents->touched;
     copy.contents->allow_race_conditions = contents->allow_race_conditions;
+    copy.contents->atomic = contents->atomic;
+    copy.contents->scatter_buffer_slots = contents->scatter_buffer_slots;
     return copy;
 }
 
@@ -416,6 +570,22 @@ bool StageSchedule::allow_race_conditions() const {
     return contents->allow_race_conditions;
 }
 
+bool &StageSchedule::atomic() {
+    return contents->atomic;
+}
+
+bool StageSchedule::atomic() const {
+    return contents->atomic;
+}
+
+int &StageSchedule::scatter_buffer_slots() {
+    return contents->scatter_buffer_slots;
+}
+
+int StageSchedule::scatter_buffer_slots() const {
+    return contents->scatter_buffer_slots;
+}
+
 void StageSchedule::accept(IRVisitor *visitor) const {
     for (const ReductionVariable &r : rvars()) {
         if (r.min.defined()) {
@@ -434,6 +604,9 @@ void StageSchedule::accept(IRVisitor *visitor) const {
         if (p.offset.defined()) {
             p.offset.accept(visitor);
         }
+        if (p.bytes_per_fetch.defined()) {
+            p.bytes_per_fetch.accept(visitor);
+        }
     }
 }
 
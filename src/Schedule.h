@@ -45,6 +45,19 @@ enum class TailStrategy {
      * case to handle the if statement. */
     GuardWithIf,
 
+    /** Like GuardWithIf, but the guard is not treated as a
+     * boundary condition, so no separate loop epilogue is
+     * generated. Instead the guard stays in the (vectorized)
+     * inner loop, where it becomes a predicate on the vector
+     * loads and stores. Always legal. Pros: no redundant
+     * re-evaluation, no code-size increase from tail-case
+     * handling, and the tail iterations stay vectorized on
+     * targets with masked loads and stores (e.g. x86 with AVX2 or
+     * AVX-512). Cons: on targets without masked operations the
+     * predicated operations scalarize, and even with them the
+     * steady-state iterations pay for evaluating the predicate. */
+    Predicate,
+
     /** Prevent evaluation beyond the original extent by shifting
      * the tail case inwards, re-evaluating some points near the
      * end. Only legal for pure variables in pure definitions. If
@@ -171,7 +184,7 @@ struct Split {
     Expr factor;
     bool exact; // Is it required that the factor divides the extent
                 // of the old var. True for splits of RVars. Forces
-                // tail strategy to be GuardWithIf.
+                // tail strategy to be GuardWithIf or Predicate.
     TailStrategy tail;
 
     enum SplitType {SplitVar = 0, RenameVar, FuseVars, PurifyRVar};
@@ -223,6 +236,7 @@ struct StorageDim {
     Expr alignment;
     Expr fold_factor;
     bool fold_forward;
+    Expr tile_extent;
 };
 
 struct PrefetchDirective {
@@ -230,6 +244,12 @@ struct PrefetchDirective {
     std::string var;
     Expr offset;
     PrefetchBoundStrategy strategy;
+    // On targets with a block prefetch engine (Hexagon's l2fetch),
+    // stage at most this many bytes per issued prefetch, so a large
+    // region is fetched in slabs that pipeline with the compute
+    // consuming it. Undefined means fetch the whole region with one
+    // descriptor. Ignored on targets that prefetch by cache line.
+    Expr bytes_per_fetch;
     // If it's a prefetch load from an image parameter, this points to that.
     Parameter param;
 };
@@ -267,6 +287,116 @@ public:
     bool memoized() const;
     // @}
 
+    /** This flag is set to true if this function is part of a group
+     * of pipeline outputs whose loop nests should be interleaved into
+     * a single traversal. See Pipeline::fuse_outputs. */
+    // @{
+    bool &fused_output();
+    bool fused_output() const;
+    // @}
+
+    /** This flag is set to true if the function should be run
+     * asynchronously with respect to its consumer, synchronized with
+     * a semaphore. */
+    // @{
+    bool &async();
+    bool async() const;
+    // @}
+
+    /** This flag is set to true if values loaded in this function's
+     * loops should be forwarded across loop iterations where
+     * possible, instead of being reloaded from memory. See
+     * Func::store_forwarding. */
+    // @{
+    bool &store_forwarding();
+    bool store_forwarding() const;
+    // @}
+
+    /** This flag is set to true if stores to this function's
+     * realization should bypass the cache using non-temporal store
+     * instructions where the target supports them. See
+     * Func::store_non_temporal. */
+    // @{
+    bool &store_non_temporal();
+    bool store_non_temporal() const;
+    // @}
+
+    /** This flag is set to true if the elements of this Tuple-valued
+     * function's realizations should be stored interleaved (AoS)
+     * rather than as separate planar allocations. See
+     * Func::store_interleaved. */
+    // @{
+    bool &store_interleaved();
+    bool store_interleaved() const;
+    // @}
+
+    /** This flag is set to true if this function's innermost serial
+     * loops should be software-pipelined, issuing the next
+     * iteration's loads an iteration early. See
+     * Func::software_pipeline. */
+    // @{
+    bool &software_pipeline();
+    bool software_pipeline() const;
+    // @}
+
+    /** This flag is set to true if prefetches should be inserted
+     * automatically for the external buffers read in this function's
+     * innermost loops, with the prefetch distance derived from the
+     * per-iteration footprint. See Func::auto_prefetch. */
+    // @{
+    bool &auto_prefetch();
+    bool auto_prefetch() const;
+    // @}
+
+    /** The name of a loop variable of this function's consumer that
+     * its computation must be slid over, reusing values computed by
+     * earlier iterations of that loop instead of recomputing them.
+     * Empty if sliding is left to the automatic analysis. See
+     * Func::slide_over. */
+    // @{
+    std::string &slide_over_loop();
+    const std::string &slide_over_loop() const;
+    // @}
+
+    /** The name of a sibling function whose loop nest this
+     * function's computation should be fused into, and the name of
+     * the pure variable of that sibling at which the two nests
+     * share loops. Empty if this function is computed in its own
+     * loop nest. See Func::compute_with. */
+    // @{
+    std::string &compute_with_func();
+    const std::string &compute_with_func() const;
+    std::string &compute_with_var();
+    const std::string &compute_with_var() const;
+    // @}
+
+    /** When non-zero, the read-back of this function from the device
+     * is divided into approximately this many slabs, each issued as
+     * soon as the producing loop has computed it so the transfer can
+     * overlap remaining device work. See Func::stream_readback. */
+    // @{
+    int &stream_readback_slices();
+    int stream_readback_slices() const;
+    // @}
+
+    /** The name of a loop variable of this function whose iterations
+     * should each be guarded by a runtime predicate, skipping the
+     * iteration entirely when the predicate evaluates true. Empty if
+     * no such guard was scheduled. See Func::skip_strips. */
+    // @{
+    std::string &skip_strips_var();
+    const std::string &skip_strips_var() const;
+    Expr &skip_strips_predicate();
+    Expr skip_strips_predicate() const;
+    // @}
+
+    /** The type of memory to use to back realizations of this
+     * function. See Func::store_in. */
+    // @{
+    MemoryType &memory_type();
+    MemoryType memory_type() const;
+    // @}
+
     /** The list and order of dimensions used to store this
      * function. The first dimension in the vector corresponds to the
      * innermost dimension for storage (i.e. which dimension is
@@ -388,6 +518,21 @@ public:
     bool &allow_race_conditions();
     // @}
 
+    /** Should scatter updates in this definition be lowered to atomic
+     * read-modify-write operations? See \ref Stage::atomic */
+    // @{
+    bool atomic() const;
+    bool &atomic();
+    // @}
+
+    /** The number of slots in the per-task write-combining buffer
+     * used for scatter updates in this definition, or zero if scatter
+     * buffering is disabled. See \ref Stage::scatter_buffered */
+    // @{
+    int scatter_buffer_slots() const;
+    int &scatter_buffer_slots();
+    // @}
+
     /** Pass an IRVisitor through to all Exprs referenced in the
      * Schedule. */
     void accept(IRVisitor *) const;
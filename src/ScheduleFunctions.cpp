@@ -1,9 +1,15 @@
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
 #include "ScheduleFunctions.h"
 #include "IROperator.h"
 #include "Simplify.h"
 #include "Substitute.h"
 #include "ExprUsesVar.h"
 #include "Var.h"
+#include "FindCalls.h"
+#include "WrapCalls.h"
 #include "Qualify.h"
 #include "IRMutator.h"
 #include "Target.h"
@@ -13,6 +19,7 @@
 #include "Func.h"
 #include "ApplySplit.h"
 #include "IREquality.h"
+#include "Solve.h"
 
 namespace Halide {
 namespace Internal {
@@ -58,6 +65,18 @@ bool contains_impure_call(const Expr &expr) {
     return is_not_pure.result;
 }
 
+// Strip likely tags so the solver can see through a predicate.
+class StripLikelies : public IRMutator2 {
+    using IRMutator2::visit;
+    Expr visit(const Call *op) override {
+        if (op->is_intrinsic(Call::likely) ||
+            op->is_intrinsic(Call::likely_if_innermost)) {
+            return mutate(op->args[0]);
+        }
+        return IRMutator2::visit(op);
+    }
+};
+
 // Build a loop nest about a provide node using a schedule
 Stmt build_provide_loop_nest_helper(string func_name,
                                     string prefix,
@@ -211,6 +230,46 @@ Stmt build_provide_loop_nest_helper(string func_name,
             const Dim &dim = stage_s.dims()[nest[i].dim_idx];
             Expr min = Variable::make(Int(32), nest[i].name + ".loop_min");
             Expr extent = Variable::make(Int(32), nest[i].name + ".loop_extent");
+
+            // Try to prune the iteration space using the predicates
+            // this loop contains: solve each one for the loop
+            // variable and intersect the loop bounds with the region
+            // outside of which the predicate is definitely false. The
+            // guards stay in place to handle whatever the solver
+            // couldn't reason about.
+            if (dim.for_type == ForType::Serial) {
+                // Names defined inside this loop are not in scope in
+                // its bounds.
+                Scope<int> inner_names;
+                for (size_t j = i + 1; j < nest.size(); j++) {
+                    if (!nest[j].name.empty()) {
+                        inner_names.push(nest[j].name, 0);
+                    }
+                }
+                Expr loop_max = Variable::make(Int(32), nest[i].name + ".loop_max");
+                Expr tight_min = min, tight_max = loop_max;
+                for (size_t j = i + 1; j < nest.size(); j++) {
+                    if (nest[j].type != Container::If ||
+                        !expr_uses_var(nest[j].value, nest[i].name)) {
+                        continue;
+                    }
+                    Expr pred = StripLikelies().mutate(nest[j].value);
+                    Interval in = solve_for_outer_interval(pred, nest[i].name);
+                    if (in.has_lower_bound() &&
+                        !expr_uses_vars(in.min, inner_names)) {
+                        tight_min = Max::make(tight_min, in.min);
+                    }
+                    if (in.has_upper_bound() &&
+                        !expr_uses_vars(in.max, inner_names)) {
+                        tight_max = Min::make(tight_max, in.max);
+                    }
+                }
+                if (!tight_min.same_as(min) || !tight_max.same_as(loop_max)) {
+                    min = tight_min;
+                    extent = tight_max - tight_min + 1;
+                }
+            }
+
             stmt = For::make(nest[i].name, min, extent, dim.for_type, dim.device_api, stmt);
         }
     }
@@ -267,6 +326,7 @@ Stmt build_provide_loop_nest(string func_name,
                              const vector<string> &dims,
                              const FuncSchedule &f_sched,
                              const Definition &def,
+                             const Target &target,
                              bool is_update) {
 
     internal_assert(!is_update == def.is_init());
@@ -295,13 +355,131 @@ Stmt build_provide_loop_nest(string func_name,
 
     // Make any specialized copies
     const vector<Specialization> &specializations = def.specializations();
+
+    auto build_specialized_case = [&](const Specialization &s) {
+        Stmt then_case = build_provide_loop_nest(func_name, prefix, dims, f_sched, s.definition, target, is_update);
+        if (target.has_feature(Target::Profile)) {
+            // Count how many times this branch is taken, so that
+            // specialize() ladders can be reordered hottest-first
+            // based on observed workloads. The string arguments
+            // compile to global constants, which is how the
+            // profiler runtime tells branches apart.
+            std::ostringstream condition;
+            condition << s.condition;
+            string stage_name = prefix.substr(0, prefix.size() - 1);
+            Expr profiler_pipeline_state = Variable::make(Handle(), "profiler_pipeline_state");
+            Expr hit = Call::make(Int(32), "halide_profiler_specialization_hit",
+                                  {profiler_pipeline_state, stage_name, condition.str()},
+                                  Call::Extern);
+            then_case = Block::make(Evaluate::make(hit), then_case);
+        }
+        return then_case;
+    };
+
+    // If the chain ends with specialize_fail, and the specializations
+    // leading into it are equality tests on one integer Expr with
+    // distinct constants, they are mutually exclusive and their order
+    // doesn't matter, so they can dispatch by binary search instead
+    // of testing every condition in turn. The else case at each leaf
+    // is the failure assert, which is cheap enough to duplicate. Only
+    // worth it once the chain is longer than the tree is deep.
+    size_t num_tree_cases = 0;
+    Expr tree_key;
+    if (!specializations.empty() &&
+        !specializations.back().failure_message.empty()) {
+        set<int64_t> seen;
+        for (size_t i = specializations.size() - 1; i > 0; i--) {
+            const EQ *eq = specializations[i-1].condition.as<EQ>();
+            if (!eq || !eq->a.type().is_scalar() ||
+                !(eq->a.type().is_int() || eq->a.type().is_uint())) {
+                break;
+            }
+            // Accept the constant on either side.
+            Expr key = eq->a, val = eq->b;
+            if (as_const_int(key) || as_const_uint(key)) {
+                std::swap(key, val);
+            }
+            const int64_t *i_val = as_const_int(val);
+            const uint64_t *u_val = as_const_uint(val);
+            if ((!i_val && !u_val) ||
+                (tree_key.defined() && !equal(tree_key, key))) {
+                break;
+            }
+            if (!seen.insert(i_val ? *i_val : (int64_t)(*u_val)).second) {
+                // A repeated constant means the later test is dead,
+                // but reordering it isn't semantics-preserving.
+                break;
+            }
+            tree_key = key;
+            num_tree_cases++;
+        }
+    }
+    const size_t min_tree_cases = 4;
+    if (num_tree_cases >= min_tree_cases) {
+        size_t first = specializations.size() - 1 - num_tree_cases;
+        const Specialization &fail = specializations.back();
+        Expr specialize_fail_error =
+            Internal::Call::make(Int(32),
+                                 "halide_error_specialize_fail",
+                                 {StringImm::make(fail.failure_message)},
+                                 Internal::Call::Extern);
+        Stmt otherwise = AssertStmt::make(const_false(), specialize_fail_error);
+
+        // Gather the cases sorted by constant; unsigned constants
+        // sort as unsigned so the < pivots below agree.
+        vector<pair<Expr, Stmt>> cases;
+        for (size_t i = first; i < specializations.size() - 1; i++) {
+            cases.push_back({specializations[i].condition,
+                             build_specialized_case(specializations[i])});
+        }
+        auto case_value = [&](const pair<Expr, Stmt> &c) {
+            const EQ *eq = c.first.as<EQ>();
+            Expr val = as_const_int(eq->a) || as_const_uint(eq->a) ? eq->a : eq->b;
+            const int64_t *i_val = as_const_int(val);
+            uint64_t v = i_val ? (uint64_t)*i_val : *as_const_uint(val);
+            if (i_val && tree_key.type().is_int()) {
+                // Bias so that signed values sort correctly as uint64.
+                v += (uint64_t)1 << 63;
+            }
+            return v;
+        };
+        std::sort(cases.begin(), cases.end(),
+                  [&](const pair<Expr, Stmt> &a, const pair<Expr, Stmt> &b) {
+                      return case_value(a) < case_value(b);
+                  });
+
+        // Build a balanced search tree over the sorted cases.
+        std::function<Stmt(size_t, size_t)> build_tree =
+            [&](size_t lo, size_t hi) -> Stmt {
+            if (hi - lo == 1) {
+                return IfThenElse::make(cases[lo].first, cases[lo].second, otherwise);
+            }
+            size_t mid = lo + (hi - lo) / 2;
+            const EQ *eq = cases[mid].first.as<EQ>();
+            Expr pivot = as_const_int(eq->a) || as_const_uint(eq->a) ? eq->a : eq->b;
+            return IfThenElse::make(tree_key < pivot,
+                                    build_tree(lo, mid),
+                                    build_tree(mid, hi));
+        };
+        debug(3) << "Dispatching " << num_tree_cases << " specializations of "
+                 << func_name << " on " << tree_key << " via binary search\n";
+        stmt = build_tree(0, cases.size());
+
+        // Any specializations before the run still take priority, so
+        // they wrap the tree as an ordinary chain below.
+        for (size_t i = first; i > 0; i--) {
+            const Specialization &s = specializations[i-1];
+            stmt = IfThenElse::make(s.condition, build_specialized_case(s), stmt);
+        }
+        return stmt;
+    }
+
     for (size_t i = specializations.size(); i > 0; i--) {
         const Specialization &s = specializations[i-1];
         Expr c = s.condition;
-        const Definition &s_def = s.definition;
         Stmt then_case;
         if (s.failure_message.empty()) {
-            then_case = build_provide_loop_nest(func_name, prefix, dims, f_sched, s_def, is_update);
+            then_case = build_specialized_case(s);
         } else {
             internal_assert(equal(c, const_true()));
             // specialize_fail() should only be possible on the final specialization
@@ -361,6 +539,13 @@ Stmt build_produce(Function f, const Target &target) {
                         buffers_contents_to_annotate.push_back(buffer);
                     }
                 } else {
+                    user_assert(!f.extern_definition_requires_dense_buffers())
+                        << "Extern stage " << extern_name << " has declared that it requires "
+                        << "densely-packed buffers, but its input " << input.name()
+                        << " is stored at a different loop level than it is computed, "
+                        << "so it would be passed a strided crop. Either store "
+                        << input.name() << " at the level it is computed, or drop the "
+                        << "extern_requires_dense_buffers declaration.\n";
                     // Make a local crop of just the region required,
                     // in case the input was folded. We have no
                     // protocol for passing folded buffers to extern
@@ -453,6 +638,12 @@ Stmt build_produce(Function f, const Target &target) {
         } else {
             // Store level doesn't match compute level. Make an output
             // buffer just for this subregion.
+            user_assert(!f.extern_definition_requires_dense_buffers())
+                << "Extern stage " << extern_name << " has declared that it requires "
+                << "densely-packed buffers, but it is stored at a different loop level "
+                << "than it is computed, so its output would be a strided crop. Either "
+                << "store " << f.name() << " at the level it is computed, or drop the "
+                << "extern_requires_dense_buffers declaration.\n";
             string stage_name = f.name() + ".s0.";
             const vector<string> f_args = f.args();
             for (int j = 0; j < f.outputs(); j++) {
@@ -595,12 +786,12 @@ Stmt build_produce(Function f, const Target &target) {
 
         string prefix = f.name() + ".s0.";
         vector<string> dims = f.args();
-        return build_provide_loop_nest(f.name(), prefix, dims, f.schedule(), f.definition(), false);
+        return build_provide_loop_nest(f.name(), prefix, dims, f.schedule(), f.definition(), target, false);
     }
 }
 
 // Build the loop nests that update a function (assuming it's a reduction).
-vector<Stmt> build_update(Function f) {
+vector<Stmt> build_update(Function f, const Target &target) {
 
     vector<Stmt> updates;
 
@@ -610,7 +801,7 @@ vector<Stmt> build_update(Function f) {
         string prefix = f.name() + ".s" + std::to_string(i+1) + ".";
 
         vector<string> dims = f.args();
-        Stmt loop = build_provide_loop_nest(f.name(), prefix, dims, f.schedule(), def, true);
+        Stmt loop = build_provide_loop_nest(f.name(), prefix, dims, f.schedule(), def, target, true);
         updates.push_back(loop);
     }
 
@@ -619,7 +810,7 @@ vector<Stmt> build_update(Function f) {
 
 pair<Stmt, Stmt> build_production(Function func, const Target &target) {
     Stmt produce = build_produce(func, target);
-    vector<Stmt> updates = build_update(func);
+    vector<Stmt> updates = build_update(func, target);
 
     // Combine the update steps
     Stmt merged_updates = Block::make(updates);
@@ -733,9 +924,59 @@ private:
             // For the very first output to be scheduled, the consumer
             // Stmt will be a no-op. No point in preserving it.
             return producer;
-        } else {
-            return Block::make(producer, consumer);
         }
+
+        if (func.schedule().async()) {
+            user_assert(!is_output)
+                << "Can't schedule output Func " << func.name() << " as async().\n";
+            if (func.schedule().store_level() == func.schedule().compute_level()) {
+                return fork_async_producer(producer, consumer);
+            }
+            // A store level outside the compute level means the
+            // producer should span the consumer's loops and run ahead
+            // of it. That fork has to happen where the storage lives,
+            // and the loops between the two levels don't exist yet,
+            // so it's deferred to fork_async_producers (see
+            // AsyncProducers.cpp), which runs after bounds
+            // inference. Emit in order here.
+        }
+
+        return Block::make(producer, consumer);
+    }
+
+    // Run an async producer and its consumer as sibling tasks on the
+    // thread pool, handing the realization off through a
+    // semaphore. The producer signals the semaphore when it has
+    // finished writing the realization; the consumer acquires it
+    // before its first use, so anything else in the consumer at this
+    // loop level (e.g. other producers, or copies to or from a
+    // device) overlaps with the asynchronous production.
+    Stmt fork_async_producer(Stmt producer, Stmt consumer) {
+        string sem_name = func.name() + ".semaphore";
+        Expr sem_var = Variable::make(type_of<halide_semaphore_t *>(), sem_name);
+
+        Expr release = Call::make(Int(32), "halide_semaphore_release",
+                                  {sem_var, 1}, Call::Extern);
+        Expr acquire = Call::make(Int(32), "halide_semaphore_acquire",
+                                  {sem_var, 1}, Call::Extern);
+        producer = Block::make(producer, Evaluate::make(release));
+        consumer = Block::make(Evaluate::make(acquire), consumer);
+
+        // Express the fork as a parallel loop of extent two, so that
+        // the existing task-spawning machinery takes care of building
+        // the closure. Task zero is the producer; task one the
+        // consumer.
+        string fork_name = func.name() + ".__fork";
+        Expr fork_var = Variable::make(Int(32), fork_name);
+        Stmt body = IfThenElse::make(fork_var == 0, producer, consumer);
+        Stmt loop = For::make(fork_name, 0, 2, ForType::Parallel, DeviceAPI::None, body);
+
+        Expr init = Call::make(Int(32), "halide_semaphore_init",
+                               {sem_var, 0}, Call::Extern);
+        Stmt block = Block::make(Evaluate::make(init), loop);
+
+        // The semaphore lives on the stack alongside the fork.
+        return Allocate::make(sem_name, UInt(64), {2}, const_true(), block);
     }
 
     Stmt build_realize(Stmt s) {
@@ -750,7 +991,8 @@ private:
                 bounds.push_back(Range(min, extent));
             }
 
-            s = Realize::make(name, func.output_types(), bounds, const_true(), s);
+            s = Realize::make(name, func.output_types(), bounds, const_true(), s,
+                              func.schedule().memory_type());
         }
 
         // This is also the point at which we inject explicit bounds
@@ -1219,6 +1461,209 @@ bool validate_schedule(Function f, Stmt s, const Target &target, bool is_output,
     return true;
 }
 
+namespace {
+
+// The names of the loops a function's schedule will produce, in the
+// form the lowered loop nest uses ("<func>.s<stage>.<var>"), ordered
+// innermost-first within each stage. This is all LoopLevel::match
+// needs, so we can check compute_at/store_at levels against it
+// without building any loop nests.
+vector<vector<string>> loop_names_for_schedule(const Function &f) {
+    vector<Definition> definitions;
+    definitions.push_back(f.definition());
+    for (const Definition &def : f.updates()) {
+        definitions.push_back(def);
+    }
+    vector<vector<string>> result;
+    for (size_t i = 0; i < definitions.size(); i++) {
+        vector<Definition> stage_defs;
+        stage_defs.push_back(definitions[i]);
+        for (size_t j = 0; j < stage_defs.size(); j++) {
+            for (const Specialization &s : stage_defs[j].specializations()) {
+                stage_defs.push_back(s.definition);
+            }
+        }
+        vector<string> stage_loops;
+        for (const Definition &def : stage_defs) {
+            for (const Dim &d : def.schedule().dims()) {
+                stage_loops.push_back(f.name() + ".s" + std::to_string(i) + "." + d.var);
+            }
+        }
+        result.push_back(stage_loops);
+    }
+    return result;
+}
+
+} // namespace
+
+void validate_schedules(const vector<Function> &outputs, const Target &target) {
+    map<string, Function> env;
+    for (Function f : outputs) {
+        populate_environment(f, env);
+    }
+    env = wrap_func_calls(env);
+
+    set<string> output_names;
+    for (const Function &f : outputs) {
+        output_names.insert(f.name());
+    }
+
+    // Cached transitive call sets, so that checking many Funcs
+    // computed at loops of the same host stays cheap.
+    map<string, map<string, Function>> transitive_calls;
+    auto calls_of = [&](const Function &f) -> const map<string, Function> & {
+        auto it = transitive_calls.find(f.name());
+        if (it == transitive_calls.end()) {
+            it = transitive_calls.emplace(f.name(), find_transitive_calls(f)).first;
+        }
+        return it->second;
+    };
+
+    for (const pair<const string, Function> &p : env) {
+        const Function &f = p.second;
+        bool is_output = output_names.count(f.name());
+
+        // Extern funcs cannot have inlined inputs.
+        if (f.has_extern_definition()) {
+            for (const ExternFuncArgument &arg : f.extern_arguments()) {
+                if (arg.is_func()) {
+                    Function g(arg.func);
+                    if (!g.is_wrapper() &&
+                        g.schedule().compute_level().is_inline()) {
+                        user_error
+                            << "Func " << g.name() << " cannot be scheduled to be computed inline, "
+                            << "because it is used in the externally-computed function " << f.name() << "\n";
+                    }
+                }
+            }
+        }
+
+        // Check any device APIs the schedule asks for are enabled in
+        // the target.
+        vector<Definition> definitions;
+        definitions.push_back(f.definition());
+        for (const Definition &def : f.updates()) {
+            definitions.push_back(def);
+        }
+        for (size_t i = 0; i < definitions.size(); i++) {
+            for (const Specialization &s : definitions[i].specializations()) {
+                definitions.push_back(s.definition);
+            }
+        }
+        for (const Definition &def : definitions) {
+            for (const Dim &d : def.schedule().dims()) {
+                if (!target.supports_device_api(d.device_api)) {
+                    user_error << "Schedule for Func " << f.name()
+                               << " requires " << d.device_api
+                               << " but no compatible target feature is enabled in target "
+                               << target.to_string() << "\n";
+                }
+            }
+        }
+
+        LoopLevel store_at = f.schedule().store_level();
+        LoopLevel compute_at = f.schedule().compute_level();
+
+        if (is_output) {
+            if (!store_at.is_root() || !compute_at.is_root()) {
+                user_error << "Func " << f.name() << " is an output, so must"
+                           << " be scheduled compute_root (which is the default).\n";
+            }
+            continue;
+        }
+
+        if (store_at.is_inline() && compute_at.is_inline()) {
+            if (f.is_pure()) {
+                validate_schedule_inlined_function(f);
+            }
+            continue;
+        }
+
+        // Check the compute and store levels name loops the
+        // enclosing Func will actually have.
+        for (int l = 0; l < 2; l++) {
+            const LoopLevel &level = (l == 0) ? compute_at : store_at;
+            const char *what = (l == 0) ? "computed" : "stored";
+            if (level.is_root() || level.is_inline()) {
+                continue;
+            }
+            auto it = env.find(level.func());
+            if (it == env.end()) {
+                user_error << "Func \"" << f.name() << "\" is scheduled to be " << what << " at "
+                           << level.to_string() << ", but Func \"" << level.func()
+                           << "\" is not used in this pipeline.\n";
+            }
+            bool found = false;
+            for (const vector<string> &stage_loops : loop_names_for_schedule(it->second)) {
+                for (const string &loop : stage_loops) {
+                    found |= level.match(loop);
+                }
+            }
+            if (!found) {
+                user_error << "Func \"" << f.name() << "\" is scheduled to be " << what << " at "
+                           << level.to_string() << ", but Func \"" << level.func()
+                           << "\" has no loop over a variable called \""
+                           << level.var().name() << "\".\n";
+            }
+        }
+
+        // The Func whose loops we are computed in must actually use
+        // this Func (possibly transitively), or the realization could
+        // never cover the uses. Funcs fused into the enclosing Func's
+        // loops with compute_with count too. Multiple outputs may
+        // share loops via Pipeline::fuse_outputs, so skip the check
+        // when computing at an output's loops in a multi-output
+        // pipeline.
+        if (!compute_at.is_root() && !compute_at.is_inline() &&
+            !(output_names.count(compute_at.func()) && outputs.size() > 1)) {
+            vector<Function> group;
+            group.push_back(env.find(compute_at.func())->second);
+            for (const pair<const string, Function> &q : env) {
+                if (q.second.schedule().compute_with_func() == compute_at.func()) {
+                    group.push_back(q.second);
+                }
+            }
+            bool used = false;
+            for (const Function &g : group) {
+                used |= calls_of(g).count(f.name()) != 0;
+            }
+            if (!used) {
+                user_error << "Func \"" << f.name() << "\" is scheduled to be computed at "
+                           << compute_at.to_string() << ", but Func \"" << compute_at.func()
+                           << "\" does not use \"" << f.name()
+                           << "\", so no loop of it can enclose the uses.\n";
+            }
+        }
+
+        // If the store and compute levels are loops of the same Func,
+        // the store level must not be inside the compute level.
+        if (!store_at.is_root() && !store_at.is_inline() &&
+            !compute_at.is_root() && !compute_at.is_inline() &&
+            store_at.func() == compute_at.func()) {
+            for (const vector<string> &loops : loop_names_for_schedule(env.find(store_at.func())->second)) {
+                // Innermost-first, so a smaller index is a deeper loop.
+                int store_idx = -1, compute_idx = -1;
+                for (int i = 0; i < (int)loops.size(); i++) {
+                    if (store_idx < 0 && store_at.match(loops[i])) {
+                        store_idx = i;
+                    }
+                    if (compute_idx < 0 && compute_at.match(loops[i])) {
+                        compute_idx = i;
+                    }
+                }
+                if (store_idx >= 0 && compute_idx >= 0) {
+                    if (store_idx < compute_idx) {
+                        user_error << "Func \"" << f.name() << "\" is stored at "
+                                   << store_at.to_string() << ", which is inside the loop it is"
+                                   << " computed at, " << compute_at.to_string() << ".\n";
+                    }
+                    break;
+                }
+            }
+        }
+    }
+}
+
 class RemoveLoopsOverOutermost : public IRMutator2 {
     using IRMutator2::visit;
 
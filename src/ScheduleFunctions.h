@@ -28,6 +28,16 @@ Stmt schedule_functions(const std::vector<Function> &outputs,
                         const Target &target,
                         bool &any_memoized);
 
+/** Quickly check the schedules of all Funcs in a pipeline for gross
+ * errors, without building any loop nests: outputs not scheduled
+ * compute_root, compute_at or store_at levels that name loops that do
+ * not exist or can never enclose the uses of the Func, store levels
+ * inside compute levels, impure Funcs scheduled inline, and device
+ * APIs absent from the target. Throws a user error on failure. Used
+ * by Pipeline::validate_schedule; the authoritative checks still run
+ * during lowering. */
+void validate_schedules(const std::vector<Function> &outputs, const Target &target);
+
 
 }
 }
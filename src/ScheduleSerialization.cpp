@@ -0,0 +1,270 @@
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ScheduleSerialization.h"
+
+#include "FindCalls.h"
+#include "Func.h"
+#include "IROperator.h"
+#include "Schedule.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// The format is a line-oriented sequence of directives. Enums are
+// written as their integer values; the header line carries a format
+// version so the values can be remapped if the enums ever change.
+const int schedule_format_version = 3;
+
+// Schedule Exprs (split factors, storage directives) must be integer
+// constants to be serializable; anything else (e.g. a ScheduleParam)
+// has no meaning outside the generator that created it.
+string expr_token(const Expr &e, const string &what, const string &func) {
+    if (!e.defined()) {
+        return "_";
+    }
+    const int64_t *val = as_const_int(e);
+    user_assert(val)
+        << "Cannot serialize schedule of function \"" << func << "\": "
+        << what << " is not an integer constant: " << e << "\n";
+    return std::to_string(*val);
+}
+
+Expr token_expr(const string &tok) {
+    if (tok == "_") {
+        return Expr();
+    }
+    return Expr((int)std::stoll(tok));
+}
+
+void write_loop_level(std::ostream &out, const string &directive,
+                      const LoopLevel &level) {
+    out << directive << " ";
+    if (!level.defined()) {
+        out << "undefined";
+    } else if (level.is_inline()) {
+        out << "inline";
+    } else if (level.is_root()) {
+        out << "root";
+    } else {
+        out << "at " << level.func() << " " << level.var().name()
+            << " " << (int)level.var().is_rvar;
+    }
+    out << "\n";
+}
+
+LoopLevel read_loop_level(std::istream &in, const map<string, Function> &env) {
+    string kind;
+    in >> kind;
+    if (kind == "undefined") {
+        return LoopLevel();
+    } else if (kind == "inline") {
+        return LoopLevel::inlined();
+    } else if (kind == "root") {
+        return LoopLevel::root();
+    }
+    user_assert(kind == "at") << "Malformed loop level in schedule file\n";
+    string func, var;
+    int is_rvar;
+    in >> func >> var >> is_rvar;
+    const auto &iter = env.find(func);
+    user_assert(iter != env.end())
+        << "Schedule file refers to loop level of unknown function \""
+        << func << "\"\n";
+    return LoopLevel(iter->second, VarOrRVar(var, is_rvar != 0));
+}
+
+void serialize_stage(std::ostream &out, const StageSchedule &s,
+                     const string &func) {
+    out << "allow_race_conditions " << (int)s.allow_race_conditions() << "\n";
+    out << "atomic " << (int)s.atomic() << "\n";
+    for (const Split &split : s.splits()) {
+        out << "split " << split.old_var << " " << split.outer << " "
+            << split.inner << " "
+            << expr_token(split.factor, "split factor", func) << " "
+            << (int)split.exact << " " << (int)split.tail << " "
+            << (int)split.split_type << "\n";
+    }
+    for (const Dim &dim : s.dims()) {
+        out << "dim " << dim.var << " " << (int)dim.for_type << " "
+            << (int)dim.device_api << " " << (int)dim.dim_type << "\n";
+    }
+}
+
+}  // namespace
+
+void serialize_schedules(const vector<Function> &outputs, std::ostream &out) {
+    map<string, Function> env;
+    for (const Function &f : outputs) {
+        map<string, Function> more_funcs = find_transitive_calls(f);
+        env.insert(more_funcs.begin(), more_funcs.end());
+    }
+
+    out << "halide_schedule " << schedule_format_version << "\n";
+
+    // 'env' is sorted by name, so the output is deterministic.
+    for (const auto &iter : env) {
+        const string &name = iter.first;
+        const Function &f = iter.second;
+        const FuncSchedule &fs = f.schedule();
+
+        out << "func " << name << "\n";
+        out << "memoized " << (int)fs.memoized() << "\n";
+        write_loop_level(out, "store_level", fs.store_level());
+        write_loop_level(out, "compute_level", fs.compute_level());
+        for (const StorageDim &sd : fs.storage_dims()) {
+            out << "storage_dim " << sd.var << " "
+                << expr_token(sd.alignment, "storage alignment", name) << " "
+                << expr_token(sd.fold_factor, "fold factor", name) << " "
+                << (int)sd.fold_forward << " "
+                << expr_token(sd.tile_extent, "storage tile extent", name) << "\n";
+        }
+
+        if (f.has_extern_definition()) {
+            continue;
+        }
+        out << "stage 0\n";
+        serialize_stage(out, f.definition().schedule(), name);
+        for (size_t i = 0; i < f.updates().size(); i++) {
+            out << "stage " << (i + 1) << "\n";
+            serialize_stage(out, f.update(i).schedule(), name);
+        }
+    }
+}
+
+void deserialize_schedules(const vector<Function> &outputs, std::istream &in) {
+    map<string, Function> env;
+    for (const Function &f : outputs) {
+        map<string, Function> more_funcs = find_transitive_calls(f);
+        env.insert(more_funcs.begin(), more_funcs.end());
+    }
+
+    string tok;
+    int version = 0;
+    in >> tok >> version;
+    user_assert(tok == "halide_schedule")
+        << "Not a Halide schedule file (expected \"halide_schedule\" header)\n";
+    user_assert(version == schedule_format_version)
+        << "Unsupported schedule file version " << version
+        << " (expected " << schedule_format_version << ")\n";
+
+    Function cur_func;
+    FuncSchedule cur_func_sched;
+    StageSchedule cur_stage_sched;
+    bool have_func = false;
+    bool have_stage = false;
+
+    while (in >> tok) {
+        if (tok == "func") {
+            string name;
+            in >> name;
+            const auto &iter = env.find(name);
+            user_assert(iter != env.end())
+                << "Schedule file refers to unknown function \"" << name << "\"\n";
+            cur_func = iter->second;
+            cur_func_sched = cur_func.schedule();
+            have_func = true;
+            have_stage = false;
+            // The file records the complete schedule, so clear anything
+            // already on the function.
+            cur_func_sched.storage_dims().clear();
+            continue;
+        }
+        user_assert(have_func) << "Malformed schedule file: directive \""
+                               << tok << "\" before any \"func\"\n";
+        if (tok == "memoized") {
+            int m;
+            in >> m;
+            cur_func_sched.memoized() = (m != 0);
+        } else if (tok == "store_level") {
+            cur_func_sched.store_level() = read_loop_level(in, env);
+        } else if (tok == "compute_level") {
+            cur_func_sched.compute_level() = read_loop_level(in, env);
+        } else if (tok == "storage_dim") {
+            StorageDim sd;
+            string alignment, fold_factor, tile_extent;
+            int fold_forward;
+            in >> sd.var >> alignment >> fold_factor >> fold_forward >> tile_extent;
+            sd.alignment = token_expr(alignment);
+            sd.fold_factor = token_expr(fold_factor);
+            sd.fold_forward = (fold_forward != 0);
+            sd.tile_extent = token_expr(tile_extent);
+            cur_func_sched.storage_dims().push_back(sd);
+        } else if (tok == "stage") {
+            int stage_num;
+            in >> stage_num;
+            int num_stages = cur_func.has_extern_definition() ?
+                0 : (int)cur_func.updates().size() + 1;
+            user_assert(stage_num >= 0 && stage_num < num_stages)
+                << "Schedule file refers to stage " << stage_num
+                << " of function \"" << cur_func.name() << "\", which has "
+                << num_stages << " stages\n";
+            if (stage_num == 0) {
+                cur_stage_sched = cur_func.definition().schedule();
+            } else {
+                cur_stage_sched = cur_func.update(stage_num - 1).schedule();
+            }
+            have_stage = true;
+            cur_stage_sched.splits().clear();
+            cur_stage_sched.dims().clear();
+        } else if (tok == "allow_race_conditions") {
+            user_assert(have_stage) << "Malformed schedule file: stage "
+                                    << "directive outside any \"stage\"\n";
+            int a;
+            in >> a;
+            cur_stage_sched.allow_race_conditions() = (a != 0);
+        } else if (tok == "atomic") {
+            user_assert(have_stage) << "Malformed schedule file: stage "
+                                    << "directive outside any \"stage\"\n";
+            int a;
+            in >> a;
+            cur_stage_sched.atomic() = (a != 0);
+        } else if (tok == "split") {
+            user_assert(have_stage) << "Malformed schedule file: stage "
+                                    << "directive outside any \"stage\"\n";
+            Split split;
+            string factor;
+            int exact, tail, split_type;
+            in >> split.old_var >> split.outer >> split.inner >> factor
+               >> exact >> tail >> split_type;
+            user_assert(tail >= 0 && tail <= (int)TailStrategy::Auto)
+                << "Invalid tail strategy in schedule file: " << tail << "\n";
+            user_assert(split_type >= 0 && split_type <= Split::PurifyRVar)
+                << "Invalid split type in schedule file: " << split_type << "\n";
+            split.factor = token_expr(factor);
+            split.exact = (exact != 0);
+            split.tail = (TailStrategy)tail;
+            split.split_type = (Split::SplitType)split_type;
+            cur_stage_sched.splits().push_back(split);
+        } else if (tok == "dim") {
+            user_assert(have_stage) << "Malformed schedule file: stage "
+                                    << "directive outside any \"stage\"\n";
+            Dim dim;
+            int for_type, device_api, dim_type;
+            in >> dim.var >> for_type >> device_api >> dim_type;
+            user_assert(for_type >= 0 && for_type <= (int)ForType::GPUThread)
+                << "Invalid for type in schedule file: " << for_type << "\n";
+            user_assert(device_api >= 0 && device_api <= (int)DeviceAPI::Hexagon)
+                << "Invalid device api in schedule file: " << device_api << "\n";
+            user_assert(dim_type >= 0 && dim_type <= Dim::ImpureRVar)
+                << "Invalid dim type in schedule file: " << dim_type << "\n";
+            dim.for_type = (ForType)for_type;
+            dim.device_api = (DeviceAPI)device_api;
+            dim.dim_type = (Dim::Type)dim_type;
+            cur_stage_sched.dims().push_back(dim);
+        } else {
+            user_error << "Unknown directive in schedule file: \"" << tok << "\"\n";
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,43 @@
+#ifndef HALIDE_SCHEDULE_SERIALIZATION_H
+#define HALIDE_SCHEDULE_SERIALIZATION_H
+
+/** \file
+ *
+ * Defines methods for saving and loading the schedules of all Funcs in
+ * a pipeline as a text file, so that schedules can be shipped as data
+ * (e.g. produced by an autotuner) and applied to a Generator at build
+ * time without modifying or recompiling it.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include "Function.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Write the schedules of the given output Functions, and everything
+ * they transitively call, to the given stream. The format is a
+ * line-oriented text format versioned by its header line; it records
+ * the full contents of each FuncSchedule and StageSchedule (storage
+ * dims, store/compute levels, splits, fuses, renames, dim list, loop
+ * types). Only schedules whose split factors and storage directives
+ * are integer constants can be serialized; schedules that reference
+ * ScheduleParams or other non-literal Exprs are rejected with a user
+ * error. */
+EXPORT void serialize_schedules(const std::vector<Function> &outputs,
+                                std::ostream &out);
+
+/** Read schedules written by serialize_schedules from the given stream
+ * and apply them to the pipeline defined by the given output
+ * Functions. The Funcs named in the file must exist in the pipeline
+ * with matching stage counts; any existing schedules on them are
+ * replaced. */
+EXPORT void deserialize_schedules(const std::vector<Function> &outputs,
+                                  std::istream &in);
+
+}
+}
+
+#endif
@@ -1,8 +1,9 @@
 #ifndef HALIDE_SCOPE_H
 #define HALIDE_SCOPE_H
 
+#include <atomic>
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <stack>
 #include <utility>
 #include <iostream>
@@ -66,6 +67,17 @@ public:
     }
 };
 
+/** A process-wide counter bumped on every mutation of any Scope. An
+ * analysis that caches facts about an Expr in a Scope can use the
+ * pair (scope address, counter value) to identify the scope's state:
+ * if the counter is unchanged since a fact was recorded against a
+ * given scope, no Scope anywhere has been mutated, so that scope
+ * still holds the same bindings. */
+inline std::atomic<uint64_t> &scope_mutation_counter() {
+    static std::atomic<uint64_t> counter(0);
+    return counter;
+}
+
 /** A common pattern when traversing Halide IR is that you need to
  * keep track of stuff when you find a Let or a LetStmt, and that it
  * should hide previous values with the same name until you leave the
@@ -73,7 +85,15 @@ public:
 template<typename T>
 class Scope {
 private:
-    std::map<std::string, SmallStack<T>> table;
+    // A hash table rather than an ordered map: scope lookups happen
+    // on every Variable in every pass, and hashing the name once
+    // beats a chain of string compares down a tree.
+    using Table = std::unordered_map<std::string, SmallStack<T>>;
+    Table table;
+
+    static void note_mutation() {
+        scope_mutation_counter().fetch_add(1, std::memory_order_relaxed);
+    }
 
     // Copying a scope object copies a large table full of strings and
     // stacks. Bad idea.
@@ -86,11 +106,21 @@ private:
 public:
     Scope() : containing_scope(nullptr) {}
 
+    ~Scope() {
+        // The bindings vanish with the scope; another Scope
+        // constructed at this address must not match cached facts
+        // recorded against our contents.
+        if (!table.empty()) {
+            note_mutation();
+        }
+    }
+
     /** Set the parent scope. If lookups fail in this scope, they
      * check the containing scope before returning an error. Caller is
      * responsible for managing the memory of the containing scope. */
     void set_containing_scope(const Scope<T> *s) {
         containing_scope = s;
+        note_mutation();
     }
 
     /** A const ref to an empty scope. Useful for default function
@@ -103,7 +133,7 @@ public:
 
     /** Retrieve the value referred to by a name */
     T get(const std::string &name) const {
-        typename std::map<std::string, SmallStack<T>>::const_iterator iter = table.find(name);
+        typename Table::const_iterator iter = table.find(name);
         if (iter == table.end() || iter->second.empty()) {
             if (containing_scope) {
                 return containing_scope->get(name);
@@ -116,16 +146,18 @@ public:
 
     /** Return a reference to an entry. Does not consider the containing scope. */
     T &ref(const std::string &name) {
-        typename std::map<std::string, SmallStack<T>>::iterator iter = table.find(name);
+        typename Table::iterator iter = table.find(name);
         if (iter == table.end() || iter->second.empty()) {
             internal_error << "Symbol '" << name << "' not found\n";
         }
+        // The caller may write through the reference.
+        note_mutation();
         return iter->second.top_ref();
     }
 
     /** Tests if a name is in scope */
     bool contains(const std::string &name) const {
-        typename std::map<std::string, SmallStack<T>>::const_iterator iter = table.find(name);
+        typename Table::const_iterator iter = table.find(name);
         if (iter == table.end() || iter->second.empty()) {
             if (containing_scope) {
                 return containing_scope->contains(name);
@@ -141,25 +173,27 @@ public:
      */
     void push(const std::string &name, const T &value) {
         table[name].push(value);
+        note_mutation();
     }
 
     /** A name goes out of scope. Restore whatever its old value
      * was (or remove it entirely if there was nothing else of the
      * same name in an outer scope) */
     void pop(const std::string &name) {
-        typename std::map<std::string, SmallStack<T>>::iterator iter = table.find(name);
+        typename Table::iterator iter = table.find(name);
         internal_assert(iter != table.end()) << "Name not in symbol table: " << name << "\n";
         iter->second.pop();
         if (iter->second.empty()) {
             table.erase(iter);
         }
+        note_mutation();
     }
 
     /** Iterate through the scope. Does not capture any containing scope. */
     class const_iterator {
-        typename std::map<std::string, SmallStack<T>>::const_iterator iter;
+        typename Table::const_iterator iter;
     public:
-        explicit const_iterator(const typename std::map<std::string, SmallStack<T>>::const_iterator &i) :
+        explicit const_iterator(const typename Table::const_iterator &i) :
             iter(i) {
         }
 
@@ -195,9 +229,9 @@ public:
     }
 
     class iterator {
-        typename std::map<std::string, SmallStack<T>>::iterator iter;
+        typename Table::iterator iter;
     public:
-        explicit iterator(typename std::map<std::string, SmallStack<T>>::iterator i) :
+        explicit iterator(typename Table::iterator i) :
             iter(i) {
         }
 
@@ -225,6 +259,8 @@ public:
     };
 
     iterator begin() {
+        // The caller may write through the iterator.
+        note_mutation();
         return iterator(table.begin());
     }
 
@@ -235,6 +271,7 @@ public:
     void swap(Scope<T> &other) {
         table.swap(other.table);
         std::swap(containing_scope, other.containing_scope);
+        note_mutation();
     }
 };
 
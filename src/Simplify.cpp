@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <mutex>
 #include <stdio.h>
 
 #include "Simplify.h"
@@ -5166,7 +5167,7 @@ private:
             // else case must not use it.
             Stmt stmt = Allocate::make(op->name, op->type, new_extents,
                                   condition, body_if->then_case,
-                                  new_expr, op->free_function);
+                                  new_expr, op->free_function, op->memory_type);
             return IfThenElse::make(body_if->condition, stmt, body_if->else_case);
         } else if (all_extents_unmodified &&
                    body.same_as(op->body) &&
@@ -5176,7 +5177,7 @@ private:
         } else {
             return Allocate::make(op->name, op->type, new_extents,
                                   condition, body,
-                                  new_expr, op->free_function);
+                                  new_expr, op->free_function, op->memory_type);
         }
     }
 
@@ -5286,10 +5287,95 @@ private:
     }
 };
 
+namespace {
+
+// A lossy cache of recent context-free simplifications. Lowering
+// calls simplify on the same subtrees many times over (BoundsInference
+// in particular re-simplifies near-identical interval expressions per
+// stage), and a simplified result for an Expr with no surrounding
+// scope info depends only on the Expr's value. Keyed by structural
+// hash; on collision the old entry is evicted, in the style of
+// IRCompareCache.
+struct SimplifyCacheEntry {
+    Expr in, out;
+};
+const int simplify_cache_bits = 12;
+SimplifyCacheEntry simplify_cache[1 << simplify_cache_bits];
+// Parts of lowering run across a thread pool, so the cache needs a lock.
+std::mutex simplify_cache_mutex;
+
+// The cache is process-global, so it must never hand one pipeline an
+// expression simplified for another. IRComparer ignores the Parameter
+// and Buffer objects bound to Variable, Load, and Call nodes, so two
+// pipelines' expressions can compare equal while being bound to
+// different Parameters of the same name and type; caching them would
+// let argument inference and JIT closures capture the wrong one.
+// Detect such bindings so those expressions bypass the cache.
+class HasBoundObjects : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Variable *op) override {
+        if (op->param.defined() ||
+            op->image.defined() ||
+            op->reduction_domain.defined()) {
+            result = true;
+        }
+    }
+
+    void visit(const Load *op) override {
+        if (op->param.defined() || op->image.defined()) {
+            result = true;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const Call *op) override {
+        if (op->param.defined() ||
+            op->image.defined() ||
+            op->func.defined()) {
+            result = true;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+public:
+    bool result = false;
+};
+
+bool has_bound_objects(const Expr &e) {
+    HasBoundObjects h;
+    e.accept(&h);
+    return h.result;
+}
+
+} // namespace
+
 Expr simplify(Expr e, bool simplify_lets,
               const Scope<Interval> &bounds,
               const Scope<ModulusRemainder> &alignment) {
-    return Simplify(simplify_lets, &bounds, &alignment).mutate(e);
+    SimplifyCacheEntry *entry = nullptr;
+    if (simplify_lets &&
+        &bounds == &Scope<Interval>::empty_scope() &&
+        &alignment == &Scope<ModulusRemainder>::empty_scope() &&
+        !has_bound_objects(e)) {
+        uint64_t h = structural_hash(e);
+        entry = &simplify_cache[h & ((1 << simplify_cache_bits) - 1)];
+        std::lock_guard<std::mutex> lock(simplify_cache_mutex);
+        if (entry->in.defined() &&
+            (entry->in.same_as(e) ||
+             (structural_hash(entry->in) == h && equal(entry->in, e)))) {
+            return entry->out;
+        }
+    }
+    Expr result = Simplify(simplify_lets, &bounds, &alignment).mutate(e);
+    if (entry != nullptr) {
+        std::lock_guard<std::mutex> lock(simplify_cache_mutex);
+        entry->in = e;
+        entry->out = result;
+    }
+    return result;
 }
 
 Stmt simplify(Stmt s, bool simplify_lets,
@@ -1,10 +1,12 @@
 #include "SimplifySpecializations.h"
+#include "Debug.h"
 #include "IROperator.h"
 #include "IRMutator.h"
 #include "Simplify.h"
 #include "Substitute.h"
 #include "Definition.h"
 #include "IREquality.h"
+#include "ThreadPool.h"
 
 #include <set>
 
@@ -154,10 +156,14 @@ vector<Definition> propagate_specialization_in_definition(Definition &def, const
 
 
 void simplify_specializations(map<string, Function> &env) {
-    for (auto &iter : env) {
+    // Each function's specializations are propagated within its own
+    // definition, so the functions can be processed in parallel.
+    const size_t num_threads =
+        (debug::debug_level() > 0) ? 1 : num_compile_time_threads();
+    parallel_for_each(env, [](std::pair<const string, Function> &iter) {
         Function &func = iter.second;
         propagate_specialization_in_definition(func.definition(), func.name());
-    }
+    }, num_threads);
 }
 
 }
@@ -384,7 +384,7 @@ private:
                 debug(3) << "Done guarding computation for " << op->name << "\n";
 
                 return Realize::make(op->name, op->types, op->bounds,
-                                     alloc_predicate, body);
+                                     alloc_predicate, body, op->memory_type);
             } else {
                 return IRMutator2::visit(op);
             }
@@ -1,6 +1,7 @@
 #include "SlidingWindow.h"
 #include "IRMutator.h"
 #include "IROperator.h"
+#include "Util.h"
 #include "Scope.h"
 #include "Debug.h"
 #include "Substitute.h"
@@ -88,6 +89,14 @@ class SlidingWindowOnFunctionAndLoop : public IRMutator2 {
 
     map<string, Expr> replacements;
 
+    // If sliding fails, remember the first reason why, so that an
+    // explicit slide_over directive can report it.
+    void record_failure(const string &reason) {
+        if (fail_reason.empty()) {
+            fail_reason = reason;
+        }
+    }
+
     using IRMutator2::visit;
 
     // Check if the dimension at index 'dim_idx' is always pure (i.e. equal to 'dim')
@@ -165,6 +174,8 @@ class SlidingWindowOnFunctionAndLoop : public IRMutator2 {
                 debug(3) << "Could not perform sliding window optimization of "
                          << func.name() << " over " << loop_var << " because multiple "
                          << "dimensions of the function dependended on the loop var\n";
+                record_failure("the regions required of multiple dimensions "
+                               "of the function depend on the loop variable");
                 return stmt;
             }
 
@@ -181,6 +192,7 @@ class SlidingWindowOnFunctionAndLoop : public IRMutator2 {
                 debug(3) << "Could not performance sliding window optimization of "
                          << func.name() << " over " << loop_var << " because the function "
                          << "scatters along the related axis.\n";
+                record_failure("the function scatters along the axis it would slide over");
                 return stmt;
             }
 
@@ -207,6 +219,8 @@ class SlidingWindowOnFunctionAndLoop : public IRMutator2 {
                          << " because I couldn't prove it moved monotonically along that dimension\n"
                          << "Min is " << min_required << "\n"
                          << "Max is " << max_required << "\n";
+                record_failure("the region required could not be proved to move "
+                               "monotonically along dimension " + dim);
                 return stmt;
             }
 
@@ -230,6 +244,8 @@ class SlidingWindowOnFunctionAndLoop : public IRMutator2 {
                          << " there's no overlap in the region computed across iterations\n"
                          << "Min is " << min_required << "\n"
                          << "Max is " << max_required << "\n";
+                record_failure("there is no overlap in the regions required by "
+                               "consecutive iterations");
                 return stmt;
             }
 
@@ -255,6 +271,7 @@ class SlidingWindowOnFunctionAndLoop : public IRMutator2 {
             } else {
                 replacements[prefix + dim + ".max"] = new_max;
             }
+            slid = true;
 
             for (size_t i = 0; i < func.updates().size(); i++) {
                 string n = func.name() + ".s" + std::to_string(i) + "." + dim;
@@ -302,6 +319,8 @@ class SlidingWindowOnFunctionAndLoop : public IRMutator2 {
             debug(3) << "Not entering loop over " << op->name
                      << " because the bounds depend on the var we're sliding over: "
                      << min << ", " << extent << "\n";
+            record_failure("the bounds of the inner loop over " + op->name +
+                           " depend on the loop variable");
             return op;
         } else {
             return IRMutator2::visit(op);
@@ -329,24 +348,53 @@ class SlidingWindowOnFunctionAndLoop : public IRMutator2 {
 
 public:
     SlidingWindowOnFunctionAndLoop(Function f, string v, Expr v_min) : func(f), loop_var(v), loop_min(v_min) {}
+
+    // Whether the production was found and successfully rewritten to
+    // slide along a dimension, and if not, why not.
+    bool slid = false;
+    string fail_reason;
 };
 
 // Perform sliding window optimization for a particular function
 class SlidingWindowOnFunction : public IRMutator2 {
     Function func;
+    // Loop var the function is explicitly required to slide over, if any.
+    string required_loop_var;
 
     using IRMutator2::visit;
 
     Stmt visit(const For *op) override {
         debug(3) << " Doing sliding window analysis over loop: " << op->name << "\n";
 
+        bool required = (!required_loop_var.empty() &&
+                         ends_with(op->name, "." + required_loop_var));
+        if (required) {
+            found_required_loop = true;
+            user_assert(op->for_type == ForType::Serial ||
+                        op->for_type == ForType::Unrolled)
+                << "Cannot slide function " << func.name()
+                << " over the loop " << op->name
+                << " because it is not a serial loop. Only serial (or unrolled) "
+                << "loops can reuse values computed by earlier iterations.\n";
+        }
+
         Stmt new_body = op->body;
 
         new_body = mutate(new_body);
 
         if (op->for_type == ForType::Serial ||
             op->for_type == ForType::Unrolled) {
-            new_body = SlidingWindowOnFunctionAndLoop(func, op->name, op->min).mutate(new_body);
+            SlidingWindowOnFunctionAndLoop slider(func, op->name, op->min);
+            new_body = slider.mutate(new_body);
+            if (required && !slider.slid) {
+                string reason = slider.fail_reason;
+                if (reason.empty()) {
+                    reason = "no production of it occurs inside that loop";
+                }
+                user_error << "Cannot slide function " << func.name()
+                           << " over the loop " << op->name
+                           << " because " << reason << ".\n";
+            }
         }
 
         if (new_body.same_as(op->body)) {
@@ -357,7 +405,11 @@ class SlidingWindowOnFunction : public IRMutator2 {
     }
 
 public:
-    SlidingWindowOnFunction(Function f) : func(f) {}
+    SlidingWindowOnFunction(Function f)
+        : func(f), required_loop_var(f.schedule().slide_over_loop()) {}
+
+    // Whether a loop matching the slide_over directive was seen.
+    bool found_required_loop = false;
 };
 
 // Perform sliding window optimization for all functions
@@ -380,6 +432,11 @@ class SlidingWindow : public IRMutator2 {
         // as its store_at level, skip it.
         const FuncSchedule &sched = iter->second.schedule();
         if (sched.compute_level() == sched.store_level()) {
+            user_assert(sched.slide_over_loop().empty())
+                << "Cannot slide function " << op->name
+                << " over the loop variable " << sched.slide_over_loop()
+                << " because its storage does not outlive its computation. "
+                << "slide_over requires a store_at level outside the compute_at level.\n";
             return IRMutator2::visit(op);
         }
 
@@ -387,14 +444,20 @@ class SlidingWindow : public IRMutator2 {
 
         debug(3) << "Doing sliding window analysis on realization of " << op->name << "\n";
 
-        new_body = SlidingWindowOnFunction(iter->second).mutate(new_body);
+        SlidingWindowOnFunction slider(iter->second);
+        new_body = slider.mutate(new_body);
+
+        user_assert(sched.slide_over_loop().empty() || slider.found_required_loop)
+            << "Cannot slide function " << op->name
+            << " over the loop variable " << sched.slide_over_loop()
+            << " because no loop over that variable exists outside its compute level.\n";
 
         new_body = mutate(new_body);
 
         if (new_body.same_as(op->body)) {
             return op;
         } else {
-            return Realize::make(op->name, op->types, op->bounds, op->condition, new_body);
+            return Realize::make(op->name, op->types, op->bounds, op->condition, new_body, op->memory_type);
         }
     }
 public:
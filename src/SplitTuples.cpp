@@ -56,13 +56,29 @@ class SplitTuples : public IRMutator2 {
 
     map<string, set<int>> func_value_indices;
 
+    bool stored_interleaved(const string &name) {
+        auto it = env.find(name);
+        return (it != env.end() &&
+                it->second.outputs() > 1 &&
+                it->second.schedule().store_interleaved());
+    }
+
     Stmt visit(const Realize *op) override {
         ScopedBinding<int> bind(realizations, op->name, 0);
         if (op->types.size() > 1) {
-            // Make a nested set of realize nodes for each tuple element
             Stmt body = mutate(op->body);
+            if (stored_interleaved(op->name)) {
+                // Make a single realize node with an extra innermost
+                // dimension indexing the tuple element. All types are
+                // the same; Func::store_interleaved checks this.
+                Region bounds;
+                bounds.push_back(Range(0, (int)op->types.size()));
+                bounds.insert(bounds.end(), op->bounds.begin(), op->bounds.end());
+                return Realize::make(op->name, {op->types[0]}, bounds, op->condition, body, op->memory_type);
+            }
+            // Make a nested set of realize nodes for each tuple element
             for (int i = (int)op->types.size() - 1; i >= 0; i--) {
-                body = Realize::make(op->name + "." + std::to_string(i), {op->types[i]}, op->bounds, op->condition, body);
+                body = Realize::make(op->name + "." + std::to_string(i), {op->types[i]}, op->bounds, op->condition, body, op->memory_type);
             }
             return body;
         } else {
@@ -84,7 +100,14 @@ class SplitTuples : public IRMutator2 {
 
     Stmt visit(const Prefetch *op) override {
         Stmt stmt;
-        if (!op->param.defined() && (op->types.size() > 1)) {
+        if (!op->param.defined() && (op->types.size() > 1) && stored_interleaved(op->name)) {
+            // The whole realization is one allocation; prefetch it
+            // with the element dimension prepended.
+            Region bounds;
+            bounds.push_back(Range(0, (int)op->types.size()));
+            bounds.insert(bounds.end(), op->bounds.begin(), op->bounds.end());
+            stmt = Prefetch::make(op->name, {op->types[0]}, bounds);
+        } else if (!op->param.defined() && (op->types.size() > 1)) {
             // Split the prefetch from a multi-dimensional halide tuple to
             // prefetches of each tuple element. Keep only prefetches of
             // elements that are actually used in the loop body.
@@ -110,10 +133,14 @@ class SplitTuples : public IRMutator2 {
             internal_assert(it != env.end());
             Function f = it->second;
             string name = op->name;
-            if (f.outputs() > 1) {
+            vector<Expr> args;
+            if (f.outputs() > 1 && f.schedule().store_interleaved()) {
+                // The element index becomes the innermost coordinate
+                // of the shared realization.
+                args.push_back(op->value_index);
+            } else if (f.outputs() > 1) {
                 name += "." + std::to_string(op->value_index);
             }
-            vector<Expr> args;
             for (Expr e : op->args) {
                 args.push_back(mutate(e));
             }
@@ -168,15 +195,24 @@ class SplitTuples : public IRMutator2 {
         vector<Stmt> provides;
         vector<pair<string, Expr>> lets;
 
+        bool interleaved = f.schedule().store_interleaved();
         for (size_t i = 0; i < op->values.size(); i++) {
-            string name = op->name + "." + std::to_string(i);
-            string var_name = name + ".value";
+            string var_name = op->name + "." + std::to_string(i) + ".value";
             Expr val = mutate(op->values[i]);
             if (!is_undef(val) && atomic) {
                 lets.push_back({ var_name, val });
                 val = Variable::make(val.type(), var_name);
             }
-            provides.push_back(Provide::make(name, {val}, args));
+            if (interleaved) {
+                // One store per element into the shared realization,
+                // with the element index as the innermost coordinate.
+                vector<Expr> element_args;
+                element_args.push_back((int)i);
+                element_args.insert(element_args.end(), args.begin(), args.end());
+                provides.push_back(Provide::make(op->name, {val}, element_args));
+            } else {
+                provides.push_back(Provide::make(op->name + "." + std::to_string(i), {val}, args));
+            }
         }
 
         Stmt result = Block::make(provides);
@@ -1,9 +1,12 @@
 #include "StmtToHtml.h"
+#include "AutoSchedule.h"
 #include "IRVisitor.h"
 #include "IROperator.h"
 #include "Scope.h"
 
+#include <cmath>
 #include <iterator>
+#include <iomanip>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -22,6 +25,112 @@ std::string to_string(T value) {
     return os.str() ;
 }
 
+// A static cost estimate for one loop, in the same units as
+// RegionCosts uses for the auto-scheduler: arithmetic ops and bytes
+// moved. RegionCosts itself works on the pre-lowered function
+// environment, so the lowered statements printed here are costed by
+// an equivalent walk over the IR.
+struct LoopCost {
+    // Totals per execution of the loop, counting vector lanes, with
+    // enclosed loops multiplied through by their extents.
+    int64_t arith = 0, bytes = 0;
+    // False if some enclosed loop had a non-constant extent, in which
+    // case the totals assume a single iteration of it and are a lower
+    // bound.
+    bool exact = true;
+    // The widest vector type in the body.
+    int max_lanes = 1;
+};
+
+class CollectLoopCosts : public IRVisitor {
+public:
+    std::map<const IRNode *, LoopCost> loop_costs;
+    LoopCost cost;
+
+private:
+    using IRVisitor::visit;
+
+    void count_op(Type t) {
+        cost.arith += t.lanes();
+        cost.max_lanes = std::max(cost.max_lanes, t.lanes());
+    }
+
+    template<typename T>
+    void visit_arith_op(const T *op) {
+        count_op(op->type);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Add *op) override { visit_arith_op(op); }
+    void visit(const Sub *op) override { visit_arith_op(op); }
+    void visit(const Mul *op) override { visit_arith_op(op); }
+    void visit(const Div *op) override { visit_arith_op(op); }
+    void visit(const Mod *op) override { visit_arith_op(op); }
+    void visit(const Min *op) override { visit_arith_op(op); }
+    void visit(const Max *op) override { visit_arith_op(op); }
+    void visit(const EQ *op) override { visit_arith_op(op); }
+    void visit(const NE *op) override { visit_arith_op(op); }
+    void visit(const LT *op) override { visit_arith_op(op); }
+    void visit(const LE *op) override { visit_arith_op(op); }
+    void visit(const GT *op) override { visit_arith_op(op); }
+    void visit(const GE *op) override { visit_arith_op(op); }
+    void visit(const And *op) override { visit_arith_op(op); }
+    void visit(const Or *op) override { visit_arith_op(op); }
+    void visit(const Not *op) override { visit_arith_op(op); }
+    void visit(const Select *op) override { visit_arith_op(op); }
+    void visit(const Cast *op) override { visit_arith_op(op); }
+    void visit(const Call *op) override { visit_arith_op(op); }
+    void visit(const Shuffle *op) override { visit_arith_op(op); }
+
+    void visit(const Load *op) override {
+        cost.bytes += (int64_t)op->type.bytes() * op->type.lanes();
+        cost.max_lanes = std::max(cost.max_lanes, op->type.lanes());
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Store *op) override {
+        Type t = op->value.type();
+        cost.bytes += (int64_t)t.bytes() * t.lanes();
+        cost.max_lanes = std::max(cost.max_lanes, t.lanes());
+        IRVisitor::visit(op);
+    }
+
+    void visit(const For *op) override {
+        LoopCost outer = cost;
+        cost = LoopCost();
+        op->body.accept(this);
+        LoopCost inner = cost;
+        if (const int64_t *extent = as_const_int(op->extent)) {
+            inner.arith *= *extent;
+            inner.bytes *= *extent;
+        } else {
+            inner.exact = false;
+        }
+        loop_costs[op] = inner;
+        cost = outer;
+        cost.arith += inner.arith;
+        cost.bytes += inner.bytes;
+        cost.exact = cost.exact && inner.exact;
+        cost.max_lanes = std::max(cost.max_lanes, inner.max_lanes);
+        op->min.accept(this);
+        op->extent.accept(this);
+    }
+};
+
+// 1234567 -> "1.23M", etc.
+string format_count(int64_t c) {
+    static const char *suffixes[] = {"", "K", "M", "G", "T"};
+    double v = (double)c;
+    int s = 0;
+    while (v >= 1000 && s < 4) {
+        v /= 1000;
+        s++;
+    }
+    std::ostringstream os;
+    os << std::setprecision(3) << v << suffixes[s];
+    return os.str();
+}
+
 class StmtToHtml : public IRVisitor {
 
     static const std::string css, js;
@@ -123,6 +232,61 @@ private:
         stream << matched(r);
     }
 
+    // Cost annotations for every For node reachable from the
+    // statements printed so far, and the roofline machine model they
+    // are judged against.
+    std::map<const IRNode *, LoopCost> loop_costs;
+    double max_loop_weight = 0;
+    int64_t balance;  // ops per byte at the roofline ridge point
+
+    // A single heat metric for a loop: its arithmetic plus its memory
+    // traffic weighted by the relative cost of a byte.
+    double loop_weight(const LoopCost &c) const {
+        return (double)c.arith + (double)c.bytes * (double)balance;
+    }
+
+    void gather_loop_costs(const Stmt &s) {
+        CollectLoopCosts collect;
+        s.accept(&collect);
+        for (const auto &p : collect.loop_costs) {
+            loop_costs[p.first] = p.second;
+            max_loop_weight = std::max(max_loop_weight, loop_weight(p.second));
+        }
+    }
+
+    string cost_annotation(const For *op, const LoopCost &c) {
+        std::ostringstream os;
+        os << "// " << format_count(c.arith) << " ops, "
+           << format_count(c.bytes) << " bytes";
+        if (!c.exact) {
+            os << " (at least)";
+        }
+        string position;
+        if (c.bytes > 0) {
+            double intensity = (double)c.arith / (double)c.bytes;
+            os << ", " << std::setprecision(2) << intensity << " ops/byte";
+            position = intensity < (double)balance ? "memory-bound" : "compute-bound";
+        } else if (c.arith > 0) {
+            position = "compute-bound";
+        }
+        if (c.max_lanes > 1) {
+            os << ", vec x" << c.max_lanes;
+        }
+        string ann = os.str();
+        if (position.empty()) {
+            return span("Comment", ann);
+        }
+        bool gpu = (op->for_type == ForType::GPUBlock ||
+                    op->for_type == ForType::GPUThread);
+        if (position == "memory-bound" && c.max_lanes == 1 && !gpu) {
+            // The schedule-review red flag: traffic dominates, but
+            // the body is scalar.
+            return span("Comment", ann + ", ") +
+                   span("Assign", position + ", unvectorized");
+        }
+        return span("Comment", ann + ", " + position);
+    }
+
     string open_expand_button(int id) {
         std::stringstream button;
         button << "<a class=ExpandButton onclick='return toggle(" << id << ");' href=_blank>"
@@ -348,27 +512,45 @@ private:
         int id = unique_id();
         stream << open_expand_button(id);
         stream << open_span("Matched");
+        string kw;
         if (op->for_type == ForType::Serial) {
-            stream << keyword("for");
+            kw = "for";
         } else if (op->for_type == ForType::Parallel) {
-            stream << keyword("parallel");
+            kw = "parallel";
         } else if (op->for_type == ForType::Vectorized) {
-            stream << keyword("vectorized");
+            kw = "vectorized";
         } else if (op->for_type == ForType::Unrolled) {
-            stream << keyword("unrolled");
+            kw = "unrolled";
         } else if (op->for_type == ForType::GPUBlock) {
-            stream << keyword("gpu_block");
+            kw = "gpu_block";
         } else if (op->for_type == ForType::GPUThread) {
-            stream << keyword("gpu_thread");
+            kw = "gpu_thread";
         } else {
             internal_assert(false) << "Unknown for type: " << ((int)op->for_type) << "\n";
         }
+        auto cost = loop_costs.find(op);
+        double heat = 0;
+        if (cost != loop_costs.end() && max_loop_weight > 0) {
+            // Log scale, so the hot loop and its enclosing loops all
+            // show up against the cheap ones.
+            heat = std::log(1 + loop_weight(cost->second)) /
+                   std::log(1 + max_loop_weight);
+        }
+        if (heat > 0) {
+            stream << "<span class='Keyword' style='background-color: rgba(255,96,0,"
+                   << std::setprecision(2) << 0.5 * heat << ")'>" << kw << "</span>";
+        } else {
+            stream << keyword(kw);
+        }
         stream << " (";
         stream << close_span();
         print_list({Variable::make(Int(32), op->name), op->min, op->extent});
         stream << matched(")");
         stream << close_expand_button();
         stream << " " << matched("{");
+        if (cost != loop_costs.end()) {
+            stream << " " << cost_annotation(op, cost->second);
+        }
         stream << open_div("ForBody Indent", id);
         print(op->body);
         stream << close_div();
@@ -598,7 +780,15 @@ public:
         ir.accept(this);
     }
 
+    // The entry point for a whole program: computes the cost
+    // annotations before printing.
+    void print_program(Stmt ir) {
+        gather_loop_costs(ir);
+        print(ir);
+    }
+
     void print(const LoweredFunc &op) {
+        gather_loop_costs(op.body);
         scope.push(op.name, unique_id());
         stream << open_div("Function");
 
@@ -632,7 +822,18 @@ public:
         stream << close_div();
     }
 
-    StmtToHtml(string filename) : id_count(0), context_stack(1, 0) {
+    // Heat is normalized against the hottest loop in the module, so
+    // gather the costs of every function before printing any of them.
+    void gather_costs(const Module &m) {
+        for (const auto &f : m.functions()) {
+            gather_loop_costs(f.body);
+        }
+    }
+
+    StmtToHtml(string filename) : id_count(0), context_stack(1, 0), balance(40) {
+        if (const int64_t *b = as_const_int(MachineParams::generic().balance)) {
+            balance = *b;
+        }
         stream.open(filename.c_str());
         stream << "<head>";
         stream << "<style type='text/css'>" << css << "</style>\n";
@@ -695,11 +896,12 @@ function toggle(id) { \n \
 
 void print_to_html(string filename, Stmt s) {
     StmtToHtml sth(filename);
-    sth.print(s);
+    sth.print_program(s);
 }
 
 void print_to_html(string filename, const Module &m) {
     StmtToHtml sth(filename);
+    sth.gather_costs(m);
     for (const auto &b : m.buffers()) {
         sth.print(b);
     }
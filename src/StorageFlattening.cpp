@@ -49,6 +49,47 @@ private:
         return Variable::make(Int(32), name, buf, param, rdom);
     }
 
+    // The storage tile extent of each arg of a function, as set by
+    // store_tiled. Undefined entries are untiled.
+    vector<Expr> storage_tiles(const string &name) {
+        auto iter = env.find(name);
+        if (iter == env.end()) {
+            return vector<Expr>();
+        }
+        Function f = iter->second.first;
+        const vector<StorageDim> &storage_dims = f.schedule().storage_dims();
+        const vector<string> &args = f.args();
+        // Interleaved tuple realizations have an implicit innermost
+        // element dimension, which is never tiled.
+        size_t implicit_dims =
+            (f.outputs() > 1 && f.schedule().store_interleaved()) ? 1 : 0;
+        vector<Expr> tiles(args.size() + implicit_dims);
+        for (const StorageDim &d : storage_dims) {
+            for (size_t j = 0; j < args.size(); j++) {
+                if (args[j] == d.var) {
+                    tiles[j + implicit_dims] = d.tile_extent;
+                }
+            }
+        }
+        return tiles;
+    }
+
+    bool stored_interleaved(const string &name) {
+        auto iter = env.find(name);
+        return (iter != env.end() &&
+                iter->second.first.outputs() > 1 &&
+                iter->second.first.schedule().store_interleaved());
+    }
+
+    bool any_defined(const vector<Expr> &e) {
+        for (const Expr &x : e) {
+            if (x.defined()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     Expr flatten_args(const string &name, const vector<Expr> &args,
                       const Buffer<> &buf, const Parameter &param) {
         bool internal = realizations.contains(name);
@@ -60,15 +101,45 @@ private:
             mins[i] = make_shape_var(name, "min", i, buf, param);
         }
 
+        vector<Expr> tiles = storage_tiles(name);
+        if (any_defined(tiles)) {
+            user_assert(internal)
+                << "Func " << name << " is scheduled with store_tiled, "
+                << "but is accessed through a halide_buffer_t, which cannot "
+                << "describe a tiled layout. Only plain realizations in host "
+                << "memory may be stored tiled.\n";
+        }
+
+        if (stored_interleaved(name)) {
+            user_assert(internal)
+                << "Func " << name << " is scheduled with store_interleaved, "
+                << "but is accessed through a halide_buffer_t, which expects "
+                << "one buffer per Tuple element. Only plain realizations in "
+                << "host memory may be stored interleaved.\n";
+        }
+
         if (internal) {
             // f(x, y) -> f[(x-xmin)*xstride + (y-ymin)*ystride] This
             // strategy makes sense when we expect x to cancel with
             // something in xmin.  We use this for internal allocations
             for (size_t i = 0; i < args.size(); i++) {
-                if (target.has_large_buffers()) {
-                    idx += cast<int64_t>(args[i] - mins[i]) * cast<int64_t>(strides[i]);
+                Expr coord = args[i] - mins[i];
+                if (i < tiles.size() && tiles[i].defined()) {
+                    // Tiled dimensions split into an offset within
+                    // the tile, at this dimension's stride, and a
+                    // tile index at the dimension's tile stride.
+                    Expr tile_stride = make_shape_var(name, "tile_stride", i, buf, param);
+                    if (target.has_large_buffers()) {
+                        idx += cast<int64_t>(coord % tiles[i]) * cast<int64_t>(strides[i]);
+                        idx += cast<int64_t>(coord / tiles[i]) * cast<int64_t>(tile_stride);
+                    } else {
+                        idx += (coord % tiles[i]) * strides[i];
+                        idx += (coord / tiles[i]) * tile_stride;
+                    }
+                } else if (target.has_large_buffers()) {
+                    idx += cast<int64_t>(coord) * cast<int64_t>(strides[i]);
                 } else {
-                    idx += (args[i] - mins[i]) * strides[i];
+                    idx += coord * strides[i];
                 }
             }
         } else {
@@ -123,6 +194,7 @@ private:
         // host allocation size and the strides in buffer_t objects (which
         // also affects the device allocation in some backends).
         vector<Expr> allocation_extents(extents.size());
+        vector<Expr> tile_extents(extents.size()), num_tiles(extents.size());
         vector<int> storage_permutation;
         {
             auto iter = env.find(op->name);
@@ -130,19 +202,46 @@ private:
             Function f = iter->second.first;
             const vector<StorageDim> &storage_dims = f.schedule().storage_dims();
             const vector<string> &args = f.args();
+            // An interleaved tuple realization has an extra implicit
+            // dimension indexing the tuple element, innermost in both
+            // the region and the storage order.
+            int implicit_dims = (int)op->bounds.size() - (int)args.size();
+            internal_assert(implicit_dims == 0 ||
+                            (implicit_dims == 1 && f.schedule().store_interleaved()));
+            user_assert(!in_shader || implicit_dims == 0)
+                << "Func " << op->name << " is scheduled with "
+                << "store_interleaved, which is not supported for "
+                << "realizations in shader memory.\n";
+            for (int i = 0; i < implicit_dims; i++) {
+                storage_permutation.push_back(i);
+                allocation_extents[i] = extents[i];
+            }
             for (size_t i = 0; i < storage_dims.size(); i++) {
                 for (size_t j = 0; j < args.size(); j++) {
                     if (args[j] == storage_dims[i].var) {
-                        storage_permutation.push_back((int)j);
+                        size_t d = j + implicit_dims;
+                        storage_permutation.push_back((int)d);
                         Expr alignment = storage_dims[i].alignment;
                         if (alignment.defined()) {
-                            allocation_extents[j] = ((extents[j] + alignment - 1)/alignment)*alignment;
+                            allocation_extents[d] = ((extents[d] + alignment - 1)/alignment)*alignment;
                         } else {
-                            allocation_extents[j] = extents[j];
+                            allocation_extents[d] = extents[d];
+                        }
+                        Expr tile = storage_dims[i].tile_extent;
+                        if (tile.defined()) {
+                            // Tiled dimensions are padded up to whole
+                            // tiles.
+                            user_assert(!in_shader)
+                                << "Func " << op->name << " is scheduled with "
+                                << "store_tiled, which is not supported for "
+                                << "realizations in shader memory.\n";
+                            tile_extents[d] = tile;
+                            num_tiles[d] = (allocation_extents[d] + tile - 1)/tile;
+                            allocation_extents[d] = num_tiles[d]*tile;
                         }
                     }
                 }
-                internal_assert(storage_permutation.size() == i+1);
+                internal_assert(storage_permutation.size() == i+1+implicit_dims);
             }
         }
 
@@ -180,20 +279,43 @@ private:
         stmt = LetStmt::make(op->name + ".buffer", builder.build(), stmt);
 
         // Make the allocation node
-        stmt = Allocate::make(op->name, op->types[0], allocation_extents, condition, stmt);
-
-        // Compute the strides
-        for (int i = (int)op->bounds.size()-1; i > 0; i--) {
-            int prev_j = storage_permutation[i-1];
+        stmt = Allocate::make(op->name, op->types[0], allocation_extents, condition, stmt,
+                              Expr(), std::string(), op->memory_type);
+
+        // Compute the strides. In storage order, each dimension's
+        // stride is the previous dimension's stride times its extent.
+        // For a tiled layout the conceptual dimensions are: the
+        // within-tile offsets of every dimension in storage order
+        // (tiled ones with the tile extent for their extent), then
+        // the tile indices of the tiled dimensions, again in storage
+        // order, each with the number of tiles for its extent.
+        vector<string> ordered_name;
+        vector<Expr> ordered_extent;
+        for (int i = 0; i < (int)op->bounds.size(); i++) {
+            int j = storage_permutation[i];
+            if (tile_extents[j].defined()) {
+                ordered_name.push_back(stride_name[j]);
+                ordered_extent.push_back(tile_extents[j]);
+            } else {
+                ordered_name.push_back(stride_name[j]);
+                ordered_extent.push_back(allocation_extents[j]);
+            }
+        }
+        for (int i = 0; i < (int)op->bounds.size(); i++) {
             int j = storage_permutation[i];
-            Expr stride = stride_var[prev_j] * allocation_extents[prev_j];
-            stmt = LetStmt::make(stride_name[j], stride, stmt);
+            if (tile_extents[j].defined()) {
+                ordered_name.push_back(op->name + ".tile_stride." + std::to_string(j));
+                ordered_extent.push_back(num_tiles[j]);
+            }
         }
-
-        // Innermost stride is one
-        if (dims > 0) {
-            int innermost = storage_permutation.empty() ? 0 : storage_permutation[0];
-            stmt = LetStmt::make(stride_name[innermost], 1, stmt);
+        for (int i = (int)ordered_name.size()-1; i >= 0; i--) {
+            Expr stride;
+            if (i == 0) {
+                stride = 1;
+            } else {
+                stride = Variable::make(Int(32), ordered_name[i-1]) * ordered_extent[i-1];
+            }
+            stmt = LetStmt::make(ordered_name[i], stride, stmt);
         }
 
         // Assign the mins and extents stored
@@ -407,7 +529,7 @@ class PromoteToMemoryType : public IRMutator {
             }
             stmt = Allocate::make(op->name, t, extents,
                                   mutate(op->condition), mutate(op->body),
-                                  mutate(op->new_expr), op->free_function);
+                                  mutate(op->new_expr), op->free_function, op->memory_type);
         } else {
             IRMutator::visit(op);
         }
@@ -428,7 +550,7 @@ Stmt storage_flattening(Stmt s,
     // all point to the function foo.
     map<string, pair<Function, int>> tuple_env;
     for (auto p : env) {
-        if (p.second.outputs() > 1) {
+        if (p.second.outputs() > 1 && !p.second.schedule().store_interleaved()) {
             for (int i = 0; i < p.second.outputs(); i++) {
                 tuple_env[p.first + "." + std::to_string(i)] = {p.second, i};
             }
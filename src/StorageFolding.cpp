@@ -50,6 +50,53 @@ int count_producers(Stmt in, const std::string &name) {
     return counter.count;
 }
 
+// Count the number of references to a particular func: calls to it,
+// provides to it, references to its buffer, and its produce/consume
+// markers.
+class CountRefs : public IRVisitor {
+    const std::string &name;
+
+    void visit(const Call *op) {
+        IRVisitor::visit(op);
+        if (op->name == name && op->call_type == Call::Halide) {
+            count++;
+        }
+    }
+
+    void visit(const Provide *op) {
+        IRVisitor::visit(op);
+        if (op->name == name) {
+            count++;
+        }
+    }
+
+    void visit(const Variable *op) {
+        if (starts_with(op->name, name + ".")) {
+            count++;
+        }
+    }
+
+    void visit(const ProducerConsumer *op) {
+        IRVisitor::visit(op);
+        if (op->name == name) {
+            count++;
+        }
+    }
+
+    using IRVisitor::visit;
+
+public:
+    int count = 0;
+
+    CountRefs(const std::string &name) : name(name) {}
+};
+
+int count_refs(Stmt in, const std::string &name) {
+    CountRefs counter(name);
+    in.accept(&counter);
+    return counter.count;
+}
+
 // Fold the storage of a function in a particular dimension by a particular factor
 class FoldStorageOfFunction : public IRMutator {
     string func;
@@ -311,12 +358,11 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
 
     void visit(const For *op) {
         if (op->for_type != ForType::Serial && op->for_type != ForType::Unrolled) {
-            // We can't proceed into a parallel for loop.
-
-            // TODO: If there's no overlap between the region touched
-            // by the threads as this loop counter varies
-            // (i.e. there's no cross-talk between threads), then it's
-            // safe to proceed.
+            // We can't proceed into a parallel for loop: the
+            // iterations would alias each other in the folded
+            // buffer. PrivatizeForFolding below handles the case
+            // where the buffer can be made private to each iteration
+            // instead.
             stmt = op;
             return;
         }
@@ -484,6 +530,76 @@ public:
         : func(f), explicit_only(explicit_only) {}
 };
 
+// Storage folding gives up at parallel loops, because the iterations
+// would alias each other in the folded buffer. If every reference to
+// the func sits inside a single parallel loop, and no values flow from
+// one iteration to another through the buffer, then each iteration can
+// get a private copy instead: sink the realization into the loop body
+// and fold it there. The per-iteration realization is captured by the
+// closure of the parallel task like any other local allocation.
+class PrivatizeForFolding : public IRMutator {
+    const Realize *realize;
+    Function func;
+    int total_refs;
+
+    using IRMutator::visit;
+
+    void visit(const For *op) {
+        if (folded ||
+            op->for_type == ForType::Serial ||
+            op->for_type == ForType::Unrolled) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        if (count_refs(op->body, realize->name) != total_refs) {
+            // Some references sit outside this loop, so the buffer is
+            // genuinely shared. Maybe an inner parallel loop contains
+            // them all.
+            IRMutator::visit(op);
+            return;
+        }
+
+        // Values may not be communicated from one iteration to the
+        // next (e.g. due to sliding over this loop).
+        Box provided = box_provided(op->body, realize->name);
+        Box required = box_required(op->body, realize->name);
+        if (!box_contains(provided, required)) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        // Only privatize if it actually unlocks a fold; a
+        // per-iteration allocation is not worth it otherwise.
+        bool explicit_only = count_producers(op->body, realize->name) != 1;
+        AttemptStorageFoldingOfFunction folder(func, explicit_only);
+        Stmt body = folder.mutate(op->body);
+        if (folder.dims_folded.empty()) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        Region bounds = realize->bounds;
+        for (size_t i = 0; i < folder.dims_folded.size(); i++) {
+            int d = folder.dims_folded[i].dim;
+            Expr f = folder.dims_folded[i].factor;
+            internal_assert(d >= 0 && d < (int)bounds.size());
+            bounds[d] = Range(0, f);
+        }
+
+        body = Realize::make(realize->name, realize->types, bounds,
+                             realize->condition, body, realize->memory_type);
+        stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+        folded = true;
+    }
+
+public:
+    bool folded = false;
+
+    PrivatizeForFolding(const Realize *realize, Function func, int total_refs)
+        : realize(realize), func(func), total_refs(total_refs) {}
+};
+
 // Look for opportunities for storage folding in a statement
 class StorageFolding : public IRMutator {
     const map<string, Function> &env;
@@ -505,10 +621,23 @@ class StorageFolding : public IRMutator {
         debug(3) << "Attempting to fold " << op->name << "\n";
         body = folder.mutate(body);
 
+        if (folder.dims_folded.empty() && func_it != env.end()) {
+            // The fold attempt may have given up at a parallel
+            // loop. If the buffer can be made private to each loop
+            // iteration, folding a private copy per iteration may
+            // still work.
+            PrivatizeForFolding privatizer(op, func, count_refs(body, op->name));
+            Stmt privatized = privatizer.mutate(body);
+            if (privatizer.folded) {
+                stmt = privatized;
+                return;
+            }
+        }
+
         if (body.same_as(op->body)) {
             stmt = op;
         } else if (folder.dims_folded.empty()) {
-            stmt = Realize::make(op->name, op->types, op->bounds, op->condition, body);
+            stmt = Realize::make(op->name, op->types, op->bounds, op->condition, body, op->memory_type);
         } else {
             Region bounds = op->bounds;
 
@@ -521,7 +650,7 @@ class StorageFolding : public IRMutator {
                 bounds[d] = Range(0, f);
             }
 
-            stmt = Realize::make(op->name, op->types, bounds, op->condition, body);
+            stmt = Realize::make(op->name, op->types, bounds, op->condition, body, op->memory_type);
         }
     }
 
@@ -0,0 +1,178 @@
+#include "StreamReadback.h"
+
+#include "Bounds.h"
+#include "Function.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+#include "InjectHostDevBufferCopies.h"
+#include "Simplify.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+/** Does a statement contain any device loops? */
+class HasGPULoop : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) override {
+        if (op->for_type == ForType::GPUBlock ||
+            op->for_type == ForType::GPUThread) {
+            result = true;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+public:
+    bool result = false;
+};
+
+/** Inject calls to halide_readback_slice at the bottom of the
+ * outermost serial loop wrapping device work in the producer of a
+ * single function, and a halide_readback_fence after the producer. */
+class StreamReadback : public IRMutator2 {
+    const Function &func;
+    int slices;
+    bool in_produce = false;
+    bool injected = false;
+
+    using IRMutator2::visit;
+
+    Expr buffer_var() {
+        Parameter output_buf = func.output_buffers()[0];
+        return Variable::make(type_of<halide_buffer_t *>(),
+                              func.name() + ".buffer", output_buf);
+    }
+
+    Stmt visit(const ProducerConsumer *op) override {
+        if (op->is_producer && op->name == func.name()) {
+            in_produce = true;
+            Stmt body = mutate(op->body);
+            in_produce = false;
+            if (injected) {
+                // All slabs have been issued by the time the producer
+                // finishes. Wait for them to land (and mark the host
+                // copy clean) before anything consumes the output.
+                Stmt fence = call_extern_and_assert("halide_readback_fence",
+                                                    {buffer_var()});
+                body = Block::make(body, fence);
+            }
+            return ProducerConsumer::make(op->name, op->is_producer, body);
+        } else {
+            return IRMutator2::visit(op);
+        }
+    }
+
+    Stmt visit(const For *op) override {
+        if (!in_produce || injected || op->for_type != ForType::Serial) {
+            return IRMutator2::visit(op);
+        }
+
+        HasGPULoop gpu;
+        op->body.accept(&gpu);
+        if (!gpu.result) {
+            return IRMutator2::visit(op);
+        }
+
+        // This is the outermost host-side serial loop wrapping device
+        // work in the producer. Each of its iterations produces a
+        // slab of the output; figure out which slab as a function of
+        // the loop variable.
+        int d = (int)func.args().size() - 1;
+        Box box = box_provided(op->body, func.name());
+        internal_assert((int)box.size() == d + 1);
+        Expr slab_lo = box[d].min, slab_hi = box[d].max;
+        internal_assert(slab_lo.defined() && slab_hi.defined());
+
+        // The read-back of a slab must not race with a later
+        // iteration still writing to it, so successive iterations
+        // must cover disjoint, contiguous, ascending ranges of the
+        // outermost storage dimension.
+        Expr next_lo = substitute(op->name, Variable::make(Int(32), op->name) + 1, slab_lo);
+        bool monotone = can_prove(next_lo >= slab_lo);
+        bool contiguous = can_prove(next_lo <= slab_hi + 1);
+        user_assert(monotone && contiguous)
+            << "Cannot stream the read-back of output " << func.name()
+            << ", because the loop " << op->name
+            << " does not advance monotonically and contiguously over the "
+            << "outermost storage dimension of " << func.name() << ". "
+            << "Schedule the loop wrapping the device loops to slice the "
+            << "outermost dimension of the output instead.\n";
+
+        // Group the iterations into approximately 'slices' read-backs
+        // rather than issuing one per iteration, which would drown
+        // the transfer queue in tiny copies for fine-grained loops. A
+        // read-back is issued at the bottom of the last iteration of
+        // each group, and covers everything the group produced.
+        Expr i = Variable::make(Int(32), op->name) - op->min;
+        Expr group = (i * slices) / op->extent;
+        Expr next_group = ((i + 1) * slices) / op->extent;
+        Expr last_in_group = next_group > group;
+        // The first iteration of the current group.
+        Expr group_start = (group * op->extent + slices - 1) / slices;
+        Expr copy_min = substitute(op->name, op->min + group_start, slab_lo);
+        Expr copy_extent = slab_hi - copy_min + 1;
+
+        Stmt issue = call_extern_and_assert(
+            "halide_readback_slice",
+            {buffer_var(), simplify(copy_min), simplify(copy_extent)});
+        issue = IfThenElse::make(simplify(last_in_group), issue);
+
+        injected = true;
+        return For::make(op->name, op->min, op->extent,
+                         op->for_type, op->device_api,
+                         Block::make(op->body, issue));
+    }
+
+public:
+    StreamReadback(const Function &f, int slices)
+        : func(f), slices(slices) {}
+};
+
+}  // namespace
+
+Stmt inject_stream_readback(Stmt s,
+                            const vector<Function> &outputs,
+                            const map<string, Function> &env) {
+    for (const auto &p : env) {
+        const Function &f = p.second;
+        int slices = f.schedule().stream_readback_slices();
+        if (slices == 0) {
+            continue;
+        }
+
+        bool is_output = false;
+        for (const Function &o : outputs) {
+            is_output |= o.same_as(f);
+        }
+        user_assert(is_output)
+            << "Func " << f.name() << " is scheduled with stream_readback, "
+            << "but is not an output of the pipeline. Only outputs are read "
+            << "back to the host.\n";
+        user_assert(!f.has_update_definition())
+            << "Func " << f.name() << " is scheduled with stream_readback, "
+            << "but has update definitions, so it is not produced in a "
+            << "single pass over its storage.\n";
+        user_assert(f.outputs() == 1)
+            << "Func " << f.name() << " is scheduled with stream_readback, "
+            << "but is a Tuple-valued Func, which is not supported.\n";
+        user_assert(!f.args().empty())
+            << "Func " << f.name() << " is scheduled with stream_readback, "
+            << "but is zero-dimensional, so there is nothing to slice.\n";
+
+        StreamReadback sr(f, slices);
+        s = sr.mutate(s);
+    }
+    return s;
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,31 @@
+#ifndef HALIDE_STREAM_READBACK_H
+#define HALIDE_STREAM_READBACK_H
+
+/** \file
+ * Defines the lowering pass that issues incremental device -> host
+ * read-backs of outputs scheduled with Func::stream_readback.
+ */
+
+#include <map>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** For each output function marked with Func::stream_readback, find
+ * the outermost serial loop in its producer that wraps device work,
+ * and inject calls to halide_readback_slice at the bottom of that
+ * loop so that completed slabs of the output are copied back to the
+ * host while later device work runs, followed by a call to
+ * halide_readback_fence after the producer. Functions whose
+ * producers contain no device loops are left alone. Must run before
+ * storage flattening. */
+Stmt inject_stream_readback(Stmt s,
+                            const std::vector<Function> &outputs,
+                            const std::map<std::string, Function> &env);
+
+}
+}
+
+#endif
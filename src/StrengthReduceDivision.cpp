@@ -0,0 +1,184 @@
+#include "StrengthReduceDivision.h"
+#include "ExprUsesVar.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+
+namespace Halide {
+namespace Internal {
+
+namespace {
+
+class StrengthReduceDivision : public IRMutator2 {
+    using IRMutator2::visit;
+
+    // Loop variables of enclosing loops, plus let bindings that
+    // (transitively) depend on them. Everything else is invariant and
+    // will be hoisted by loop_invariant_code_motion.
+    Scope<int> varying;
+    int loop_depth = 0;
+
+    // We only win if the divide executes repeatedly while the magic
+    // numbers are computed once: the numerator must vary with some
+    // enclosing loop that the denominator is invariant to. Constant
+    // denominators are better served by the tables in codegen.
+    bool should_reduce(const Expr &num, const Expr &den) {
+        Type t = den.type();
+        return (loop_depth > 0 &&
+                (t.is_int() || t.is_uint()) &&
+                (t.bits() == 8 || t.bits() == 16 || t.bits() == 32) &&
+                !is_const(den) &&
+                !expr_uses_vars(den, varying) &&
+                expr_uses_vars(num, varying));
+    }
+
+    // Rewrite num / den as a fixed-point multiply, following
+    // "Division by Invariant Integers using Multiplication" by
+    // Granlund and Montgomery (the same methods find_inverse.cpp uses
+    // to build the FastIntegerDivide tables, but with the magic
+    // numbers computed at runtime instead of looked up).
+    Expr reduced_div(const Expr &num, const Expr &den) {
+        Type t = num.type();
+        internal_assert(den.type() == t);
+        const int bits = t.bits();
+        const int lanes = t.lanes();
+
+        // Vector denominators are almost always broadcasts of a
+        // scalar. Compute the magic numbers on the scalar, so they
+        // stay hoistable (loop_invariant_code_motion declines to lift
+        // vectors), and broadcast the results.
+        Expr d = den;
+        if (const Broadcast *b = den.as<Broadcast>()) {
+            d = b->value;
+        }
+        Type et = d.type();
+        Type uet = UInt(bits, et.lanes());
+        Type uwide_et = UInt(bits * 2, et.lanes());
+        Type uwide = UInt(bits * 2, lanes);
+
+        auto spread = [&](Expr e) {
+            if (e.type().lanes() != lanes) {
+                e = Broadcast::make(e, lanes);
+            }
+            return e;
+        };
+
+        Expr q;
+        if (t.is_uint()) {
+            // Round-up method: with sh = ceil(log2(d)) and
+            // m = floor(2^(bits+sh) / d) + 1 truncated to bits bits,
+            //   n / d == (q0 + ((n - q0) >> 1)) >> (sh - 1)
+            // where q0 = mulhi(m, n), for any n and any d >= 2. The
+            // averaging step recovers the truncated top bit of m
+            // without overflowing. Clamping d away from 0 and 1 keeps
+            // count_leading_zeros and the division defined; those
+            // denominators are handled by the select at the end.
+            Expr safe_d = select(d <= 1, make_const(et, 2), d);
+            Expr lz = count_leading_zeros(safe_d - 1);  // bits - ceil(log2(d))
+            Expr m = cast(et, (~make_zero(uwide_et) >> cast(uwide_et, lz)) /
+                                  cast(uwide_et, safe_d) + 1);
+            Expr shift = cast(et, bits - 1) - lz;  // sh - 1
+
+            Expr q0 = cast(t, (cast(uwide, spread(m)) * cast(uwide, num)) >>
+                                  make_const(uwide, bits));
+            q = (q0 + ((num - q0) >> make_one(t))) >> spread(shift);
+            q = select(den <= make_one(t), num, q);
+        } else {
+            // Divide the magnitudes, then correct the truncating
+            // quotient to a flooring one the way lower_euclidean_div
+            // does. The magnitudes are computed as uints so that
+            // INT_MIN is representable.
+            Type ut = UInt(bits, lanes);
+            Expr dsign = d >> make_const(et, bits - 1);
+            Expr au = (cast(uet, d) ^ cast(uet, dsign)) - cast(uet, dsign);
+            Expr safe_au = select(au <= 1, make_const(uet, 2), au);
+            Expr lz = count_leading_zeros(safe_au - 1);
+            // Round-down method: with sh = ceil(log2(|d|)) - 1 and
+            // m = ceil(2^(bits+sh) / |d|), which always fits in bits
+            // bits for the halved numerator range,
+            //   v / |d| == mulhi(m, v) >> sh   for v <= 2^(bits-1).
+            Expr m = cast(uet, (~make_zero(uwide_et) >> cast(uwide_et, lz + 1)) /
+                                   cast(uwide_et, safe_au) + 1);
+            Expr shift = cast(uet, bits - 1) - lz;  // sh
+
+            Expr xsign = num >> make_const(t, bits - 1);
+            Expr an = (cast(ut, num) ^ cast(ut, xsign)) - cast(ut, xsign);
+            Expr q0 = (cast(uwide, spread(m)) * cast(uwide, an)) >>
+                      make_const(uwide, bits);
+            q0 = cast(ut, q0) >> spread(shift);
+            // Apply the sign of the true quotient, then nudge
+            // negative inexact quotients down by examining the
+            // implied remainder.
+            Expr su = cast(ut, xsign ^ spread(dsign));
+            Expr qt = cast(t, (q0 ^ su) - su);
+            Expr r = num - qt * den;
+            Expr rs = r >> make_const(t, bits - 1);
+            Expr bs = den >> make_const(t, bits - 1);
+            q = qt - (rs & bs) + (rs & ~bs);
+            q = select(den == make_const(t, -1), make_zero(t) - num,
+                       select(den == make_one(t) || den == make_zero(t), num, q));
+        }
+        internal_assert(q.type() == t);
+        return q;
+    }
+
+    Expr visit(const Div *op) override {
+        if (should_reduce(op->a, op->b)) {
+            return reduced_div(mutate(op->a), mutate(op->b));
+        }
+        return IRMutator2::visit(op);
+    }
+
+    Expr visit(const Mod *op) override {
+        if (should_reduce(op->a, op->b)) {
+            Expr num = mutate(op->a);
+            Expr den = mutate(op->b);
+            // The quotient subexpression is shared with any matching
+            // division by common_subexpression_elimination.
+            return num - reduced_div(num, den) * den;
+        }
+        return IRMutator2::visit(op);
+    }
+
+    template<typename LetOrLetStmt>
+    auto visit_let(const LetOrLetStmt *op) -> decltype(op->body) {
+        Expr value = mutate(op->value);
+        bool varies = expr_uses_vars(value, varying);
+        if (varies) {
+            varying.push(op->name, 0);
+        }
+        auto body = mutate(op->body);
+        if (varies) {
+            varying.pop(op->name);
+        }
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            return op;
+        }
+        return LetOrLetStmt::make(op->name, value, body);
+    }
+
+    Expr visit(const Let *op) override {
+        return visit_let(op);
+    }
+
+    Stmt visit(const LetStmt *op) override {
+        return visit_let(op);
+    }
+
+    Stmt visit(const For *op) override {
+        ScopedBinding<int> p(varying, op->name, 0);
+        loop_depth++;
+        Stmt stmt = IRMutator2::visit(op);
+        loop_depth--;
+        return stmt;
+    }
+};
+
+}  // namespace
+
+Stmt strength_reduce_division(Stmt s) {
+    return StrengthReduceDivision().mutate(s);
+}
+
+}
+}
@@ -0,0 +1,28 @@
+#ifndef HALIDE_STRENGTH_REDUCE_DIVISION_H
+#define HALIDE_STRENGTH_REDUCE_DIVISION_H
+
+/** \file
+ * Defines the lowering pass that replaces integer division and
+ * modulo by loop-invariant denominators with multiply-shift
+ * sequences.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Rewrite integer division and modulo by non-constant,
+ * loop-invariant denominators into a fixed-point
+ * multiply-and-shift. The magic numbers are computed at runtime with
+ * a single division, which loop-invariant code motion then hoists out
+ * of the loop, so each element costs a widening multiply and a few
+ * shifts instead of a hardware divide. Divisions by constants are
+ * left alone; codegen already handles those. Must run before
+ * loop_invariant_code_motion. */
+Stmt strength_reduce_division(Stmt s);
+
+}
+}
+
+#endif
@@ -22,6 +22,12 @@ class Substitute : public IRMutator {
         }
     }
 
+    // Names not being replaced never need to go into the hidden
+    // scope; skipping them keeps it empty in the common case.
+    bool replaces(const string &s) {
+        return replace.find(s) != replace.end();
+    }
+
 public:
     Substitute(const map<string, Expr> &m) : replace(m) {}
 
@@ -38,9 +44,14 @@ public:
 
     void visit(const Let *op) {
         Expr new_value = mutate(op->value);
-        hidden.push(op->name, 0);
+        bool shadows = replaces(op->name);
+        if (shadows) {
+            hidden.push(op->name, 0);
+        }
         Expr new_body = mutate(op->body);
-        hidden.pop(op->name);
+        if (shadows) {
+            hidden.pop(op->name);
+        }
 
         if (new_value.same_as(op->value) &&
             new_body.same_as(op->body)) {
@@ -52,9 +63,14 @@ public:
 
     void visit(const LetStmt *op) {
         Expr new_value = mutate(op->value);
-        hidden.push(op->name, 0);
+        bool shadows = replaces(op->name);
+        if (shadows) {
+            hidden.push(op->name, 0);
+        }
         Stmt new_body = mutate(op->body);
-        hidden.pop(op->name);
+        if (shadows) {
+            hidden.pop(op->name);
+        }
 
         if (new_value.same_as(op->value) &&
             new_body.same_as(op->body)) {
@@ -68,9 +84,14 @@ public:
 
         Expr new_min = mutate(op->min);
         Expr new_extent = mutate(op->extent);
-        hidden.push(op->name, 0);
+        bool shadows = replaces(op->name);
+        if (shadows) {
+            hidden.push(op->name, 0);
+        }
         Stmt new_body = mutate(op->body);
-        hidden.pop(op->name);
+        if (shadows) {
+            hidden.pop(op->name);
+        }
 
         if (new_min.same_as(op->min) &&
             new_extent.same_as(op->extent) &&
@@ -255,6 +255,9 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"hvx_v62", Target::HVX_v62},
     {"hvx_v65", Target::HVX_v65},
     {"hvx_v66", Target::HVX_v66},
+    {"sve_256", Target::SVE_256},
+    {"arm_dot_prod", Target::ARMDotProd},
+    {"profile_loops", Target::ProfileLoops},
     {"hvx_shared_object", Target::HVX_shared_object},
     {"fuzz_float_stores", Target::FuzzFloatStores},
     {"soft_float_abi", Target::SoftFloatABI},
@@ -266,6 +269,9 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"trace_loads", Target::TraceLoads},
     {"trace_stores", Target::TraceStores},
     {"trace_realizations", Target::TraceRealizations},
+    {"unchecked_entry", Target::UncheckedEntry},
+    {"arm_fp16", Target::ARMFp16},
+    {"no_error_strings", Target::NoErrorStrings},
 };
 
 bool lookup_feature(const std::string &tok, Target::Feature &result) {
@@ -353,6 +359,12 @@ bool merge_string(Target &t, const std::string &target) {
         }
     }
 
+    if (t.has_feature(Target::ProfileLoops)) {
+        // Loop-level profiling is an extension of the regular
+        // sampling profiler.
+        t.set_feature(Target::Profile);
+    }
+
     if (arch_specified && !bits_specified) {
         return false;
     }
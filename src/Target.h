@@ -74,6 +74,9 @@ struct Target {
         HVX_v62 = halide_target_feature_hvx_v62,
         HVX_v65 = halide_target_feature_hvx_v65,
         HVX_v66 = halide_target_feature_hvx_v66,
+        SVE_256 = halide_target_feature_sve_256,
+        ARMDotProd = halide_target_feature_arm_dot_prod,
+        ProfileLoops = halide_target_feature_profile_loops,
         HVX_shared_object = halide_target_feature_hvx_use_shared_object,
         FuzzFloatStores = halide_target_feature_fuzz_float_stores,
         SoftFloatABI = halide_target_feature_soft_float_abi,
@@ -85,6 +88,9 @@ struct Target {
         TraceLoads = halide_target_feature_trace_loads,
         TraceStores = halide_target_feature_trace_stores,
         TraceRealizations = halide_target_feature_trace_realizations,
+        UncheckedEntry = halide_target_feature_unchecked_entry,
+        ARMFp16 = halide_target_feature_arm_fp16,
+        NoErrorStrings = halide_target_feature_no_error_strings,
         FeatureEnd = halide_target_feature_end
     };
     Target() : os(OSUnknown), arch(ArchUnknown), bits(0) {}
@@ -276,6 +282,14 @@ struct Target {
                 // SSE was all 128-bit. We ignore MMX.
                 return 16 / data_size;
             }
+        } else if (arch == Target::ARM) {
+            if (bits == 64 && has_feature(Halide::Target::SVE_256)) {
+                // SVE with 256-bit vectors.
+                return 32 / data_size;
+            } else {
+                // NEON is 128-bit.
+                return 16 / data_size;
+            }
         } else {
             // Assume 128-bit vectors on other targets.
             return 16 / data_size;
@@ -2,10 +2,13 @@
 #define HALIDE_THREAD_POOL_H
 
 #include <condition_variable>
+#include <functional>
 #include <future>
+#include <iterator>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 #ifdef _MSC_VER
 #else
@@ -135,6 +138,49 @@ public:
     }
 };
 
+/** The number of threads to use for parallel work done at compile
+ * time (lowering, codegen for multiple sub-targets, etc.). Respects
+ * HL_NUM_THREADS, the same variable that sizes the runtime's thread
+ * pool, so bounding a process's thread usage bounds compilation as
+ * well as execution. Defaults to the number of processors online. */
+inline size_t num_compile_time_threads() {
+    char *threads_str = getenv("HL_NUM_THREADS");
+    if (threads_str) {
+        int threads = atoi(threads_str);
+        if (threads > 0) {
+            return (size_t)threads;
+        }
+    }
+    return ThreadPool<void>::num_processors_online();
+}
+
+/** Run f on every element of a collection using a temporary
+ * ThreadPool, blocking until all invocations are done. The elements
+ * are passed by reference, so f may mutate them; f must not touch
+ * state shared between elements without its own synchronization. With
+ * num_threads == 1, or a collection of at most one element, runs
+ * serially without spawning threads. */
+template<typename Collection, typename F>
+void parallel_for_each(Collection &collection, F f,
+                       size_t num_threads = num_compile_time_threads()) {
+    const size_t size = std::distance(std::begin(collection), std::end(collection));
+    if (num_threads <= 1 || size <= 1) {
+        for (auto &item : collection) {
+            f(item);
+        }
+        return;
+    }
+    ThreadPool<void> pool(std::min(num_threads, size));
+    std::vector<std::future<void>> futures;
+    for (auto &item : collection) {
+        auto *item_ptr = &item;
+        futures.push_back(pool.async([f, item_ptr]() { f(*item_ptr); }));
+    }
+    for (auto &future : futures) {
+        future.get();
+    }
+}
+
 template<typename T>
 inline void ThreadPool<T>::Job::run_unlocked(std::unique_lock<std::mutex> &unique_lock) {
     unique_lock.unlock();
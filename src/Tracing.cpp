@@ -189,12 +189,12 @@ private:
             Stmt new_body = op->body;
             new_body = Block::make(new_body, Evaluate::make(call_after));
             new_body = LetStmt::make(op->name + ".trace_id", call_before, new_body);
-            stmt = Realize::make(op->name, op->types, op->bounds, op->condition, new_body);
+            stmt = Realize::make(op->name, op->types, op->bounds, op->condition, new_body, op->memory_type);
         } else if (f.is_tracing_stores() || f.is_tracing_loads()) {
             // We need a trace id defined to pass to the loads and stores
             Stmt new_body = op->body;
             new_body = LetStmt::make(op->name + ".trace_id", 0, new_body);
-            stmt = Realize::make(op->name, op->types, op->bounds, op->condition, new_body);
+            stmt = Realize::make(op->name, op->types, op->bounds, op->condition, new_body, op->memory_type);
         }
 
     }
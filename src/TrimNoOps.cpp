@@ -428,6 +428,54 @@ class TrimNoOps : public IRMutator {
     }
 };
 
+/** Guard loops scheduled with Func::skip_strips: the body of each
+ * marked loop is wrapped in a test of the (runtime-varying) predicate,
+ * so the whole iteration - typically a strip produced by split() - is
+ * skipped for the cost of one test when the predicate says there is
+ * nothing to do. This is the runtime counterpart of the static
+ * trimming above, for no-op regions that change from run to run. */
+class SkipPredicatedStrips : public IRMutator {
+    struct Guard {
+        string func, var;
+        Expr skip;
+    };
+    vector<Guard> guards;
+
+    using IRMutator::visit;
+
+    void visit(const For *op) {
+        IRMutator::visit(op);
+        op = stmt.as<For>();
+        internal_assert(op);
+        for (const Guard &g : guards) {
+            // Loops of this func are named func.s<stage>.var
+            if (starts_with(op->name, g.func + ".s") &&
+                ends_with(op->name, "." + g.var)) {
+                Expr skip = substitute(g.var, Variable::make(Int(32), op->name), g.skip);
+                Stmt body = IfThenElse::make(!skip, op->body);
+                stmt = For::make(op->name, op->min, op->extent,
+                                 op->for_type, op->device_api, body);
+                return;
+            }
+        }
+    }
+
+public:
+    SkipPredicatedStrips(const map<string, Function> &env) {
+        for (const auto &i : env) {
+            const FuncSchedule &s = i.second.schedule();
+            if (!s.skip_strips_var().empty()) {
+                internal_assert(s.skip_strips_predicate().defined());
+                guards.push_back({i.first, s.skip_strips_var(), s.skip_strips_predicate()});
+            }
+        }
+    }
+
+    bool any_guards() const {
+        return !guards.empty();
+    }
+};
+
 }
 
 Stmt trim_no_ops(Stmt s) {
@@ -435,5 +483,13 @@ Stmt trim_no_ops(Stmt s) {
     return s;
 }
 
+Stmt skip_predicated_strips(Stmt s, const map<string, Function> &env) {
+    SkipPredicatedStrips skipper(env);
+    if (skipper.any_guards()) {
+        s = skipper.mutate(s);
+    }
+    return s;
+}
+
 }
 }
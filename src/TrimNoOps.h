@@ -6,7 +6,10 @@
  * which they actually do something.
  */
 
+#include <map>
+
 #include "IR.h"
+#include "Function.h"
 
 namespace Halide {
 namespace Internal {
@@ -15,6 +18,14 @@ namespace Internal {
  * something. For examples see test/correctness/trim_no_ops.cpp */
 EXPORT Stmt trim_no_ops(Stmt s);
 
+/** Guard loops scheduled with Func::skip_strips with their runtime
+ * predicates, so iterations the predicate rules out are skipped for
+ * the cost of one test each. The runtime counterpart of trim_no_ops,
+ * for no-op regions that vary from run to run; runs early in
+ * lowering, before bounds inference, so reads performed by the
+ * predicates participate in the usual bounds machinery. */
+EXPORT Stmt skip_predicated_strips(Stmt s, const std::map<std::string, Function> &env);
+
 }
 }
 
@@ -294,6 +294,7 @@ struct Type {
     static const halide_type_code_t UInt = halide_type_uint;
     static const halide_type_code_t Float = halide_type_float;
     static const halide_type_code_t Handle = halide_type_handle;
+    static const halide_type_code_t BFloat = halide_type_bfloat;
     // @}
 
     /** The number of bytes required to store a single scalar value of this type. Ignores vector lanes. */
@@ -368,6 +369,9 @@ struct Type {
     /** Is this type a floating point type (float or double). */
     bool is_float() const {return code() == Float;}
 
+    /** Is this type a floating point type in the bfloat format? */
+    bool is_bfloat() const {return code() == BFloat;}
+
     /** Is this type a signed integer type? */
     bool is_int() const {return code() == Int;}
 
@@ -448,6 +452,15 @@ inline Type Float(int bits, int lanes = 1) {
     return Type(Type::Float, bits, lanes);
 }
 
+/** Construct a floating-point type in the bfloat format. Only 16-bit
+ * bfloats are supported. Arithmetic on bfloat values is emulated by
+ * widening to 32-bit float, computing, and rounding back (see
+ * EmulateFloat16Math.h), so bfloat is best used as a storage type
+ * with explicit casts to Float(32) around the math. */
+inline Type BFloat(int bits, int lanes = 1) {
+    return Type(Type::BFloat, bits, lanes);
+}
+
 /** Construct a boolean type */
 inline Type Bool(int lanes = 1) {
     return UInt(1, lanes);
@@ -3,15 +3,59 @@
 #include "IROperator.h"
 #include "Simplify.h"
 #include "Substitute.h"
+#include "Util.h"
+
+#include <cstdlib>
 
 using std::vector;
 
 namespace Halide {
 namespace Internal {
 
+namespace {
+
+// A proxy for the code size of a statement: the number of memory
+// operations and calls in it. These are what dominate the instruction
+// count of a stamped-out loop body after lowering; the pure
+// arithmetic in between mostly folds or stays in registers.
+class CountOps : public IRVisitor {
+    using IRVisitor::visit;
+    void visit(const Load *op) {
+        count++;
+        IRVisitor::visit(op);
+    }
+    void visit(const Store *op) {
+        count++;
+        IRVisitor::visit(op);
+    }
+    void visit(const Call *op) {
+        count++;
+        IRVisitor::visit(op);
+    }
+public:
+    int count = 0;
+};
+
+int count_ops(Stmt s) {
+    CountOps counter;
+    s.accept(&counter);
+    return counter.count;
+}
+
+}  // namespace
+
 class UnrollLoops : public IRMutator {
     using IRMutator::visit;
 
+    // Refuse unrolls whose fully-unrolled, simplified body exceeds
+    // this many ops (see CountOps above), and keep them as serial
+    // loops instead. Big unrolled bodies blow out the icache, and the
+    // cost shows up in whatever runs next rather than in the loop
+    // itself, so it's easy to ship one by accident. Set the
+    // environment variable HL_UNROLL_BUDGET to adjust the limit, or
+    // to zero to unroll unconditionally.
+    int unroll_budget;
+
     void visit(const For *for_loop) {
         if (for_loop->for_type == ForType::Unrolled) {
             // Give it one last chance to simplify to an int
@@ -27,16 +71,41 @@ class UnrollLoops : public IRMutator {
             }
 
             vector<Stmt> iters;
-            // Make n copies of the body, each wrapped in a let that defines the loop var for that body
+            // Make n copies of the body, each wrapped in a let that
+            // defines the loop var for that body. Simplify each copy
+            // immediately, so that branches that are dead in a
+            // particular iteration fold away before we measure the
+            // result against the unroll budget.
             for (int i = 0; i < e->value; i++) {
-                iters.push_back(substitute(for_loop->name, for_loop->min + i, body));
+                iters.push_back(simplify(substitute(for_loop->name, for_loop->min + i, body)));
             }
-            stmt = Block::make(iters);
+            Stmt unrolled = Block::make(iters);
 
+            int size = 0;
+            if (unroll_budget > 0 &&
+                (size = count_ops(unrolled)) > unroll_budget) {
+                user_warning << "Warning: Not unrolling loop over " << for_loop->name
+                             << " because the unrolled body contains " << size
+                             << " ops, which exceeds the unroll budget of "
+                             << unroll_budget << ". Set HL_UNROLL_BUDGET to adjust"
+                             << " this limit, or to zero to remove it.\n";
+                stmt = For::make(for_loop->name, for_loop->min, extent,
+                                 ForType::Serial, for_loop->device_api, body);
+            } else {
+                stmt = unrolled;
+            }
         } else {
             IRMutator::visit(for_loop);
         }
     }
+
+public:
+    UnrollLoops() : unroll_budget(4096) {
+        std::string budget = get_env_variable("HL_UNROLL_BUDGET");
+        if (!budget.empty()) {
+            unroll_budget = atoi(budget.c_str());
+        }
+    }
 };
 
 Stmt unroll_loops(Stmt s) {
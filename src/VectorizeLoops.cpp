@@ -231,6 +231,106 @@ bool uses_gpu_vars(Expr s) {
     return uses.uses_gpu;
 }
 
+class LoadsFromBuffer : public IRVisitor {
+private:
+    using IRVisitor::visit;
+    void visit(const Load *op) {
+        if (op->name == buffer) {
+            result = true;
+        }
+        IRVisitor::visit(op);
+    }
+    const std::string &buffer;
+public:
+    bool result = false;
+    LoadsFromBuffer(const std::string &b) : buffer(b) {}
+};
+
+bool loads_from_buffer(Expr e, const std::string &buffer) {
+    LoadsFromBuffer loads(buffer);
+    e.accept(&loads);
+    return loads.result;
+}
+
+// Check if an expression is marked as likely.
+class HasLikelyTag : public IRVisitor {
+    using IRVisitor::visit;
+    void visit(const Call *op) {
+        if (op->is_intrinsic(Call::likely) ||
+            op->is_intrinsic(Call::likely_if_innermost)) {
+            result = true;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+public:
+    bool result = false;
+};
+
+bool has_likely_tag(Expr e) {
+    HasLikelyTag h;
+    e.accept(&h);
+    return h.result;
+}
+
+// A rough per-lane evaluation cost for an expression, for deciding
+// whether the work skipped by a branch pays for the branch. Loads,
+// divisions, and calls count for more than simple arithmetic; likely
+// tags are free because codegen strips them.
+class EstimateCost : public IRVisitor {
+    using IRVisitor::visit;
+    void visit(const Add *op) {cost++; IRVisitor::visit(op);}
+    void visit(const Sub *op) {cost++; IRVisitor::visit(op);}
+    void visit(const Mul *op) {cost++; IRVisitor::visit(op);}
+    void visit(const Div *op) {cost += 4; IRVisitor::visit(op);}
+    void visit(const Mod *op) {cost += 4; IRVisitor::visit(op);}
+    void visit(const Min *op) {cost++; IRVisitor::visit(op);}
+    void visit(const Max *op) {cost++; IRVisitor::visit(op);}
+    void visit(const Select *op) {cost++; IRVisitor::visit(op);}
+    void visit(const Cast *op) {cost++; IRVisitor::visit(op);}
+    void visit(const Load *op) {cost += 2; IRVisitor::visit(op);}
+    void visit(const Call *op) {
+        if (!op->is_intrinsic(Call::likely) &&
+            !op->is_intrinsic(Call::likely_if_innermost)) {
+            cost += 4;
+        }
+        IRVisitor::visit(op);
+    }
+public:
+    int cost = 0;
+};
+
+int estimate_cost(Expr e) {
+    EstimateCost c;
+    e.accept(&c);
+    return c.cost;
+}
+
+// Find the first vectorized select with exactly one likely-tagged
+// arm. These mark a common path worth testing for with a branch
+// instead of always evaluating both arms.
+class FindLikelySelect : public IRVisitor {
+    using IRVisitor::visit;
+    void visit(const Select *op) {
+        if (result.defined()) {
+            return;
+        }
+        if (op->condition.type().is_vector()) {
+            bool likely_true = has_likely_tag(op->true_value);
+            bool likely_false = has_likely_tag(op->false_value);
+            if (likely_true != likely_false) {
+                result = op;
+                likely_arm_is_true = likely_true;
+                return;
+            }
+        }
+        IRVisitor::visit(op);
+    }
+public:
+    Expr result;
+    bool likely_arm_is_true = false;
+};
+
 // Wrap a vectorized predicate around a Load/Store node.
 class PredicateLoadStore : public IRMutator {
     string var;
@@ -249,6 +349,20 @@ class PredicateLoadStore : public IRMutator {
                 << "We are inside a hexagon loop, but the target doesn't have hexagon's features\n";
             return true;
         } else if (target.arch == Target::X86) {
+            // AVX2 has masked loads and stores of 32- and 64-bit
+            // elements (vmaskmov/vpmaskmov). AVX-512 masks every
+            // operation, and with AVX512BW (Skylake and later) that
+            // includes 8- and 16-bit elements. Outside those cases
+            // llvm scalarizes the predicated op, which is worse than
+            // the scalar tail loop it would be replacing.
+            if (target.features_any_of({Target::AVX512_Skylake,
+                                        Target::AVX512_Cannonlake})) {
+                return lanes >= 4;
+            }
+            if (target.has_feature(Target::AVX2) &&
+                (bit_size == 64) && (lanes >= 2)) {
+                return true;
+            }
             // Should only attempt to predicate store/load if the lane size is
             // no less than 4
             return (bit_size == 32) && (lanes >= 4);
@@ -658,11 +772,183 @@ class VectorSubs : public IRMutator {
 
         if (predicate.same_as(op->predicate) && value.same_as(op->value) && index.same_as(op->index)) {
             stmt = op;
+        } else if (index.type().is_scalar() &&
+                   predicate.type().is_scalar() &&
+                   value.type().is_vector()) {
+            // Every lane wants to store to the same site, which is
+            // the pattern a reduction vectorized over its RVar
+            // produces. If the value is an update of that site we
+            // know how to reassociate, do the reduction horizontally
+            // across the lanes instead of emitting a racing store.
+            Stmt reduced = rewrite_reduction_store(op, predicate, value, index);
+            if (reduced.defined()) {
+                stmt = reduced;
+            } else {
+                int lanes = value.type().lanes();
+                stmt = Store::make(op->name, value, widen(index, lanes),
+                                   op->param, widen(predicate, lanes));
+            }
         } else {
             int lanes = std::max(predicate.type().lanes(), std::max(value.type().lanes(), index.type().lanes()));
-            stmt = Store::make(op->name, widen(value, lanes), widen(index, lanes),
-                               op->param, widen(predicate, lanes));
+            Stmt branched = branch_on_likely_select(op, predicate, value, index, lanes);
+            if (branched.defined()) {
+                stmt = branched;
+            } else {
+                stmt = Store::make(op->name, widen(value, lanes), widen(index, lanes),
+                                   op->param, widen(predicate, lanes));
+            }
+        }
+    }
+
+    // The update operations we know how to reassociate across the
+    // lanes of a vectorized reduction, plus And for testing a vector
+    // condition.
+    enum class ReduceOp { Add, Sub, Mul, Min, Max, And };
+
+    Expr combine_lanes(Expr a, Expr b, ReduceOp op) {
+        switch (op) {
+        case ReduceOp::Add: return a + b;
+        case ReduceOp::Sub: return a - b;
+        case ReduceOp::Mul: return a * b;
+        case ReduceOp::Min: return min(a, b);
+        case ReduceOp::Max: return max(a, b);
+        case ReduceOp::And: return a && b;
+        }
+        return Expr();
+    }
+
+    // If the value being stored contains a select marked with a
+    // likely arm, and the other arm is much more expensive,
+    // vectorizing the select evaluates the expensive arm on every
+    // lane just to throw the result away nearly all the time. In that
+    // case branch on whether the whole vector takes the likely arm
+    // and skip the expensive one. The condition is usually
+    // data-dependent, so unlike the likely tags consumed by loop
+    // partitioning this can't be resolved statically by splitting the
+    // loop.
+    Stmt branch_on_likely_select(const Store *op, const Expr &predicate,
+                                 const Expr &value, const Expr &index, int lanes) {
+        if (!is_one(predicate) || !value.type().is_vector()) {
+            return Stmt();
+        }
+
+        FindLikelySelect finder;
+        value.accept(&finder);
+        const Select *sel = finder.result.as<Select>();
+        if (!sel) {
+            return Stmt();
+        }
+
+        Expr likely_arm = finder.likely_arm_is_true ? sel->true_value : sel->false_value;
+        Expr unlikely_arm = finder.likely_arm_is_true ? sel->false_value : sel->true_value;
+
+        // The branch costs a log2(lanes) tree of ands plus a
+        // conditional jump that mispredicts whenever a vector
+        // straddles the condition, so only branch when the skipped
+        // arm is substantially more expensive than the kept one. This
+        // also leaves cheap boundary-condition selects alone for loop
+        // partitioning to deal with.
+        int unlikely_cost = estimate_cost(unlikely_arm);
+        if (unlikely_cost < 10 || unlikely_cost < 4 * estimate_cost(likely_arm)) {
+            return Stmt();
+        }
+
+        Expr cond = sel->condition;
+        if (!finder.likely_arm_is_true) {
+            cond = !cond;
+        }
+        Expr all_likely = reduce_lanes(cond, ReduceOp::And);
+
+        Expr fast_value = substitute(finder.result, likely_arm, value);
+        Stmt fast = Store::make(op->name, widen(fast_value, lanes), widen(index, lanes),
+                                op->param, widen(predicate, lanes));
+        Stmt slow = Store::make(op->name, widen(value, lanes), widen(index, lanes),
+                                op->param, widen(predicate, lanes));
+        return IfThenElse::make(all_likely, fast, slow);
+    }
+
+    // Reduce the lanes of a vector to a scalar with a tree of
+    // pairwise operations on half-width slices. LLVM's backends
+    // recognize this shape and select horizontal reduction
+    // instructions (e.g. haddps and psadbw on x86, addv on aarch64)
+    // where the target has them, which beats the linear
+    // extract-accumulate chain a serial loop over the lanes becomes.
+    Expr reduce_lanes(Expr vec, ReduceOp op) {
+        while (vec.type().lanes() > 1) {
+            int lanes = vec.type().lanes();
+            if (lanes % 2 == 1) {
+                Expr last = extract_lane(vec, lanes - 1);
+                Expr rest = Shuffle::make_slice(vec, 0, 1, lanes - 1);
+                vec = combine_lanes(reduce_lanes(rest, op), last, op);
+            } else {
+                Expr a = Shuffle::make_slice(vec, 0, 1, lanes / 2);
+                Expr b = Shuffle::make_slice(vec, lanes / 2, 1, lanes / 2);
+                vec = combine_lanes(a, b, op);
+            }
+        }
+        return vec;
+    }
+
+    // If 'value' is a supported associative update of the scalar
+    // store site, return the store rewritten to accumulate a
+    // horizontal reduction of the vector operand. Otherwise returns
+    // an undefined Stmt. Note that this reorders the reduction
+    // relative to the serial loop, but reaching here already required
+    // allow_race_conditions(), which promises any order is
+    // acceptable; without this rewrite the lanes just clobber each
+    // other.
+    Stmt rewrite_reduction_store(const Store *op, const Expr &predicate,
+                                 const Expr &value, const Expr &index) {
+        Expr a, b;
+        ReduceOp reduce_op;
+        if (const Add *n = value.as<Add>()) {
+            a = n->a; b = n->b; reduce_op = ReduceOp::Add;
+        } else if (const Sub *n = value.as<Sub>()) {
+            a = n->a; b = n->b; reduce_op = ReduceOp::Sub;
+        } else if (const Mul *n = value.as<Mul>()) {
+            a = n->a; b = n->b; reduce_op = ReduceOp::Mul;
+        } else if (const Min *n = value.as<Min>()) {
+            a = n->a; b = n->b; reduce_op = ReduceOp::Min;
+        } else if (const Max *n = value.as<Max>()) {
+            a = n->a; b = n->b; reduce_op = ReduceOp::Max;
+        } else {
+            return Stmt();
         }
+
+        // One operand must be the old value of the store site,
+        // broadcast to all lanes.
+        auto is_old_value = [&](const Expr &e) {
+            const Broadcast *broadcast = e.as<Broadcast>();
+            const Load *load = broadcast ? broadcast->value.as<Load>() : nullptr;
+            return load != nullptr &&
+                   load->name == op->name &&
+                   is_one(load->predicate) &&
+                   equal(load->index, index);
+        };
+
+        Expr init, vec;
+        if (is_old_value(a)) {
+            init = a.as<Broadcast>()->value;
+            vec = b;
+        } else if (reduce_op != ReduceOp::Sub && is_old_value(b)) {
+            // These ops commute; subtraction does not.
+            init = b.as<Broadcast>()->value;
+            vec = a;
+        } else {
+            return Stmt();
+        }
+
+        // The serial loop would observe partial updates through any
+        // other access to the buffer, so there must be none.
+        if (loads_from_buffer(vec, op->name)) {
+            return Stmt();
+        }
+
+        // A chain of subtractions from the site subtracts the sum of
+        // the lanes.
+        ReduceOp lanes_op = (reduce_op == ReduceOp::Sub) ? ReduceOp::Add : reduce_op;
+        Expr new_value = combine_lanes(init, reduce_lanes(vec, lanes_op), reduce_op);
+        return Store::make(op->name, new_value, index, op->param, predicate);
     }
 
     void visit(const AssertStmt *op) {
@@ -853,7 +1139,8 @@ class VectorSubs : public IRMutator {
         // The variable itself could still exist inside an inner scalarized block.
         body = substitute(v, Variable::make(Int(32), var), body);
 
-        stmt = Allocate::make(op->name, op->type, new_extents, op->condition, body, new_expr, op->free_function);
+        stmt = Allocate::make(op->name, op->type, new_extents, op->condition, body,
+                              new_expr, op->free_function, op->memory_type);
     }
 
     Stmt scalarize(Stmt s) {
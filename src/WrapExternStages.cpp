@@ -88,11 +88,22 @@ class WrapExternStages : public IRMutator {
 
                 // Make the call to upgrade old buffer
                 // fields into the original new
-                // buffer. Important for bounds queries.
+                // buffer. Important for bounds queries. A full
+                // upgrade is only needed in bounds query mode, when
+                // the extern stage may have written new shapes; on
+                // any other call only the dirty bits and device state
+                // can have changed.
                 Expr upgrade_call = Call::make(Int(32), "halide_upgrade_buffer_t",
                                                {a.name, old_buffer_var, new_buffer_var},
                                                Call::Extern);
-                upgrades.push_back(make_checked_call(upgrade_call));
+                Expr upgrade_device_call = Call::make(Int(32), "halide_upgrade_buffer_t_device_fields",
+                                                      {a.name, old_buffer_var, new_buffer_var},
+                                                      Call::Extern);
+                Expr bounds_query = Call::make(Bool(), Call::buffer_is_bounds_query,
+                                               {new_buffer_var}, Call::Extern);
+                upgrades.push_back(IfThenElse::make(bounds_query,
+                                                    make_checked_call(upgrade_call),
+                                                    make_checked_call(upgrade_device_call)));
                 call_args.push_back(old_buffer_var);
             } else {
                 call_args.push_back(Variable::make(a.type, a.name));
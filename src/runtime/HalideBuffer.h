@@ -69,6 +69,7 @@ enum struct BufferDeviceOwnership : int {
     WrappedNative, ///> halide_device_detach_native will be called when device ref count goes to zero
     Unmanaged,     ///> No free routine will be called when device ref count goes to zero
     AllocatedDeviceAndHost, ///> Call device_and_host_free when DeveRefCount goes to zero.
+    Cropped,       ///> Call halide_device_release_crop when device ref count goes to zero
 };
 
 /** A similar struct for managing device allocations. */
@@ -116,6 +117,16 @@ class Buffer {
      * buffer. */
     mutable DeviceRefCount *dev_ref_count = nullptr;
 
+    /** The device ref count for a cropped view. Holds a copy of the
+     * buffer it was cropped from, so the parent's device allocation
+     * stays alive for as long as the crop does. */
+    struct DevRefCountCropped : DeviceRefCount {
+        Buffer<T, D> cropped_from;
+        DevRefCountCropped(const Buffer<T, D> &cropped_from) : cropped_from(cropped_from) {
+            ownership = BufferDeviceOwnership::Cropped;
+        }
+    };
+
     /** True if T is of type void or const void */
     static const bool T_is_void = std::is_same<typename std::remove_const<T>::type, void>::value;
 
@@ -201,12 +212,20 @@ private:
                     buf.device_interface->detach_native(nullptr, &buf);
                 } else if (dev_ref_count && dev_ref_count->ownership == BufferDeviceOwnership::AllocatedDeviceAndHost) {
                     buf.device_interface->device_and_host_free(nullptr, &buf);
+                } else if (dev_ref_count && dev_ref_count->ownership == BufferDeviceOwnership::Cropped) {
+                    buf.device_interface->device_release_crop(nullptr, &buf);
                 } else if (dev_ref_count == nullptr || dev_ref_count->ownership == BufferDeviceOwnership::Allocated) {
                     buf.device_interface->device_free(nullptr, &buf);
                 }
             }
             if (dev_ref_count) {
-                delete dev_ref_count;
+                if (dev_ref_count->ownership == BufferDeviceOwnership::Cropped) {
+                    // DeviceRefCount has no virtual destructor, so the
+                    // derived type must be deleted as what it is.
+                    delete (DevRefCountCropped *)dev_ref_count;
+                } else {
+                    delete dev_ref_count;
+                }
             }
         }
         buf.device = 0;
@@ -940,6 +959,26 @@ public:
         return *((Buffer<T2, D2> *)this);
     }
 
+    /** Return a view of this Buffer with the element bits
+     * reinterpreted as another type of the same size, without copying
+     * any data. For example, a Buffer<float> may be viewed as a
+     * Buffer<uint32_t> to inspect the bit patterns of its
+     * elements. The element sizes must match, which is checked with
+     * an assert at runtime (the element size of this Buffer is not
+     * known statically if its type is void). */
+    template<typename T2>
+    Buffer<T2, D> reinterpret_bits() const {
+        static_assert(!std::is_const<T>::value || std::is_const<T2>::value,
+                      "Can't reinterpret a Buffer<const T> as a Buffer of non-const T2");
+        assert(type().bytes() == (int)sizeof(T2));
+        Buffer<T, D> im = *this;
+        im.buf.type = halide_type_of<typename std::remove_cv<T2>::type>();
+        // All instantiations of Buffer with the same static
+        // dimensionality have identical layout, so the pun below is
+        // safe (see as() above).
+        return *((Buffer<T2, D> *)&im);
+    }
+
     /** Conventional names for the first three dimensions. */
     // @{
     int width() const {
@@ -1043,58 +1082,312 @@ public:
         set_host_dirty();
     }
 
+    /** Fill this Buffer with the values at the same coordinates in
+     * another Buffer, converting between the two element types as if
+     * by an assignment of scalars. Both element types must be
+     * statically known. As with copy_from, the copy is restricted to
+     * the intersection of the two buffers. */
+    template<typename T2, int D2>
+    void convert_from(const Buffer<T2, D2> &other) {
+        static_assert(!T_is_void && !Buffer<T2, D2>::T_is_void,
+                      "Cannot call convert_from on a Buffer<void>; use copy_from instead.");
+        assert(!device_dirty() && "Cannot call Halide::Runtime::Buffer::convert_from on a device dirty destination.");
+        assert(!other.device_dirty() && "Cannot call Halide::Runtime::Buffer::convert_from on a device dirty source.");
+
+        Buffer<const T2, D2> src(other);
+        Buffer<T, D> dst(*this);
+
+        assert(src.dimensions() == dst.dimensions());
+
+        // Trim the copy to the region in common
+        for (int i = 0; i < dimensions(); i++) {
+            int min_coord = std::max(dst.dim(i).min(), src.dim(i).min());
+            int max_coord = std::min(dst.dim(i).max(), src.dim(i).max());
+            if (max_coord < min_coord) {
+                // The buffers do not overlap.
+                return;
+            }
+            dst.crop(i, min_coord, max_coord - min_coord + 1);
+            src.crop(i, min_coord, max_coord - min_coord + 1);
+        }
+
+        dst.for_each_value([](not_void_T &dst_val, T2 src_val) {
+            dst_val = (not_void_T)src_val;
+        }, src);
+        set_host_dirty();
+    }
+
+    /** A variant of copy_from that distributes slices of the region
+     * in common across the Halide runtime thread pool via
+     * halide_do_par_for, sharing worker threads with any Halide
+     * pipelines running in the process. Layout-converting copies
+     * (e.g. planar to interleaved) work just as they do in
+     * copy_from. The calling code must be linked against the Halide
+     * runtime, or against a compiled pipeline that includes it. */
+    template<typename T2, int D2>
+    void copy_from_parallel(const Buffer<T2, D2> &other) {
+        assert(!device_dirty() && "Cannot call Halide::Runtime::Buffer::copy_from_parallel on a device dirty destination.");
+        assert(!other.device_dirty() && "Cannot call Halide::Runtime::Buffer::copy_from_parallel on a device dirty source.");
+
+        Buffer<const T, D> src(other);
+        Buffer<T, D> dst(*this);
+
+        assert(src.dimensions() == dst.dimensions());
+
+        // Trim the copy to the region in common
+        for (int i = 0; i < dimensions(); i++) {
+            int min_coord = std::max(dst.dim(i).min(), src.dim(i).min());
+            int max_coord = std::min(dst.dim(i).max(), src.dim(i).max());
+            if (max_coord < min_coord) {
+                // The buffers do not overlap.
+                return;
+            }
+            dst.crop(i, min_coord, max_coord - min_coord + 1);
+            src.crop(i, min_coord, max_coord - min_coord + 1);
+        }
+
+        int d = dst.best_parallel_dim();
+        if (d < 0 || dst.dim(d).extent() < 2) {
+            // Too little available parallelism to be worth the
+            // task-spawning overhead.
+            dst.copy_from(src);
+        } else {
+            parallel_copy_closure<const T, D> c = {&dst, &src, d};
+            halide_do_par_for(nullptr, parallel_copy_task<const T, D>,
+                              dst.dim(d).min(), dst.dim(d).extent(), (uint8_t *)&c);
+        }
+        set_host_dirty();
+    }
+
+    /** A variant of fill that distributes slices of the buffer across
+     * the Halide runtime thread pool via halide_do_par_for. The
+     * calling code must be linked against the Halide runtime, or
+     * against a compiled pipeline that includes it. */
+    void fill_parallel(not_void_T val) {
+        int d = best_parallel_dim();
+        if (d < 0 || dim(d).extent() < 2) {
+            fill(val);
+            return;
+        }
+        parallel_fill_closure c = {this, val, d};
+        halide_do_par_for(nullptr, parallel_fill_task,
+                          dim(d).min(), dim(d).extent(), (uint8_t *)&c);
+        set_host_dirty();
+    }
+
+private:
+    /** Pick a dimension for the parallel variants of copy_from and
+     * fill to partition: the one with the largest extent, excluding
+     * the dimension with the smallest stride, which is better left
+     * intact for the dense inner loops. Returns -1 for buffers with
+     * fewer than two dimensions. */
+    int best_parallel_dim() const {
+        int innermost = -1;
+        for (int i = 0; i < dimensions(); i++) {
+            int s = dim(i).stride();
+            if (s < 0) s = -s;
+            int s_inner = innermost < 0 ? 0 : dim(innermost).stride();
+            if (s_inner < 0) s_inner = -s_inner;
+            if (innermost < 0 || s < s_inner) {
+                innermost = i;
+            }
+        }
+        int best = -1;
+        for (int i = 0; i < dimensions(); i++) {
+            if (i != innermost &&
+                (best < 0 || dim(i).extent() > dim(best).extent())) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    /** Closure struct and task function for copy_from_parallel. Each
+     * task runs the serial copy on one slice of the partitioned
+     * dimension. */
+    template<typename T2, int D2>
+    struct parallel_copy_closure {
+        Buffer<T, D> *dst;
+        const Buffer<T2, D2> *src;
+        int d;
+    };
+
+    template<typename T2, int D2>
+    static int parallel_copy_task(void *, int i, uint8_t *closure) {
+        parallel_copy_closure<T2, D2> *c = (parallel_copy_closure<T2, D2> *)closure;
+        c->dst->cropped(c->d, i, 1).copy_from(*c->src);
+        return 0;
+    }
+
+    /** The same for fill_parallel. */
+    struct parallel_fill_closure {
+        Buffer<T, D> *buf;
+        not_void_T val;
+        int d;
+    };
+
+    static int parallel_fill_task(void *, int i, uint8_t *closure) {
+        parallel_fill_closure *c = (parallel_fill_closure *)closure;
+        c->buf->cropped(c->d, i, 1).fill(c->val);
+        return 0;
+    }
+
+    /** Crop a single dimension without handling the device side. */
+    void crop_host(int d, int min, int extent) {
+        assert(dim(d).min() <= min);
+        assert(dim(d).max() >= min + extent - 1);
+        int shift = min - dim(d).min();
+        if (buf.host != nullptr) {
+            buf.host += shift * dim(d).stride() * type().bytes();
+        }
+        buf.dim[d].min = min;
+        buf.dim[d].extent = extent;
+    }
+
+    void crop_host(const std::vector<std::pair<int, int>> &rect) {
+        assert(rect.size() <= std::numeric_limits<int>::max());
+        int limit = (int)rect.size();
+        assert(limit <= dimensions());
+        for (int i = 0; i < limit; i++) {
+            crop_host(i, rect[i].first, rect[i].second);
+        }
+    }
+
+    /** Give a host-side crop of this buffer a device-side view of the
+     * same region via device_crop, keeping the buffer it was cropped
+     * from alive for as long as the crop lives. If the device API
+     * doesn't support cropping, the crop just has no device handle. */
+    template<typename T2, int D2>
+    void complete_device_crop(Buffer<T2, D2> &result_host_cropped) const {
+        assert(buf.device_interface != nullptr);
+        if (buf.device_interface->device_crop(nullptr, &this->buf, &result_host_cropped.buf) == 0) {
+            const Buffer<T, D> *cropped_from = this;
+            // A crop of a crop counts as a crop of the original
+            // buffer; it's the original that has to stay alive.
+            if (dev_ref_count != nullptr && dev_ref_count->ownership == BufferDeviceOwnership::Cropped) {
+                cropped_from = &((DevRefCountCropped *)dev_ref_count)->cropped_from;
+            }
+            result_host_cropped.crop_from(*cropped_from);
+        }
+    }
+
+    /** Set up the device ref count for a buffer to indicate that it
+     * is a cropped view of cropped_from. */
+    template<typename T2, int D2>
+    void crop_from(const Buffer<T2, D2> &cropped_from) {
+        assert(dev_ref_count == nullptr);
+        dev_ref_count = new DevRefCountCropped(cropped_from);
+    }
+
+public:
     /** Make an image that refers to a sub-range of this image along
      * the given dimension. Does not assert the crop region is within
-     * the existing bounds. The cropped image drops any device
-     * handle. */
+     * the existing bounds. If this image has a device handle (for
+     * example one wrapped from a native API via device_wrap_native),
+     * the crop gets a device-side view of the same region where the
+     * device API supports cropping (see halide_device_crop), and
+     * keeps the image it was cropped from alive; otherwise the crop
+     * has no device handle. */
     Buffer<T, D> cropped(int d, int min, int extent) const {
         // Make a fresh copy of the underlying buffer (but not a fresh
         // copy of the allocation, if there is one).
         Buffer<T, D> im = *this;
-        im.crop(d, min, extent);
+
+        // Drop the device handle from the copy. On success
+        // complete_device_crop gives it a cropped view instead; on
+        // failure it must not alias the uncropped allocation.
+        im.device_deallocate();
+
+        im.crop_host(d, min, extent);
+        if (buf.device_interface != nullptr) {
+            complete_device_crop(im);
+        }
+        return im;
+    }
+
+    /** Make an image with a different static dimensionality capacity
+     * that refers to a sub-range of this image along the given
+     * dimension. The result's shape is guaranteed to live in its
+     * in-class storage rather than on the heap; an assert checks that
+     * the dimensionality fits in the requested capacity. */
+    template<int D2>
+    Buffer<T, D2> cropped(int d, int min, int extent) const {
+        assert(dimensions() <= D2);
+        Buffer<T, D2> im = *this;
+        im.device_deallocate();
+        im.crop_host(d, min, extent);
+        if (buf.device_interface != nullptr) {
+            complete_device_crop(im);
+        }
         return im;
     }
 
-    /** Crop an image in-place along the given dimension. */
+    /** Crop an image in-place along the given dimension. This does
+     * not move any data around in memory - it just changes the min
+     * and extent of the given dimension. */
     void crop(int d, int min, int extent) {
-        // assert(dim(d).min() <= min);
-        // assert(dim(d).max() >= min + extent - 1);
-        int shift = min - dim(d).min();
-        if (shift) {
-            device_deallocate();
+        // An optimization for the case in which the buffer is already
+        // cropped to the desired region.
+        if (dim(d).min() == min && dim(d).extent() == extent) {
+            return;
         }
-        if (buf.host != nullptr) {
-            buf.host += shift * dim(d).stride() * type().bytes();
+        if (buf.device_interface != nullptr) {
+            *this = cropped(d, min, extent);
+        } else {
+            crop_host(d, min, extent);
         }
-        buf.dim[d].min = min;
-        buf.dim[d].extent = extent;
     }
 
     /** Make an image that refers to a sub-rectangle of this image along
      * the first N dimensions. Does not assert the crop region is within
-     * the existing bounds. The cropped image drops any device handle. */
+     * the existing bounds. The device handle is treated as in the
+     * one-dimensional cropped() above. */
     Buffer<T, D> cropped(const std::vector<std::pair<int, int>> &rect) const {
         // Make a fresh copy of the underlying buffer (but not a fresh
         // copy of the allocation, if there is one).
         Buffer<T, D> im = *this;
-        im.crop(rect);
+
+        im.device_deallocate();
+
+        im.crop_host(rect);
+        if (buf.device_interface != nullptr) {
+            complete_device_crop(im);
+        }
+        return im;
+    }
+
+    /** Make an image with a different static dimensionality capacity
+     * that refers to a sub-rectangle of this image along the first N
+     * dimensions. The result's shape is guaranteed to live in its
+     * in-class storage rather than on the heap; an assert checks that
+     * the dimensionality fits in the requested capacity. */
+    template<int D2>
+    Buffer<T, D2> cropped(const std::vector<std::pair<int, int>> &rect) const {
+        assert(dimensions() <= D2);
+        Buffer<T, D2> im = *this;
+        im.device_deallocate();
+        im.crop_host(rect);
+        if (buf.device_interface != nullptr) {
+            complete_device_crop(im);
+        }
         return im;
     }
 
     /** Crop an image in-place along the first N dimensions. */
     void crop(const std::vector<std::pair<int, int>> &rect) {
-        assert(rect.size() <= std::numeric_limits<int>::max());
-        int limit = (int)rect.size();
-        assert(limit <= dimensions());
-        for (int i = 0; i < limit; i++) {
-            crop(i, rect[i].first, rect[i].second);
+        if (buf.device_interface != nullptr) {
+            *this = cropped(rect);
+        } else {
+            crop_host(rect);
         }
     }
 
     /** Make an image which refers to the same data with using
      * translated coordinates in the given dimension. Positive values
      * move the image data to the right or down relative to the
-     * coordinate system. Drops any device handle. */
+     * coordinate system. The device handle, if any, is preserved:
+     * translation only renames coordinates, it does not touch the
+     * underlying memory. */
     Buffer<T, D> translated(int d, int dx) const {
         Buffer<T, D> im = *this;
         im.translate(d, dx);
@@ -1103,7 +1396,6 @@ public:
 
     /** Translate an image in-place along one dimension */
     void translate(int d, int delta) {
-        device_deallocate();
         buf.dim[d].min += delta;
     }
 
@@ -1117,7 +1409,6 @@ public:
 
     /** Translate an image along the first N dimensions */
     void translate(const std::vector<int> &delta) {
-        device_deallocate();
         assert(delta.size() <= std::numeric_limits<int>::max());
         int limit = (int)delta.size();
         assert(limit <= dimensions());
@@ -1130,7 +1421,6 @@ public:
     template<typename ...Args>
     void set_min(Args... args) {
         assert(sizeof...(args) <= (size_t)dimensions());
-        device_deallocate();
         const int x[] = {args...};
         for (size_t i = 0; i < sizeof...(args); i++) {
             buf.dim[i].min = x[i];
@@ -1171,6 +1461,19 @@ public:
         return im;
     }
 
+    /** Make a lower-dimensional image with a different static
+     * dimensionality capacity that refers to one slice of this
+     * image. The result's shape is guaranteed to live in its in-class
+     * storage rather than on the heap; an assert checks that the
+     * sliced dimensionality fits in the requested capacity. */
+    template<int D2>
+    Buffer<T, D2> sliced(int d, int pos) const {
+        assert(dimensions() - 1 <= D2);
+        Buffer<T, D> im = *this;
+        im.slice(d, pos);
+        return Buffer<T, D2>(std::move(im));
+    }
+
     /** Slice an image in-place */
     void slice(int d, int pos) {
         // assert(pos >= dim(d).min() && pos <= dim(d).max());
@@ -1610,6 +1913,55 @@ public:
     }
     // @}
 
+    /** Get a typed pointer to the start of the scanline of the
+     * innermost storage dimension that passes through the given
+     * coordinates of the remaining dimensions, or one past its
+     * end. Coordinates beyond those given are treated as their min,
+     * as with operator(). The innermost dimension must have a stride
+     * of one (as buffers allocated by this class do), so the scanline
+     * is contiguous, and walking the pointer from row_begin to
+     * row_end compiles to raw pointer arithmetic that autovectorizes
+     * well, instead of a per-element multiply chain through the
+     * strides. The non-const versions set the host_dirty flag to
+     * true. */
+    // @{
+    template<typename ...Args,
+             typename = typename std::enable_if<AllInts<Args...>::value>::type>
+    HALIDE_ALWAYS_INLINE
+    const not_void_T *row_begin(Args... rest) const {
+        static_assert(!T_is_void,
+                      "Cannot use row_begin() on Buffer<void> types");
+        assert(!device_dirty());
+        assert(dimensions() >= 1 && dim(0).stride() == 1);
+        return (const not_void_T *)(address_of(dim(0).min(), rest...));
+    }
+
+    template<typename ...Args,
+             typename = typename std::enable_if<AllInts<Args...>::value>::type>
+    HALIDE_ALWAYS_INLINE
+    const not_void_T *row_end(Args... rest) const {
+        return row_begin(rest...) + dim(0).extent();
+    }
+
+    template<typename ...Args,
+             typename = typename std::enable_if<AllInts<Args...>::value>::type>
+    HALIDE_ALWAYS_INLINE
+    not_void_T *row_begin(Args... rest) {
+        static_assert(!T_is_void,
+                      "Cannot use row_begin() on Buffer<void> types");
+        set_host_dirty();
+        assert(dimensions() >= 1 && dim(0).stride() == 1);
+        return (not_void_T *)(address_of(dim(0).min(), rest...));
+    }
+
+    template<typename ...Args,
+             typename = typename std::enable_if<AllInts<Args...>::value>::type>
+    HALIDE_ALWAYS_INLINE
+    not_void_T *row_end(Args... rest) {
+        return row_begin(rest...) + dim(0).extent();
+    }
+    // @}
+
     void fill(not_void_T val) {
         set_host_dirty();
         for_each_value([=](T &v) {v = val;});
@@ -1698,17 +2050,8 @@ private:
     }
     // @}
 
-public:
-    /** Call a function on every value in the buffer, and the
-     * corresponding values in some number of other buffers of the
-     * same size. The function should take a reference, const
-     * reference, or value of the correct type for each buffer. This
-     * effectively lifts a function of scalars to an element-wise
-     * function of buffers. This produces code that the compiler can
-     * autovectorize. This is slightly cheaper than for_each_element,
-     * because it does not need to track the coordinates. */
-    template<typename Fn, typename ...Args, int N = sizeof...(Args) + 1>
-    void for_each_value(Fn &&f, Args... other_buffers) {
+    template<bool assert_dense, typename Fn, typename ...Args, int N = sizeof...(Args) + 1>
+    void for_each_value_impl(Fn &&f, Args... other_buffers) {
         for_each_value_task_dim<N> *t =
             (for_each_value_task_dim<N> *)HALIDE_ALLOCA((dimensions()+1) * sizeof(for_each_value_task_dim<N>));
         for (int i = 0; i <= dimensions(); i++) {
@@ -1753,6 +2096,11 @@ public:
             }
         }
 
+        if (assert_dense) {
+            // for_each_dense_value promises the contiguous inner loop.
+            assert(innermost_strides_are_one);
+        }
+
         if (innermost_strides_are_one) {
             for_each_value_helper<true>(f, dimensions() - 1, t, begin(), (other_buffers.begin())...);
         } else {
@@ -1760,6 +2108,32 @@ public:
         }
     }
 
+public:
+    /** Call a function on every value in the buffer, and the
+     * corresponding values in some number of other buffers of the
+     * same size. The function should take a reference, const
+     * reference, or value of the correct type for each buffer. This
+     * effectively lifts a function of scalars to an element-wise
+     * function of buffers. This produces code that the compiler can
+     * autovectorize. This is slightly cheaper than for_each_element,
+     * because it does not need to track the coordinates. */
+    template<typename Fn, typename ...Args>
+    void for_each_value(Fn &&f, Args... other_buffers) {
+        for_each_value_impl<false>(f, other_buffers...);
+    }
+
+    /** A variant of for_each_value for hot loops that must
+     * vectorize. Asserts that after sorting and flattening the
+     * dimensions the innermost traversal over this buffer and all the
+     * other buffers has a stride of one, so the call is guaranteed to
+     * take the contiguous inner loop that autovectorizes, instead of
+     * silently falling back to strided addressing when some buffer
+     * has an unexpected memory layout. */
+    template<typename Fn, typename ...Args>
+    void for_each_dense_value(Fn &&f, Args... other_buffers) {
+        for_each_value_impl<true>(f, other_buffers...);
+    }
+
 private:
 
     // Helper functions for for_each_element
@@ -152,6 +152,82 @@ extern int halide_default_do_task(void *user_context, halide_task_t f, int idx,
                                   uint8_t *closure);
 // @}
 
+/** A parallel task to be passed to halide_do_parallel_tasks. Each
+ * task is a loop over [min, min+extent), executed via the same
+ * per-iteration function type used by halide_do_par_for. */
+struct halide_parallel_task_t {
+    halide_task_t fn;
+    uint8_t *closure;
+    const char *name;
+    int min, extent;
+};
+
+/** Enqueue a batch of parallel loops onto the thread pool and block
+ * until all of them have completed. Tasks enqueued together are
+ * accounted for as a group, and tasks enqueued from within a running
+ * task (nested parallelism) execute LIFO, so the innermost loops of a
+ * nested parallel schedule are retired first instead of
+ * oversubscribing the machine. Returns zero if every iteration of
+ * every task returns zero, or an arbitrarily chosen nonzero return
+ * value otherwise. */
+//@{
+typedef int (*halide_do_parallel_tasks_t)(void *, int, struct halide_parallel_task_t *);
+extern halide_do_parallel_tasks_t halide_set_custom_do_parallel_tasks(halide_do_parallel_tasks_t do_parallel_tasks);
+extern int halide_do_parallel_tasks(void *user_context, int num_tasks,
+                                    struct halide_parallel_task_t *tasks);
+extern int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
+                                            struct halide_parallel_task_t *tasks);
+//@}
+
+/** An opaque struct representing a semaphore. Used by the code
+ * generated for asynchronous producers (see Func::async) to signal
+ * completion to their consumers. Must be initialized with
+ * halide_semaphore_init before use, and may be located on the stack
+ * of the running pipeline. */
+struct halide_semaphore_t {
+    uint64_t _private[2];
+};
+
+/** Initialize, release, and acquire a semaphore. Release makes n
+ * units available; acquire blocks until n units are available and
+ * takes them; try_acquire takes them without blocking if it can and
+ * returns whether it did. */
+//@{
+extern int halide_semaphore_init(struct halide_semaphore_t *sem, int n);
+extern int halide_semaphore_release(struct halide_semaphore_t *sem, int n);
+extern int halide_semaphore_acquire(struct halide_semaphore_t *sem, int n);
+extern bool halide_semaphore_try_acquire(struct halide_semaphore_t *sem, int n);
+//@}
+
+/** A node in a task graph to be passed to
+ * halide_task_graph_execute. fn is typically a small wrapper that
+ * unpacks closure and calls an ahead-of-time-compiled filter with its
+ * arguments. deps holds num_deps indices into the node array naming
+ * the nodes that must complete before this one may run (e.g. the
+ * producers of its input buffers). */
+//@{
+typedef int (*halide_task_graph_fn_t)(void *user_context, void *closure);
+
+struct halide_task_graph_node_t {
+    halide_task_graph_fn_t fn;
+    void *closure;
+    int num_deps;
+    const int *deps;
+};
+//@}
+
+/** Execute a graph of tasks on the thread pool, respecting the
+ * dependency edges, and block until all of them have completed. Nodes
+ * become eligible to run as soon as their dependencies have finished,
+ * without draining the pool in between, so independent nodes (and the
+ * parallel loops inside them) overlap instead of paying a full
+ * barrier per pipeline. Returns zero if every node returns zero;
+ * otherwise nodes that have not yet started are skipped and the
+ * nonzero result of one of the failing nodes is returned. It is an
+ * error for the dependency edges to contain a cycle. */
+extern int halide_task_graph_execute(void *user_context, int num_nodes,
+                                     struct halide_task_graph_node_t *nodes);
+
 struct halide_thread;
 
 /** Spawn a thread. Returns a handle to the thread for the purposes of
@@ -180,6 +256,138 @@ extern void halide_join_thread(struct halide_thread *);
  */
 extern int halide_set_num_threads(int n);
 
+/** Define (or redefine) a named thread pool domain with a worker
+ * budget. Parallel loops launched while a domain is selected (see
+ * halide_set_thread_pool_domain) are run by at most max_threads
+ * workers at once, so pipelines sharing a process can be given
+ * separate core budgets instead of fighting over the whole pool. A
+ * max_threads of zero means no cap. Returns zero on success. */
+extern int halide_define_thread_pool_domain(const char *name, int max_threads);
+
+/** Select the thread pool domain applied to parallel loops launched
+ * from now on, or pass NULL to select none (no worker cap). The
+ * budget is captured when a loop is launched, so loops already in
+ * flight are unaffected. The cap is best-effort: under the stealing
+ * schedule, workers already running a loop can hand ranges to idle
+ * threads. Returns zero on success, or an error if the domain was
+ * never defined. */
+extern int halide_set_thread_pool_domain(const char *name);
+
+/** Scheduling policies for the default implementation of
+ * halide_do_par_for. They trade per-iteration overhead against load
+ * balance on loops whose iterations have variable cost. */
+typedef enum halide_parallel_schedule_t {
+    /** Threads claim chunks proportional to the iterations remaining,
+     * and idle threads steal individual iterations from busy ones.
+     * Balances well on variable-cost loops. The default. */
+    halide_parallel_schedule_stealing = 0,
+    /** Guided self-scheduling: threads claim chunks proportional to
+     * the iterations remaining, so chunks shrink toward the end of
+     * the loop, but claimed chunks are never stolen. */
+    halide_parallel_schedule_guided = 1,
+    /** Pre-split the loop into one contiguous chunk per thread. The
+     * cheapest policy, but it load-imbalances if iteration costs
+     * vary. */
+    halide_parallel_schedule_static = 2
+} halide_parallel_schedule_t;
+
+/** Set the scheduling policy used by the default implementation of
+ * halide_do_par_for. Applies to parallel loops launched after the
+ * call. Returns the old policy. Can also be set with the
+ * HL_PARALLEL_SCHEDULE environment variable (0, 1, or 2, matching
+ * halide_parallel_schedule_t), which is read when the thread pool is
+ * first initialized; an explicit call to this function takes
+ * precedence over the environment. Custom implementations of
+ * halide_do_par_for may ignore it. */
+extern int halide_set_parallel_schedule(int schedule);
+
+/** Parallel loops with at most this many iterations are run inline
+ * on the calling thread by the default implementation of
+ * halide_do_par_for, instead of being enqueued on the thread pool:
+ * for tiny loops, enqueueing the job and waking workers costs more
+ * than the iterations themselves. The default of 1 only
+ * short-circuits loops the pool could never help with; raise it if
+ * your pipeline's parallel loops are known to have cheap iterations
+ * (e.g. per-scanline loops at small resolutions). Returns the old
+ * crossover. Can also be set with the HL_PARALLEL_INLINE_EXTENT
+ * environment variable; an explicit call takes precedence. Custom
+ * implementations of halide_do_par_for may ignore it. */
+extern int halide_set_parallel_inline_extent(int extent);
+
+/** Pin the calling thread to the given logical cpu. Returns zero on
+ * success, nonzero on failure or on platforms without affinity
+ * support. */
+extern int halide_pin_thread_to_cpu(int cpu);
+
+/** Pinning policies for the worker threads of the default thread
+ * pool. On multi-socket machines, pinning keeps a worker's stolen-from
+ * neighbours, and hence most of its working set, on its own node. */
+typedef enum halide_thread_pinning_t {
+    /** Let the OS place worker threads. The default. */
+    halide_thread_pinning_none = 0,
+    /** Pin worker i to logical cpu i+1 (leaving cpu 0 to the thread
+     * that launched the pipeline), so adjacently numbered workers
+     * share a cache and, on most machines, a socket. */
+    halide_thread_pinning_compact = 1,
+    /** Pin workers to even-numbered cpus first, then odd-numbered
+     * ones, spreading them across SMT pairs (or sockets that
+     * interleave cpu numbers) before doubling up. */
+    halide_thread_pinning_spread = 2
+} halide_thread_pinning_t;
+
+/** Set the pinning policy for the default thread pool's workers.
+ * Returns the old policy. Only affects worker threads spawned after
+ * the call, so set it before the first parallel loop runs (or call
+ * halide_shutdown_thread_pool first). Can also be set with the
+ * HL_THREAD_PINNING environment variable (0, 1, or 2, matching
+ * halide_thread_pinning_t), read when the thread pool is first
+ * initialized; an explicit call takes precedence. */
+extern int halide_set_thread_pinning(int pinning);
+
+/** Core classes on machines with heterogeneous cpus (e.g. ARM
+ * big.LITTLE). On Linux, cpus are classified by their sysfs
+ * cpu_capacity (falling back to cpuinfo_max_freq); the cpus with the
+ * highest value are the big class and everything else is LITTLE. On
+ * homogeneous machines, and on platforms without a way to tell cores
+ * apart, every cpu counts as big and the LITTLE class is empty. */
+typedef enum halide_cpu_core_class_t {
+    /** Any core; no restriction. */
+    halide_cpu_core_any = 0,
+    /** The performance cores. */
+    halide_cpu_core_big = 1,
+    /** The efficiency cores. */
+    halide_cpu_core_little = 2
+} halide_cpu_core_class_t;
+
+/** The number of logical cpus in the given core class. Useful for
+ * sizing the thread pool to a class before restricting it, e.g.
+ * halide_set_num_threads(halide_host_cpu_count_of_class(halide_cpu_core_big)). */
+extern int halide_host_cpu_count_of_class(int core_class);
+
+/** Restrict the calling thread to the cpus of the given core class
+ * (or to all cpus for halide_cpu_core_any, or for a class that is
+ * empty on this machine). Returns zero on success, nonzero on failure
+ * or on platforms without affinity support. */
+extern int halide_pin_thread_to_core_class(int core_class);
+
+/** Restrict the default thread pool's workers to a core class.
+ * Parallel loops launched after the call run their tasks on cpus of
+ * that class only, so a latency-critical pipeline can be kept off the
+ * LITTLE cores (or a background one confined to them); pass
+ * halide_cpu_core_any to lift the restriction. The class is captured
+ * when a loop is launched, so it can be changed per invocation, and
+ * loops already in flight are unaffected. While a class other than
+ * halide_cpu_core_any is in effect it overrides the per-cpu placement
+ * of halide_set_thread_pinning for the workers involved. The calling
+ * thread also helps run its own loops and is left alone; pin it with
+ * halide_pin_thread_to_core_class if it should be restricted too.
+ * Returns the old class. Can also be set with the
+ * HL_THREAD_CORE_CLASS environment variable (0, 1, or 2, matching
+ * halide_cpu_core_class_t), read when the thread pool is first
+ * initialized; an explicit call takes precedence. On platforms
+ * without affinity support this is a no-op. */
+extern int halide_set_thread_pool_core_class(int core_class);
+
 /** Halide calls these functions to allocate and free memory. To
  * replace in AOT code, use the halide_set_custom_malloc and
  * halide_set_custom_free, or (on platforms that support weak
@@ -208,6 +416,40 @@ extern halide_malloc_t halide_set_custom_malloc(halide_malloc_t user_malloc);
 extern halide_free_t halide_set_custom_free(halide_free_t user_free);
 //@}
 
+/** Called by Halide-generated code to hint that the first bytes of an
+ * allocation obtained from halide_malloc are dead: the pipeline has
+ * finished consuming them and will not touch them again before the
+ * allocation is freed. The default implementation returns fully dead
+ * pages of large allocations to the operating system, so a big
+ * intermediate consumed front-to-back by a later stage stops counting
+ * against peak resident memory as consumption proceeds. The contents
+ * of the released range become undefined. A no-op when a custom
+ * allocator is installed, and always safe to ignore. */
+extern int halide_release_allocation_prefix(void *user_context, void *ptr, uint64_t bytes);
+
+/** Set the maximum number of bytes of freed allocations the default
+ * allocator may hold for reuse. Pipelines that repeatedly realize
+ * similarly-sized intermediates recycle their temporary buffers from
+ * this pool instead of going through malloc and free each time. Zero
+ * (the default) disables pooling and releases anything currently
+ * held. Can also be set with the HL_ALLOCATION_POOL_SIZE environment
+ * variable. Has no effect on custom allocators. */
+extern void halide_set_allocation_pool_size(int64_t size);
+
+/** Apply a named bundle of runtime configuration, setting the thread
+ * count, the allocation pool budget, and the memoization cache size
+ * together. The profiles are:
+ *
+ * - "default": the out-of-the-box settings.
+ * - "low-latency": pool freed allocations so steady-state
+ *   realizations do no allocation work.
+ * - "batch-throughput": a large memoization cache; no pooling.
+ *
+ * Returns zero on success, or an error code for an unknown profile
+ * name. Settings applied afterwards with the individual functions
+ * above win. */
+extern int halide_apply_runtime_profile(void *user_context, const char *name);
+
 /** Halide calls these functions to interact with the underlying
  * system runtime functions. To replace in AOT code on platforms that
  * support weak linking, define these functions yourself, or use
@@ -254,8 +496,9 @@ typedef enum halide_type_code_t
 {
     halide_type_int = 0,   //!< signed integers
     halide_type_uint = 1,  //!< unsigned integers
-    halide_type_float = 2, //!< floating point numbers
-    halide_type_handle = 3 //!< opaque pointer type (void *)
+    halide_type_float = 2, //!< IEEE floating point numbers
+    halide_type_handle = 3, //!< opaque pointer type (void *)
+    halide_type_bfloat = 4 //!< floating point numbers in the bfloat format
 } halide_type_code_t;
 
 // Note that while __attribute__ can go before or after the declaration,
@@ -325,7 +568,9 @@ enum halide_trace_event_code_t {halide_trace_load = 0,
                                 halide_trace_consume = 6,
                                 halide_trace_end_consume = 7,
                                 halide_trace_begin_pipeline = 8,
-                                halide_trace_end_pipeline = 9};
+                                halide_trace_end_pipeline = 9,
+                                halide_trace_begin_task = 10,
+                                halide_trace_end_task = 11};
 
 struct halide_trace_event_t {
     /** The name of the Func or Pipeline that this event refers to */
@@ -346,6 +591,13 @@ struct halide_trace_event_t {
      * min0, extent0, min1, extent1, ...
      *
      * For pipeline-related events, this will be null.
+     *
+     * For task events (emitted by the thread pool when the
+     * HL_TRACE_TASKS environment variable is set), this contains the
+     * worker thread id (-1 for the thread that launched the loop),
+     * the task index, and the low and high 32 bits of the address of
+     * the task function, which identifies the loop. The value field
+     * holds a uint64 timestamp in nanoseconds.
      */
     int32_t *coordinates;
 
@@ -476,9 +728,35 @@ struct halide_trace_packet_t {
  * Halide checks the for existence of an environment variable called
  * HL_TRACE_FILE and opens that file. If HL_TRACE_FILE is not defined,
  * it outputs trace information to stdout in a human-readable
- * format. */
+ * format.
+ *
+ * If the environment variable HL_TRACE_ASYNC is also set, full trace
+ * buffers are written to the file by a background thread, so pipeline
+ * threads swap to an empty buffer and keep going instead of stalling
+ * on disk I/O. This makes coarse-grained tracing (e.g. just
+ * trace_realizations) cheap enough to leave on in production. The
+ * packets written are the same; only who writes them changes. */
 extern void halide_set_trace_file(int fd);
 
+/** Make binary tracing lossy instead of applying backpressure to the
+ * pipeline. When the trace buffers are full and the background
+ * drainer has not caught up, events are dropped and counted rather
+ * than stalling the compute thread on the sink. The losses are
+ * recorded in the trace as loads of a pseudo-func named "<dropped>"
+ * whose uint64 value is the number of events lost since the previous
+ * such record. Can also be enabled with the HL_TRACE_LOSSY
+ * environment variable; either way it implies asynchronous draining
+ * (see HL_TRACE_ASYNC above). */
+extern void halide_set_trace_lossy(int lossy);
+
+/** Set a sampling rate for one trace event type (a value from
+ * halide_trace_event_code_t). A rate of 1 (the default) keeps every
+ * event, n keeps every nth, and 0 drops the event type entirely.
+ * Sampled-out events still consume packet ids, so ids remain unique.
+ * Sampling begin/end events leaves the trace structurally
+ * incomplete; most tools only tolerate sampled loads and stores. */
+extern void halide_set_trace_sample_rate(int event, int rate);
+
 /** Halide calls this to retrieve the file descriptor to write binary
  * trace events to. The default implementation returns the value set
  * by halide_set_trace_file. Implement it yourself if you wish to use
@@ -549,6 +827,21 @@ extern void halide_device_release(void *user_context,
  * explicitly to copy back the results of a GPU-based filter. */
 extern int halide_copy_to_host(void *user_context, struct halide_buffer_t *buf);
 
+/** Begin copying a contiguous range of the outermost dimension of buf
+ * from device memory to host memory. Emitted by lowering for Funcs
+ * scheduled with Func::stream_readback, so that read-back of
+ * completed slabs overlaps remaining device work on backends that
+ * support it. The host may not touch the rows until
+ * halide_readback_fence returns. Not intended to be called
+ * directly. */
+extern int halide_readback_slice(void *user_context, struct halide_buffer_t *buf,
+                                 int slice_min, int slice_extent);
+
+/** Wait until every copy issued via halide_readback_slice on this
+ * buffer has completed, and mark the host copy clean. Not intended to
+ * be called directly. */
+extern int halide_readback_fence(void *user_context, struct halide_buffer_t *buf);
+
 /** Copy image data from host memory to device memory. This should not
  * be called directly; Halide handles copying to the device
  * automatically.  If interface is NULL and the bug has a non-zero dev
@@ -572,6 +865,47 @@ extern int halide_buffer_copy(void *user_context, struct halide_buffer_t *src,
                               const struct halide_device_interface_t *dst_device_interface,
                               struct halide_buffer_t *dst);
 
+/** Region math for code that distributes a pipeline's output across
+ * workers (e.g. machines in a cluster) using the bounds-query
+ * protocol: shard the output, intersect and union the per-shard input
+ * regions the query reports, and size the resulting transfers.
+ * Regions are arrays of halide_dimension_t, the representation the
+ * bounds-query protocol uses in halide_buffer_t::dim; only min and
+ * extent are meaningful, strides are ignored (and zeroed in results).
+ * @{ */
+
+/** Split the range [min, min+extent) into num_shards contiguous
+ * pieces of near-equal size (no two shards differ by more than one
+ * iteration) and store piece `shard` (0 <= shard < num_shards) into
+ * *shard_min / *shard_extent. Shards with more iterations come first,
+ * and a shard may be empty if num_shards > extent. */
+extern void halide_region_shard(int min, int extent, int num_shards, int shard,
+                                int *shard_min, int *shard_extent);
+
+/** Intersect two regions of the given dimensionality. Returns true if
+ * the intersection is non-empty; an empty intersection has all
+ * extents zeroed. result may alias a or b. */
+extern bool halide_region_intersect(int dimensions,
+                                    const struct halide_dimension_t *a,
+                                    const struct halide_dimension_t *b,
+                                    struct halide_dimension_t *result);
+
+/** The bounding box of two regions of the given dimensionality. Empty
+ * regions contribute nothing. result may alias a or b. */
+extern void halide_region_union(int dimensions,
+                                const struct halide_dimension_t *a,
+                                const struct halide_dimension_t *b,
+                                struct halide_dimension_t *result);
+
+/** The number of bytes a densely-packed copy of the region occupies:
+ * the product of the extents times bytes_per_element. This is the
+ * size of the transfer needed to move the region between workers,
+ * regardless of the strides it is stored with at either end. */
+extern uint64_t halide_region_size_bytes(int dimensions,
+                                         const struct halide_dimension_t *region,
+                                         int bytes_per_element);
+/** @} */
+
 /** Give the destination buffer a device allocation which is an alias
  * for the same coordinate range in the source buffer. Modifies the
  * device, device_interface, and the device_dirty flag only. Only
@@ -598,6 +932,16 @@ extern int halide_device_release_crop(void *user_context,
  * should rarely be necessary, except maybe for profiling. */
 extern int halide_device_sync(void *user_context, struct halide_buffer_t *buf);
 
+/** Eagerly create the context, command queue, and other state a
+ * device API backend would otherwise make lazily inside the first
+ * pipeline call, which can take hundreds of milliseconds. Calling
+ * this at process start (e.g. from a worker thread, in parallel with
+ * other loading) keeps that cost off the first frame's critical
+ * path. Entirely optional: backends still initialize on first use if
+ * this is never called. Returns zero on success. */
+extern int halide_device_initialize(void *user_context,
+                                    const struct halide_device_interface_t *device_interface);
+
 /** Allocate device memory to back a halide_buffer_t. */
 extern int halide_device_malloc(void *user_context, struct halide_buffer_t *buf,
                                 const struct halide_device_interface_t *device_interface);
@@ -651,6 +995,33 @@ extern int halide_get_gpu_device(void *user_context);
  */
 extern void halide_memoization_cache_set_size(int64_t size);
 
+/** Eviction policies for the memoization cache. */
+enum halide_memoization_cache_policy_t {
+    /** Evict the least recently used entry. The default. */
+    halide_memoization_cache_policy_lru = 0,
+
+    /** Evict the entry with the lowest frequency-per-byte score
+     * (Greedy-Dual-Size-Frequency). Small, frequently hit entries
+     * stay resident while large entries that are only streamed
+     * through once are evicted first, even if they were touched more
+     * recently. */
+    halide_memoization_cache_policy_cost_aware = 1
+};
+
+/** Set the eviction policy used when the memoization cache exceeds
+ * the size set by halide_memoization_cache_set_size. Takes one of the
+ * halide_memoization_cache_policy_t values; unknown values are
+ * treated as LRU. Entries already cached keep their statistics, so
+ * the policy may be switched at any time. */
+extern void halide_memoization_cache_set_policy(int policy);
+
+/** Touch the memoization cache's locks and key-hashing code without
+ * looking anything up or storing anything, so that the first real
+ * lookup doesn't pay for cold code pages. Called by generated warmup
+ * entry points (see halide_pipeline_warmup); safe to call at any
+ * time. */
+extern void halide_memoization_cache_prime(void *user_context);
+
 /** Given a cache key for a memoized result, currently constructed
  *  from the Func name and top-level Func name plus the arguments of
  *  the computation, determine if the result is in the cache and
@@ -713,6 +1084,21 @@ extern void halide_memoization_cache_release(void *user_context, void *host);
  */
 extern void halide_memoization_cache_cleanup();
 
+/** The first call into a freshly loaded pipeline is typically several
+ * times slower than steady state: its code pages fault in, its
+ * buffers fault in, and the runtime services it uses are cold. Each
+ * externally visible filter gets a companion entry point named
+ * name_warmup(void *user_context, void *arena, uint64_t arena_size)
+ * which forwards to this function with the filter's own entry point,
+ * so latency-sensitive callers can pay those costs before the first
+ * real invocation. Pass the allocation the filter's outputs (or its
+ * custom allocator's pool) will live in as the arena, or null and
+ * zero to skip the arena pre-fault. The default implementation faults
+ * in the filter's entry page, touches one byte per page of the arena,
+ * and primes the allocator and the memoization cache. */
+extern int halide_pipeline_warmup(void *user_context, const void *entry_point,
+                                  void *arena, uint64_t arena_size);
+
 /** Create a unique file with a name of the form prefixXXXXXsuffix in an arbitrary
  * (but writable) directory; this is typically $TMP or /tmp, but the specific
  * location is not guaranteed. (Note that the exact form of the file name
@@ -1071,7 +1457,13 @@ typedef enum halide_target_feature_t {
     halide_target_feature_cuda_capability61 = 46,  ///< Enable CUDA compute capability 6.1 (Pascal)
     halide_target_feature_hvx_v65 = 47, ///< Enable Hexagon v65 architecture.
     halide_target_feature_hvx_v66 = 48, ///< Enable Hexagon v66 architecture.
-    halide_target_feature_end = 49, ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
+    halide_target_feature_sve_256 = 49, ///< Assume ARM SVE with 256-bit vectors. Vectorized code is generated at 256 bits instead of NEON's 128. Only relevant on 64-bit ARM.
+    halide_target_feature_arm_dot_prod = 50, ///< Enable the ARMv8.2 dot product instructions (SDOT and UDOT). Only relevant on 64-bit ARM.
+    halide_target_feature_profile_loops = 51, ///< Launch a sampling profiler alongside the Halide pipeline that monitors and reports at the granularity of individual loops, not just Funcs. Implies halide_target_feature_profile. Adds a store per iteration of each instrumented loop.
+    halide_target_feature_unchecked_entry = 52, ///< Also emit a "name_unchecked" copy of each pipeline entry point with all runtime checks stripped, for callers that have already validated their buffers against the checked entry point.
+    halide_target_feature_arm_fp16 = 53, ///< Enable the ARMv8.2 half-precision arithmetic instructions, and generate native float16 math instead of widening to float32. Only relevant on 64-bit ARM.
+    halide_target_feature_no_error_strings = 54, ///< Failed runtime checks return their halide_error_code_t directly instead of calling halide_error_* with a formatted message. No message strings are materialized or linked, which shrinks embedded binaries; the cost is that failures are only identifiable by code.
+    halide_target_feature_end = 55, ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
 } halide_target_feature_t;
 
 /** This function is called internally by Halide in some situations to determine
@@ -1140,7 +1532,12 @@ typedef struct halide_dimension_t {
 #endif
 
 typedef enum {halide_buffer_flag_host_dirty = 1,
-              halide_buffer_flag_device_dirty = 2} halide_buffer_flags;
+              halide_buffer_flag_device_dirty = 2,
+              /** The host allocation was made by the device runtime
+               * in page-locked (pinned) memory, and must be freed by
+               * it. Set by halide_device_and_host_malloc on device
+               * APIs that support pinned allocation. */
+              halide_buffer_flag_host_pinned = 4} halide_buffer_flags;
 
 /**
  * The raw representation of an image passed around by generated
@@ -1317,6 +1714,13 @@ typedef struct buffer_t {
 extern int halide_upgrade_buffer_t(void *user_context, const char *name,
                                    const buffer_t *old_buf, halide_buffer_t *new_buf);
 
+/** Copies just the dirty flags and device allocation state from an
+ * old-style buffer_t back to a new-style halide_buffer_t. Used after
+ * calling an extern stage that expects the legacy type, when the call
+ * was not a bounds query and so cannot have changed the shape. */
+extern int halide_upgrade_buffer_t_device_fields(void *user_context, const char *name,
+                                                 const buffer_t *old_buf, halide_buffer_t *new_buf);
+
 /** Copies the host pointer, mins, extents, strides, and device state
  * from a halide_buffer_t to a buffer_t. Also sets elem_size. Useful
  * for backporting the results of bounds inference. */
@@ -1437,6 +1841,41 @@ struct halide_profiler_func_stats {
 
     /** The total number of memory allocation of this Func. */
     int num_allocs;
+
+    /** Hardware cache misses attributed to this Func, if hardware
+     * counters are being sampled (see
+     * halide_profiler_read_hw_counters). */
+    uint64_t cache_misses;
+
+    /** Stalled processor cycles attributed to this Func, if hardware
+     * counters are being sampled. */
+    uint64_t stalled_cycles;
+
+    /** The memory allocation of this Func that was live when the
+     * pipeline hit its peak heap usage. Together these snapshots say
+     * which combination of Funcs was co-resident at the high-water
+     * mark. */
+    uint64_t memory_at_peak;
+};
+
+/** Per-specialization state tracked by the profiler. One exists for
+ * each specialize() branch that has been taken at least once at
+ * runtime. These exist in a linked list per pipeline. */
+struct halide_profiler_specialization_stats {
+    /** The number of times this specialization's branch was taken. */
+    uint64_t hits;
+
+    /** The name of the Stage the specialization belongs to,
+     * e.g. "f.s0". A global constant string. */
+    const char *func;
+
+    /** The specialization condition, pretty-printed. A global
+     * constant string. */
+    const char *condition;
+
+    /** The next specialization_stats pointer. It's a void * because
+     * types in the Halide runtime may not currently be recursive. */
+    void *next;
 };
 
 /** Per-pipeline state tracked by the sampling profiler. These exist
@@ -1482,6 +1921,11 @@ struct halide_profiler_pipeline_stats {
 
     /** The total number of memory allocation of funcs in this pipeline. */
     int num_allocs;
+
+    /** A linked list of hit counts for each specialize() branch taken
+     * while running this pipeline. Only branches that have been taken
+     * at least once are present. */
+    struct halide_profiler_specialization_stats *specializations;
 };
 
 /** The global state of the profiler. */
@@ -1535,6 +1979,25 @@ extern struct halide_profiler_state *halide_profiler_get_state();
  * This function grabs the global profiler state's lock on entry. */
 extern struct halide_profiler_pipeline_stats *halide_profiler_get_pipeline_state(const char *pipeline_name);
 
+/** Record that a specialize() branch was taken. Called by compiled
+ * pipelines when profiling is enabled. func and condition are global
+ * constant strings baked into the pipeline, so each branch passes a
+ * unique pair. */
+extern int halide_profiler_specialization_hit(void *pipeline_state,
+                                              const char *func,
+                                              const char *condition);
+
+/** Read the cumulative hardware performance counters the profiler
+ * samples alongside wall-clock time. Returns zero and fills in the
+ * counts on success, or nonzero if hardware counters are unavailable.
+ * The first call opens the counters. Only implemented on Linux, via
+ * perf_event; system-wide counters require perf_event_paranoid <= 0
+ * or CAP_SYS_ADMIN, and the profiler silently reports times only when
+ * access is denied. Not thread-safe; intended to be called from the
+ * profiler thread. */
+extern int halide_profiler_read_hw_counters(uint64_t *cache_misses,
+                                            uint64_t *stalled_cycles);
+
 /** Reset all profiler state.
  * WARNING: Do NOT call this method while any halide pipeline is
  * running; halide_profiler_memory_allocate/free and
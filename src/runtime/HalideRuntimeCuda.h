@@ -30,7 +30,8 @@ extern int halide_cuda_run(void *user_context,
                            int num_attributes,
                            float* vertex_buffer,
                            int num_coords_dim0,
-                           int num_coords_dim1);
+                           int num_coords_dim1,
+                           void **run_state);
 // @}
 
 /** Set the underlying cuda device poiner for a buffer. The device
@@ -57,6 +58,45 @@ extern int halide_cuda_detach_device_ptr(void *user_context, struct halide_buffe
  */
 extern uintptr_t halide_cuda_get_device_ptr(void *user_context, struct halide_buffer_t *buf);
 
+/** Set the CUDA stream Halide issues its copies and kernel launches
+ * on, so Halide work can be interleaved with other CUDA work in the
+ * application. The stream (a CUstream, passed as a void pointer to
+ * keep the CUDA headers out of this file) must belong to the context
+ * Halide is using and must outlive any use of it by Halide. Copies to
+ * the device are issued asynchronously on this stream and are ordered
+ * with respect to the kernels on it; copies back to the host
+ * synchronize the stream before returning. Pass NULL to return to the
+ * default stream. This is a convenience alternative to overriding
+ * halide_cuda_get_stream at link time. */
+extern int halide_cuda_set_stream(void *user_context, void *stream);
+
+/** Query the occupancy-optimal number of threads per block for one of
+ * the kernels in a compiled pipeline, so a single binary can pick a
+ * block size per device at runtime. state_ptr is the module state
+ * filled in by halide_cuda_initialize_kernels (the __user_context
+ * symbol in generated code), and entry_name is the kernel name as it
+ * appears in the generated source. The result, computed with
+ * cuOccupancyMaxPotentialBlockSize, is stored in *block_size; feed it
+ * (or a tiling derived from it) to the Params driving a symbolic
+ * gpu_tile. block_size_limit bounds the answer (0 means no limit) and
+ * dynamic_shared_mem_bytes should be the dynamic shared memory the
+ * kernel is launched with. Requires a CUDA 6.5 or later driver;
+ * returns an error on older drivers. */
+extern int halide_cuda_max_potential_block_size(void *user_context, void *state_ptr,
+                                                const char *entry_name,
+                                                int *block_size,
+                                                int block_size_limit,
+                                                size_t dynamic_shared_mem_bytes);
+
+/** The CUDA runtime caches freed device allocations and hands them
+ * back to later allocations of the same size instead of paying for a
+ * cuMemAlloc/cuMemFree round-trip per realization. Call this to
+ * return all currently-unused cached allocations to the driver, e.g.
+ * before another library needs the device memory. The cache is also
+ * flushed automatically when an allocation fails and on
+ * halide_device_release. */
+extern int halide_cuda_release_unused_device_allocations(void *user_context);
+
 #ifdef __cplusplus
 } // End extern "C"
 #endif
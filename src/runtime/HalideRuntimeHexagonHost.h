@@ -55,6 +55,25 @@ extern int halide_hexagon_power_hvx_off(void *user_context);
 extern void halide_hexagon_power_hvx_off_as_destructor(void *user_context, void * /* obj */);
 // @}
 
+/** Batch several pipeline invocations into a single FastRPC round
+ * trip. Between begin and end, Halide pipelines offloaded to Hexagon
+ * queue their marshalled arguments on the host instead of calling into
+ * the DSP, and end sends the whole queue in one RPC, running the
+ * pipelines back to back with HVX powered on once for the batch. This
+ * amortizes the per-call RPC overhead when many pipelines run per
+ * frame. Outputs are not valid until the batch is flushed; the batch
+ * is flushed by halide_hexagon_end_rpc_batch, or implicitly if
+ * something copies a buffer back to the host mid-batch. Input and
+ * output buffers referenced by queued invocations must stay live until
+ * the flush. Errors from the batched pipelines are reported by the
+ * flushing call; begin returns nonzero (and batching is disabled) if
+ * libhalide_hexagon_host.so predates
+ * halide_hexagon_remote_run_batch. */
+// @{
+extern int halide_hexagon_begin_rpc_batch(void *user_context);
+extern int halide_hexagon_end_rpc_batch(void *user_context);
+// @}
+
 /** Power modes for Hexagon. */
 typedef enum halide_hexagon_power_mode_t {
     halide_hexagon_power_low     = 0,
@@ -31,7 +31,8 @@ extern int halide_metal_run(void *user_context,
                             int num_attributes,
                             float* vertex_buffer,
                             int num_coords_dim0,
-                            int num_coords_dim1);
+                            int num_coords_dim1,
+                            void **run_state);
 // @}
 
 /** Set the underlying MTLBuffer for a halide_buffer_t. This memory should be
@@ -30,7 +30,8 @@ extern int halide_opencl_run(void *user_context,
                              int num_attributes,
                              float* vertex_buffer,
                              int num_coords_dim0,
-                             int num_coords_dim1);
+                             int num_coords_dim1,
+                             void **run_state);
 // @}
 
 /** Set the platform name for OpenCL to use (e.g. "Intel" or
@@ -61,6 +62,27 @@ extern void halide_opencl_set_device_type(const char *n);
  * halide_set_ocl_device_type. */
 extern const char *halide_opencl_get_device_type(void *user_context);
 
+/** Set the directory the OpenCL runtime caches compiled program
+ * binaries in, keyed by a hash of the kernel source, the device name,
+ * the driver version and the build options. The argument is copied
+ * internally. Later runs load the binary
+ * (clCreateProgramWithBinary) instead of recompiling the source, and
+ * fall back to a source compile if the cached binary is missing or
+ * the driver rejects it. The directory must already exist. If never
+ * called, Halide uses the environment variable
+ * HL_OCL_PROGRAM_CACHE_DIR; if that is also unset, no caching is
+ * done. */
+extern void halide_opencl_set_program_cache_dir(const char *n);
+
+/** Halide calls this to get the program binary cache
+ * directory. Implement this yourself to use a different directory per
+ * user_context. The default implementation returns the value set by
+ * halide_opencl_set_program_cache_dir, or the environment variable
+ * HL_OCL_PROGRAM_CACHE_DIR. An empty string disables caching. The
+ * result is valid until the next call to
+ * halide_opencl_set_program_cache_dir. */
+extern const char *halide_opencl_get_program_cache_dir(void *user_context);
+
 /** Set the underlying cl_mem for a halide_buffer_t. This memory should be
  * allocated using clCreateBuffer or similar and must have an extent
  * large enough to cover that specified by the halide_buffer_t extent
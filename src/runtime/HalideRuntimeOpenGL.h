@@ -31,7 +31,8 @@ extern int halide_opengl_run(void *user_context,
                              int num_attributes,
                              float* vertex_buffer,
                              int num_coords_dim0,
-                             int num_coords_dim1);
+                             int num_coords_dim1,
+                             void **run_state);
 // @}
 
 /** Set the underlying OpenGL texture for a buffer. The texture must
@@ -41,7 +41,8 @@ extern int halide_openglcompute_run(void *user_context,
                              int num_attributes,
                              float* vertex_buffer,
                              int num_coords_dim0,
-                             int num_coords_dim1);
+                             int num_coords_dim1,
+                             void **run_state);
 // @}
 
 /** This function retrieves pointers to OpenGL API functions.
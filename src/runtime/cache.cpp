@@ -75,6 +75,12 @@ struct CacheEntry {
     uint32_t hash;
     uint32_t in_use_count; // 0 if none returned from halide_cache_lookup
     uint32_t tuple_count;
+    // Eviction bookkeeping: how many times this entry has been hit,
+    // the total bytes of stored data across the tuple buffers, and
+    // the entry's score under the cost-aware eviction policy.
+    uint32_t access_count;
+    uint64_t total_size;
+    uint64_t priority;
     // The shape of the computed data. There may be more data allocated than this.
     int32_t dimensions;
     halide_dimension_t *computed_bounds;
@@ -88,6 +94,15 @@ struct CacheEntry {
     void destroy();
     halide_buffer_t &buffer(int32_t i);
 
+    // Record a hit under the given shard clock, updating the entry's
+    // cost-aware priority: a Greedy-Dual-Size-Frequency score of
+    // clock + frequency / size, scaled to keep the division in
+    // integers.
+    void touch(uint64_t clock) {
+        access_count++;
+        const uint64_t kCostScale = 1 << 20;
+        priority = clock + (access_count * kCostScale) / (total_size + 1);
+    }
 };
 
 struct CacheBlockHeader {
@@ -120,6 +135,12 @@ WEAK bool CacheEntry::init(const uint8_t *cache_key, size_t cache_key_size,
     hash = key_hash;
     in_use_count = 0;
     tuple_count = tuples;
+    access_count = 0;
+    total_size = 0;
+    for (int32_t i = 0; i < tuples; i++) {
+        total_size += tuple_buffers[i]->size_in_bytes();
+    }
+    priority = 0;
     dimensions = computed_bounds_buf->dimensions;
 
     // Allocate all the necessary space (or die)
@@ -185,34 +206,72 @@ WEAK uint32_t djb_hash(const uint8_t *key, size_t key_size)  {
     return h;
 }
 
-WEAK halide_mutex memoization_lock;
+// The cache is sharded by key hash so that lookups of distinct keys
+// on different threads don't contend on a single lock. Each shard is
+// an independent hash table with its own lock, LRU chain, and slice
+// of the total cache budget. Eviction is per-shard rather than
+// globally LRU; with hashing spreading entries evenly this is a close
+// approximation, and it keeps the fast path down to one uncontended
+// lock acquisition.
+const size_t kHashTableSize = 64;
+const size_t kNumShards = 16;  // must be a power of two
 
-const size_t kHashTableSize = 256;
+const uint64_t kDefaultCacheSize = 1 << 20;
 
-WEAK CacheEntry *cache_entries[kHashTableSize];
+struct CacheShard {
+    halide_mutex lock;
 
-WEAK CacheEntry *most_recently_used = NULL;
-WEAK CacheEntry *least_recently_used = NULL;
+    CacheEntry *entries[kHashTableSize];
 
-const uint64_t kDefaultCacheSize = 1 << 20;
-WEAK int64_t max_cache_size = kDefaultCacheSize;
-WEAK int64_t current_cache_size = 0;
+    CacheEntry *most_recently_used;
+    CacheEntry *least_recently_used;
+
+    // The aging clock for the cost-aware eviction policy: the
+    // priority of the last entry evicted, so long-resident entries
+    // must keep earning hits to stay ahead of new arrivals.
+    uint64_t clock;
+
+    // Zero means the shard hasn't been given an explicit budget and
+    // uses its slice of kDefaultCacheSize.
+    int64_t max_size;
+    int64_t current_size;
+
+    int64_t effective_max_size() {
+        return max_size != 0 ? max_size : (int64_t)(kDefaultCacheSize / kNumShards);
+    }
+
+    void prune();
+    void evict(CacheEntry *entry);
+};
+
+WEAK CacheShard cache_shards[kNumShards];
+
+// One of halide_memoization_cache_policy_t. Read without any shard
+// lock held; switching policies mid-flight is harmless.
+WEAK int cache_eviction_policy = halide_memoization_cache_policy_lru;
+
+// The bucket index within a shard uses the low bits of the hash, so
+// pick the shard with bits above those.
+WEAK __attribute((always_inline)) CacheShard *shard_for_hash(uint32_t h) {
+    return &cache_shards[(h / kHashTableSize) & (kNumShards - 1)];
+}
 
 #if CACHE_DEBUGGING
-WEAK void validate_cache() {
-    print(NULL) << "validating cache, "
-                << "current size " << current_cache_size
-                << " of maximum " << max_cache_size << "\n";
+// Validates a single shard. Caller must hold the shard's lock.
+WEAK void validate_cache_shard(CacheShard *shard) {
+    print(NULL) << "validating cache shard, "
+                << "current size " << shard->current_size
+                << " of maximum " << shard->effective_max_size() << "\n";
     int entries_in_hash_table = 0;
     for (size_t i = 0; i < kHashTableSize; i++) {
-        CacheEntry *entry = cache_entries[i];
+        CacheEntry *entry = shard->entries[i];
         while (entry != NULL) {
             entries_in_hash_table++;
-            if (entry->more_recent == NULL && entry != most_recently_used) {
+            if (entry->more_recent == NULL && entry != shard->most_recently_used) {
                 halide_print(NULL, "cache invalid case 1\n");
                 __builtin_trap();
             }
-            if (entry->less_recent == NULL && entry != least_recently_used) {
+            if (entry->less_recent == NULL && entry != shard->least_recently_used) {
                 halide_print(NULL, "cache invalid case 2\n");
                 __builtin_trap();
             }
@@ -220,13 +279,13 @@ WEAK void validate_cache() {
         }
     }
     int entries_from_mru = 0;
-    CacheEntry *mru_chain = most_recently_used;
+    CacheEntry *mru_chain = shard->most_recently_used;
     while (mru_chain != NULL) {
         entries_from_mru++;
         mru_chain = mru_chain->less_recent;
     }
     int entries_from_lru = 0;
-    CacheEntry *lru_chain = least_recently_used;
+    CacheEntry *lru_chain = shard->least_recently_used;
     while (lru_chain != NULL) {
         entries_from_lru++;
         lru_chain = lru_chain->more_recent;
@@ -242,71 +301,292 @@ WEAK void validate_cache() {
         halide_print(NULL, "cache invalid case 4\n");
         __builtin_trap();
     }
-    if (current_cache_size < 0) {
+    if (shard->current_size < 0) {
         halide_print(NULL, "cache size is negative\n");
         __builtin_trap();
     }
 }
 #endif
 
-WEAK void prune_cache() {
+// Remove a single entry from the shard and deallocate it. Caller must
+// hold the shard's lock, and the entry must not be in use.
+WEAK void CacheShard::evict(CacheEntry *entry) {
+    uint32_t h = entry->hash;
+    uint32_t index = h % kHashTableSize;
+
+    // Remove from hash table
+    CacheEntry *prev_hash_entry = entries[index];
+    if (prev_hash_entry == entry) {
+        entries[index] = entry->next;
+    } else {
+        while (prev_hash_entry != NULL && prev_hash_entry->next != entry) {
+            prev_hash_entry = prev_hash_entry->next;
+        }
+        halide_assert(NULL, prev_hash_entry != NULL);
+        prev_hash_entry->next = entry->next;
+    }
+
+    CacheEntry *more_recent = entry->more_recent;
+
+    // Remove from less recent chain.
+    if (least_recently_used == entry) {
+        least_recently_used = more_recent;
+    }
+    if (more_recent != NULL) {
+        more_recent->less_recent = entry->less_recent;
+    }
+
+    // Remove from more recent chain.
+    if (most_recently_used == entry) {
+        most_recently_used = entry->less_recent;
+    }
+    if (entry->less_recent != NULL) {
+        entry->less_recent->more_recent = more_recent;
+    }
+
+    // Decrease cache used amount.
+    current_size -= entry->total_size;
+
+    // Under the cost-aware policy, the clock advances to the evicted
+    // entry's priority, so surviving entries age relative to it.
+    if (entry->priority > clock) {
+        clock = entry->priority;
+    }
+
+    // Deallocate the entry.
+    entry->destroy();
+    halide_free(NULL, entry);
+}
+
+// Caller must hold the shard's lock.
+WEAK void CacheShard::prune() {
 #if CACHE_DEBUGGING
-    validate_cache();
+    validate_cache_shard(this);
 #endif
-    CacheEntry *prune_candidate = least_recently_used;
-    while (current_cache_size > max_cache_size &&
-           prune_candidate != NULL) {
-        CacheEntry *more_recent = prune_candidate->more_recent;
-
-        if (prune_candidate->in_use_count == 0) {
-            uint32_t h = prune_candidate->hash;
-            uint32_t index = h % kHashTableSize;
-
-            // Remove from hash table
-            CacheEntry *prev_hash_entry = cache_entries[index];
-            if (prev_hash_entry == prune_candidate) {
-                cache_entries[index] = prune_candidate->next;
-            } else {
-                while (prev_hash_entry != NULL && prev_hash_entry->next != prune_candidate) {
-                    prev_hash_entry = prev_hash_entry->next;
+    if (cache_eviction_policy == halide_memoization_cache_policy_cost_aware) {
+        // Evict the eligible entry with the lowest
+        // frequency-per-byte score until we fit. The LRU chain links
+        // every entry in the shard, so use it as the iteration order.
+        while (current_size > effective_max_size()) {
+            CacheEntry *victim = NULL;
+            for (CacheEntry *entry = least_recently_used; entry != NULL;
+                 entry = entry->more_recent) {
+                if (entry->in_use_count == 0 &&
+                    (victim == NULL || entry->priority < victim->priority)) {
+                    victim = entry;
                 }
-                halide_assert(NULL, prev_hash_entry != NULL);
-                prev_hash_entry->next = prune_candidate->next;
             }
-
-            // Remove from less recent chain.
-            if (least_recently_used == prune_candidate) {
-                least_recently_used = more_recent;
-            }
-            if (more_recent != NULL) {
-                more_recent->less_recent = prune_candidate->less_recent;
-            }
-
-            // Remove from more recent chain.
-            if (most_recently_used == prune_candidate) {
-                most_recently_used = prune_candidate->less_recent;
-            }
-            if (prune_candidate->less_recent != NULL) {
-                prune_candidate->less_recent = more_recent;
+            if (victim == NULL) {
+                break;
             }
+            evict(victim);
+        }
+    } else {
+        CacheEntry *prune_candidate = least_recently_used;
+        while (current_size > effective_max_size() &&
+               prune_candidate != NULL) {
+            CacheEntry *more_recent = prune_candidate->more_recent;
 
-            // Decrease cache used amount.
-            for (uint32_t i = 0; i < prune_candidate->tuple_count; i++) {
-                current_cache_size -= prune_candidate->buf[i].size_in_bytes();
+            if (prune_candidate->in_use_count == 0) {
+                evict(prune_candidate);
             }
 
-            // Deallocate the entry.
-            prune_candidate->destroy();
-            halide_free(NULL, prune_candidate);
+            prune_candidate = more_recent;
         }
-
-        prune_candidate = more_recent;
     }
 #if CACHE_DEBUGGING
-    validate_cache();
+    validate_cache_shard(this);
 #endif
 }
 
+// An optional persistent backend. If HL_MEMOIZATION_CACHE_DIR is set,
+// entries are written to files in that directory on store, and
+// in-memory misses fall back to loading from disk, so memoized
+// results survive across processes. The generated keys contain a
+// content hash of the memoized function's definition rather than
+// anything process-specific, so a file written by one process is safe
+// to load in another.
+//
+// Each file holds a fixed header, the full key (the hash in the
+// filename is not trusted), the computed bounds, and then for each
+// tuple component its type, its allocated shape, and the raw host
+// data. Files are written to a temporary name and renamed into place
+// so readers never see a partial entry.
+
+struct CacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t key_size;
+    uint32_t tuple_count;
+    int32_t dimensions;
+};
+
+const uint32_t kCacheFileMagic = 0x484c4d43; // "HLMC"
+const uint32_t kCacheFileVersion = 1;
+
+WEAK uint64_t fnv1a_hash_64(const uint8_t *key, size_t key_size) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < key_size; i++) {
+        h ^= key[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Writes dir + "/" + 16 hex digits of the key hash + suffix into
+// buf. Returns false if it doesn't fit.
+WEAK bool cache_file_path(char *buf, size_t buf_size, const char *dir,
+                          const uint8_t *cache_key, size_t key_size,
+                          const char *suffix) {
+    uint64_t h = fnv1a_hash_64(cache_key, key_size);
+    size_t dir_len = strlen(dir);
+    size_t suffix_len = strlen(suffix);
+    if (dir_len + 1 + 16 + suffix_len + 1 > buf_size) {
+        return false;
+    }
+    char *dst = buf;
+    memcpy(dst, dir, dir_len);
+    dst += dir_len;
+    *dst++ = '/';
+    for (int i = 15; i >= 0; i--) {
+        int nibble = (int)((h >> (i * 4)) & 0xf);
+        *dst++ = (nibble < 10) ? ('0' + nibble) : ('a' + (nibble - 10));
+    }
+    memcpy(dst, suffix, suffix_len + 1);
+    return true;
+}
+
+// Fills the already-allocated host storage of tuple_buffers from the
+// on-disk entry for cache_key, if there is one and it matches the
+// requested shapes. Returns true on a complete load.
+WEAK bool cache_load_from_file(void *user_context, const char *dir,
+                               const uint8_t *cache_key, int32_t size,
+                               halide_buffer_t *computed_bounds,
+                               int32_t tuple_count, halide_buffer_t **tuple_buffers) {
+    char path[1024];
+    if (!cache_file_path(path, sizeof(path), dir, cache_key, size, ".halide_cache")) {
+        return false;
+    }
+    void *f = fopen(path, "rb");
+    if (f == NULL) {
+        return false;
+    }
+
+    bool ok = false;
+    uint8_t *stored_key = NULL;
+    halide_dimension_t *stored_shape = NULL;
+    do {
+        CacheFileHeader header;
+        if (fread(&header, sizeof(header), 1, f) != 1 ||
+            header.magic != kCacheFileMagic ||
+            header.version != kCacheFileVersion ||
+            header.key_size != (uint32_t)size ||
+            header.tuple_count != (uint32_t)tuple_count ||
+            header.dimensions != computed_bounds->dimensions) {
+            break;
+        }
+
+        // The filename hash can collide; the stored key must match exactly.
+        stored_key = (uint8_t *)halide_malloc(user_context, size);
+        if (stored_key == NULL ||
+            fread(stored_key, 1, size, f) != (size_t)size ||
+            !keys_equal(stored_key, cache_key, size)) {
+            break;
+        }
+
+        int32_t dimensions = header.dimensions;
+        stored_shape = (halide_dimension_t *)halide_malloc(
+            user_context, sizeof(halide_dimension_t) * (dimensions ? dimensions : 1));
+        if (stored_shape == NULL) {
+            break;
+        }
+
+        size_t shape_bytes = sizeof(halide_dimension_t) * dimensions;
+        if (shape_bytes != 0 &&
+            (fread(stored_shape, shape_bytes, 1, f) != 1 ||
+             !buffer_has_shape(computed_bounds, stored_shape))) {
+            break;
+        }
+
+        bool tuples_ok = true;
+        for (int32_t i = 0; tuples_ok && i < tuple_count; i++) {
+            halide_buffer_t *buf = tuple_buffers[i];
+            halide_type_t stored_type;
+            tuples_ok =
+                fread(&stored_type, sizeof(stored_type), 1, f) == 1 &&
+                stored_type == buf->type &&
+                (shape_bytes == 0 ||
+                 (fread(stored_shape, shape_bytes, 1, f) == 1 &&
+                  buffer_has_shape(buf, stored_shape))) &&
+                fread(buf->host, 1, buf->size_in_bytes(), f) == buf->size_in_bytes();
+        }
+        ok = tuples_ok;
+    } while (0);
+
+    if (stored_key != NULL) {
+        halide_free(user_context, stored_key);
+    }
+    if (stored_shape != NULL) {
+        halide_free(user_context, stored_shape);
+    }
+    fclose(f);
+    return ok;
+}
+
+// Writes the entry to disk. Failures are silent: the persistent cache
+// is strictly an optimization and the in-memory entry is already in
+// place.
+WEAK void cache_store_to_file(void *user_context, const char *dir,
+                              const uint8_t *cache_key, int32_t size,
+                              halide_buffer_t *computed_bounds,
+                              int32_t tuple_count, halide_buffer_t **tuple_buffers) {
+    // Only host-resident data can be persisted.
+    for (int32_t i = 0; i < tuple_count; i++) {
+        if (tuple_buffers[i]->device != 0) {
+            return;
+        }
+    }
+
+    char path[1024], tmp_path[1024];
+    if (!cache_file_path(path, sizeof(path), dir, cache_key, size, ".halide_cache") ||
+        !cache_file_path(tmp_path, sizeof(tmp_path), dir, cache_key, size, ".halide_cache.tmp")) {
+        return;
+    }
+
+    void *f = fopen(tmp_path, "wb");
+    if (f == NULL) {
+        return;
+    }
+
+    CacheFileHeader header;
+    header.magic = kCacheFileMagic;
+    header.version = kCacheFileVersion;
+    header.key_size = (uint32_t)size;
+    header.tuple_count = (uint32_t)tuple_count;
+    header.dimensions = computed_bounds->dimensions;
+
+    size_t shape_bytes = sizeof(halide_dimension_t) * header.dimensions;
+    bool ok =
+        fwrite(&header, sizeof(header), 1, f) == 1 &&
+        fwrite(cache_key, 1, size, f) == (size_t)size &&
+        (shape_bytes == 0 ||
+         fwrite(computed_bounds->dim, shape_bytes, 1, f) == 1);
+    for (int32_t i = 0; ok && i < tuple_count; i++) {
+        halide_buffer_t *buf = tuple_buffers[i];
+        ok = fwrite(&buf->type, sizeof(buf->type), 1, f) == 1 &&
+             (shape_bytes == 0 ||
+              fwrite(buf->dim, shape_bytes, 1, f) == 1) &&
+             fwrite(buf->host, 1, buf->size_in_bytes(), f) == buf->size_in_bytes();
+    }
+
+    fclose(f);
+    if (ok) {
+        rename(tmp_path, path);
+    } else {
+        remove(tmp_path);
+    }
+}
+
 }}} // namespace Halide::Runtime::Internal
 
 extern "C" {
@@ -316,18 +596,48 @@ WEAK void halide_memoization_cache_set_size(int64_t size) {
         size = kDefaultCacheSize;
     }
 
-    ScopedMutexLock lock(&memoization_lock);
+    // Divide the budget evenly among the shards.
+    int64_t per_shard = size / (int64_t)kNumShards;
+    if (per_shard < 1) {
+        per_shard = 1;
+    }
+    for (size_t i = 0; i < kNumShards; i++) {
+        CacheShard *shard = &cache_shards[i];
+        ScopedMutexLock lock(&shard->lock);
+        shard->max_size = per_shard;
+        shard->prune();
+    }
+}
 
-    max_cache_size = size;
-    prune_cache();
+WEAK void halide_memoization_cache_set_policy(int policy) {
+    if (policy != halide_memoization_cache_policy_cost_aware) {
+        policy = halide_memoization_cache_policy_lru;
+    }
+    cache_eviction_policy = policy;
+}
+
+WEAK void halide_memoization_cache_prime(void *user_context) {
+    // Run a throwaway key through the hash and take each shard's lock
+    // once, so that the first real lookup doesn't pay for cold code
+    // pages or a contended first touch of the lock words.
+    uint8_t dummy_key[16];
+    for (size_t i = 0; i < sizeof(dummy_key); i++) {
+        dummy_key[i] = (uint8_t)i;
+    }
+    uint32_t h = djb_hash(dummy_key, sizeof(dummy_key));
+    (void)shard_for_hash(h);
+    for (size_t i = 0; i < kNumShards; i++) {
+        ScopedMutexLock lock(&cache_shards[i].lock);
+    }
 }
 
 WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
                                          halide_buffer_t *computed_bounds, int32_t tuple_count, halide_buffer_t **tuple_buffers) {
     uint32_t h = djb_hash(cache_key, size);
     uint32_t index = h % kHashTableSize;
+    CacheShard *shard = shard_for_hash(h);
 
-    ScopedMutexLock lock(&memoization_lock);
+    ScopedMutexLock lock(&shard->lock);
 
 #if CACHE_DEBUGGING
     debug_print_key(user_context, "halide_memoization_cache_lookup", cache_key, size);
@@ -342,7 +652,7 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
     }
 #endif
 
-    CacheEntry *entry = cache_entries[index];
+    CacheEntry *entry = shard->entries[index];
     while (entry != NULL) {
         if (entry->hash == h && entry->key_size == (size_t)size &&
             keys_equal(entry->key, cache_key, size) &&
@@ -356,23 +666,23 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
             }
 
             if (all_bounds_equal) {
-                if (entry != most_recently_used) {
+                if (entry != shard->most_recently_used) {
                     halide_assert(user_context, entry->more_recent != NULL);
                     if (entry->less_recent != NULL) {
                         entry->less_recent->more_recent = entry->more_recent;
                     } else {
-                        halide_assert(user_context, least_recently_used == entry);
-                        least_recently_used = entry->more_recent;
+                        halide_assert(user_context, shard->least_recently_used == entry);
+                        shard->least_recently_used = entry->more_recent;
                     }
                     halide_assert(user_context, entry->more_recent != NULL);
                     entry->more_recent->less_recent = entry->less_recent;
 
                     entry->more_recent = NULL;
-                    entry->less_recent = most_recently_used;
-                    if (most_recently_used != NULL) {
-                        most_recently_used->more_recent = entry;
+                    entry->less_recent = shard->most_recently_used;
+                    if (shard->most_recently_used != NULL) {
+                        shard->most_recently_used->more_recent = entry;
                     }
-                    most_recently_used = entry;
+                    shard->most_recently_used = entry;
                 }
 
                 for (int32_t i = 0; i < tuple_count; i++) {
@@ -381,6 +691,7 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
                 }
 
                 entry->in_use_count += tuple_count;
+                entry->touch(shard->clock);
 
                 return 0;
             }
@@ -405,8 +716,62 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
         header->entry = NULL;
     }
 
+    const char *dir = getenv("HL_MEMOIZATION_CACHE_DIR");
+    if (dir != NULL &&
+        cache_load_from_file(user_context, dir, cache_key, size,
+                             computed_bounds, tuple_count, tuple_buffers)) {
+        // Promote the loaded data to an in-memory entry so later
+        // lookups hit without touching the disk.
+        uint64_t added_size = 0;
+        for (int32_t i = 0; i < tuple_count; i++) {
+            added_size += tuple_buffers[i]->size_in_bytes();
+        }
+        shard->current_size += added_size;
+        shard->prune();
+
+        CacheEntry *new_entry = (CacheEntry *)halide_malloc(NULL, sizeof(CacheEntry));
+        bool inited = false;
+        if (new_entry) {
+            inited = new_entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers);
+        }
+        if (!inited) {
+            // Hand the loaded buffers to the caller uncached. The
+            // block headers have no entry, so
+            // halide_memoization_cache_release will free them.
+            shard->current_size -= added_size;
+            if (new_entry) {
+                halide_free(user_context, new_entry);
+            }
+            return 0;
+        }
+
+        new_entry->next = shard->entries[index];
+        new_entry->less_recent = shard->most_recently_used;
+        if (shard->most_recently_used != NULL) {
+            shard->most_recently_used->more_recent = new_entry;
+        }
+        shard->most_recently_used = new_entry;
+        if (shard->least_recently_used == NULL) {
+            shard->least_recently_used = new_entry;
+        }
+        shard->entries[index] = new_entry;
+
+        new_entry->in_use_count = tuple_count;
+        new_entry->touch(shard->clock);
+
+        for (int32_t i = 0; i < tuple_count; i++) {
+            get_pointer_to_header(tuple_buffers[i]->host)->entry = new_entry;
+        }
+
 #if CACHE_DEBUGGING
-    validate_cache();
+        validate_cache_shard(shard);
+#endif
+
+        return 0;
+    }
+
+#if CACHE_DEBUGGING
+    validate_cache_shard(shard);
 #endif
 
     return 1;
@@ -420,8 +785,9 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
     uint32_t h = get_pointer_to_header(tuple_buffers[0]->host)->hash;
 
     uint32_t index = h % kHashTableSize;
+    CacheShard *shard = shard_for_hash(h);
 
-    ScopedMutexLock lock(&memoization_lock);
+    ScopedMutexLock lock(&shard->lock);
 
 #if CACHE_DEBUGGING
     debug_print_key(user_context, "halide_memoization_cache_store", cache_key, size);
@@ -436,7 +802,7 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
     }
 #endif
 
-    CacheEntry *entry = cache_entries[index];
+    CacheEntry *entry = shard->entries[index];
     while (entry != NULL) {
         if (entry->hash == h && entry->key_size == (size_t)size &&
             keys_equal(entry->key, cache_key, size) &&
@@ -475,8 +841,8 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
             added_size += buf->size_in_bytes();
         }
     }
-    current_cache_size += added_size;
-    prune_cache();
+    shard->current_size += added_size;
+    shard->prune();
 
     CacheEntry *new_entry = (CacheEntry *)halide_malloc(NULL, sizeof(CacheEntry));
     bool inited = false;
@@ -484,7 +850,7 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
         inited = new_entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers);
     }
     if (!inited) {
-        current_cache_size -= added_size;
+        shard->current_size -= added_size;
 
         // This entry is still in use by the caller. Mark it as having no cache entry
         // so halide_memoization_cache_release can free the buffer.
@@ -498,25 +864,32 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
         return 0;
     }
 
-    new_entry->next = cache_entries[index];
-    new_entry->less_recent = most_recently_used;
-    if (most_recently_used != NULL) {
-        most_recently_used->more_recent = new_entry;
+    new_entry->next = shard->entries[index];
+    new_entry->less_recent = shard->most_recently_used;
+    if (shard->most_recently_used != NULL) {
+        shard->most_recently_used->more_recent = new_entry;
     }
-    most_recently_used = new_entry;
-    if (least_recently_used == NULL) {
-        least_recently_used = new_entry;
+    shard->most_recently_used = new_entry;
+    if (shard->least_recently_used == NULL) {
+        shard->least_recently_used = new_entry;
     }
-    cache_entries[index] = new_entry;
+    shard->entries[index] = new_entry;
 
     new_entry->in_use_count = tuple_count;
+    new_entry->touch(shard->clock);
 
     for (int32_t i = 0; i < tuple_count; i++) {
         get_pointer_to_header(tuple_buffers[i]->host)->entry = new_entry;
     }
 
+    const char *dir = getenv("HL_MEMOIZATION_CACHE_DIR");
+    if (dir != NULL) {
+        cache_store_to_file(user_context, dir, cache_key, size,
+                            computed_bounds, tuple_count, tuple_buffers);
+    }
+
 #if CACHE_DEBUGGING
-    validate_cache();
+    validate_cache_shard(shard);
 #endif
     debug(user_context) << "Exiting halide_memoization_cache_store\n";
 
@@ -531,12 +904,13 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
     if (entry == NULL) {
         halide_free(user_context, header);
     } else {
-        ScopedMutexLock lock(&memoization_lock);
+        CacheShard *shard = shard_for_hash(entry->hash);
+        ScopedMutexLock lock(&shard->lock);
 
         halide_assert(user_context, entry->in_use_count > 0);
         entry->in_use_count--;
 #if CACHE_DEBUGGING
-        validate_cache();
+        validate_cache_shard(shard);
 #endif
     }
 
@@ -545,20 +919,24 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
 
 WEAK void halide_memoization_cache_cleanup() {
     debug(NULL) << "halide_memoization_cache_cleanup\n";
-    for (size_t i = 0; i < kHashTableSize; i++) {
-        CacheEntry *entry = cache_entries[i];
-        cache_entries[i] = NULL;
-        while (entry != NULL) {
-            CacheEntry *next = entry->next;
-            entry->destroy();
-            halide_free(NULL, entry);
-            entry = next;
+    for (size_t s = 0; s < kNumShards; s++) {
+        CacheShard *shard = &cache_shards[s];
+        for (size_t i = 0; i < kHashTableSize; i++) {
+            CacheEntry *entry = shard->entries[i];
+            shard->entries[i] = NULL;
+            while (entry != NULL) {
+                CacheEntry *next = entry->next;
+                entry->destroy();
+                halide_free(NULL, entry);
+                entry = next;
+            }
         }
+        shard->current_size = 0;
+        shard->clock = 0;
+        shard->most_recently_used = NULL;
+        shard->least_recently_used = NULL;
+        halide_mutex_destroy(&shard->lock);
     }
-    current_cache_size = 0;
-    most_recently_used = NULL;
-    least_recently_used = NULL;
-    halide_mutex_destroy(&memoization_lock);
 }
 
 namespace {
@@ -11,6 +11,7 @@ namespace Halide { namespace Runtime { namespace Internal { namespace Cuda {
 // Define the function pointers for the CUDA API.
 #define CUDA_FN(ret, fn, args) WEAK ret (CUDAAPI *fn)args;
 #define CUDA_FN_OPTIONAL(ret, fn, args) WEAK ret (CUDAAPI *fn)args;
+#define CUDA_FN_OPTIONAL_3020(ret, fn, fn_3020, args) WEAK ret (CUDAAPI *fn)args;
 #define CUDA_FN_3020(ret, fn, fn_3020, args) WEAK ret (CUDAAPI *fn)args;
 #define CUDA_FN_4000(ret, fn, fn_4000, args) WEAK ret (CUDAAPI *fn)args;
 #include "cuda_functions.h"
@@ -64,6 +65,7 @@ WEAK void load_libcuda(void *user_context) {
 
     #define CUDA_FN(ret, fn, args) fn = get_cuda_symbol<ret (CUDAAPI *)args>(user_context, #fn);
     #define CUDA_FN_OPTIONAL(ret, fn, args) fn = get_cuda_symbol<ret (CUDAAPI *)args>(user_context, #fn, true);
+    #define CUDA_FN_OPTIONAL_3020(ret, fn, fn_3020, args) fn = get_cuda_symbol<ret (CUDAAPI *)args>(user_context, #fn_3020, true);
     #define CUDA_FN_3020(ret, fn, fn_3020, args) fn = get_cuda_symbol<ret (CUDAAPI *)args>(user_context, #fn_3020);
     #define CUDA_FN_4000(ret, fn, fn_4000, args) fn = get_cuda_symbol<ret (CUDAAPI *)args>(user_context, #fn_4000);
     #include "cuda_functions.h"
@@ -78,6 +80,62 @@ WEAK CUresult create_cuda_context(void *user_context, CUcontext *ctx);
 CUcontext WEAK context = 0;
 volatile int WEAK thread_lock = 0;
 
+// The stream all copies and kernel launches are issued on when the
+// user has supplied one via halide_cuda_set_stream. Zero means the
+// default stream.
+CUstream WEAK custom_stream = 0;
+
+// A second, non-blocking stream used by halide_cuda_readback_slice so
+// device -> host copies of completed slabs can overlap kernels still
+// running on the main stream. Created lazily; belongs to the global
+// context above and is destroyed with it.
+CUstream WEAK readback_stream = NULL;
+
+// A cache of device allocations. cuMemAlloc/cuMemFree serialize on a
+// driver lock and cost on the order of 100us each, so in steady
+// state we hand freed allocations back to the next realization of
+// the same (rounded) size instead of returning them to the
+// driver. The cache belongs to the global context above; it is
+// flushed before that context is released.
+struct device_allocation_cache_entry {
+    CUdeviceptr ptr;
+    size_t size;
+    device_allocation_cache_entry *next;
+};
+WEAK device_allocation_cache_entry *device_allocation_cache = NULL;
+volatile int WEAK allocation_cache_lock = 0;
+
+// Round allocation sizes up to a power of two, so realizations whose
+// sizes wobble slightly from frame to frame still hit the cache.
+WEAK size_t round_up_allocation_size(size_t size) {
+    size_t rounded = 256;
+    while (rounded < size) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+// Return every cached allocation to the driver. Must be called with
+// the context current.
+WEAK CUresult flush_device_allocation_cache(void *user_context) {
+    CUresult err = CUDA_SUCCESS;
+    while (__sync_lock_test_and_set(&allocation_cache_lock, 1)) { }
+    device_allocation_cache_entry *e = device_allocation_cache;
+    device_allocation_cache = NULL;
+    __sync_lock_release(&allocation_cache_lock);
+    while (e) {
+        device_allocation_cache_entry *next = e->next;
+        debug(user_context) << "    cuMemFree (cached) " << (void *)(e->ptr) << "\n";
+        CUresult free_err = cuMemFree(e->ptr);
+        if (free_err != CUDA_SUCCESS) {
+            err = free_err;
+        }
+        free(e);
+        e = next;
+    }
+    return err;
+}
+
 }}}} // namespace Halide::Runtime::Internal::Cuda
 
 using namespace Halide::Runtime::Internal;
@@ -127,7 +185,18 @@ WEAK int halide_cuda_release_context(void *user_context) {
 // any sort of scoping must be handled by that of the
 // halide_cuda_acquire_context/halide_cuda_release_context pair, not this call.
 WEAK int halide_cuda_get_stream(void *user_context, CUcontext ctx, CUstream *stream) {
-    *stream = 0;
+    *stream = custom_stream;
+    return 0;
+}
+
+// Set the stream Halide issues its copies and kernel launches
+// on. The stream must belong to the context Halide is using (see
+// halide_cuda_acquire_context), and must outlive any use of it by
+// Halide. Pass NULL to return to the default stream. An alternative
+// to overriding halide_cuda_get_stream when a linker-level override
+// isn't convenient.
+WEAK int halide_cuda_set_stream(void *user_context, void *stream) {
+    custom_stream = (CUstream)stream;
     return 0;
 }
 
@@ -171,16 +240,72 @@ public:
     }
 };
 
+// A cached result of cuModuleGetFunction. Looking an entry point up
+// by name is a round-trip into the driver, so we only do it once per
+// entry point per module and keep the handles here.
+struct kernel_cache_entry {
+    CUfunction f;
+    kernel_cache_entry *next;
+    char name[1]; // The entry name, allocated inline.
+};
+
+// A per-launch-site cache of everything halide_cuda_run needs to
+// issue a kernel. The generated code hands each launch site a private
+// global slot in which we keep the resolved function handle and
+// pre-sized argument storage, so a steady-state launch does no name
+// lookups and no allocation - just a single driver call.
+struct launch_site_state {
+    CUmodule module; // The module the handle was resolved against.
+    CUfunction f;
+    int num_args;
+    // num_args+1 translated arg pointers followed by num_args device
+    // handles, allocated inline.
+    void *args_storage[1];
+};
+
 // Structure to hold the state of a module attached to the context.
 // Also used as a linked-list to keep track of all the different
 // modules that are attached to a context in order to release them all
 // when then context is released.
 struct module_state {
     CUmodule module;
+    kernel_cache_entry *kernels;
     module_state *next;
 };
 WEAK module_state *state_list = NULL;
 
+// Get the function handle for an entry point, from the module's
+// cache if we've launched it before.
+WEAK CUresult get_kernel(void *user_context, module_state *state,
+                         const char *entry_name, CUfunction *f) {
+    for (kernel_cache_entry *e = state->kernels; e != NULL; e = e->next) {
+        const char *a = e->name;
+        const char *b = entry_name;
+        while (*a != 0 && *a == *b) {
+            a++;
+            b++;
+        }
+        if (*a == *b) {
+            *f = e->f;
+            return CUDA_SUCCESS;
+        }
+    }
+    CUresult err = cuModuleGetFunction(f, state->module, entry_name);
+    if (err != CUDA_SUCCESS) {
+        return err;
+    }
+    size_t len = strlen(entry_name);
+    kernel_cache_entry *e = (kernel_cache_entry *)malloc(sizeof(kernel_cache_entry) + len);
+    // If the allocation fails we just don't cache.
+    if (e != NULL) {
+        e->f = *f;
+        memcpy(e->name, entry_name, len + 1);
+        e->next = state->kernels;
+        state->kernels = e;
+    }
+    return CUDA_SUCCESS;
+}
+
 WEAK CUresult create_cuda_context(void *user_context, CUcontext *ctx) {
     // Initialize CUDA
     CUresult err = cuInit(0);
@@ -403,6 +528,7 @@ WEAK int halide_cuda_initialize_kernels(void *user_context, void **state_ptr, co
     if (!(*state)) {
         *state = (module_state*)malloc(sizeof(module_state));
         (*state)->module = NULL;
+        (*state)->kernels = NULL;
         (*state)->next = state_list;
         state_list = *state;
     }
@@ -442,6 +568,53 @@ WEAK int halide_cuda_initialize_kernels(void *user_context, void **state_ptr, co
     return 0;
 }
 
+WEAK int halide_cuda_max_potential_block_size(void *user_context, void *state_ptr,
+                                              const char *entry_name,
+                                              int *block_size,
+                                              int block_size_limit,
+                                              size_t dynamic_shared_mem_bytes) {
+    debug(user_context) << "CUDA: halide_cuda_max_potential_block_size (user_context: " << user_context
+                        << ", entry_name: " << entry_name << ")\n";
+
+    Context ctx(user_context);
+    if (ctx.error != 0) {
+        return ctx.error;
+    }
+
+    if (cuOccupancyMaxPotentialBlockSize == NULL) {
+        error(user_context) << "CUDA: cuOccupancyMaxPotentialBlockSize not found. "
+                            << "The occupancy API requires CUDA 6.5 or later.\n";
+        return CUDA_ERROR_NOT_FOUND;
+    }
+
+    halide_assert(user_context, state_ptr);
+    module_state *state = (module_state*)state_ptr;
+    halide_assert(user_context, state->module);
+
+    CUfunction f;
+    CUresult err = get_kernel(user_context, state, entry_name, &f);
+    if (err != CUDA_SUCCESS) {
+        error(user_context) << "CUDA: cuModuleGetFunction failed: "
+                            << get_error_name(err);
+        return err;
+    }
+
+    int min_grid_size = 0;
+    err = cuOccupancyMaxPotentialBlockSize(&min_grid_size, block_size, f,
+                                           NULL, dynamic_shared_mem_bytes,
+                                           block_size_limit);
+    if (err != CUDA_SUCCESS) {
+        error(user_context) << "CUDA: cuOccupancyMaxPotentialBlockSize failed: "
+                            << get_error_name(err);
+        return err;
+    }
+
+    debug(user_context) << "    max potential block size for " << entry_name
+                        << ": " << *block_size << "\n";
+
+    return 0;
+}
+
 WEAK int halide_cuda_device_free(void *user_context, halide_buffer_t* buf) {
     // halide_device_free, at present, can be exposed to clients and they
     // should be allowed to call halide_device_free on any halide_buffer_t
@@ -466,8 +639,26 @@ WEAK int halide_cuda_device_free(void *user_context, halide_buffer_t* buf) {
 
     halide_assert(user_context, validate_device_pointer(user_context, buf));
 
-    debug(user_context) <<  "    cuMemFree " << (void *)(dev_ptr) << "\n";
-    CUresult err = cuMemFree(dev_ptr);
+    // Stash the allocation in the cache for the next realization of
+    // this size rather than paying for a cuMemFree. If we can't make
+    // a list node, fall through to freeing it for real.
+    size_t rounded_size = round_up_allocation_size(buf->size_in_bytes());
+    device_allocation_cache_entry *e =
+        (device_allocation_cache_entry *)malloc(sizeof(device_allocation_cache_entry));
+    CUresult err = CUDA_SUCCESS;
+    if (e != NULL) {
+        debug(user_context) << "    caching allocation " << (void *)(dev_ptr)
+                            << " of size " << (uint64_t)rounded_size << "\n";
+        e->ptr = dev_ptr;
+        e->size = rounded_size;
+        while (__sync_lock_test_and_set(&allocation_cache_lock, 1)) { }
+        e->next = device_allocation_cache;
+        device_allocation_cache = e;
+        __sync_lock_release(&allocation_cache_lock);
+    } else {
+        debug(user_context) <<  "    cuMemFree " << (void *)(dev_ptr) << "\n";
+        err = cuMemFree(dev_ptr);
+    }
     // If cuMemFree fails, it isn't likely to succeed later, so just drop
     // the reference.
     buf->device_interface->impl->release_module();
@@ -507,6 +698,18 @@ WEAK int halide_cuda_device_release(void *user_context) {
         }
         halide_assert(user_context, err == CUDA_SUCCESS || err == CUDA_ERROR_DEINITIALIZED);
 
+        // Give any cached device allocations back to the driver
+        // before the context they belong to goes away.
+        flush_device_allocation_cache(user_context);
+
+        // The readback stream belongs to this context too.
+        if (readback_stream != NULL) {
+            if (cuStreamDestroy != NULL) {
+                cuStreamDestroy(readback_stream);
+            }
+            readback_stream = NULL;
+        }
+
         // Unload the modules attached to this context. Note that the list
         // nodes themselves are not freed, only the module objects are
         // released. Subsequent calls to halide_init_kernels might re-create
@@ -519,6 +722,14 @@ WEAK int halide_cuda_device_release(void *user_context) {
                 err = cuModuleUnload(state->module);
                 halide_assert(user_context, err == CUDA_SUCCESS || err == CUDA_ERROR_DEINITIALIZED);
                 state->module = 0;
+                // The cached function handles died with the module.
+                kernel_cache_entry *e = state->kernels;
+                while (e) {
+                    kernel_cache_entry *next_entry = e->next;
+                    free(e);
+                    e = next_entry;
+                }
+                state->kernels = NULL;
             }
             state = state->next;
         }
@@ -570,16 +781,42 @@ WEAK int halide_cuda_device_malloc(void *user_context, halide_buffer_t *buf) {
     uint64_t t_before = halide_current_time_ns(user_context);
     #endif
 
-    CUdeviceptr p;
-    debug(user_context) << "    cuMemAlloc " << (uint64_t)size << " -> ";
-    CUresult err = cuMemAlloc(&p, size);
-    if (err != CUDA_SUCCESS) {
-        debug(user_context) << get_error_name(err) << "\n";
-        error(user_context) << "CUDA: cuMemAlloc failed: "
-                            << get_error_name(err);
-        return err;
+    size_t rounded_size = round_up_allocation_size(size);
+
+    // Check the allocation cache first.
+    CUdeviceptr p = 0;
+    while (__sync_lock_test_and_set(&allocation_cache_lock, 1)) { }
+    for (device_allocation_cache_entry **prev = &device_allocation_cache;
+         *prev != NULL; prev = &(*prev)->next) {
+        if ((*prev)->size == rounded_size) {
+            device_allocation_cache_entry *e = *prev;
+            *prev = e->next;
+            p = e->ptr;
+            free(e);
+            break;
+        }
+    }
+    __sync_lock_release(&allocation_cache_lock);
+
+    if (p) {
+        debug(user_context) << "    reused cached allocation of "
+                            << (uint64_t)rounded_size << " -> " << (void *)p << "\n";
     } else {
-        debug(user_context) << (void *)p << "\n";
+        debug(user_context) << "    cuMemAlloc " << (uint64_t)rounded_size << " -> ";
+        CUresult err = cuMemAlloc(&p, rounded_size);
+        if (err == CUDA_ERROR_OUT_OF_MEMORY) {
+            // Give the cached allocations back to the driver and retry.
+            flush_device_allocation_cache(user_context);
+            err = cuMemAlloc(&p, rounded_size);
+        }
+        if (err != CUDA_SUCCESS) {
+            debug(user_context) << get_error_name(err) << "\n";
+            error(user_context) << "CUDA: cuMemAlloc failed: "
+                                << get_error_name(err);
+            return err;
+        } else {
+            debug(user_context) << (void *)p << "\n";
+        }
     }
     halide_assert(user_context, p);
     buf->device = p;
@@ -596,7 +833,8 @@ WEAK int halide_cuda_device_malloc(void *user_context, halide_buffer_t *buf) {
 
 namespace {
 WEAK int do_multidimensional_copy(void *user_context, const device_copy &c,
-                                  uint64_t src, uint64_t dst, int d, bool from_host, bool to_host) {
+                                  uint64_t src, uint64_t dst, int d, bool from_host, bool to_host,
+                                  CUstream stream) {
     if (d > MAX_COPY_DIMS) {
         error(user_context) << "Buffer has too many dimensions to copy to/from GPU\n";
         return -1;
@@ -606,12 +844,29 @@ WEAK int do_multidimensional_copy(void *user_context, const device_copy &c,
         debug(user_context) << "    from " << (from_host ? "host" : "device")
                             << " to " << (to_host ? "host" : "device") << ", "
                             << (void *)src << " -> " << (void *)dst << ", " << c.chunk_size << " bytes\n";
+        // Issue the copies asynchronously on the stream where the
+        // driver supports it, so they order with the kernel launches
+        // on that stream instead of blocking the whole device. The
+        // caller synchronizes the stream afterwards where the host
+        // needs to see the result.
         if (!from_host && to_host) {
-            err = cuMemcpyDtoH((void *)dst, (CUdeviceptr)src, c.chunk_size);
+            if (cuMemcpyDtoHAsync != NULL) {
+                err = cuMemcpyDtoHAsync((void *)dst, (CUdeviceptr)src, c.chunk_size, stream);
+            } else {
+                err = cuMemcpyDtoH((void *)dst, (CUdeviceptr)src, c.chunk_size);
+            }
         } else if (from_host && !to_host) {
-            err = cuMemcpyHtoD((CUdeviceptr)dst, (void *)src, c.chunk_size);
+            if (cuMemcpyHtoDAsync != NULL) {
+                err = cuMemcpyHtoDAsync((CUdeviceptr)dst, (void *)src, c.chunk_size, stream);
+            } else {
+                err = cuMemcpyHtoD((CUdeviceptr)dst, (void *)src, c.chunk_size);
+            }
         } else if (!from_host && !to_host) {
-            err = cuMemcpyDtoD((CUdeviceptr)dst, (CUdeviceptr)src, c.chunk_size);
+            if (cuMemcpyDtoDAsync != NULL) {
+                err = cuMemcpyDtoDAsync((CUdeviceptr)dst, (CUdeviceptr)src, c.chunk_size, stream);
+            } else {
+                err = cuMemcpyDtoD((CUdeviceptr)dst, (CUdeviceptr)src, c.chunk_size);
+            }
         } else if (dst != src) {
             // Could reach here if a user called directly into the
             // cuda API for a device->host copy on a source buffer
@@ -625,7 +880,7 @@ WEAK int do_multidimensional_copy(void *user_context, const device_copy &c,
     } else {
         ssize_t src_off = 0, dst_off = 0;
         for (int i = 0; i < (int)c.extent[d-1]; i++) {
-            int err = do_multidimensional_copy(user_context, c, src + src_off, dst + dst_off, d - 1, from_host, to_host);
+            int err = do_multidimensional_copy(user_context, c, src + src_off, dst + dst_off, d - 1, from_host, to_host, stream);
             dst_off += c.dst_stride_bytes[d-1];
             src_off += c.src_stride_bytes[d-1];
             if (err) {
@@ -684,7 +939,28 @@ WEAK int halide_cuda_buffer_copy(void *user_context, struct halide_buffer_t *src
         }
         #endif
 
-        err = do_multidimensional_copy(user_context, c, c.src + c.src_begin, c.dst, dst->dimensions, from_host, to_host);
+        CUstream stream = NULL;
+        if (cuStreamSynchronize != NULL) {
+            int result = halide_cuda_get_stream(user_context, ctx.context, &stream);
+            if (result != 0) {
+                error(user_context) << "CUDA: In halide_cuda_buffer_copy, halide_cuda_get_stream returned " << result << "\n";
+            }
+        }
+
+        err = do_multidimensional_copy(user_context, c, c.src + c.src_begin, c.dst, dst->dimensions, from_host, to_host, stream);
+
+        // Copies to the device stay asynchronous: they're ordered
+        // with respect to the kernels on the stream, and the host
+        // buffer they read from outlives the pipeline. Copies to the
+        // host must complete before we return.
+        if (!err && to_host && cuMemcpyDtoHAsync != NULL && cuStreamSynchronize != NULL) {
+            CUresult sync_err = cuStreamSynchronize(stream);
+            if (sync_err != CUDA_SUCCESS) {
+                error(user_context) << "CUDA: cuStreamSynchronize failed: "
+                                    << get_error_name(sync_err);
+                err = (int)sync_err;
+            }
+        }
 
         #ifdef DEBUG_RUNTIME
         uint64_t t_after = halide_current_time_ns(user_context);
@@ -695,6 +971,65 @@ WEAK int halide_cuda_buffer_copy(void *user_context, struct halide_buffer_t *src
     return err;
 }
 
+WEAK int halide_cuda_device_to_device_copy(void *user_context, struct halide_buffer_t *src,
+                                           struct halide_buffer_t *dst) {
+    if (src->device_interface != &cuda_device_interface ||
+        dst->device_interface != &cuda_device_interface) {
+        // We can only move data between cuda allocations directly.
+        return halide_error_code_incompatible_device_interface;
+    }
+    halide_assert(user_context, src->device && dst->device);
+
+    device_copy c = make_buffer_copy(src, false, dst, false);
+
+    Context ctx(user_context);
+    if (ctx.error != CUDA_SUCCESS) {
+        return ctx.error;
+    }
+
+    debug(user_context)
+        << "CUDA: halide_cuda_device_to_device_copy (user_context: " << user_context
+        << ", src: " << src << ", dst: " << dst << ")\n";
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    halide_assert(user_context, validate_device_pointer(user_context, src));
+    halide_assert(user_context, validate_device_pointer(user_context, dst));
+    #endif
+
+    CUstream stream = NULL;
+    if (cuStreamSynchronize != NULL) {
+        int result = halide_cuda_get_stream(user_context, ctx.context, &stream);
+        if (result != 0) {
+            error(user_context) << "CUDA: In halide_cuda_device_to_device_copy, halide_cuda_get_stream returned " << result << "\n";
+        }
+    }
+
+    // With unified addressing the driver services copies whose
+    // endpoints sit on different devices as peer-to-peer DMA
+    // transfers (the cuMemcpyPeer path), so this stays off the
+    // through-host route in the multi-GPU case too.
+    int err = do_multidimensional_copy(user_context, c, c.src + c.src_begin, c.dst,
+                                       dst->dimensions, false, false, stream);
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return err;
+}
+
+WEAK int halide_cuda_device_initialize(void *user_context) {
+    debug(user_context)
+        << "CUDA: halide_cuda_device_initialize (user_context: " << user_context << ")\n";
+
+    // Acquiring the context creates it (and loads libcuda) if this
+    // is the first use.
+    Context ctx(user_context);
+    return ctx.error;
+}
+
 WEAK int halide_cuda_device_crop(void *user_context, const struct halide_buffer_t *src,
                                  struct halide_buffer_t *dst) {
     // Pointer arithmetic works fine.
@@ -721,6 +1056,121 @@ WEAK int halide_cuda_copy_to_host(void *user_context, halide_buffer_t* buf) {
     return halide_cuda_buffer_copy(user_context, buf, NULL, buf);
 }
 
+WEAK int halide_cuda_readback_slice(void *user_context, struct halide_buffer_t *buf,
+                                    int slice_min, int slice_extent) {
+    // Overlapping the copy with the kernels still queued on the main
+    // stream needs stream and event support from the driver.
+    if (cuStreamCreate == NULL || cuStreamDestroy == NULL ||
+        cuStreamWaitEvent == NULL || cuStreamSynchronize == NULL ||
+        cuEventCreate == NULL || cuEventRecord == NULL ||
+        cuEventDestroy == NULL || cuMemcpyDtoHAsync == NULL) {
+        // Let the caller take the blocking fallback path.
+        return halide_error_code_incompatible_device_interface;
+    }
+
+    Context ctx(user_context);
+    if (ctx.error != CUDA_SUCCESS) {
+        return ctx.error;
+    }
+
+    debug(user_context)
+        << "CUDA: halide_cuda_readback_slice (user_context: " << user_context
+        << ", buf: " << buf << ", slice_min: " << slice_min
+        << ", slice_extent: " << slice_extent << ")\n";
+
+    if (readback_stream == NULL) {
+        CUresult err = cuStreamCreate(&readback_stream, CU_STREAM_NON_BLOCKING);
+        if (err != CUDA_SUCCESS) {
+            error(user_context) << "CUDA: cuStreamCreate failed: "
+                                << get_error_name(err);
+            return (int)err;
+        }
+    }
+
+    // A host-side view of the slice to copy into. The source is the
+    // whole buffer; make_buffer_copy offsets the device pointer by
+    // the difference in mins.
+    const int d = buf->dimensions - 1;
+    halide_dimension_t view_dim[MAX_COPY_DIMS];
+    for (int i = 0; i < buf->dimensions; i++) {
+        view_dim[i] = buf->dim[i];
+    }
+    view_dim[d].min = slice_min;
+    view_dim[d].extent = slice_extent;
+    halide_buffer_t dst_view = *buf;
+    dst_view.dim = view_dim;
+    dst_view.host = buf->host +
+                    (intptr_t)(slice_min - buf->dim[d].min) *
+                    buf->dim[d].stride * buf->type.bytes();
+
+    device_copy c = make_buffer_copy(buf, false, &dst_view, true);
+
+    // Order the copy after everything issued on the main stream so
+    // far, then issue it on the readback stream and return without
+    // waiting; halide_cuda_readback_fence waits for the lot.
+    CUstream main_stream = NULL;
+    int result = halide_cuda_get_stream(user_context, ctx.context, &main_stream);
+    if (result != 0) {
+        error(user_context) << "CUDA: In halide_cuda_readback_slice, halide_cuda_get_stream returned " << result << "\n";
+    }
+
+    CUevent ev;
+    CUresult err = cuEventCreate(&ev, CU_EVENT_DISABLE_TIMING);
+    if (err == CUDA_SUCCESS) {
+        err = cuEventRecord(ev, main_stream);
+    }
+    if (err == CUDA_SUCCESS) {
+        err = cuStreamWaitEvent(readback_stream, ev, 0);
+    }
+    if (err != CUDA_SUCCESS) {
+        error(user_context) << "CUDA: In halide_cuda_readback_slice, recording the readback event failed: "
+                            << get_error_name(err);
+        return (int)err;
+    }
+
+    int copy_err = do_multidimensional_copy(user_context, c, c.src + c.src_begin, c.dst,
+                                            buf->dimensions, false, true, readback_stream);
+
+    // The driver defers the actual destruction until the waiting
+    // stream has consumed the event.
+    cuEventDestroy(ev);
+
+    return copy_err;
+}
+
+WEAK int halide_cuda_readback_fence(void *user_context, struct halide_buffer_t *buf) {
+    if (readback_stream == NULL) {
+        return 0;
+    }
+
+    Context ctx(user_context);
+    if (ctx.error != CUDA_SUCCESS) {
+        return ctx.error;
+    }
+
+    debug(user_context)
+        << "CUDA: halide_cuda_readback_fence (user_context: " << user_context
+        << ", buf: " << buf << ")\n";
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_before = halide_current_time_ns(user_context);
+    #endif
+
+    CUresult err = cuStreamSynchronize(readback_stream);
+    if (err != CUDA_SUCCESS) {
+        error(user_context) << "CUDA: cuStreamSynchronize failed: "
+                            << get_error_name(err);
+        return (int)err;
+    }
+
+    #ifdef DEBUG_RUNTIME
+    uint64_t t_after = halide_current_time_ns(user_context);
+    debug(user_context) << "    Time: " << (t_after - t_before) / 1.0e6 << " ms\n";
+    #endif
+
+    return 0;
+}
+
 // Used to generate correct timings when tracing
 WEAK int halide_cuda_device_sync(void *user_context, struct halide_buffer_t *) {
     debug(user_context)
@@ -772,7 +1222,8 @@ WEAK int halide_cuda_run(void *user_context,
                          int num_attributes,
                          float* vertex_buffer,
                          int num_coords_dim0,
-                         int num_coords_dim1) {
+                         int num_coords_dim1,
+                         void **run_state) {
 
     debug(user_context) << "CUDA: halide_cuda_run ("
                         << "user_context: " << user_context << ", "
@@ -794,31 +1245,70 @@ WEAK int halide_cuda_run(void *user_context,
     #endif
 
     halide_assert(user_context, state_ptr);
-    CUmodule mod = ((module_state*)state_ptr)->module;
-    debug(user_context) << "Got module " << mod << "\n";
-    halide_assert(user_context, mod);
-    CUfunction f;
-    err = cuModuleGetFunction(&f, mod, entry_name);
-    debug(user_context) << "Got function " << f << "\n";
-    if (err != CUDA_SUCCESS) {
-        error(user_context) << "CUDA: cuModuleGetFunction failed: "
-                            << get_error_name(err);
-        return err;
+    module_state *state = (module_state*)state_ptr;
+    debug(user_context) << "Got module " << state->module << "\n";
+    halide_assert(user_context, state->module);
+    // We run with the context held (see halide_cuda_acquire_context),
+    // so the launch-site descriptor needs no locking of its own. It
+    // stays valid until the module it was resolved against is
+    // unloaded, which we detect by comparing against the module in
+    // the state; the descriptor itself is then refilled in place.
+    launch_site_state *site = NULL;
+    if (run_state != NULL) {
+        site = (launch_site_state *)(*run_state);
     }
 
-    size_t num_args = 0;
-    while (arg_sizes[num_args] != 0) {
-        debug(user_context) << "    halide_cuda_run " << (int)num_args
-                            << " " << (int)arg_sizes[num_args]
-                            << " [" << (*((void **)args[num_args])) << " ...] "
-                            << arg_is_buffer[num_args] << "\n";
-        num_args++;
+    CUfunction f;
+    size_t num_args;
+    if (site != NULL && site->module == state->module) {
+        f = site->f;
+        num_args = site->num_args;
+    } else {
+        err = get_kernel(user_context, state, entry_name, &f);
+        if (err != CUDA_SUCCESS) {
+            error(user_context) << "CUDA: cuModuleGetFunction failed: "
+                                << get_error_name(err);
+            return err;
+        }
+
+        num_args = 0;
+        while (arg_sizes[num_args] != 0) {
+            debug(user_context) << "    halide_cuda_run " << (int)num_args
+                                << " " << (int)arg_sizes[num_args]
+                                << " [" << (*((void **)args[num_args])) << " ...] "
+                                << arg_is_buffer[num_args] << "\n";
+            num_args++;
+        }
+
+        if (run_state != NULL) {
+            if (site == NULL) {
+                site = (launch_site_state *)malloc(sizeof(launch_site_state) +
+                                                   num_args * sizeof(void *) +
+                                                   num_args * sizeof(uint64_t));
+                // If the allocation fails we just don't cache.
+                *run_state = site;
+            }
+            if (site != NULL) {
+                site->module = state->module;
+                site->f = f;
+                site->num_args = (int)num_args;
+            }
+        }
     }
+    debug(user_context) << "Got function " << f << "\n";
 
-    // We need storage for both the arg and the pointer to it if if
-    // has to be translated.
-    void** translated_args = (void **)malloc((num_args + 1) * sizeof(void *));
-    uint64_t *dev_handles = (uint64_t *)malloc(num_args * sizeof(uint64_t));
+    // We need storage for both the arg and the pointer to it if it
+    // has to be translated. Use the pre-sized storage in the
+    // launch-site descriptor if we have one; otherwise one allocation
+    // serves both to keep the per-launch overhead down.
+    void **translated_args;
+    if (site != NULL) {
+        translated_args = site->args_storage;
+    } else {
+        translated_args = (void **)malloc((num_args + 1) * sizeof(void *) +
+                                          num_args * sizeof(uint64_t));
+    }
+    uint64_t *dev_handles = (uint64_t *)(translated_args + num_args + 1);
     for (size_t i = 0; i <= num_args; i++) { // Get NULL at end.
         if (arg_is_buffer[i]) {
             halide_assert(user_context, arg_sizes[i] == sizeof(uint64_t));
@@ -848,8 +1338,9 @@ WEAK int halide_cuda_run(void *user_context,
                          stream,
                          translated_args,
                          NULL);
-    free(dev_handles);
-    free(translated_args);
+    if (site == NULL) {
+        free(translated_args);
+    }
     if (err != CUDA_SUCCESS) {
         error(user_context) << "CUDA: cuLaunchKernel failed: "
                             << get_error_name(err);
@@ -869,11 +1360,70 @@ WEAK int halide_cuda_run(void *user_context,
     return 0;
 }
 
+WEAK int halide_cuda_release_unused_device_allocations(void *user_context) {
+    debug(user_context)
+        << "CUDA: halide_cuda_release_unused_device_allocations (user_context: "
+        << user_context << ")\n";
+
+    Context ctx(user_context);
+    if (ctx.error != CUDA_SUCCESS) {
+        return ctx.error;
+    }
+    return (int)flush_device_allocation_cache(user_context);
+}
+
 WEAK int halide_cuda_device_and_host_malloc(void *user_context, struct halide_buffer_t *buf) {
+    // Make the host allocation page-locked, so copies between it and
+    // the device run at full PCIe bandwidth and can be asynchronous.
+    // Older drivers, and systems where pinning fails (it's a finite
+    // resource), fall back to an ordinary pageable allocation.
+    if (cuMemHostAlloc != NULL) {
+        Context ctx(user_context);
+        if (ctx.error != CUDA_SUCCESS) {
+            return ctx.error;
+        }
+
+        size_t size = buf->size_in_bytes();
+        void *p = NULL;
+        CUresult err = cuMemHostAlloc(&p, size, 0);
+        if (err == CUDA_SUCCESS) {
+            debug(user_context) << "CUDA: cuMemHostAlloc " << (uint64_t)size
+                                << " Success: " << p << "\n";
+            buf->host = (uint8_t *)p;
+            buf->set_flag(halide_buffer_flag_host_pinned, true);
+            int result = halide_cuda_device_malloc(user_context, buf);
+            if (result != 0) {
+                cuMemFreeHost(buf->host);
+                buf->host = NULL;
+                buf->set_flag(halide_buffer_flag_host_pinned, false);
+            }
+            return result;
+        }
+        debug(user_context) << "CUDA: cuMemHostAlloc failed ("
+                            << get_error_name(err)
+                            << "); falling back to pageable memory\n";
+    }
     return halide_default_device_and_host_malloc(user_context, buf, &cuda_device_interface);
 }
 
 WEAK int halide_cuda_device_and_host_free(void *user_context, struct halide_buffer_t *buf) {
+    if (buf->get_flag(halide_buffer_flag_host_pinned)) {
+        Context ctx(user_context);
+        if (ctx.error != CUDA_SUCCESS) {
+            return ctx.error;
+        }
+
+        int result = halide_cuda_device_free(user_context, buf);
+        if (buf->host) {
+            debug(user_context) << "CUDA: cuMemFreeHost " << (void *)buf->host << "\n";
+            cuMemFreeHost(buf->host);
+            buf->host = NULL;
+        }
+        buf->set_flag(halide_buffer_flag_host_pinned, false);
+        buf->set_host_dirty(false);
+        buf->set_device_dirty(false);
+        return result;
+    }
     return halide_default_device_and_host_free(user_context, buf, &cuda_device_interface);
 }
 
@@ -981,6 +1531,10 @@ WEAK halide_device_interface_impl_t cuda_device_interface_impl = {
     halide_cuda_device_release_crop,
     halide_cuda_wrap_device_ptr,
     halide_cuda_detach_device_ptr,
+    halide_cuda_device_to_device_copy,
+    halide_cuda_device_initialize,
+    halide_cuda_readback_slice,
+    halide_cuda_readback_fence,
 };
 
 WEAK halide_device_interface_t cuda_device_interface = {
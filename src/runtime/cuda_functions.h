@@ -9,6 +9,9 @@
 #ifndef CUDA_FN_OPTIONAL
 #define CUDA_FN_OPTIONAL(ret, fn, args)
 #endif
+#ifndef CUDA_FN_OPTIONAL_3020
+#define CUDA_FN_OPTIONAL_3020(ret, fn, fn_3020, args) CUDA_FN_OPTIONAL(ret, fn, args)
+#endif
 #ifndef CUDA_FN_3020
 #define CUDA_FN_3020(ret, fn, fn_3020, args) CUDA_FN(ret, fn, args)
 #endif
@@ -55,8 +58,21 @@ CUDA_FN_4000(CUresult, cuCtxPopCurrent, cuCtxPopCurrent_v2, (CUcontext *pctx));
 CUDA_FN(CUresult, cuPointerGetAttribute, (void *result, int query, CUdeviceptr ptr));
 
 CUDA_FN_OPTIONAL(CUresult, cuStreamSynchronize, (CUstream hStream));
+CUDA_FN_OPTIONAL(CUresult, cuOccupancyMaxPotentialBlockSize, (int *minGridSize, int *blockSize, CUfunction func, void *blockSizeToDynamicSMemSize, size_t dynamicSMemSize, int blockSizeLimit));
+CUDA_FN_OPTIONAL(CUresult, cuMemHostAlloc, (void **pp, size_t bytesize, unsigned int Flags));
+CUDA_FN_OPTIONAL(CUresult, cuMemFreeHost, (void *p));
+CUDA_FN_OPTIONAL_3020(CUresult, cuMemcpyHtoDAsync, cuMemcpyHtoDAsync_v2, (CUdeviceptr dstDevice, const void *srcHost, size_t ByteCount, CUstream hStream));
+CUDA_FN_OPTIONAL_3020(CUresult, cuMemcpyDtoHAsync, cuMemcpyDtoHAsync_v2, (void *dstHost, CUdeviceptr srcDevice, size_t ByteCount, CUstream hStream));
+CUDA_FN_OPTIONAL_3020(CUresult, cuMemcpyDtoDAsync, cuMemcpyDtoDAsync_v2, (CUdeviceptr dstDevice, CUdeviceptr srcDevice, size_t ByteCount, CUstream hStream));
+CUDA_FN_OPTIONAL(CUresult, cuStreamCreate, (CUstream *phStream, unsigned int Flags));
+CUDA_FN_OPTIONAL_3020(CUresult, cuStreamDestroy, cuStreamDestroy_v2, (CUstream hStream));
+CUDA_FN_OPTIONAL(CUresult, cuStreamWaitEvent, (CUstream hStream, CUevent hEvent, unsigned int Flags));
+CUDA_FN_OPTIONAL(CUresult, cuEventCreate, (CUevent *phEvent, unsigned int Flags));
+CUDA_FN_OPTIONAL(CUresult, cuEventRecord, (CUevent hEvent, CUstream hStream));
+CUDA_FN_OPTIONAL_3020(CUresult, cuEventDestroy, cuEventDestroy_v2, (CUevent hEvent));
 
 #undef CUDA_FN
 #undef CUDA_FN_OPTIONAL
+#undef CUDA_FN_OPTIONAL_3020
 #undef CUDA_FN_3020
 #undef CUDA_FN_4000
@@ -119,6 +119,94 @@ WEAK int halide_copy_to_host(void *user_context, struct halide_buffer_t *buf) {
     return copy_to_host_already_locked(user_context, buf);
 }
 
+/** Begin copying a contiguous range of the outermost dimension of buf
+ * from device memory to host memory, [slice_min, slice_min +
+ * slice_extent). Unlike halide_copy_to_host this ignores the dirty
+ * bits: lowering emits it immediately after producing those rows on
+ * the device, and clears device_dirty itself via
+ * halide_readback_fence once every slice has been issued. On backends
+ * with an asynchronous readback_slice implementation the copy is
+ * overlapped with subsequently issued device work; elsewhere it falls
+ * back to a blocking cropped copy. */
+WEAK int halide_readback_slice(void *user_context, struct halide_buffer_t *buf,
+                               int slice_min, int slice_extent) {
+    ScopedMutexLock lock(&device_copy_mutex);
+
+    int result = debug_log_and_validate_buf(user_context, buf, "halide_readback_slice");
+    if (result != 0) {
+        return result;
+    }
+    if (buf->device == 0 || buf->device_interface == NULL ||
+        buf->dimensions == 0 || slice_extent <= 0) {
+        return 0;
+    }
+
+    const halide_device_interface_t *interface = buf->device_interface;
+    interface->impl->use_module();
+    result = halide_error_code_incompatible_device_interface;
+    if (interface->impl->readback_slice != NULL) {
+        result = interface->impl->readback_slice(user_context, buf, slice_min, slice_extent);
+    }
+    if (result == halide_error_code_incompatible_device_interface) {
+        // Blocking fallback: a cropped copy through the backend's
+        // buffer_copy. The source view forces device_dirty so the
+        // backend takes the device -> host path regardless of the
+        // real buffer's flags; the destination view is a host-side
+        // window onto the slice.
+        const int d = buf->dimensions - 1;
+        halide_dimension_t view_dim[MAX_COPY_DIMS];
+        for (int i = 0; i < buf->dimensions; i++) {
+            view_dim[i] = buf->dim[i];
+        }
+        view_dim[d].min = slice_min;
+        view_dim[d].extent = slice_extent;
+
+        halide_buffer_t src_view = *buf;
+        src_view.set_device_dirty(true);
+
+        halide_buffer_t dst_view = *buf;
+        dst_view.dim = view_dim;
+        dst_view.host = buf->host +
+                        (intptr_t)(slice_min - buf->dim[d].min) *
+                        buf->dim[d].stride * buf->type.bytes();
+        dst_view.device = 0;
+        dst_view.device_interface = NULL;
+        dst_view.flags = 0;
+
+        result = interface->impl->buffer_copy(user_context, &src_view, NULL, &dst_view);
+    }
+    interface->impl->release_module();
+    return result;
+}
+
+/** Wait until every device to host copy issued via
+ * halide_readback_slice on this buffer has completed, then mark the
+ * host copy clean. The slices issued since the buffer was last
+ * written on the device must jointly cover it; lowering guarantees
+ * this for the calls it emits. */
+WEAK int halide_readback_fence(void *user_context, struct halide_buffer_t *buf) {
+    ScopedMutexLock lock(&device_copy_mutex);
+
+    int result = debug_log_and_validate_buf(user_context, buf, "halide_readback_fence");
+    if (result != 0) {
+        return result;
+    }
+    if (buf->device == 0 || buf->device_interface == NULL) {
+        return 0;
+    }
+
+    const halide_device_interface_t *interface = buf->device_interface;
+    interface->impl->use_module();
+    if (interface->impl->readback_fence != NULL) {
+        result = interface->impl->readback_fence(user_context, buf);
+    }
+    if (result == 0) {
+        buf->set_device_dirty(false);
+    }
+    interface->impl->release_module();
+    return result;
+}
+
 /** Copy image data from host memory to device memory. This should not be
  * called directly; Halide handles copying to the device automatically. */
 WEAK int copy_to_device_already_locked(void *user_context,
@@ -200,6 +288,36 @@ WEAK int halide_device_sync(void *user_context, struct halide_buffer_t *buf) {
     }
 }
 
+/** Eagerly create the device API state a backend would otherwise
+ * make lazily inside the first pipeline call, so that cost can be
+ * paid at process start instead of on the first frame. */
+WEAK int halide_device_initialize(void *user_context,
+                                  const halide_device_interface_t *device_interface) {
+    debug(user_context) << "halide_device_initialize: target device interface "
+                        << device_interface << "\n";
+
+    int result;
+    device_interface->impl->use_module();
+    if (device_interface->impl->device_initialize) {
+        result = device_interface->impl->device_initialize(user_context);
+    } else {
+        // Round-trip a minimal allocation through the backend, which
+        // forces it to create its context on the way.
+        halide_dimension_t shape(0, 1, 1);
+        halide_buffer_t buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type = halide_type_t(halide_type_uint, 8);
+        buf.dimensions = 1;
+        buf.dim = &shape;
+        result = device_interface->impl->device_malloc(user_context, &buf);
+        if (result == 0) {
+            result = device_interface->impl->device_free(user_context, &buf);
+        }
+    }
+    device_interface->impl->release_module();
+    return result;
+}
+
 /** Allocate device memory to back a halide_buffer_t. */
 WEAK int halide_device_malloc(void *user_context, struct halide_buffer_t *buf,
                               const halide_device_interface_t *device_interface) {
@@ -526,7 +644,31 @@ WEAK int halide_buffer_copy(void *user_context, struct halide_buffer_t *src,
         src_device_interface->impl->use_module();
     }
 
-    if (dst_device_interface) {
+    // If both sides live on a device, give the two interfaces a
+    // chance to negotiate a direct device-to-device transfer before
+    // the general dispatch below, which may round-trip through host
+    // memory when the interfaces differ.
+    bool direct_copy_done = false;
+    if (dst_device_interface && src_device_interface &&
+        src->device && (src->device_dirty() || !src->host)) {
+        int d2d_err = halide_error_code_incompatible_device_interface;
+        if (dst_device_interface->impl->device_to_device_copy) {
+            d2d_err = dst_device_interface->impl->device_to_device_copy(user_context, src, dst);
+        }
+        if (d2d_err == halide_error_code_incompatible_device_interface &&
+            src_device_interface != dst_device_interface &&
+            src_device_interface->impl->device_to_device_copy) {
+            d2d_err = src_device_interface->impl->device_to_device_copy(user_context, src, dst);
+        }
+        if (d2d_err != halide_error_code_incompatible_device_interface) {
+            err = d2d_err;
+            direct_copy_done = true;
+        }
+    }
+
+    if (direct_copy_done) {
+        // Nothing further to do; the dirty bits are set below.
+    } else if (dst_device_interface) {
         // Make the dst interface handle arbitrary src device
         // interfaces (e.g. CUDA might know how to copy out of an
         // OpenGL texture). If the dst device interface doesn't
@@ -28,6 +28,37 @@ struct halide_device_interface_impl_t {
                                struct halide_buffer_t *buf);
     int (*wrap_native)(void *user_context, struct halide_buffer_t *buf, uint64_t handle);
     int (*detach_native)(void *user_context, struct halide_buffer_t *buf);
+    /** Copy directly between two device allocations, which need not
+     * belong to this interface (e.g. a backend may know how to DMA
+     * out of another API's memory). Optional: may be NULL. Must
+     * return halide_error_code_incompatible_device_interface, without
+     * copying anything, if it can't handle this particular pair of
+     * buffers; halide_buffer_copy then falls back to copying through
+     * host memory. */
+    int (*device_to_device_copy)(void *user_context, struct halide_buffer_t *src,
+                                 struct halide_buffer_t *dst);
+    /** Eagerly create the context, command queue, or other state the
+     * backend would otherwise make lazily inside the first pipeline
+     * call. Optional: may be NULL, in which case
+     * halide_device_initialize warms the backend up by
+     * round-tripping a minimal device allocation instead. */
+    int (*device_initialize)(void *user_context);
+    /** Begin reading back a contiguous range of the outermost
+     * dimension of buf, [slice_min, slice_min + slice_extent), from
+     * the device to the host, regardless of the buffer's dirty
+     * bits. The copy must be ordered after all device work issued so
+     * far, but the call should return without waiting for it where
+     * the backend can; the host must not touch the rows until
+     * readback_fence returns. Optional: may be NULL, or may return
+     * halide_error_code_incompatible_device_interface, in which case
+     * halide_readback_slice falls back to a blocking cropped copy
+     * through buffer_copy. */
+    int (*readback_slice)(void *user_context, struct halide_buffer_t *buf,
+                          int slice_min, int slice_extent);
+    /** Wait until every read-back issued via readback_slice has
+     * completed. Optional: may be NULL; only backends with an
+     * asynchronous readback_slice need it. */
+    int (*readback_fence)(void *user_context, struct halide_buffer_t *buf);
 };
 
 extern WEAK int halide_default_device_and_host_malloc(void *user_context, struct halide_buffer_t *buf,
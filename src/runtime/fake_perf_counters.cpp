@@ -0,0 +1,13 @@
+#include "HalideRuntime.h"
+
+extern "C" {
+
+WEAK int halide_profiler_read_hw_counters(uint64_t *cache_misses,
+                                          uint64_t *stalled_cycles) {
+    // Hardware counter sampling is only implemented on Linux (see
+    // linux_perf_counters.cpp). The profiler falls back to reporting
+    // times only.
+    return -1;
+}
+
+}
@@ -18,12 +18,26 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
     return 0;
 }
 
+WEAK int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
+                                          struct halide_parallel_task_t *tasks) {
+    for (int i = 0; i < num_tasks; i++) {
+        int result = halide_do_par_for(user_context, tasks[i].fn,
+                                       tasks[i].min, tasks[i].extent,
+                                       tasks[i].closure);
+        if (result) {
+            return result;
+        }
+    }
+    return 0;
+}
+
 }
 
 namespace Halide { namespace Runtime { namespace Internal {
 
 WEAK halide_do_task_t custom_do_task = halide_default_do_task;
 WEAK halide_do_par_for_t custom_do_par_for = halide_default_do_par_for;
+WEAK halide_do_parallel_tasks_t custom_do_parallel_tasks = halide_default_do_parallel_tasks;
 
 }}} // namespace Halide::Runtime::Internal
 
@@ -54,6 +68,34 @@ WEAK int halide_set_num_threads(int n) {
     return 1;
 }
 
+WEAK int halide_set_parallel_schedule(int schedule) {
+    // There's only one thread, so the schedule doesn't matter.
+    return halide_parallel_schedule_stealing;
+}
+
+WEAK int halide_set_parallel_inline_extent(int extent) {
+    // Every loop already runs inline on the calling thread.
+    return 1;
+}
+
+WEAK int halide_pin_thread_to_cpu(int cpu) {
+    return -1;
+}
+
+WEAK int halide_pin_thread_to_core_class(int core_class) {
+    return -1;
+}
+
+WEAK int halide_set_thread_pinning(int pinning) {
+    // There are no worker threads to pin.
+    return halide_thread_pinning_none;
+}
+
+WEAK int halide_set_thread_pool_core_class(int core_class) {
+    // There are no worker threads to restrict.
+    return halide_cpu_core_any;
+}
+
 WEAK halide_do_task_t halide_set_custom_do_task(halide_do_task_t f) {
     halide_do_task_t result = custom_do_task;
     custom_do_task = f;
@@ -76,4 +118,92 @@ WEAK int halide_do_par_for(void *user_context, halide_task_t f,
   return (*custom_do_par_for)(user_context, f, min, size, closure);
 }
 
+WEAK halide_do_parallel_tasks_t halide_set_custom_do_parallel_tasks(halide_do_parallel_tasks_t f) {
+    halide_do_parallel_tasks_t result = custom_do_parallel_tasks;
+    custom_do_parallel_tasks = f;
+    return result;
+}
+
+WEAK int halide_do_parallel_tasks(void *user_context, int num_tasks,
+                                  struct halide_parallel_task_t *tasks) {
+    return (*custom_do_parallel_tasks)(user_context, num_tasks, tasks);
+}
+
+// With no threads, a task graph just runs its nodes one at a time in
+// a dependency-respecting order.
+WEAK int halide_task_graph_execute(void *user_context, int num_nodes,
+                                   struct halide_task_graph_node_t *nodes) {
+    if (num_nodes <= 0) {
+        return 0;
+    }
+    uint8_t *done = (uint8_t *)__builtin_alloca(num_nodes);
+    for (int i = 0; i < num_nodes; i++) {
+        done[i] = 0;
+    }
+    int retired = 0;
+    while (retired < num_nodes) {
+        bool progress = false;
+        for (int i = 0; i < num_nodes; i++) {
+            if (done[i]) {
+                continue;
+            }
+            bool ready = true;
+            for (int j = 0; j < nodes[i].num_deps; j++) {
+                int d = nodes[i].deps[j];
+                if (d < 0 || d >= num_nodes || d == i) {
+                    halide_error(user_context, "halide_task_graph_execute: dependency index out of range");
+                    return halide_error_code_generic_error;
+                }
+                ready = ready && done[d];
+            }
+            if (!ready) {
+                continue;
+            }
+            int result = nodes[i].fn(user_context, nodes[i].closure);
+            if (result != 0) {
+                return result;
+            }
+            done[i] = 1;
+            retired++;
+            progress = true;
+        }
+        if (!progress) {
+            halide_error(user_context, "halide_task_graph_execute: cycle in task graph");
+            return halide_error_code_generic_error;
+        }
+    }
+    return 0;
+}
+
+// With no threads, a semaphore is just a counter, and blocking on one
+// is a programming error: nothing could ever release it.
+WEAK int halide_semaphore_init(halide_semaphore_t *s, int n) {
+    int *sem = (int *)s;
+    *sem = n;
+    return n;
+}
+
+WEAK int halide_semaphore_release(halide_semaphore_t *s, int n) {
+    int *sem = (int *)s;
+    *sem += n;
+    return *sem;
+}
+
+WEAK bool halide_semaphore_try_acquire(halide_semaphore_t *s, int n) {
+    int *sem = (int *)s;
+    if (*sem >= n) {
+        *sem -= n;
+        return true;
+    }
+    return false;
+}
+
+WEAK int halide_semaphore_acquire(halide_semaphore_t *s, int n) {
+    if (!halide_semaphore_try_acquire(s, n)) {
+        halide_error(NULL, "halide_semaphore_acquire would deadlock without a thread pool.");
+        return 0;
+    }
+    return n;
+}
+
 }  // extern "C"
@@ -123,12 +123,28 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
     return job.exit_status;
 }
 
+WEAK int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
+                                          struct halide_parallel_task_t *tasks) {
+    // GCD has no notion of a task group with shared accounting that
+    // maps onto this, so just run the loops back to back.
+    for (int i = 0; i < num_tasks; i++) {
+        int result = halide_do_par_for(user_context, tasks[i].fn,
+                                       tasks[i].min, tasks[i].extent,
+                                       tasks[i].closure);
+        if (result) {
+            return result;
+        }
+    }
+    return 0;
+}
+
 }  // extern "C"
 
 namespace Halide { namespace Runtime { namespace Internal {
 
 WEAK halide_do_task_t custom_do_task = halide_default_do_task;
 WEAK halide_do_par_for_t custom_do_par_for = halide_default_do_par_for;
+WEAK halide_do_parallel_tasks_t custom_do_parallel_tasks = halide_default_do_parallel_tasks;
 
 }}}  // namespace Halide::Runtime::Internal
 
@@ -165,6 +181,37 @@ WEAK int halide_set_num_threads(int n) {
     return old_custom_num_threads;
 }
 
+WEAK int halide_set_parallel_schedule(int schedule) {
+    // Grand Central Dispatch does its own scheduling.
+    return halide_parallel_schedule_stealing;
+}
+
+WEAK int halide_set_parallel_inline_extent(int extent) {
+    // Grand Central Dispatch decides for itself when to run a loop
+    // on the submitting thread.
+    return 1;
+}
+
+WEAK int halide_pin_thread_to_cpu(int cpu) {
+    // Darwin doesn't support explicit thread affinity.
+    return -1;
+}
+
+WEAK int halide_pin_thread_to_core_class(int core_class) {
+    // Darwin doesn't support explicit thread affinity.
+    return -1;
+}
+
+WEAK int halide_set_thread_pinning(int pinning) {
+    // Grand Central Dispatch does its own thread placement.
+    return halide_thread_pinning_none;
+}
+
+WEAK int halide_set_thread_pool_core_class(int core_class) {
+    // Grand Central Dispatch handles the asymmetry itself via QoS.
+    return halide_cpu_core_any;
+}
+
 WEAK halide_do_task_t halide_set_custom_do_task(halide_do_task_t f) {
     halide_do_task_t result = custom_do_task;
     custom_do_task = f;
@@ -187,4 +234,94 @@ WEAK int halide_do_par_for(void *user_context, halide_task_t f,
   return (*custom_do_par_for)(user_context, f, min, size, closure);
 }
 
+WEAK halide_do_parallel_tasks_t halide_set_custom_do_parallel_tasks(halide_do_parallel_tasks_t f) {
+    halide_do_parallel_tasks_t result = custom_do_parallel_tasks;
+    custom_do_parallel_tasks = f;
+    return result;
+}
+
+WEAK int halide_do_parallel_tasks(void *user_context, int num_tasks,
+                                  struct halide_parallel_task_t *tasks) {
+    return (*custom_do_parallel_tasks)(user_context, num_tasks, tasks);
+}
+
+// As with parallel task groups, GCD has no shared accounting to hang
+// a graph scheduler off, so run the nodes one at a time in a
+// dependency-respecting order. The parallel loops inside each node
+// still use the whole machine.
+WEAK int halide_task_graph_execute(void *user_context, int num_nodes,
+                                   struct halide_task_graph_node_t *nodes) {
+    if (num_nodes <= 0) {
+        return 0;
+    }
+    uint8_t *done = (uint8_t *)__builtin_alloca(num_nodes);
+    for (int i = 0; i < num_nodes; i++) {
+        done[i] = 0;
+    }
+    int retired = 0;
+    while (retired < num_nodes) {
+        bool progress = false;
+        for (int i = 0; i < num_nodes; i++) {
+            if (done[i]) {
+                continue;
+            }
+            bool ready = true;
+            for (int j = 0; j < nodes[i].num_deps; j++) {
+                int d = nodes[i].deps[j];
+                if (d < 0 || d >= num_nodes || d == i) {
+                    halide_error(user_context, "halide_task_graph_execute: dependency index out of range");
+                    return halide_error_code_generic_error;
+                }
+                ready = ready && done[d];
+            }
+            if (!ready) {
+                continue;
+            }
+            int result = nodes[i].fn(user_context, nodes[i].closure);
+            if (result != 0) {
+                return result;
+            }
+            done[i] = 1;
+            retired++;
+            progress = true;
+        }
+        if (!progress) {
+            halide_error(user_context, "halide_task_graph_execute: cycle in task graph");
+            return halide_error_code_generic_error;
+        }
+    }
+    return 0;
+}
+
+// Semaphores are an atomic counter. There's no cheap condition
+// variable to park blocked acquirers on here, so acquire spins;
+// acquires only block for as long as it takes the producer task on
+// the other end to catch up.
+WEAK int halide_semaphore_init(halide_semaphore_t *s, int n) {
+    int *sem = (int *)s;
+    __atomic_store_n(sem, n, __ATOMIC_RELEASE);
+    return n;
+}
+
+WEAK int halide_semaphore_release(halide_semaphore_t *s, int n) {
+    int *sem = (int *)s;
+    return __atomic_add_fetch(sem, n, __ATOMIC_ACQ_REL);
+}
+
+WEAK bool halide_semaphore_try_acquire(halide_semaphore_t *s, int n) {
+    int *sem = (int *)s;
+    int expected = __atomic_load_n(sem, __ATOMIC_ACQUIRE);
+    while (expected >= n &&
+           !__atomic_compare_exchange_n(sem, &expected, expected - n, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    }
+    return expected >= n;
+}
+
+WEAK int halide_semaphore_acquire(halide_semaphore_t *s, int n) {
+    while (!halide_semaphore_try_acquire(s, n)) {
+    }
+    return n;
+}
+
 }
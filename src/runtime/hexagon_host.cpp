@@ -29,6 +29,10 @@ typedef int (*remote_get_symbol_fn)(halide_hexagon_handle_t, const char*, int, h
 typedef int (*remote_run_fn)(halide_hexagon_handle_t, int,
                              const remote_buffer*, int, const remote_buffer*, int,
                              remote_buffer*, int);
+typedef int (*remote_run_batch_fn)(halide_hexagon_handle_t,
+                                   const remote_buffer*, int,
+                                   remote_buffer*, int,
+                                   const unsigned char*, int);
 typedef int (*remote_release_library_fn)(halide_hexagon_handle_t);
 typedef int (*remote_poll_log_fn)(char *, int, int *);
 typedef void (*remote_poll_profiler_state_fn)(int *, int *);
@@ -43,6 +47,7 @@ typedef void (*host_free_fn)(void *);
 WEAK remote_load_library_fn remote_load_library = NULL;
 WEAK remote_get_symbol_fn remote_get_symbol = NULL;
 WEAK remote_run_fn remote_run = NULL;
+WEAK remote_run_batch_fn remote_run_batch = NULL;
 WEAK remote_release_library_fn remote_release_library = NULL;
 WEAK remote_poll_log_fn remote_poll_log = NULL;
 WEAK remote_poll_profiler_state_fn remote_poll_profiler_state = NULL;
@@ -140,6 +145,7 @@ WEAK int init_hexagon_runtime(void *user_context) {
     if (!host_free) return -1;
 
     // These symbols are optional.
+    get_symbol(user_context, host_lib, "halide_hexagon_remote_run_batch", remote_run_batch, /* required */ false);
     get_symbol(user_context, host_lib, "halide_hexagon_remote_poll_log", remote_poll_log, /* required */ false);
     get_symbol(user_context, host_lib, "halide_hexagon_remote_poll_profiler_state", remote_poll_profiler_state, /* required */ false);
 
@@ -294,6 +300,126 @@ WEAK int map_arguments(void *user_context, int arg_count,
     return mapped_count;
 }
 
+// State for batching pipeline invocations into a single RPC. While a
+// batch is open (halide_hexagon_begin_rpc_batch), halide_hexagon_run
+// queues the marshalled arguments here instead of issuing an RPC, and
+// halide_hexagon_end_rpc_batch sends the whole queue to the DSP in one
+// halide_hexagon_remote_run_batch call. The control buffer describes
+// each queued invocation as a sequence of 32-bit words: the function
+// handle, the input buffer, output buffer and scalar counts, then for
+// each scalar its size in bytes followed by the value packed into
+// whole words. Buffer arguments are ION-backed shared memory, so only
+// their mapped remote_buffer entries are queued; scalars live on the
+// caller's stack and are copied into the control buffer. Guarded by
+// thread_lock.
+WEAK bool rpc_batch_active = false;
+WEAK halide_hexagon_handle_t rpc_batch_module = 0;
+WEAK remote_buffer *rpc_batch_inputs = NULL;
+WEAK int rpc_batch_input_count = 0;
+WEAK int rpc_batch_input_capacity = 0;
+WEAK remote_buffer *rpc_batch_outputs = NULL;
+WEAK int rpc_batch_output_count = 0;
+WEAK int rpc_batch_output_capacity = 0;
+WEAK uint32_t *rpc_batch_control = NULL;
+WEAK int rpc_batch_control_count = 0;
+WEAK int rpc_batch_control_capacity = 0;
+
+// Grow one of the batch arrays to hold at least count + extra
+// elements. Returns false on allocation failure.
+WEAK bool rpc_batch_reserve(void **array, int *capacity, int count, int extra, size_t elem_size) {
+    if (count + extra <= *capacity) {
+        return true;
+    }
+    int new_capacity = *capacity < 16 ? 16 : *capacity * 2;
+    while (new_capacity < count + extra) {
+        new_capacity *= 2;
+    }
+    void *new_array = malloc(new_capacity * elem_size);
+    if (!new_array) {
+        return false;
+    }
+    if (*array) {
+        memcpy(new_array, *array, count * elem_size);
+        free(*array);
+    }
+    *array = new_array;
+    *capacity = new_capacity;
+    return true;
+}
+
+// Append one invocation to the open batch. The mapped buffer entries
+// and scalar values are copied, so the caller's stack copies may die,
+// but the ION allocations the buffer entries point to must stay live
+// until the batch is flushed.
+WEAK int queue_batched_run(void *user_context,
+                           halide_hexagon_handle_t module, halide_hexagon_handle_t function,
+                           const remote_buffer *input_buffers, int input_buffer_count,
+                           const remote_buffer *output_buffers, int output_buffer_count,
+                           const remote_buffer *input_scalars, int input_scalar_count) {
+    int scalar_words = 0;
+    for (int i = 0; i < input_scalar_count; i++) {
+        scalar_words += 1 + (input_scalars[i].dataLen + 3) / 4;
+    }
+    if (!rpc_batch_reserve((void **)&rpc_batch_inputs, &rpc_batch_input_capacity,
+                           rpc_batch_input_count, input_buffer_count, sizeof(remote_buffer)) ||
+        !rpc_batch_reserve((void **)&rpc_batch_outputs, &rpc_batch_output_capacity,
+                           rpc_batch_output_count, output_buffer_count, sizeof(remote_buffer)) ||
+        !rpc_batch_reserve((void **)&rpc_batch_control, &rpc_batch_control_capacity,
+                           rpc_batch_control_count, 4 + scalar_words, sizeof(uint32_t))) {
+        error(user_context) << "Hexagon: out of memory queueing batched pipeline\n";
+        return -1;
+    }
+    memcpy(rpc_batch_inputs + rpc_batch_input_count, input_buffers,
+           input_buffer_count * sizeof(remote_buffer));
+    rpc_batch_input_count += input_buffer_count;
+    memcpy(rpc_batch_outputs + rpc_batch_output_count, output_buffers,
+           output_buffer_count * sizeof(remote_buffer));
+    rpc_batch_output_count += output_buffer_count;
+
+    uint32_t *control = rpc_batch_control + rpc_batch_control_count;
+    *control++ = (uint32_t)function;
+    *control++ = (uint32_t)input_buffer_count;
+    *control++ = (uint32_t)output_buffer_count;
+    *control++ = (uint32_t)input_scalar_count;
+    for (int i = 0; i < input_scalar_count; i++) {
+        *control++ = (uint32_t)input_scalars[i].dataLen;
+        int payload_words = (input_scalars[i].dataLen + 3) / 4;
+        if (payload_words > 0) {
+            control[payload_words - 1] = 0;
+            memcpy(control, input_scalars[i].data, input_scalars[i].dataLen);
+            control += payload_words;
+        }
+    }
+    rpc_batch_control_count += 4 + scalar_words;
+    rpc_batch_module = module;
+    return 0;
+}
+
+// Send any queued invocations to the DSP in a single RPC. The queue
+// arrays keep their capacity for the next batch.
+WEAK int flush_rpc_batch(void *user_context) {
+    if (rpc_batch_control_count == 0) {
+        return 0;
+    }
+    debug(user_context) << "    halide_hexagon_remote_run_batch ("
+                        << rpc_batch_input_count << " inputs, "
+                        << rpc_batch_output_count << " outputs) -> ";
+    int result = remote_run_batch(rpc_batch_module,
+                                  rpc_batch_inputs, rpc_batch_input_count,
+                                  rpc_batch_outputs, rpc_batch_output_count,
+                                  (const unsigned char *)rpc_batch_control,
+                                  rpc_batch_control_count * (int)sizeof(uint32_t));
+    poll_log(user_context);
+    debug(user_context) << "        " << result << "\n";
+    rpc_batch_input_count = 0;
+    rpc_batch_output_count = 0;
+    rpc_batch_control_count = 0;
+    if (result != 0) {
+        error(user_context) << "Hexagon batched pipelines failed.\n";
+    }
+    return result;
+}
+
 }  // namespace
 
 WEAK int halide_hexagon_run(void *user_context,
@@ -354,6 +480,19 @@ WEAK int halide_hexagon_run(void *user_context,
                                            input_scalars);
     if (input_scalar_count < 0) return input_scalar_count;
 
+    // If a batch is open, queue this invocation instead of issuing an
+    // RPC. The result of the batched pipelines is reported by
+    // halide_hexagon_end_rpc_batch.
+    {
+        ScopedMutexLock lock(&thread_lock);
+        if (rpc_batch_active) {
+            return queue_batched_run(user_context, module, *function,
+                                     input_buffers, input_buffer_count,
+                                     output_buffers, output_buffer_count,
+                                     input_scalars, input_scalar_count);
+        }
+    }
+
     #ifdef DEBUG_RUNTIME
     uint64_t t_before = halide_current_time_ns(user_context);
     #endif
@@ -389,6 +528,42 @@ WEAK int halide_hexagon_run(void *user_context,
     return result != 0 ? -1 : 0;
 }
 
+WEAK int halide_hexagon_begin_rpc_batch(void *user_context) {
+    int result = init_hexagon_runtime(user_context);
+    if (result != 0) return result;
+
+    debug(user_context) << "Hexagon: halide_hexagon_begin_rpc_batch (user_context: "
+                        << user_context << ")\n";
+
+    if (!remote_run_batch) {
+        // The support library predates batching. Not an error; the
+        // caller just keeps paying one RPC per pipeline.
+        debug(user_context) << "    batching not supported by support library\n";
+        return -1;
+    }
+
+    ScopedMutexLock lock(&thread_lock);
+    if (rpc_batch_active) {
+        error(user_context) << "Hexagon: RPC batch already open.\n";
+        return -1;
+    }
+    rpc_batch_active = true;
+    return 0;
+}
+
+WEAK int halide_hexagon_end_rpc_batch(void *user_context) {
+    debug(user_context) << "Hexagon: halide_hexagon_end_rpc_batch (user_context: "
+                        << user_context << ")\n";
+
+    ScopedMutexLock lock(&thread_lock);
+    if (!rpc_batch_active) {
+        error(user_context) << "Hexagon: no RPC batch open.\n";
+        return -1;
+    }
+    rpc_batch_active = false;
+    return flush_rpc_batch(user_context);
+}
+
 WEAK int halide_hexagon_device_release(void *user_context) {
     debug(user_context)
         << "Hexagon: halide_hexagon_device_release (user_context: " <<  user_context << ")\n";
@@ -580,6 +755,18 @@ WEAK int halide_hexagon_copy_to_host(void *user_context, struct halide_buffer_t
     uint64_t t_before = halide_current_time_ns(user_context);
     #endif
 
+    // Make sure any batched pipelines that may have written this
+    // buffer have actually run.
+    {
+        ScopedMutexLock lock(&thread_lock);
+        if (rpc_batch_active) {
+            int result = flush_rpc_batch(user_context);
+            if (result != 0) {
+                return result;
+            }
+        }
+    }
+
     halide_assert(user_context, buf->host && buf->device);
     device_copy c = make_device_to_host_copy(buf);
 
@@ -598,7 +785,12 @@ WEAK int halide_hexagon_copy_to_host(void *user_context, struct halide_buffer_t
 WEAK int halide_hexagon_device_sync(void *user_context, struct halide_buffer_t *) {
     debug(user_context)
         << "Hexagon: halide_hexagon_device_sync (user_context: " << user_context << ")\n";
-    // Nothing to do.
+    // The DSP runs synchronously, so the only pending work is any
+    // batched pipelines that haven't been sent yet.
+    ScopedMutexLock lock(&thread_lock);
+    if (rpc_batch_active) {
+        return flush_rpc_batch(user_context);
+    }
     return 0;
 }
 
@@ -816,6 +1008,10 @@ WEAK halide_device_interface_impl_t hexagon_device_interface_impl = {
     halide_default_device_release_crop,
     halide_default_device_wrap_native,
     halide_default_device_detach_native,
+    NULL,  // device_to_device_copy
+    NULL,  // device_initialize
+    NULL,  // readback_slice
+    NULL,  // readback_fence
 };
 
 WEAK halide_device_interface_t hexagon_device_interface = {
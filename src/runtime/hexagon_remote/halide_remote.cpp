@@ -4,6 +4,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <dlfcn.h>
 #include <qurt.h>
 
@@ -330,6 +331,91 @@ int halide_hexagon_remote_run_v2(handle_t module_ptr, handle_t function,
     return result;
 }
 
+int halide_hexagon_remote_run_batch(handle_t module_ptr,
+                                    const buffer *input_buffersPtrs, int input_buffersLen,
+                                    buffer *output_buffersPtrs, int output_buffersLen,
+                                    const unsigned char *control, int controlLen) {
+    // The control buffer describes each batched invocation as a
+    // sequence of 32-bit words: the function handle, the input
+    // buffer, output buffer and scalar counts, then for each scalar
+    // its size in bytes followed by the value packed into whole
+    // words. The buffer sequences hold the buffers of all the
+    // invocations concatenated in order.
+    const uint32_t *words = reinterpret_cast<const uint32_t *>(control);
+    int num_words = controlLen / 4;
+    int pos = 0;
+    int next_input = 0;
+    int next_output = 0;
+
+    // Power HVX on once for the whole batch instead of once per
+    // pipeline.
+    int result = halide_hexagon_remote_power_hvx_on();
+    if (result != 0) {
+        return result;
+    }
+
+    while (pos + 4 <= num_words) {
+        pipeline_argv_t pipeline = reinterpret_cast<pipeline_argv_t>(words[pos++]);
+        int num_inputs = words[pos++];
+        int num_outputs = words[pos++];
+        int num_scalars = words[pos++];
+        if (next_input + num_inputs > input_buffersLen ||
+            next_output + num_outputs > output_buffersLen) {
+            result = -1;
+            break;
+        }
+
+        struct buffer_t {
+            uint64_t dev;
+            uint8_t* host;
+        };
+        void **args = (void **)__builtin_alloca((num_inputs + num_outputs + num_scalars) * sizeof(void *));
+        buffer_t *buffers = (buffer_t *)__builtin_alloca((num_inputs + num_outputs) * sizeof(buffer_t));
+        // The packed scalar values in the control buffer are only
+        // word-aligned, so copy them out to properly aligned storage.
+        uint64_t *scalars = (uint64_t *)__builtin_alloca(num_scalars * sizeof(uint64_t));
+
+        void **next_arg = &args[0];
+        buffer_t *next_buffer_t = &buffers[0];
+        // Input buffers come first.
+        for (int i = 0; i < num_inputs; i++, next_arg++, next_buffer_t++) {
+            next_buffer_t->host = input_buffersPtrs[next_input++].data;
+            *next_arg = next_buffer_t;
+        }
+        // Output buffers are next.
+        for (int i = 0; i < num_outputs; i++, next_arg++, next_buffer_t++) {
+            next_buffer_t->host = output_buffersPtrs[next_output++].data;
+            *next_arg = next_buffer_t;
+        }
+        // Input scalars are last.
+        for (int i = 0; i < num_scalars; i++, next_arg++) {
+            if (pos >= num_words) {
+                halide_hexagon_remote_power_hvx_off();
+                return -1;
+            }
+            int size = words[pos++];
+            int payload_words = (size + 3) / 4;
+            if (pos + payload_words > num_words || size > (int)sizeof(uint64_t)) {
+                halide_hexagon_remote_power_hvx_off();
+                return -1;
+            }
+            scalars[i] = 0;
+            memcpy(&scalars[i], &words[pos], size);
+            pos += payload_words;
+            *next_arg = &scalars[i];
+        }
+
+        result = run_context.run(pipeline, args);
+        if (result != 0) {
+            break;
+        }
+    }
+
+    halide_hexagon_remote_power_hvx_off();
+
+    return result;
+}
+
 int halide_hexagon_remote_release_library(handle_t module_ptr) {
     if (use_dlopenbuf()) {
         dlclose(reinterpret_cast<void*>(module_ptr));
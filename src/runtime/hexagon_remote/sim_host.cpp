@@ -435,6 +435,55 @@ int halide_hexagon_remote_run(handle_t module_ptr, handle_t function,
     return ret;
 }
 
+DLLEXPORT
+int halide_hexagon_remote_run_batch(handle_t module_ptr,
+                                    const host_buffer *input_buffersPtrs, int input_buffersLen,
+                                    host_buffer *output_buffersPtrs, int output_buffersLen,
+                                    const unsigned char *control, int controlLen) {
+    // Batching exists to amortize FastRPC overhead, which the
+    // simulator doesn't have, so just unpack the control buffer (see
+    // halide_hexagon_remote.idl for the layout) and run the batched
+    // pipelines one at a time.
+    const uint32_t *words = reinterpret_cast<const uint32_t *>(control);
+    int num_words = controlLen / 4;
+    int pos = 0;
+    int next_input = 0;
+    int next_output = 0;
+    while (pos + 4 <= num_words) {
+        handle_t function = words[pos++];
+        int num_inputs = words[pos++];
+        int num_outputs = words[pos++];
+        int num_scalars = words[pos++];
+        if (next_input + num_inputs > input_buffersLen ||
+            next_output + num_outputs > output_buffersLen) {
+            return -1;
+        }
+
+        std::vector<host_buffer> scalars(num_scalars);
+        for (int i = 0; i < num_scalars; i++) {
+            if (pos >= num_words) return -1;
+            int size = words[pos++];
+            int payload_words = (size + 3) / 4;
+            if (pos + payload_words > num_words) return -1;
+            scalars[i].data = const_cast<unsigned char *>(
+                reinterpret_cast<const unsigned char *>(&words[pos]));
+            scalars[i].dataLen = size;
+            pos += payload_words;
+        }
+
+        int ret = halide_hexagon_remote_run(module_ptr, function,
+                                            input_buffersPtrs + next_input, num_inputs,
+                                            output_buffersPtrs + next_output, num_outputs,
+                                            scalars.data(), num_scalars);
+        if (ret != 0) {
+            return ret;
+        }
+        next_input += num_inputs;
+        next_output += num_outputs;
+    }
+    return 0;
+}
+
 DLLEXPORT
 int halide_hexagon_remote_release_library(handle_t module_ptr) {
     std::lock_guard<std::mutex> guard(mutex);
@@ -0,0 +1,162 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+#include "printer.h"
+
+// Classification of the logical cpus of an asymmetric multiprocessor
+// (e.g. ARM big.LITTLE) into big and LITTLE cores, using the sysfs
+// cpu_capacity the kernel scheduler itself uses, so the thread pool
+// can keep latency-sensitive pipelines off the slow cores. Shared by
+// the Linux and Android runtimes.
+
+extern "C" {
+
+extern int open(const char *pathname, int flags, ...);
+extern ssize_t read(int fd, void *buf, size_t bytes);
+extern int close(int fd);
+
+// Pid 0 means the calling thread.
+extern int sched_setaffinity(int pid, size_t cpusetsize, const unsigned long *mask);
+
+}  // extern "C"
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// Room for 512 logical cpus on 32-bit systems, 1024 on 64-bit,
+// matching the libc cpu_set_t.
+#define CPU_MASK_WORDS 16
+#define CPU_MASK_BITS (CPU_MASK_WORDS * 8 * (int)sizeof(unsigned long))
+
+struct cpu_topology_t {
+    // Which logical cpus belong to each class. On homogeneous
+    // machines (or if sysfs tells us nothing) every cpu is big and
+    // the LITTLE mask is empty.
+    unsigned long big_mask[CPU_MASK_WORDS];
+    unsigned long little_mask[CPU_MASK_WORDS];
+    int num_big, num_little;
+    // Nonzero once the fields above are valid. Racing threads may
+    // classify twice, writing identical results, so only the
+    // store-release/load-acquire pairing matters.
+    int classified;
+};
+WEAK cpu_topology_t cpu_topology;
+
+// Read a small decimal value from a sysfs file, or -1 if we can't.
+WEAK long read_sysfs_long(const char *path) {
+    int fd = open(path, 0 /* O_RDONLY */);
+    if (fd < 0) {
+        return -1;
+    }
+    char buf[32];
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) {
+        return -1;
+    }
+    buf[len] = 0;
+    return atoi(buf);
+}
+
+// The relative compute capacity of a logical cpu. Kernels built for
+// asymmetric systems expose the value the scheduler uses; elsewhere
+// fall back to the maximum cpufreq, which also separates the core
+// classes on every big.LITTLE part we've seen. -1 if neither is
+// readable.
+WEAK long cpu_capacity(int cpu) {
+    char mem[64];
+    Printer<StringStreamPrinter, sizeof(mem)> path(NULL, mem);
+    path << "/sys/devices/system/cpu/cpu" << cpu << "/cpu_capacity";
+    long capacity = read_sysfs_long(path.str());
+    if (capacity < 0) {
+        path.clear();
+        path << "/sys/devices/system/cpu/cpu" << cpu << "/cpufreq/cpuinfo_max_freq";
+        capacity = read_sysfs_long(path.str());
+    }
+    return capacity;
+}
+
+WEAK void classify_cpus() {
+    if (__atomic_load_n(&cpu_topology.classified, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    int num_cpus = halide_host_cpu_count();
+    if (num_cpus > CPU_MASK_BITS) {
+        num_cpus = CPU_MASK_BITS;
+    }
+
+    long capacities[CPU_MASK_BITS];
+    long max_capacity = -1;
+    for (int i = 0; i < num_cpus; i++) {
+        capacities[i] = cpu_capacity(i);
+        if (capacities[i] > max_capacity) {
+            max_capacity = capacities[i];
+        }
+    }
+
+    const int bits_per_word = 8 * sizeof(unsigned long);
+    unsigned long big_mask[CPU_MASK_WORDS], little_mask[CPU_MASK_WORDS];
+    memset(big_mask, 0, sizeof(big_mask));
+    memset(little_mask, 0, sizeof(little_mask));
+    int num_big = 0, num_little = 0;
+    for (int i = 0; i < num_cpus; i++) {
+        // The fastest class is big; everything slower is LITTLE. Cpus
+        // whose capacity we couldn't read count as big, so an
+        // unreadable sysfs degrades to "everything is big" rather
+        // than an empty class.
+        if (capacities[i] == max_capacity || capacities[i] < 0) {
+            big_mask[i / bits_per_word] |= 1UL << (i % bits_per_word);
+            num_big++;
+        } else {
+            little_mask[i / bits_per_word] |= 1UL << (i % bits_per_word);
+            num_little++;
+        }
+    }
+
+    memcpy(cpu_topology.big_mask, big_mask, sizeof(big_mask));
+    memcpy(cpu_topology.little_mask, little_mask, sizeof(little_mask));
+    cpu_topology.num_big = num_big;
+    cpu_topology.num_little = num_little;
+    __atomic_store_n(&cpu_topology.classified, 1, __ATOMIC_RELEASE);
+}
+
+}}}  // namespace Halide::Runtime::Internal
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK int halide_host_cpu_count_of_class(int core_class) {
+    if (core_class == halide_cpu_core_big) {
+        classify_cpus();
+        return cpu_topology.num_big;
+    } else if (core_class == halide_cpu_core_little) {
+        classify_cpus();
+        return cpu_topology.num_little;
+    } else {
+        return halide_host_cpu_count();
+    }
+}
+
+WEAK int halide_pin_thread_to_core_class(int core_class) {
+    unsigned long mask[CPU_MASK_WORDS];
+    const unsigned long *src = NULL;
+    if (core_class == halide_cpu_core_big) {
+        classify_cpus();
+        src = cpu_topology.big_mask;
+    } else if (core_class == halide_cpu_core_little) {
+        classify_cpus();
+        if (cpu_topology.num_little > 0) {
+            src = cpu_topology.little_mask;
+        }
+        // An empty class (homogeneous machine) falls through to "any
+        // cpu" rather than asking for an unsatisfiable affinity.
+    }
+    if (src) {
+        memcpy(mask, src, sizeof(mask));
+    } else {
+        memset(mask, 0xff, sizeof(mask));
+    }
+    return sched_setaffinity(0, sizeof(mask), mask);
+}
+
+}  // extern "C"
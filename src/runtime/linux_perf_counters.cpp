@@ -0,0 +1,137 @@
+#include "HalideRuntime.h"
+
+// Hardware performance counter sampling via the Linux perf_event
+// interface. The profiler thread uses this to attribute cache misses
+// and stalled cycles to Funcs, alongside the wall-clock time it
+// already samples.
+
+extern "C" {
+
+// The syscall number for perf_event_open:
+// -- i386 is 336
+// -- x64 is 298
+#ifndef SYS_PERF_EVENT_OPEN
+
+#ifdef BITS_64
+#define SYS_PERF_EVENT_OPEN 298
+#endif
+
+#ifdef BITS_32
+#define SYS_PERF_EVENT_OPEN 336
+#endif
+
+#endif
+
+extern int syscall(int num, ...);
+extern ssize_t read(int fd, void *buf, size_t bytes);
+
+}
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// The prefix of struct perf_event_attr from the kernel ABI
+// (PERF_ATTR_SIZE_VER0). Everything we don't set is left zero.
+struct perf_event_attr {
+    uint32_t type;
+    uint32_t size;
+    uint64_t config;
+    uint64_t sample_period;
+    uint64_t sample_type;
+    uint64_t read_format;
+    uint64_t flags;
+    uint32_t wakeup_events;
+    uint32_t bp_type;
+    uint64_t bp_addr;
+};
+
+enum {
+    PERF_TYPE_HARDWARE = 0,
+    PERF_COUNT_HW_CACHE_MISSES = 3,
+    PERF_COUNT_HW_STALLED_CYCLES_BACKEND = 8,
+    PERF_ATTR_SIZE_VER0 = 64,
+};
+
+// Bit positions within perf_event_attr::flags.
+const uint64_t perf_attr_exclude_hv = (uint64_t)1 << 6;
+
+// The counters tracked, in the order the profiler expects them.
+const int num_perf_events = 2;
+WEAK uint64_t perf_event_configs[num_perf_events] = {
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_STALLED_CYCLES_BACKEND,
+};
+
+// One fd per (event, cpu) pair, or NULL if the counters couldn't be
+// opened (e.g. perf_event_paranoid forbids system-wide counters for
+// unprivileged processes).
+WEAK int *perf_event_fds = NULL;
+WEAK int perf_event_cpus = 0;
+WEAK bool perf_events_failed = false;
+
+WEAK bool open_perf_events() {
+    int cpus = halide_host_cpu_count();
+    int *fds = (int *)malloc(num_perf_events * cpus * sizeof(int));
+    if (!fds) {
+        return false;
+    }
+    for (int e = 0; e < num_perf_events; e++) {
+        for (int cpu = 0; cpu < cpus; cpu++) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = PERF_ATTR_SIZE_VER0;
+            attr.config = perf_event_configs[e];
+            attr.flags = perf_attr_exclude_hv;
+            // System-wide on one cpu, counting from creation.
+            int fd = syscall(SYS_PERF_EVENT_OPEN, &attr, -1, cpu, -1, 0);
+            if (fd < 0) {
+                for (int i = 0; i < e * cpus + cpu; i++) {
+                    close(fds[i]);
+                }
+                free(fds);
+                return false;
+            }
+            fds[e * cpus + cpu] = fd;
+        }
+    }
+    perf_event_fds = fds;
+    perf_event_cpus = cpus;
+    return true;
+}
+
+}}} // namespace Halide::Runtime::Internal
+
+extern "C" {
+
+WEAK int halide_profiler_read_hw_counters(uint64_t *cache_misses,
+                                          uint64_t *stalled_cycles) {
+    if (perf_events_failed) {
+        return -1;
+    }
+    if (!perf_event_fds) {
+        // First call. Only the profiler thread calls this, so there's
+        // no race on the initialization.
+        if (!open_perf_events()) {
+            perf_events_failed = true;
+            return -1;
+        }
+    }
+    uint64_t totals[num_perf_events];
+    for (int e = 0; e < num_perf_events; e++) {
+        totals[e] = 0;
+        for (int cpu = 0; cpu < perf_event_cpus; cpu++) {
+            uint64_t count = 0;
+            int fd = perf_event_fds[e * perf_event_cpus + cpu];
+            if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) {
+                perf_events_failed = true;
+                return -1;
+            }
+            totals[e] += count;
+        }
+    }
+    *cache_misses = totals[0];
+    *stalled_cycles = totals[1];
+    return 0;
+}
+
+}
@@ -173,6 +173,73 @@ INLINE mxArray *create_numeric_matrix(size_t M, size_t N, mxClassID type, mxComp
     }
 }
 
+// Marshalling the same argument list repeatedly dominates the cost of
+// calling a small filter from a Matlab batch loop, so the converted
+// descriptors are cached between calls. An argument slot hits the
+// cache when the incoming mxArray has the same class and extents as
+// the previous call (shape identity); its halide_buffer_t, with
+// strides already computed and validation already done, is then
+// reused with just the data pointer refreshed. Scalar arguments are
+// re-read every call since their values change.
+
+const int kMaxCachedDims = 16;
+
+struct ArgDescriptor {
+    // The shape identity of the mxArray this descriptor was built
+    // from. class_id of mxUNKNOWN_CLASS marks the slot invalid.
+    mxClassID class_id;
+    int dim_count;
+    size_t extents[kMaxCachedDims];
+
+    // The converted argument.
+    halide_buffer_t buf;
+    halide_dimension_t dim[kMaxCachedDims];
+    uint64_t scalar_storage;
+};
+
+struct ArgDescriptorCache {
+    const halide_filter_metadata_t *metadata;
+    ArgDescriptor *args;
+};
+
+WEAK ArgDescriptorCache arg_descriptor_cache = {NULL, NULL};
+
+WEAK bool descriptor_matches(const ArgDescriptor *desc, const mxArray *arr) {
+    if (desc->class_id == mxUNKNOWN_CLASS ||
+        mxGetClassID(arr) != desc->class_id) {
+        return false;
+    }
+    int dim_count = get_number_of_dimensions(arr);
+    if (dim_count != desc->dim_count || dim_count > kMaxCachedDims) {
+        return false;
+    }
+    for (int i = 0; i < dim_count; i++) {
+        if (get_dimension(arr, i) != desc->extents[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Get the descriptor array for a pipeline, building it on first use.
+// A mex module wraps one pipeline, so a single cache suffices; if
+// several pipelines share one runtime the cache just follows the most
+// recently called one.
+WEAK ArgDescriptor *get_arg_descriptors(void *user_context, const halide_filter_metadata_t *metadata) {
+    if (arg_descriptor_cache.metadata != metadata) {
+        if (arg_descriptor_cache.args) {
+            halide_free(user_context, arg_descriptor_cache.args);
+        }
+        size_t size = sizeof(ArgDescriptor) * metadata->num_arguments;
+        arg_descriptor_cache.args = (ArgDescriptor *)halide_malloc(user_context, size);
+        if (arg_descriptor_cache.args) {
+            memset(arg_descriptor_cache.args, 0, size);
+        }
+        arg_descriptor_cache.metadata = arg_descriptor_cache.args ? metadata : NULL;
+    }
+    return arg_descriptor_cache.args;
+}
+
 }  // namespace mex
 }  // namespace Runtime
 }  // namespace Halide
@@ -408,6 +475,8 @@ WEAK int halide_matlab_call_pipeline(void *user_context,
         return result;
     }
 
+    ArgDescriptor *descriptors = get_arg_descriptors(user_context, metadata);
+
     void **args = (void **)__builtin_alloca(nrhs * sizeof(void *));
     for (int i = 0; i < nrhs; i++) {
         const mxArray *arg = prhs[i];
@@ -415,6 +484,19 @@ WEAK int halide_matlab_call_pipeline(void *user_context,
 
         if (arg_metadata->kind == halide_argument_kind_input_buffer ||
             arg_metadata->kind == halide_argument_kind_output_buffer) {
+            ArgDescriptor *desc = descriptors ? &descriptors[i] : NULL;
+            if (desc && descriptor_matches(desc, arg)) {
+                // Same shape identity as the previous call: reuse the
+                // converted descriptor, refreshing only the data
+                // pointer and the device state.
+                desc->buf.host = (uint8_t *)mxGetData(arg);
+                desc->buf.device = 0;
+                desc->buf.device_interface = NULL;
+                desc->buf.flags = 0;
+                desc->buf.set_host_dirty(true);
+                args[i] = &desc->buf;
+                continue;
+            }
             halide_buffer_t *buf = (halide_buffer_t *)__builtin_alloca(sizeof(halide_buffer_t));
             memset(buf, 0, sizeof(halide_buffer_t));
             buf->dim = (halide_dimension_t *)__builtin_alloca(sizeof(halide_dimension_t) * arg_metadata->dimensions);
@@ -425,6 +507,19 @@ WEAK int halide_matlab_call_pipeline(void *user_context,
                 return result;
             }
             args[i] = buf;
+            if (desc &&
+                arg_metadata->dimensions <= kMaxCachedDims &&
+                get_number_of_dimensions(arg) <= kMaxCachedDims) {
+                // Remember the conversion for the next call.
+                desc->buf = *buf;
+                desc->buf.dim = desc->dim;
+                memcpy(desc->dim, buf->dim, sizeof(halide_dimension_t) * arg_metadata->dimensions);
+                desc->dim_count = get_number_of_dimensions(arg);
+                for (int d = 0; d < desc->dim_count; d++) {
+                    desc->extents[d] = get_dimension(arg, d);
+                }
+                desc->class_id = mxGetClassID(arg);
+            }
         } else {
             size_t size_bytes = max(8, (arg_metadata->type.bits + 7) / 8);
             void *scalar = __builtin_alloca(size_bytes);
@@ -458,4 +553,68 @@ WEAK int halide_matlab_call_pipeline(void *user_context,
     return result;
 }
 
+// The raw re-invocation path, analogous to the unchecked entry points
+// emitted under the unchecked_entry feature: a harness that has made
+// one successful call through halide_matlab_call_pipeline (which
+// validates the arguments and builds the descriptor cache) can
+// re-invoke the pipeline through here with no validation at all, as
+// long as every buffer argument keeps the shape it had when the cache
+// was built. Only the data pointers and scalar values are re-read.
+WEAK int halide_matlab_call_pipeline_raw(void *user_context,
+                                         int (*pipeline)(void **args), const halide_filter_metadata_t *metadata,
+                                         int nrhs, const mxArray **prhs) {
+    ArgDescriptor *descriptors = arg_descriptor_cache.args;
+    if (arg_descriptor_cache.metadata != metadata ||
+        !descriptors ||
+        nrhs != metadata->num_arguments) {
+        error(user_context) << "halide_matlab_call_pipeline_raw requires a prior successful call "
+                            << "through halide_matlab_call_pipeline for " << metadata->name << ".\n";
+        return halide_error_code_generic_error;
+    }
+
+    void **args = (void **)__builtin_alloca(nrhs * sizeof(void *));
+    for (int i = 0; i < nrhs; i++) {
+        const halide_filter_argument_t *arg_metadata = &metadata->arguments[i];
+        ArgDescriptor *desc = &descriptors[i];
+
+        if (arg_metadata->kind == halide_argument_kind_input_buffer ||
+            arg_metadata->kind == halide_argument_kind_output_buffer) {
+            if (desc->class_id == mxUNKNOWN_CLASS) {
+                error(user_context) << "No cached descriptor for parameter " << arg_metadata->name << ".\n";
+                return halide_error_code_generic_error;
+            }
+            desc->buf.host = (uint8_t *)mxGetData(prhs[i]);
+            desc->buf.device = 0;
+            desc->buf.device_interface = NULL;
+            desc->buf.flags = 0;
+            desc->buf.set_host_dirty(true);
+            args[i] = &desc->buf;
+        } else {
+            int result = halide_matlab_array_to_scalar(user_context, prhs[i], arg_metadata,
+                                                       &desc->scalar_storage);
+            if (result != 0) {
+                return result;
+            }
+            args[i] = &desc->scalar_storage;
+        }
+    }
+
+    int result = pipeline(args);
+
+    // Copy any GPU resident output buffers back to the CPU before returning.
+    for (int i = 0; i < nrhs; i++) {
+        const halide_filter_argument_t *arg_metadata = &metadata->arguments[i];
+
+        if (arg_metadata->kind == halide_argument_kind_output_buffer) {
+            halide_copy_to_host(user_context, (halide_buffer_t *)args[i]);
+        }
+        if (arg_metadata->kind == halide_argument_kind_input_buffer ||
+            arg_metadata->kind == halide_argument_kind_output_buffer) {
+            halide_device_free(user_context, (halide_buffer_t *)args[i]);
+        }
+    }
+
+    return result;
+}
+
 }  // extern "C"
@@ -210,6 +210,13 @@ struct module_state {
 };
 WEAK module_state *state_list = NULL;
 
+// The command buffer dispatches are encoded into. It is committed
+// lazily, at the next sync point, so that back-to-back kernel
+// launches within one pipeline invocation share a single command
+// buffer and a single commit instead of paying for one per dispatch.
+// Guarded by the context lock.
+WEAK mtl_command_buffer *pending_command_buffer = NULL;
+
 // API Capabilities.  If more capabilities need to be checked,
 // this can be refactored to something more robust/general.
 WEAK bool metal_api_supports_set_bytes;
@@ -337,6 +344,36 @@ WEAK command_buffer_completed_handler_block_literal command_buffer_completed_han
     &command_buffer_completed_handler_descriptor
 };
 
+// Return the command buffer new dispatches should be encoded into,
+// creating one if there isn't one pending. Must be called with the
+// context held. The buffer is retained as it has to survive the
+// autorelease pool of the call that created it; the matching release
+// happens when it is committed.
+WEAK mtl_command_buffer *get_pending_command_buffer(mtl_command_queue *queue) {
+    if (pending_command_buffer == NULL) {
+        mtl_command_buffer *command_buffer = new_command_buffer(queue);
+        if (command_buffer == NULL) {
+            return NULL;
+        }
+        retain_ns_object(command_buffer);
+        add_command_buffer_completed_handler(command_buffer, &command_buffer_completed_handler_block);
+        pending_command_buffer = command_buffer;
+    }
+    return pending_command_buffer;
+}
+
+// Commit any dispatches encoded since the last sync point. Does not
+// wait for them: the command queue is serial, so anything committed
+// here is complete by the time a later command buffer on the same
+// queue completes.
+WEAK void commit_pending_command_buffer() {
+    if (pending_command_buffer != NULL) {
+        commit_command_buffer(pending_command_buffer);
+        release_ns_object(pending_command_buffer);
+        pending_command_buffer = NULL;
+    }
+}
+
 }}}} // namespace Halide::Runtime::Internal::Metal
 
 using namespace Halide::Runtime::Internal::Metal;
@@ -466,6 +503,8 @@ WEAK int halide_metal_initialize_kernels(void *user_context, void **state_ptr, c
 namespace {
 
 inline void halide_metal_device_sync_internal(mtl_command_queue *queue, struct halide_buffer_t *buffer) {
+    // Flush any dispatches that are still waiting on a sync point.
+    commit_pending_command_buffer();
     mtl_command_buffer *sync_command_buffer = new_command_buffer(queue);
     if (buffer != NULL) {
         mtl_buffer *metal_buffer = (mtl_buffer *)buffer->device;
@@ -631,7 +670,8 @@ WEAK int halide_metal_run(void *user_context,
                            int num_attributes,
                            float* vertex_buffer,
                            int num_coords_dim0,
-                           int num_coords_dim1) {
+                           int num_coords_dim1,
+                           void **run_state) {
     #ifdef DEBUG_RUNTIME
     uint64_t t_before = halide_current_time_ns(user_context);
     #endif
@@ -641,7 +681,7 @@ WEAK int halide_metal_run(void *user_context,
         return metal_context.error;
     }
 
-    mtl_command_buffer *command_buffer = new_command_buffer(metal_context.queue);
+    mtl_command_buffer *command_buffer = get_pending_command_buffer(metal_context.queue);
     if (command_buffer == 0) {
         error(user_context) << "Metal: Could not allocate command buffer.\n";
         return -1;
@@ -659,6 +699,9 @@ WEAK int halide_metal_run(void *user_context,
     mtl_function *function = new_function_with_name(state->library, entry_name, strlen(entry_name));
     if (function == 0) {
         error(user_context) << "Metal: Could not get function " << entry_name << "from Metal library.\n";
+        // The command buffer is shared with later dispatches; leave
+        // it usable by closing our encoder before bailing out.
+        end_encoding(encoder);
         return -1;
     }
 
@@ -666,6 +709,7 @@ WEAK int halide_metal_run(void *user_context,
     if (pipeline_state == 0) {
         error(user_context) << "Metal: Could not allocate pipeline state.\n";
         release_ns_object(function);
+        end_encoding(encoder);
         return -1;
     }
     set_compute_pipeline_state(encoder, pipeline_state);
@@ -704,6 +748,7 @@ WEAK int halide_metal_run(void *user_context,
                 error(user_context) << "Metal: Could not allocate arguments buffer.\n";
                 release_ns_object(pipeline_state);
                 release_ns_object(function);
+                end_encoding(encoder);
                 return -1;
             }
             args_ptr = (char *)buffer_contents(args_buffer);
@@ -752,9 +797,12 @@ WEAK int halide_metal_run(void *user_context,
                           threadsX, threadsY, threadsZ);
     end_encoding(encoder);
 
-    add_command_buffer_completed_handler(command_buffer, &command_buffer_completed_handler_block);
-
-    commit_command_buffer(command_buffer);
+    // The command buffer is deliberately not committed here. It
+    // accumulates the dispatches of the whole pipeline invocation and
+    // is committed at the next sync point (device_sync or a copy back
+    // to the host), so a multi-stage pipeline pays for one commit and
+    // one wait rather than one per kernel launch. The completed
+    // handler was attached when the command buffer was created.
 
     release_ns_object(pipeline_state);
     release_ns_object(function);
@@ -851,7 +899,11 @@ WEAK halide_device_interface_impl_t metal_device_interface_impl = {
     halide_default_device_crop,
     halide_default_device_release_crop,
     halide_metal_wrap_buffer,
-    halide_metal_detach_buffer
+    halide_metal_detach_buffer,
+    NULL,  // device_to_device_copy
+    NULL,  // device_initialize
+    NULL,  // readback_slice
+    NULL,  // readback_fence
 };
 
 WEAK halide_device_interface_t metal_device_interface = {
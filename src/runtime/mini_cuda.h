@@ -217,6 +217,9 @@ typedef struct CUDA_MEMCPY3D_st {
 
 #define CU_POINTER_ATTRIBUTE_CONTEXT 1
 
+#define CU_STREAM_NON_BLOCKING 0x1
+#define CU_EVENT_DISABLE_TIMING 0x2
+
 }}}}
 
 #endif
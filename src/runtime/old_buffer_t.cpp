@@ -63,6 +63,21 @@ WEAK int halide_upgrade_buffer_t(void *user_context, const char *name,
     return 0;
 }
 
+WEAK int halide_upgrade_buffer_t_device_fields(void *user_context, const char *name,
+                                               const buffer_t *old_buf, halide_buffer_t *new_buf) {
+    if (old_buf->dev) {
+        old_dev_wrapper *wrapper = (old_dev_wrapper *)(old_buf->dev);
+        new_buf->device = wrapper->device;
+        new_buf->device_interface = wrapper->interface;
+    } else {
+        new_buf->device = 0;
+        new_buf->device_interface = NULL;
+    }
+    new_buf->set_host_dirty(old_buf->host_dirty);
+    new_buf->set_device_dirty(old_buf->dev_dirty);
+    return 0;
+}
+
 WEAK int halide_downgrade_buffer_t(void *user_context, const char *name,
                                    const halide_buffer_t *new_buf, buffer_t *old_buf) {
     memset(old_buf, 0, sizeof(buffer_t));
@@ -84,6 +84,10 @@ WEAK char device_type[256];
 WEAK int device_type_lock = 0;
 WEAK bool device_type_initialized = false;
 
+WEAK char program_cache_dir[512];
+WEAK int program_cache_dir_lock = 0;
+WEAK bool program_cache_dir_initialized = false;
+
 }}}} // namespace Halide::Runtime::Internal::OpenCL
 
 using namespace Halide::Runtime::Internal::OpenCL;
@@ -130,6 +134,24 @@ WEAK const char *halide_opencl_get_device_type(void *user_context) {
     return device_type;
 }
 
+WEAK void halide_opencl_set_program_cache_dir(const char *n) {
+    if (n) {
+        strncpy(program_cache_dir, n, 511);
+    } else {
+        program_cache_dir[0] = 0;
+    }
+    program_cache_dir_initialized = true;
+}
+
+WEAK const char *halide_opencl_get_program_cache_dir(void *user_context) {
+    ScopedSpinLock lock(&program_cache_dir_lock);
+    if (!program_cache_dir_initialized) {
+        const char *name = getenv("HL_OCL_PROGRAM_CACHE_DIR");
+        halide_opencl_set_program_cache_dir(name);
+    }
+    return program_cache_dir;
+}
+
 // The default implementation of halide_acquire_cl_context uses the global
 // pointers above, and serializes access with a spin lock.
 // Overriding implementations of acquire/release must implement the following
@@ -505,6 +527,184 @@ WEAK int halide_opencl_device_free(void *user_context, halide_buffer_t* buf) {
 }
 
 
+namespace {
+
+const uint64_t kFnv1aOffsetBasis = 0xcbf29ce484222325ULL;
+
+// 64-bit FNV-1a, used to key the on-disk program binary cache.
+uint64_t fnv1a_hash_64(const uint8_t *key, size_t len, uint64_t h) {
+    for (size_t i = 0; i < len; i++) {
+        h ^= key[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// On-disk header preceding a cached program binary. The hashes are
+// repeated inside the file so that a filename collision can't hand a
+// binary to the wrong source or device.
+struct program_binary_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t src_hash;
+    uint64_t dev_hash;
+    uint64_t binary_size;
+};
+const uint32_t kProgramBinaryMagic = 0x484c434c; // "HLCL"
+const uint32_t kProgramBinaryVersion = 1;
+
+// Hash together everything a compiled binary is specific to besides
+// the source: the device, the driver that compiled it, and the build
+// options.
+bool device_build_hash(void *user_context, cl_device_id dev, const char *options, uint64_t *hash) {
+    char device_name[256];
+    char driver_version[256];
+    if (clGetDeviceInfo(dev, CL_DEVICE_NAME, sizeof(device_name), device_name, NULL) != CL_SUCCESS ||
+        clGetDeviceInfo(dev, CL_DRIVER_VERSION, sizeof(driver_version), driver_version, NULL) != CL_SUCCESS) {
+        return false;
+    }
+    uint64_t h = kFnv1aOffsetBasis;
+    h = fnv1a_hash_64((const uint8_t *)device_name, strlen(device_name) + 1, h);
+    h = fnv1a_hash_64((const uint8_t *)driver_version, strlen(driver_version) + 1, h);
+    h = fnv1a_hash_64((const uint8_t *)options, strlen(options), h);
+    *hash = h;
+    return true;
+}
+
+// Writes dir + "/" + 32 hex digits of the two hashes + suffix into
+// buf. Returns false if it doesn't fit.
+bool program_binary_path(char *buf, size_t buf_size, const char *dir,
+                         uint64_t src_hash, uint64_t dev_hash, const char *suffix) {
+    size_t dir_len = strlen(dir);
+    size_t suffix_len = strlen(suffix);
+    if (dir_len + 1 + 32 + suffix_len + 1 > buf_size) {
+        return false;
+    }
+    char *dst = buf;
+    memcpy(dst, dir, dir_len);
+    dst += dir_len;
+    *dst++ = '/';
+    uint64_t hashes[] = {src_hash, dev_hash};
+    for (int i = 0; i < 2; i++) {
+        for (int j = 15; j >= 0; j--) {
+            int nibble = (int)((hashes[i] >> (j * 4)) & 0xf);
+            *dst++ = (nibble < 10) ? ('0' + nibble) : ('a' + (nibble - 10));
+        }
+    }
+    memcpy(dst, suffix, suffix_len + 1);
+    return true;
+}
+
+// Creates and builds a program from a cached binary. Returns NULL if
+// there is no usable cached binary for this source/device/driver, in
+// which case the caller compiles from source as usual.
+cl_program create_program_from_cached_binary(void *user_context, cl_context context,
+                                             cl_device_id dev, const char *path,
+                                             uint64_t src_hash, uint64_t dev_hash) {
+    void *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    cl_program program = NULL;
+    uint8_t *binary = NULL;
+    do {
+        program_binary_header header;
+        if (fread(&header, sizeof(header), 1, f) != 1 ||
+            header.magic != kProgramBinaryMagic ||
+            header.version != kProgramBinaryVersion ||
+            header.src_hash != src_hash ||
+            header.dev_hash != dev_hash ||
+            header.binary_size == 0) {
+            break;
+        }
+
+        binary = (uint8_t *)malloc((size_t)header.binary_size);
+        if (binary == NULL ||
+            fread(binary, 1, (size_t)header.binary_size, f) != (size_t)header.binary_size) {
+            break;
+        }
+
+        const unsigned char *binaries[] = {binary};
+        size_t lengths[] = {(size_t)header.binary_size};
+        cl_int status = CL_SUCCESS;
+        cl_int err = CL_SUCCESS;
+        program = clCreateProgramWithBinary(context, 1, &dev, lengths, binaries, &status, &err);
+        if (err != CL_SUCCESS || status != CL_SUCCESS) {
+            program = NULL;
+            break;
+        }
+
+        // Building a binary program just finalizes it; a driver that
+        // rejects a stale binary fails here and we fall back to source.
+        cl_device_id devices[] = {dev};
+        err = clBuildProgram(program, 1, devices, NULL, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            clReleaseProgram(program);
+            program = NULL;
+            break;
+        }
+        debug(user_context) << "    loaded cached program binary from " << path << "\n";
+    } while (0);
+
+    if (binary != NULL) {
+        free(binary);
+    }
+    fclose(f);
+    return program;
+}
+
+// Writes the binary of a successfully built program to the cache
+// directory. Failures are silent: the cache is strictly an
+// optimization and the program is already built.
+void store_program_binary(void *user_context, cl_program program, const char *dir,
+                          uint64_t src_hash, uint64_t dev_hash) {
+    char path[1024], tmp_path[1024];
+    if (!program_binary_path(path, sizeof(path), dir, src_hash, dev_hash, ".clbin") ||
+        !program_binary_path(tmp_path, sizeof(tmp_path), dir, src_hash, dev_hash, ".clbin.tmp")) {
+        return;
+    }
+
+    size_t binary_size = 0;
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(binary_size), &binary_size, NULL) != CL_SUCCESS ||
+        binary_size == 0) {
+        return;
+    }
+    uint8_t *binary = (uint8_t *)malloc(binary_size);
+    if (binary == NULL) {
+        return;
+    }
+    uint8_t *binaries[] = {binary};
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binaries), binaries, NULL) != CL_SUCCESS) {
+        free(binary);
+        return;
+    }
+
+    void *f = fopen(tmp_path, "wb");
+    if (f == NULL) {
+        free(binary);
+        return;
+    }
+    program_binary_header header;
+    header.magic = kProgramBinaryMagic;
+    header.version = kProgramBinaryVersion;
+    header.src_hash = src_hash;
+    header.dev_hash = dev_hash;
+    header.binary_size = binary_size;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(binary, 1, binary_size, f) == binary_size;
+    fclose(f);
+    free(binary);
+    if (ok) {
+        rename(tmp_path, path);
+        debug(user_context) << "    stored program binary to " << path << "\n";
+    } else {
+        remove(tmp_path);
+    }
+}
+
+}
+
 WEAK int halide_opencl_initialize_kernels(void *user_context, void **state_ptr, const char* src, int size) {
     debug(user_context)
         << "CL: halide_opencl_init_kernels (user_context: " << user_context
@@ -571,41 +771,65 @@ WEAK int halide_opencl_initialize_kernels(void *user_context, void **state_ptr,
         options << "-D MAX_CONSTANT_BUFFER_SIZE=" << max_constant_buffer_size
                 << " -D MAX_CONSTANT_ARGS=" << max_constant_args;
 
-        const char * sources[] = { src };
-        debug(user_context) << "    clCreateProgramWithSource -> ";
-        cl_program program = clCreateProgramWithSource(ctx.context, 1, &sources[0], NULL, &err );
-        if (err != CL_SUCCESS) {
-            debug(user_context) << get_opencl_error_name(err) << "\n";
-            error(user_context) << "CL: clCreateProgramWithSource failed: "
-                                << get_opencl_error_name(err);
-            return err;
-        } else {
-            debug(user_context) << (void *)program << "\n";
+        // If a program cache directory is set, look for a binary left
+        // by a previous run of these kernels on this device and
+        // driver before compiling from source.
+        const char *cache_dir = halide_opencl_get_program_cache_dir(user_context);
+        uint64_t src_hash = 0, dev_hash = 0;
+        bool cache_usable = false;
+        if (cache_dir[0]) {
+            src_hash = fnv1a_hash_64((const uint8_t *)src, size, kFnv1aOffsetBasis);
+            cache_usable = device_build_hash(user_context, dev, options.str(), &dev_hash);
+        }
+        if (cache_usable) {
+            char path[1024];
+            if (program_binary_path(path, sizeof(path), cache_dir, src_hash, dev_hash, ".clbin")) {
+                (*state)->program = create_program_from_cached_binary(user_context, ctx.context, dev,
+                                                                      path, src_hash, dev_hash);
+            }
         }
-        (*state)->program = program;
-
-        debug(user_context) << "    clBuildProgram " << (void *)program
-                            << " " << options.str() << "\n";
-        err = clBuildProgram(program, 1, devices, options.str(), NULL, NULL );
-        if (err != CL_SUCCESS) {
 
-            // Allocate an appropriately sized buffer for the build log.
-            char buffer[8192];
-
-            // Get build log
-            if (clGetProgramBuildInfo(program, dev,
-                                      CL_PROGRAM_BUILD_LOG,
-                                      sizeof(buffer), buffer,
-                                      NULL) == CL_SUCCESS) {
-                error(user_context) << "CL: clBuildProgram failed: "
-                                    << get_opencl_error_name(err)
-                                    << "\nBuild Log:\n"
-                                    << buffer << "\n";
+        if (!(*state)->program) {
+            const char * sources[] = { src };
+            debug(user_context) << "    clCreateProgramWithSource -> ";
+            cl_program program = clCreateProgramWithSource(ctx.context, 1, &sources[0], NULL, &err );
+            if (err != CL_SUCCESS) {
+                debug(user_context) << get_opencl_error_name(err) << "\n";
+                error(user_context) << "CL: clCreateProgramWithSource failed: "
+                                    << get_opencl_error_name(err);
+                return err;
             } else {
-                error(user_context) << "clGetProgramBuildInfo failed";
+                debug(user_context) << (void *)program << "\n";
             }
+            (*state)->program = program;
 
-            return err;
+            debug(user_context) << "    clBuildProgram " << (void *)program
+                                << " " << options.str() << "\n";
+            err = clBuildProgram(program, 1, devices, options.str(), NULL, NULL );
+            if (err != CL_SUCCESS) {
+
+                // Allocate an appropriately sized buffer for the build log.
+                char buffer[8192];
+
+                // Get build log
+                if (clGetProgramBuildInfo(program, dev,
+                                          CL_PROGRAM_BUILD_LOG,
+                                          sizeof(buffer), buffer,
+                                          NULL) == CL_SUCCESS) {
+                    error(user_context) << "CL: clBuildProgram failed: "
+                                        << get_opencl_error_name(err)
+                                        << "\nBuild Log:\n"
+                                        << buffer << "\n";
+                } else {
+                    error(user_context) << "clGetProgramBuildInfo failed";
+                }
+
+                return err;
+            }
+
+            if (cache_usable) {
+                store_program_binary(user_context, program, cache_dir, src_hash, dev_hash);
+            }
         }
     }
 
@@ -891,7 +1115,8 @@ WEAK int halide_opencl_run(void *user_context,
                            int num_attributes,
                            float* vertex_buffer,
                            int num_coords_dim0,
-                           int num_coords_dim1) {
+                           int num_coords_dim1,
+                           void **run_state) {
     debug(user_context)
         << "CL: halide_opencl_run (user_context: " << user_context << ", "
         << "entry: " << entry_name << ", "
@@ -1053,6 +1278,16 @@ WEAK uintptr_t halide_opencl_get_cl_mem(void *user_context, halide_buffer_t *buf
     return (uintptr_t)buf->device;
 }
 
+WEAK int halide_opencl_device_initialize(void *user_context) {
+    debug(user_context)
+        << "CL: halide_opencl_device_initialize (user_context: " << user_context << ")\n";
+
+    // Acquiring the context creates it (and the command queue, and
+    // loads libOpenCL) if this is the first use.
+    ClContext ctx(user_context);
+    return ctx.error;
+}
+
 WEAK int halide_opencl_device_crop(void *user_context,
                                     const struct halide_buffer_t *src,
                                     struct halide_buffer_t *dst) {
@@ -1170,6 +1405,10 @@ WEAK halide_device_interface_impl_t opencl_device_interface_impl = {
     halide_opencl_device_release_crop,
     halide_opencl_wrap_cl_mem,
     halide_opencl_detach_cl_mem,
+    NULL,  // device_to_device_copy
+    halide_opencl_device_initialize,
+    NULL,  // readback_slice
+    NULL,  // readback_fence
 };
 
 WEAK halide_device_interface_t opencl_device_interface = {
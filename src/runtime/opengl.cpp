@@ -1327,7 +1327,8 @@ WEAK int halide_opengl_run(void *user_context,
                            int num_padded_attributes,
                            float* vertex_buffer,
                            int num_coords_dim0,
-                           int num_coords_dim1) {
+                           int num_coords_dim1,
+                           void **run_state) {
     if (!global_state.initialized) {
         error(user_context) << "OpenGL runtime not initialized (halide_opengl_run).";
         return 1;
@@ -2054,7 +2055,11 @@ WEAK halide_device_interface_impl_t opengl_device_interface_impl = {
     halide_default_device_crop,
     halide_default_device_release_crop,
     halide_opengl_wrap_texture,
-    halide_opengl_detach_texture
+    halide_opengl_detach_texture,
+    NULL,  // device_to_device_copy
+    NULL,  // device_initialize
+    NULL,  // readback_slice
+    NULL,  // readback_fence
 };
 
 WEAK halide_device_interface_t opengl_device_interface = {
@@ -427,7 +427,7 @@ WEAK int halide_openglcompute_run(void *user_context, void *state_ptr,
                        int shared_mem_bytes, size_t arg_sizes[], void *args[],
                        int8_t arg_is_buffer[], int num_attributes,
                        float *vertex_buffer, int num_coords_dim0,
-                       int num_coords_dim1) {
+                       int num_coords_dim1, void **run_state) {
 #ifdef DEBUG_RUNTIME
     uint64_t t_before = halide_current_time_ns(user_context);
 #endif
@@ -688,6 +688,10 @@ WEAK halide_device_interface_impl_t openglcompute_device_interface_impl = {
     halide_default_device_release_crop,
     halide_default_device_wrap_native,
     halide_default_device_detach_native,
+    NULL,  // device_to_device_copy
+    NULL,  // device_initialize
+    NULL,  // readback_slice
+    NULL,  // readback_fence
 };
 
 
@@ -8,4 +8,12 @@ WEAK int halide_host_cpu_count() {
     return sysconf(58);
 }
 
+WEAK int halide_host_cpu_count_of_class(int core_class) {
+    // No way to tell core types apart here; every cpu counts as big.
+    if (core_class == halide_cpu_core_little) {
+        return 0;
+    }
+    return halide_host_cpu_count();
+}
+
 }
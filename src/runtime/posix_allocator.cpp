@@ -1,27 +1,205 @@
 #include "HalideRuntime.h"
 #include "runtime_internal.h"
+#include "scoped_mutex_lock.h"
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// A bounded pool of freed allocations, so pipelines that realize many
+// same-shaped intermediates per second recycle their temporary
+// buffers instead of paying for a malloc/free pair per realization.
+// Freed blocks are kept on an MRU-first free list (embedded in the
+// block itself) up to a byte budget; when the budget is exceeded the
+// least recently freed blocks are returned to the system. The budget
+// defaults to zero (pooling off) and is set with
+// halide_set_allocation_pool_size or the HL_ALLOCATION_POOL_SIZE
+// environment variable.
+struct AllocationPoolEntry {
+    AllocationPoolEntry *next;
+};
+
+WEAK halide_mutex allocation_pool_lock = { { 0 } };
+WEAK AllocationPoolEntry *allocation_pool_head = NULL;
+// -1 means the environment hasn't been consulted yet.
+WEAK int64_t allocation_pool_capacity = -1;
+WEAK int64_t allocation_pool_held = 0;
+
+// The usable size of a block, stored one word below the original
+// malloc pointer slot. See halide_default_malloc for the layout.
+WEAK __attribute((always_inline)) size_t &block_size(void *ptr) {
+    return ((size_t *)ptr)[-2];
+}
+
+// On Linux, blocks of a huge page or more are mapped directly and
+// advised MADV_HUGEPAGE, so large intermediates don't pay a 4K
+// page-fault storm and the TLB pressure that goes with it on every
+// realization. The mmap constants below hold for the Linux
+// architectures we target here; other platforms just use malloc.
+#if defined(__linux__) && \
+    (defined(__x86_64__) || defined(__i386__) || \
+     defined(__arm__) || defined(__aarch64__))
+#define HALIDE_ALLOCATOR_HUGE_PAGES
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define PROT_READ 1
+#define PROT_WRITE 2
+#define MAP_PRIVATE 2
+#define MAP_ANONYMOUS 0x20
+#define MADV_HUGEPAGE 14
+#define MADV_DONTNEED 4
+
+WEAK __attribute((always_inline)) bool block_uses_huge_pages(size_t x) {
+    return x >= (size_t)HUGE_PAGE_SIZE;
+}
+
+// The length of the mapping backing a block of usable size x. Must be
+// recomputable at free time from the stored block size.
+WEAK size_t huge_mapping_length(size_t x) {
+    size_t header = halide_malloc_alignment() + 2 * sizeof(void *);
+    return (x + header + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+}
+#endif
+
+// Return a block to the system, whichever way it was allocated.
+WEAK void free_block(void *ptr);
+
+// Caller must hold allocation_pool_lock.
+WEAK int64_t allocation_pool_capacity_already_locked() {
+    if (allocation_pool_capacity < 0) {
+        allocation_pool_capacity = 0;
+        char *env = getenv("HL_ALLOCATION_POOL_SIZE");
+        if (env != NULL) {
+            allocation_pool_capacity = atoi(env);
+        }
+    }
+    return allocation_pool_capacity;
+}
+
+}}} // namespace Halide::Runtime::Internal
 
 extern "C" {
 
 extern void *malloc(size_t);
 extern void free(void *);
+#ifdef HALIDE_ALLOCATOR_HUGE_PAGES
+extern void *mmap(void *addr, size_t length, int prot, int flags, int fd, long offset);
+extern int munmap(void *addr, size_t length);
+extern int madvise(void *addr, size_t length, int advice);
+#endif
+
+} // extern "C"
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+WEAK void free_block(void *ptr) {
+#ifdef HALIDE_ALLOCATOR_HUGE_PAGES
+    size_t size = block_size(ptr);
+    if (block_uses_huge_pages(size)) {
+        munmap(((void **)ptr)[-1], huge_mapping_length(size));
+        return;
+    }
+#endif
+    free(((void **)ptr)[-1]);
+}
+
+}}} // namespace Halide::Runtime::Internal
+
+extern "C" {
 
 WEAK void *halide_default_malloc(void *user_context, size_t x) {
-    // Allocate enough space for aligning the pointer we return.
+    {
+        ScopedMutexLock lock(&allocation_pool_lock);
+        if (allocation_pool_capacity_already_locked() > 0) {
+            // Reuse the most recently freed block that fits without
+            // wasting more than half its space.
+            AllocationPoolEntry **prev_ptr = &allocation_pool_head;
+            for (AllocationPoolEntry *entry = allocation_pool_head;
+                 entry != NULL;
+                 prev_ptr = &entry->next, entry = entry->next) {
+                size_t entry_size = block_size(entry);
+                if (entry_size >= x && entry_size <= x * 2) {
+                    *prev_ptr = entry->next;
+                    allocation_pool_held -= entry_size;
+                    return entry;
+                }
+            }
+        }
+    }
+
+    // Allocate enough space for aligning the pointer we return, plus
+    // two header words: the original pointer and the usable size.
     const size_t alignment = halide_malloc_alignment();
-    void *orig = malloc(x + alignment);
+    void *orig = NULL;
+#ifdef HALIDE_ALLOCATOR_HUGE_PAGES
+    if (block_uses_huge_pages(x)) {
+        size_t length = huge_mapping_length(x);
+        orig = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (orig == (void *)(-1)) {
+            // Out of memory. No malloc fallback: free_block
+            // dispatches on the block size, so a large block must
+            // always be mmap-backed. Will result in a failed
+            // assertion and a call to halide_error.
+            return NULL;
+        }
+        // Advisory: if transparent huge pages are disabled this just
+        // fails and we keep the 4K mapping.
+        madvise(orig, length, MADV_HUGEPAGE);
+    } else
+#endif
+    {
+        orig = malloc(x + alignment + 2 * sizeof(void*));
+    }
     if (orig == NULL) {
         // Will result in a failed assertion and a call to halide_error
         return NULL;
     }
-    // We want to store the original pointer prior to the pointer we return.
-    void *ptr = (void *)(((size_t)orig + alignment + sizeof(void*) - 1) & ~(alignment - 1));
+    void *ptr = (void *)(((size_t)orig + alignment + 2 * sizeof(void*) - 1) & ~(alignment - 1));
     ((void **)ptr)[-1] = orig;
+    block_size(ptr) = x;
     return ptr;
 }
 
 WEAK void halide_default_free(void *user_context, void *ptr) {
-    free(((void**)ptr)[-1]);
+    {
+        ScopedMutexLock lock(&allocation_pool_lock);
+        int64_t capacity = allocation_pool_capacity_already_locked();
+        size_t size = block_size(ptr);
+        // Blocks too small to hold a free list entry go straight back
+        // to the system.
+        if (capacity > 0 && size >= sizeof(AllocationPoolEntry)) {
+            AllocationPoolEntry *entry = (AllocationPoolEntry *)ptr;
+            entry->next = allocation_pool_head;
+            allocation_pool_head = entry;
+            allocation_pool_held += size;
+
+            // Drop the least recently freed blocks until we fit.
+            while (allocation_pool_held > capacity &&
+                   allocation_pool_head != NULL) {
+                AllocationPoolEntry **prev_ptr = &allocation_pool_head;
+                while ((*prev_ptr)->next != NULL) {
+                    prev_ptr = &(*prev_ptr)->next;
+                }
+                AllocationPoolEntry *victim = *prev_ptr;
+                *prev_ptr = NULL;
+                allocation_pool_held -= block_size(victim);
+                free_block(victim);
+            }
+            return;
+        }
+    }
+    free_block(ptr);
+}
+
+WEAK void halide_set_allocation_pool_size(int64_t size) {
+    ScopedMutexLock lock(&allocation_pool_lock);
+    allocation_pool_capacity = size;
+    while (allocation_pool_held > allocation_pool_capacity &&
+           allocation_pool_head != NULL) {
+        AllocationPoolEntry *victim = allocation_pool_head;
+        allocation_pool_head = victim->next;
+        allocation_pool_held -= block_size(victim);
+        free_block(victim);
+    }
 }
 
 }
@@ -55,4 +233,31 @@ WEAK void halide_free(void *user_context, void *ptr) {
     custom_free(user_context, ptr);
 }
 
+WEAK int halide_release_allocation_prefix(void *user_context, void *ptr, uint64_t bytes) {
+#ifdef HALIDE_ALLOCATOR_HUGE_PAGES
+    // The hint only makes sense for blocks with our header, which a
+    // custom allocator's blocks don't have.
+    if (custom_malloc != halide_default_malloc ||
+        custom_free != halide_default_free) {
+        return 0;
+    }
+    size_t size = block_size(ptr);
+    if (!block_uses_huge_pages(size)) {
+        return 0;
+    }
+    if (bytes > size) {
+        bytes = size;
+    }
+    // Release whole huge pages only, so the rest of the mapping keeps
+    // its huge pages; the partially dead page at each end stays
+    // resident.
+    size_t begin = ((size_t)ptr + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+    size_t end = ((size_t)ptr + (size_t)bytes) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+    if (begin < end) {
+        madvise((void *)begin, end - begin, MADV_DONTNEED);
+    }
+#endif
+    return 0;
+}
+
 }
@@ -29,6 +29,10 @@ extern int pthread_mutex_lock(halide_mutex *mutex);
 extern int pthread_mutex_unlock(halide_mutex *mutex);
 extern int pthread_mutex_destroy(halide_mutex *mutex);
 
+// This module only ships on Linux and Android, where
+// sched_setaffinity is available. Pid 0 means the calling thread.
+extern int sched_setaffinity(int pid, size_t cpusetsize, const unsigned long *mask);
+
 } // extern "C"
 
 namespace Halide { namespace Runtime { namespace Internal {
@@ -62,6 +66,19 @@ WEAK void halide_join_thread(struct halide_thread *thread_arg) {
     free(t);
 }
 
+WEAK int halide_pin_thread_to_cpu(int cpu) {
+    // Room for 512 logical cpus on 32-bit systems, 1024 on 64-bit,
+    // matching the libc cpu_set_t.
+    unsigned long mask[16];
+    memset(mask, 0, sizeof(mask));
+    const int bits_per_word = 8 * sizeof(unsigned long);
+    if (cpu < 0 || cpu >= (int)(sizeof(mask) * 8)) {
+        return -1;
+    }
+    mask[cpu / bits_per_word] |= 1UL << (cpu % bits_per_word);
+    return sched_setaffinity(0, sizeof(mask), mask);
+}
+
 WEAK void halide_mutex_lock(halide_mutex *mutex) {
     pthread_mutex_lock(mutex);
 }
@@ -45,6 +45,7 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
     p->num_allocs = 0;
     p->active_threads_numerator = 0;
     p->active_threads_denominator = 0;
+    p->specializations = NULL;
     p->funcs = (halide_profiler_func_stats *)malloc(num_funcs * sizeof(halide_profiler_func_stats));
     if (!p->funcs) {
         free(p);
@@ -60,13 +61,17 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
         p->funcs[i].stack_peak = 0;
         p->funcs[i].active_threads_numerator = 0;
         p->funcs[i].active_threads_denominator = 0;
+        p->funcs[i].cache_misses = 0;
+        p->funcs[i].stalled_cycles = 0;
+        p->funcs[i].memory_at_peak = 0;
     }
     s->first_free_id += num_funcs;
     s->pipelines = p;
     return p;
 }
 
-WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int active_threads) {
+WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time,
+                    uint64_t cache_misses, uint64_t stalled_cycles, int active_threads) {
     halide_profiler_pipeline_stats *p_prev = NULL;
     for (halide_profiler_pipeline_stats *p = s->pipelines; p;
          p = (halide_profiler_pipeline_stats *)(p->next)) {
@@ -79,6 +84,8 @@ WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int ac
             }
             halide_profiler_func_stats *f = p->funcs + func_id - p->first_func_id;
             f->time += time;
+            f->cache_misses += cache_misses;
+            f->stalled_cycles += stalled_cycles;
             f->active_threads_numerator += active_threads;
             f->active_threads_denominator += 1;
             p->time += time;
@@ -98,6 +105,13 @@ WEAK void sampling_profiler_thread(void *) {
     // grab the lock
     halide_mutex_lock(&s->lock);
 
+    // If hardware performance counters are available, sample them
+    // alongside the clock and bill the deltas to the current func,
+    // the same way time is billed.
+    uint64_t last_misses = 0, last_stalls = 0;
+    bool have_hw_counters =
+        halide_profiler_read_hw_counters(&last_misses, &last_stalls) == 0;
+
     while (s->current_func != halide_profiler_please_stop) {
 
         uint64_t t1 = halide_current_time_ns(NULL);
@@ -113,12 +127,25 @@ WEAK void sampling_profiler_thread(void *) {
                 active_threads = s->active_threads;
             }
             uint64_t t_now = halide_current_time_ns(NULL);
+            uint64_t delta_misses = 0, delta_stalls = 0;
+            if (have_hw_counters) {
+                uint64_t misses = 0, stalls = 0;
+                if (halide_profiler_read_hw_counters(&misses, &stalls) == 0) {
+                    delta_misses = misses - last_misses;
+                    delta_stalls = stalls - last_stalls;
+                    last_misses = misses;
+                    last_stalls = stalls;
+                } else {
+                    have_hw_counters = false;
+                }
+            }
             if (func == halide_profiler_please_stop) {
                 break;
             } else if (func >= 0) {
-                // Assume all time since I was last awake is due to
-                // the currently running func.
-                bill_func(s, func, t_now - t, active_threads);
+                // Assume all time (and all hardware counter events)
+                // since I was last awake is due to the currently
+                // running func.
+                bill_func(s, func, t_now - t, delta_misses, delta_stalls, active_threads);
             }
             t = t_now;
 
@@ -197,6 +224,48 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
     return p->first_func_id;
 }
 
+WEAK int halide_profiler_specialization_hit(void *pipeline_state,
+                                            const char *func,
+                                            const char *condition) {
+    halide_profiler_pipeline_stats *p_stats = (halide_profiler_pipeline_stats *) pipeline_state;
+
+    // The func and condition strings are global constants unique to
+    // the branch, so they can be compared by pointer. Entries are
+    // only ever pushed onto the front of the list, so it's safe to
+    // walk it without the lock.
+    for (halide_profiler_specialization_stats *s = p_stats->specializations; s;
+         s = (halide_profiler_specialization_stats *)(s->next)) {
+        if (s->func == func && s->condition == condition) {
+            __sync_add_and_fetch(&s->hits, 1);
+            return 0;
+        }
+    }
+
+    // First hit of this branch. Take the lock and re-check, in case
+    // another thread just took the same branch for the first time.
+    halide_profiler_state *state = halide_profiler_get_state();
+    ScopedMutexLock lock(&state->lock);
+    for (halide_profiler_specialization_stats *s = p_stats->specializations; s;
+         s = (halide_profiler_specialization_stats *)(s->next)) {
+        if (s->func == func && s->condition == condition) {
+            __sync_add_and_fetch(&s->hits, 1);
+            return 0;
+        }
+    }
+    halide_profiler_specialization_stats *s =
+        (halide_profiler_specialization_stats *)malloc(sizeof(halide_profiler_specialization_stats));
+    if (!s) {
+        // Not worth failing the pipeline over; just drop the count.
+        return 0;
+    }
+    s->hits = 1;
+    s->func = func;
+    s->condition = condition;
+    s->next = p_stats->specializations;
+    p_stats->specializations = s;
+    return 0;
+}
+
 WEAK void halide_profiler_stack_peak_update(void *user_context,
                                             void *pipeline_state,
                                             uint64_t *f_values) {
@@ -240,17 +309,31 @@ WEAK void halide_profiler_memory_allocate(void *user_context,
     // current desctructor (called on profiler shutdown) does not free the structs
     // unless user specifically calls halide_profiler_reset().
 
+    // Update per-func memory stats first, so that a snapshot taken
+    // at a new pipeline-wide peak below includes this allocation.
+    __sync_add_and_fetch(&f_stats->num_allocs, 1);
+    __sync_add_and_fetch(&f_stats->memory_total, incr);
+    uint64_t f_mem_current = __sync_add_and_fetch(&f_stats->memory_current, incr);
+    sync_compare_max_and_swap(&f_stats->memory_peak, f_mem_current);
+
     // Update per-pipeline memory stats
     __sync_add_and_fetch(&p_stats->num_allocs, 1);
     __sync_add_and_fetch(&p_stats->memory_total, incr);
     uint64_t p_mem_current = __sync_add_and_fetch(&p_stats->memory_current, incr);
     sync_compare_max_and_swap(&p_stats->memory_peak, p_mem_current);
 
-    // Update per-func memory stats
-    __sync_add_and_fetch(&f_stats->num_allocs, 1);
-    __sync_add_and_fetch(&f_stats->memory_total, incr);
-    uint64_t f_mem_current = __sync_add_and_fetch(&f_stats->memory_current, incr);
-    sync_compare_max_and_swap(&f_stats->memory_peak, f_mem_current);
+    if (p_stats->memory_peak == p_mem_current) {
+        // This allocation set a new pipeline-wide high-water mark (or
+        // tied it). Snapshot what each func had live at the time, so
+        // the report can name the co-resident offenders. Like the
+        // counter updates above this is done without the lock; if
+        // several threads race past the peak at once the snapshot
+        // settles on one of the candidate live sets, which is as
+        // accurate as the lock-free counters it copies from anyway.
+        for (int i = 0; i < p_stats->num_funcs; i++) {
+            p_stats->funcs[i].memory_at_peak = p_stats->funcs[i].memory_current;
+        }
+    }
 }
 
 WEAK void halide_profiler_memory_free(void *user_context,
@@ -311,6 +394,19 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
              << "  peak heap usage: " << p->memory_peak << " bytes\n";
         halide_print(user_context, sstr.str());
 
+        // Break the peak down into what each func had live when it
+        // was hit, so it's clear which combination of co-resident
+        // allocations to go after.
+        for (int i = 0; i < p->num_funcs; i++) {
+            halide_profiler_func_stats *fs = p->funcs + i;
+            if (fs->memory_at_peak) {
+                sstr.clear();
+                sstr << "  live at heap peak: " << fs->name
+                     << ": " << fs->memory_at_peak << " bytes\n";
+                halide_print(user_context, sstr.str());
+            }
+        }
+
         bool print_f_states = p->time || p->memory_total;
         if (!print_f_states) {
             for (int i = 0; i < p->num_funcs; i++) {
@@ -332,7 +428,19 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
                 // slot. Only report overhead time if it's non-zero
                 if (i == 0 && fs->time == 0) continue;
 
-                sstr << "  " << fs->name << ": ";
+                // Loop-level entries (from the profile_loops target
+                // feature) have dotted names like "f.s0.y.x"; indent
+                // them under the Func they belong to.
+                int depth = 0;
+                for (const char *c = fs->name; *c; c++) {
+                    depth += (*c == '.');
+                }
+                if (depth > 1) depth--; // "f.s0.x" is one level below "f"
+                sstr << "  ";
+                for (int j = 0; j < depth; j++) {
+                    sstr << " ";
+                }
+                sstr << fs->name << ": ";
                 cursor += 25;
                 while (sstr.size() < cursor) sstr << " ";
 
@@ -377,11 +485,30 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
                 if (fs->stack_peak > 0) {
                     sstr << " stack: " << fs->stack_peak;
                 }
+                if (fs->cache_misses || fs->stalled_cycles) {
+                    sstr << " misses: " << fs->cache_misses
+                         << " stalls: " << fs->stalled_cycles;
+                    if (fs->memory_total && fs->time) {
+                        // Heap bytes allocated per second of func
+                        // time: a rough bandwidth figure for
+                        // interpreting the miss counts.
+                        sstr << " bytes/s: "
+                             << (uint64_t)(fs->memory_total * (1000000000.0 / fs->time));
+                    }
+                }
                 sstr << "\n";
 
                 halide_print(user_context, sstr.str());
             }
         }
+
+        for (halide_profiler_specialization_stats *sp = p->specializations; sp;
+             sp = (halide_profiler_specialization_stats *)(sp->next)) {
+            sstr.clear();
+            sstr << "  " << sp->func << " specialized on " << sp->condition
+                 << ": " << sp->hits << " hits\n";
+            halide_print(user_context, sstr.str());
+        }
     }
 }
 
@@ -404,6 +531,11 @@ WEAK void halide_profiler_reset() {
     while (s->pipelines) {
         halide_profiler_pipeline_stats *p = s->pipelines;
         s->pipelines = (halide_profiler_pipeline_stats *)(p->next);
+        while (p->specializations) {
+            halide_profiler_specialization_stats *sp = p->specializations;
+            p->specializations = (halide_profiler_specialization_stats *)(sp->next);
+            free(sp);
+        }
         free(p->funcs);
         free(p);
     }
@@ -83,6 +83,12 @@ WEAK void halide_default_free(void *user_context, void *ptr) {
     aligned_free(ptr);
 }
 
+WEAK int halide_release_allocation_prefix(void *user_context, void *ptr, uint64_t bytes) {
+    // No way to give individual pages back to QuRT; purely a hint, so
+    // ignore it.
+    return 0;
+}
+
 namespace Halide { namespace Runtime { namespace Internal {
 
 WEAK halide_malloc_t custom_malloc = halide_default_malloc;
@@ -55,6 +55,20 @@ WEAK int _halide_prefetch_2d(const void *ptr, int width_bytes, int height, int s
     //  - A l2fetch with any subfield set to zero cancels all pending prefetches
     //  - The l2fetch starting address must be in mapped memory but the range
     //    prefetched can go into unmapped memory without raising an exception
+    //  - The descriptor fields are 16 bits wide. Prefetching is
+    //    advisory, so clamp oversized requests rather than letting
+    //    the shifts corrupt adjacent fields.
+    if (width_bytes > 0xffff) {
+        width_bytes = 0xffff;
+    }
+    if (stride_bytes > 0xffff) {
+        // The row step can't be expressed; just fetch the first row.
+        height = 1;
+        stride_bytes = width_bytes;
+    }
+    if (height > 0xffff) {
+        height = 0xffff;
+    }
     const int dir = 1;
     uint64_t desc =
         (static_cast<uint64_t>(dir) << 48) |
@@ -56,6 +56,16 @@ WEAK void halide_join_thread(struct halide_thread *thread_arg) {
     free(t);
 }
 
+WEAK int halide_pin_thread_to_cpu(int cpu) {
+    // QuRT manages hardware thread placement itself.
+    return -1;
+}
+
+WEAK int halide_pin_thread_to_core_class(int core_class) {
+    // QuRT manages hardware thread placement itself.
+    return -1;
+}
+
 WEAK void halide_mutex_lock(halide_mutex *mutex) {
     qurt_mutex_lock((qurt_mutex_t *)mutex);
 }
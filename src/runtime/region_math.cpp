@@ -0,0 +1,90 @@
+#include "HalideRuntime.h"
+
+// Region math for code that distributes a pipeline across workers:
+// shard an output region, intersect and union the per-shard regions
+// the bounds query reports, and size the transfers. Regions are
+// arrays of halide_dimension_t, the same representation the
+// bounds-query protocol uses in halide_buffer_t::dim; only min and
+// extent are meaningful here, strides are ignored.
+
+extern "C" {
+
+WEAK void halide_region_shard(int min, int extent, int num_shards, int shard,
+                              int *shard_min, int *shard_extent) {
+    if (num_shards < 1 || extent < 0) {
+        *shard_min = min;
+        *shard_extent = 0;
+        return;
+    }
+    // Near-equal contiguous pieces; when extent doesn't divide
+    // evenly, the first (extent % num_shards) shards get one extra
+    // iteration, so any shard's extent differs from any other's by at
+    // most one.
+    int base = extent / num_shards;
+    int extra = extent % num_shards;
+    *shard_min = min + shard * base + (shard < extra ? shard : extra);
+    *shard_extent = base + (shard < extra ? 1 : 0);
+}
+
+WEAK bool halide_region_intersect(int dimensions,
+                                  const halide_dimension_t *a,
+                                  const halide_dimension_t *b,
+                                  halide_dimension_t *result) {
+    bool nonempty = true;
+    for (int i = 0; i < dimensions; i++) {
+        int min = a[i].min > b[i].min ? a[i].min : b[i].min;
+        int a_max = a[i].min + a[i].extent;
+        int b_max = b[i].min + b[i].extent;
+        int max = a_max < b_max ? a_max : b_max;
+        result[i].min = min;
+        result[i].extent = max > min ? max - min : 0;
+        result[i].stride = 0;
+        if (result[i].extent == 0) {
+            nonempty = false;
+        }
+    }
+    if (!nonempty) {
+        // An empty intersection in any dimension empties the whole
+        // region; zero all the extents so callers that only test one
+        // dimension still see it.
+        for (int i = 0; i < dimensions; i++) {
+            result[i].extent = 0;
+        }
+    }
+    return nonempty;
+}
+
+WEAK void halide_region_union(int dimensions,
+                              const halide_dimension_t *a,
+                              const halide_dimension_t *b,
+                              halide_dimension_t *result) {
+    for (int i = 0; i < dimensions; i++) {
+        // Bounding box: empty regions are treated as contributing
+        // nothing rather than their (meaningless) min.
+        if (a[i].extent == 0) {
+            result[i] = b[i];
+        } else if (b[i].extent == 0) {
+            result[i] = a[i];
+        } else {
+            int min = a[i].min < b[i].min ? a[i].min : b[i].min;
+            int a_max = a[i].min + a[i].extent;
+            int b_max = b[i].min + b[i].extent;
+            int max = a_max > b_max ? a_max : b_max;
+            result[i].min = min;
+            result[i].extent = max - min;
+        }
+        result[i].stride = 0;
+    }
+}
+
+WEAK uint64_t halide_region_size_bytes(int dimensions,
+                                       const halide_dimension_t *region,
+                                       int bytes_per_element) {
+    uint64_t size = (uint64_t)bytes_per_element;
+    for (int i = 0; i < dimensions; i++) {
+        size *= (uint64_t)region[i].extent;
+    }
+    return size;
+}
+
+}
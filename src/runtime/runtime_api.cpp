@@ -17,6 +17,7 @@
 extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_buffer_copy,
     (void *)&halide_buffer_to_string,
+    (void *)&halide_apply_runtime_profile,
     (void *)&halide_can_use_target_features,
     (void *)&halide_cond_broadcast,
     (void *)&halide_cond_destroy,
@@ -31,7 +32,10 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_cuda_device_interface,
     (void *)&halide_cuda_get_device_ptr,
     (void *)&halide_cuda_initialize_kernels,
+    (void *)&halide_cuda_max_potential_block_size,
+    (void *)&halide_cuda_release_unused_device_allocations,
     (void *)&halide_cuda_run,
+    (void *)&halide_cuda_set_stream,
     (void *)&halide_cuda_wrap_device_ptr,
     (void *)&halide_current_time_ns,
     (void *)&halide_debug_to_file,
@@ -43,12 +47,14 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_device_free_legacy,
     (void *)&halide_device_free_as_destructor,
     (void *)&halide_device_host_nop_free,
+    (void *)&halide_device_initialize,
     (void *)&halide_device_malloc,
     (void *)&halide_device_malloc_legacy,
     (void *)&halide_device_release,
     (void *)&halide_device_sync,
     (void *)&halide_device_sync_legacy,
     (void *)&halide_do_par_for,
+    (void *)&halide_do_parallel_tasks,
     (void *)&halide_do_task,
     (void *)&halide_double_to_string,
     (void *)&halide_downgrade_buffer_t,
@@ -88,9 +94,11 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_get_library_symbol,
     (void *)&halide_get_symbol,
     (void *)&halide_get_trace_file,
+    (void *)&halide_hexagon_begin_rpc_batch,
     (void *)&halide_hexagon_detach_device_handle,
     (void *)&halide_hexagon_device_interface,
     (void *)&halide_hexagon_device_release,
+    (void *)&halide_hexagon_end_rpc_batch,
     (void *)&halide_hexagon_get_device_handle,
     (void *)&halide_hexagon_get_device_size,
     (void *)&halide_hexagon_initialize_kernels,
@@ -106,9 +114,12 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_load_library,
     (void *)&halide_malloc,
     (void *)&halide_matlab_call_pipeline,
+    (void *)&halide_matlab_call_pipeline_raw,
     (void *)&halide_memoization_cache_cleanup,
     (void *)&halide_memoization_cache_lookup,
+    (void *)&halide_memoization_cache_prime,
     (void *)&halide_memoization_cache_release,
+    (void *)&halide_memoization_cache_set_policy,
     (void *)&halide_memoization_cache_set_size,
     (void *)&halide_memoization_cache_store,
     (void *)&halide_metal_acquire_context,
@@ -130,10 +141,12 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_opencl_get_cl_mem,
     (void *)&halide_opencl_get_device_type,
     (void *)&halide_opencl_get_platform_name,
+    (void *)&halide_opencl_get_program_cache_dir,
     (void *)&halide_opencl_initialize_kernels,
     (void *)&halide_opencl_run,
     (void *)&halide_opencl_set_device_type,
     (void *)&halide_opencl_set_platform_name,
+    (void *)&halide_opencl_set_program_cache_dir,
     (void *)&halide_opencl_wrap_cl_mem,
     (void *)&halide_opengl_context_lost,
     (void *)&halide_opengl_create_context,
@@ -148,6 +161,9 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_openglcompute_device_interface,
     (void *)&halide_openglcompute_initialize_kernels,
     (void *)&halide_openglcompute_run,
+    (void *)&halide_pin_thread_to_cpu,
+    (void *)&halide_pin_thread_to_core_class,
+    (void *)&halide_pipeline_warmup,
     (void *)&halide_pointer_to_string,
     (void *)&halide_print,
     (void *)&halide_profiler_get_pipeline_state,
@@ -157,13 +173,25 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_profiler_pipeline_start,
     (void *)&halide_profiler_report,
     (void *)&halide_profiler_reset,
+    (void *)&halide_profiler_read_hw_counters,
+    (void *)&halide_profiler_specialization_hit,
     (void *)&halide_profiler_stack_peak_update,
     (void *)&halide_qurt_hvx_lock,
     (void *)&halide_qurt_hvx_unlock,
     (void *)&halide_qurt_hvx_unlock_as_destructor,
+    (void *)&halide_region_intersect,
+    (void *)&halide_region_shard,
+    (void *)&halide_region_size_bytes,
+    (void *)&halide_region_union,
+    (void *)&halide_release_allocation_prefix,
     (void *)&halide_release_jit_module,
     (void *)&halide_set_custom_can_use_target_features,
+    (void *)&halide_semaphore_acquire,
+    (void *)&halide_semaphore_init,
+    (void *)&halide_semaphore_release,
+    (void *)&halide_semaphore_try_acquire,
     (void *)&halide_set_custom_do_par_for,
+    (void *)&halide_set_custom_do_parallel_tasks,
     (void *)&halide_set_custom_do_task,
     (void *)&halide_set_custom_free,
     (void *)&halide_set_custom_get_library_symbol,
@@ -171,20 +199,31 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_set_custom_load_library,
     (void *)&halide_set_custom_malloc,
     (void *)&halide_set_custom_print,
+    (void *)&halide_define_thread_pool_domain,
+    (void *)&halide_set_allocation_pool_size,
     (void *)&halide_set_custom_trace,
     (void *)&halide_set_error_handler,
     (void *)&halide_set_gpu_device,
     (void *)&halide_set_num_threads,
+    (void *)&halide_set_parallel_inline_extent,
+    (void *)&halide_set_parallel_schedule,
+    (void *)&halide_set_thread_pinning,
+    (void *)&halide_set_thread_pool_core_class,
+    (void *)&halide_set_thread_pool_domain,
     (void *)&halide_set_trace_file,
+    (void *)&halide_set_trace_lossy,
+    (void *)&halide_set_trace_sample_rate,
     (void *)&halide_shutdown_thread_pool,
     (void *)&halide_shutdown_trace,
     (void *)&halide_sleep_ms,
     (void *)&halide_spawn_thread,
     (void *)&halide_start_clock,
     (void *)&halide_string_to_string,
+    (void *)&halide_task_graph_execute,
     (void *)&halide_trace,
     (void *)&halide_trace_helper,
     (void *)&halide_uint64_to_string,
     (void *)&halide_upgrade_buffer_t,
+    (void *)&halide_upgrade_buffer_t_device_fields,
     (void *)&halide_use_jit_module,
 };
@@ -78,8 +78,10 @@ int fileno(void *);
 int fclose(void *);
 int close(int);
 size_t fwrite(const void *, size_t, size_t, void *);
+size_t fread(void *, size_t, size_t, void *);
 ssize_t write(int fd, const void *buf, size_t bytes);
 int remove(const char *pathname);
+int rename(const char *oldpath, const char *newpath);
 int ioctl(int fd, unsigned long request, ...);
 void exit(int);
 void abort();
@@ -147,6 +149,10 @@ WEAK int halide_matlab_call_pipeline(void *user_context,
                                      int (*pipeline)(void **args), const halide_filter_metadata_t *metadata,
                                      int nlhs, mxArray **plhs, int nrhs, const mxArray **prhs);
 
+WEAK int halide_matlab_call_pipeline_raw(void *user_context,
+                                         int (*pipeline)(void **args), const halide_filter_metadata_t *metadata,
+                                         int nrhs, const mxArray **prhs);
+
 
 // Condition variables. Only available on some platforms (those that use the common thread pool).
 struct halide_cond {
@@ -0,0 +1,55 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+#include "printer.h"
+
+// Named bundles of runtime configuration. Each profile sets the
+// thread count, the allocation pool budget, and the memoization
+// cache size together, so a deployment picks a preset with one call
+// instead of wiring up the individual override points per app.
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+struct RuntimeProfile {
+    const char *name;
+    // < 0 means the pool and cache knobs use their defaults below.
+    int num_threads;       // 0 selects the default thread count.
+    int64_t pool_size;     // Passed to halide_set_allocation_pool_size.
+    int64_t cache_size;    // Passed to halide_memoization_cache_set_size.
+};
+
+// Matches kDefaultCacheSize in cache.cpp.
+const int64_t default_cache_size = 1 << 20;
+
+WEAK RuntimeProfile runtime_profiles[] = {
+    // The defaults: thread count from HL_NUM_THREADS or the core
+    // count, no allocation pooling, a small memoization cache.
+    {"default", 0, 0, default_cache_size},
+    // Recycle temporary buffers instead of hitting the system
+    // allocator per realization, so steady-state frames do no
+    // allocation work.
+    {"low-latency", 0, 64 * 1024 * 1024, default_cache_size},
+    // Keep every core busy and let memoized stages keep their
+    // results around; allocation cost amortizes over the batch.
+    {"batch-throughput", 0, 0, 256 * 1024 * 1024},
+};
+
+}}} // namespace Halide::Runtime::Internal
+
+extern "C" {
+
+WEAK int halide_apply_runtime_profile(void *user_context, const char *name) {
+    for (size_t i = 0; i < sizeof(runtime_profiles) / sizeof(runtime_profiles[0]); i++) {
+        const RuntimeProfile &p = runtime_profiles[i];
+        if (strcmp(name, p.name) == 0) {
+            halide_set_num_threads(p.num_threads);
+            halide_set_allocation_pool_size(p.pool_size);
+            halide_memoization_cache_set_size(p.cache_size);
+            return 0;
+        }
+    }
+    error(user_context) << "halide_apply_runtime_profile: unknown profile \""
+                        << name << "\"";
+    return halide_error_code_generic_error;
+}
+
+}
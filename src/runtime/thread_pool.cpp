@@ -13,6 +13,7 @@ WEAK void halide_thread_pool_cleanup() {
 namespace Halide { namespace Runtime { namespace Internal {
 WEAK halide_do_task_t custom_do_task = halide_default_do_task;
 WEAK halide_do_par_for_t custom_do_par_for = halide_default_do_par_for;
+WEAK halide_do_parallel_tasks_t custom_do_parallel_tasks = halide_default_do_parallel_tasks;
 }}}
 
 WEAK halide_do_task_t halide_set_custom_do_task(halide_do_task_t f) {
@@ -37,4 +38,15 @@ WEAK int halide_do_par_for(void *user_context, halide_task_t f,
   return (*custom_do_par_for)(user_context, f, min, size, closure);
 }
 
+WEAK halide_do_parallel_tasks_t halide_set_custom_do_parallel_tasks(halide_do_parallel_tasks_t f) {
+    halide_do_parallel_tasks_t result = custom_do_parallel_tasks;
+    custom_do_parallel_tasks = f;
+    return result;
+}
+
+WEAK int halide_do_parallel_tasks(void *user_context, int num_tasks,
+                                  struct halide_parallel_task_t *tasks) {
+    return (*custom_do_parallel_tasks)(user_context, num_tasks, tasks);
+}
+
 } // extern "C"
@@ -5,43 +5,187 @@ struct work {
     work *next_job;
     int (*f)(void *, int, uint8_t *);
     void *user_context;
+    // The range of tasks not yet claimed by any thread. Protected by
+    // the work queue mutex.
     int next, max;
     uint8_t *closure;
-    int active_workers;
+    // The number of tasks not yet completed. Decremented without the
+    // lock held as tasks finish, so use atomic ops.
+    int tasks_remaining;
+    // Counts the jobs in this job's group (sibling tasks enqueued by
+    // the same call, including this one) that still have tasks
+    // remaining. The owner of the group blocks until it reaches
+    // zero. Protected by the work queue mutex.
+    int *group_remaining;
     int exit_status;
-    bool running() { return next < max || active_workers > 0; }
+    // The halide_parallel_schedule_t in effect when this job was
+    // enqueued.
+    int schedule;
+    // For the static schedule, the fixed chunk size each thread
+    // claims. Unused by the other schedules.
+    int chunk;
+    // The maximum number of workers that may run this job's tasks at
+    // once (0 means no limit), from the thread pool domain in effect
+    // when the job was enqueued.
+    int max_workers;
+    // The halide_cpu_core_class_t workers must run this job's tasks
+    // on, captured when the job was enqueued.
+    int core_class;
+    // The number of workers currently running one of this job's task
+    // ranges. Incremented with the work queue mutex held, decremented
+    // without it, so use atomic ops.
+    int active_workers;
+};
+
+// A contiguous range of task indices belonging to a single job. The
+// unit of transfer between the work queue, the per-worker deques, and
+// thieves.
+struct task_range {
+    work *job;
+    int min, extent;
+};
+
+// A fixed-size Chase-Lev work-stealing deque. The owning worker
+// pushes and pops ranges at the bottom without taking any lock;
+// thieves steal from the top using a compare-and-swap. Entries are
+// small (a job pointer plus a range), and because workers split
+// ranges one iteration at a time (pop one entry, push back the
+// remainder), the depth stays bounded by the number of chunks claimed
+// plus the nesting depth, so a small capacity suffices. On overflow
+// the owner simply runs the range inline.
+#define TASK_DEQUE_SIZE 64
+#define TASK_DEQUE_MASK (TASK_DEQUE_SIZE - 1)
+struct task_deque {
+    // Monotonically increasing logical indices into the ring
+    // buffer. 'top' is the steal end, 'bottom' the owner's end.
+    intptr_t top, bottom;
+    task_range entries[TASK_DEQUE_SIZE];
+
+    // Called by the owning worker only.
+    bool push(const task_range &r) {
+        intptr_t b = __atomic_load_n(&bottom, __ATOMIC_RELAXED);
+        intptr_t t = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+        if (b - t >= TASK_DEQUE_SIZE) {
+            return false;
+        }
+        entries[b & TASK_DEQUE_MASK] = r;
+        __atomic_store_n(&bottom, b + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Called by the owning worker only.
+    bool pop(task_range *r) {
+        intptr_t b = __atomic_load_n(&bottom, __ATOMIC_RELAXED) - 1;
+        __atomic_store_n(&bottom, b, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        intptr_t t = __atomic_load_n(&top, __ATOMIC_RELAXED);
+        if (t < b) {
+            *r = entries[b & TASK_DEQUE_MASK];
+            return true;
+        } else if (t == b) {
+            // Last entry. Race against any thieves for it.
+            *r = entries[b & TASK_DEQUE_MASK];
+            bool won = __atomic_compare_exchange_n(&top, &t, t + 1, false,
+                                                   __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+            __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+            return won;
+        } else {
+            // Empty. Restore bottom.
+            __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    }
+
+    // May be called by any thread.
+    bool steal(task_range *r) {
+        intptr_t t = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        intptr_t b = __atomic_load_n(&bottom, __ATOMIC_ACQUIRE);
+        if (t >= b) {
+            return false;
+        }
+        *r = entries[t & TASK_DEQUE_MASK];
+        return __atomic_compare_exchange_n(&top, &t, t + 1, false,
+                                           __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    }
+};
+
+// A named thread pool domain: parallel loops launched while a domain
+// is selected get its worker budget, so pipelines sharing the process
+// (e.g. a latency-critical preview and a batch exporter) stop
+// fighting over the whole pool.
+#define MAX_POOL_DOMAINS 8
+#define POOL_DOMAIN_NAME_SIZE 32
+struct pool_domain {
+    char name[POOL_DOMAIN_NAME_SIZE];
+    int max_threads;
 };
 
 // The work queue and thread pool is weak, so one big work queue is shared by all halide functions
 #define MAX_THREADS 64
 struct work_queue_t {
-    // all fields are protected by this mutex.
+    // The fields below are all protected by this mutex. Workers only
+    // take it to claim a fresh chunk of iterations from a job, to go
+    // to sleep, or to signal completion; the per-iteration fast path
+    // runs entirely on the lock-free deques.
     halide_mutex mutex;
 
     // Singly linked list for job stack
     work *jobs;
 
-    // Worker threads are divided into an 'A' team and a 'B' team. The
-    // B team sleeps on the wakeup_b_team condition variable. The A
-    // team does work. Threads transition to the B team if they wake
-    // up and find that a_team_size > target_a_team_size.  Threads
-    // move into the A team whenever they wake up and find that
-    // a_team_size < target_a_team_size.
-    int a_team_size, target_a_team_size;
-
     // Broadcast when a job completes.
     halide_cond wakeup_owners;
 
-    // Broadcast whenever items are added to the work queue.
-    halide_cond wakeup_a_team;
+    // Broadcast whenever items are added to the work queue, or when a
+    // worker splits off a stealable range while other workers are
+    // asleep.
+    halide_cond wakeup_workers;
 
-    // May also be broadcast when items are added to the work queue if
-    // more threads are required than are currently in the A team.
-    halide_cond wakeup_b_team;
+    // The number of workers asleep on wakeup_workers. Written with
+    // the lock held; read without it by workers deciding whether a
+    // wakeup broadcast is worth taking the lock for.
+    int sleeping_workers;
 
     // Keep track of threads so they can be joined at shutdown
     halide_thread *threads[MAX_THREADS];
 
+    // One work-stealing deque per worker thread. Owners of jobs
+    // (threads blocked in halide_default_do_par_for) do not have a
+    // deque of their own; they help out by claiming chunks from the
+    // job list and stealing from these.
+    task_deque deques[MAX_THREADS];
+
+    // The halide_parallel_schedule_t applied to newly launched
+    // parallel loops, and whether it was set explicitly (in which
+    // case the HL_PARALLEL_SCHEDULE environment variable is ignored).
+    int schedule;
+    bool schedule_set;
+
+    // The halide_thread_pinning_t applied to newly spawned workers,
+    // and whether it was set explicitly (in which case the
+    // HL_THREAD_PINNING environment variable is ignored).
+    int pinning;
+    bool pinning_set;
+
+    // The halide_cpu_core_class_t applied to newly launched parallel
+    // loops, and whether it was set explicitly (in which case the
+    // HL_THREAD_CORE_CLASS environment variable is ignored).
+    int core_class;
+    bool core_class_set;
+
+    // The core class each worker last applied to itself, so workers
+    // only pay the affinity syscall when consecutive jobs disagree.
+    // Each entry is written and read only by the owning worker.
+    int worker_core_class[MAX_THREADS];
+
+    // The defined thread pool domains, and the one applied to newly
+    // launched parallel loops, stored as index + 1 so that the
+    // zero-initialized state means "none" (no worker cap). Protected
+    // by the mutex.
+    pool_domain domains[MAX_POOL_DOMAINS];
+    int num_domains;
+    int current_domain;
+
     // The number threads created
     int threads_created;
 
@@ -68,6 +212,66 @@ WEAK int clamp_num_threads(int desired_num_threads) {
     return desired_num_threads;
 }
 
+WEAK int clamp_parallel_schedule(int schedule) {
+    if (schedule < halide_parallel_schedule_stealing ||
+        schedule > halide_parallel_schedule_static) {
+        schedule = halide_parallel_schedule_stealing;
+    }
+    return schedule;
+}
+
+WEAK int clamp_thread_pinning(int pinning) {
+    if (pinning < halide_thread_pinning_none ||
+        pinning > halide_thread_pinning_spread) {
+        pinning = halide_thread_pinning_none;
+    }
+    return pinning;
+}
+
+WEAK int clamp_core_class(int core_class) {
+    if (core_class < halide_cpu_core_any ||
+        core_class > halide_cpu_core_little) {
+        core_class = halide_cpu_core_any;
+    }
+    return core_class;
+}
+
+// The logical cpu worker 'id' gets pinned to, for the policies that
+// pin. Cpu 0 is left to the thread that launched the pipeline for as
+// long as possible.
+WEAK int pinned_cpu_for_worker(int id) {
+    int num_cpus = halide_host_cpu_count();
+    if (num_cpus < 1) {
+        num_cpus = 1;
+    }
+    int k = (id + 1) % num_cpus;
+    if (work_queue.pinning == halide_thread_pinning_spread) {
+        // Enumerate even cpus first, then odd ones.
+        int half = (num_cpus + 1) / 2;
+        k = (k < half) ? (2 * k) : (2 * (k - half) + 1);
+    }
+    return k;
+}
+
+// Move a worker onto the core class its current job asks for,
+// re-pinning only when the class differs from the last job it ran. A
+// return to halide_cpu_core_any restores the per-cpu placement of the
+// pinning policy, if one is set. Best-effort: on platforms without
+// affinity support the pin call fails and the job runs wherever the
+// OS put us.
+WEAK void apply_core_class(int worker_id, int core_class) {
+    if (work_queue.worker_core_class[worker_id] == core_class) {
+        return;
+    }
+    work_queue.worker_core_class[worker_id] = core_class;
+    if (core_class == halide_cpu_core_any &&
+        work_queue.pinning != halide_thread_pinning_none) {
+        halide_pin_thread_to_cpu(pinned_cpu_for_worker(worker_id));
+    } else {
+        halide_pin_thread_to_core_class(core_class);
+    }
+}
+
 WEAK int default_desired_num_threads() {
     int desired_num_threads = 0;
     char *threads_str = getenv("HL_NUM_THREADS");
@@ -83,106 +287,299 @@ WEAK int default_desired_num_threads() {
     return desired_num_threads;
 }
 
-WEAK void worker_thread_already_locked(work *owned_job) {
-    // If I'm a job owner, then I was the thread that called
-    // do_par_for, and I should only stay in this function until my
-    // job is complete. If I'm a lowly worker thread, I should stay in
-    // this function as long as the work queue is running.
-    while (owned_job != NULL ? owned_job->running()
-           : work_queue.running()) {
+// Parallel loops with at most this many iterations are run inline on
+// the calling thread instead of being enqueued on the pool: below the
+// crossover, enqueueing the job and waking workers costs more than
+// the iterations themselves. Kept outside work_queue_t (and read with
+// relaxed atomics) so the fast path never has to take the work queue
+// mutex or initialize the pool. -1 means the HL_PARALLEL_INLINE_EXTENT
+// environment variable hasn't been consulted yet; the default is 1,
+// which only short-circuits loops the pool could never help with.
+WEAK int inline_par_for_extent = -1;
 
-        if (work_queue.jobs == NULL) {
-            if (owned_job) {
-                // There are no jobs pending. Wait for the last worker
-                // to signal that the job is finished.
-                halide_cond_wait(&work_queue.wakeup_owners, &work_queue.mutex);
-            } else if (work_queue.a_team_size <= work_queue.target_a_team_size) {
-                // There are no jobs pending. Wait until more jobs are enqueued.
-                halide_cond_wait(&work_queue.wakeup_a_team, &work_queue.mutex);
-            } else {
-                // There are no jobs pending, and there are too many
-                // threads in the A team. Transition to the B team
-                // until the wakeup_b_team condition is fired.
-                work_queue.a_team_size--;
-                halide_cond_wait(&work_queue.wakeup_b_team, &work_queue.mutex);
-                work_queue.a_team_size++;
-            }
-        } else {
-            // Grab the next job.
-            work *job = work_queue.jobs;
+WEAK int par_for_inline_extent() {
+    int e = __atomic_load_n(&inline_par_for_extent, __ATOMIC_RELAXED);
+    if (e < 0) {
+        char *str = getenv("HL_PARALLEL_INLINE_EXTENT");
+        e = str ? atoi(str) : 1;
+        if (e < 0) {
+            e = 0;
+        }
+        __atomic_store_n(&inline_par_for_extent, e, __ATOMIC_RELAXED);
+    }
+    return e;
+}
 
-            // Claim a task from it.
-            work myjob = *job;
-            job->next++;
+// Opt-in tracing of task execution (set HL_TRACE_TASKS): every task
+// run emits begin/end events through halide_trace recording which
+// worker ran which iteration of which loop, timestamped so the trace
+// can be turned into a per-worker timeline and the straggler tasks of
+// a poorly balanced schedule show up visually (see
+// util/HalideTraceToChrome.cpp). Loops are identified by the address
+// of their task function; the loop's name isn't available at this
+// level.
+WEAK bool trace_tasks = false;
 
-            // If there were no more tasks pending for this job,
-            // remove it from the stack.
-            if (job->next == job->max) {
-                work_queue.jobs = job->next_job;
-            }
+WEAK void trace_task(void *user_context, int event_code, work *job,
+                     int idx, int worker_id) {
+    uint64_t now = (uint64_t)halide_current_time_ns(user_context);
+    uint64_t fn = (uint64_t)(uintptr_t)job->f;
+    int32_t coords[4] = {worker_id, idx,
+                         (int32_t)(uint32_t)fn,
+                         (int32_t)(uint32_t)(fn >> 32)};
+    halide_trace_event_t e;
+    e.func = "<thread pool>";
+    e.value = &now;
+    e.coordinates = coords;
+    e.type.code = halide_type_uint;
+    e.type.bits = 64;
+    e.type.lanes = 1;
+    e.event = (halide_trace_event_code_t)event_code;
+    e.parent_id = 0;
+    e.value_index = 0;
+    e.dimensions = 4;
+    halide_trace(user_context, &e);
+}
 
-            // Increment the active_worker count so that other threads
-            // are aware that this job is still in progress even
-            // though there are no outstanding tasks for it.
-            job->active_workers++;
+// Run one task range, splitting one iteration off at a time so that
+// the remainder stays visible to thieves in the given deque. Pass
+// NULL for the deque to run the whole range inline (used by job
+// owners, which don't own a deque). Returns after running at least
+// one iteration. Called with the work queue lock *not* held. 'counted'
+// means the caller already counted us towards the job's active
+// workers (claiming a fresh chunk does, with the lock held, so the
+// worker cap of a capped job is enforced exactly at that point).
+WEAK void run_task_range(task_range r, task_deque *deque, bool counted) {
+    int worker_id = deque ? (int)(deque - work_queue.deques) : -1;
+    if (deque) {
+        // Owners (no deque) are the thread that launched the
+        // pipeline; their placement is left to the caller.
+        apply_core_class(worker_id, r.job->core_class);
+    }
+    if (!counted) {
+        __atomic_add_fetch(&r.job->active_workers, 1, __ATOMIC_ACQ_REL);
+    }
+    // The job lives on its owner's stack frame. Once our final
+    // tasks_remaining decrement below retires the job, the owner may
+    // return and destroy it, so anything we need from the job after
+    // that point must be captured up front, and our exit from the
+    // worker count must happen before that decrement.
+    int max_workers = r.job->max_workers;
+    while (r.extent > 0) {
+        if (r.extent > 1 && deque &&
+            r.job->schedule == halide_parallel_schedule_stealing) {
+            // Keep the tail of the range available to thieves.
+            task_range rest = {r.job, r.min + 1, r.extent - 1};
+            if (deque->push(rest)) {
+                r.extent = 1;
+                // If anyone is asleep, let them know there's
+                // something to steal. The read of sleeping_workers is
+                // racy; a missed wakeup here just means the range
+                // gets drained by the threads already awake.
+                if (__atomic_load_n(&work_queue.sleeping_workers, __ATOMIC_RELAXED) > 0) {
+                    halide_mutex_lock(&work_queue.mutex);
+                    halide_cond_broadcast(&work_queue.wakeup_workers);
+                    halide_mutex_unlock(&work_queue.mutex);
+                }
+            }
+            // If the deque was full, just run the whole range inline.
+        }
 
-            // Release the lock and do the task.
-            halide_mutex_unlock(&work_queue.mutex);
-            int result = halide_do_task(myjob.user_context, myjob.f, myjob.next,
-                                        myjob.closure);
+        if (trace_tasks) {
+            trace_task(r.job->user_context, halide_trace_begin_task,
+                       r.job, r.min, worker_id);
+        }
+        int result = halide_do_task(r.job->user_context, r.job->f, r.min,
+                                    r.job->closure);
+        if (trace_tasks) {
+            trace_task(r.job->user_context, halide_trace_end_task,
+                       r.job, r.min, worker_id);
+        }
+        if (result) {
+            // Ensure the write of the exit status is visible before
+            // the owner can observe the job as finished.
+            r.job->exit_status = result;
+        }
+        if (r.extent == 1) {
+            // We just ran our last iteration, so the tasks_remaining
+            // decrement below may be the one that retires the
+            // job. Drop out of the worker count first; it is not safe
+            // to touch the job outside the lock after the decrement.
+            __atomic_sub_fetch(&r.job->active_workers, 1, __ATOMIC_ACQ_REL);
+        }
+        int remaining = __atomic_sub_fetch(&r.job->tasks_remaining, 1, __ATOMIC_ACQ_REL);
+        if (remaining == 0) {
+            // This was the last task of the job. Retire it from its
+            // group and wake its owner. Holding the lock makes the
+            // group_remaining access safe: the owner cannot observe
+            // the count and return until we release it.
             halide_mutex_lock(&work_queue.mutex);
+            (*r.job->group_remaining)--;
+            halide_cond_broadcast(&work_queue.wakeup_owners);
+            halide_mutex_unlock(&work_queue.mutex);
+        }
+        r.min++;
+        r.extent--;
+    }
+    if (max_workers > 0 &&
+        __atomic_load_n(&work_queue.sleeping_workers, __ATOMIC_RELAXED) > 0) {
+        // We may have freed up a slot on a capped job that a sleeping
+        // worker was waiting on.
+        halide_mutex_lock(&work_queue.mutex);
+        halide_cond_broadcast(&work_queue.wakeup_workers);
+        halide_mutex_unlock(&work_queue.mutex);
+    }
+}
 
-            // If this task failed, set the exit status on the job.
-            if (result) {
-                job->exit_status = result;
-            }
+// The worker cap of the currently selected thread pool domain, or 0
+// if no domain is selected. Called with the work queue lock held.
+WEAK int current_domain_max_workers_already_locked() {
+    int d = work_queue.current_domain;
+    if (d <= 0 || d > work_queue.num_domains) {
+        return 0;
+    }
+    return work_queue.domains[d - 1].max_threads;
+}
 
-            // We are no longer active on this job
-            job->active_workers--;
+// Whether this job will accept another worker right now. Jobs from a
+// capped thread pool domain stop handing out fresh chunks once enough
+// workers are on them. The cap is best-effort: under the stealing
+// schedule, workers already on the job can still fan its ranges out
+// to thieves.
+WEAK bool job_has_capacity(work *job) {
+    return job->max_workers == 0 ||
+           __atomic_load_n(&job->active_workers, __ATOMIC_RELAXED) < job->max_workers;
+}
 
-            // If the job is done and I'm not the owner of it, wake up
-            // the owner.
-            if (!job->running() && job != owned_job) {
-                halide_cond_broadcast(&work_queue.wakeup_owners);
-            }
+// Whether there is any job we could claim a chunk from. Called with
+// the work queue lock held.
+WEAK bool any_claimable_job_already_locked() {
+    for (work *job = work_queue.jobs; job != NULL; job = job->next_job) {
+        if (job_has_capacity(job)) {
+            return true;
         }
     }
+    return false;
 }
 
-WEAK void worker_thread(void *) {
-    halide_mutex_lock(&work_queue.mutex);
-    worker_thread_already_locked(NULL);
-    halide_mutex_unlock(&work_queue.mutex);
-}
+// Claim a chunk of iterations from the job list. Called with the work
+// queue lock held. Returns false if there are no unclaimed iterations
+// anywhere (or every job with some is at its worker cap).
+WEAK bool claim_task_range_already_locked(task_range *r) {
+    work **prev = &work_queue.jobs;
+    work *job = work_queue.jobs;
+    while (job != NULL && !job_has_capacity(job)) {
+        prev = &job->next_job;
+        job = job->next_job;
+    }
+    if (job == NULL) {
+        return false;
+    }
 
-}}}  // namespace Halide::Runtime::Internal
+    int remaining = job->max - job->next;
+    int chunk;
+    if (job->schedule == halide_parallel_schedule_static) {
+        // One fixed-size chunk per thread, computed when the job was
+        // enqueued.
+        chunk = job->chunk;
+    } else {
+        // Claim a chunk sized so that each thread takes the lock O(1)
+        // times per job rather than once per iteration, shrinking
+        // toward the end of the loop so the last chunks can't
+        // straggle badly. Under the stealing schedule the deques take
+        // care of any remaining imbalance.
+        chunk = remaining / (work_queue.desired_num_threads * 2);
+    }
+    if (chunk < 1) chunk = 1;
+    if (chunk > remaining) chunk = remaining;
+    r->job = job;
+    r->min = job->next;
+    r->extent = chunk;
+    job->next += chunk;
 
-using namespace Halide::Runtime::Internal;
+    // Count the claimer towards the job's active workers while we
+    // still hold the lock, so a capped job can't hand out more chunks
+    // than its worker budget.
+    __atomic_add_fetch(&job->active_workers, 1, __ATOMIC_ACQ_REL);
 
-extern "C" {
+    // If there are no more unclaimed tasks in this job, remove it
+    // from the stack. The job itself stays alive until
+    // tasks_remaining hits zero.
+    if (job->next == job->max) {
+        *prev = job->next_job;
+    }
+    return true;
+}
 
-WEAK int halide_default_do_task(void *user_context, halide_task_t f, int idx,
-                                uint8_t *closure) {
-    return f(user_context, idx, closure);
+// Try to steal a range from any worker's deque, scanning from
+// 'first' so that a worker tries its neighbours before distant
+// threads (under a pinning policy, neighbouring ids share a cache or
+// socket). Safe to call from any thread, without the lock. Workers
+// may steal from their own deque too; this is how a worker blocked as
+// the owner of a nested job drains ranges it pushed earlier.
+WEAK bool steal_task_range(task_range *r, int first) {
+    int n = work_queue.threads_created;
+    if (n == 0) {
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        if (work_queue.deques[(first + i) % n].steal(r)) {
+            return true;
+        }
+    }
+    return false;
 }
 
-WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
-                                   int min, int size, uint8_t *closure) {
-    // Our for loops are expected to gracefully handle sizes <= 0
-    if (size <= 0) {
-        return 0;
+WEAK void worker_thread(void *arg) {
+    int id = (int)(intptr_t)arg;
+    task_deque *my_deque = &work_queue.deques[id];
+
+    if (work_queue.pinning != halide_thread_pinning_none) {
+        halide_pin_thread_to_cpu(pinned_cpu_for_worker(id));
     }
 
-    // Grab the lock. If it hasn't been initialized yet, then the
-    // field will be zero-initialized because it's a static global.
     halide_mutex_lock(&work_queue.mutex);
+    while (work_queue.running()) {
+        task_range r;
+        if (claim_task_range_already_locked(&r)) {
+            halide_mutex_unlock(&work_queue.mutex);
+            bool counted = true;
+            do {
+                run_task_range(r, my_deque, counted);
+                counted = false;
+            } while (my_deque->pop(&r) || steal_task_range(&r, id + 1));
+            halide_mutex_lock(&work_queue.mutex);
+        } else {
+            // No unclaimed iterations in the job list. Look for
+            // something to steal before going to sleep. Drop the lock
+            // while scanning; the deques are lock-free.
+            halide_mutex_unlock(&work_queue.mutex);
+            bool stole = my_deque->pop(&r) || steal_task_range(&r, id + 1);
+            if (stole) {
+                do {
+                    run_task_range(r, my_deque, false);
+                } while (my_deque->pop(&r) || steal_task_range(&r, id + 1));
+            }
+            halide_mutex_lock(&work_queue.mutex);
+            if (!stole && !any_claimable_job_already_locked() && work_queue.running()) {
+                work_queue.sleeping_workers++;
+                halide_cond_wait(&work_queue.wakeup_workers, &work_queue.mutex);
+                work_queue.sleeping_workers--;
+            }
+        }
+    }
+    halide_mutex_unlock(&work_queue.mutex);
+}
 
+// One-time (and on demand after halide_set_num_threads) setup of the
+// work queue and worker threads. Called with the lock held.
+WEAK void init_thread_pool_already_locked() {
     if (!work_queue.initialized) {
         work_queue.shutdown = false;
         halide_cond_init(&work_queue.wakeup_owners);
-        halide_cond_init(&work_queue.wakeup_a_team);
-        halide_cond_init(&work_queue.wakeup_b_team);
+        halide_cond_init(&work_queue.wakeup_workers);
         work_queue.jobs = NULL;
+        work_queue.sleeping_workers = 0;
 
         // Compute the desired number of threads to use. Other code
         // can also mess with this value, but only when the work queue
@@ -191,10 +588,30 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
             work_queue.desired_num_threads = default_desired_num_threads();
         }
         work_queue.desired_num_threads = clamp_num_threads(work_queue.desired_num_threads);
-        work_queue.threads_created = 0;
 
-        // Everyone starts on the a team.
-        work_queue.a_team_size = work_queue.desired_num_threads;
+        if (!work_queue.schedule_set) {
+            char *schedule_str = getenv("HL_PARALLEL_SCHEDULE");
+            if (schedule_str) {
+                work_queue.schedule = clamp_parallel_schedule(atoi(schedule_str));
+            }
+        }
+
+        if (!work_queue.pinning_set) {
+            char *pinning_str = getenv("HL_THREAD_PINNING");
+            if (pinning_str) {
+                work_queue.pinning = clamp_thread_pinning(atoi(pinning_str));
+            }
+        }
+
+        if (!work_queue.core_class_set) {
+            char *core_class_str = getenv("HL_THREAD_CORE_CLASS");
+            if (core_class_str) {
+                work_queue.core_class = clamp_core_class(atoi(core_class_str));
+            }
+        }
+        trace_tasks = getenv("HL_TRACE_TASKS") != NULL;
+
+        work_queue.threads_created = 0;
 
         work_queue.initialized = true;
     }
@@ -202,11 +619,81 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
     while (work_queue.threads_created < work_queue.desired_num_threads - 1) {
         // We might need to make some new threads, if work_queue.desired_num_threads has
         // increased.
-        work_queue.threads[work_queue.threads_created++] =
-            halide_spawn_thread(worker_thread, NULL);
+        int id = work_queue.threads_created++;
+        work_queue.threads[id] =
+            halide_spawn_thread(worker_thread, (void *)(intptr_t)id);
+    }
+}
+
+// The owner's side of a group of enqueued jobs: help retire
+// outstanding work until every job in the group has completed. The
+// owner has no deque, so it claims chunks and runs them inline, and
+// steals (from any deque, including possibly its own if this is a
+// nested call from a worker) when the job list runs dry. Called with
+// the lock held; returns with it held.
+WEAK void help_with_group_already_locked(int *group_remaining) {
+    while (*group_remaining > 0) {
+        task_range r;
+        if (claim_task_range_already_locked(&r)) {
+            halide_mutex_unlock(&work_queue.mutex);
+            run_task_range(r, NULL, true);
+            halide_mutex_lock(&work_queue.mutex);
+        } else {
+            halide_mutex_unlock(&work_queue.mutex);
+            bool stole = steal_task_range(&r, 0);
+            if (stole) {
+                run_task_range(r, NULL, false);
+            }
+            halide_mutex_lock(&work_queue.mutex);
+            if (!stole && !any_claimable_job_already_locked() && *group_remaining > 0) {
+                // Nothing left for us to help with. Wait for the last
+                // worker to signal that the group is finished.
+                halide_cond_wait(&work_queue.wakeup_owners, &work_queue.mutex);
+            }
+        }
     }
+}
+
+}}}  // namespace Halide::Runtime::Internal
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK int halide_default_do_task(void *user_context, halide_task_t f, int idx,
+                                uint8_t *closure) {
+    return f(user_context, idx, closure);
+}
 
-    // Make the job.
+WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
+                                   int min, int size, uint8_t *closure) {
+    // Our for loops are expected to gracefully handle sizes <= 0
+    if (size <= 0) {
+        return 0;
+    }
+
+    // Run tiny loops inline rather than engaging the pool. As in the
+    // pool itself, a failing iteration doesn't stop the remaining
+    // ones; the last failure wins.
+    if (size <= par_for_inline_extent()) {
+        int exit_status = 0;
+        for (int i = min; i < min + size; i++) {
+            int result = halide_do_task(user_context, f, i, closure);
+            if (result) {
+                exit_status = result;
+            }
+        }
+        return exit_status;
+    }
+
+    // Grab the lock. If it hasn't been initialized yet, then the
+    // field will be zero-initialized because it's a static global.
+    halide_mutex_lock(&work_queue.mutex);
+
+    init_thread_pool_already_locked();
+
+    // Make the job. It forms a group of one.
+    int group_remaining = 1;
     work job;
     job.f = f;               // The job should call this function. It takes an index and a closure.
     job.user_context = user_context;
@@ -214,37 +701,24 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
     job.max  = min + size;   // Keep going until one less than this index.
     job.closure = closure;   // Use this closure.
     job.exit_status = 0;     // The job hasn't failed yet
-    job.active_workers = 0;  // Nobody is working on this yet
-
-    if (!work_queue.jobs && size < work_queue.desired_num_threads) {
-        // If there's no nested parallelism happening and there are
-        // fewer tasks to do than threads, then set the target A team
-        // size so that some threads will put themselves to sleep
-        // until a larger job arrives.
-        work_queue.target_a_team_size = size;
-    } else {
-        // Otherwise the target A team size is
-        // desired_num_threads. This may still be less than
-        // threads_created if desired_num_threads has been reduced by
-        // other code.
-        work_queue.target_a_team_size = work_queue.desired_num_threads;
-    }
+    job.tasks_remaining = size;
+    job.group_remaining = &group_remaining;
+    job.schedule = work_queue.schedule;
+    job.chunk = (size + work_queue.desired_num_threads - 1) /
+                work_queue.desired_num_threads;
+    job.max_workers = current_domain_max_workers_already_locked();
+    job.core_class = work_queue.core_class;
+    job.active_workers = 0;
 
     // Push the job onto the stack.
     job.next_job = work_queue.jobs;
     work_queue.jobs = &job;
 
-    // Wake up our A team.
-    halide_cond_broadcast(&work_queue.wakeup_a_team);
-
-    // If there are fewer threads than we would like on the a team,
-    // wake up the b team too.
-    if (work_queue.target_a_team_size > work_queue.a_team_size) {
-        halide_cond_broadcast(&work_queue.wakeup_b_team);
-    }
+    // Wake up any sleeping workers.
+    halide_cond_broadcast(&work_queue.wakeup_workers);
 
     // Do some work myself.
-    worker_thread_already_locked(&job);
+    help_with_group_already_locked(&group_remaining);
 
     halide_mutex_unlock(&work_queue.mutex);
 
@@ -253,6 +727,119 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
     return job.exit_status;
 }
 
+WEAK int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
+                                          struct halide_parallel_task_t *tasks) {
+    if (num_tasks <= 0) {
+        return 0;
+    }
+
+    work *jobs = (work *)__builtin_alloca(num_tasks * sizeof(work));
+
+    halide_mutex_lock(&work_queue.mutex);
+
+    init_thread_pool_already_locked();
+
+    // Make a job per task, all sharing one group counter. Push them
+    // in reverse so the first task is on top of the stack. Because
+    // the job list is claimed LIFO, a batch enqueued from inside a
+    // running task (nested parallelism) gets drained before the
+    // remainder of its enclosing loops, which keeps the working set
+    // of each thread on the innermost tiles.
+    int group_remaining = 0;
+    for (int i = 0; i < num_tasks; i++) {
+        if (tasks[i].extent > 0) {
+            group_remaining++;
+        }
+    }
+    for (int i = num_tasks - 1; i >= 0; i--) {
+        if (tasks[i].extent <= 0) {
+            continue;
+        }
+        work *job = jobs + i;
+        job->f = tasks[i].fn;
+        job->user_context = user_context;
+        job->next = tasks[i].min;
+        job->max = tasks[i].min + tasks[i].extent;
+        job->closure = tasks[i].closure;
+        job->exit_status = 0;
+        job->tasks_remaining = tasks[i].extent;
+        job->group_remaining = &group_remaining;
+        job->schedule = work_queue.schedule;
+        job->chunk = (tasks[i].extent + work_queue.desired_num_threads - 1) /
+                     work_queue.desired_num_threads;
+        job->max_workers = current_domain_max_workers_already_locked();
+        job->core_class = work_queue.core_class;
+        job->active_workers = 0;
+        job->next_job = work_queue.jobs;
+        work_queue.jobs = job;
+    }
+
+    // Wake up any sleeping workers.
+    halide_cond_broadcast(&work_queue.wakeup_workers);
+
+    // Do some work myself.
+    help_with_group_already_locked(&group_remaining);
+
+    halide_mutex_unlock(&work_queue.mutex);
+
+    // Return zero if all the jobs succeeded, otherwise return the
+    // exit status of one of the failing jobs.
+    int exit_status = 0;
+    for (int i = 0; i < num_tasks; i++) {
+        if (tasks[i].extent > 0 && jobs[i].exit_status != 0) {
+            exit_status = jobs[i].exit_status;
+        }
+    }
+    return exit_status;
+}
+
+WEAK int halide_set_parallel_schedule(int schedule) {
+    schedule = clamp_parallel_schedule(schedule);
+    // Take the lock so the change doesn't land in the middle of a job
+    // being enqueued; jobs already in flight keep the schedule they
+    // were launched with.
+    halide_mutex_lock(&work_queue.mutex);
+    int old = work_queue.schedule;
+    work_queue.schedule = schedule;
+    work_queue.schedule_set = true;
+    halide_mutex_unlock(&work_queue.mutex);
+    return old;
+}
+
+WEAK int halide_set_parallel_inline_extent(int extent) {
+    if (extent < 0) {
+        extent = 0;
+    }
+    // Resolves the environment variable first so the old value
+    // returned is the one loops were actually using.
+    int old = par_for_inline_extent();
+    __atomic_store_n(&inline_par_for_extent, extent, __ATOMIC_RELAXED);
+    return old;
+}
+
+WEAK int halide_set_thread_pinning(int pinning) {
+    pinning = clamp_thread_pinning(pinning);
+    halide_mutex_lock(&work_queue.mutex);
+    int old = work_queue.pinning;
+    work_queue.pinning = pinning;
+    work_queue.pinning_set = true;
+    halide_mutex_unlock(&work_queue.mutex);
+    return old;
+}
+
+WEAK int halide_set_thread_pool_core_class(int core_class) {
+    core_class = clamp_core_class(core_class);
+    // Take the lock so the change doesn't land in the middle of a job
+    // being enqueued; jobs already in flight keep the class they were
+    // launched with.
+    halide_mutex_lock(&work_queue.mutex);
+    int old = work_queue.core_class;
+    work_queue.core_class = core_class;
+    work_queue.core_class_set = true;
+    halide_mutex_unlock(&work_queue.mutex);
+    return old;
+}
+
 WEAK int halide_set_num_threads(int n) {
     if (n < 0) {
         halide_error(NULL, "halide_set_num_threads: must be >= 0.");
@@ -270,6 +857,230 @@ WEAK int halide_set_num_threads(int n) {
     return old;
 }
 
+WEAK int halide_define_thread_pool_domain(const char *name, int max_threads) {
+    if (name == NULL || strlen(name) == 0 ||
+        strlen(name) >= POOL_DOMAIN_NAME_SIZE || max_threads < 0) {
+        halide_error(NULL, "halide_define_thread_pool_domain: bad domain name or thread count.");
+        return halide_error_code_generic_error;
+    }
+    halide_mutex_lock(&work_queue.mutex);
+    int d = 0;
+    while (d < work_queue.num_domains &&
+           strcmp(work_queue.domains[d].name, name) != 0) {
+        d++;
+    }
+    if (d == work_queue.num_domains) {
+        if (d == MAX_POOL_DOMAINS) {
+            halide_mutex_unlock(&work_queue.mutex);
+            halide_error(NULL, "halide_define_thread_pool_domain: too many domains.");
+            return halide_error_code_generic_error;
+        }
+        memcpy(work_queue.domains[d].name, name, strlen(name) + 1);
+        work_queue.num_domains++;
+    }
+    work_queue.domains[d].max_threads = max_threads;
+    halide_mutex_unlock(&work_queue.mutex);
+    return 0;
+}
+
+WEAK int halide_set_thread_pool_domain(const char *name) {
+    halide_mutex_lock(&work_queue.mutex);
+    if (name == NULL) {
+        work_queue.current_domain = 0;
+        halide_mutex_unlock(&work_queue.mutex);
+        return 0;
+    }
+    for (int d = 0; d < work_queue.num_domains; d++) {
+        if (strcmp(work_queue.domains[d].name, name) == 0) {
+            work_queue.current_domain = d + 1;
+            halide_mutex_unlock(&work_queue.mutex);
+            return 0;
+        }
+    }
+    halide_mutex_unlock(&work_queue.mutex);
+    halide_error(NULL, "halide_set_thread_pool_domain: unknown domain.");
+    return halide_error_code_generic_error;
+}
+
+// Semaphores are just an atomic counter. Acquirers that need to block
+// piggyback on the work queue's condition variables rather than
+// carrying a mutex and condvar of their own; semaphores are only used
+// by code already running on the thread pool, so the queue is always
+// initialized by the time anyone can block.
+namespace {
+struct halide_semaphore_impl_t {
+    int value;
+};
+}
+
+WEAK int halide_semaphore_init(halide_semaphore_t *s, int n) {
+    halide_semaphore_impl_t *sem = (halide_semaphore_impl_t *)s;
+    __atomic_store_n(&sem->value, n, __ATOMIC_RELEASE);
+    return n;
+}
+
+WEAK int halide_semaphore_release(halide_semaphore_t *s, int n) {
+    halide_semaphore_impl_t *sem = (halide_semaphore_impl_t *)s;
+    int new_val = __atomic_add_fetch(&sem->value, n, __ATOMIC_ACQ_REL);
+    // Anyone blocked in halide_semaphore_acquire is asleep on
+    // wakeup_owners along with any blocked job owners; they all
+    // recheck their predicates on wakeup.
+    halide_mutex_lock(&work_queue.mutex);
+    halide_cond_broadcast(&work_queue.wakeup_owners);
+    halide_mutex_unlock(&work_queue.mutex);
+    return new_val;
+}
+
+WEAK bool halide_semaphore_try_acquire(halide_semaphore_t *s, int n) {
+    halide_semaphore_impl_t *sem = (halide_semaphore_impl_t *)s;
+    // Decrement and get new value
+    int expected = __atomic_load_n(&sem->value, __ATOMIC_ACQUIRE);
+    while (expected >= n &&
+           !__atomic_compare_exchange_n(&sem->value, &expected, expected - n, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // CAS failure reloads expected; retry while there are still
+        // enough units available.
+    }
+    return expected >= n;
+}
+
+WEAK int halide_semaphore_acquire(halide_semaphore_t *s, int n) {
+    while (!halide_semaphore_try_acquire(s, n)) {
+        halide_mutex_lock(&work_queue.mutex);
+        if (!halide_semaphore_try_acquire(s, n)) {
+            halide_cond_wait(&work_queue.wakeup_owners, &work_queue.mutex);
+            halide_mutex_unlock(&work_queue.mutex);
+        } else {
+            halide_mutex_unlock(&work_queue.mutex);
+            return n;
+        }
+    }
+    return n;
+}
+
+}  // extern "C"
+
+// A task graph executes as an ordinary parallel-for job with one
+// iteration per node, except that each iteration claims whichever
+// node is ready (all dependencies retired) rather than the node with
+// its own index. That keeps the pool busy across node boundaries: the
+// moment a node retires, its dependents become claimable without
+// anything draining in between. Iterations with nothing ready park on
+// wakeup_owners, like blocked semaphore acquirers.
+namespace Halide { namespace Runtime { namespace Internal {
+
+enum {
+    task_graph_node_waiting = 0,
+    task_graph_node_running,
+    task_graph_node_retired
+};
+
+struct task_graph_state {
+    struct halide_task_graph_node_t *nodes;
+    int num_nodes;
+    // Unretired dependencies per node. Protected by the work queue mutex.
+    int *remaining;
+    // One of the task_graph_node_ states above. Protected by the work
+    // queue mutex.
+    uint8_t *state;
+    // The first nonzero result from a node; once set, remaining nodes
+    // are skipped. Protected by the work queue mutex.
+    int exit_status;
+};
+
+WEAK int run_one_graph_node(void *user_context, int idx, uint8_t *closure) {
+    task_graph_state *graph = (task_graph_state *)closure;
+
+    halide_mutex_lock(&work_queue.mutex);
+    int node = -1;
+    while (node < 0) {
+        bool any_running = false;
+        for (int i = 0; i < graph->num_nodes && node < 0; i++) {
+            if (graph->state[i] == task_graph_node_waiting &&
+                (graph->remaining[i] == 0 || graph->exit_status != 0)) {
+                node = i;
+            }
+            any_running = any_running ||
+                          (graph->state[i] == task_graph_node_running);
+        }
+        if (node < 0) {
+            if (!any_running) {
+                // Nothing is ready and nothing is running, so the
+                // remaining nodes all depend on each other.
+                halide_error(user_context, "halide_task_graph_execute: cycle in task graph");
+                graph->exit_status = halide_error_code_generic_error;
+            } else {
+                halide_cond_wait(&work_queue.wakeup_owners, &work_queue.mutex);
+            }
+        }
+    }
+    graph->state[node] = task_graph_node_running;
+    bool skip = (graph->exit_status != 0);
+    halide_mutex_unlock(&work_queue.mutex);
+
+    int result = 0;
+    if (!skip) {
+        result = graph->nodes[node].fn(user_context, graph->nodes[node].closure);
+    }
+
+    halide_mutex_lock(&work_queue.mutex);
+    if (result != 0) {
+        graph->exit_status = result;
+    }
+    graph->state[node] = task_graph_node_retired;
+    for (int i = 0; i < graph->num_nodes; i++) {
+        if (graph->state[i] != task_graph_node_waiting) {
+            continue;
+        }
+        const struct halide_task_graph_node_t *n = graph->nodes + i;
+        for (int j = 0; j < n->num_deps; j++) {
+            if (n->deps[j] == node) {
+                graph->remaining[i]--;
+            }
+        }
+    }
+    halide_cond_broadcast(&work_queue.wakeup_owners);
+    halide_mutex_unlock(&work_queue.mutex);
+
+    return result;
+}
+
+}}}  // namespace Halide::Runtime::Internal
+
+extern "C" {
+
+WEAK int halide_task_graph_execute(void *user_context, int num_nodes,
+                                   struct halide_task_graph_node_t *nodes) {
+    if (num_nodes <= 0) {
+        return 0;
+    }
+
+    task_graph_state graph;
+    graph.nodes = nodes;
+    graph.num_nodes = num_nodes;
+    graph.remaining = (int *)__builtin_alloca(num_nodes * sizeof(int));
+    graph.state = (uint8_t *)__builtin_alloca(num_nodes);
+    graph.exit_status = 0;
+    for (int i = 0; i < num_nodes; i++) {
+        for (int j = 0; j < nodes[i].num_deps; j++) {
+            int d = nodes[i].deps[j];
+            if (d < 0 || d >= num_nodes || d == i) {
+                halide_error(user_context, "halide_task_graph_execute: dependency index out of range");
+                return halide_error_code_generic_error;
+            }
+        }
+        graph.remaining[i] = nodes[i].num_deps;
+        graph.state[i] = task_graph_node_waiting;
+    }
+
+    int result = halide_do_par_for(user_context, run_one_graph_node,
+                                   0, num_nodes, (uint8_t *)&graph);
+    if (graph.exit_status != 0) {
+        result = graph.exit_status;
+    }
+    return result;
+}
+
 WEAK void halide_shutdown_thread_pool() {
     if (!work_queue.initialized) return;
 
@@ -278,8 +1089,7 @@ WEAK void halide_shutdown_thread_pool() {
     halide_mutex_lock(&work_queue.mutex);
     work_queue.shutdown = true;
     halide_cond_broadcast(&work_queue.wakeup_owners);
-    halide_cond_broadcast(&work_queue.wakeup_a_team);
-    halide_cond_broadcast(&work_queue.wakeup_b_team);
+    halide_cond_broadcast(&work_queue.wakeup_workers);
     halide_mutex_unlock(&work_queue.mutex);
 
     // Wait until they leave
@@ -290,8 +1100,7 @@ WEAK void halide_shutdown_thread_pool() {
     // Tidy up
     halide_mutex_destroy(&work_queue.mutex);
     halide_cond_destroy(&work_queue.wakeup_owners);
-    halide_cond_destroy(&work_queue.wakeup_a_team);
-    halide_cond_destroy(&work_queue.wakeup_b_team);
+    halide_cond_destroy(&work_queue.wakeup_workers);
     work_queue.initialized = false;
 }
 
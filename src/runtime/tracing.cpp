@@ -75,6 +75,7 @@ class TraceBuffer {
     uint32_t cursor;
     uint8_t buf[buffer_size];
 
+public:
     // Attempt to atomically acquire space in the buffer to write a
     // packet. Returns NULL if the buffer was full.
     __attribute__((always_inline)) halide_trace_packet_t *try_acquire_packet(void *user_context, uint32_t size) {
@@ -90,8 +91,6 @@ class TraceBuffer {
         }
     }
 
-public:
-
     // Wait for all writers to finish with their packets, stall any
     // new writers, and flush the buffer to the fd.
     __attribute__((always_inline)) void flush(void *user_context, int fd) {
@@ -135,14 +134,172 @@ WEAK int halide_trace_file_lock = 0;
 WEAK bool halide_trace_file_initialized = false;
 WEAK void *halide_trace_file_internally_opened = NULL;
 
+// State for asynchronous trace draining (the HL_TRACE_ASYNC
+// environment variable). Two trace buffers alternate roles: writers
+// fill the active one, and when it's full they hand it to a
+// background drainer thread and swap in the other, instead of
+// stalling on disk I/O themselves.
+WEAK TraceBuffer *halide_trace_spare_buffer = NULL;
+WEAK int halide_trace_swap_lock = 0;
+WEAK volatile int halide_trace_swap_count = 0;
+WEAK volatile int halide_trace_drain_pending = 0;
+WEAK volatile bool halide_trace_drainer_exit = false;
+WEAK volatile bool halide_trace_drainer_running = false;
+
+// State for lossy tracing (the HL_TRACE_LOSSY environment variable,
+// or halide_set_trace_lossy). Rather than stalling the compute
+// thread when the sink can't keep up, drop the event and count it.
+WEAK bool halide_trace_lossy = false;
+WEAK volatile uintptr_t halide_trace_dropped_count = 0;
+
+// Per-event-type sampling. A rate of 1 keeps every event, n keeps
+// every nth, and 0 drops the event type entirely.
+WEAK int halide_trace_sample_rates[halide_trace_end_task + 1] =
+    {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+WEAK volatile uint32_t halide_trace_sample_counters[halide_trace_end_task + 1];
+
+WEAK void trace_drainer_thread(void *) {
+    while (!halide_trace_drainer_exit) {
+        if (halide_trace_drain_pending) {
+            halide_trace_spare_buffer->flush(NULL, halide_trace_file);
+            __sync_synchronize();
+            halide_trace_drain_pending = 0;
+        } else {
+            halide_sleep_ms(NULL, 1);
+        }
+    }
+    if (halide_trace_drain_pending) {
+        halide_trace_spare_buffer->flush(NULL, halide_trace_file);
+        halide_trace_drain_pending = 0;
+    }
+    __sync_synchronize();
+    halide_trace_drainer_running = false;
+}
+
+// Hand the full active buffer to the drainer and swap in the spare.
+// epoch is the value of halide_trace_swap_count observed when the
+// caller failed to acquire a packet; if another thread has swapped
+// since then, there's nothing to do.
+WEAK void swap_trace_buffers(int epoch) {
+    ScopedSpinLock lock(&halide_trace_swap_lock);
+    if (halide_trace_swap_count != epoch) {
+        return;
+    }
+    while (halide_trace_drain_pending) {
+        // The drainer hasn't finished with the spare buffer yet;
+        // tracing is outrunning the disk.
+        halide_sleep_ms(NULL, 1);
+    }
+    TraceBuffer *t = halide_trace_buffer;
+    halide_trace_buffer = halide_trace_spare_buffer;
+    halide_trace_spare_buffer = t;
+    __sync_synchronize();
+    halide_trace_drain_pending = 1;
+    halide_trace_swap_count = epoch + 1;
+}
+
+// Wait for any pending background drain to finish, then flush the
+// active buffer, so that the trace file is complete.
+WEAK void flush_async_trace(void *user_context, int fd) {
+    while (halide_trace_drain_pending) {
+        halide_sleep_ms(NULL, 1);
+    }
+    halide_trace_buffer->flush(user_context, fd);
+}
+
+// The id counter for trace packets. Hoisted out of
+// halide_default_trace so that the dropped-count records below can
+// claim ids from the same sequence.
+WEAK volatile int32_t halide_trace_ids = 1;
+
+// Claim space for a packet according to the current backpressure
+// policy. In lossy mode this never blocks on the sink: if the
+// buffers are full and the drainer is busy it returns NULL and the
+// caller drops the event.
+WEAK halide_trace_packet_t *acquire_trace_packet(void *user_context, int fd,
+                                                 uint32_t total_size,
+                                                 TraceBuffer **buffer_out) {
+    TraceBuffer *buffer;
+    halide_trace_packet_t *packet;
+    if (halide_trace_lossy) {
+        buffer = halide_trace_buffer;
+        packet = buffer->try_acquire_packet(user_context, total_size);
+        if (!packet && halide_trace_spare_buffer && !halide_trace_drain_pending) {
+            // The drainer is idle; hand it the full buffer and try
+            // the spare. If the drainer was still busy, tracing has
+            // outrun the sink and the event gets dropped instead of
+            // waiting.
+            swap_trace_buffers(halide_trace_swap_count);
+            buffer = halide_trace_buffer;
+            packet = buffer->try_acquire_packet(user_context, total_size);
+        }
+    } else if (halide_trace_spare_buffer) {
+        while (true) {
+            int epoch = halide_trace_swap_count;
+            buffer = halide_trace_buffer;
+            packet = buffer->try_acquire_packet(user_context, total_size);
+            if (packet) {
+                break;
+            }
+            swap_trace_buffers(epoch);
+        }
+    } else {
+        buffer = halide_trace_buffer;
+        packet = buffer->acquire_packet(user_context, fd, total_size);
+    }
+    *buffer_out = buffer;
+    return packet;
+}
+
+// Note previously dropped events in the trace itself, as a load of
+// the pseudo-func "<dropped>" whose value is the number of events
+// lost since the last such record. Only emitted when there is room;
+// otherwise the count keeps accumulating.
+WEAK void emit_dropped_record(void *user_context) {
+    uintptr_t dropped = halide_trace_dropped_count;
+    if (!dropped) {
+        return;
+    }
+    const char *name = "<dropped>";
+    uint32_t name_bytes = 10;
+    uint32_t total_size =
+        ((uint32_t)sizeof(halide_trace_packet_t) + (uint32_t)sizeof(uint64_t) + name_bytes + 3) & ~3;
+    TraceBuffer *buffer = halide_trace_buffer;
+    halide_trace_packet_t *packet = buffer->try_acquire_packet(user_context, total_size);
+    if (!packet) {
+        return;
+    }
+    __sync_fetch_and_sub(&halide_trace_dropped_count, dropped);
+    packet->size = total_size;
+    packet->id = __sync_fetch_and_add(&halide_trace_ids, 1);
+    packet->type.code = halide_type_uint;
+    packet->type.bits = 64;
+    packet->type.lanes = 1;
+    packet->event = halide_trace_load;
+    packet->parent_id = 0;
+    packet->value_index = 0;
+    packet->dimensions = 0;
+    uint64_t value = (uint64_t)dropped;
+    memcpy((void *)packet->value(), &value, sizeof(value));
+    memcpy((void *)packet->func(), name, name_bytes);
+    buffer->release_packet(packet);
+}
+
 }}}
 
 extern "C" {
 
 WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t *e) {
-    static int32_t ids = 1;
-
-    int32_t my_id = __sync_fetch_and_add(&ids, 1);
+    int32_t my_id = __sync_fetch_and_add(&halide_trace_ids, 1);
+
+    // Apply any per-event-type sampling rate. Sampled-out events
+    // still consume an id, so ids stay unique across the trace.
+    int rate = halide_trace_sample_rates[e->event];
+    if (rate != 1 &&
+        (rate <= 0 ||
+         (__sync_fetch_and_add(&halide_trace_sample_counters[e->event], 1) % (uint32_t)rate) != 0)) {
+        return my_id;
+    }
 
     // If we're dumping to a file, use a binary format
     int fd = halide_get_trace_file(user_context);
@@ -156,35 +313,54 @@ WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t
         uint32_t total_size = (total_size_without_padding + 3) & ~3;
 
         // Claim some space to write to in the trace buffer
-        halide_trace_packet_t *packet = halide_trace_buffer->acquire_packet(user_context, fd, total_size);
+        TraceBuffer *buffer;
+        halide_trace_packet_t *packet =
+            acquire_trace_packet(user_context, fd, total_size, &buffer);
 
-        if (total_size > 4096) {
-            print(NULL) << total_size << "\n";
-        }
+        if (packet) {
+            if (total_size > 4096) {
+                print(NULL) << total_size << "\n";
+            }
 
-        // Write a packet into it
-        packet->size = total_size;
-        packet->id = my_id;
-        packet->type = e->type;
-        packet->event = e->event;
-        packet->parent_id = e->parent_id;
-        packet->value_index = e->value_index;
-        packet->dimensions = e->dimensions;
-        if (e->coordinates) {
-            memcpy((void *)packet->coordinates(), e->coordinates, coords_bytes);
-        }
-        if (e->value) {
-            memcpy((void *)packet->value(), e->value, value_bytes);
-        }
-        memcpy((void *)packet->func(), e->func, name_bytes);
+            // Write a packet into it
+            packet->size = total_size;
+            packet->id = my_id;
+            packet->type = e->type;
+            packet->event = e->event;
+            packet->parent_id = e->parent_id;
+            packet->value_index = e->value_index;
+            packet->dimensions = e->dimensions;
+            if (e->coordinates) {
+                memcpy((void *)packet->coordinates(), e->coordinates, coords_bytes);
+            }
+            if (e->value) {
+                memcpy((void *)packet->value(), e->value, value_bytes);
+            }
+            memcpy((void *)packet->func(), e->func, name_bytes);
+
+            // Release it
+            buffer->release_packet(packet);
 
-        // Release it
-        halide_trace_buffer->release_packet(packet);
+            if (halide_trace_dropped_count) {
+                emit_dropped_record(user_context);
+            }
+        } else {
+            // Lossy mode, and the sink is behind.
+            __sync_fetch_and_add(&halide_trace_dropped_count, (uintptr_t)1);
+        }
 
         // We should also flush the trace buffer if we hit an event
         // that might be the end of the trace.
         if (e->event == halide_trace_end_pipeline) {
-            halide_trace_buffer->flush(user_context, fd);
+            if (halide_trace_dropped_count) {
+                // Last chance to account for any losses in the file.
+                emit_dropped_record(user_context);
+            }
+            if (halide_trace_spare_buffer) {
+                flush_async_trace(user_context, fd);
+            } else {
+                halide_trace_buffer->flush(user_context, fd);
+            }
         }
 
     } else {
@@ -206,7 +382,9 @@ WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t
                                      "Consume",
                                      "End consume",
                                      "Begin pipeline",
-                                     "End pipeline"};
+                                     "End pipeline",
+                                     "Begin task",
+                                     "End task"};
 
         // Only print out the value on stores and loads.
         bool print_value = (e->event < 2);
@@ -310,6 +488,16 @@ WEAK void halide_set_trace_file(int fd) {
     halide_trace_file = fd;
 }
 
+WEAK void halide_set_trace_lossy(int lossy) {
+    halide_trace_lossy = (lossy != 0);
+}
+
+WEAK void halide_set_trace_sample_rate(int event, int rate) {
+    if (event >= 0 && event <= halide_trace_end_task) {
+        halide_trace_sample_rates[event] = rate;
+    }
+}
+
 extern int errno;
 
 WEAK int halide_get_trace_file(void *user_context) {
@@ -324,6 +512,18 @@ WEAK int halide_get_trace_file(void *user_context) {
             if (!halide_trace_buffer) {
                 halide_trace_buffer = (TraceBuffer *)malloc(sizeof(TraceBuffer));
             }
+            if (getenv("HL_TRACE_LOSSY")) {
+                halide_trace_lossy = true;
+            }
+            // Lossy mode is only useful with a background drainer to
+            // fall behind, so it implies asynchronous draining.
+            if ((getenv("HL_TRACE_ASYNC") || halide_trace_lossy) && !halide_trace_spare_buffer) {
+                halide_trace_spare_buffer = (TraceBuffer *)malloc(sizeof(TraceBuffer));
+                memset((void *)halide_trace_spare_buffer, 0, sizeof(TraceBuffer));
+                halide_trace_drainer_exit = false;
+                halide_trace_drainer_running = true;
+                halide_spawn_thread(trace_drainer_thread, NULL);
+            }
         } else {
             halide_set_trace_file(0);
         }
@@ -336,6 +536,13 @@ WEAK int32_t halide_trace(void *user_context, const halide_trace_event_t *e) {
 }
 
 WEAK int halide_shutdown_trace() {
+    if (halide_trace_drainer_running) {
+        halide_trace_drainer_exit = true;
+        do {
+            // Memory barrier.
+            __sync_synchronize();
+        } while (halide_trace_drainer_running);
+    }
     if (halide_trace_file_internally_opened) {
         int ret = fclose(halide_trace_file_internally_opened);
         halide_trace_file = 0;
@@ -344,6 +551,10 @@ WEAK int halide_shutdown_trace() {
         if (halide_trace_buffer) {
             free(halide_trace_buffer);
         }
+        if (halide_trace_spare_buffer) {
+            free(halide_trace_spare_buffer);
+            halide_trace_spare_buffer = NULL;
+        }
         return ret;
     } else {
         return 0;
@@ -0,0 +1,37 @@
+#include "HalideRuntime.h"
+
+extern "C" {
+
+WEAK int halide_pipeline_warmup(void *user_context, const void *entry_point,
+                                void *arena, uint64_t arena_size) {
+    // Fault in the page holding the filter's entry point. We don't
+    // know how long the function is, so only the first page is safe
+    // to read; an L1I miss on the rest is minor next to a page fault.
+    if (entry_point) {
+        (void)*(volatile const uint8_t *)entry_point;
+    }
+
+    // Pre-fault the caller's arena, one touch per page. Each byte is
+    // written back to itself so that copy-on-write and demand-zero
+    // pages get real private copies, not just read mappings.
+    const uint64_t page_size = 4096;
+    volatile uint8_t *p = (volatile uint8_t *)arena;
+    for (uint64_t i = 0; i < arena_size; i += page_size) {
+        p[i] = p[i];
+    }
+    if (arena_size > 0) {
+        p[arena_size - 1] = p[arena_size - 1];
+    }
+
+    // Warm the allocator and the memoization cache key machinery,
+    // which are the first runtime services a cold invocation hits.
+    void *block = halide_malloc(user_context, page_size);
+    if (block) {
+        halide_free(user_context, block);
+    }
+    halide_memoization_cache_prime(user_context);
+
+    return 0;
+}
+
+}
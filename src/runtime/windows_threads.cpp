@@ -71,6 +71,16 @@ WEAK void halide_join_thread(halide_thread *thread_arg) {
     free(thread);
 }
 
+WEAK int halide_pin_thread_to_cpu(int cpu) {
+    // Not implemented on this platform.
+    return -1;
+}
+
+WEAK int halide_pin_thread_to_core_class(int core_class) {
+    // Not implemented on this platform.
+    return -1;
+}
+
 WEAK void halide_mutex_destroy(halide_mutex *mutex_arg) {
     windows_mutex *mutex = (windows_mutex *)mutex_arg;
     if (mutex->once != 0) {
@@ -122,4 +132,12 @@ WEAK int halide_host_cpu_count() {
     }
 }
 
+WEAK int halide_host_cpu_count_of_class(int core_class) {
+    // No way to tell core types apart here; every cpu counts as big.
+    if (core_class == halide_cpu_core_little) {
+        return 0;
+    }
+    return halide_host_cpu_count();
+}
+
 } // extern "C"
@@ -0,0 +1,58 @@
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    int W = 4096;
+    int H = 4096;
+    Buffer<uint32_t> input(W, H);
+
+    for (int y = 0; y < input.height(); y++) {
+        for (int x = 0; x < input.width(); x++) {
+            input(x, y) = rand() & 0xff;
+        }
+    }
+
+    Var x("x");
+
+    // A serial associative reduction: every iteration of the RDom writes
+    // to the same site, so the rvars cannot be parallelized directly and
+    // the auto-scheduler has to factor the reduction with rfactor to get
+    // any parallelism out of it.
+    Func sums("sums");
+    sums(x) = cast<uint64_t>(0);
+    RDom r(0, W, 0, H, "r");
+    sums(x) += cast<uint64_t>(input(r.x, r.y) >> x);
+
+    // Provide estimates on the pipeline output
+    sums.estimate(x, 0, 4);
+
+    // Auto-schedule the pipeline
+    Target target = get_jit_target_from_environment();
+    Pipeline p(sums);
+
+    p.auto_schedule(target);
+
+    // Inspect the schedule
+    sums.print_loop_nest();
+
+    // Run the schedule and check the result against a reference
+    Buffer<uint64_t> out = p.realize(4);
+
+    for (int i = 0; i < 4; i++) {
+        uint64_t ref = 0;
+        for (int y = 0; y < input.height(); y++) {
+            for (int x = 0; x < input.width(); x++) {
+                ref += input(x, y) >> i;
+            }
+        }
+        if (out(i) != ref) {
+            printf("out(%d) = %llu instead of %llu\n", i,
+                   (unsigned long long)out(i), (unsigned long long)ref);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x, y;
+
+    Func in("in");
+    in(x, y) = (x * 17 + y * 31) % 256;
+    in.compute_root();
+
+    {
+        // A histogram with the scatter parallelized using atomic adds.
+        Func hist("hist");
+        hist(x) = 0;
+        RDom r(0, 200, 0, 200);
+        hist(in(r.x, r.y)) += 1;
+        hist.update().atomic().parallel(r.y);
+
+        Buffer<int> result = hist.realize(256);
+
+        int correct[256] = {0};
+        for (int yy = 0; yy < 200; yy++) {
+            for (int xx = 0; xx < 200; xx++) {
+                correct[(xx * 17 + yy * 31) % 256]++;
+            }
+        }
+        for (int i = 0; i < 256; i++) {
+            if (result(i) != correct[i]) {
+                printf("hist(%d) = %d instead of %d\n", i, result(i), correct[i]);
+                return -1;
+            }
+        }
+    }
+
+    {
+        // A scatter reduction using atomic max, marked via Func::atomic.
+        Func m("m");
+        m(x) = 0;
+        RDom r(0, 200, 0, 200);
+        Expr bucket = in(r.x, r.y) % 16;
+        m(bucket) = max(m(bucket), r.x + r.y);
+        m.atomic();
+        m.update().parallel(r.y);
+
+        Buffer<int> result = m.realize(16);
+
+        int correct[16] = {0};
+        for (int yy = 0; yy < 200; yy++) {
+            for (int xx = 0; xx < 200; xx++) {
+                int b = ((xx * 17 + yy * 31) % 256) % 16;
+                if (xx + yy > correct[b]) correct[b] = xx + yy;
+            }
+        }
+        for (int i = 0; i < 16; i++) {
+            if (result(i) != correct[i]) {
+                printf("m(%d) = %d instead of %d\n", i, result(i), correct[i]);
+                return -1;
+            }
+        }
+    }
+
+    Target t = get_jit_target_from_environment();
+    if (t.has_feature(Target::CUDA)) {
+        // Row sums accumulated with atomic adds from GPU threads. The
+        // address is the same for every thread in the block, so the
+        // PTX backend combines each warp's operands with a shuffle
+        // reduction and issues one atomic per warp.
+        Func sums("sums");
+        sums(y) = 0;
+        RDom r(0, 256);
+        sums(y) += in(r.x, y);
+        sums.update().atomic().gpu_blocks(y).gpu_threads(r.x);
+
+        Buffer<int> result = sums.realize(40);
+
+        for (int yy = 0; yy < 40; yy++) {
+            int correct = 0;
+            for (int xx = 0; xx < 256; xx++) {
+                correct += (xx * 17 + yy * 31) % 256;
+            }
+            if (result(yy) != correct) {
+                printf("sums(%d) = %d instead of %d\n", yy, result(yy), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
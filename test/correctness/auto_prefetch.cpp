@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // auto_prefetch synthesizes prefetches for the input images read
+    // in the innermost loops, with a distance derived from the
+    // per-iteration footprint. Prefetches are only hints, so this
+    // just checks the pipeline is still correct with them injected
+    // (including the guards at the edges of the input).
+    Buffer<uint8_t> in_buf(128, 128);
+    for (int y = 0; y < in_buf.height(); y++) {
+        for (int x = 0; x < in_buf.width(); x++) {
+            in_buf(x, y) = (uint8_t)(x * 3 + y * 5);
+        }
+    }
+
+    ImageParam input(UInt(8), 2);
+    input.set(in_buf);
+
+    Func g("g");
+    Var x("x"), y("y");
+    g(x, y) = cast<uint16_t>(input(x, y)) + input(x + 1, y) + input(x, y + 1);
+    g.auto_prefetch();
+
+    Buffer<uint16_t> out = g.realize(127, 127);
+    for (int yy = 0; yy < out.height(); yy++) {
+        for (int xx = 0; xx < out.width(); xx++) {
+            uint16_t correct = (uint16_t)in_buf(xx, yy) +
+                               in_buf(xx + 1, yy) + in_buf(xx, yy + 1);
+            if (out(xx, yy) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n",
+                       xx, yy, out(xx, yy), correct);
+                return -1;
+            }
+        }
+    }
+
+    // With the inner loop vectorized, the row loop is the innermost
+    // dynamic loop, so the prefetches are synthesized at row
+    // granularity (fetching the next rows' footprint while the
+    // current row is computed).
+    Func h("h");
+    h(x, y) = cast<uint16_t>(input(x, y)) + input(x + 1, y) + input(x, y + 1);
+    h.vectorize(x, 16, TailStrategy::GuardWithIf).auto_prefetch();
+
+    Buffer<uint16_t> out2 = h.realize(127, 127);
+    for (int yy = 0; yy < out2.height(); yy++) {
+        for (int xx = 0; xx < out2.width(); xx++) {
+            uint16_t correct = (uint16_t)in_buf(xx, yy) +
+                               in_buf(xx + 1, yy) + in_buf(xx, yy + 1);
+            if (out2(xx, yy) != correct) {
+                printf("out2(%d, %d) = %d instead of %d\n",
+                       xx, yy, out2(xx, yy), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
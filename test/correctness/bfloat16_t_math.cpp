@@ -0,0 +1,72 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <cmath>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    {
+        // bfloat16 as a storage type: values written through a bfloat
+        // Func should round-trip with bfloat precision.
+        Func f, g;
+        Var x;
+
+        f(x) = cast(BFloat(16), sqrt(cast<float>(x)));
+        f.compute_root();
+        g(x) = cast<float>(f(x));
+        g.vectorize(x, 8);
+
+        Buffer<float> out = g.realize(128);
+        for (int xx = 0; xx < 128; xx++) {
+            float correct = (float)bfloat16_t(std::sqrt((float)xx));
+            if (out(xx) != correct) {
+                printf("out(%d) = %f instead of %f\n", xx, out(xx), correct);
+                return -1;
+            }
+        }
+    }
+
+    {
+        // Arithmetic on bfloat values widens to float32, computes,
+        // and rounds back to bfloat, matching what bfloat16_t does in
+        // software.
+        Func h, hf;
+        Var x;
+
+        Expr v = cast(BFloat(16), cast<float>(x) / 7.0f);
+        h(x) = v * cast(BFloat(16), 0.5f) + cast(BFloat(16), 1.5f);
+        h.compute_root().vectorize(x, 8);
+        hf(x) = cast<float>(h(x));
+
+        Buffer<float> out = hf.realize(64);
+        for (int xx = 0; xx < 64; xx++) {
+            bfloat16_t correct =
+                bfloat16_t((float)xx / 7.0f) * bfloat16_t(0.5f) + bfloat16_t(1.5f);
+            if (out(xx) != (float)correct) {
+                printf("out(%d) = %f instead of %f\n", xx, out(xx), (float)correct);
+                return -1;
+            }
+        }
+    }
+
+    {
+        // Realize directly into a bfloat16 buffer, and compare
+        // against bfloat values computed on the host.
+        Func f;
+        Var x;
+        f(x) = cast(BFloat(16), 0.1f) * cast(BFloat(16), x);
+
+        Buffer<bfloat16_t> out = f.realize(32);
+        for (int xx = 0; xx < 32; xx++) {
+            bfloat16_t correct = bfloat16_t(0.1f) * bfloat16_t(xx);
+            if (out(xx).to_bits() != correct.to_bits()) {
+                printf("out(%d) = 0x%04x instead of 0x%04x\n",
+                       xx, out(xx).to_bits(), correct.to_bits());
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
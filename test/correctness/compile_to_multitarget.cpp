@@ -27,6 +27,32 @@ void testCompileToOutput(Func j) {
     Internal::assert_file_exists(expected_h);
 }
 
+void testCompileToSingleObject(Func j) {
+    std::string fn_name = "compile_to_multitarget_single";
+#ifdef _MSC_VER
+    std::string fn_object = Internal::get_test_tmp_dir() + fn_name + ".obj";
+#else
+    std::string fn_object = Internal::get_test_tmp_dir() + fn_name + ".o";
+#endif
+
+    Internal::ensure_no_file_exists(fn_object);
+
+    std::vector<Target> targets = {
+        Target("host-profile-debug"),
+        Target("host-profile"),
+    };
+    Pipeline p(j);
+    auto args = p.infer_arguments();
+    auto module_producer = [&](const std::string &name, const Target &target) -> Module {
+        return p.compile_to_module(args, name, target);
+    };
+    // Requesting an object emits all of the sub-targets, the runtime,
+    // and the dispatch wrapper as one object file.
+    compile_multitarget(fn_name, Outputs().object(fn_object), targets, module_producer);
+
+    Internal::assert_file_exists(fn_object);
+}
+
 int main(int argc, char **argv) {
     Param<float> factor("factor");
     Func f, g, h, j;
@@ -41,6 +67,7 @@ int main(int argc, char **argv) {
     h.compute_root();
 
     testCompileToOutput(j);
+    testCompileToSingleObject(j);
 
     printf("Success!\n");
     return 0;
@@ -0,0 +1,95 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+bool error_occurred;
+void record_error(void *user_context, const char *msg) {
+    error_occurred = true;
+}
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    {
+        // Two siblings reading the same input, fused at their y
+        // loops, should walk each row of the input once.
+        Func in("in"), f("f"), g("g"), h("h");
+        in(x, y) = x * 3 + y;
+        in.compute_root();
+        f(x, y) = in(x, y) * 2;
+        g(x, y) = in(x, y) + 7;
+        h(x, y) = f(x, y) + g(x, y);
+
+        f.compute_root().parallel(y);
+        g.compute_root().compute_with(f, y);
+
+        Buffer<int> result = h.realize(128, 96);
+        for (int yy = 0; yy < 96; yy++) {
+            for (int xx = 0; xx < 128; xx++) {
+                int v = xx * 3 + yy;
+                int correct = v * 2 + v + 7;
+                if (result(xx, yy) != correct) {
+                    printf("h(%d, %d) = %d instead of %d\n",
+                           xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Three-way fusion, with the host's inner dimension
+        // vectorized. Only the loops outside the fused variable need
+        // to be plain, so this is fine.
+        Func in("in"), f("f"), g("g"), k("k"), out("out");
+        in(x, y) = x + y * 5;
+        in.compute_root();
+        f(x, y) = in(x, y) + 1;
+        g(x, y) = in(x, y) * in(x, y);
+        k(x, y) = in(x, y) - in(x, y) / 3;
+        out(x, y) = f(x, y) + g(x, y) + k(x, y);
+
+        f.compute_root().vectorize(x, 8);
+        g.compute_root().compute_with(f, y);
+        k.compute_root().compute_with(f, y);
+
+        Buffer<int> result = out.realize(100, 50);
+        for (int yy = 0; yy < 50; yy++) {
+            for (int xx = 0; xx < 100; xx++) {
+                int v = xx + yy * 5;
+                int correct = (v + 1) + v * v + (v - v / 3);
+                if (result(xx, yy) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n",
+                           xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Fused siblings computed over different regions should trip
+        // the runtime check.
+        Func f("f"), g("g"), h("h");
+        f(x, y) = x + y;
+        g(x, y) = x - y;
+        h(x, y) = f(x, y) + g(x % 10, y % 10);
+
+        f.compute_root();
+        g.compute_root().compute_with(f, y);
+        h.set_error_handler(&record_error);
+
+        error_occurred = false;
+        h.realize(100, 80);
+
+        if (!error_occurred) {
+            printf("Fusing siblings computed over mismatched regions "
+                   "should have been a runtime error\n");
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
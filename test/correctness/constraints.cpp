@@ -78,6 +78,41 @@ int main(int argc, char **argv) {
 
     Internal::assert_file_exists(assembly_file);
 
+    // Stamp out a variant specialized to the exact shape of a witness
+    // buffer: every min, extent, and stride becomes a compile-time
+    // constant.
+    Func k;
+    ImageParam shaped(Int(32), 2);
+    shaped.set_shape_from(image1.raw_buffer());
+    k(x, y) = shaped(x, y) + 1;
+    k.set_error_handler(my_error_handler);
+
+    shaped.set(image1);
+    error_occurred = false;
+    Buffer<int> result = k.realize(image1.width(), image1.height());
+    for (int yy = 0; yy < result.height(); yy++) {
+        for (int xx = 0; xx < result.width(); xx++) {
+            if (result(xx, yy) != image1(xx, yy) + 1) {
+                printf("result(%d, %d) = %d instead of %d\n",
+                       xx, yy, result(xx, yy), image1(xx, yy) + 1);
+                return -1;
+            }
+        }
+    }
+    if (error_occurred) {
+        printf("Error incorrectly raised for matching shape\n");
+        return -1;
+    }
+
+    // Any other shape should be rejected.
+    shaped.set(image2);
+    error_occurred = false;
+    k.realize(20, 20);
+    if (!error_occurred) {
+        printf("Error incorrectly not raised for mismatched shape\n");
+        return -1;
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,61 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // Split factors don't have to be compile-time constants: they can
+    // be Exprs derived from the output extents, so a single compiled
+    // pipeline can pick a sensible tile granularity per frame at
+    // runtime.
+    Func f("f"), g("g");
+    Var x("x"), y("y"), xo("xo"), yo("yo"), xi("xi"), yi("yi");
+
+    f(x, y) = x + y;
+    g(x, y) = f(x, y) * 2;
+
+    OutputImageParam out = g.output_buffer();
+    Expr tile_w = clamp(out.dim(0).extent() / 8, 4, 64);
+    Expr tile_h = clamp(out.dim(1).extent() / 8, 4, 64);
+
+    g.tile(x, y, xo, yo, xi, yi, tile_w, tile_h, TailStrategy::GuardWithIf)
+        .parallel(yo);
+    f.compute_at(g, xo);
+
+    // Realize at several sizes with the same pipeline. Small outputs
+    // should get small tiles, large outputs large ones.
+    for (int size : {10, 100, 1000}) {
+        Buffer<int> im = g.realize(size, size);
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = (x + y) * 2;
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // A split factor that isn't bounded away from zero should still
+    // produce correct output, thanks to the runtime guard on the
+    // factor.
+    {
+        Func h("h");
+        h(x) = x * 3;
+        Param<int> w("w");
+        Var xo("xo"), xi("xi");
+        h.split(x, xo, xi, max(w / 4, 1), TailStrategy::GuardWithIf);
+        w.set(2);
+        Buffer<int> im = h.realize(20);
+        for (int x = 0; x < im.width(); x++) {
+            if (im(x) != x * 3) {
+                printf("im(%d) = %d instead of %d\n", x, im(x), x * 3);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
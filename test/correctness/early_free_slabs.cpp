@@ -0,0 +1,35 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // A large intermediate consumed front-to-back by a serial
+    // consumer. Lowering injects per-iteration hints that release the
+    // consumed slabs of the producer back to the OS; check the
+    // pipeline still computes the right thing with them in place.
+    const int W = 2048, H = 1024;
+
+    Func f("f"), g("g");
+    Var x("x"), y("y");
+
+    f(x, y) = x + y * 3;
+    f.compute_root();
+
+    RDom r(0, W);
+    g(y) = 0;
+    g(y) += f(r, y);
+
+    Buffer<int> result = g.realize(H);
+
+    for (int yy = 0; yy < H; yy++) {
+        int correct = W * (W - 1) / 2 + W * yy * 3;
+        if (result(yy) != correct) {
+            printf("result(%d) = %d instead of %d\n", yy, result(yy), correct);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+namespace {
+
+int16_t sat16(int32_t x) {
+    if (x > 32767) return 32767;
+    if (x < -32768) return -32768;
+    return (int16_t)x;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const int W = 256;
+
+    Buffer<uint8_t> in_u8_a(W), in_u8_b(W);
+    Buffer<int16_t> in_i16_a(W), in_i16_b(W);
+    for (int i = 0; i < W; i++) {
+        // Include the extremes of each type, so saturation and
+        // rounding actually get exercised.
+        in_u8_a(i) = (uint8_t)(i * 89 + 3);
+        in_u8_b(i) = (uint8_t)(255 - i * 37);
+        in_i16_a(i) = (int16_t)(i * 1021 - 32768);
+        in_i16_b(i) = (int16_t)(32767 - i * 517);
+    }
+    in_i16_a(0) = -32768;
+    in_i16_b(0) = -32768;
+    in_i16_a(1) = 32767;
+    in_i16_b(1) = 32767;
+
+    Var x("x");
+
+    Func f_u8("f_u8");
+    f_u8(x) = Tuple(saturating_add(in_u8_a(x), in_u8_b(x)),
+                    saturating_sub(in_u8_a(x), in_u8_b(x)),
+                    halving_add(in_u8_a(x), in_u8_b(x)),
+                    rounding_halving_add(in_u8_a(x), in_u8_b(x)));
+    f_u8.vectorize(x, 16);
+
+    Func f_i16("f_i16");
+    f_i16(x) = Tuple(saturating_add(in_i16_a(x), in_i16_b(x)),
+                     halving_sub(in_i16_a(x), in_i16_b(x)),
+                     rounding_mul_shift_right(in_i16_a(x), in_i16_b(x), 15));
+    f_i16.vectorize(x, 8);
+
+    Realization r_u8 = f_u8.realize(W);
+    Realization r_i16 = f_i16.realize(W);
+
+    for (int i = 0; i < W; i++) {
+        int a = in_u8_a(i), b = in_u8_b(i);
+        uint8_t correct[] = {
+            (uint8_t)std::min(a + b, 255),
+            (uint8_t)std::max(a - b, 0),
+            (uint8_t)((a + b) >> 1),
+            (uint8_t)((a + b + 1) >> 1),
+        };
+        for (int j = 0; j < 4; j++) {
+            uint8_t result = Buffer<uint8_t>(r_u8[j])(i);
+            if (result != correct[j]) {
+                printf("u8 op %d at %d: %d instead of %d\n",
+                       j, i, result, correct[j]);
+                return -1;
+            }
+        }
+    }
+
+    for (int i = 0; i < W; i++) {
+        int32_t a = in_i16_a(i), b = in_i16_b(i);
+        int16_t correct[] = {
+            sat16(a + b),
+            // Halide's signed division rounds toward negative
+            // infinity, as does an arithmetic shift.
+            (int16_t)((a - b) >> 1),
+            sat16((a * b + (1 << 14)) >> 15),
+        };
+        for (int j = 0; j < 3; j++) {
+            int16_t result = Buffer<int16_t>(r_i16[j])(i);
+            if (result != correct[j]) {
+                printf("i16 op %d at %d: %d instead of %d\n",
+                       j, i, result, correct[j]);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    {
+        // A lookup table defined entirely in terms of constants and
+        // bounded to a constant region gets baked into a table at
+        // compile time. This should be invisible apart from the lack
+        // of runtime compute, so just check the values.
+        Func lut, f;
+        Var x, y;
+
+        lut(x) = cast<uint8_t>(min(x * x / 255, 255));
+        lut.bound(x, 0, 256);
+
+        f(x, y) = cast<int>(lut(x)) + y;
+
+        Buffer<int> im = f.realize(256, 4);
+        for (int yy = 0; yy < 4; yy++) {
+            for (int xx = 0; xx < 256; xx++) {
+                int correct = (uint8_t)std::min(xx * xx / 255, 255) + yy;
+                if (im(xx, yy) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", xx, yy, im(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // A 2D table with negative mins, realized rather than inlined.
+        Func lut, g;
+        Var x, y;
+
+        lut(x, y) = cast<int16_t>(x * 10 + y);
+        lut.bound(x, -8, 16).bound(y, -8, 16).compute_root();
+
+        g(x, y) = cast<int>(lut(x - 8, y - 8));
+
+        Buffer<int> im = g.realize(16, 16);
+        for (int yy = 0; yy < 16; yy++) {
+            for (int xx = 0; xx < 16; xx++) {
+                int correct = (xx - 8) * 10 + (yy - 8);
+                if (im(xx, yy) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", xx, yy, im(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // A function that depends on a Param can't be folded, and
+        // should still work as usual.
+        Func lut, f;
+        Var x;
+        Param<float> scale;
+
+        lut(x) = x * scale;
+        lut.bound(x, 0, 16);
+
+        f(x) = lut(x) * 2.0f;
+
+        scale.set(3.0f);
+        Buffer<float> im = f.realize(16);
+        for (int xx = 0; xx < 16; xx++) {
+            float correct = xx * 3.0f * 2.0f;
+            if (im(xx) != correct) {
+                printf("im(%d) = %f instead of %f\n", xx, im(xx), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+bool error_occurred;
+void record_error(void *user_context, const char *msg) {
+    error_occurred = true;
+}
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    {
+        // Two outputs reading the same input should walk it once.
+        Func in("in"), f("f"), g("g");
+        in(x, y) = x * 3 + y;
+        in.compute_root();
+        f(x, y) = in(x, y) * 2;
+        g(x, y) = in(x, y) + 7;
+
+        Pipeline p({f, g});
+        p.fuse_outputs();
+
+        // The fused traversal takes its structure from the first output.
+        f.parallel(y);
+
+        Realization r = p.realize(128, 96);
+        Buffer<int> fb = r[0], gb = r[1];
+        for (int yy = 0; yy < 96; yy++) {
+            for (int xx = 0; xx < 128; xx++) {
+                int v = xx * 3 + yy;
+                if (fb(xx, yy) != v * 2 || gb(xx, yy) != v + 7) {
+                    printf("f/g(%d, %d) = %d/%d instead of %d/%d\n",
+                           xx, yy, fb(xx, yy), gb(xx, yy), v * 2, v + 7);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Three outputs, with the first one vectorized.
+        Func in("in"), f("f"), g("g"), h("h");
+        in(x, y) = x + y * 5;
+        in.compute_root();
+        f(x, y) = in(x, y) + 1;
+        g(x, y) = in(x, y) * in(x, y);
+        h(x, y) = in(x, y) - in(x, y) / 3;
+
+        Pipeline p({f, g, h});
+        p.fuse_outputs();
+        f.vectorize(x, 8);
+
+        Realization r = p.realize(100, 50);
+        Buffer<int> fb = r[0], gb = r[1], hb = r[2];
+        for (int yy = 0; yy < 50; yy++) {
+            for (int xx = 0; xx < 100; xx++) {
+                int v = xx + yy * 5;
+                if (fb(xx, yy) != v + 1 || gb(xx, yy) != v * v || hb(xx, yy) != v - v / 3) {
+                    printf("At (%d, %d): %d %d %d instead of %d %d %d\n",
+                           xx, yy, fb(xx, yy), gb(xx, yy), hb(xx, yy),
+                           v + 1, v * v, v - v / 3);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Realizing fused outputs over different regions is an error.
+        Func f("f"), g("g");
+        f(x, y) = x + y;
+        g(x, y) = x - y;
+
+        Pipeline p({f, g});
+        p.fuse_outputs();
+        p.set_error_handler(&record_error);
+
+        Buffer<int> fb(100, 100), gb(100, 80);
+        error_occurred = false;
+        Realization r(fb, gb);
+        p.realize(r);
+
+        if (!error_occurred) {
+            printf("Realizing fused outputs with mismatched sizes should have been an error\n");
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
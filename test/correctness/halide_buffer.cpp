@@ -126,6 +126,124 @@ int main(int argc, char **argv) {
         });
     }
 
+    {
+        // Check cropping and slicing to a chosen static dimensionality
+        Buffer<float, 3> a(100, 80, 3);
+
+        a.fill([&](int x, int y, int c) {
+            return x + 100.0f * y + 100000.0f * c;
+        });
+
+        Buffer<float, 3> tile = a.cropped<3>({{20, 10}, {30, 10}});
+        tile.for_each_element([&](int x, int y, int c) {
+            if (&tile(x, y, c) != &a(x, y, c)) {
+                printf("tile(%d, %d, %d) does not alias a\n", x, y, c);
+                abort();
+            }
+        });
+
+        Buffer<float, 2> plane = a.sliced<2>(2, 1);
+        if (plane.dimensions() != 2) {
+            printf("plane has %d dimensions instead of 2\n", plane.dimensions());
+            abort();
+        }
+        plane.for_each_element([&](int x, int y) {
+            if (&plane(x, y) != &a(x, y, 1)) {
+                printf("plane(%d, %d) does not alias a\n", x, y);
+                abort();
+            }
+        });
+    }
+
+    {
+        // Check a type-converting copy
+        Buffer<uint8_t> a(32, 32);
+        a.fill([&](int x, int y) {
+            return (uint8_t)(x + y);
+        });
+
+        Buffer<float> b(32, 32);
+        b.convert_from(a);
+        b.for_each_element([&](int x, int y) {
+            float correct = (float)(uint8_t)(x + y);
+            if (b(x, y) != correct) {
+                printf("b(%d, %d) = %f instead of %f\n", x, y, b(x, y), correct);
+                abort();
+            }
+        });
+    }
+
+    {
+        // Check reinterpreting the bits of a buffer as another type
+        Buffer<float> a(10);
+        a.fill(1.0f);
+
+        Buffer<uint32_t> bits = a.reinterpret_bits<uint32_t>();
+        if ((void *)bits.data() != (void *)a.data()) {
+            printf("reinterpret_bits made a copy\n");
+            abort();
+        }
+        bits.for_each_element([&](int x) {
+            if (bits(x) != 0x3f800000) {
+                printf("bits(%d) = %x instead of %x\n", x, bits(x), 0x3f800000);
+                abort();
+            }
+        });
+
+        // Writes through the view should be visible in the original
+        bits(3) = 0x40000000;
+        if (a(3) != 2.0f) {
+            printf("a(3) = %f instead of 2.0\n", a(3));
+            abort();
+        }
+    }
+
+    {
+        // Check the raw scanline accessors
+        Buffer<int> a(128, 32);
+        a.fill([&](int x, int y) {
+            return x + 100 * y;
+        });
+
+        for (int y = a.dim(1).min(); y <= a.dim(1).max(); y++) {
+            if (a.row_begin(y) != &a(a.dim(0).min(), y) ||
+                a.row_end(y) != &a(a.dim(0).max(), y) + 1) {
+                printf("row_begin/row_end do not span row %d\n", y);
+                abort();
+            }
+            // A raw-pointer walk over the row should visit the same
+            // values as operator()
+            int x = a.dim(0).min();
+            for (const int *p = a.row_begin(y); p != a.row_end(y); p++, x++) {
+                if (*p != a(x, y)) {
+                    printf("*p = %d instead of %d at (%d, %d)\n", *p, a(x, y), x, y);
+                    abort();
+                }
+            }
+        }
+
+        // Scanlines survive cropping in y, and keep their min offset
+        // when cropped in x.
+        Buffer<int> window = a.cropped(0, 10, 20).cropped(1, 5, 10);
+        if (window.row_begin(5) != &window(10, 5)) {
+            printf("row_begin on a cropped buffer is wrong\n");
+            abort();
+        }
+
+        // for_each_dense_value behaves like for_each_value on densely
+        // packed buffers.
+        Buffer<int> b(128, 32);
+        b.for_each_dense_value([](int &b_val, int a_val) {
+            b_val = a_val * 2;
+        }, a);
+        b.for_each_element([&](int x, int y) {
+            if (b(x, y) != a(x, y) * 2) {
+                printf("b(%d, %d) = %d instead of %d\n", x, y, b(x, y), a(x, y) * 2);
+                abort();
+            }
+        });
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,84 @@
+#include "Halide.h"
+#include <algorithm>
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+int main(int argc, char **argv) {
+    Buffer<int> input(100, 100, "input_buf");
+    for (int yy = 0; yy < 100; yy++) {
+        for (int xx = 0; xx < 100; xx++) {
+            input(xx, yy) = xx * 3 + yy * 7;
+        }
+    }
+
+    Var x, y;
+    Func g("g"), f("f");
+    g(x, y) = input(x, y) * 2;
+    f(x, y) = g(x, y) + g(x + 1, y) + g(x, y + 1);
+    g.compute_root();
+
+    Buffer<int> out(99, 99);
+    f.realize(out);
+
+    // Perturb a block of the input.
+    for (int yy = 50; yy < 60; yy++) {
+        for (int xx = 40; xx < 50; xx++) {
+            input(xx, yy) += 100;
+        }
+    }
+
+    Region changed = {Range(40, 10), Range(50, 10)};
+    Region stale = f.infer_stale_regions("input_buf", changed);
+
+    if (stale.size() != 2) {
+        printf("stale region has %d dimensions instead of 2\n", (int)stale.size());
+        return -1;
+    }
+
+    // f reads g(x, y), g(x+1, y), and g(x, y+1), so the stale box
+    // must cover at least [39, 49] x [49, 59]. The query is allowed
+    // to be conservative, so clamp whatever comes back to the output
+    // bounds before recomputing it.
+    int expected_min[2] = {39, 49};
+    int expected_max[2] = {49, 59};
+    Region clamped;
+    for (int d = 0; d < 2; d++) {
+        int lo = 0, hi = 98;
+        if (stale[d].min.defined()) {
+            const int64_t *mn = as_const_int(stale[d].min);
+            const int64_t *ex = as_const_int(stale[d].extent);
+            if (!mn || !ex) {
+                printf("stale region dim %d does not have constant bounds\n", d);
+                return -1;
+            }
+            lo = std::max(lo, (int)*mn);
+            hi = std::min(hi, (int)(*mn + *ex - 1));
+        }
+        if (lo > expected_min[d] || hi < expected_max[d]) {
+            printf("stale region dim %d = [%d, %d] does not cover [%d, %d]\n",
+                   d, lo, hi, expected_min[d], expected_max[d]);
+            return -1;
+        }
+        clamped.push_back(Range(lo, hi - lo + 1));
+    }
+
+    // Recompute just the stale region in place, then check the whole
+    // output against a fresh full realization.
+    f.realize_region(Realization(out), clamped);
+
+    Buffer<int> fresh = f.realize(99, 99);
+    for (int yy = 0; yy < 99; yy++) {
+        for (int xx = 0; xx < 99; xx++) {
+            if (out(xx, yy) != fresh(xx, yy)) {
+                printf("out(%d, %d) = %d instead of %d\n",
+                       xx, yy, out(xx, yy), fresh(xx, yy));
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -49,11 +49,62 @@ bool test_interleave() {
     return true;
 }
 
+template <typename T>
+bool test_deinterleave() {
+    Var x("x"), y("y"), c("c");
+
+    ImageParam input(halide_type_of<T>(), 3, "input");
+    input.dim(0).set_stride(3);
+    input.dim(2).set_stride(1).set_bounds(0, 3);
+
+    Func planar("planar");
+    planar(x, y, c) = input(x, y, c);
+
+    Target target = get_jit_target_from_environment();
+    if (target.has_gpu_feature()) {
+        Var xi("xi"), yi("yi");
+        planar.gpu_tile(x, y, xi, yi, 16, 16);
+    } else if (target.has_feature(Target::HVX_64)) {
+        const int vector_width = 64 / sizeof(T);
+        planar.hexagon().vectorize(x, vector_width);
+    } else if (target.has_feature(Target::HVX_128)) {
+        const int vector_width = 128 / sizeof(T);
+        planar.hexagon().vectorize(x, vector_width);
+    } else {
+        planar.vectorize(x, target.natural_vector_size<uint8_t>());
+    }
+
+    Buffer<T> buff = Buffer<T>::make_interleaved(256, 128, 3);
+    buff.for_each_element([&](int x, int y, int c) {
+        buff(x, y, c) = x * 3 + y * 5 + c;
+    });
+    input.set(buff);
+
+    Buffer<T> out = planar.realize(256, 128, 3, target);
+    out.copy_to_host();
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            for (int c = 0; c < 3; c++) {
+                T correct = x * 3 + y * 5 + c;
+                if (out(x, y, c) != correct) {
+                    printf("out(%d, %d, %d) = %d instead of %d\n", x, y, c, out(x, y, c), correct);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
 int main(int argc, char **argv) {
     if (!test_interleave<uint8_t>()) return -1;
     if (!test_interleave<uint16_t>()) return -1;
     if (!test_interleave<uint32_t>()) return -1;
 
+    if (!test_deinterleave<uint8_t>()) return -1;
+    if (!test_deinterleave<uint16_t>()) return -1;
+    if (!test_deinterleave<uint32_t>()) return -1;
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,80 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    {
+        // A small pipeline with a reduction, a schedule, and both
+        // kinds of params, evaluated by the interpreter and by the
+        // compiled path. They should agree exactly on integer math.
+        ImageParam in(UInt(8), 2);
+        Param<int> offset;
+
+        Buffer<uint8_t> input(64, 48);
+        input.for_each_element([&](int x, int y) {
+            input(x, y) = (uint8_t)(x * 7 + y * 13);
+        });
+        in.set(input);
+        offset.set(5);
+
+        Var x, y;
+        Func blur("blur"), hist("hist");
+        Func clamped = BoundaryConditions::repeat_edge(in);
+        blur(x, y) = cast<uint8_t>((cast<uint16_t>(clamped(x - 1, y)) +
+                                    2 * clamped(x, y) +
+                                    clamped(x + 1, y) + offset) / 4);
+        hist(x) = 0;
+        RDom r(0, 64, 0, 48);
+        hist(cast<int>(blur(r.x, r.y) % 32)) += 1;
+
+        blur.compute_root().vectorize(x, 8).parallel(y);
+
+        Pipeline p({blur, hist});
+
+        Buffer<uint8_t> blur_c(64, 48), blur_i(64, 48);
+        Buffer<int> hist_c(32), hist_i(32);
+        p.realize(Realization(blur_c, hist_c));
+        p.realize_interpreted(Realization(blur_i, hist_i));
+
+        for (int yy = 0; yy < 48; yy++) {
+            for (int xx = 0; xx < 64; xx++) {
+                if (blur_c(xx, yy) != blur_i(xx, yy)) {
+                    printf("blur(%d, %d) = %d interpreted, but %d compiled\n",
+                           xx, yy, blur_i(xx, yy), blur_c(xx, yy));
+                    return -1;
+                }
+            }
+        }
+        for (int i = 0; i < 32; i++) {
+            if (hist_c(i) != hist_i(i)) {
+                printf("hist(%d) = %d interpreted, but %d compiled\n",
+                       i, hist_i(i), hist_c(i));
+                return -1;
+            }
+        }
+    }
+
+    {
+        // Float math may differ from compiled code in the last ulp,
+        // so just check it's close.
+        Var x;
+        Func f;
+        f(x) = sqrt(cast<float>(x)) * 2.0f + select(x % 2 == 0, sin(cast<float>(x)), 0.5f);
+
+        Pipeline p(f);
+        Buffer<float> compiled = p.realize(128)[0];
+        Buffer<float> interpreted = p.realize_interpreted({128})[0];
+        for (int i = 0; i < 128; i++) {
+            float err = std::abs(compiled(i) - interpreted(i));
+            if (err > 1e-5f) {
+                printf("f(%d) = %f interpreted, but %f compiled\n",
+                       i, interpreted(i), compiled(i));
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
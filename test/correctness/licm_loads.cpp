@@ -0,0 +1,63 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <cmath>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    {
+        // Loads with loop-invariant indices, and invariant
+        // transcendentals mixed in with them, get hoisted out of the
+        // loop now. Check the values come out unchanged.
+        Buffer<float> lut(8);
+        for (int i = 0; i < 8; i++) {
+            lut(i) = i * 0.25f;
+        }
+        Param<float> p;
+        p.set(1.5f);
+
+        Func f;
+        Var x;
+        f(x) = lut(3) * pow(p, 3) + select(x > 10, lut(4), lut(5)) + x;
+
+        Buffer<float> out = f.realize(32);
+        for (int i = 0; i < 32; i++) {
+            float correct =
+                0.75f * std::pow(1.5f, 3) + (i > 10 ? 1.0f : 1.25f) + i;
+            if (std::abs(out(i) - correct) > 0.001f) {
+                printf("out(%d) = %f instead of %f\n", i, out(i), correct);
+                return -1;
+            }
+        }
+    }
+
+    {
+        // A load whose index is loop-invariant must still not be
+        // hoisted out of a loop that stores to the same buffer. This
+        // scan writes g(1) on its first step and reads it on every
+        // later one.
+        Func g;
+        Var x;
+        g(x) = x;
+        RDom r(1, 15);
+        g(r) = g(r - 1) + g(1);
+
+        Buffer<int> out = g.realize(16);
+        int correct[16];
+        for (int i = 0; i < 16; i++) {
+            correct[i] = i;
+        }
+        for (int i = 1; i < 16; i++) {
+            correct[i] = correct[i - 1] + correct[1];
+        }
+        for (int i = 0; i < 16; i++) {
+            if (out(i) != correct[i]) {
+                printf("out(%d) = %d instead of %d\n", i, out(i), correct[i]);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -111,18 +111,18 @@ int main(int argc, char **argv) {
     }
 
     // The slicing applies to every loop level starting from the
-    // outermost one, but only recursively simplifies the clean steady
-    // state. It either splits things three (start, middle, end). So
-    // adding a boundary condition to a 2D computation will produce 5
-    // code paths for the top, bottom, left, right, and center of the
-    // image.
+    // outermost one, and recursively simplifies the prologue and
+    // epilogue as well as the clean steady state. Each loop splits
+    // things in three (start, middle, end). So adding a boundary
+    // condition to a 2D computation will produce 9 code paths: the
+    // four corners, the four edges, and the interior of the image.
     {
         Var y;
         Func g;
         g(x, y) = x + y;
         g.compute_root();
         Func h = BoundaryConditions::mirror_image(g, 0, 10, 0, 10);
-        count_partitions(h, 5);
+        count_partitions(h, 9);
     }
 
     // If you split and also have a boundary condition, or have
@@ -0,0 +1,63 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+namespace {
+
+bool error_occurred = false;
+void my_error_handler(void *user_context, const char *msg) {
+    error_occurred = true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ImageParam input(Int(32), 2);
+
+    Var x, y;
+    Func g;
+    g(x, y) = input(x, y) + input(y, x);
+
+    Pipeline p(g);
+    // The transpose access makes the two dimensions interchangeable,
+    // so we only ever run this on square inputs; telling the compiler
+    // lets provably-equal address math fold together.
+    p.add_requirement(input.dim(0).extent() == input.dim(1).extent());
+    p.add_requirement(input.dim(1).stride() == input.dim(0).extent());
+    p.set_error_handler(&my_error_handler);
+
+    Buffer<int> square(10, 10);
+    square.for_each_element([&](int x, int y) {
+        square(x, y) = x + 10 * y;
+    });
+    input.set(square);
+
+    Buffer<int> result = p.realize(10, 10);
+    if (error_occurred) {
+        printf("Unexpected error for square input\n");
+        return -1;
+    }
+    for (int yy = 0; yy < 10; yy++) {
+        for (int xx = 0; xx < 10; xx++) {
+            int correct = square(xx, yy) + square(yy, xx);
+            if (result(xx, yy) != correct) {
+                printf("result(%d, %d) = %d instead of %d\n",
+                       xx, yy, result(xx, yy), correct);
+                return -1;
+            }
+        }
+    }
+
+    // A non-square input must trip the requirement check at runtime.
+    Buffer<int> rect(10, 12);
+    input.set(rect);
+    p.realize(10, 10);
+    if (!error_occurred) {
+        printf("There should have been a requirement failure\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
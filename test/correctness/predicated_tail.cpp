@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // Use TailStrategy::Predicate on extents that don't divide the
+    // split factor, so the guard condition stays in the vectorized
+    // loop as a predicate instead of being factored out into a
+    // scalar epilogue. The results must match GuardWithIf exactly.
+
+    {
+        // A pure definition with a non-dividing extent.
+        Func f("f");
+        Var x("x"), y("y");
+        f(x, y) = x * 3 + y * 7;
+        f.vectorize(x, 8, TailStrategy::Predicate);
+
+        Buffer<int> im = f.realize(37, 5);
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = x * 3 + y * 7;
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n",
+                           x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // An RVar split. RVar splits must not recompute points, so
+        // Predicate is one of the few legal strategies.
+        Func g("g");
+        Var x("x");
+        RDom r(0, 53);
+        g(x) = 0;
+        g(x) += r * r;
+        RVar ro("ro"), ri("ri");
+        g.update().split(r, ro, ri, 8, TailStrategy::Predicate).vectorize(ri);
+
+        Buffer<int> im = g.realize(10);
+        int correct = 0;
+        for (int r = 0; r < 53; r++) {
+            correct += r * r;
+        }
+        for (int x = 0; x < im.width(); x++) {
+            if (im(x) != correct) {
+                printf("im(%d) = %d instead of %d\n", x, im(x), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+// Affine RDom::where predicates should be solved into tightened loop
+// bounds at lowering time, so a triangular domain iterates over half
+// the rectangle instead of testing the predicate everywhere. Count
+// the evaluations to check the pruning actually happened.
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+int call_counter = 0;
+extern "C" DLLEXPORT int count_arg(int x) {
+    call_counter++;
+    return x;
+}
+HalideExtern_1(int, count_arg, int);
+
+int main(int argc, char **argv) {
+    const int N = 64;
+
+    Func f("f");
+    Var y("y");
+    RDom r(0, N, 0, N);
+    r.where(r.x <= r.y);
+
+    f(y) = 0;
+    f(r.y) += count_arg(r.x);
+
+    Buffer<int> result = f.realize(N);
+
+    for (int yy = 0; yy < N; yy++) {
+        int correct = yy * (yy + 1) / 2;
+        if (result(yy) != correct) {
+            printf("result(%d) = %d instead of %d\n", yy, result(yy), correct);
+            return -1;
+        }
+    }
+
+    int expected_evals = N * (N + 1) / 2;
+    if (call_counter != expected_evals) {
+        printf("The triangular domain was evaluated %d times instead of %d; "
+               "the where predicate was not pruned into the loop bounds\n",
+               call_counter, expected_evals);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
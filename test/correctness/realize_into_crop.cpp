@@ -0,0 +1,53 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// Realizing into a crop of a larger buffer writes directly into the
+// parent allocation: compositing tiles into an atlas needs no
+// realize-then-copy step.
+
+int main(int argc, char **argv) {
+    const int atlas_size = 100, tile_size = 25;
+    const int sentinel = -17;
+
+    Buffer<int> atlas(atlas_size, atlas_size);
+    atlas.fill(sentinel);
+
+    Var x, y;
+    Func f;
+    f(x, y) = x + y * 1000;
+
+    // Composite four tiles at scattered offsets.
+    int offsets[][2] = {{0, 0}, {50, 25}, {75, 75}, {25, 60}};
+    for (auto &o : offsets) {
+        Buffer<int> tile(atlas.cropped(0, o[0], tile_size).cropped(1, o[1], tile_size));
+
+        // The crop must alias the atlas, not copy it.
+        if (tile.data() != &atlas(o[0], o[1])) {
+            printf("Crop at (%d, %d) does not alias the atlas\n", o[0], o[1]);
+            return -1;
+        }
+
+        f.realize(tile);
+    }
+
+    for (int yy = 0; yy < atlas_size; yy++) {
+        for (int xx = 0; xx < atlas_size; xx++) {
+            bool in_tile = false;
+            for (auto &o : offsets) {
+                in_tile |= (xx >= o[0] && xx < o[0] + tile_size &&
+                            yy >= o[1] && yy < o[1] + tile_size);
+            }
+            int correct = in_tile ? xx + yy * 1000 : sentinel;
+            if (atlas(xx, yy) != correct) {
+                printf("atlas(%d, %d) = %d instead of %d\n",
+                       xx, yy, atlas(xx, yy), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
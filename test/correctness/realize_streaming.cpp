@@ -0,0 +1,79 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    // A pipeline with a stencil over a compute_root producer, so
+    // realizing in slabs recomputes the producer rows that straddle
+    // each slab boundary.
+    Func f("f"), g("g"), h("h");
+    f(x, y) = x + y;
+    g(x, y) = f(x, y - 1) + f(x, y + 1);
+    h(x, y) = g(x, y) * 2;
+    f.compute_root();
+    g.compute_root();
+
+    Pipeline p(h);
+
+    Buffer<int> reference = p.realize(128, 128);
+
+    // An explicit slab size that doesn't divide the extent, so the
+    // last slab is a fringe.
+    {
+        Buffer<int> out(128, 128);
+        p.realize_streaming(Realization(out), 24);
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                if (out(x, y) != reference(x, y)) {
+                    printf("out(%d, %d) = %d instead of %d\n",
+                           x, y, out(x, y), reference(x, y));
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Let the planner pick the slab size, on an output that doesn't
+    // start at the origin.
+    {
+        Buffer<int> out(128, 128);
+        out.set_min(3, 5);
+        p.realize_streaming(Realization(out));
+        for (int y = 5; y < 5 + 128; y++) {
+            for (int x = 3; x < 3 + 128; x++) {
+                int correct = ((x + y - 1) + (x + y + 1)) * 2;
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n",
+                           x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // A tuple-valued output streams too.
+    {
+        Func t("t");
+        t(x, y) = Tuple(x + y, x - y);
+        Pipeline q(t);
+        Realization r = q.realize(50, 50);
+        Buffer<int> a(50, 50), b(50, 50);
+        Realization out(a, b);
+        q.realize_streaming(out, 7);
+        for (int y = 0; y < 50; y++) {
+            for (int x = 0; x < 50; x++) {
+                if (a(x, y) != x + y || b(x, y) != x - y) {
+                    printf("out(%d, %d) = (%d, %d) instead of (%d, %d)\n",
+                           x, y, a(x, y), b(x, y), x + y, x - y);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <thread>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // Test that the object instance registry copes with many threads
+    // registering and unregistering Params at once, and that pipelines
+    // built concurrently still resolve their own parameters. This test
+    // is intended to be run in a thread-sanitizer.
+
+    constexpr int total_iters = 1024;
+    constexpr int num_threads = 8;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+        threads.emplace_back([=]{
+            for (int i = 0; i < (total_iters / num_threads); i++) {
+                // Churn the registry with some short-lived params.
+                Param<int> p0, p1, p2, p3;
+
+                Param<int> offset;
+                offset.set(i);
+                Func f;
+                Var x;
+                f(x) = x + offset;
+                Buffer<int> im = f.realize(16);
+                for (int j = 0; j < 16; j++) {
+                    if (im(j) != j + i) {
+                        printf("im(%d) = %d instead of %d\n", j, im(j), j + i);
+                        exit(-1);
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    printf("Success!\n");
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int W = 256, H = 64;
+
+    Buffer<uint8_t> in_u8(W, H);
+    Buffer<int16_t> in_i16(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            in_u8(x, y) = (uint8_t)(x * 7 + y * 13);
+            in_i16(x, y) = (int16_t)(x * 255 - y * 500 - 16000);
+        }
+    }
+
+    Var x, y;
+
+    {
+        // Rounding halving add of u8, the bread and butter of
+        // bilinear resampling. Must be bit-exact: (a + b + 1) / 2.
+        Func f("f");
+        f(x, y) = rounding_halving_add(in_u8(x, y), in_u8((x + 1) % W, y));
+        f.vectorize(x, 16);
+        Buffer<uint8_t> out = f.realize(W, H);
+        for (int yy = 0; yy < H; yy++) {
+            for (int xx = 0; xx < W; xx++) {
+                int a = in_u8(xx, yy), b = in_u8((xx + 1) % W, yy);
+                uint8_t correct = (uint8_t)((a + b + 1) / 2);
+                if (out(xx, yy) != correct) {
+                    printf("rounding_halving_add(%d, %d) = %d instead of %d\n",
+                           a, b, out(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Widening multiply of i16: the product is computed at 32
+        // bits so it can't wrap.
+        Func g("g");
+        g(x, y) = widening_mul(in_i16(x, y), in_i16((x + 1) % W, y));
+        g.vectorize(x, 8);
+        Buffer<int32_t> out = g.realize(W, H);
+        for (int yy = 0; yy < H; yy++) {
+            for (int xx = 0; xx < W; xx++) {
+                int32_t correct = (int32_t)in_i16(xx, yy) * in_i16((xx + 1) % W, yy);
+                if (out(xx, yy) != correct) {
+                    printf("widening_mul at (%d, %d) = %d instead of %d\n",
+                           xx, yy, out(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Widening add of u8 to u16.
+        Func h("h");
+        h(x, y) = widening_add(in_u8(x, y), in_u8((x + 3) % W, y));
+        h.vectorize(x, 16);
+        Buffer<uint16_t> out = h.realize(W, H);
+        for (int yy = 0; yy < H; yy++) {
+            for (int xx = 0; xx < W; xx++) {
+                uint16_t correct = (uint16_t)in_u8(xx, yy) + in_u8((xx + 3) % W, yy);
+                if (out(xx, yy) != correct) {
+                    printf("widening_add at (%d, %d) = %d instead of %d\n",
+                           xx, yy, out(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Rounding shift right of i16, including a shift of zero.
+        Func r("r");
+        r(x, y) = rounding_shift_right(in_i16(x, y), cast<int16_t>(x % 8));
+        r.vectorize(x, 8);
+        Buffer<int16_t> out = r.realize(W, H);
+        for (int yy = 0; yy < H; yy++) {
+            for (int xx = 0; xx < W; xx++) {
+                int a = in_i16(xx, yy);
+                int b = xx % 8;
+                int16_t correct = (int16_t)(b == 0 ? a : ((a + (1 << (b - 1))) >> b));
+                if (out(xx, yy) != correct) {
+                    printf("rounding_shift_right(%d, %d) = %d instead of %d\n",
+                           a, b, out(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x, y;
+
+    Func in("in");
+    in(x, y) = (x * 17 + y * 31) % 256;
+    in.compute_root();
+
+    {
+        // A contended histogram: every row hits the same few buckets,
+        // so per-point atomics would serialize on the cache line. The
+        // write-combining buffers accumulate per task and flush each
+        // bucket once.
+        Func hist("hist");
+        hist(x) = 0;
+        RDom r(0, 200, 0, 200);
+        hist(in(r.x, r.y) % 8) += 1;
+        hist.update().scatter_buffered().parallel(r.y);
+
+        Buffer<int> result = hist.realize(8);
+
+        int correct[8] = {0};
+        for (int yy = 0; yy < 200; yy++) {
+            for (int xx = 0; xx < 200; xx++) {
+                correct[((xx * 17 + yy * 31) % 256) % 8]++;
+            }
+        }
+        for (int i = 0; i < 8; i++) {
+            if (result(i) != correct[i]) {
+                printf("hist(%d) = %d instead of %d\n", i, result(i), correct[i]);
+                return -1;
+            }
+        }
+    }
+
+    {
+        // A max scatter reduction with more destinations than slots,
+        // so slots are evicted and flushed mid-loop.
+        Func m("m");
+        m(x) = 0;
+        RDom r(0, 200, 0, 200);
+        Expr bucket = in(r.x, r.y);
+        m(bucket) = max(m(bucket), r.x + r.y);
+        m.update().scatter_buffered(16).parallel(r.y);
+
+        Buffer<int> result = m.realize(256);
+
+        int correct[256] = {0};
+        for (int yy = 0; yy < 200; yy++) {
+            for (int xx = 0; xx < 200; xx++) {
+                int b = (xx * 17 + yy * 31) % 256;
+                if (xx + yy > correct[b]) correct[b] = xx + yy;
+            }
+        }
+        for (int i = 0; i < 256; i++) {
+            if (result(i) != correct[i]) {
+                printf("m(%d) = %d instead of %d\n", i, result(i), correct[i]);
+                return -1;
+            }
+        }
+    }
+
+    {
+        // -= accumulates sums in the buffer and subtracts each slot
+        // once on flush. Left serial to check the no-parallel-loop
+        // fallback too.
+        Func d("d");
+        d(x) = 1 << 20;
+        RDom r(0, 100, 0, 100);
+        d(in(r.x, r.y) % 4) -= in(r.x, r.y);
+        d.update().scatter_buffered(4);
+
+        Buffer<int> result = d.realize(4);
+
+        int correct[4] = {1 << 20, 1 << 20, 1 << 20, 1 << 20};
+        for (int yy = 0; yy < 100; yy++) {
+            for (int xx = 0; xx < 100; xx++) {
+                int v = (xx * 17 + yy * 31) % 256;
+                correct[v % 4] -= v;
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            if (result(i) != correct[i]) {
+                printf("d(%d) = %d instead of %d\n", i, result(i), correct[i]);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -4,10 +4,13 @@
 #include <future>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "test/common/halide_test_dirs.h"
 
+#include "halide_benchmark.h"
+
 using namespace Halide;
 using namespace Halide::ConciseCasts;
 
@@ -36,6 +39,14 @@ struct TestResult {
     string error_msg;
 };
 
+struct BenchResult {
+    string op;
+    string name;
+    int vector_width;
+    double vector_time;
+    double scalar_time;
+};
+
 struct Task {
     string op;
     string name;
@@ -1429,6 +1440,24 @@ struct Test {
         // Interleave or deinterleave two vectors. Given that we use
         // interleaving loads and stores, it's hard to hit this op with
         // halide.
+
+        // ARMv8.2 dot products. The operands have to be dense in
+        // groups of 4, the shape of an 8-bit dot-product reduction
+        // with the inner dimension split by 4.
+        if (!arm32 && target.has_feature(Target::ARMDotProd)) {
+            Expr i8_4x4[] = {in_i8(4*x), in_i8(4*x + 1), in_i8(4*x + 2), in_i8(4*x + 3)};
+            Expr i8_4x4b[] = {in_i8(4*x + 32), in_i8(4*x + 33), in_i8(4*x + 34), in_i8(4*x + 35)};
+            Expr u8_4x4[] = {in_u8(4*x), in_u8(4*x + 1), in_u8(4*x + 2), in_u8(4*x + 3)};
+            Expr u8_4x4b[] = {in_u8(4*x + 32), in_u8(4*x + 33), in_u8(4*x + 34), in_u8(4*x + 35)};
+            check("sdot", 4, i32(i8_4x4[0])*i8_4x4b[0] + i32(i8_4x4[1])*i8_4x4b[1] +
+                             i32(i8_4x4[2])*i8_4x4b[2] + i32(i8_4x4[3])*i8_4x4b[3]);
+            check("sdot", 4, i32_1 + i32(i8_4x4[0])*i8_4x4b[0] + i32(i8_4x4[1])*i8_4x4b[1] +
+                             i32(i8_4x4[2])*i8_4x4b[2] + i32(i8_4x4[3])*i8_4x4b[3]);
+            check("udot", 4, u32(u8_4x4[0])*u8_4x4b[0] + u32(u8_4x4[1])*u8_4x4b[1] +
+                             u32(u8_4x4[2])*u8_4x4b[2] + u32(u8_4x4[3])*u8_4x4b[3]);
+            check("udot", 4, u32_1 + u32(u8_4x4[0])*u8_4x4b[0] + u32(u8_4x4[1])*u8_4x4b[1] +
+                             u32(u8_4x4[2])*u8_4x4b[2] + u32(u8_4x4[3])*u8_4x4b[3]);
+        }
     }
 
     void check_hvx_all() {
@@ -1566,6 +1595,13 @@ struct Test {
         check("vavg(v*.w,v*.w):rnd", hvx_width/4, i32((i64(i32_1) + i64(i32_2) + 1)/2));
         check("vnavg(v*.ub,v*.ub)", hvx_width/1, i8_sat((i16(u8_1) - i16(u8_2))/2));
         check("vnavg(v*.h,v*.h)", hvx_width/2, i16_sat((i32(i16_1) - i32(i16_2))/2));
+        if (is_v62) {
+            check("vavg(v*.b,v*.b)", hvx_width/1, i8((i16(i8_1) + i16(i8_2))/2));
+            check("vavg(v*.b,v*.b):rnd", hvx_width/1, i8((i16(i8_1) + i16(i8_2) + 1)/2));
+            check("vavg(v*.uw,v*.uw)", hvx_width/4, u32((u64(u32_1) + u64(u32_2))/2));
+            check("vavg(v*.uw,v*.uw):rnd", hvx_width/4, u32((u64(u32_1) + u64(u32_2) + 1)/2));
+            check("vnavg(v*.b,v*.b)", hvx_width/1, i8_sat((i16(i8_1) - i16(i8_2))/2));
+        }
         check("vnavg(v*.w,v*.w)", hvx_width/4, i32_sat((i64(i32_1) - i64(i32_2))/2));
 
         // The behavior of shifts larger than the type behave differently
@@ -1927,12 +1963,10 @@ struct Test {
         check("v*.uw += vrmpy(v*.ub,v*.ub)", hvx_width, u32_1 + u32(u8_1)*u8_1 + u32(u8_2)*u8_2 + u32(u8_3)*u8_3 + u32(u8_4)*u8_4);
 check("v*.w += vrmpy(v*.b,v*.b)", hvx_width, i32_1 + i32(i8_1)*i8_1 + i32(i8_2)*i8_2 + i32(i8_3)*i8_3 + i32(i8_4)*i8_4);
 
-#if 0
-        // These don't generate yet because we don't support mixed signs yet.
-        check("vrmpy(v*.ub,v*.b)", hvx_width, i32(u8_1)*i8_1) + i32(u8_2)*i8_2) + i32(u8_3)*i8_3 + i32(u8_4)*i8_4);
+        // Mixed signs, the common shape of 8-bit convolutions
+        // (unsigned pixels times signed coefficients).
+        check("vrmpy(v*.ub,v*.b)", hvx_width, i32(u8_1)*i8_1 + i32(u8_2)*i8_2 + i32(u8_3)*i8_3 + i32(u8_4)*i8_4);
         check("v*.w += vrmpy(v*.ub,v*.b)", hvx_width, i32_1 + i32(u8_1)*i8_1 + i32(u8_2)*i8_2 + i32(u8_3)*i8_3 + i32(u8_4)*i8_4);
-        check("vrmpy(v*.ub,v*.b)", hvx_width, i16(u8_1)*i8_1 + i16(u8_2)*i8_2 + i16(u8_3)*i8_3 + i16(u8_4)*i8_4);
-#endif
 
         // These should also work with 16 bit results. However, it is
         // only profitable to do so if the interleave simplifies away.
@@ -2060,8 +2094,8 @@ check("v*.w += vrmpy(v*.b,v*.b)", hvx_width, i32_1 + i32(i8_1)*i8_1 + i32(i8_2)*
         }
     }
 
-    bool test_all() {
-        // Queue up a bunch of tasks representing each test to run.
+    // Queue up a bunch of tasks representing each test to run.
+    void add_tests() {
         if (target.arch == Target::X86) {
             check_sse_all();
         } else if (target.arch == Target::ARM) {
@@ -2071,6 +2105,94 @@ check("v*.w += vrmpy(v*.b,v*.b)", hvx_width, i32_1 + i32(i8_1)*i8_1 + i32(i8_2)*
         } else if (target.arch == Target::POWERPC) {
             check_altivec_all();
         }
+    }
+
+    // Time the kernel for one pattern, vectorized and scalar, by
+    // realizing it over the same region the checks use.
+    BenchResult benchmark_one(const Task &task) const {
+        Target t = target.without_feature(Target::NoRuntime);
+
+        Func f(task.name);
+        f(x, y) = task.expr;
+        f.bound(x, 0, W).vectorize(x, task.vector_width);
+
+        Func f_scalar("scalar_" + task.name);
+        f_scalar(x, y) = task.expr;
+        f_scalar.bound(x, 0, W);
+
+        Buffer<> out_vector(task.expr.type(), {W, H});
+        Buffer<> out_scalar(task.expr.type(), {W, H});
+
+        // Compile and warm up outside the timed region.
+        f.realize(out_vector, t);
+        f_scalar.realize(out_scalar, t);
+
+        double vector_time = Tools::benchmark(3, 16, [&]() {
+            f.realize(out_vector, t);
+        });
+        double scalar_time = Tools::benchmark(3, 16, [&]() {
+            f_scalar.realize(out_scalar, t);
+        });
+
+        return {task.op, task.name, task.vector_width, vector_time, scalar_time};
+    }
+
+    // Produce a per-pattern instruction-selection scorecard: the
+    // throughput of each pattern's kernel, vectorized and scalar, so
+    // that pattern-matching regressions across compiler upgrades show
+    // up as numbers rather than just instruction names. A vectorized
+    // kernel running much slower than its scalar version means the
+    // pattern has scalarized; that is the only hard assertion, since
+    // many of these kernels are memory bound and cannot show the full
+    // vector-width speedup.
+    bool benchmark_all() {
+        if (!can_run_code()) {
+            printf("Not benchmarking everything, because target doesn't match host.\n");
+            return true;
+        }
+
+        add_tests();
+
+        double min_speedup = 0.5;
+        if (const char *e = getenv("HL_SIMD_OP_CHECK_MIN_SPEEDUP")) {
+            min_speedup = atof(e);
+        }
+
+        string csv_filename = output_directory + "simd_op_bench.csv";
+        std::ofstream csv(csv_filename);
+        csv << "target,op,name,vector_width,vector_ns_per_element,scalar_ns_per_element,speedup\n";
+
+        printf("%-30s %6s %16s %16s %10s\n",
+               "op", "width", "vector (ns/elem)", "scalar (ns/elem)", "speedup");
+
+        bool success = true;
+        for (const Task &task : tasks) {
+            BenchResult r = benchmark_one(task);
+            double per_elem = 1e9 / (double)(W * H);
+            double speedup = r.scalar_time / r.vector_time;
+            printf("%-30s %6d %16.4f %16.4f %9.2fx%s\n",
+                   r.op.c_str(), r.vector_width,
+                   r.vector_time * per_elem, r.scalar_time * per_elem, speedup,
+                   speedup < min_speedup ? " <-- scalarized?" : "");
+            csv << target.to_string() << "," << r.op << "," << r.name << ","
+                << r.vector_width << ","
+                << r.vector_time * per_elem << ","
+                << r.scalar_time * per_elem << ","
+                << speedup << "\n";
+            if (speedup < min_speedup) {
+                std::cerr << "Vectorized " << r.name << " (" << r.op << ") is more than "
+                          << (1.0 / min_speedup) << "x slower than its scalar version. "
+                          << "The pattern has probably stopped matching.\n";
+                success = false;
+            }
+        }
+
+        printf("Scorecard written to %s\n", csv_filename.c_str());
+        return success;
+    }
+
+    bool test_all() {
+        add_tests();
 
         Halide::Internal::ThreadPool<TestResult> pool(num_threads);
         std::vector<std::future<TestResult>> futures;
@@ -2099,19 +2221,39 @@ check("v*.w += vrmpy(v*.b,v*.b)", hvx_width, i32_1 + i32(i8_1)*i8_1 + i32(i8_2)*
 int main(int argc, char **argv) {
     Test test;
 
-    if (argc > 1) {
-        test.filter = argv[1];
+    bool benchmark = false;
+    vector<const char *> positional_args;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--benchmark") == 0) {
+            // Produce the per-pattern timing scorecard instead of
+            // checking the generated assembly.
+            benchmark = true;
+        } else {
+            positional_args.push_back(argv[i]);
+        }
+    }
+
+    if (positional_args.size() > 0) {
+        test.filter = positional_args[0];
         num_threads = 1;
     }
 
-    if (argc > 2) {
+    if (positional_args.size() > 1) {
         // Don't forget: if you want to run the standard tests to a specific output
         // directory, you'll need to invoke with the first arg enclosed
         // in quotes (to avoid it being wildcard-expanded by the shell):
         //
         //    correctness_simd_op_check "*" /path/to/output
         //
-        test.output_directory = argv[2];
+        test.output_directory = positional_args[1];
+    }
+
+    if (benchmark) {
+        if (!test.benchmark_all()) {
+            return -1;
+        }
+        printf("Success!\n");
+        return 0;
     }
 
     bool success = test.test_all();
@@ -0,0 +1,60 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    {
+        // A sparse update over the pure variables: only points where
+        // the mask is set get the update applied.
+        Buffer<uint8_t> mask(64, 64);
+        for (int j = 0; j < 64; j++) {
+            for (int i = 0; i < 64; i++) {
+                mask(i, j) = ((i + j) % 3 == 0) ? 1 : 0;
+            }
+        }
+
+        Func f("f");
+        f(x, y) = x + y;
+        f(x, y) = f(x, y) + 100;
+        f.update().skip_where(mask(x, y) != 0);
+
+        Buffer<int> result = f.realize(64, 64);
+        for (int j = 0; j < 64; j++) {
+            for (int i = 0; i < 64; i++) {
+                int correct = i + j + (mask(i, j) ? 100 : 0);
+                if (result(i, j) != correct) {
+                    printf("f(%d, %d) = %d instead of %d\n",
+                           i, j, result(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // A condition that only mentions the outer variable skips
+        // whole rows at a time.
+        Func g("g");
+        g(x, y) = x - y;
+        g(x, y) = 7;
+        g.update().skip_where(y % 2 == 1);
+
+        Buffer<int> result = g.realize(32, 32);
+        for (int j = 0; j < 32; j++) {
+            for (int i = 0; i < 32; i++) {
+                int correct = (j % 2 == 1) ? 7 : i - j;
+                if (result(i, j) != correct) {
+                    printf("g(%d, %d) = %d instead of %d\n",
+                           i, j, result(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -177,6 +177,56 @@ int main(int argc, char **argv) {
         }
     }
 
+    {
+        // Explicitly require sliding over the serial tile loop of a
+        // tiled schedule. Within each row of tiles, only the first
+        // tile should compute the full apron of the stencil.
+        count = 0;
+        Func f, g;
+        Var xo, yo, xi, yi;
+
+        f(x, y) = call_counter(x, y);
+        g(x, y) = f(x - 2, y) + f(x + 2, y);
+
+        g.tile(x, y, xo, yo, xi, yi, 10, 10);
+        f.store_at(g, yo).compute_at(g, xo).slide_over(xo);
+
+        Buffer<int> im = g.realize(100, 100);
+
+        // Per row of tiles, the first tile computes 14 columns of f
+        // and the other nine tiles compute 10 new columns each, over
+        // 10 rows: (14 + 9*10) * 10 * 10 rows of tiles.
+        if (count != 10400) {
+            printf("f was called %d times instead of %d times\n", count, 10400);
+            return -1;
+        }
+    }
+
+    {
+        // The same thing with the rows of tiles processed in
+        // parallel. The storage lives at the row level, so each
+        // thread carries its own overlap between consecutive tiles.
+        Func f, g;
+        Var xo, yo, xi, yi;
+
+        f(x, y) = x + y;
+        g(x, y) = f(x - 2, y) + f(x + 2, y);
+
+        g.tile(x, y, xo, yo, xi, yi, 10, 10).parallel(yo);
+        f.store_at(g, yo).compute_at(g, xo).slide_over(xo);
+
+        Buffer<int> im = g.realize(100, 100);
+        for (int yy = 0; yy < 100; yy++) {
+            for (int xx = 0; xx < 100; xx++) {
+                int correct = 2 * (xx + yy);
+                if (im(xx, yy) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", xx, yy, im(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // Software pipelining restructures the inner loop into
+    // prologue/kernel/epilogue with the loads issued an iteration
+    // early. Check the restructured loop still computes the right
+    // thing, including when the kernel runs for zero iterations.
+    Buffer<uint8_t> input(1024 + 4);
+    for (int i = 0; i < input.width(); i++) {
+        input(i) = (uint8_t)(i * 7 + 5);
+    }
+
+    Func f("f");
+    Var x("x");
+    f(x) = cast<uint16_t>(input(x)) + input(x + 2) + input(x + 4);
+    f.vectorize(x, 16).software_pipeline();
+
+    // One realization big enough for the kernel to run, and one of a
+    // single vector so only the prologue and epilogue run.
+    for (int size : {1024, 16}) {
+        Buffer<uint16_t> out = f.realize(size);
+        for (int xx = 0; xx < out.width(); xx++) {
+            uint16_t correct = (uint16_t)input(xx) + input(xx + 2) + input(xx + 4);
+            if (out(xx) != correct) {
+                printf("out(%d) = %d instead of %d\n", xx, out(xx), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
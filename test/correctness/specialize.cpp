@@ -662,6 +662,36 @@ int main(int argc, char **argv) {
         _halide_user_assert(vector_store_lanes == 32);
     }
 
+    {
+        Var x;
+        Param<int> p;
+
+        // A chain of equality specializations ending in
+        // specialize_fail() dispatches via binary search. Check every
+        // case still lands on the right branch, with the conditions
+        // deliberately added out of order.
+        Func f;
+        f(x) = x;
+        f.specialize(p == 3).vectorize(x, 2);
+        f.specialize(p == 0).vectorize(x, 4);
+        f.specialize(p == 5).vectorize(x, 8);
+        f.specialize(p == 1).vectorize(x, 16);
+        f.specialize(p == 2).vectorize(x, 32);
+        f.specialize(p == 4).vectorize(x, 64);
+        f.specialize_fail("Unhandled Param value encountered.");
+
+        f.set_custom_trace(&my_trace);
+        f.trace_stores();
+
+        const int expected_lanes[] = {4, 16, 32, 2, 64, 8};
+        for (int i = 0; i < 6; i++) {
+            vector_store_lanes = 0;
+            p.set(i);
+            f.realize(128);
+            _halide_user_assert(vector_store_lanes == expected_lanes[i]);
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -383,6 +383,42 @@ int main(int argc, char **argv) {
         }
     }
 
+    {
+        custom_malloc_size = 0;
+        Func f, g;
+
+        f(x, y) = x * y;
+        g(x, y) = f(x-1, y+1) + f(x, y-1);
+        Var yo, yi;
+        g.split(y, yo, yi, 16).parallel(yo);
+        f.store_root().compute_at(g, yi);
+
+        // The producer slides over a serial loop inside a parallel
+        // loop, and no values pass between the parallel iterations
+        // through it, so each iteration should get a private folded
+        // copy instead of all sharing one full-size buffer.
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        Buffer<int> im = g.realize(100, 1000);
+
+        size_t expected_size = 101*4*sizeof(int) + sizeof(int);
+        if (custom_malloc_size == 0 || custom_malloc_size != expected_size) {
+            printf("Scratch space allocated was %d instead of %d\n", (int)custom_malloc_size, (int)expected_size);
+            return -1;
+        }
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = (x-1)*(y+1) + x*(y-1);
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
     {
         // Fold the storage of the output of an extern stage
         Func f, g, h;
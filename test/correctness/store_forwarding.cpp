@@ -0,0 +1,40 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // A 7-wide horizontal blur. With store_forwarding, the seven
+    // overlapping vector loads per iteration become shuffles of the
+    // two extreme loads; this just checks the transformed pipeline
+    // still computes the right thing.
+    Buffer<uint16_t> input(1024 + 6);
+    for (int i = 0; i < input.width(); i++) {
+        input(i) = (uint16_t)(i * 17 + 123);
+    }
+
+    Func blur("blur");
+    Var x("x");
+    Expr sum = cast<uint16_t>(0);
+    for (int i = 0; i < 7; i++) {
+        sum = sum + input(x + i);
+    }
+    blur(x) = sum;
+
+    blur.vectorize(x, 8).store_forwarding();
+
+    Buffer<uint16_t> out = blur.realize(1024);
+    for (int x = 0; x < out.width(); x++) {
+        uint16_t correct = 0;
+        for (int i = 0; i < 7; i++) {
+            correct += input(x + i);
+        }
+        if (out(x) != correct) {
+            printf("out(%d) = %d instead of %d\n", x, out(x), correct);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // A small per-tile intermediate forced onto the stack.
+    {
+        Func f, g;
+        Var x, y, xo, yo, xi, yi;
+
+        f(x, y) = x + y;
+        g(x, y) = f(x, y) * 2;
+
+        g.tile(x, y, xo, yo, xi, yi, 8, 8);
+        f.compute_at(g, xo).store_in(MemoryType::Stack);
+
+        Buffer<int> im = g.realize(64, 64);
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = (x + y) * 2;
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // An intermediate small enough for the stack promotion heuristic,
+    // forced onto the heap instead.
+    {
+        Func f, g;
+        Var x, y;
+
+        f(x, y) = x * y;
+        g(x, y) = f(x, y) + f(x, y + 1);
+
+        f.compute_at(g, y).store_in(MemoryType::Heap);
+
+        Buffer<int> im = g.realize(32, 32);
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = x * y + x * (y + 1);
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
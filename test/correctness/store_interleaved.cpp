@@ -0,0 +1,80 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    {
+        // Complex multiplication through an interleaved intermediate.
+        Func cplx("cplx"), out("out");
+        cplx(x, y) = Tuple(x + y, x - y);
+        cplx.compute_root().store_interleaved();
+
+        // (a + bi) * (a + bi) = (a*a - b*b) + 2*a*b*i
+        Expr re = cplx(x, y)[0], im = cplx(x, y)[1];
+        out(x, y) = re * re - im * im + 2 * re * im;
+        out.vectorize(x, 8);
+
+        Buffer<int> result = out.realize(64, 30);
+        for (int yy = 0; yy < 30; yy++) {
+            for (int xx = 0; xx < 64; xx++) {
+                int a = xx + yy, b = xx - yy;
+                int correct = a * a - b * b + 2 * a * b;
+                if (result(xx, yy) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n",
+                           xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // An update definition that swaps the elements in-place. The
+        // boxes provided and required overlap, so the stores must
+        // happen atomically per point.
+        Func f("f"), g("g");
+        f(x, y) = Tuple(x * 3, y * 5);
+        f(x, y) = Tuple(f(x, y)[1], f(x, y)[0]);
+        f.compute_root().store_interleaved();
+        g(x, y) = f(x, y)[0] + f(x, y)[1] * 2;
+
+        Buffer<int> result = g.realize(20, 15);
+        for (int yy = 0; yy < 15; yy++) {
+            for (int xx = 0; xx < 20; xx++) {
+                int correct = yy * 5 + xx * 3 * 2;
+                if (result(xx, yy) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n",
+                           xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Interleaving composes with align_storage on the explicit
+        // dimensions, and with a compute_at producer.
+        Func f("f"), g("g");
+        f(x, y) = Tuple(cast<float>(x), cast<float>(y));
+        g(x, y) = f(x, y)[0] * f(x, y)[1];
+        f.compute_at(g, y).store_interleaved().align_storage(x, 16);
+
+        Buffer<float> result = g.realize(50, 40);
+        for (int yy = 0; yy < 40; yy++) {
+            for (int xx = 0; xx < 50; xx++) {
+                float correct = (float)xx * yy;
+                if (result(xx, yy) != correct) {
+                    printf("result(%d, %d) = %f instead of %f\n",
+                           xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y"), c("c");
+
+    {
+        // A transpose-flavored consumer over a tiled producer, with
+        // extents the tile size doesn't divide.
+        Func f("f"), g("g");
+        f(x, y) = x * 3 + y * 7;
+        f.compute_root().store_tiled(x, y, 8, 8);
+        g(x, y) = f(y, x) + f(x, y);
+
+        Buffer<int> result = g.realize(75, 75);
+        for (int yy = 0; yy < 75; yy++) {
+            for (int xx = 0; xx < 75; xx++) {
+                int correct = (yy * 3 + xx * 7) + (xx * 3 + yy * 7);
+                if (result(xx, yy) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n",
+                           xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // An untiled dimension stored inside the tiled ones, a
+        // non-power-of-two tile, and an update definition.
+        Func f("f"), g("g");
+        f(c, x, y) = c + x * 5 + y * 11;
+        f(c, x, y) += 1;
+        f.compute_root().store_tiled(x, y, 6, 4);
+        g(c, x, y) = f(c, x, y) * 2;
+
+        Buffer<int> result = g.realize(3, 20, 15);
+        for (int yy = 0; yy < 15; yy++) {
+            for (int xx = 0; xx < 20; xx++) {
+                for (int cc = 0; cc < 3; cc++) {
+                    int correct = (cc + xx * 5 + yy * 11 + 1) * 2;
+                    if (result(cc, xx, yy) != correct) {
+                        printf("result(%d, %d, %d) = %d instead of %d\n",
+                               cc, xx, yy, result(cc, xx, yy), correct);
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    {
+        // Tiling composes with reorder_storage.
+        Func f("f"), g("g");
+        f(x, y) = x - y;
+        f.compute_root().reorder_storage(y, x).store_tiled(x, y, 16, 4);
+        g(x, y) = f(x, y) + f(clamp(x + 3, 0, 49), clamp(y + 5, 0, 39));
+
+        Buffer<int> result = g.realize(50, 40);
+        for (int yy = 0; yy < 40; yy++) {
+            for (int xx = 0; xx < 50; xx++) {
+                int x2 = std::min(xx + 3, 49), y2 = std::min(yy + 5, 39);
+                int correct = (xx - yy) + (x2 - y2);
+                if (result(xx, yy) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n",
+                           xx, yy, result(xx, yy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (!target.has_gpu_feature()) {
+        printf("No GPU target enabled. Skipping test.\n");
+        return 0;
+    }
+
+    Var x("x"), y("y"), yo("yo"), yi("yi"), xi("xi"), yii("yii");
+
+    {
+        // Slice the output into slabs along y with a serial host loop
+        // around the device loops, and stream each slab back to the
+        // host as it completes.
+        Func f("f");
+        f(x, y) = x * 3 + y * 7;
+
+        f.split(y, yo, yi, 16)
+            .gpu_tile(x, yi, xi, yii, 8, 8)
+            .stream_readback(4);
+
+        Buffer<int> out = f.realize(128, 128, target);
+        for (int cy = 0; cy < out.height(); cy++) {
+            for (int cx = 0; cx < out.width(); cx++) {
+                int correct = cx * 3 + cy * 7;
+                if (out(cx, cy) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n",
+                           cx, cy, out(cx, cy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // More slices than slabs just issues one read-back per slab.
+        Func g("g");
+        g(x, y) = x + y;
+
+        g.split(y, yo, yi, 32)
+            .gpu_tile(x, yi, xi, yii, 8, 8)
+            .stream_readback(100);
+
+        Buffer<int> out = g.realize(64, 64, target);
+        for (int cy = 0; cy < out.height(); cy++) {
+            for (int cx = 0; cx < out.width(); cx++) {
+                int correct = cx + cy;
+                if (out(cx, cy) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n",
+                           cx, cy, out(cx, cy), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "Halide.h"
+#include <stdio.h>
+
+#include "halide_streaming_sink.h"
+#include "test/common/halide_test_dirs.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int width = 128, height = 100, rows_per_block = 16;
+    const int blocks = (height + rows_per_block - 1) / rows_per_block;
+
+    std::string path = Internal::get_test_tmp_dir() + "halide_test_streaming_sink.bin";
+    Internal::ensure_no_file_exists(path);
+
+    {
+        Tools::StreamingFileSink sink(path);
+
+        Var x, y, s;
+        Func f;
+        f(x, y) = cast<uint8_t>(x * 3 + y * 7);
+
+        Func write_out("write_out");
+        write_out.define_extern("halide_streaming_file_sink",
+                                {Expr(sink.handle()), width, height, rows_per_block, f},
+                                Int(32), 1);
+
+        // Walk the blocks serially so each one is handed to the
+        // writer as soon as it is computed, instead of staging the
+        // whole frame first.
+        Func done("done");
+        done(s) = write_out(s);
+        write_out.compute_at(done, s);
+        f.compute_at(done, s);
+
+        Buffer<int> status = done.realize(blocks);
+        for (int i = 0; i < blocks; i++) {
+            if (status(i) != 0) {
+                printf("Block %d reported write failure\n", i);
+                return -1;
+            }
+        }
+
+        if (!sink.finish()) {
+            printf("The sink reported an I/O error\n");
+            return -1;
+        }
+    }
+
+    Internal::assert_file_exists(path);
+    FILE *f = fopen(path.c_str(), "rb");
+    std::vector<uint8_t> result(width * height);
+    size_t read = fread(result.data(), 1, result.size(), f);
+    fclose(f);
+    if (read != result.size()) {
+        printf("Expected %d bytes in the file, got %d\n",
+               (int)result.size(), (int)read);
+        return -1;
+    }
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t correct = (uint8_t)(x * 3 + y * 7);
+            if (result[y * width + x] != correct) {
+                printf("file[%d, %d] = %d instead of %d\n",
+                       x, y, result[y * width + x], correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
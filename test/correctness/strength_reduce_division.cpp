@@ -0,0 +1,84 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <limits>
+#include <vector>
+
+using namespace Halide;
+
+// Division and modulo by a loop-invariant denominator get rewritten
+// during lowering into a multiply-shift with magic numbers computed
+// at runtime. Check that the results still satisfy the requirements
+// of Euclidean division for denominators only known at realization
+// time, including the awkward ones.
+
+template<typename T>
+bool test(const std::vector<T> &denominators, int vector_width) {
+    T minval = std::numeric_limits<T>::min();
+
+    Var x;
+    Param<T> d;
+    Func f;
+    // Covers the full range of T as x increases, but avoid the most
+    // negative value, which has no quotient when dividing by -1.
+    Expr num = max(cast<T>(x * 7 - 1234), cast<T>(minval + 1));
+    f(x) = Tuple(num / d, num % d);
+    if (vector_width > 1) {
+        f.vectorize(x, vector_width);
+    }
+
+    for (T den : denominators) {
+        d.set(den);
+        Realization R = f.realize(1024);
+        Buffer<T> q(R[0]);
+        Buffer<T> r(R[1]);
+        for (int i = 0; i < 1024; i++) {
+            T n = (T)(i * 7 - 1234);
+            if (n == minval) {
+                n = (T)(minval + 1);
+            }
+            int64_t abs_den = std::abs((int64_t)den);
+            if ((T)((int64_t)q(i) * den + r(i)) != n ||
+                r(i) < 0 ||
+                (int64_t)r(i) >= abs_den) {
+                printf("(%lld / %lld, %lld %% %lld) = (%lld, %lld) at width %d\n",
+                       (long long)n, (long long)den,
+                       (long long)n, (long long)den,
+                       (long long)q(i), (long long)r(i),
+                       vector_width);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool test_unsigned() {
+    T maxval = std::numeric_limits<T>::max();
+    std::vector<T> denominators =
+        {1, 2, 3, 7, 10, 100, 128, (T)(maxval / 2 + 1), (T)(maxval - 1), maxval};
+    return test<T>(denominators, 1) && test<T>(denominators, 8);
+}
+
+template<typename T>
+bool test_signed() {
+    T minval = std::numeric_limits<T>::min();
+    T maxval = std::numeric_limits<T>::max();
+    std::vector<T> denominators =
+        {1, -1, 2, -2, 3, -3, 7, -7, 100, -100, maxval, (T)(minval + 1), minval};
+    return test<T>(denominators, 1) && test<T>(denominators, 8);
+}
+
+int main(int argc, char **argv) {
+    if (!test_unsigned<uint8_t>() ||
+        !test_unsigned<uint16_t>() ||
+        !test_unsigned<uint32_t>() ||
+        !test_signed<int8_t>() ||
+        !test_signed<int16_t>() ||
+        !test_signed<int32_t>()) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
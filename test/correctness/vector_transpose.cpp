@@ -0,0 +1,57 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// An in-register transpose: break the image into tiles, transpose
+// within each tile with a vectorized and unrolled stage, then untile
+// with x % t, x / t index math. The strided stores and loads this
+// produces should lower to networks of even/odd shuffles (see
+// Deinterleave.cpp) for power-of-two tile sizes up to 16. This test
+// locks in the correctness of that lowering.
+
+int test(int tile) {
+    const int size = 64;
+
+    Buffer<int> input(size, size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            input(x, y) = x * 1000 + y;
+        }
+    }
+
+    Var x("x"), y("y"), xo("xo"), yo("yo");
+
+    Func tiled("tiled"), tiledT("tiledT"), out("out");
+    tiled(x, y, xo, yo) = input(xo * tile + x, yo * tile + y);
+    tiledT(y, x, xo, yo) = tiled(x, y, xo, yo);
+    out(y, x) = tiledT(y % tile, x % tile, x / tile, y / tile);
+
+    // Dense vector loads, strided stores within each tile...
+    tiledT.compute_root().vectorize(x).unroll(y);
+    // ...and strided loads when untiling.
+    out.vectorize(y, tile);
+
+    Buffer<int> result = out.realize(size, size);
+    for (int xx = 0; xx < size; xx++) {
+        for (int yy = 0; yy < size; yy++) {
+            if (result(yy, xx) != input(xx, yy)) {
+                printf("tile size %d: result(%d, %d) = %d instead of %d\n",
+                       tile, yy, xx, result(yy, xx), input(xx, yy));
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    for (int tile : {4, 8, 16}) {
+        if (test(tile) != 0) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // Vectorized loads with dynamic indices. On x86 with avx2 these
+    // become native gather instructions; everywhere else they
+    // scalarize. Either way the values must match.
+    Buffer<int> lut(256);
+    Buffer<float> lut_f(256);
+    for (int i = 0; i < 256; i++) {
+        lut(i) = i * 17 + 3;
+        lut_f(i) = i * 0.25f - 8.0f;
+    }
+
+    Func f("f");
+    Var x("x");
+    Expr idx = (x * 7 + 5) % 256;
+    f(x) = Tuple(lut(idx), lut_f(255 - idx));
+    f.vectorize(x, 8);
+
+    Realization r = f.realize(1024);
+    Buffer<int> out = r[0];
+    Buffer<float> out_f = r[1];
+    for (int x = 0; x < out.width(); x++) {
+        int idx = (x * 7 + 5) % 256;
+        int correct = idx * 17 + 3;
+        float correct_f = (255 - idx) * 0.25f - 8.0f;
+        if (out(x) != correct) {
+            printf("out(%d) = %d instead of %d\n", x, out(x), correct);
+            return -1;
+        }
+        if (out_f(x) != correct_f) {
+            printf("out_f(%d) = %f instead of %f\n", x, out_f(x), correct_f);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
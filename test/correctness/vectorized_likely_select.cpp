@@ -0,0 +1,66 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// A vectorized select with a likely arm may lower to a branch that
+// skips the expensive arm when every lane takes the likely one. The
+// result must not depend on whether any given vector takes the fast
+// path, the slow path, or straddles the two.
+
+int main(int argc, char **argv) {
+    const int N = 1024;
+
+    Buffer<float> input(N);
+    for (int i = 0; i < N; i++) {
+        // Mostly small values (the likely case), with occasional
+        // large ones scattered so that some vectors are all-likely,
+        // some all-unlikely, and some mixed.
+        if (i % 100 < 3 || (i > 500 && i < 520)) {
+            input(i) = 1000.0f + i;
+        } else {
+            input(i) = (i % 17) * 0.25f;
+        }
+    }
+
+    ImageParam in(Float(32), 1);
+    Var x;
+
+    // The unlikely arm is deliberately much more expensive than the
+    // likely one, so the cost model chooses to branch.
+    Expr v = in(x);
+    Expr cheap = v * 2.0f;
+    Expr expensive = sqrt(v) + sin(v) * cos(v) + pow(v, 0.3f) + log(v);
+    Func f;
+    f(x) = select(v < 100.0f, likely(cheap), expensive);
+    f.vectorize(x, 8);
+
+    in.set(input);
+    Buffer<float> result = f.realize(N);
+
+    for (int i = 0; i < N; i++) {
+        float v = input(i);
+        float correct = v < 100.0f ? v * 2.0f
+                                   : sqrtf(v) + sinf(v) * cosf(v) + powf(v, 0.3f) + logf(v);
+        if (fabs(result(i) - correct) > 1e-4f * fabs(correct)) {
+            printf("result(%d) = %f instead of %f\n", i, result(i), correct);
+            return -1;
+        }
+    }
+
+    // The same thing with the likely tag on the false arm.
+    Func g;
+    g(x) = select(v >= 100.0f, expensive, likely(cheap));
+    g.vectorize(x, 8);
+
+    Buffer<float> result2 = g.realize(N);
+    for (int i = 0; i < N; i++) {
+        if (result2(i) != result(i)) {
+            printf("result2(%d) = %f instead of %f\n", i, result2(i), result(i));
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
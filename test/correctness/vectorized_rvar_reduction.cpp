@@ -0,0 +1,102 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// Vectorizing an update over its RVar makes every lane hit the same
+// store site, so it requires allow_race_conditions(). For associative
+// updates the lowering recognizes the pattern and reduces across the
+// lanes instead of racing, so the result should actually be correct,
+// and fast.
+
+int main(int argc, char **argv) {
+    {
+        // A summation, in several types and widths. u8 summed into
+        // u16 is the case x86 has a dedicated instruction for.
+        Func in("in");
+        Var x;
+        in(x) = cast<uint8_t>(x * 7 + 3);
+        in.compute_root();
+
+        RDom r(0, 100);
+        Func f;
+        f() = cast<uint16_t>(0);
+        f() += cast<uint16_t>(in(r));
+        f.update().allow_race_conditions().vectorize(r, 8);
+
+        uint16_t correct = 0;
+        for (int i = 0; i < 100; i++) {
+            correct += (uint8_t)(i * 7 + 3);
+        }
+
+        Buffer<uint16_t> out = f.realize();
+        if (out() != correct) {
+            printf("sum = %d instead of %d\n", out(), correct);
+            return -1;
+        }
+    }
+
+    {
+        // A float dot product. Vectorizing reorders the summation,
+        // which allow_race_conditions() permits.
+        Func a("a"), b("b");
+        Var x;
+        a(x) = sin(x);
+        b(x) = cos(x);
+        a.compute_root();
+        b.compute_root();
+
+        RDom r(0, 128);
+        Func dot;
+        dot() = 0.0f;
+        dot() += a(r) * b(r);
+        dot.update().allow_race_conditions().vectorize(r, 4);
+
+        float correct = 0;
+        for (int i = 0; i < 128; i++) {
+            correct += sinf(i) * cosf(i);
+        }
+
+        Buffer<float> out = dot.realize();
+        if (fabs(out() - correct) > 1e-3f) {
+            printf("dot product = %f instead of %f\n", out(), correct);
+            return -1;
+        }
+    }
+
+    {
+        // Min and max, with a vector width that doesn't divide the
+        // reduction extent.
+        Func in("in");
+        Var x;
+        in(x) = (x * 123457) % 1001;
+        in.compute_root();
+
+        RDom r(0, 99);
+        Func lo, hi;
+        lo() = 100000;
+        lo() = min(lo(), in(r));
+        lo.update().allow_race_conditions().vectorize(r, 8);
+        hi() = -100000;
+        hi() = max(hi(), in(r));
+        hi.update().allow_race_conditions().vectorize(r, 8);
+
+        int correct_lo = 100000, correct_hi = -100000;
+        for (int i = 0; i < 99; i++) {
+            int v = (i * 123457) % 1001;
+            correct_lo = std::min(correct_lo, v);
+            correct_hi = std::max(correct_hi, v);
+        }
+
+        Buffer<int> lo_out = lo.realize();
+        Buffer<int> hi_out = hi.realize();
+        if (lo_out() != correct_lo || hi_out() != correct_hi) {
+            printf("min/max = %d, %d instead of %d, %d\n",
+                   lo_out(), hi_out(), correct_lo, correct_hi);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
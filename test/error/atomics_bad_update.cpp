@@ -0,0 +1,27 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func in, hist;
+    Var x, y;
+
+    in(x, y) = (x + y) % 16;
+    in.compute_root();
+
+    hist(x) = 1;
+    RDom r(0, 10, 0, 10);
+    hist(in(r.x, r.y)) *= 2;
+
+    // A multiply is not a supported atomic read-modify-write, so
+    // lowering this schedule should fail.
+    hist.update().atomic().parallel(r.y);
+
+    hist.realize(16);
+
+    // We shouldn't reach here, because there should have been a compile error.
+    printf("There should have been an error\n");
+
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x, y;
+
+    Func f, g;
+
+    f(x, y) = x;
+    g(x, y) = f(x - 1, y) + f(x + 1, y);
+
+    // It's not possible to slide over a parallel loop; its iterations
+    // would have to consume each other's results.
+    g.parallel(y);
+    f.store_root().compute_at(g, y).slide_over(y);
+
+    Buffer<int> im = g.realize(100, 100);
+
+    printf("Should have gotten a bad slide_over!\n");
+    return -1;
+}
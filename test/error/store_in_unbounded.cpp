@@ -0,0 +1,21 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f, g;
+    Var x, y;
+
+    f(x, y) = x + y;
+    g(x, y) = f(x, y) * 2;
+
+    // The size of f's realization depends on the output size, so it
+    // can't be promoted to a stack allocation.
+    f.compute_root().store_in(MemoryType::Stack);
+
+    Buffer<int> im = g.realize(64, 64);
+
+    printf("Should have gotten an error about a non-constant stack allocation!\n");
+    return -1;
+}
@@ -0,0 +1,24 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f("f"), g("g");
+    Var x("x"), y("y"), yo("yo"), yi("yi");
+
+    f(x, y) = x + y;
+    g(x, y) = f(x, y) * 2;
+
+    g.split(y, yo, yi, 8);
+
+    // g has no loop over a variable called z, so the pre-check should
+    // reject this immediately, without running lowering.
+    f.compute_at(g, Var("z"));
+
+    Pipeline p(g);
+    p.validate_schedule();
+
+    printf("Success!\n");
+    return 0;
+}
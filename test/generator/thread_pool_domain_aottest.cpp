@@ -0,0 +1,112 @@
+#include "HalideRuntime.h"
+#include "HalideBuffer.h"
+
+#include <atomic>
+#include <stdio.h>
+
+#include "thread_pool_domain.h"
+
+using namespace Halide::Runtime;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+std::atomic<int> active{0};
+std::atomic<int> max_active{0};
+
+extern "C" DLLEXPORT int track_concurrency(int x) {
+    int now = ++active;
+    int seen = max_active;
+    while (now > seen && !max_active.compare_exchange_weak(seen, now)) {
+    }
+    // Do a little work so the tasks actually overlap.
+    for (volatile int i = 0; i < 10000; i++) {
+    }
+    active--;
+    return x;
+}
+
+int errors_reported = 0;
+void record_error(void *user_context, const char *msg) {
+    errors_reported++;
+}
+
+int main(int argc, char **argv) {
+    const int W = 256, H = 256;
+    Buffer<int> out(W, H);
+
+    halide_set_num_threads(8);
+
+    // The cap is only best-effort under the work-stealing schedule,
+    // so use the static schedule, which hands out every task range
+    // under the work queue lock.
+    halide_set_parallel_schedule(halide_parallel_schedule_static);
+
+    if (halide_define_thread_pool_domain("background", 2) != 0) {
+        printf("Defining a domain unexpectedly failed\n");
+        return -1;
+    }
+    if (halide_set_thread_pool_domain("background") != 0) {
+        printf("Selecting a defined domain unexpectedly failed\n");
+        return -1;
+    }
+
+    max_active = 0;
+    int ret = thread_pool_domain(out);
+    if (ret) {
+        printf("Non zero exit code: %d\n", ret);
+        return -1;
+    }
+    if (max_active > 2) {
+        printf("Saw %d tasks running at once in a domain capped at 2 threads\n",
+               (int)max_active);
+        return -1;
+    }
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int correct = x + y * 256;
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    // Redefining a domain updates its budget in place.
+    if (halide_define_thread_pool_domain("background", 4) != 0) {
+        printf("Redefining a domain unexpectedly failed\n");
+        return -1;
+    }
+
+    // Deselecting the domain removes the cap again.
+    if (halide_set_thread_pool_domain(NULL) != 0) {
+        printf("Deselecting the domain unexpectedly failed\n");
+        return -1;
+    }
+
+    max_active = 0;
+    ret = thread_pool_domain(out);
+    if (ret) {
+        printf("Non zero exit code: %d\n", ret);
+        return -1;
+    }
+
+    // Selecting an undefined domain is an error and leaves the
+    // current selection alone.
+    halide_set_error_handler(&record_error);
+    if (halide_set_thread_pool_domain("no_such_domain") == 0 ||
+        errors_reported != 1) {
+        printf("Selecting an undefined domain did not report an error\n");
+        return -1;
+    }
+    halide_set_error_handler(NULL);
+
+    halide_set_parallel_schedule(halide_parallel_schedule_stealing);
+
+    printf("Success!\n");
+    return 0;
+}
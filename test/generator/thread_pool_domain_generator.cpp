@@ -0,0 +1,23 @@
+#include "Halide.h"
+
+namespace {
+
+HalideExtern_1(int, track_concurrency, int);
+
+class ThreadPoolDomain : public Halide::Generator<ThreadPoolDomain> {
+public:
+    Output<Buffer<int>> output{"output", 2};
+
+    void generate() {
+        // One task per row, each of which calls out to the test
+        // harness so it can measure how many tasks run at once.
+        Var x, y;
+
+        output(x, y) = track_concurrency(x + y * 256);
+        output.parallel(y);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(ThreadPoolDomain, thread_pool_domain)
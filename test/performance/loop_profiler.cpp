@@ -0,0 +1,51 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+float func_ms = 0;
+float loop_ms = 0;
+
+void my_print(void *, const char *msg) {
+    float this_ms;
+    char buf[256];
+    // Per-Func line, e.g. " f: 1.5ms (99%)"
+    if (sscanf(msg, " f: %fms", &this_ms) == 1) {
+        func_ms += this_ms;
+    }
+    // Per-loop line, e.g. "   f.s0.y: 1.2ms (80%)"
+    if (sscanf(msg, " f.s0.%255s %fms", buf, &this_ms) == 2) {
+        loop_ms += this_ms;
+    }
+}
+
+int main(int argc, char **argv) {
+    // A single expensive Func with a vectorized steady state and a
+    // scalar tail. Loop-level profiling should attribute nearly all
+    // of the time to the loops inside f, not just to f as a whole.
+    Func f("f");
+    Var x("x"), y("y");
+    Expr e = cast<float>(x + y);
+    for (int i = 0; i < 100; i++) {
+        e = sin(e);
+    }
+    f(x, y) = e;
+    f.vectorize(x, 8);
+
+    f.set_custom_print(&my_print);
+
+    Target t = get_jit_target_from_environment().with_feature(Target::ProfileLoops);
+    Buffer<float> im = f.realize(500, 500, t);
+
+    printf("Time attributed to loops inside f: %fms (f itself: %fms)\n",
+           loop_ms, func_ms);
+
+    if (loop_ms == 0) {
+        printf("No samples were attributed to any loop of f. "
+               "Loop-level profiling doesn't seem to be working.\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
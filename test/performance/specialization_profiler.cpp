@@ -0,0 +1,74 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// The hit count reported for each branch of the specialization
+// ladder, indexed by the value of p_val the branch tests for.
+int hits[2] = {0, 0};
+int spurious_lines = 0;
+
+void my_print(void *, const char *msg) {
+    int which, this_hits;
+    if (sscanf(msg, " f.s0 specialized on (p_val == %d): %d hits",
+               &which, &this_hits) == 2) {
+        if (which == 0 || which == 1) {
+            hits[which] = this_hits;
+        } else {
+            spurious_lines++;
+        }
+    }
+}
+
+void reset_stats() {
+    hits[0] = hits[1] = 0;
+    spurious_lines = 0;
+}
+
+int main(int argc, char **argv) {
+    Param<int> p("p_val");
+
+    Func f("f");
+    Var x("x");
+    f(x) = x * p;
+    f.specialize(p == 0);
+    f.specialize(p == 1).vectorize(x, 8);
+
+    f.set_custom_print(&my_print);
+    Target t = get_jit_target_from_environment().with_feature(Target::Profile);
+
+    // The profiler reports and resets after each jitted call, so each
+    // realize should report exactly one hit for the branch taken.
+    struct {
+        int param;
+        int expected_hits_0, expected_hits_1;
+    } trials[] = {
+        {1, 0, 1},
+        {0, 1, 0},
+        {7, 0, 0},  // Falls through to the default schedule
+    };
+
+    for (auto &trial : trials) {
+        reset_stats();
+        p.set(trial.param);
+        Buffer<int> im = f.realize(100, t);
+        for (int i = 0; i < im.width(); i++) {
+            if (im(i) != i * trial.param) {
+                printf("im(%d) = %d instead of %d\n", i, im(i), i * trial.param);
+                return -1;
+            }
+        }
+        if (hits[0] != trial.expected_hits_0 ||
+            hits[1] != trial.expected_hits_1 ||
+            spurious_lines != 0) {
+            printf("For p_val = %d, expected hit counts {%d, %d}, got {%d, %d} "
+                   "with %d spurious specialization lines\n",
+                   trial.param, trial.expected_hits_0, trial.expected_hits_1,
+                   hits[0], hits[1], spurious_lines);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -745,13 +745,25 @@ Arguments:
         some_input_buffer=/path/to/existing/file.png
         some_output_buffer=/path/to/create/output/file.png
 
-    We currently support JPG, PGM, PNG, PPM format. If the type or dimensions
-    of the input or output file type can't support the data (e.g., your filter
-    uses float32 input and output, and you load/save to PNG), we'll use the most
-    robust approximation within the format and issue a warning to stdout.
+    We currently support HCT, JPG, MAT, PGM, PNG, PPM, and TMP formats. If the type
+    or dimensions of the input or output file type can't support the data
+    (e.g., your filter uses float32 input and output, and you load/save to
+    PNG), we'll use the most robust approximation within the format and issue
+    a warning to stdout.
+
+    TMP (the raw planar format used by the ImageStack tool) is by far the
+    fastest input format: it supports every Halide type directly, and on
+    POSIX systems the loader maps the file and wraps the pages zero-copy.
+    Prefer it for large inputs when benchmarking.
+
+    HCT is a raw planar chunked tensor container: the payload is split
+    into independently-seekable chunks along the outermost dimension. It
+    supports every Halide type and any number of dimensions, and is the
+    format used by --stream (see below) for data too large to hold in
+    memory all at once.
 
     (We anticipate adding other image formats in the future, in particular,
-    TIFF and TMP.)
+    TIFF.)
 
     For inputs, there are also "pseudo-file" specifiers you can use; currently
     supported are
@@ -794,6 +806,26 @@ Flags:
         runs "samples" sets of "iterations" each, and chooses the fastest
         sample set.
 
+    --benchmarks=steady_state:
+        Measure steady-state behavior instead: run a few untimed warmup
+        calls (which pay one-time costs like device buffer allocation and
+        host-to-device copies), then time each call individually with no
+        reallocation or copying between calls, and report percentile
+        latencies (min/p50/p90/p99/max). For GPU targets this matches a
+        production loop whose data stays device-resident; use
+        --benchmark_include_copies to measure the copy-in/copy-out loop
+        instead.
+
+    --benchmark_warmup_iters=NUM [default = 1]:
+        Number of untimed warmup calls before steady-state measurement;
+        ignored unless --benchmarks=steady_state is specified.
+
+    --benchmark_include_copies:
+        In steady-state mode, mark the input buffers dirty before each
+        timed call (forcing a fresh host-to-device copy) and copy the
+        outputs back to the host inside the timed region; ignored unless
+        --benchmarks=steady_state is specified.
+
     --benchmark_min_time=DURATION_SECONDS [default = 0.1]:
         Override the default minimum desired benchmarking time; ignored if
         --benchmarks is not also specified.
@@ -811,6 +843,18 @@ Flags:
         allocation during run; note that this may slow down execution, so
         benchmarks may be inaccurate if you combine --benchmark with this.
 
+    --stream:
+        Process .hct inputs one chunk at a time instead of loading them
+        whole: for each chunk, the chunk is read from disk, a bounds
+        query is run, the filter is invoked, and the output chunks are
+        appended to the output files. Only one chunk of input and output
+        is ever resident, so inputs can be much larger than memory. All
+        outputs must be .hct files, and the filter must not require
+        input from outside the current chunk (i.e., no stencils across
+        the chunked dimension); we detect this via the bounds query and
+        fail rather than produce incorrect results. Not compatible with
+        --benchmarks, --track_memory, or --output_extents.
+
 Known Issues:
 
     * Filters running on GPU (vs CPU) have not been tested.
@@ -866,6 +910,224 @@ FormatInfo best_save_format(const Buffer<> &b, const std::set<FormatInfo> &info)
     return best;
 }
 
+bool is_hct_path(const std::string &path) {
+    return Halide::Tools::Internal::get_lowercase_extension(path) == "hct";
+}
+
+// Streamed (.hct) execution: run the filter once per chunk of the
+// streamed inputs, so that only one chunk of input and output is ever
+// resident in memory. Scalar inputs and non-.hct buffer inputs (e.g. a
+// LUT) have already been loaded whole; each .hct input is read one
+// chunk at a time, positioned at its place in the outermost dimension,
+// and a fresh bounds query is run per chunk. Outputs are appended
+// chunk-by-chunk to .hct files whose headers are rewritten at the end,
+// once the total output extent is known.
+int run_streamed(std::map<std::string, ArgData> &args) {
+    using Halide::Tools::Internal::ChunkedTensorDesc;
+    using Halide::Tools::Internal::FileOpener;
+    using Halide::Tools::Internal::buffer_is_compact_planar;
+    using Halide::Tools::Internal::hct_read_desc;
+    using Halide::Tools::Internal::hct_seek;
+    using Halide::Tools::Internal::hct_write_desc;
+
+    struct StreamedInput {
+        ArgData *arg;
+        std::shared_ptr<FileOpener> file;
+        ChunkedTensorDesc desc;
+    };
+    struct StreamedOutput {
+        ArgData *arg;
+        std::shared_ptr<FileOpener> file;
+        ChunkedTensorDesc desc;
+        uint64_t header_bytes{0};
+        int64_t total_slices{0};
+    };
+
+    std::vector<StreamedInput> ins;
+    std::vector<StreamedOutput> outs;
+    for (auto &arg_pair : args) {
+        auto &arg = arg_pair.second;
+        if (arg.metadata->kind == halide_argument_kind_input_buffer &&
+            is_hct_path(arg.raw_string)) {
+            StreamedInput in;
+            in.arg = &arg;
+            in.file = std::make_shared<FileOpener>(arg.raw_string, "rb");
+            if (in.file->f == nullptr) {
+                fail() << "File could not be opened for reading: " << arg.raw_string;
+            }
+            if (!hct_read_desc<IOCheckFail>(*in.file, &in.desc)) {
+                fail() << "Unable to read: " << arg.raw_string;
+            }
+            if ((int) in.desc.extents.size() != arg.metadata->dimensions) {
+                fail() << "Streamed input " << arg.metadata->name << " has "
+                     << in.desc.extents.size() << " dimensions, but this argument requires "
+                     << arg.metadata->dimensions << " dimensions.";
+            }
+            if (in.desc.type != arg.metadata->type) {
+                fail() << "Streamed input " << arg.metadata->name << " is of type "
+                     << in.desc.type << " but this argument expects type "
+                     << arg.metadata->type << "; type conversion is not supported when streaming.";
+            }
+            ins.push_back(in);
+        } else if (arg.metadata->kind == halide_argument_kind_output_buffer) {
+            if (!is_hct_path(arg.raw_string)) {
+                fail() << "--stream requires all outputs to be .hct files, but output "
+                     << arg.metadata->name << " is: " << arg.raw_string;
+            }
+            StreamedOutput out;
+            out.arg = &arg;
+            out.file = std::make_shared<FileOpener>(arg.raw_string, "wb");
+            if (out.file->f == nullptr) {
+                fail() << "File could not be opened for writing: " << arg.raw_string;
+            }
+            outs.push_back(out);
+        }
+    }
+
+    if (ins.empty()) {
+        fail() << "--stream requires at least one .hct buffer input.";
+    }
+    // All streamed inputs advance in lockstep, so they must agree on
+    // chunk geometry along the outermost dimension.
+    for (const auto &in : ins) {
+        if (in.desc.extents.back() != ins[0].desc.extents.back() ||
+            in.desc.chunk_extent != ins[0].desc.chunk_extent) {
+            fail() << "All streamed inputs must have the same outermost extent and chunk extent; "
+                 << in.arg->metadata->name << " does not match " << ins[0].arg->metadata->name << ".";
+        }
+    }
+    const int num_chunks = ins[0].desc.num_chunks();
+    const int outermost = (int) ins[0].desc.extents.size() - 1;
+
+    for (int c = 0; c < num_chunks; c++) {
+        info() << "Processing chunk " << c << " of " << num_chunks << "...";
+
+        // Read one chunk of each streamed input, positioned at its
+        // place in the outermost dimension.
+        Shape default_output_shape;
+        for (auto &in : ins) {
+            std::vector<int> chunk_extents(in.desc.extents.begin(), in.desc.extents.end());
+            chunk_extents.back() = in.desc.chunk_slices(c);
+            Buffer<> b = Buffer<>(in.desc.type, chunk_extents);
+            if (!hct_seek(in.file->f, in.desc.chunk_offsets[c]) ||
+                !in.file->read_bytes(b.data(), in.desc.chunk_bytes(c))) {
+                fail() << "Could not read chunk " << c << " of: " << in.arg->raw_string;
+            }
+            b.translate(outermost, in.desc.chunk_begin(c));
+            b.set_host_dirty();
+            in.arg->buffer_value = b;
+            if (default_output_shape.empty()) {
+                default_output_shape = get_shape(b);
+            }
+        }
+
+        std::vector<Shape> constrained_shapes = run_bounds_query(args, default_output_shape);
+
+        // The bounds query tells us the region the filter needs from
+        // each input for this chunk's output; if that extends beyond
+        // the chunk itself, streaming can't produce correct results.
+        for (auto &in : ins) {
+            const halide_dimension_t &dim = constrained_shapes[in.arg->index].back();
+            const int begin = in.desc.chunk_begin(c);
+            const int end = begin + in.desc.chunk_slices(c);
+            if (dim.extent != 0 && (dim.min < begin || dim.min + dim.extent > end)) {
+                fail() << "The filter requires region [" << dim.min << ", " << (dim.min + dim.extent - 1)
+                     << "] of the outermost dimension of input " << in.arg->metadata->name
+                     << ", which extends outside the current chunk [" << begin << ", " << (end - 1)
+                     << "]; --stream requires pipelines whose chunks are independent"
+                     << " (no stencils across the chunked dimension).";
+            }
+        }
+
+        for (auto &arg_pair : args) {
+            auto &arg = arg_pair.second;
+            const Shape &constrained_shape = constrained_shapes[arg.index];
+            switch (arg.metadata->kind) {
+                case halide_argument_kind_input_buffer:
+                    (void) adapt_input_buffer_layout(constrained_shape, &arg.buffer_value);
+                    break;
+                case halide_argument_kind_output_buffer:
+                    arg.buffer_value = allocate_buffer(arg.metadata->type, make_legal_output_buffer_shape(constrained_shape));
+                    break;
+            }
+        }
+
+        std::vector<void*> filter_argv(args.size(), nullptr);
+        for (auto &arg_pair : args) {
+            auto &arg = arg_pair.second;
+            switch (arg.metadata->kind) {
+                case halide_argument_kind_input_scalar:
+                    filter_argv[arg.index] = &arg.scalar_value;
+                    break;
+                case halide_argument_kind_input_buffer:
+                case halide_argument_kind_output_buffer:
+                    filter_argv[arg.index] = arg.buffer_value.raw_buffer();
+                    break;
+            }
+        }
+        // Ignore result since our halide_error() should catch everything.
+        (void) halide_rungen_redirect_argv(&filter_argv[0]);
+
+        // Append each output chunk. The header is sized and skipped on
+        // the first chunk, and rewritten with the final extents after
+        // the last one.
+        for (auto &out : outs) {
+            Buffer<> &b = out.arg->buffer_value;
+            b.copy_to_host();
+            if (b.dimensions() < 1 || !buffer_is_compact_planar(b)) {
+                fail() << "--stream requires compact planar output buffers, but output "
+                     << out.arg->metadata->name << " is not.";
+            }
+            const int od = b.dimensions() - 1;
+            if (c == 0) {
+                out.desc.type = b.type();
+                for (int i = 0; i < b.dimensions(); ++i) {
+                    out.desc.extents.push_back(b.dim(i).extent());
+                }
+                out.desc.chunk_extent = b.dim(od).extent();
+                out.header_bytes = 8 + 4 + 4 + 4 + 4 * (uint64_t) out.desc.extents.size() + 4 + 8 * (uint64_t) num_chunks;
+                if (!hct_seek(out.file->f, out.header_bytes)) {
+                    fail() << "Unable to save output: " << out.arg->raw_string;
+                }
+            } else {
+                for (int i = 0; i < od; ++i) {
+                    if (b.dim(i).extent() != out.desc.extents[i]) {
+                        fail() << "Output " << out.arg->metadata->name
+                             << " changed extents between chunks; cannot stream it.";
+                    }
+                }
+                if (c < num_chunks - 1 ? (b.dim(od).extent() != out.desc.chunk_extent)
+                                       : (b.dim(od).extent() > out.desc.chunk_extent)) {
+                    fail() << "Output " << out.arg->metadata->name
+                         << " changed chunk extent between chunks; cannot stream it.";
+                }
+            }
+            if (!out.file->write_bytes(b.begin(), b.size_in_bytes())) {
+                fail() << "Unable to save output: " << out.arg->raw_string;
+            }
+            out.total_slices += b.dim(od).extent();
+        }
+    }
+
+    // Now that the total outermost extents are known, go back and
+    // write the real headers (which include the chunk offset tables).
+    for (auto &out : outs) {
+        out.desc.extents.back() = (int32_t) out.total_slices;
+        if (out.desc.num_chunks() != num_chunks ||
+            out.desc.header_bytes() != out.header_bytes) {
+            fail() << "Internal error: inconsistent chunking for output: " << out.arg->raw_string;
+        }
+        if (!hct_seek(out.file->f, 0) ||
+            !hct_write_desc<IOCheckFail>(*out.file, &out.desc)) {
+            fail() << "Unable to save output: " << out.arg->raw_string;
+        }
+        info() << "Saved output " << out.arg->metadata->name << " to " << out.arg->raw_string;
+    }
+
+    info() << "Streamed " << num_chunks << " chunks.";
+    return 0;
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -898,11 +1160,15 @@ int main(int argc, char **argv) {
     Shape default_output_shape;
     std::vector<std::string> unknown_args;
     bool benchmark = false;
+    bool benchmark_steady_state = false;
+    bool benchmark_include_copies = false;
     bool track_memory = false;
     bool describe = false;
+    bool stream = false;
     double benchmark_min_time = BenchmarkConfig().min_time;
     int benchmark_min_iters = BenchmarkConfig().min_iters;
     int benchmark_max_iters = BenchmarkConfig().max_iters;
+    int benchmark_warmup_iters = 1;
     for (int i = 1; i < argc; ++i) {
         if (argv[i][0] == '-') {
             const char *p = argv[i] + 1; // skip -
@@ -943,11 +1209,33 @@ int main(int argc, char **argv) {
                 if (!parse_scalar(flag_value, &track_memory)) {
                     fail() << "Invalid value for flag: " << flag_name;
                 }
+            } else if (flag_name == "stream") {
+                if (flag_value.empty()) {
+                    flag_value = "true";
+                }
+                if (!parse_scalar(flag_value, &stream)) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
             } else if (flag_name == "benchmarks") {
-                if (flag_value != "all") {
-                    fail() << "The only valid value for --benchmarks is 'all'";
+                if (flag_value == "all") {
+                    benchmark = true;
+                } else if (flag_value == "steady_state") {
+                    benchmark = true;
+                    benchmark_steady_state = true;
+                } else {
+                    fail() << "The only valid values for --benchmarks are 'all' and 'steady_state'";
+                }
+            } else if (flag_name == "benchmark_include_copies") {
+                if (flag_value.empty()) {
+                    flag_value = "true";
+                }
+                if (!parse_scalar(flag_value, &benchmark_include_copies)) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
+            } else if (flag_name == "benchmark_warmup_iters") {
+                if (!parse_scalar(flag_value, &benchmark_warmup_iters)) {
+                    fail() << "Invalid value for flag: " << flag_name;
                 }
-                benchmark = true;
             } else if (flag_name == "benchmark_min_time") {
                 if (!parse_scalar(flag_value, &benchmark_min_time)) {
                     fail() << "Invalid value for flag: " << flag_name;
@@ -1006,6 +1294,13 @@ int main(int argc, char **argv) {
         warn() << "Using --track_memory with --benchmarks will produce inaccurate benchmark results.";
     }
 
+    if (stream && (benchmark || track_memory)) {
+        fail() << "--stream cannot be combined with --benchmarks or --track_memory.";
+    }
+    if (stream && !default_output_shape.empty()) {
+        fail() << "--stream cannot be combined with --output_extents; output shapes follow the input chunks.";
+    }
+
     // Check to be sure that all required arguments are specified.
     if (found.size() != args.size() || !unknown_args.empty()) {
         std::ostringstream o;
@@ -1041,6 +1336,10 @@ int main(int argc, char **argv) {
             break;
         }
         case halide_argument_kind_input_buffer: {
+            if (stream && is_hct_path(arg.raw_string)) {
+                // Streamed inputs are read one chunk at a time in run_streamed().
+                break;
+            }
             arg.buffer_value = load_input(arg.raw_string, *arg.metadata);
             info() << "Input " << arg_name << ": Shape is " << get_shape(arg.buffer_value);
             // If there was no default_output_shape specified, use the shape of
@@ -1057,6 +1356,10 @@ int main(int argc, char **argv) {
         }
     }
 
+    if (stream) {
+        return run_streamed(args);
+    }
+
     // Run a bounds query: we need to figure out how to allocate the output buffers,
     // and the input buffers might need reshaping to satisfy constraints (e.g. a chunky/interleaved layout).
     std::vector<Shape> constrained_shapes = run_bounds_query(args, default_output_shape);
@@ -1123,21 +1426,83 @@ int main(int argc, char **argv) {
                 }
             };
 
-            info() << "Benchmarking filter...";
-
-            BenchmarkConfig config;
-            config.min_time = benchmark_min_time;
-            config.max_time = benchmark_min_time * 4;
-            config.min_iters = benchmark_min_iters;
-            config.max_iters = benchmark_max_iters;
-            auto result = Halide::Tools::benchmark(benchmark_inner, config);
+            if (benchmark_steady_state) {
+                info() << "Warming up filter...";
+                for (int i = 0; i < benchmark_warmup_iters; i++) {
+                    benchmark_inner();
+                }
 
-            std::cout << "Benchmark for " << md->name << " produces best case of " << result.wall_time << " sec/iter (over "
-                << result.samples << " samples, "
-                << result.iterations << " iterations, "
-                << "accuracy " << std::setprecision(2) << (result.accuracy * 100.0) << "%).\n";
-            std::cout << "Best output throughput is " << (megapixels / result.wall_time) << " mpix/sec.\n";
+                // The warmup calls paid the one-time costs (device buffer
+                // allocation, host-to-device copies), and nothing marks the
+                // buffers dirty between calls, so from here on the data stays
+                // device-resident and each timed call measures just the
+                // kernels plus a sync -- unless we've been asked to put the
+                // copies back into the timed region.
+                info() << "Benchmarking filter (steady state)...";
+
+                using BenchmarkClock = Halide::Tools::SteadyClock<>::type;
+                std::vector<double> times;
+                double total_time = 0.0;
+                while ((int)times.size() < benchmark_max_iters &&
+                       ((int)times.size() < benchmark_min_iters || total_time < benchmark_min_time)) {
+                    if (benchmark_include_copies) {
+                        for (auto &arg_pair : args) {
+                            auto &arg = arg_pair.second;
+                            if (arg.metadata->kind == halide_argument_kind_input_buffer) {
+                                arg.buffer_value.set_host_dirty();
+                            }
+                        }
+                    }
+                    auto start = BenchmarkClock::now();
+                    benchmark_inner();
+                    if (benchmark_include_copies) {
+                        for (auto &arg_pair : args) {
+                            auto &arg = arg_pair.second;
+                            if (arg.metadata->kind == halide_argument_kind_output_buffer) {
+                                arg.buffer_value.copy_to_host();
+                            }
+                        }
+                    }
+                    auto end = BenchmarkClock::now();
+                    double elapsed =
+                        std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+                    times.push_back(elapsed);
+                    total_time += elapsed;
+                }
 
+                std::sort(times.begin(), times.end());
+                const auto percentile = [&times](double p) -> double {
+                    // Nearest-rank; times is sorted and never empty.
+                    size_t i = (size_t)(p / 100.0 * (times.size() - 1) + 0.5);
+                    return times[i];
+                };
+
+                std::cout << "Steady-state benchmark for " << md->name << " over "
+                    << times.size() << " iterations ("
+                    << benchmark_warmup_iters << " warmup, copies "
+                    << (benchmark_include_copies ? "included" : "excluded") << "):\n";
+                std::cout << "  min: " << times.front() << " sec/iter"
+                    << "  p50: " << percentile(50)
+                    << "  p90: " << percentile(90)
+                    << "  p99: " << percentile(99)
+                    << "  max: " << times.back() << "\n";
+                std::cout << "Median output throughput is " << (megapixels / percentile(50)) << " mpix/sec.\n";
+            } else {
+                info() << "Benchmarking filter...";
+
+                BenchmarkConfig config;
+                config.min_time = benchmark_min_time;
+                config.max_time = benchmark_min_time * 4;
+                config.min_iters = benchmark_min_iters;
+                config.max_iters = benchmark_max_iters;
+                auto result = Halide::Tools::benchmark(benchmark_inner, config);
+
+                std::cout << "Benchmark for " << md->name << " produces best case of " << result.wall_time << " sec/iter (over "
+                    << result.samples << " samples, "
+                    << result.iterations << " iterations, "
+                    << "accuracy " << std::setprecision(2) << (result.accuracy * 100.0) << "%).\n";
+                std::cout << "Best output throughput is " << (megapixels / result.wall_time) << " mpix/sec.\n";
+            }
         } else {
             info() << "Running filter...";
             // Ignore result since our halide_error() should catch everything.
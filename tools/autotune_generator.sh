@@ -0,0 +1,135 @@
+#!/bin/bash
+# Closed-loop autotuner for auto-scheduled generators.
+#
+# The auto-scheduler commits to one schedule analytically, and its
+# choices swing on the MachineParams it is given: different parameters
+# produce different groupings and tilings. This script closes the loop:
+# it enumerates candidate MachineParams, runs the generator once per
+# candidate, links each result against RunGen, benchmarks it, and
+# persists the winning parameters keyed by a hash of pipeline and
+# target. Run it overnight per SKU and bake the stored winners into the
+# build for that fleet.
+#
+# Usage:
+#   autotune_generator.sh <generator-binary> <generator-name> [rungen-args...]
+#
+# Everything after the generator name is passed to the RunGen binary,
+# e.g. input images or --output_extents for pipelines whose inputs have
+# no defaults. By default the filter is benchmarked with
+# --default_input_buffers (zero-filled inputs).
+#
+# Environment:
+#   HL_TARGET         target to compile for (default host)
+#   TUNE_DIR          scratch directory (default ./autotune)
+#   TUNE_DB           winners file (default <TUNE_DIR>/winners.txt);
+#                     one line per pipeline+target hash:
+#                       <hash> <generator> <target> <machine_params> <sec/iter>
+#   TUNE_CANDIDATES   optional file with one MachineParams string
+#                     ("parallelism,llc,balance") per line, replacing
+#                     the built-in candidate grid
+#   HALIDE_SRC_PATH   source tree root, for tools/RunGen.cpp (default:
+#                     parent of this script's directory)
+#   CXX               compiler for the RunGen link (default c++)
+
+set -u
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 <generator-binary> <generator-name> [rungen-args...]" >&2
+    exit 1
+fi
+
+GENERATOR="$1"
+NAME="$2"
+shift 2
+RUN_ARGS=("$@")
+if [ ${#RUN_ARGS[@]} -eq 0 ]; then
+    RUN_ARGS=(--default_input_buffers)
+fi
+
+TARGET="${HL_TARGET:-host}"
+TUNE_DIR="${TUNE_DIR:-./autotune}"
+TUNE_DB="${TUNE_DB:-$TUNE_DIR/winners.txt}"
+SRC="${HALIDE_SRC_PATH:-$(cd "$(dirname "$0")/.." && pwd)}"
+CXX="${CXX:-c++}"
+
+mkdir -p "$TUNE_DIR"
+
+# Image IO is irrelevant for zero-filled benchmarking, and skipping it
+# keeps the RunGen link free of libpng/libjpeg.
+RUNGEN_FLAGS="-std=c++11 -O2 -DHALIDE_NO_PNG -DHALIDE_NO_JPEG -I$SRC/tools -I$TUNE_DIR"
+RUNGEN_LIBS="-ldl -lpthread -lz"
+
+# Candidate MachineParams. The grid brackets MachineParams::generic()
+# (16,16777216,40) in last-level cache size and balance; parallelism is
+# taken from the machine since over- or under-subscribing threads is
+# never the right answer. A measured point from halide_machine_params
+# is added when that tool is on PATH or next to the generator.
+candidates() {
+    if [ -n "${TUNE_CANDIDATES:-}" ]; then
+        cat "$TUNE_CANDIDATES"
+        return
+    fi
+    local threads
+    threads=$(getconf _NPROCESSORS_ONLN 2> /dev/null || echo 16)
+    echo "16,16777216,40"
+    local mp
+    for mp in "$(dirname "$GENERATOR")/halide_machine_params" halide_machine_params; do
+        if command -v "$mp" > /dev/null 2>&1; then
+            "$mp" 2> /dev/null
+            break
+        fi
+    done
+    local llc balance
+    for llc in 4194304 8388608 16777216 33554432; do
+        for balance in 10 20 40 80 160; do
+            echo "$threads,$llc,$balance"
+        done
+    done
+}
+
+KEY=$(echo "$NAME|$TARGET" | (sha1sum 2> /dev/null || shasum) | awk '{print $1}')
+
+BEST_MP=""
+BEST_T=""
+N=0
+for MP in $(candidates | sort -u); do
+    N=$((N + 1))
+    echo "[$N] machine_params=$MP"
+    rm -f "$TUNE_DIR/$NAME.a" "$TUNE_DIR/$NAME.h"
+    if ! "$GENERATOR" -g "$NAME" -f "$NAME" -o "$TUNE_DIR" -e static_library,h \
+         target="$TARGET" auto_schedule=true machine_params="$MP" > /dev/null; then
+        echo "    generator failed, skipping"
+        continue
+    fi
+    if ! $CXX $RUNGEN_FLAGS -DHL_RUNGEN_FILTER_HEADER=\""$NAME.h"\" \
+         "$SRC/tools/RunGen.cpp" "$SRC/tools/RunGenStubs.cpp" \
+         "$TUNE_DIR/$NAME.a" $RUNGEN_LIBS -o "$TUNE_DIR/$NAME.rungen"; then
+        echo "    link failed, skipping"
+        continue
+    fi
+    T=$("$TUNE_DIR/$NAME.rungen" --benchmarks=all "${RUN_ARGS[@]}" 2> /dev/null |
+        awk '/best case of/ { print $8 }')
+    if [ -z "$T" ]; then
+        echo "    benchmark failed, skipping"
+        continue
+    fi
+    echo "    $T sec/iter"
+    if [ -z "$BEST_T" ] || awk "BEGIN { exit !($T < $BEST_T) }"; then
+        BEST_T="$T"
+        BEST_MP="$MP"
+    fi
+done
+
+if [ -z "$BEST_MP" ]; then
+    echo "No candidate produced a working build of $NAME for $TARGET" >&2
+    exit 1
+fi
+
+# Replace any previous entry for this pipeline+target.
+touch "$TUNE_DB"
+grep -v "^$KEY " "$TUNE_DB" > "$TUNE_DB.tmp" || true
+echo "$KEY $NAME $TARGET $BEST_MP $BEST_T" >> "$TUNE_DB.tmp"
+mv "$TUNE_DB.tmp" "$TUNE_DB"
+
+echo "Winner for $NAME ($TARGET): machine_params=$BEST_MP at $BEST_T sec/iter"
+echo "Recorded in $TUNE_DB under key $KEY"
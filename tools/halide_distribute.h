@@ -0,0 +1,286 @@
+// A tile-distribution layer over the bounds-query protocol, for
+// sharding one large realization of an AOT-compiled filter across N
+// workers (threads, processes, or machines). Every AOT filter already
+// answers bounds queries -- call it with buffers whose host and
+// device pointers are null and it fills in the regions it would
+// touch, without computing anything -- so the planner can compute,
+// for each worker's piece of the output, exactly which region of each
+// input that piece needs. Only those bytes have to move.
+//
+// Usage, against a filter built with its metadata (as RunGen uses):
+//
+//   extern "C" int my_filter_argv(void **args);
+//   extern "C" const halide_filter_metadata_t *my_filter_metadata();
+//
+//   Halide::Tools::TileDistributor dist(my_filter_metadata(),
+//                                       my_filter_argv);
+//   dist.bind("gain", gain_value);   // scalars can affect the bounds
+//
+//   // Shard the output region across 8 workers along its outermost
+//   // dimension, and bounds-query each shard's input regions:
+//   auto shards = dist.plan(output_region, 8);
+//
+//   // For each shard, pack(shard, i, full_input) yields a dense
+//   // buffer holding just the bytes worker shards[i] needs -- ship
+//   // it, realize the shard remotely (a remote worker does what
+//   // execute_shard() does), ship the dense result back, and
+//   // stitch(shard, i, packed_result, full_output) places it.
+//
+//   // Or validate a plan end-to-end in-process:
+//   int err = dist.run_local(shards, arg_buffers);
+//
+// The byte movement, remote invocation, and stitching all reduce to
+// the halide_region_* C API in the runtime plus halide_buffer_copy;
+// the transport itself (ssh, MPI, a job queue) is deliberately left
+// to the caller, since that is the part that differs per cluster.
+
+#ifndef HALIDE_TOOLS_DISTRIBUTE_H
+#define HALIDE_TOOLS_DISTRIBUTE_H
+
+#include <cassert>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+
+namespace Halide {
+namespace Tools {
+
+// A region is an array of halide_dimension_t, as in the bounds-query
+// protocol; strides are ignored.
+using Region = std::vector<halide_dimension_t>;
+
+// One worker's slice of the job. regions is indexed by argument
+// position in the filter's metadata: output arguments hold this
+// worker's piece of the output, input arguments hold the region the
+// bounds query reported that piece needs, and scalar arguments are
+// empty.
+struct DistributedShard {
+    int worker = 0;
+    std::vector<Region> regions;
+};
+
+class TileDistributor {
+public:
+    using ArgvCall = int (*)(void **);
+
+    TileDistributor(const halide_filter_metadata_t *metadata, ArgvCall call)
+        : metadata_(metadata), call_(call) {
+    }
+
+    // Bind a scalar argument. All scalars must be bound before
+    // planning or executing: they participate in the bounds query,
+    // since (e.g.) a radius parameter changes the input regions.
+    void bind(const std::string &name, const halide_scalar_value_t &value) {
+        int i = arg_index(name);
+        assert(i >= 0 && metadata_->arguments[i].kind == halide_argument_kind_input_scalar);
+        scalars_[i] = value;
+    }
+
+    // Shard output_region into num_workers near-equal pieces along
+    // split_dim (default: the outermost dimension), and bounds-query
+    // the input region each piece needs. Filters with several outputs
+    // get the same split applied to each. Returns one entry per
+    // worker; workers whose piece is empty are still present so
+    // worker indices stay stable.
+    std::vector<DistributedShard> plan(const Region &output_region,
+                                       int num_workers,
+                                       int split_dim = -1) {
+        if (split_dim < 0) {
+            split_dim = (int)output_region.size() - 1;
+        }
+        std::vector<DistributedShard> shards(num_workers);
+        for (int w = 0; w < num_workers; w++) {
+            DistributedShard &shard = shards[w];
+            shard.worker = w;
+            shard.regions.resize(metadata_->num_arguments);
+            for (int i = 0; i < metadata_->num_arguments; i++) {
+                const auto &md = metadata_->arguments[i];
+                if (md.kind != halide_argument_kind_output_buffer) {
+                    continue;
+                }
+                Region r = output_region;
+                r.resize(md.dimensions);
+                assert(split_dim < md.dimensions && "output lacks the split dimension");
+                halide_region_shard(output_region[split_dim].min,
+                                    output_region[split_dim].extent,
+                                    num_workers, w,
+                                    &r[split_dim].min, &r[split_dim].extent);
+                shard.regions[i] = r;
+            }
+            int err = bounds_query(shard);
+            if (err != 0) {
+                return {};
+            }
+        }
+        return shards;
+    }
+
+    // A dense copy of shard's region of argument arg, ready to put on
+    // the wire. full must cover the region. The result owns its
+    // allocation.
+    Runtime::Buffer<> pack(const DistributedShard &shard, int arg,
+                           const halide_buffer_t *full) const {
+        Region r = with_dense_strides(shard.regions[arg]);
+        Runtime::Buffer<> dense(metadata_->arguments[arg].type,
+                                nullptr, (int)r.size(), r.data());
+        dense.allocate();
+        halide_buffer_copy(nullptr, const_cast<halide_buffer_t *>(full),
+                           nullptr, dense.raw_buffer());
+        return dense;
+    }
+
+    // Copy a worker's (packed) result for output argument arg into
+    // its place in the full output.
+    int stitch(const DistributedShard &shard, int arg,
+               halide_buffer_t *packed, halide_buffer_t *full_output) const {
+        std::vector<halide_dimension_t> crop_dims;
+        halide_buffer_t crop = crop_view(full_output, shard.regions[arg], crop_dims);
+        return halide_buffer_copy(nullptr, packed, nullptr, &crop);
+    }
+
+    // Realize one shard in the calling process, writing into dense
+    // buffers covering the shard's output regions. buffers is indexed
+    // by argument position; input entries must cover the shard's
+    // input regions (the full inputs, or packed copies of them), and
+    // output entries are overwritten with freshly-allocated results.
+    // This is exactly what a remote worker runs against the buffers
+    // it received.
+    int execute_shard(const DistributedShard &shard,
+                      std::vector<Runtime::Buffer<>> &buffers) {
+        std::vector<void *> argv(metadata_->num_arguments, nullptr);
+        for (int i = 0; i < metadata_->num_arguments; i++) {
+            const auto &md = metadata_->arguments[i];
+            if (md.kind == halide_argument_kind_input_scalar) {
+                argv[i] = scalar_arg(i);
+            } else if (md.kind == halide_argument_kind_output_buffer) {
+                Region r = with_dense_strides(shard.regions[i]);
+                buffers[i] = Runtime::Buffer<>(md.type, nullptr,
+                                               (int)r.size(), r.data());
+                buffers[i].allocate();
+                argv[i] = buffers[i].raw_buffer();
+            } else {
+                argv[i] = buffers[i].raw_buffer();
+            }
+        }
+        return call_(argv.data());
+    }
+
+    // Run a whole plan in-process: pack each shard's input regions,
+    // realize the shard against only those bytes, and stitch the
+    // pieces into the full outputs. Validates a plan (and the
+    // filter's bounds-query answers) without a cluster; arg_buffers
+    // is indexed by argument position, with null entries for scalars.
+    int run_local(const std::vector<DistributedShard> &shards,
+                  const std::vector<halide_buffer_t *> &arg_buffers) {
+        for (const auto &shard : shards) {
+            std::vector<Runtime::Buffer<>> buffers(metadata_->num_arguments);
+            for (int i = 0; i < metadata_->num_arguments; i++) {
+                if (metadata_->arguments[i].kind == halide_argument_kind_input_buffer) {
+                    buffers[i] = pack(shard, i, arg_buffers[i]);
+                }
+            }
+            int err = execute_shard(shard, buffers);
+            if (err != 0) {
+                return err;
+            }
+            for (int i = 0; i < metadata_->num_arguments; i++) {
+                if (metadata_->arguments[i].kind == halide_argument_kind_output_buffer) {
+                    err = stitch(shard, i, buffers[i].raw_buffer(), arg_buffers[i]);
+                    if (err != 0) {
+                        return err;
+                    }
+                }
+            }
+        }
+        return 0;
+    }
+
+    int arg_index(const std::string &name) const {
+        for (int i = 0; i < metadata_->num_arguments; i++) {
+            if (name == metadata_->arguments[i].name) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+private:
+    const halide_filter_metadata_t *metadata_;
+    ArgvCall call_;
+    std::map<int, halide_scalar_value_t> scalars_;
+
+    void *scalar_arg(int i) {
+        auto it = scalars_.find(i);
+        assert(it != scalars_.end() && "unbound scalar argument");
+        return &it->second;
+    }
+
+    static Region with_dense_strides(Region r) {
+        int32_t stride = 1;
+        for (auto &d : r) {
+            d.stride = stride;
+            stride *= d.extent;
+        }
+        return r;
+    }
+
+    // A non-owning view of the given region of buf. dims provides
+    // storage that must outlive the view.
+    static halide_buffer_t crop_view(halide_buffer_t *buf, const Region &r,
+                                     std::vector<halide_dimension_t> &dims) {
+        halide_buffer_t view = *buf;
+        dims.assign(buf->dim, buf->dim + buf->dimensions);
+        int64_t offset = 0;
+        for (int d = 0; d < (int)r.size(); d++) {
+            offset += (int64_t)(r[d].min - dims[d].min) * dims[d].stride;
+            dims[d].min = r[d].min;
+            dims[d].extent = r[d].extent;
+        }
+        view.host += offset * buf->type.bytes();
+        view.dim = dims.data();
+        view.device = 0;
+        view.device_interface = nullptr;
+        return view;
+    }
+
+    // Fill in shard's input regions by running the filter in
+    // bounds-query mode against its output regions.
+    int bounds_query(DistributedShard &shard) {
+        std::vector<void *> argv(metadata_->num_arguments, nullptr);
+        std::vector<Runtime::Buffer<>> query(metadata_->num_arguments);
+        for (int i = 0; i < metadata_->num_arguments; i++) {
+            const auto &md = metadata_->arguments[i];
+            if (md.kind == halide_argument_kind_input_scalar) {
+                argv[i] = scalar_arg(i);
+                continue;
+            }
+            // Null host and device make this a query, not a
+            // computation; outputs carry the region we want, inputs
+            // are filled in by the filter.
+            Region r = shard.regions[i];
+            r.resize(md.dimensions);
+            query[i] = Runtime::Buffer<>(md.type, nullptr,
+                                         (int)r.size(), r.data());
+            argv[i] = query[i].raw_buffer();
+        }
+        int err = call_(argv.data());
+        if (err != 0) {
+            return err;
+        }
+        for (int i = 0; i < metadata_->num_arguments; i++) {
+            if (metadata_->arguments[i].kind == halide_argument_kind_input_buffer) {
+                const halide_buffer_t *b = query[i].raw_buffer();
+                shard.regions[i].assign(b->dim, b->dim + b->dimensions);
+            }
+        }
+        return 0;
+    }
+};
+
+}  // namespace Tools
+}  // namespace Halide
+
+#endif  // HALIDE_TOOLS_DISTRIBUTE_H
@@ -8,13 +8,23 @@
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <map>
 #include <set>
 #include <string>
+#include <thread>
 #include <vector>
 #include <cctype>
 
+#if !defined(_WIN32) && !defined(HALIDE_NO_MMAP)
+#define HALIDE_IMAGE_IO_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #ifndef HALIDE_NO_PNG
 #include "png.h"
 #endif
@@ -372,6 +382,37 @@ void write_big_endian_row(const ImageType &im, int y, uint8_t *dst) {
     }
 }
 
+// Run fn(y) for every y in [ymin, ymax], splitting the range across
+// threads. Loading large images is dominated by the per-sample
+// conversion in the row helpers above, which is embarrassingly
+// parallel. The Halide runtime's thread pool isn't linkable from every
+// consumer of this header, so just use std::thread directly.
+template<typename Fn>
+void for_each_row_parallel(int ymin, int ymax, Fn fn) {
+    const int rows = ymax - ymin + 1;
+    // Don't bother spinning up threads for small images.
+    int threads = std::min((int)std::thread::hardware_concurrency(), rows / 64);
+    if (threads <= 1) {
+        for (int y = ymin; y <= ymax; y++) {
+            fn(y);
+        }
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        const int y0 = ymin + (int)(((int64_t)rows * t) / threads);
+        const int y1 = ymin + (int)(((int64_t)rows * (t + 1)) / threads) - 1;
+        pool.emplace_back([=]() {
+            for (int y = y0; y <= y1; y++) {
+                fn(y);
+            }
+        });
+    }
+    for (auto &th : pool) {
+        th.join();
+    }
+}
+
 #ifndef HALIDE_NO_PNG
 
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
@@ -430,13 +471,22 @@ bool load_png(const std::string &filename, ImageType *im) {
         Internal::read_big_endian_row<uint8_t, ImageType> :
         Internal::read_big_endian_row<uint16_t, ImageType>;
 
-    std::vector<uint8_t> row(png_get_rowbytes(png_ptr, info_ptr));
+    // libpng insists on decoding rows in order, but the per-sample
+    // conversion into the image doesn't care, so decode into a staging
+    // buffer and convert the rows in parallel.
+    const size_t row_bytes = png_get_rowbytes(png_ptr, info_ptr);
+    std::vector<uint8_t> decoded(row_bytes * height);
+    std::vector<png_bytep> row_pointers(height);
+    for (int y = 0; y < height; ++y) {
+        row_pointers[y] = decoded.data() + y * row_bytes;
+    }
+    png_read_image(png_ptr, row_pointers.data());
+
     const int ymin = im->dim(1).min();
     const int ymax = im->dim(1).max();
-    for (int y = ymin; y <= ymax; ++y) {
-        png_read_row(png_ptr, row.data(), nullptr);
-        copy_to_image(row.data(), y, im);
-    }
+    Internal::for_each_row_parallel(ymin, ymax, [&](int y) {
+        copy_to_image(decoded.data() + (y - ymin) * row_bytes, y, im);
+    });
 
     png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 
@@ -513,13 +563,21 @@ bool save_png(ImageType &im, const std::string &filename) {
         Internal::write_big_endian_row<uint8_t, ImageType> :
         Internal::write_big_endian_row<uint16_t, ImageType>;
 
-    std::vector<uint8_t> row(png_get_rowbytes(png_ptr, info_ptr));
+    // Convert the rows in parallel, then hand the whole image to
+    // libpng to encode.
+    const size_t row_bytes = png_get_rowbytes(png_ptr, info_ptr);
+    std::vector<uint8_t> encoded(row_bytes * height);
     const int ymin = im.dim(1).min();
     const int ymax = im.dim(1).max();
-    for (int y = ymin; y <= ymax; ++y) {
-        copy_from_image(im, y, row.data());
-        png_write_row(png_ptr, row.data());
+    Internal::for_each_row_parallel(ymin, ymax, [&](int y) {
+        copy_from_image(im, y, encoded.data() + (y - ymin) * row_bytes);
+    });
+
+    std::vector<png_bytep> row_pointers(height);
+    for (int y = 0; y < height; ++y) {
+        row_pointers[y] = encoded.data() + y * row_bytes;
     }
+    png_write_image(png_ptr, row_pointers.data());
     png_write_end(png_ptr, NULL);
     png_destroy_write_struct(&png_ptr, &info_ptr);
 
@@ -586,15 +644,19 @@ bool load_pnm(const std::string &filename, int channels, ImageType *im) {
         Internal::read_big_endian_row<uint8_t, ImageType> :
         Internal::read_big_endian_row<uint16_t, ImageType>;
 
-    std::vector<uint8_t> row(width * channels * (bit_depth / 8));
+    // Read the whole payload in one go, then convert the rows in
+    // parallel.
+    const size_t row_bytes = (size_t)width * channels * (bit_depth / 8);
+    std::vector<uint8_t> data(row_bytes * height);
+    if (!check(f.read_vector(&data), "Could not read data")) {
+        return false;
+    }
+
     const int ymin = im->dim(1).min();
     const int ymax = im->dim(1).max();
-    for (int y = ymin; y <= ymax; ++y) {
-        if (!check(f.read_vector(&row), "Could not read data")) {
-            return false;
-        }
-        copy_to_image(row.data(), y, im);
-    }
+    Internal::for_each_row_parallel(ymin, ymax, [&](int y) {
+        copy_to_image(data.data() + (y - ymin) * row_bytes, y, im);
+    });
 
     return true;
 }
@@ -625,14 +687,17 @@ bool save_pnm(ImageType &im, const int channels, const std::string &filename) {
         Internal::write_big_endian_row<uint8_t, ImageType> :
         Internal::write_big_endian_row<uint16_t, ImageType>;
 
-    std::vector<uint8_t> row(width * channels * (bit_depth / 8));
+    // Convert the rows in parallel, then write the payload in one go.
+    const size_t row_bytes = (size_t)width * channels * (bit_depth / 8);
+    std::vector<uint8_t> data(row_bytes * height);
     const int ymin = im.dim(1).min();
     const int ymax = im.dim(1).max();
-    for (int y = ymin; y <= ymax; ++y) {
-        copy_from_image(im, y, row.data());
-        if (!check(f.write_vector(row), "Could not write data")) {
-            return false;
-        }
+    Internal::for_each_row_parallel(ymin, ymax, [&](int y) {
+        copy_from_image(im, y, data.data() + (y - ymin) * row_bytes);
+    });
+
+    if (!check(f.write_vector(data), "Could not write data")) {
+        return false;
     }
 
     return true;
@@ -819,11 +884,81 @@ bool buffer_is_compact_planar(ImageType &im) {
     return true;
 }
 
+#ifdef HALIDE_IMAGE_IO_USE_MMAP
+
+// Zero-copy loader for .tmp files: map the file and wrap the payload
+// pages in the image directly, so nothing is copied (or even read)
+// until the pixels are touched. The mapping is copy-on-write, so
+// writing to the loaded image is safe and doesn't touch the file. The
+// mapping is intentionally left in place for the life of the process;
+// the image type has no way to call munmap when the last reference
+// dies. Returns false (without complaint) if the file can't be
+// mapped; the caller falls back to the copying loader.
+template<typename ImageType>
+bool load_tmp_mmap(const std::string &filename, ImageType *im) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    int32_t header[5];
+    if (fstat(fd, &st) != 0 ||
+        read(fd, header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        close(fd);
+        return false;
+    }
+
+    if (!(header[0] > 0 && header[1] > 0 && header[2] > 0 && header[3] > 0 &&
+          header[4] >= 0 && header[4] < kNumTmpCodes)) {
+        close(fd);
+        return false;
+    }
+
+    const halide_type_t im_type = tmp_code_to_halide_type()[header[4]];
+
+    // The payload starts at a fixed 20-byte offset, which leaves
+    // 8-byte element types misaligned; let those take the copying path.
+    if (sizeof(header) % im_type.bytes() != 0) {
+        close(fd);
+        return false;
+    }
+
+    const uint64_t payload_bytes = (uint64_t)im_type.bytes() *
+        header[0] * header[1] * header[2] * header[3];
+    if ((uint64_t)st.st_size < sizeof(header) + payload_bytes) {
+        close(fd);
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, sizeof(header) + payload_bytes,
+                        PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the pages alive; the descriptor isn't needed.
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    std::vector<int> im_dimensions = { header[0], header[1], header[2], header[3] };
+    *im = ImageType(im_type, (uint8_t *)mapped + sizeof(header), im_dimensions);
+
+    im->set_host_dirty();
+    return true;
+}
+
+#endif  // HALIDE_IMAGE_IO_USE_MMAP
+
 // ".tmp" is a file format used by the ImageStack tool (see https://github.com/abadams/ImageStack)
 template<typename ImageType, CheckFunc check = CheckReturn>
 bool load_tmp(const std::string &filename, ImageType *im) {
     static_assert(!ImageType::has_static_halide_type, "");
 
+#ifdef HALIDE_IMAGE_IO_USE_MMAP
+    if (load_tmp_mmap(filename, im)) {
+        return true;
+    }
+#endif
+
     FileOpener f(filename, "rb");
     if (!check(f.f != nullptr, "File could not be opened for reading")) {
         return false;
@@ -1300,6 +1435,238 @@ bool save_mat(ImageType &im, const std::string &filename) {
     return true;
 }
 
+// ".hct" is a Halide-specific chunked tensor container, intended for
+// data too large to comfortably materialize in one piece. The payload
+// is split into chunks along the outermost dimension so that a reader
+// can process one chunk at a time. Layout (all fields little-endian):
+//
+//   char     magic[8];          // "HLChTen0"
+//   uint32_t compression;       // 0 = raw. Reserved for future codecs.
+//   uint8_t  type_code;         // a halide_type_code_t
+//   uint8_t  type_bits;
+//   uint16_t reserved;          // must be zero
+//   uint32_t dimensions;        // at least 1
+//   int32_t  extent[dimensions];
+//   int32_t  chunk_extent;      // outermost-dimension slices per chunk
+//   uint64_t chunk_offset[num_chunks];  // byte offset of each chunk
+//
+// where num_chunks = ceil(extent[dimensions-1] / chunk_extent), and the
+// final chunk may be partial. Each chunk is the dense planar encoding
+// (dimension zero innermost) of chunk_extent consecutive outermost
+// slices. The offset table makes the chunks independently seekable.
+
+constexpr char kHctMagic[8] = {'H', 'L', 'C', 'h', 'T', 'e', 'n', '0'};
+
+struct ChunkedTensorDesc {
+    halide_type_t type;
+    std::vector<int32_t> extents;
+    int32_t chunk_extent = 0;
+    std::vector<uint64_t> chunk_offsets;
+
+    int num_chunks() const {
+        if (extents.empty() || chunk_extent <= 0) {
+            return 0;
+        }
+        return (int) ((extents.back() + chunk_extent - 1) / chunk_extent);
+    }
+
+    // The first outermost slice of chunk c, and the number of slices it holds.
+    int chunk_begin(int c) const {
+        return c * chunk_extent;
+    }
+    int chunk_slices(int c) const {
+        return std::min(chunk_extent, extents.back() - chunk_begin(c));
+    }
+
+    uint64_t bytes_per_slice() const {
+        uint64_t b = (type.bits + 7) / 8;
+        for (size_t i = 0; i + 1 < extents.size(); i++) {
+            b *= (uint64_t) extents[i];
+        }
+        return b;
+    }
+    uint64_t chunk_bytes(int c) const {
+        return bytes_per_slice() * (uint64_t) chunk_slices(c);
+    }
+
+    uint64_t header_bytes() const {
+        return 8 + 4 + 4 + 4 + 4 * extents.size() + 4 + 8 * num_chunks();
+    }
+};
+
+// fseek takes a long, which may be 32 bits; .hct files are routinely larger.
+inline bool hct_seek(FILE *f, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(f, (long long) offset, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t) offset, SEEK_SET) == 0;
+#endif
+}
+
+template<CheckFunc check = CheckReturn>
+bool hct_read_desc(FileOpener &f, ChunkedTensorDesc *desc) {
+    char magic[8];
+    if (!check(f.read_array(magic) && !memcmp(magic, kHctMagic, sizeof(magic)),
+               "Bad magic on .hct file")) {
+        return false;
+    }
+    uint32_t compression, dims;
+    uint8_t type_code, type_bits;
+    uint16_t reserved;
+    if (!check(f.read_bytes(&compression, 4) &&
+               f.read_bytes(&type_code, 1) &&
+               f.read_bytes(&type_bits, 1) &&
+               f.read_bytes(&reserved, 2) &&
+               f.read_bytes(&dims, 4), "Could not read .hct header")) {
+        return false;
+    }
+    if (!check(compression == 0, "Unsupported .hct compression scheme")) {
+        return false;
+    }
+    if (!check(reserved == 0 && dims >= 1 && dims <= 16, "Bad header on .hct file")) {
+        return false;
+    }
+    desc->type = halide_type_t((halide_type_code_t) type_code, type_bits);
+    desc->extents.resize(dims);
+    if (!check(f.read_vector(&desc->extents) &&
+               f.read_bytes(&desc->chunk_extent, 4), "Could not read .hct extents")) {
+        return false;
+    }
+    for (int32_t e : desc->extents) {
+        if (!check(e > 0, "Bad extent in .hct file")) {
+            return false;
+        }
+    }
+    if (!check(desc->chunk_extent > 0, "Bad chunk extent in .hct file")) {
+        return false;
+    }
+    desc->chunk_offsets.resize(desc->num_chunks());
+    if (!check(f.read_vector(&desc->chunk_offsets), "Could not read .hct chunk table")) {
+        return false;
+    }
+    return true;
+}
+
+// Writes the header, populating desc->chunk_offsets with the offsets
+// the (uncompressed) chunk payloads must be written at.
+template<CheckFunc check = CheckReturn>
+bool hct_write_desc(FileOpener &f, ChunkedTensorDesc *desc) {
+    desc->chunk_offsets.resize(desc->num_chunks());
+    uint64_t offset = desc->header_bytes();
+    for (int c = 0; c < desc->num_chunks(); c++) {
+        desc->chunk_offsets[c] = offset;
+        offset += desc->chunk_bytes(c);
+    }
+    const uint32_t compression = 0;
+    const uint8_t type_code = desc->type.code, type_bits = desc->type.bits;
+    const uint16_t reserved = 0;
+    const uint32_t dims = (uint32_t) desc->extents.size();
+    if (!check(f.write_array(kHctMagic) &&
+               f.write_bytes(&compression, 4) &&
+               f.write_bytes(&type_code, 1) &&
+               f.write_bytes(&type_bits, 1) &&
+               f.write_bytes(&reserved, 2) &&
+               f.write_bytes(&dims, 4) &&
+               f.write_vector(desc->extents) &&
+               f.write_bytes(&desc->chunk_extent, 4) &&
+               f.write_vector(desc->chunk_offsets), "Could not write .hct header")) {
+        return false;
+    }
+    return true;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_hct(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    FileOpener f(filename, "rb");
+    if (!check(f.f != nullptr, "File could not be opened for reading")) {
+        return false;
+    }
+
+    ChunkedTensorDesc desc;
+    if (!hct_read_desc<check>(f, &desc)) {
+        return false;
+    }
+
+    std::vector<int> im_dimensions(desc.extents.begin(), desc.extents.end());
+    *im = ImageType(desc.type, im_dimensions);
+
+    // This should never fail unless the default Buffer<> constructor behavior changes.
+    if (!check(buffer_is_compact_planar(*im), "load_hct() requires compact planar images")) {
+        return false;
+    }
+
+    uint8_t *dst = (uint8_t *) im->begin();
+    for (int c = 0; c < desc.num_chunks(); c++) {
+        if (!check(hct_seek(f.f, desc.chunk_offsets[c]) &&
+                   f.read_bytes(dst, desc.chunk_bytes(c)), "Could not read .hct chunk")) {
+            return false;
+        }
+        dst += desc.chunk_bytes(c);
+    }
+
+    im->set_host_dirty();
+    return true;
+}
+
+inline const std::set<FormatInfo> &query_hct() {
+    // HCT files need at least one dimension to chunk along. Our
+    // support arbitrarily stops at 16 dimensions, like .mat.
+    static std::set<FormatInfo> info = []() {
+        std::set<FormatInfo> s;
+        for (int i = 1; i <= 16; i++) {
+            s.insert({ halide_type_t(halide_type_float, 32), i });
+            s.insert({ halide_type_t(halide_type_float, 64), i });
+            s.insert({ halide_type_t(halide_type_uint, 8), i });
+            s.insert({ halide_type_t(halide_type_int, 8), i });
+            s.insert({ halide_type_t(halide_type_uint, 16), i });
+            s.insert({ halide_type_t(halide_type_int, 16), i });
+            s.insert({ halide_type_t(halide_type_uint, 32), i });
+            s.insert({ halide_type_t(halide_type_int, 32), i });
+            s.insert({ halide_type_t(halide_type_uint, 64), i });
+            s.insert({ halide_type_t(halide_type_int, 64), i });
+        }
+        return s;
+    }();
+    return info;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool save_hct(ImageType &im, const std::string &filename) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    im.copy_to_host();
+
+    if (!check(im.dimensions() >= 1, ".hct files require at least one dimension")) {
+        return false;
+    }
+
+    ChunkedTensorDesc desc;
+    desc.type = im.type();
+    for (int i = 0; i < im.dimensions(); ++i) {
+        desc.extents.push_back(im.dim(i).extent());
+    }
+    // One outermost slice per chunk: fine granularity for streaming
+    // readers, and the offset table stays negligibly small.
+    desc.chunk_extent = 1;
+
+    FileOpener f(filename, "wb");
+    if (!check(f.f != nullptr, "File could not be opened for writing")) {
+        return false;
+    }
+    if (!hct_write_desc<check>(f, &desc)) {
+        return false;
+    }
+
+    // Raw chunks are contiguous, so the payload is just the planar encoding.
+    if (!write_planar_payload<ImageType, check>(im, f)) {
+        return false;
+    }
+
+    return true;
+}
+
 
 template<typename ImageType, Internal::CheckFunc check>
 struct ImageIO {
@@ -1323,7 +1690,8 @@ bool find_imageio(const std::string &filename, ImageIO<ImageType, check> *result
 #endif
         {"ppm", {load_ppm<ImageType, check>, save_ppm<ImageType, check>, query_ppm}},
         {"tmp", {load_tmp<ImageType, check>, save_tmp<ImageType, check>, query_tmp}},
-        {"mat", {load_mat<ImageType, check>, save_mat<ImageType, check>, query_mat}}
+        {"mat", {load_mat<ImageType, check>, save_mat<ImageType, check>, query_mat}},
+        {"hct", {load_hct<ImageType, check>, save_hct<ImageType, check>, query_hct}}
     };
     std::string ext = Internal::get_lowercase_extension(filename);
     auto it = m.find(ext);
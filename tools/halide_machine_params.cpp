@@ -0,0 +1,167 @@
+// Measures the machine parameters that the auto-scheduler's cost model
+// depends on and prints them in MachineParams canonical string form:
+//
+//   parallelism,last_level_cache_size,balance
+//
+// The defaults in MachineParams::generic() describe a generic desktop
+// part; on machines with very different cache sizes or compute/memory
+// balance (e.g. many-core servers) the auto-scheduler makes noticeably
+// worse choices with them. This tool micro-benchmarks the host:
+//
+//   parallelism: hardware thread count.
+//   last_level_cache_size: found by sweeping a streaming reduction over
+//       working sets from 64KB to 512MB and taking the largest set that
+//       still runs at cache-like bandwidth (above the geometric mean of
+//       the fastest and slowest points of the sweep).
+//   balance: the measured cost of a load that misses the last-level
+//       cache divided by the measured cost of a vectorizable
+//       multiply-add on in-cache data.
+//
+// Feed the result to a generator:
+//
+//   ./bin/my_generator -g my_pipeline auto_schedule=true \
+//       machine_params=$(./bin/halide_machine_params) ...
+//
+// or to Pipeline::auto_schedule via MachineParams(std::string). Pass -v
+// to also print the individual measurements to stderr. Run it on an
+// otherwise idle machine; each measurement takes the best of several
+// runs, but there is no substitute for quiet neighbors.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Best-of-n wall time for op, in nanoseconds.
+template<typename F>
+double time_ns(F op, int samples = 5) {
+    double best = 0;
+    for (int i = 0; i < samples; i++) {
+        auto t1 = std::chrono::high_resolution_clock::now();
+        op();
+        auto t2 = std::chrono::high_resolution_clock::now();
+        double t = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+        if (i == 0 || t < best) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+// Used as a sink so the compiler can't discard the benchmark loops.
+volatile float sink;
+
+// Nanoseconds per 4-byte load when streaming through a working set of
+// the given size. Small sizes measure cache bandwidth, large sizes
+// measure DRAM bandwidth. Touches total_bytes per timed run regardless
+// of the working set size so all points of the sweep are comparable.
+double ns_per_load(size_t working_set_bytes, size_t total_bytes) {
+    size_t n = working_set_bytes / sizeof(float);
+    std::vector<float> data(n, 1.0f);
+    size_t passes = std::max((size_t)1, total_bytes / working_set_bytes);
+    double t = time_ns([&]() {
+        float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (size_t p = 0; p < passes; p++) {
+            for (size_t i = 0; i + 3 < n; i += 4) {
+                s0 += data[i];
+                s1 += data[i + 1];
+                s2 += data[i + 2];
+                s3 += data[i + 3];
+            }
+        }
+        sink = s0 + s1 + s2 + s3;
+    });
+    return t / ((double)passes * (double)(n & ~(size_t)3));
+}
+
+// Nanoseconds per multiply-add on data resident in L1. Eight
+// independent accumulators so the measurement is throughput-bound, not
+// latency-bound, matching how the cost model treats vectorizable
+// arithmetic.
+double ns_per_op() {
+    const size_t n = 1024;  // 4KB: comfortably in L1
+    std::vector<float> data(n, 1.000001f);
+    const int passes = 1 << 14;
+    double t = time_ns([&]() {
+        float a0 = 0, a1 = 0, a2 = 0, a3 = 0, a4 = 0, a5 = 0, a6 = 0, a7 = 0;
+        for (int p = 0; p < passes; p++) {
+            for (size_t i = 0; i + 7 < n; i += 8) {
+                a0 = a0 * data[i] + 1.0f;
+                a1 = a1 * data[i + 1] + 1.0f;
+                a2 = a2 * data[i + 2] + 1.0f;
+                a3 = a3 * data[i + 3] + 1.0f;
+                a4 = a4 * data[i + 4] + 1.0f;
+                a5 = a5 * data[i + 5] + 1.0f;
+                a6 = a6 * data[i + 6] + 1.0f;
+                a7 = a7 * data[i + 7] + 1.0f;
+            }
+        }
+        sink = a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7;
+    });
+    // Each iteration is a multiply and an add; count them as one
+    // "arithmetic op" apiece, as the cost model does.
+    return t / ((double)passes * (double)n * 2.0);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    int parallelism = (int)std::thread::hardware_concurrency();
+    if (parallelism <= 0) {
+        parallelism = 1;
+    }
+
+    // Sweep working sets from 64KB to 512MB, measuring per-load cost at
+    // each. The largest point is safely beyond any current LLC, so it
+    // measures DRAM.
+    const size_t min_set = 64 * 1024;
+    const size_t max_set = 512 * 1024 * 1024;
+    const size_t total = 1 << 28;  // bytes touched per timed run
+    std::vector<size_t> sizes;
+    std::vector<double> costs;
+    for (size_t s = min_set; s <= max_set; s *= 2) {
+        sizes.push_back(s);
+        costs.push_back(ns_per_load(s, total));
+        if (verbose) {
+            fprintf(stderr, "%10zu KB: %6.3f ns/load\n", s / 1024, costs.back());
+        }
+    }
+    double fast = *std::min_element(costs.begin(), costs.end());
+    double slow = costs.back();
+
+    // The sweep is flat while the working set fits in cache and flat
+    // again once it spills to DRAM; split the two regimes at the
+    // geometric mean of the extremes and call the last cache-like point
+    // the LLC size.
+    double threshold = std::sqrt(fast * slow);
+    size_t llc = min_set;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        if (costs[i] <= threshold) {
+            llc = sizes[i];
+        }
+    }
+
+    double op_cost = ns_per_op();
+    int balance = (int)(slow / op_cost + 0.5);
+    if (balance < 1) {
+        balance = 1;
+    }
+
+    if (verbose) {
+        fprintf(stderr, "parallelism: %d threads\n", parallelism);
+        fprintf(stderr, "last-level cache: %zu KB\n", llc / 1024);
+        fprintf(stderr, "arithmetic: %.3f ns/op, DRAM load: %.3f ns -> balance %d\n",
+                op_cost, slow, balance);
+    }
+
+    printf("%d,%zu,%d\n", parallelism, llc, balance);
+    return 0;
+}
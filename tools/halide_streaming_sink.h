@@ -0,0 +1,231 @@
+// A streaming file sink for Halide pipelines. Instead of realizing a
+// whole frame into memory and then writing it out, an extern stage
+// hands blocks of rows to a background writer thread as they are
+// produced, overlapping compute with storage I/O and removing the
+// full-frame staging copy.
+//
+// Usage, writing a 2-D planar Func f of known width and height:
+//
+//   Halide::Tools::StreamingFileSink sink("frame.bin");
+//
+//   int rows_per_block = 16;
+//   int blocks = (height + rows_per_block - 1) / rows_per_block;
+//   Func write_out("write_out");
+//   write_out.define_extern("halide_streaming_file_sink",
+//                           {Expr(sink.handle()), width, height,
+//                            rows_per_block, f},
+//                           Int(32), 1);
+//
+//   // Walk the blocks serially so each one is handed off as soon as
+//   // it is computed.
+//   Func done("done");
+//   Var s;
+//   done(s) = write_out(s);
+//   write_out.compute_at(done, s);
+//   f.compute_at(done, s);
+//   done.realize(blocks);
+//
+//   if (!sink.finish()) { /* report the I/O error */ }
+//
+// The writer uses a plain thread and buffered stdio rather than
+// io_uring or POSIX aio, so it works everywhere Halide's JIT tests
+// do; the overlap comes from the handoff, not the syscall used.
+
+#ifndef HALIDE_TOOLS_STREAMING_SINK_H
+#define HALIDE_TOOLS_STREAMING_SINK_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HalideRuntime.h"
+
+#ifdef _WIN32
+#define HALIDE_STREAMING_SINK_EXPORT __declspec(dllexport) inline
+#else
+#define HALIDE_STREAMING_SINK_EXPORT __attribute__((weak))
+#endif
+
+namespace Halide {
+namespace Tools {
+
+class StreamingFileSink {
+public:
+    // max_blocks_in_flight bounds the queue, so a slow disk applies
+    // backpressure to the pipeline instead of buffering the frame.
+    StreamingFileSink(const std::string &filename, int max_blocks_in_flight = 4)
+        : file(fopen(filename.c_str(), "wb")),
+          max_blocks(max_blocks_in_flight),
+          failed_(file == nullptr),
+          stop(false) {
+        writer = std::thread(&StreamingFileSink::writer_main, this);
+    }
+
+    ~StreamingFileSink() {
+        finish();
+    }
+
+    StreamingFileSink(const StreamingFileSink &) = delete;
+    StreamingFileSink &operator=(const StreamingFileSink &) = delete;
+
+    // An opaque handle to pass to the extern stage as a scalar arg.
+    uint64_t handle() const {
+        return (uint64_t)(uintptr_t)this;
+    }
+
+    // Drain the queue, close the file, and report whether every
+    // write succeeded. Idempotent; also called by the destructor.
+    bool finish() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stop) {
+                return !failed_;
+            }
+            stop = true;
+        }
+        not_empty.notify_all();
+        writer.join();
+        if (file) {
+            if (fclose(file) != 0) {
+                failed_ = true;
+            }
+            file = nullptr;
+        }
+        return !failed_;
+    }
+
+    // Queue a block of bytes for writing at the given file
+    // offset. Takes ownership of the bytes; blocks if the writer is
+    // more than max_blocks_in_flight behind. Returns non-zero if the
+    // sink has already failed.
+    int write_block(uint64_t offset, std::vector<char> &&bytes) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [&] {
+            return (int)queue.size() < max_blocks || failed_;
+        });
+        if (failed_) {
+            return 1;
+        }
+        queue.push_back({offset, std::move(bytes)});
+        not_empty.notify_one();
+        return 0;
+    }
+
+private:
+    struct Block {
+        uint64_t offset;
+        std::vector<char> bytes;
+    };
+
+    void writer_main() {
+        for (;;) {
+            Block b;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_empty.wait(lock, [&] {
+                    return !queue.empty() || stop;
+                });
+                if (queue.empty()) {
+                    return;
+                }
+                b = std::move(queue.front());
+                queue.pop_front();
+                not_full.notify_all();
+            }
+            bool ok = file != nullptr &&
+                      fseek(file, (long)b.offset, SEEK_SET) == 0 &&
+                      fwrite(b.bytes.data(), 1, b.bytes.size(), file) == b.bytes.size();
+            if (!ok) {
+                std::unique_lock<std::mutex> lock(mutex);
+                failed_ = true;
+                not_full.notify_all();
+            }
+        }
+    }
+
+    FILE *file;
+    const int max_blocks;
+    bool failed_;
+    bool stop;
+    std::deque<Block> queue;
+    std::mutex mutex;
+    std::condition_variable not_empty, not_full;
+    std::thread writer;
+};
+
+}  // namespace Tools
+}  // namespace Halide
+
+// The extern stage. The output is one Int(32) status per block of
+// rows_per_block rows (zero on success); realizing element s of it
+// writes rows [s * rows_per_block, min((s + 1) * rows_per_block,
+// height)) of the input to the file, in row-major order.
+extern "C" HALIDE_STREAMING_SINK_EXPORT
+int halide_streaming_file_sink(uint64_t sink_handle, int32_t width, int32_t height,
+                               int32_t rows_per_block, halide_buffer_t *in,
+                               halide_buffer_t *out) {
+    if (in->is_bounds_query()) {
+        // We need the input rows covering the requested blocks.
+        int32_t first_row = out->dim[0].min * rows_per_block;
+        int32_t rows = out->dim[0].extent * rows_per_block;
+        if (first_row + rows > height) {
+            rows = height - first_row;
+        }
+        in->dim[0].min = 0;
+        in->dim[0].extent = width;
+        in->dim[1].min = first_row;
+        in->dim[1].extent = rows;
+        return 0;
+    }
+
+    Halide::Tools::StreamingFileSink *sink =
+        (Halide::Tools::StreamingFileSink *)(uintptr_t)sink_handle;
+    const size_t elem = in->type.bytes();
+    const size_t row_bytes = (size_t)width * elem;
+
+    for (int32_t block = out->dim[0].min;
+         block < out->dim[0].min + out->dim[0].extent;
+         block++) {
+        int32_t first_row = block * rows_per_block;
+        int32_t rows = rows_per_block;
+        if (first_row + rows > height) {
+            rows = height - first_row;
+        }
+
+        // Gather the block's rows into one dense allocation, which
+        // the writer thread then owns; the pipeline is free to reuse
+        // the strip storage as soon as we return.
+        std::vector<char> bytes(rows * row_bytes);
+        for (int32_t r = 0; r < rows; r++) {
+            const char *src = (const char *)in->host +
+                              ((ptrdiff_t)(first_row + r - in->dim[1].min) * in->dim[1].stride -
+                               (ptrdiff_t)in->dim[0].min * in->dim[0].stride) * elem;
+            char *dst = bytes.data() + (size_t)r * row_bytes;
+            if (in->dim[0].stride == 1) {
+                memcpy(dst, src, row_bytes);
+            } else {
+                for (int32_t x = 0; x < width; x++) {
+                    memcpy(dst + x * elem, src + (ptrdiff_t)x * in->dim[0].stride * elem, elem);
+                }
+            }
+        }
+
+        int result = sink->write_block((uint64_t)first_row * row_bytes, std::move(bytes));
+        if (result != 0) {
+            return result;
+        }
+
+        if (out->host) {
+            ((int32_t *)out->host)[(block - out->dim[0].min) * out->dim[0].stride] = 0;
+        }
+    }
+    return 0;
+}
+
+#endif  // HALIDE_TOOLS_STREAMING_SINK_H
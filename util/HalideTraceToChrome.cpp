@@ -0,0 +1,74 @@
+// Converts a binary Halide trace (produced by setting HL_TRACE_FILE,
+// with task tracing enabled via HL_TRACE_TASKS) into the Chrome trace
+// event format, which chrome://tracing and https://ui.perfetto.dev
+// can display as one timeline row per thread-pool worker. Idle gaps
+// and straggler tasks in a poorly balanced parallel schedule show up
+// directly as holes and long bars in the timeline.
+//
+// Usage: HalideTraceToChrome < trace.bin > trace.json
+
+#include "HalideTraceUtils.h"
+#include <inttypes.h>
+#include <set>
+#include <stdio.h>
+
+using namespace Halide::Internal;
+
+int main(int argc, char **argv) {
+    if (argc != 1) {
+        fprintf(stderr, "Usage: %s < trace.bin > trace.json\n", argv[0]);
+        return 1;
+    }
+
+    // Worker ids start at -1 (the thread that launched the loop), so
+    // shift them by one to get nonnegative Chrome thread ids.
+    std::set<int> tids_named;
+    bool have_start = false;
+    uint64_t start = 0;
+    bool first = true;
+
+    printf("[\n");
+
+    Packet p;
+    while (p.read_from_stdin()) {
+        if (p.event != halide_trace_begin_task &&
+            p.event != halide_trace_end_task) {
+            continue;
+        }
+
+        int worker = p.get_coord(0);
+        int iteration = p.get_coord(1);
+        uint64_t fn = ((uint64_t)(uint32_t)p.get_coord(3) << 32) |
+                      (uint64_t)(uint32_t)p.get_coord(2);
+        uint64_t timestamp = p.get_value_as<uint64_t>(0);
+        if (!have_start) {
+            start = timestamp;
+            have_start = true;
+        }
+        int tid = worker + 1;
+
+        if (tids_named.insert(tid).second) {
+            if (!first) printf(",\n");
+            first = false;
+            if (worker < 0) {
+                printf("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+                       "\"tid\": %d, \"args\": {\"name\": \"owner\"}}", tid);
+            } else {
+                printf("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+                       "\"tid\": %d, \"args\": {\"name\": \"worker %d\"}}",
+                       tid, worker);
+            }
+        }
+
+        if (!first) printf(",\n");
+        first = false;
+        printf("{\"name\": \"task 0x%" PRIx64 "\", \"ph\": \"%s\", \"pid\": 0, "
+               "\"tid\": %d, \"ts\": %.3f, \"args\": {\"iteration\": %d}}",
+               fn, p.event == halide_trace_begin_task ? "B" : "E",
+               tid, (timestamp - start) / 1000.0, iteration);
+    }
+
+    printf("\n]\n");
+
+    return 0;
+}
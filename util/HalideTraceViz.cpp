@@ -774,6 +774,8 @@ int run(int argc, char **argv) {
         case halide_trace_end_consume:
         case halide_trace_begin_pipeline:
         case halide_trace_end_pipeline:
+        case halide_trace_begin_task:
+        case halide_trace_end_task:
             break;
         default:
             fprintf(stderr, "Unknown tracing event code: %d\n", p.event);